@@ -0,0 +1,165 @@
+import ctypes
+from concurrent.futures import Future
+
+import numpy as np
+
+_Preprocess = ctypes.CFUNCTYPE(ctypes.c_int32, ctypes.c_void_p, ctypes.c_uint64, ctypes.POINTER(ctypes.c_uint8), ctypes.c_int64,
+                               ctypes.POINTER(ctypes.c_uint8))
+_Result = ctypes.CFUNCTYPE(None, ctypes.c_void_p, ctypes.c_uint64, ctypes.c_int32, ctypes.POINTER(ctypes.c_uint8), ctypes.c_int64,
+                           ctypes.c_double)
+
+
+class _Batch(ctypes.Structure):
+    _fields_ = [('batch_id', ctypes.c_uint64), ('count', ctypes.c_int32), ('data', ctypes.POINTER(ctypes.c_uint8)),
+                ('item_bytes', ctypes.c_int64), ('ids', ctypes.POINTER(ctypes.c_uint64))]
+
+
+class _BatchSchedulerStats(ctypes.Structure):
+    _fields_ = [('submitted', ctypes.c_int64), ('dropped', ctypes.c_int64), ('completed', ctypes.c_int64), ('batches', ctypes.c_int64),
+                ('mean_batch_size', ctypes.c_double), ('mean_latency', ctypes.c_double), ('max_latency', ctypes.c_double),
+                ('over_bound', ctypes.c_int64), ('mean_inference', ctypes.c_double)]
+
+
+class BatchScheduler:
+    """Micro-batching front end for a model call, replacing one image per call in process_detic and a thread per clip.
+
+    submit() returns a Future. The model loop calls next_batch() to get a (count, *item_shape) array of preprocessed
+    inputs and finish() with one result per input, which resolves the futures by request id. Batches close when full
+    or when waiting longer would break latency_bound, and the next batch is preprocessed while the model runs.
+
+    preprocess(input_bytes, slot_array) fills one staging slot from submitted bytes, e.g. with cv2.resize into the
+    slot; it runs on the native scheduler thread. Without it, submitted arrays must already have item_shape. An
+    exception in preprocess is set on the future of the request. Futures cancelled before preprocessing are skipped.
+    """
+
+    def __init__(self, item_shape, dtype=np.float32, max_batch=8, latency_bound=0.1, max_delay=0.05, staging_count=2,
+                 max_pending=64, preprocess=None, lib_path='ReplayApi.dll'):
+        self.lib = ctypes.CDLL(lib_path)
+        self.lib.rr_BatchSchedulerCreate.restype = ctypes.c_void_p
+        self.lib.rr_BatchSchedulerCreate.argtypes = [ctypes.c_int64, ctypes.c_int32, ctypes.c_int32, ctypes.c_double, ctypes.c_double,
+                                                     ctypes.c_int32, _Preprocess, _Result, ctypes.c_void_p]
+        self.lib.rr_BatchSchedulerDestroy.argtypes = [ctypes.c_void_p]
+        self.lib.rr_BatchSchedulerSubmit.argtypes = [ctypes.c_void_p, ctypes.c_uint64, ctypes.c_void_p, ctypes.c_int64]
+        self.lib.rr_BatchSchedulerAcquire.restype = ctypes.c_int32
+        self.lib.rr_BatchSchedulerAcquire.argtypes = [ctypes.c_void_p, ctypes.c_double, ctypes.POINTER(_Batch)]
+        self.lib.rr_BatchSchedulerComplete.argtypes = [ctypes.c_void_p, ctypes.c_uint64, ctypes.c_void_p, ctypes.c_int64]
+        self.lib.rr_BatchSchedulerGetStaging.restype = ctypes.c_int32
+        self.lib.rr_BatchSchedulerGetStaging.argtypes = [ctypes.c_void_p, ctypes.POINTER(ctypes.c_void_p), ctypes.c_int32,
+                                                         ctypes.POINTER(ctypes.c_int64)]
+        self.lib.rr_BatchSchedulerStop.argtypes = [ctypes.c_void_p]
+        self.lib.rr_BatchSchedulerGetStats.restype = ctypes.c_int32
+        self.lib.rr_BatchSchedulerGetStats.argtypes = [ctypes.c_void_p, ctypes.POINTER(_BatchSchedulerStats)]
+
+        self.item_shape = tuple(item_shape)
+        self.dtype = np.dtype(dtype)
+        item_bytes = int(np.prod(self.item_shape)) * self.dtype.itemsize
+        self.futures = {}
+        self.results = {}
+        self.errors = {}
+        self.pinned = []
+        self.next_id = 1
+        self.user_preprocess = preprocess
+        # Keep references so the callbacks outlive the native scheduler
+        self.preprocess_callback = _Preprocess(self._preprocess) if preprocess else _Preprocess()
+        self.result_callback = _Result(self._result)
+        self.handle = self.lib.rr_BatchSchedulerCreate(item_bytes, max_batch, staging_count, latency_bound, max_delay, max_pending,
+                                                       self.preprocess_callback, self.result_callback, None)
+        if not self.handle:
+            raise ValueError(f'Invalid batch scheduler configuration: item_shape={item_shape}, max_batch={max_batch}')
+
+    def _preprocess(self, _, request_id, data, size, slot):
+        future = self.futures.get(request_id)
+        if future is not None and future.cancelled():
+            return 0
+        try:
+            source = np.ctypeslib.as_array(data, shape=(size,)) if size else np.empty(0, np.uint8)
+            target = np.ctypeslib.as_array(slot, shape=(int(np.prod(self.item_shape)) * self.dtype.itemsize,))
+            self.user_preprocess(source, target.view(self.dtype).reshape(self.item_shape))
+            return 1
+        except Exception as e:
+            self.errors[request_id] = e
+            return 0
+
+    def _result(self, _, request_id, completed, data, size, latency):
+        future = self.futures.pop(request_id, None)
+        result = self.results.pop(request_id, None)
+        error = self.errors.pop(request_id, None)
+        if future is None or future.cancelled():
+            return
+        if completed:
+            future.set_result(result)
+        elif error is not None:
+            future.set_exception(error)
+        else:
+            future.cancel()
+
+    def submit(self, array):
+        """Queues input array and returns Future for its result. Future is cancelled if the request is dropped.
+
+        The future stays pending until its batch completes, so it can be cancelled until then.
+        """
+        array = np.ascontiguousarray(array)
+        request_id = self.next_id
+        self.next_id += 1
+        future = Future()
+        self.futures[request_id] = future
+        self.lib.rr_BatchSchedulerSubmit(self.handle, request_id, array.ctypes.data, array.nbytes)
+        return future
+
+    def next_batch(self, timeout=-1.0):
+        """Returns (batch, inputs) with inputs as (count, *item_shape) view of the staging buffer, or None on stop."""
+        batch = _Batch()
+        if not self.lib.rr_BatchSchedulerAcquire(self.handle, timeout, ctypes.byref(batch)):
+            return None
+        flat = np.ctypeslib.as_array(batch.data, shape=(batch.count * batch.item_bytes,))
+        return batch, flat.view(self.dtype).reshape((batch.count,) + self.item_shape)
+
+    def finish(self, batch, results):
+        """Completes batch with one result object per input, in input order."""
+        for i, result in enumerate(results):
+            self.results[batch.ids[i]] = result
+        self.lib.rr_BatchSchedulerComplete(self.handle, batch.batch_id, None, 0)
+
+    def pin_staging(self):
+        """Registers staging buffers as page-locked memory with CUDA so host to device copies run asynchronously.
+
+        Buffers are unregistered again by close(). Calling this again replaces the previous registration.
+        """
+        import torch
+        self._unpin_staging()
+        buffers = (ctypes.c_void_p * 16)()
+        size = ctypes.c_int64()
+        count = self.lib.rr_BatchSchedulerGetStaging(self.handle, buffers, len(buffers), ctypes.byref(size))
+        cudart = torch.cuda.cudart()
+        for i in range(min(count, len(buffers))):
+            if cudart.cudaHostRegister(buffers[i], size.value, 0) == cudart.cudaError.success:
+                self.pinned.append(buffers[i])
+
+    def _unpin_staging(self):
+        if self.pinned:
+            import torch
+            cudart = torch.cuda.cudart()
+            for buffer in self.pinned:
+                cudart.cudaHostUnregister(buffer)
+            self.pinned = []
+
+    def stats(self):
+        """Returns batch sizes, latencies in seconds and drop counts as dict."""
+        stats = _BatchSchedulerStats()
+        self.lib.rr_BatchSchedulerGetStats(self.handle, ctypes.byref(stats))
+        return {name: getattr(stats, name) for name, _ in _BatchSchedulerStats._fields_}
+
+    def stop(self):
+        """Cancels pending requests and wakes the model loop waiting in next_batch."""
+        if self.handle:
+            self.lib.rr_BatchSchedulerStop(self.handle)
+
+    def close(self):
+        if self.handle:
+            # Staging memory is freed with the scheduler, unregister it first
+            self._unpin_staging()
+            self.lib.rr_BatchSchedulerDestroy(self.handle)
+            self.handle = None
+
+    def __del__(self):
+        self.close()
@@ -0,0 +1,109 @@
+import ctypes
+
+import numpy as np
+
+
+class _ChangeEvent(ctypes.Structure):
+    _fields_ = [('time', ctypes.c_double), ('object', ctypes.c_int64)]
+
+
+class _ChangeSpan(ctypes.Structure):
+    _fields_ = [('first', ctypes.c_double), ('last', ctypes.c_double), ('count', ctypes.c_int64)]
+
+
+class ChangeIndex:
+    """Spatio-temporal index of object changes over the primary region.
+
+    The region is split into a tile grid holding time-sorted (time, object) events, built from the Detic masks while
+    tracking. Answers which objects changed where and when without going back to the saved frames. Objects are
+    referred to by label; ids are assigned on first use.
+    """
+
+    def __init__(self, width, height, tile_size=32, lib_path='ReplayApi.dll'):
+        self.lib = ctypes.CDLL(lib_path)
+        self.lib.rr_ChangeIndexCreate.restype = ctypes.c_void_p
+        self.lib.rr_ChangeIndexCreate.argtypes = [ctypes.c_int32, ctypes.c_int32, ctypes.c_int32]
+        self.lib.rr_ChangeIndexDestroy.argtypes = [ctypes.c_void_p]
+        self.lib.rr_ChangeIndexAddBox.restype = ctypes.c_int32
+        self.lib.rr_ChangeIndexAddBox.argtypes = [ctypes.c_void_p, ctypes.c_double, ctypes.c_int64, ctypes.c_int32, ctypes.c_int32,
+                                                  ctypes.c_int32, ctypes.c_int32]
+        self.lib.rr_ChangeIndexAddMask.restype = ctypes.c_int32
+        self.lib.rr_ChangeIndexAddMask.argtypes = [ctypes.c_void_p, ctypes.c_double, ctypes.c_int64, ctypes.c_void_p, ctypes.c_int32,
+                                                   ctypes.c_int32, ctypes.c_int32]
+        self.lib.rr_ChangeIndexQuery.restype = ctypes.c_int32
+        self.lib.rr_ChangeIndexQuery.argtypes = [ctypes.c_void_p, ctypes.c_int32, ctypes.c_int32, ctypes.c_int32, ctypes.c_int32,
+                                                 ctypes.c_double, ctypes.c_double, ctypes.POINTER(_ChangeEvent), ctypes.c_int32]
+        self.lib.rr_ChangeIndexHasChange.restype = ctypes.c_int32
+        self.lib.rr_ChangeIndexHasChange.argtypes = [ctypes.c_void_p, ctypes.c_int32, ctypes.c_int32, ctypes.c_int32, ctypes.c_int32,
+                                                     ctypes.c_double, ctypes.c_double]
+        self.lib.rr_ChangeIndexGetObjectSpan.restype = ctypes.c_int32
+        self.lib.rr_ChangeIndexGetObjectSpan.argtypes = [ctypes.c_void_p, ctypes.c_int64, ctypes.POINTER(_ChangeSpan)]
+        self.lib.rr_ChangeIndexGetEventCount.restype = ctypes.c_int64
+        self.lib.rr_ChangeIndexGetEventCount.argtypes = [ctypes.c_void_p]
+        self.lib.rr_ChangeIndexClear.argtypes = [ctypes.c_void_p]
+
+        self.handle = self.lib.rr_ChangeIndexCreate(width, height, tile_size)
+        if not self.handle:
+            raise ValueError(f'Invalid change index configuration: size=({width}, {height}), tile_size={tile_size}')
+        self.ids = {}
+        self.labels = []
+
+    def object_id(self, label):
+        if label not in self.ids:
+            self.ids[label] = len(self.labels)
+            self.labels.append(label)
+        return self.ids[label]
+
+    def add_box(self, time, label, box):
+        """Adds change of object covering box (x0, y0, x1, y1) in pixels."""
+        x0, y0, x1, y1 = (int(v) for v in box)
+        self.lib.rr_ChangeIndexAddBox(self.handle, time, self.object_id(label), x0, y0, x1, y1)
+
+    def add_mask(self, time, label, mask):
+        """Adds change of object covering non-zero pixels of HxW mask, e.g. a Detic instance mask."""
+        mask = np.ascontiguousarray(mask, dtype=np.uint8)
+        if mask.ndim != 2 or not self.lib.rr_ChangeIndexAddMask(self.handle, time, self.object_id(label), mask.ctypes.data, mask.shape[1],
+                                                                mask.shape[0], mask.strides[0]):
+            raise ValueError(f'Invalid change mask: shape={mask.shape}')
+
+    def query(self, region, t0, t1):
+        """Returns [(time, label)] of changes in region (x0, y0, x1, y1) within [t0, t1], sorted by time."""
+        x0, y0, x1, y1 = (int(v) for v in region)
+        count = self.lib.rr_ChangeIndexQuery(self.handle, x0, y0, x1, y1, t0, t1, None, 0)
+        if count <= 0:
+            return []
+        events = (_ChangeEvent * count)()
+        count = min(count, self.lib.rr_ChangeIndexQuery(self.handle, x0, y0, x1, y1, t0, t1, events, count))
+        return [(events[i].time, self.labels[events[i].object]) for i in range(count)]
+
+    def has_change(self, region, t0, t1):
+        x0, y0, x1, y1 = (int(v) for v in region)
+        return bool(self.lib.rr_ChangeIndexHasChange(self.handle, x0, y0, x1, y1, t0, t1))
+
+    def span(self, label):
+        """Returns (first, last, count) changes of object, None if it never changed."""
+        if label not in self.ids:
+            return None
+        span = _ChangeSpan()
+        if not self.lib.rr_ChangeIndexGetObjectSpan(self.handle, self.ids[label], ctypes.byref(span)):
+            return None
+        return span.first, span.last, span.count
+
+    def changed_objects(self):
+        """Returns labels of all changed objects ordered by first change."""
+        spans = [(self.span(label), label) for label in self.labels]
+        return [label for span, label in sorted((s for s in spans if s[0] is not None), key=lambda s: s[0][0])]
+
+    def event_count(self):
+        return self.lib.rr_ChangeIndexGetEventCount(self.handle)
+
+    def clear(self):
+        self.lib.rr_ChangeIndexClear(self.handle)
+
+    def close(self):
+        if self.handle:
+            self.lib.rr_ChangeIndexDestroy(self.handle)
+            self.handle = None
+
+    def __del__(self):
+        self.close()
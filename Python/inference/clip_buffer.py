@@ -0,0 +1,63 @@
+import ctypes
+
+import numpy as np
+
+
+class _ClipView(ctypes.Structure):
+    _fields_ = [('data', ctypes.c_void_p), ('shape', ctypes.c_int64 * 5), ('strides', ctypes.c_int64 * 5), ('first_frame', ctypes.c_int64),
+                ('half', ctypes.c_int32)]
+
+
+class ClipBuffer:
+    """Sliding window of saliency model input frames, kept resized and normalized in NCTHW layout.
+
+    Replaces resizing the whole images_sal list and stacking it with transform() for every inference. Each frame is
+    resized to the model size once when pushed, and window() returns the latest length frames as a strided view of the
+    native buffer, ready for torch.from_numpy. The view stays valid for slack further pushes; upload it with .cuda()
+    before that.
+    """
+
+    def __init__(self, size=(384, 224), length=32, slack=4, half=False, lib_path='ReplayApi.dll'):
+        self.lib = ctypes.CDLL(lib_path)
+        self.lib.rr_ClipBufferCreate.restype = ctypes.c_void_p
+        self.lib.rr_ClipBufferCreate.argtypes = [ctypes.c_int32, ctypes.c_int32, ctypes.c_int32, ctypes.c_int32, ctypes.c_int32]
+        self.lib.rr_ClipBufferDestroy.argtypes = [ctypes.c_void_p]
+        self.lib.rr_ClipBufferPush.restype = ctypes.c_int32
+        self.lib.rr_ClipBufferPush.argtypes = [ctypes.c_void_p, ctypes.c_void_p, ctypes.c_int32, ctypes.c_int32, ctypes.c_int32,
+                                               ctypes.c_int32]
+        self.lib.rr_ClipBufferGetView.restype = ctypes.c_int32
+        self.lib.rr_ClipBufferGetView.argtypes = [ctypes.c_void_p, ctypes.POINTER(_ClipView)]
+        self.lib.rr_ClipBufferClear.argtypes = [ctypes.c_void_p]
+
+        self.handle = self.lib.rr_ClipBufferCreate(size[0], size[1], length, slack, 1 if half else 0)
+        if not self.handle:
+            raise ValueError(f'Invalid clip buffer configuration: size={size}, length={length}')
+
+    def push(self, image):
+        """Appends HxWx3 or HxWx4 uint8 frame, e.g. the BGR primary region."""
+        image = np.ascontiguousarray(image, dtype=np.uint8)
+        if image.ndim != 3 or not self.lib.rr_ClipBufferPush(self.handle, image.ctypes.data, image.shape[1], image.shape[0],
+                                                             image.strides[0], image.shape[2]):
+            raise ValueError(f'Invalid clip frame: shape={image.shape}')
+
+    def window(self):
+        """Returns (1, 3, length, height, width) float32 or float16 view of the latest frames, or None until the window fills."""
+        view = _ClipView()
+        if not self.lib.rr_ClipBufferGetView(self.handle, ctypes.byref(view)):
+            return None
+
+        dtype = np.float16 if view.half else np.float32
+        extent = sum((n - 1) * s for n, s in zip(view.shape, view.strides)) + np.dtype(dtype).itemsize
+        flat = np.frombuffer((ctypes.c_uint8 * extent).from_address(view.data), dtype=dtype)
+        return np.lib.stride_tricks.as_strided(flat, shape=tuple(view.shape), strides=tuple(view.strides))
+
+    def clear(self):
+        self.lib.rr_ClipBufferClear(self.handle)
+
+    def close(self):
+        if self.handle:
+            self.lib.rr_ClipBufferDestroy(self.handle)
+            self.handle = None
+
+    def __del__(self):
+        self.close()
@@ -0,0 +1,52 @@
+import os
+import time
+
+import cv2
+
+from inference.latency_trace import FrameTrace, INGEST
+
+# Equirect snapshot of the environment cubemap, written by the recorder in equirect capture mode
+EQUIRECT_SNAPSHOT = '../../VarjoCameraRecorder/VarjoCameraRecorder/bin/frames/cube_equirect'
+
+
+class EquirectSnapshotStream:
+    """360 frame source reading the equirect snapshots of the recorder, with the read_stream()/frame interface of
+    VideoStream.
+
+    The recorder writes each snapshot as cube_equirect_<frame number>.bmp and publishes cube_equirect.trace after it,
+    so a new frame is detected by a new trace frame number and the image is always the one of the trace. read_stream()
+    waits for the next frame and sets frame to None if none arrives within timeout, e.g. when the recorder has stopped.
+    """
+
+    def __init__(self, base_path=EQUIRECT_SNAPSHOT, timeout=5.0, poll_interval=0.01):
+        self.base_path = base_path
+        self.timeout = timeout
+        self.poll_interval = poll_interval
+        self.frame = None
+        self.trace = None
+        self.frame_number = None
+
+    def read_stream(self):
+        deadline = time.monotonic() + self.timeout
+        while True:
+            trace = FrameTrace.read(self.base_path + '.trace')
+            if trace is not None and trace.frame_number != self.frame_number:
+                image = cv2.imread(self.image_path(trace.frame_number))
+                # A failed read means the recorder has already replaced the snapshot, the next trace names the new one
+                if image is not None:
+                    trace.stamp(INGEST)
+                    self.frame, self.trace, self.frame_number = image, trace, trace.frame_number
+                    return
+            if time.monotonic() >= deadline:
+                self.frame = None
+                return
+            time.sleep(self.poll_interval)
+
+    def image_path(self, frame_number):
+        return f'{self.base_path}_{frame_number}.bmp'
+
+    def read(self):
+        return self.frame
+
+    def stop(self):
+        pass
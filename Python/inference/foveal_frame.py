@@ -0,0 +1,97 @@
+import ctypes
+import os
+
+import cv2
+import numpy as np
+
+
+class _TileRect(ctypes.Structure):
+    _fields_ = [('x', ctypes.c_int32), ('y', ctypes.c_int32), ('width', ctypes.c_int32), ('height', ctypes.c_int32)]
+
+
+class _FovealInfo(ctypes.Structure):
+    _fields_ = [('width', ctypes.c_int32), ('height', ctypes.c_int32), ('periphery_scale', ctypes.c_int32),
+                ('gaze_valid', ctypes.c_int32), ('fixation_x', ctypes.c_int32), ('fixation_y', ctypes.c_int32),
+                ('roi', _TileRect)]
+
+
+class FovealDecoder:
+    """Decodes the two-level frames the recorder stores in gaze-contingent capture mode.
+
+    A frame keeps full resolution only in a region around the gaze point; the periphery is upsampled from a
+    downsampled copy, so detections outside the region see a blurred image.
+    """
+
+    def __init__(self, lib_path='ReplayApi.dll'):
+        self.lib = ctypes.CDLL(lib_path)
+        self.lib.rr_FovealFrameOpen.restype = ctypes.c_void_p
+        self.lib.rr_FovealFrameOpen.argtypes = [ctypes.c_char_p, ctypes.c_int64]
+        self.lib.rr_FovealFrameDestroy.argtypes = [ctypes.c_void_p]
+        self.lib.rr_FovealFrameGetInfo.restype = ctypes.c_int32
+        self.lib.rr_FovealFrameGetInfo.argtypes = [ctypes.c_void_p, ctypes.POINTER(_FovealInfo)]
+        self.lib.rr_FovealFrameDecode.restype = ctypes.c_int32
+        self.lib.rr_FovealFrameDecode.argtypes = [ctypes.c_void_p, ctypes.c_void_p, ctypes.c_int32]
+
+    def decode(self, data):
+        """Returns (BGR image, info dict) of serialized frame, (None, None) if invalid."""
+        frame = self.lib.rr_FovealFrameOpen(data, len(data))
+        if not frame:
+            return None, None
+        try:
+            info = _FovealInfo()
+            self.lib.rr_FovealFrameGetInfo(frame, ctypes.byref(info))
+            pixels = np.empty((info.height, info.width, 4), dtype=np.uint8)
+            if not self.lib.rr_FovealFrameDecode(frame, pixels.ctypes.data, info.width * 4):
+                return None, None
+        finally:
+            self.lib.rr_FovealFrameDestroy(frame)
+
+        roi = info.roi
+        return cv2.cvtColor(pixels, cv2.COLOR_BGRA2BGR), {
+            'gaze_valid': bool(info.gaze_valid),
+            'fixation': (info.fixation_x, info.fixation_y),
+            'roi': (roi.x, roi.y, roi.width, roi.height),
+            'periphery_scale': info.periphery_scale,
+        }
+
+    def read(self, filename):
+        """Returns (BGR image, info dict) of frame file, (None, None) if missing or invalid."""
+        try:
+            with open(filename, 'rb') as f:
+                return self.decode(f.read())
+        except OSError:
+            return None, None
+
+
+_shared_decoder = None
+_decoder_error = None
+
+
+def _get_decoder():
+    """Returns decoder shared by read_snapshot, None if ReplayApi.dll cannot be loaded. Loading is tried once."""
+    global _shared_decoder, _decoder_error
+    if _shared_decoder is None and _decoder_error is None:
+        try:
+            _shared_decoder = FovealDecoder()
+        except OSError as e:
+            _decoder_error = e
+            print(f'Foveal decoder unavailable, reading .bmp snapshots only: {e}')
+    return _shared_decoder
+
+
+def read_snapshot(base_path):
+    """Returns the newer of base_path.bmp and base_path.fov as BGR image, None if neither can be read.
+
+    The recorder writes .bmp snapshots normally and .fov snapshots in gaze-contingent capture mode. Raises
+    RuntimeError if the .fov snapshot is the newer one and the decoder library cannot be loaded, rather than returning
+    a stale .bmp of an earlier session.
+    """
+    candidates = [path for path in (base_path + '.bmp', base_path + '.fov') if os.path.exists(path)]
+    if not candidates:
+        return None
+    newest = max(candidates, key=os.path.getmtime)
+    if newest.endswith('.fov'):
+        if _get_decoder() is None:
+            raise RuntimeError(f'{newest} needs the foveal decoder, which is unavailable: {_decoder_error}')
+        return _shared_decoder.read(newest)[0]
+    return cv2.imread(newest)
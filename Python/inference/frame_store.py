@@ -0,0 +1,82 @@
+import ctypes
+
+import numpy as np
+
+
+class _StoredFrame(ctypes.Structure):
+    _fields_ = [('pixels', ctypes.POINTER(ctypes.c_uint8)), ('width', ctypes.c_int32), ('height', ctypes.c_int32),
+                ('channels', ctypes.c_int32), ('token', ctypes.c_void_p)]
+
+
+class _FrameStoreStats(ctypes.Structure):
+    _fields_ = [(name, ctypes.c_int64) for name in ('frame_count', 'resident_count', 'resident_bytes', 'spilled_count', 'spill_bytes',
+                                                    'raw_spill_bytes', 'hits', 'reloads', 'evictions')]
+
+
+class FrameStore:
+    """Bounded native store for frame history, replacing unbounded Python lists of full frames.
+
+    Frames are referenced by integer handle. Frames over the memory budget are evicted least recently used first to a
+    compressed spill file and reloaded transparently by get(), so session length is limited by disk, not RAM.
+    """
+
+    def __init__(self, spill_path, budget_bytes, lib_path='ReplayApi.dll'):
+        self.lib = ctypes.CDLL(lib_path)
+        self.lib.rr_FrameStoreCreate.restype = ctypes.c_void_p
+        self.lib.rr_FrameStoreCreate.argtypes = [ctypes.c_char_p, ctypes.c_int64]
+        self.lib.rr_FrameStoreDestroy.argtypes = [ctypes.c_void_p]
+        self.lib.rr_FrameStorePut.restype = ctypes.c_uint64
+        self.lib.rr_FrameStorePut.argtypes = [ctypes.c_void_p, ctypes.c_void_p, ctypes.c_int32, ctypes.c_int32, ctypes.c_int32,
+                                              ctypes.c_int32]
+        self.lib.rr_FrameStoreAcquire.restype = ctypes.c_int32
+        self.lib.rr_FrameStoreAcquire.argtypes = [ctypes.c_void_p, ctypes.c_uint64, ctypes.POINTER(_StoredFrame)]
+        self.lib.rr_FrameStoreUnpin.argtypes = [ctypes.POINTER(_StoredFrame)]
+        self.lib.rr_FrameStoreRelease.argtypes = [ctypes.c_void_p, ctypes.c_uint64]
+        self.lib.rr_FrameStoreSetBudget.argtypes = [ctypes.c_void_p, ctypes.c_int64]
+        self.lib.rr_FrameStoreGetStats.restype = ctypes.c_int32
+        self.lib.rr_FrameStoreGetStats.argtypes = [ctypes.c_void_p, ctypes.POINTER(_FrameStoreStats)]
+
+        self.handle = self.lib.rr_FrameStoreCreate(spill_path.encode('utf-8'), budget_bytes)
+        if not self.handle:
+            raise IOError(f'Creating frame store failed: {spill_path}')
+
+    def put(self, image):
+        """Copies HxW or HxWxC uint8 image with up to 4 channels into the store and returns its handle."""
+        image = np.ascontiguousarray(image, dtype=np.uint8)
+        channels = image.shape[2] if image.ndim == 3 else 1
+        frame_handle = self.lib.rr_FrameStorePut(self.handle, image.ctypes.data, image.shape[1], image.shape[0], channels,
+                                                 image.strides[0])
+        if not frame_handle:
+            raise ValueError(f'Invalid frame: shape={image.shape}')
+        return frame_handle
+
+    def get(self, frame_handle):
+        """Returns copy of stored frame, reloading it from disk if needed, or None for unknown handle."""
+        frame = _StoredFrame()
+        if not self.lib.rr_FrameStoreAcquire(self.handle, frame_handle, ctypes.byref(frame)):
+            return None
+        try:
+            shape = (frame.height, frame.width) if frame.channels == 1 else (frame.height, frame.width, frame.channels)
+            return np.ctypeslib.as_array(frame.pixels, shape=shape).copy()
+        finally:
+            self.lib.rr_FrameStoreUnpin(ctypes.byref(frame))
+
+    def release(self, frame_handle):
+        self.lib.rr_FrameStoreRelease(self.handle, frame_handle)
+
+    def set_budget(self, budget_bytes):
+        self.lib.rr_FrameStoreSetBudget(self.handle, budget_bytes)
+
+    def stats(self):
+        """Returns occupancy and eviction statistics as dict."""
+        stats = _FrameStoreStats()
+        self.lib.rr_FrameStoreGetStats(self.handle, ctypes.byref(stats))
+        return {name: getattr(stats, name) for name, _ in _FrameStoreStats._fields_}
+
+    def close(self):
+        if self.handle:
+            self.lib.rr_FrameStoreDestroy(self.handle)
+            self.handle = None
+
+    def __del__(self):
+        self.close()
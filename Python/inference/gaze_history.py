@@ -0,0 +1,103 @@
+import ctypes
+import math
+
+
+class _GazeSample(ctypes.Structure):
+    _fields_ = [('time', ctypes.c_int64), ('gaze', ctypes.c_double * 3), ('world', ctypes.c_double * 3),
+                ('focus_distance', ctypes.c_double), ('status', ctypes.c_int32), ('has_world', ctypes.c_int32)]
+
+
+class _GazeFixation(ctypes.Structure):
+    _fields_ = [('start', ctypes.c_int64), ('end', ctypes.c_int64), ('direction', ctypes.c_double * 3),
+                ('region', ctypes.c_int32)]
+
+
+class GazeHistory:
+    """Gaze history of a recording session, loaded from the gaze log written by the native GazeRecorder.
+
+    Times are Varjo time in nanoseconds, the clock of FrameTrace.sensor_timestamp, so a change detected in a frame
+    can be looked up by the sensor timestamp of that frame. World directions use the HMD world space, -Z forward.
+    """
+
+    VALID = 2
+
+    def __init__(self, capacity=1 << 20, lib_path='ReplayApi.dll'):
+        self.lib = ctypes.CDLL(lib_path)
+        self.lib.rr_GazeRecorderCreate.restype = ctypes.c_void_p
+        self.lib.rr_GazeRecorderCreate.argtypes = [ctypes.c_int32]
+        self.lib.rr_GazeRecorderDestroy.argtypes = [ctypes.c_void_p]
+        self.lib.rr_GazeRecorderLoadLog.restype = ctypes.c_int64
+        self.lib.rr_GazeRecorderLoadLog.argtypes = [ctypes.c_void_p, ctypes.c_char_p]
+        self.lib.rr_GazeRecorderWriteLog.restype = ctypes.c_int32
+        self.lib.rr_GazeRecorderWriteLog.argtypes = [ctypes.c_void_p, ctypes.c_char_p]
+        self.lib.rr_GazeRecorderGetSampleAt.restype = ctypes.c_int32
+        self.lib.rr_GazeRecorderGetSampleAt.argtypes = [ctypes.c_void_p, ctypes.c_int64, ctypes.c_int64,
+                                                        ctypes.POINTER(_GazeSample)]
+        self.lib.rr_GazeRecorderGetAngleTo.restype = ctypes.c_double
+        self.lib.rr_GazeRecorderGetAngleTo.argtypes = [ctypes.c_void_p, ctypes.POINTER(ctypes.c_double), ctypes.c_int64,
+                                                       ctypes.c_int64]
+        self.lib.rr_GazeRecorderGetFixations.restype = ctypes.c_int32
+        self.lib.rr_GazeRecorderGetFixations.argtypes = [ctypes.c_void_p, ctypes.c_int64, ctypes.c_int64,
+                                                         ctypes.POINTER(_GazeFixation), ctypes.c_int32]
+        self.lib.rr_GazeRecorderGetDwell.restype = ctypes.c_int32
+        self.lib.rr_GazeRecorderGetDwell.argtypes = [ctypes.c_void_p, ctypes.POINTER(ctypes.c_double), ctypes.c_int32,
+                                                     ctypes.POINTER(ctypes.c_int32), ctypes.POINTER(ctypes.c_int32)]
+
+        self.handle = self.lib.rr_GazeRecorderCreate(capacity)
+        if not self.handle:
+            raise ValueError(f'Invalid gaze recorder configuration: capacity={capacity}')
+
+    def load_log(self, filename):
+        """Adds all samples of a gaze log. Returns number of samples read."""
+        return self.lib.rr_GazeRecorderLoadLog(self.handle, filename.encode())
+
+    def write_log(self, filename):
+        """Writes all samples to a gaze log, e.g. to trim a session. Returns False on failure."""
+        return bool(self.lib.rr_GazeRecorderWriteLog(self.handle, filename.encode()))
+
+    def sample_at(self, time_ns, max_delta_ns=20000000):
+        """Returns sample closest to time as dict, None if none within max_delta_ns."""
+        sample = _GazeSample()
+        if not self.lib.rr_GazeRecorderGetSampleAt(self.handle, time_ns, max_delta_ns, ctypes.byref(sample)):
+            return None
+        return {'time': sample.time, 'gaze': tuple(sample.gaze), 'world': tuple(sample.world) if sample.has_world else None,
+                'focus_distance': sample.focus_distance, 'valid': sample.status == self.VALID}
+
+    def angle_to(self, direction, time_ns, max_delta_ns=20000000):
+        """Returns angle in degrees between gaze and world direction at time, None if gaze is not known."""
+        angle = self.lib.rr_GazeRecorderGetAngleTo(self.handle, (ctypes.c_double * 3)(*direction), time_ns, max_delta_ns)
+        return math.degrees(angle) if angle >= 0.0 else None
+
+    def fixations(self, t0=-(1 << 63), t1=(1 << 63) - 1):
+        """Returns fixations overlapping [t0, t1] as dicts."""
+        count = self.lib.rr_GazeRecorderGetFixations(self.handle, t0, t1, None, 0)
+        fixations = (_GazeFixation * count)()
+        count = min(count, self.lib.rr_GazeRecorderGetFixations(self.handle, t0, t1, fixations, count))
+        return [{'start': f.start, 'end': f.end, 'direction': tuple(f.direction), 'region': f.region}
+                for f in fixations[:count]]
+
+    def dwell(self):
+        """Returns dwell seconds per world region as rows of columns, bottom row first, columns from yaw -180."""
+        columns, rows = ctypes.c_int32(), ctypes.c_int32()
+        values = (ctypes.c_double * 4096)()
+        count = self.lib.rr_GazeRecorderGetDwell(self.handle, values, len(values), ctypes.byref(columns),
+                                                 ctypes.byref(rows))
+        if count == 0:
+            return []
+        return [list(values[row * columns.value:(row + 1) * columns.value]) for row in range(count // columns.value)]
+
+    def rank_by_inattention(self, changes, max_delta_ns=20000000):
+        """Sorts changes given as (world direction, time_ns, payload) so that those the user was looking away from
+        come first. Changes without known gaze are treated as unseen."""
+        def angle(change):
+            value = self.angle_to(change[0], change[1], max_delta_ns)
+            return 180.0 if value is None else value
+        return sorted(changes, key=angle, reverse=True)
+
+    def close(self):
+        if self.handle:
+            self.lib.rr_GazeRecorderDestroy(self.handle)
+            self.handle = None
+
+    def __del__(self):
+        self.close()
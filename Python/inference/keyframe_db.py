@@ -0,0 +1,100 @@
+import ctypes
+import math
+
+import numpy as np
+
+
+class _Keyframe(ctypes.Structure):
+    _fields_ = [('id', ctypes.c_uint64), ('time', ctypes.c_int64), ('hmd_pose', ctypes.c_double * 16), ('frame', ctypes.c_uint64)]
+
+
+class _KeyframeMatch(ctypes.Structure):
+    _fields_ = [('keyframe', _Keyframe), ('angle', ctypes.c_double), ('distance', ctypes.c_double), ('cost', ctypes.c_double)]
+
+
+class _KeyframeDatabaseStats(ctypes.Structure):
+    _fields_ = [(name, ctypes.c_int64) for name in ('keyframes', 'added', 'evicted', 'queries', 'scanned')]
+
+
+def _pose_array(hmd_pose):
+    """Returns 4x4 pose with translation in last column as column major ctypes array."""
+    pose = np.ascontiguousarray(np.asarray(hmd_pose, dtype=np.float64).reshape(4, 4).T)
+    return (ctypes.c_double * 16)(*pose.ravel())
+
+
+def _keyframe_dict(keyframe):
+    return {'id': keyframe.id, 'time': keyframe.time, 'hmd_pose': np.array(keyframe.hmd_pose).reshape(4, 4).T,
+            'frame': keyframe.frame}
+
+
+class KeyframeDatabase:
+    """Captured frames indexed by HMD viewpoint for replaying a change from the view closest to the user's current one.
+
+    Poses are 4x4 HMD world poses with translation in the last column, times are Varjo time in nanoseconds. Frames
+    are FrameStore handles; if a store is given, frames of evicted keyframes are released from it.
+    """
+
+    def __init__(self, frame_store=None, max_keyframes=65536, max_age_ns=0, position_weight=0.5, lib_path='ReplayApi.dll'):
+        self.lib = ctypes.CDLL(lib_path)
+        self.lib.rr_KeyframeDatabaseCreate.restype = ctypes.c_void_p
+        self.lib.rr_KeyframeDatabaseCreate.argtypes = [ctypes.c_void_p, ctypes.c_int64, ctypes.c_int64, ctypes.c_double]
+        self.lib.rr_KeyframeDatabaseDestroy.argtypes = [ctypes.c_void_p]
+        self.lib.rr_KeyframeDatabaseAdd.restype = ctypes.c_uint64
+        self.lib.rr_KeyframeDatabaseAdd.argtypes = [ctypes.c_void_p, ctypes.c_int64, ctypes.POINTER(ctypes.c_double), ctypes.c_uint64]
+        self.lib.rr_KeyframeDatabaseFindNearest.restype = ctypes.c_int32
+        self.lib.rr_KeyframeDatabaseFindNearest.argtypes = [ctypes.c_void_p, ctypes.POINTER(ctypes.c_double), ctypes.c_int64,
+                                                            ctypes.c_int64, ctypes.c_double, ctypes.POINTER(_KeyframeMatch)]
+        self.lib.rr_KeyframeDatabaseGet.restype = ctypes.c_int32
+        self.lib.rr_KeyframeDatabaseGet.argtypes = [ctypes.c_void_p, ctypes.c_uint64, ctypes.POINTER(_Keyframe)]
+        self.lib.rr_KeyframeDatabaseEvictBefore.restype = ctypes.c_int64
+        self.lib.rr_KeyframeDatabaseEvictBefore.argtypes = [ctypes.c_void_p, ctypes.c_int64, ctypes.c_int64]
+        self.lib.rr_KeyframeDatabaseGetStats.restype = ctypes.c_int32
+        self.lib.rr_KeyframeDatabaseGetStats.argtypes = [ctypes.c_void_p, ctypes.POINTER(_KeyframeDatabaseStats)]
+
+        # Keep store alive while the database may release frames from it
+        self.frame_store = frame_store
+        self.handle = self.lib.rr_KeyframeDatabaseCreate(frame_store.handle if frame_store else None, max_keyframes, max_age_ns,
+                                                         position_weight)
+        if not self.handle:
+            raise ValueError(f'Invalid keyframe database configuration: max_keyframes={max_keyframes}, '
+                             f'position_weight={position_weight}')
+
+    def add(self, time_ns, hmd_pose, frame_handle):
+        """Adds keyframe and returns its id, 0 if time is older than the latest keyframe."""
+        return self.lib.rr_KeyframeDatabaseAdd(self.handle, time_ns, _pose_array(hmd_pose), frame_handle)
+
+    def find_nearest(self, hmd_pose, t0=-(1 << 63), t1=(1 << 63) - 1, max_angle_deg=180.0):
+        """Returns keyframe dict with angle_deg, distance and cost of the viewpoint closest to pose captured in [t0, t1],
+        None if no keyframe is within max_angle_deg of the view direction."""
+        match = _KeyframeMatch()
+        if not self.lib.rr_KeyframeDatabaseFindNearest(self.handle, _pose_array(hmd_pose), t0, t1, math.radians(max_angle_deg),
+                                                       ctypes.byref(match)):
+            return None
+        result = _keyframe_dict(match.keyframe)
+        result.update({'angle_deg': math.degrees(match.angle), 'distance': match.distance, 'cost': match.cost})
+        return result
+
+    def get(self, keyframe_id):
+        """Returns keyframe dict, None if unknown or evicted."""
+        keyframe = _Keyframe()
+        if not self.lib.rr_KeyframeDatabaseGet(self.handle, keyframe_id, ctypes.byref(keyframe)):
+            return None
+        return _keyframe_dict(keyframe)
+
+    def evict_before(self, time_ns, max_count=1 << 62):
+        """Evicts up to max_count oldest keyframes captured before time. Returns number evicted."""
+        return self.lib.rr_KeyframeDatabaseEvictBefore(self.handle, time_ns, max_count)
+
+    def stats(self):
+        """Returns size and query statistics as dict."""
+        stats = _KeyframeDatabaseStats()
+        self.lib.rr_KeyframeDatabaseGetStats(self.handle, ctypes.byref(stats))
+        return {name: getattr(stats, name) for name, _ in _KeyframeDatabaseStats._fields_}
+
+    def close(self):
+        if self.handle:
+            self.lib.rr_KeyframeDatabaseDestroy(self.handle)
+            self.handle = None
+
+    def __del__(self):
+        self.close()
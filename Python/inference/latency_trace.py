@@ -0,0 +1,120 @@
+import ctypes
+import os
+import struct
+import time
+
+# Stages in pipeline order, as TraceStage in FrameTrace.hpp
+EXPOSURE, CAPTURE, PUBLISH, INGEST, DETECTION, VISUALIZATION, TRANSPORT, UPLOAD = range(8)
+STAGE_NAMES = ['exposure', 'capture', 'publish', 'ingest', 'detection', 'visualization', 'transport', 'upload']
+
+_RECORD = struct.Struct('<IHHqq8q')
+_MAGIC = 0x43525446
+_VERSION = 1
+
+
+class FrameTrace:
+    """Frame id and timestamp envelope passed from the recorder through detection to the Unity overlay.
+
+    Each stage reads the trace sidecar written by the previous one, stamps its own time and writes the trace next to
+    its output. Stamps use time.perf_counter_ns(), which reads the same monotonic clock as the recorder and Unity.
+    """
+
+    def __init__(self, frame_number=0, sensor_timestamp=0, stamps=None):
+        self.frame_number = frame_number
+        self.sensor_timestamp = sensor_timestamp
+        self.stamps = list(stamps) if stamps else [0] * len(STAGE_NAMES)
+
+    @classmethod
+    def from_bytes(cls, data):
+        """Returns trace parsed from record, None if invalid."""
+        if len(data) < _RECORD.size:
+            return None
+        magic, version, stage_count, frame_number, sensor_timestamp, *stamps = _RECORD.unpack_from(data)
+        if magic != _MAGIC or version != _VERSION or stage_count != len(STAGE_NAMES):
+            return None
+        return cls(frame_number, sensor_timestamp, stamps)
+
+    @classmethod
+    def read(cls, filename):
+        """Returns trace from sidecar file, None if missing or invalid."""
+        try:
+            with open(filename, 'rb') as f:
+                return cls.from_bytes(f.read(_RECORD.size))
+        except OSError:
+            return None
+
+    def to_bytes(self):
+        return _RECORD.pack(_MAGIC, _VERSION, len(STAGE_NAMES), self.frame_number, self.sensor_timestamp, *self.stamps)
+
+    def stamp(self, stage, time_ns=None):
+        self.stamps[stage] = time.perf_counter_ns() if time_ns is None else time_ns
+
+    def write(self, filename):
+        """Writes trace as sidecar file. Written to a temporary name first so readers never see a partial record."""
+        temp = filename + '.tmp'
+        with open(temp, 'wb') as f:
+            f.write(self.to_bytes())
+        os.replace(temp, filename)
+
+    def append_to_log(self, filename):
+        with open(filename, 'ab') as f:
+            f.write(self.to_bytes())
+
+
+class _LatencyStats(ctypes.Structure):
+    _fields_ = [('count', ctypes.c_int64), ('mean', ctypes.c_double), ('p50', ctypes.c_double), ('p90', ctypes.c_double),
+                ('p99', ctypes.c_double), ('max', ctypes.c_double)]
+
+
+class LatencyCollector:
+    """Per-stage latency distributions of a session trace log, computed by the native collector.
+
+    Stage latency is the time from the previous stamped stage of the same frame, total latency runs from exposure to
+    the last stamped stage.
+    """
+
+    def __init__(self, max_samples=100000, lib_path='ReplayApi.dll'):
+        self.lib = ctypes.CDLL(lib_path)
+        self.lib.rr_LatencyCollectorCreate.restype = ctypes.c_void_p
+        self.lib.rr_LatencyCollectorCreate.argtypes = [ctypes.c_int64]
+        self.lib.rr_LatencyCollectorDestroy.argtypes = [ctypes.c_void_p]
+        self.lib.rr_LatencyCollectorRecord.restype = ctypes.c_int32
+        self.lib.rr_LatencyCollectorRecord.argtypes = [ctypes.c_void_p, ctypes.c_char_p, ctypes.c_int64]
+        self.lib.rr_LatencyCollectorLoadLog.restype = ctypes.c_int64
+        self.lib.rr_LatencyCollectorLoadLog.argtypes = [ctypes.c_void_p, ctypes.c_char_p]
+        self.lib.rr_LatencyCollectorGetStats.restype = ctypes.c_int32
+        self.lib.rr_LatencyCollectorGetStats.argtypes = [ctypes.c_void_p, ctypes.c_int32, ctypes.POINTER(_LatencyStats)]
+        self.lib.rr_LatencyCollectorWriteReport.restype = ctypes.c_int32
+        self.lib.rr_LatencyCollectorWriteReport.argtypes = [ctypes.c_void_p, ctypes.c_char_p]
+
+        self.handle = self.lib.rr_LatencyCollectorCreate(max_samples)
+        if not self.handle:
+            raise ValueError(f'Invalid latency collector configuration: max_samples={max_samples}')
+
+    def record(self, trace):
+        data = trace.to_bytes()
+        return self.lib.rr_LatencyCollectorRecord(self.handle, data, len(data)) != 0
+
+    def load_log(self, filename):
+        """Adds all traces of a session trace log. Returns number of traces read."""
+        return self.lib.rr_LatencyCollectorLoadLog(self.handle, filename.encode())
+
+    def stats(self):
+        """Returns latency distribution in seconds per stage and 'total' as dict."""
+        result = {}
+        for stage, name in enumerate(STAGE_NAMES + ['total']):
+            stats = _LatencyStats()
+            self.lib.rr_LatencyCollectorGetStats(self.handle, stage, ctypes.byref(stats))
+            result[name] = {field: getattr(stats, field) for field, _ in _LatencyStats._fields_}
+        return result
+
+    def write_report(self, filename):
+        return self.lib.rr_LatencyCollectorWriteReport(self.handle, filename.encode()) != 0
+
+    def close(self):
+        if self.handle:
+            self.lib.rr_LatencyCollectorDestroy(self.handle)
+            self.handle = None
+
+    def __del__(self):
+        self.close()
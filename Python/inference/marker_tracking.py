@@ -23,27 +23,25 @@ class Marker:
             cv2.imwrite(marker_path, img)
         return img
 
-    def get_position(self, frame):
-        (corners, ids, rejected) = aruco.detectMarkers(frame, self.aruco_dict, parameters=self.aruco_params)
-        if len(corners) > 0:
-            ids = ids.flatten()
+    def get_position(self, frame, corners=None):
+        # Corners of get_corners may be passed in to detect the marker only once
+        if corners is None:
+            corners = self.get_corners(frame)
+        if corners is None:
+            return None
 
-            for (markerCorner, markerID) in zip(corners, ids):
-                # (x, y) coordinates of marker corners:
-                # top left, top right, bottom right, bottom left
-                corners = markerCorner.reshape((4, 2))
-                (top_left, _, bottom_right, _) = corners
+        # (x, y) coordinates of marker corners:
+        # top left, top right, bottom right, bottom left
+        (top_left, _, bottom_right, _) = corners
 
-                # convert each of the (x, y)-coordinate pairs to integers
-                # top_left = (int(top_left[0]), int(top_left[1]))
-                center = (int(top_left[0] + (bottom_right[0]-top_left[0])/2),
-                          int(top_left[1] + (bottom_right[1]-top_left[1])/2))
-                # draw the top left (x,y) coordinates of the marker
-                cv2.circle(frame, center, 4, (0, 0, 255), -1)
+        # convert each of the (x, y)-coordinate pairs to integers
+        # top_left = (int(top_left[0]), int(top_left[1]))
+        center = (int(top_left[0] + (bottom_right[0]-top_left[0])/2),
+                  int(top_left[1] + (bottom_right[1]-top_left[1])/2))
+        # draw the top left (x,y) coordinates of the marker
+        cv2.circle(frame, center, 4, (0, 0, 255), -1)
 
-                return center
-        else:
-            return None
+        return center
 
     def get_corners(self, frame):
         (corners, ids, rejected) = aruco.detectMarkers(frame, self.aruco_dict, parameters=self.aruco_params)
@@ -0,0 +1,153 @@
+import ctypes
+
+import numpy as np
+
+
+class StoredMask:
+    """Object mask of one frame held by a mask store. Decoded on access, like detectron2 GenericMask.mask."""
+
+    def __init__(self, store, frame, label):
+        self.store = store
+        self.frame = frame
+        self.label = label
+
+    @property
+    def mask(self):
+        return self.store.get(self.frame, self.label)
+
+
+class MaskStore:
+    """Detic masks of the primary region run-length encoded per frame and object.
+
+    Masks are kept as runs cropped to their rows instead of full frame arrays, and unions over frames are built on the
+    runs. Objects are referred to by label; ids are assigned on first use.
+    """
+
+    def __init__(self, width, height, lib_path='ReplayApi.dll'):
+        self.lib = ctypes.CDLL(lib_path)
+        self.lib.rr_MaskStoreCreate.restype = ctypes.c_void_p
+        self.lib.rr_MaskStoreCreate.argtypes = [ctypes.c_int32, ctypes.c_int32]
+        self.lib.rr_MaskStoreDestroy.argtypes = [ctypes.c_void_p]
+        self.lib.rr_MaskStorePut.restype = ctypes.c_int32
+        self.lib.rr_MaskStorePut.argtypes = [ctypes.c_void_p, ctypes.c_int64, ctypes.c_int64, ctypes.c_void_p, ctypes.c_int32]
+        self.lib.rr_MaskStoreGetMask.restype = ctypes.c_int32
+        self.lib.rr_MaskStoreGetMask.argtypes = [ctypes.c_void_p, ctypes.c_int64, ctypes.c_int64, ctypes.c_void_p, ctypes.c_int32,
+                                                 ctypes.c_uint8]
+        self.lib.rr_MaskStoreGetCentroid.restype = ctypes.c_int32
+        self.lib.rr_MaskStoreGetCentroid.argtypes = [ctypes.c_void_p, ctypes.c_int64, ctypes.c_int64, ctypes.POINTER(ctypes.c_float)]
+        self.lib.rr_MaskStoreGetUnion.restype = ctypes.c_int32
+        self.lib.rr_MaskStoreGetUnion.argtypes = [ctypes.c_void_p, ctypes.POINTER(ctypes.c_int64), ctypes.c_int32, ctypes.c_void_p,
+                                                  ctypes.c_int32, ctypes.c_uint8]
+        self.lib.rr_MaskStoreGetCount.restype = ctypes.c_int64
+        self.lib.rr_MaskStoreGetCount.argtypes = [ctypes.c_void_p]
+        self.lib.rr_MaskStoreGetByteSize.restype = ctypes.c_int64
+        self.lib.rr_MaskStoreGetByteSize.argtypes = [ctypes.c_void_p]
+        self.lib.rr_MaskStoreSave.restype = ctypes.c_int32
+        self.lib.rr_MaskStoreSave.argtypes = [ctypes.c_void_p, ctypes.c_char_p]
+
+        self.handle = self.lib.rr_MaskStoreCreate(width, height)
+        if not self.handle:
+            raise ValueError(f'Invalid mask store configuration: size=({width}, {height})')
+        self.shape = (height, width)
+        self.ids = {}
+
+    def object_id(self, label):
+        if label not in self.ids:
+            self.ids[label] = len(self.ids)
+        return self.ids[label]
+
+    def put(self, frame, label, mask):
+        """Stores non-zero pixels of HxW mask for frame and object. Returns StoredMask referring to it."""
+        mask = np.ascontiguousarray(mask, dtype=np.uint8)
+        if mask.shape != self.shape or not self.lib.rr_MaskStorePut(self.handle, frame, self.object_id(label), mask.ctypes.data,
+                                                                    mask.strides[0]):
+            raise ValueError(f'Invalid mask: shape={mask.shape}, expected {self.shape}')
+        return StoredMask(self, frame, label)
+
+    def get(self, frame, label, value=1):
+        """Returns HxW uint8 mask of object in frame with set pixels of value, None if not stored."""
+        mask = np.empty(self.shape, np.uint8)
+        if label not in self.ids or not self.lib.rr_MaskStoreGetMask(self.handle, frame, self.ids[label], mask.ctypes.data,
+                                                                     mask.strides[0], value):
+            return None
+        return mask
+
+    def centroid(self, frame, label):
+        """Returns (x, y) centroid of object mask in frame, None if not stored or empty."""
+        centroid = (ctypes.c_float * 2)()
+        if label not in self.ids or not self.lib.rr_MaskStoreGetCentroid(self.handle, frame, self.ids[label], centroid):
+            return None
+        return centroid[0], centroid[1]
+
+    def union(self, frames, value=1):
+        """Returns HxW uint8 union of all object masks in frames with set pixels of value."""
+        frames = list(frames)
+        mask = np.empty(self.shape, np.uint8)
+        if not self.lib.rr_MaskStoreGetUnion(self.handle, (ctypes.c_int64 * len(frames))(*frames), len(frames), mask.ctypes.data,
+                                             mask.strides[0], value):
+            raise RuntimeError('Building mask union failed')
+        return mask
+
+    def count(self):
+        return self.lib.rr_MaskStoreGetCount(self.handle)
+
+    def byte_size(self):
+        return self.lib.rr_MaskStoreGetByteSize(self.handle)
+
+    def save(self, filename):
+        """Saves all masks losslessly. Returns False on failure."""
+        return bool(self.lib.rr_MaskStoreSave(self.handle, filename.encode()))
+
+    def close(self):
+        if self.handle:
+            self.lib.rr_MaskStoreDestroy(self.handle)
+            self.handle = None
+
+    def __del__(self):
+        self.close()
+
+
+class ReferenceMaskStore:
+    """Numpy version of MaskStore keeping full frame masks, used by the detector without the library."""
+
+    def __init__(self, width, height):
+        self.shape = (height, width)
+        self.masks = {}
+
+    def put(self, frame, label, mask):
+        mask = np.asarray(mask, dtype=np.uint8)
+        if mask.shape != self.shape:
+            raise ValueError(f'Invalid mask: shape={mask.shape}, expected {self.shape}')
+        self.masks[frame, label] = mask > 0
+        return StoredMask(self, frame, label)
+
+    def get(self, frame, label, value=1):
+        mask = self.masks.get((frame, label))
+        return None if mask is None else mask.astype(np.uint8) * np.uint8(value)
+
+    def centroid(self, frame, label):
+        mask = self.masks.get((frame, label))
+        if mask is None or not mask.any():
+            return None
+        ys, xs = np.nonzero(mask)
+        return xs.mean(), ys.mean()
+
+    def union(self, frames, value=1):
+        frames = set(frames)
+        mask = np.zeros(self.shape, bool)
+        for (frame, _), object_mask in self.masks.items():
+            if frame in frames:
+                mask |= object_mask
+        return mask.astype(np.uint8) * np.uint8(value)
+
+    def count(self):
+        return len(self.masks)
+
+    def byte_size(self):
+        return sum(mask.nbytes for mask in self.masks.values())
+
+    def save(self, filename):
+        return False
+
+    def close(self):
+        pass
@@ -10,12 +10,31 @@ import copy
 from scipy.ndimage.filters import gaussian_filter
 from vidgear.gears.stabilizer import Stabilizer
 from threading import Thread
-
+from collections import deque
+from concurrent.futures import Future
+
+from inference.batch_scheduler import BatchScheduler
+from inference.change_index import ChangeIndex
+from inference.clip_buffer import ClipBuffer
+from inference.equirect_snapshot import EquirectSnapshotStream
+from inference.foveal_frame import read_snapshot
+from inference.frame_store import FrameStore
+from inference.gaze_history import GazeHistory
+from inference.latency_trace import FrameTrace, INGEST, DETECTION, VISUALIZATION
 from inference.marker_tracking import Marker
+from inference.mask_store import MaskStore, ReferenceMaskStore
+from inference.overlay_compositor import BLEND_ADD, BLEND_SCALE, NO_TINT, OverlayCompositor, ReferenceCompositor
+from inference.polyline_layer import PolylineLayer, ReferencePolylineLayer
 from inference.model import TASED_v2
+from inference.replay_bundle import ReplayBundleWriter
+from inference.spherical_stabilizer import SphericalStabilizer
+from inference.trajectory_store import ReferenceTrajectoryStore, TrajectoryStore
+from inference.work_queue import WorkQueue
 import matplotlib
 
 from detectron2.config import get_cfg
+from detectron2.data.transforms import ResizeShortestEdge
+from detectron2.utils.visualizer import Visualizer
 from detectron2.utils.logger import setup_logger
 
 sys.path.insert(0, 'Detic/third_party/CenterNet2/projects/CenterNet2/')
@@ -37,9 +56,18 @@ FOV = 60   # Varjo FOV: 115
 SMOOTHING_RADIUS = 5
 MOTION_LINE_WINDOW = 10
 MOTION_HISTORY_WINDOW = 10
+EQUIRECT_SOURCE = 'cubemap'  # Video input reading the recorder's equirect snapshots of the environment cubemap
 # REPLAY_WINDOW = 5
 LINE_THICKNESS = 2
 PRIMARY_THRESH = (5, 5)
+FRAME_STORE_BUDGET = 256 * 1024 * 1024   # bytes of primary region history in memory, older frames spill to disk
+DETIC_QUEUE_CAPACITY = 2   # primary region frames waiting for Detic, the oldest is dropped when full
+DETIC_MAX_AGE = 2.0   # seconds a frame may wait for Detic before it is dropped as stale
+DETIC_MAX_BATCH = 4   # primary region frames per Detic model call
+DETIC_LATENCY_BOUND = 1.0   # seconds a frame may wait for its Detic batch to close
+SALIENCY_MAX_BATCH = 2   # saliency clips per model call, further clips wait for a free slot
+SALIENCY_LATENCY_BOUND = 0.5   # seconds a clip may wait for its saliency batch to close
+GAZE_LOG = '../../VarjoCameraRecorder/VarjoCameraRecorder/bin/frames/gaze.log'   # gaze_log of capture.cfg
 
 # Static objects
 static_objects = ['desk', 'sofa', 'dining_table', 'kitchen_table', 'coffee_table', 'crossbar']
@@ -156,14 +184,20 @@ def smooth(trajectory):
     return smoothed_trajectory
 
 
-def get_centroid(binary_mask):
-    M = cv2.moments(binary_mask)
-    if M["m00"] > 0:
-        # Calculate the centroid of each mask
-        cX = int(M["m10"] / M["m00"])
-        cY = int(M["m01"] / M["m00"])
-        return (cX, cY)
-    return None
+def view_direction(theta, phi):
+    """World direction of a GetPerspective view center, angles in degrees on the recorder equirect frame, -Z forward."""
+    yaw, pitch = math.radians(theta), math.radians(phi)
+    return math.cos(pitch) * math.sin(yaw), math.sin(pitch), -math.cos(pitch) * math.cos(yaw)
+
+
+def native_or_fallback(create, fallback, unavailable):
+    """Returns create(), or fallback() when the native library cannot be loaded. A fallback of None returns None.
+    unavailable describes what runs instead and is printed with the load error."""
+    try:
+        return create()
+    except OSError as e:
+        print(f'{unavailable}: {e}')
+        return fallback() if fallback is not None else None
 
 
 class OnlineDetector:
@@ -181,18 +215,24 @@ class OnlineDetector:
         self.replay_demo = output_path + '/replay_demo'
         self.replay_output = output_path + '/replay'
         self.gray_replay_output = output_path + '/gray_replay'
-        self.obj_mask_output = output_path + '/obj_mask'
+        # Detic masks of all detections, run-length encoded without loss
+        self.obj_mask_output = output_path + '/obj_masks.rle'
         self.primary_region_path = output_path + '/primary_region'
         self.visualization_output = output_path + '/visualization'
         self.er_path = output_path + '/original_er'
         self.saliency_map_path = output_path + '/saliency_map'
         self.varjo_frame = output_path + '/varjo_frame.jpg'     # could be .bmp
+        # Visualization tracks for Unity in one file, next to the per-frame folders
+        self.output_path = output_path
+        self.replay_bundle_path = output_path + '/replay.bundle'
+        # Latency trace of the Varjo frame, handed to Unity next to the visualizations
+        self.overlay_trace = output_path + '/overlay.trace'
 
         # Create output directories if they don't exist
         output_paths = [self.motion_history_output, self.motion_history_demo,
                         self.motion_line_output, self.motion_line_demo, self.motion_line_traj,
                         self.replay_output, self.gray_replay_output, self.replay_demo,
-                        self.obj_mask_output, self.primary_region_path, self.saliency_map_path,
+                        self.primary_region_path, self.saliency_map_path,
                         self.er_path, self.visualization_output]
         if not os.path.exists(output_path):
             os.mkdir(output_path)
@@ -206,8 +246,6 @@ class OnlineDetector:
         self.current_saliency_map = None
         self.images_sal = []
         self.is_calc_saliency = False
-        self.or_calc_count = 0
-        self.or_pool_size = 1
         self.obj_mask = None
         self.obj_masked_img = None
         self.obj_bbox = None
@@ -226,8 +264,6 @@ class OnlineDetector:
         self.mh_dx, self.mh_dy = 0, 0
         self.mh_replay = []
         self.motion_lines = []     # store [[((new_x, new_y), (old_x, old_y)) for i] for frame]
-        self.all_motion_lines = {}
-        self.motion_line_dict = {}
         self.motion_line_color = {}  # store {label: color}
         self.motion_line_color = {
             # BGR
@@ -256,6 +292,35 @@ class OnlineDetector:
         self.p0 = None
         self.er_frame = None
         self.marker = Marker()
+        # Rotation-only stabilization on the sphere, falls back to 2D affine stabilization without the native library
+        self.stabilizer = native_or_fallback(SphericalStabilizer, None,
+                                             'Spherical stabilizer unavailable, using affine stabilization')
+        # Visualization layers are composited natively, or with the same arithmetic in numpy without the library
+        self.compositor = native_or_fallback(OverlayCompositor, ReferenceCompositor,
+                                             'Overlay compositor unavailable, compositing in numpy')
+        # Centroid of each object per detection, the motion line up to a detection is a time-range query
+        self.trajectories = native_or_fallback(TrajectoryStore, ReferenceTrajectoryStore,
+                                               'Trajectory store unavailable, keeping trajectories in Python')
+        self.primary_view = None
+        # Marker corners in the stabilization reference frame, for the rotation prior
+        self.reference_corners = None
+        # Primary region history under a memory budget, kept as frame handles. A plain list without the library
+        self.frame_store = native_or_fallback(lambda: FrameStore(output_path + '/primary_history.spill', FRAME_STORE_BUDGET), None,
+                                              'Frame store unavailable, keeping primary region history in memory')
+        # Saliency clip kept resized and normalized as frames arrive. A list resized per inference without the library
+        self.clip_buffer = native_or_fallback(lambda: ClipBuffer(size=(384, 224), length=self.len_temporal), None,
+                                              'Clip buffer unavailable, resizing the saliency clip per inference')
+        # Detection jobs are bounded and dropped when stale, so Detic stays close to real time. A list without the library
+        self.detic_queue = native_or_fallback(lambda: WorkQueue('detic', capacity=DETIC_QUEUE_CAPACITY), None,
+                                              'Work queue unavailable, queueing all frames for detection')
+        # Primary region frame of each detection, frames dropped by the queue have no detection
+        self.detection_frames = []
+        # Where and when objects changed in the primary region, created once the view size is known
+        self.change_index = None
+        # Detic masks of each detection, created once the view size is known
+        self.mask_store = None
+        # Sensor timestamp and primary view (theta, phi) of each frame number, only for recorder equirect input
+        self.frame_views = {}
 
         self.frame_w, self.frame_h = 640, 480
         self.view_size = (self.frame_h // RESIZE_H, self.frame_w // RESIZE_W)  # h, w
@@ -280,11 +345,15 @@ class OnlineDetector:
         self.is_replaying = False
         self.frame_count = 0
 
-        self.is_varjo_frame = False
         self.varjo_image = None
 
         self.sal_thread = None
         self.detic_thread = None
+        # Micro-batched model calls, created with the models. Saliency runs a thread per clip and Detic one image per
+        # call without the library
+        self.saliency_batches = None
+        self.saliency_futures = []
+        self.detic_batches = None
 
         # Detic
         cfg = setup_cfg()
@@ -323,6 +392,13 @@ class OnlineDetector:
         # run the eval function on the saliency model
         self.model.eval()
 
+        self.saliency_batches = native_or_fallback(
+            lambda: BatchScheduler((3, self.len_temporal, 224, 384), max_batch=SALIENCY_MAX_BATCH,
+                                   latency_bound=SALIENCY_LATENCY_BOUND, max_pending=SALIENCY_MAX_BATCH), None,
+            'Batch scheduler unavailable, running saliency in a thread per clip')
+        if self.saliency_batches is not None:
+            Thread(target=self.run_batches, args=(self.saliency_batches, self.get_saliency_maps), daemon=True).start()
+
 
     def transform(self, snippet):
         ''' stack & noralization '''
@@ -334,17 +410,41 @@ class OnlineDetector:
 
     def process_sal_async(self):
         if not self.is_calc_saliency:
-            images_resized = []
-
-            for frame in self.images_sal:
-                img = cv2.resize(frame, (384, 224))
-                images_resized.append(img)
-
+            if self.clip_buffer is not None:
+                window = self.clip_buffer.window()
+                if window is None:
+                    return
+                # Upload or submit right away, the view is only valid for a few more pushes. Submit copies it
+                clip = window if self.saliency_batches is not None else torch.from_numpy(window).cuda()
+            else:
+                images_resized = []
+
+                for frame in self.images_sal:
+                    img = cv2.resize(frame, (384, 224))
+                    images_resized.append(img)
+                clip = self.transform(images_resized)
+
+            print("Run saliency model")
+            if self.saliency_batches is not None:
+                # Clips queued while the model runs share the next call, the map is saved when the clip's batch completes
+                future = self.saliency_batches.submit(clip[0] if isinstance(clip, np.ndarray) else clip[0].numpy())
+                future.add_done_callback(self.saliency_done)
+                self.images_sal = []
+                self.saliency_futures = [f for f in self.saliency_futures if not f.done()] + [future]
+                self.is_calc_saliency = len(self.saliency_futures) >= SALIENCY_MAX_BATCH
+                return
             self.is_calc_saliency = True
-            Thread(target=self.process_sal, args=([images_resized])).start()
+            Thread(target=self.process_sal, args=([clip])).start()
+
+    def saliency_done(self, future):
+        """Saves saliency map of a batched clip. Runs on the saliency model thread."""
+        self.is_calc_saliency = False
+        if future.cancelled() or future.result() is None:
+            return
+        self.current_saliency_map = future.result()
+        cv2.imwrite(self.saliency_map_path + f'/{self.obj_rec_count:04d}.jpg', self.current_saliency_map)
 
-    def process_sal(self, images_resized):
-        clip = self.transform(images_resized)
+    def process_sal(self, clip):
         self.current_saliency_map = self.get_saliency_map(clip)
         frame_idx = self.obj_rec_count
 
@@ -364,154 +464,281 @@ class OnlineDetector:
     def process_detic(self):
         # Process the first image in image stack instead of the current frame
 
+        # Frames handed to the batch scheduler as (job_id, frame_file, image, future), handled in queue order
+        in_flight = deque()
         while True:
-            if len(self.images_or) > 1:
-                image = self.images_or.pop(0)
-                if self.is_varjo_frame:
-                    image = None
-                    while image is None:
-                        image = cv2.imread(
-                            "../../VarjoCameraRecorder/VarjoCameraRecorder/bin/frames/left.bmp")
-                    image_h, image_w, _ = image.shape
-                    crop_w = int(image_w * 0.14)
-                    crop_h = int(image_h * 0.23)
-                    image = image[crop_h:image_h - crop_h, crop_w:image_w - crop_w]
-                    cv2.imwrite(
-                        "../../VarjoCameraRecorder/VarjoCameraRecorder/bin/frames/cropped_left.bmp",
-                        image)
-
-                    start_time = time.time()
-                    predictions, visualized_output = self.detic.run_on_image(image)
-                    output_image, orig_masks, orig_labels, orig_boxes = visualized_output
-                    confidences = [int(label.split(" ")[1].strip('%')) for label in orig_labels]
-                    orig_labels = [label.split(" ")[0] for label in orig_labels]
-
-                    logger.info(
-                        "{}: {} in {:.2f}s".format(
-                            "LAST",
-                            "detected {} instances".format(len(predictions["instances"]))
-                            if "instances" in predictions
-                            else "finished",
-                            time.time() - start_time,
-                        )
-                    )
-                    self.curr_obj_pos = list(zip(orig_masks, orig_labels, orig_boxes))
-                    denylist = []
-
-                    label_set = set(orig_labels)
-                    for label in label_set:
-                        indices = [i for i, x in enumerate(orig_labels) if x == label]
-                        if len(indices) > 1:
-                            max_confidence = 0
-                            max_index = 0
-                            for i in indices:
-                                if confidences[i] >= max_confidence:
-                                    max_confidence = confidences[i]
-                                    max_index = i
-
-                            indices.remove(max_index)
-                            for i in indices:
-                                denylist.append(i)
-
-                    if self.curr_obj_pos is not None:
-                        # Delete objects in denylist
-                        self.curr_obj_pos = np.delete(self.curr_obj_pos, denylist, 0)
-
-                    # self.apply_visualization(image, curr_obj_pos)
+            job = None
+            if len(in_flight) < DETIC_MAX_BATCH:
+                job = self.pop_detection(timeout=0.0 if in_flight else 0.1)
+            if job is not None:
+                job_id, frame_file, image = job
+                if frame_file is None:
+                    # Last job of the session: detect on the Varjo snapshot and hand its trace to run()
+                    while in_flight:
+                        self.handle_detection(*in_flight.popleft())
+                    _, varjo_detection = image
+                    try:
+                        varjo_detection.set_result(self.detect_varjo_snapshot())
+                    except Exception as e:
+                        varjo_detection.set_exception(e)
+                    self.complete_detection(job_id)
                     print("OBJECT RECOGNITION DONE")
                     break
-                frame_idx = self.obj_rec_count
-                self.obj_rec_count += 1
-                print("Start evaluation: ", self.or_calc_count)
-
-                start_time = time.time()
-                predictions, visualized_output = self.detic.run_on_image(image)
-                output_image, orig_masks, orig_labels, orig_boxes = visualized_output
-                logger.info(
-                    "{}: {} in {:.2f}s".format(
-                        frame_idx,
-                        "detected {} instances".format(len(predictions["instances"]))
-                        if "instances" in predictions
-                        else "finished",
-                        time.time() - start_time,
-                    )
-                )
-                confidences = [int(label.split(" ")[1].strip('%')) for label in orig_labels]
-                orig_labels = [label.split(" ")[0] for label in orig_labels]
-                print("orig labels: ", orig_labels)
-
-                # Multithreading: Run or_calc_count number of object recognition jobs at a time
-                self.or_calc_count -= 1
-
-                # Semantic rejection
-                # masks = orig_masks.copy()
-                # orig_masks = [mask[orig_boxes.tensor[i][0]:ori] for i, mask in enumerate(orig_masks)]
-                # print("orig box[0]: ", orig_boxes.tensor[0][0])
-                # Boxes(tensor (Tensor[float]): a Nx4 matrix.  Each row is (x1, y1, x2, y2))
-
-                masks = list(zip(orig_masks, orig_labels, orig_boxes))
-                print("orig_masks: ", orig_masks)
-                print("Masks: ", masks)
-
-                denylist = []
-
-                label_set = set(orig_labels)
-
-                self.obj_set.update(label_set)
-
-                for label in label_set:
-                    indices = [i for i, x in enumerate(orig_labels) if x == label]
-                    max_confidence = 0
-                    max_index = 0
-                    for i in indices:
-                        if confidences[i] >= max_confidence:
-                            max_confidence = confidences[i]
-                            max_index = i
-                    indices.remove(max_index)
-                    for i in indices:
-                        denylist.append(i)
+                if self.detic_batches is None:
+                    self.handle_detection(job_id, frame_file, image, None)
+                else:
+                    # Keep taking queued frames so that they share a model call, results come back by request id
+                    in_flight.append((job_id, frame_file, image, self.detic_batches.submit(image)))
+            elif in_flight:
+                self.handle_detection(*in_flight.popleft())
+
+    def handle_detection(self, job_id, frame_file, image, detection):
+        """Runs Detic on primary region frame, or takes the batched result from detection future, and stores its masks."""
+        print("Start evaluation: ", frame_file, "backlog:", self.detection_backlog())
+        start_time = time.time()
+        if detection is None:
+            predictions, visualized_output = self.detic.run_on_image(image)
+        else:
+            predictions = None if detection.cancelled() else detection.result()
+            if predictions is None:
+                print("Detection failed: ", frame_file)
+                self.complete_detection(job_id)
+                return
+            visualized_output = self.visualize_detection(image, predictions)
 
-                for i, label in enumerate(orig_labels):
-                    # class_name = label.split()[0]
-                    # # confidence = label.split()[1]
-                    # labels.append(class_name)
-                    if label in static_objects:
+        frame_idx = self.obj_rec_count
+        self.detection_frames.append(frame_file)
+        self.obj_rec_count += 1
+
+        output_image, orig_masks, orig_labels, orig_boxes = visualized_output
+        logger.info(
+            "{}: {} in {:.2f}s".format(
+                frame_idx,
+                "detected {} instances".format(len(predictions["instances"]))
+                if "instances" in predictions
+                else "finished",
+                time.time() - start_time,
+            )
+        )
+        confidences = [int(label.split(" ")[1].strip('%')) for label in orig_labels]
+        orig_labels = [label.split(" ")[0] for label in orig_labels]
+        print("orig labels: ", orig_labels)
+
+        # Semantic rejection
+        # masks = orig_masks.copy()
+        # orig_masks = [mask[orig_boxes.tensor[i][0]:ori] for i, mask in enumerate(orig_masks)]
+        # print("orig box[0]: ", orig_boxes.tensor[0][0])
+        # Boxes(tensor (Tensor[float]): a Nx4 matrix.  Each row is (x1, y1, x2, y2))
+
+        masks = list(zip(orig_masks, orig_labels, orig_boxes))
+        print("orig_masks: ", orig_masks)
+        print("Masks: ", masks)
+
+        denylist = []
+
+        label_set = set(orig_labels)
+
+        self.obj_set.update(label_set)
+
+        for label in label_set:
+            indices = [i for i, x in enumerate(orig_labels) if x == label]
+            max_confidence = 0
+            max_index = 0
+            for i in indices:
+                if confidences[i] >= max_confidence:
+                    max_confidence = confidences[i]
+                    max_index = i
+            indices.remove(max_index)
+            for i in indices:
+                denylist.append(i)
+
+        for i, label in enumerate(orig_labels):
+            # class_name = label.split()[0]
+            # # confidence = label.split()[1]
+            # labels.append(class_name)
+            if label in static_objects:
+                denylist.append(i)
+
+        # Process output masks
+        if masks is not None:
+            # Delete objects in denylist
+            masks = np.delete(masks, denylist, 0)
+
+            # Delete masks outside salient region
+
+            denylist = []
+            if self.current_saliency_map is not None:
+                salient_region = np.argwhere(self.current_saliency_map > SALIENCY_THRESHOLD)
+                salient_region = np.delete(salient_region, -1, 1)
+                salient_region = [tuple(i) for i in salient_region]
+
+                for i, (mask, label, box) in enumerate(masks):
+                    binary_mask = mask.mask
+                    binary_mask_coords = np.argwhere(binary_mask > 0)
+                    binary_mask_coords = [tuple(c) for c in binary_mask_coords]
+                    intersections = set(binary_mask_coords).intersection(set(salient_region))
+
+                    if len(intersections) <= 10:
                         denylist.append(i)
 
-                # Process output masks
-                if masks is not None:
-                    # Delete objects in denylist
-                    masks = np.delete(masks, denylist, 0)
-
-                    # Delete masks outside salient region
-                    
-                    denylist = []
-                    if self.current_saliency_map is not None:
-                        salient_region = np.argwhere(self.current_saliency_map > SALIENCY_THRESHOLD)
-                        salient_region = np.delete(salient_region, -1, 1)
-                        salient_region = [tuple(i) for i in salient_region]
-
-                        for i, (mask, label, box) in enumerate(masks):
-                            binary_mask = mask.mask
-                            binary_mask_coords = np.argwhere(binary_mask > 0)
-                            binary_mask_coords = [tuple(c) for c in binary_mask_coords]
-                            intersections = set(binary_mask_coords).intersection(set(salient_region))
-
-                            if len(intersections) <= 10:
-                                denylist.append(i)
-
-                        masks = np.delete(masks, denylist, 0)
-                    
-
-                    # Store masks for the frame
-                    self.masks[frame_idx] = masks
+                masks = np.delete(masks, denylist, 0)
+
+
+            # Changes are indexed by capture frame number, detections can be dropped so obj_rec_count skips frames
+            if self.change_index is not None:
+                for mask, label, box in masks:
+                    self.change_index.add_mask(frame_file, label, mask.mask)
+            # Store masks for the frame, the full frame Detic masks are dropped
+            self.masks[frame_idx] = [(self.mask_store.put(frame_idx, label, mask.mask), label, box) for mask, label, box in masks]
+
+            # Thread(target=self.process_viz, args=([self.obj_rec_count-1])).start()
+            viz_start_time = time.time()
+            self.process_viz(self.obj_rec_count-1)
+            print(f"viz processing time: {time.time() - viz_start_time}s")
+
+        print(f"time: {time.time() - start_time}s")
+        self.complete_detection(job_id)
+
+    def create_detic_batches(self):
+        """Creates Detic batch scheduler for primary region frames of view_size and starts its model thread.
+
+        Frames are resized to the Detic input size on the scheduler thread while the previous batch runs.
+        """
+        predictor = self.detic.predictor
+        height, width = self.view_size
+        input_height, input_width = ResizeShortestEdge.get_output_shape(height, width, predictor.aug.short_edge_length[0],
+                                                                        predictor.aug.max_size)
+
+        def preprocess(source, slot):
+            image = source.reshape(height, width, 3)
+            if predictor.input_format == 'RGB':
+                image = image[:, :, ::-1]
+            slot[:] = predictor.aug.get_transform(image).apply_image(image)
+
+        self.detic_batches = native_or_fallback(
+            lambda: BatchScheduler((input_height, input_width, 3), dtype=np.uint8, max_batch=DETIC_MAX_BATCH,
+                                   latency_bound=DETIC_LATENCY_BOUND, max_pending=2 * DETIC_MAX_BATCH, preprocess=preprocess),
+            None, 'Batch scheduler unavailable, running Detic one image per call')
+        if self.detic_batches is None:
+            return
+        Thread(target=self.run_batches, args=(self.detic_batches, self.detect_batch), daemon=True).start()
+
+    def detect_batch(self, images):
+        """Runs Detic on (count, h, w, 3) preprocessed frames. Returns predictions of each frame at primary region size."""
+        height, width = self.view_size
+        inputs = [{'image': torch.as_tensor(image.astype('float32').transpose(2, 0, 1)), 'height': height, 'width': width}
+                  for image in images]
+        with torch.no_grad():
+            return self.detic.predictor.model(inputs)
 
-                    # Thread(target=self.process_viz, args=([self.obj_rec_count-1])).start()
-                    viz_start_time = time.time()
-                    self.process_viz(self.obj_rec_count-1)
-                    print(f"viz processing time: {time.time() - viz_start_time}s")
+    def visualize_detection(self, image, predictions):
+        """Draws batched predictions on image like VisualizationDemo.run_on_image. Returns the same visualized output."""
+        visualizer = Visualizer(image[:, :, ::-1], self.detic.metadata, instance_mode=self.detic.instance_mode)
+        return visualizer.draw_instance_predictions(predictions=predictions["instances"].to(self.detic.cpu_device))
 
-                print(f"time: {time.time() - start_time}s")
+    def run_batches(self, scheduler, model):
+        """Model loop of scheduler, calls model on each batch until the scheduler stops. A failed batch resolves to None."""
+        while True:
+            batch = scheduler.next_batch()
+            if batch is None:
+                break
+            batch, inputs = batch
+            try:
+                results = model(inputs)
+            except Exception as e:
+                print(f'Batched inference failed: {e}')
+                results = [None] * batch.count
+            scheduler.finish(batch, results)
+
+    def detect_varjo_snapshot(self):
+        """Detects objects on the current Varjo snapshot into curr_obj_pos. Returns the frame trace of the snapshot, None
+        if it has none."""
+        image = None
+        while image is None:
+            image = read_snapshot("../../VarjoCameraRecorder/VarjoCameraRecorder/bin/frames/left")
+        frame_trace = FrameTrace.read("../../VarjoCameraRecorder/VarjoCameraRecorder/bin/frames/left.trace")
+        if frame_trace is not None:
+            frame_trace.stamp(INGEST)
+        image_h, image_w, _ = image.shape
+        crop_w = int(image_w * 0.14)
+        crop_h = int(image_h * 0.23)
+        image = image[crop_h:image_h - crop_h, crop_w:image_w - crop_w]
+        cv2.imwrite(
+            "../../VarjoCameraRecorder/VarjoCameraRecorder/bin/frames/cropped_left.bmp",
+            image)
+
+        start_time = time.time()
+        predictions, visualized_output = self.detic.run_on_image(image)
+        if frame_trace is not None:
+            frame_trace.stamp(DETECTION)
+        output_image, orig_masks, orig_labels, orig_boxes = visualized_output
+        confidences = [int(label.split(" ")[1].strip('%')) for label in orig_labels]
+        orig_labels = [label.split(" ")[0] for label in orig_labels]
+
+        logger.info(
+            "{}: {} in {:.2f}s".format(
+                "LAST",
+                "detected {} instances".format(len(predictions["instances"]))
+                if "instances" in predictions
+                else "finished",
+                time.time() - start_time,
+            )
+        )
+        self.curr_obj_pos = list(zip(orig_masks, orig_labels, orig_boxes))
+        denylist = []
+
+        label_set = set(orig_labels)
+        for label in label_set:
+            indices = [i for i, x in enumerate(orig_labels) if x == label]
+            if len(indices) > 1:
+                max_confidence = 0
+                max_index = 0
+                for i in indices:
+                    if confidences[i] >= max_confidence:
+                        max_confidence = confidences[i]
+                        max_index = i
+
+                indices.remove(max_index)
+                for i in indices:
+                    denylist.append(i)
+
+        if self.curr_obj_pos is not None:
+            # Delete objects in denylist
+            self.curr_obj_pos = np.delete(self.curr_obj_pos, denylist, 0)
+        return frame_trace
+
+    def push_detection(self, frame_file, image, deadline=DETIC_MAX_AGE):
+        """Queues image for Detic. frame_file is the index of the saved primary region, None for the Varjo snapshot."""
+        if self.detic_queue is not None:
+            self.detic_queue.push((frame_file, image), -1 if frame_file is None else frame_file, deadline)
+        else:
+            self.images_or.append((frame_file, image))
+
+    def pop_detection(self, timeout=0.1):
+        """Returns (job_id, frame_file, image) of the oldest live detection job, None if none arrives within timeout."""
+        if self.detic_queue is not None:
+            job = self.detic_queue.pop(timeout=timeout)
+            if job is None:
+                return None
+            job_id, (frame_file, image), _, _ = job
+            return job_id, frame_file, image
+        if not self.images_or:
+            if timeout > 0:
+                time.sleep(0.01)
+            return None
+        frame_file, image = self.images_or.pop(0)
+        return None, frame_file, image
+
+    def complete_detection(self, job_id):
+        if self.detic_queue is not None:
+            self.detic_queue.complete(job_id)
+
+    def detection_backlog(self):
+        return self.detic_queue.stats()['depth'] if self.detic_queue is not None else len(self.images_or)
+
+    def detection_frame_path(self, frame_idx):
+        """Path of the primary region frame detection frame_idx ran on."""
+        return self.primary_region_path + f'/{self.detection_frames[frame_idx]:04d}.jpg'
 
     def process_viz(self, frame_idx):
         # Compute motion line and motion history
@@ -519,21 +746,20 @@ class OnlineDetector:
         # frame_idx = self.frame_count
         print("process VIZ: ", frame_idx)
         if frame_idx > 0:
-            if os.path.exists(self.obj_mask_output + f'/{frame_idx - 1:04d}.jpg'):
+            if frame_idx - 1 in self.motion_history:
                 self.save_motion_line(frame_idx - 1, frame_idx)
                 self.save_motion_history(frame_idx - 1, frame_idx)
             else:
-                print("PATH NOT EXIST: ", self.obj_mask_output + f'/{frame_idx - 1:04d}.jpg')
+                print("NO MOTION HISTORY: ", frame_idx - 1)
         else:
             # For the first frame
             print("FIRST FRAME")
             h, w = self.view_size
-            image = cv2.imread(self.primary_region_path + f'/{frame_idx:04d}.jpg')
+            image = cv2.imread(self.detection_frame_path(frame_idx))
             # masks, labels = self.masks[frame_idx]
             mask_labels = self.masks[frame_idx]
-            binary_mask = np.full((h, w), 0, dtype=np.uint8)
             for mask, label, box in mask_labels:
-                binary_mask = cv2.add(binary_mask, mask.mask)
+                binary_mask = mask.mask
 
                 # Test writing the patch into the frame
                 masked = cv2.bitwise_and(image, image, mask=binary_mask)
@@ -579,8 +805,6 @@ class OnlineDetector:
                 self.mh_prev_x[label], self.mh_prev_y[label] = int(box[0]), int(box[1])
                 self.mh_prev_w[label], self.mh_prev_h[label] = int(box[2] - box[0]), int(box[3] - box[1])
                 # cv2.imwrite(self.obj_mask_output + f'/mask_patch_{frame_idx:04d}_{label}.png', mask_patch)
-            masked = cv2.bitwise_and(image, image, mask=binary_mask)
-            cv2.imwrite(self.obj_mask_output + f'/{frame_idx:04d}.jpg', masked)
             # cv2.imwrite(self.replay_output + f'/{frame_idx:04d}.png', masked)
 
             self.motion_history[frame_idx] = np.zeros((h, w), np.float32)
@@ -590,7 +814,17 @@ class OnlineDetector:
         with torch.no_grad():
             smap = self.model(clip.cuda()).cpu().data[0]
 
-        smap = (smap.numpy() * 255.).astype(int) / 255.
+        return self.saliency_color(smap.numpy())
+
+    def get_saliency_maps(self, clips):
+        """Runs saliency model on (count, 3, length, 224, 384) clips. Returns saliency map of each clip."""
+        with torch.no_grad():
+            smaps = self.model(torch.from_numpy(clips).cuda()).cpu().numpy()
+
+        return [self.saliency_color(smap) for smap in smaps]
+
+    def saliency_color(self, smap):
+        smap = (smap * 255.).astype(int) / 255.
         smap = gaussian_filter(smap, sigma=7)
         grayscale = (smap / np.max(smap) * 255.).astype(np.uint8)
 
@@ -601,103 +835,44 @@ class OnlineDetector:
         return resized_color
 
     def save_motion_line(self, prev_idx, curr_idx):
-        color = np.random.randint(0, 255, (100, 4))
-        color[-1] = 255
-
-        prev_frame = cv2.imread(self.primary_region_path + f'/{prev_idx:04d}.jpg')
-        curr_frame = cv2.imread(self.primary_region_path + f'/{curr_idx:04d}.jpg')
+        curr_frame = cv2.imread(self.detection_frame_path(curr_idx))
 
         """Centroid-based motion line"""
 
         # Connect centroids of the same object label
-        # prev_centroids = [(get_centroid(binary_mask.mask), label)
-        #                   for binary_mask, label, box in self.masks[prev_idx]]
-        curr_centroids = [(get_centroid(binary_mask.mask), label)
-                          for binary_mask, label, box in self.masks[curr_idx]]
-
-        # motion_lines = []
-        if prev_idx == 0:
-            self.motion_line_dict[prev_idx] = {}
-            obj_motion_lines = {}
-        else:
-            obj_motion_lines = self.motion_line_dict[prev_idx].copy()
-
-        for curr_v, label in curr_centroids:
-            # motion_lines.append(curr_v)
-            if label not in obj_motion_lines.keys():
-                obj_motion_lines[label] = []
-            # obj_motion_lines[label].append((curr_v, curr_frame[curr_v[0]][curr_v[1]]))
-            obj_motion_lines[label].append(curr_v)
+        for _, label, box in self.masks[curr_idx]:
+            centroid = self.mask_store.centroid(curr_idx, label)
+            if centroid is None:
+                continue
+            curr_v = (int(centroid[0]), int(centroid[1]))
+            self.trajectories.append(label, curr_idx, curr_v, box)
 
-            
             # If line color is not predefined, get the centroid color
             if label not in self.motion_line_color.keys():
                 centroid_color = curr_frame[curr_v[0]][curr_v[1]]
-                self.motion_line_color[label] = centroid_color 
-            
-
-            if label not in self.all_motion_lines.keys():
-                self.all_motion_lines[label] = []
-            self.all_motion_lines[label].append(curr_v)
-
-            # if len(obj_motion_lines[label]) > MOTION_LINE_WINDOW:
-            #     obj_motion_lines[label].pop(0)
-        self.motion_line_dict[curr_idx] = copy.deepcopy(obj_motion_lines)
-
-        print(f"motion line dict at {curr_idx}: {self.motion_line_dict[curr_idx]}")
-        transparent_img = np.zeros((curr_frame.shape[0], curr_frame.shape[1], 4), dtype=np.uint8)
-        motion_line_img = np.zeros_like(transparent_img)
-
-        for k, v in self.all_motion_lines.items():
-            prev_centroid = None
-            for centroid in v:
-                curr_frame = cv2.circle(curr_frame, centroid, LINE_THICKNESS, lightgray, -1)
-                if prev_centroid is not None:
-                    curr_frame = cv2.line(curr_frame, prev_centroid, centroid, lightgray, LINE_THICKNESS)
-                prev_centroid = centroid
-
-        for label, v in obj_motion_lines.items():
-            prev_centroid = None
-            for centroid in v:
-                linecolor = self.motion_line_color[label]
-                linecolor = (int(linecolor[0]), int(linecolor[1]), int(linecolor[2]), 255)
-                motion_line_img = cv2.circle(motion_line_img, centroid, LINE_THICKNESS, linecolor, -1)
-                if prev_centroid is not None:
-                    # cent_distance = math.sqrt((prev_centroid[0] - centroid[0])**2 + (prev_centroid[1] - centroid[1])**2)
-                    # if cent_distance > 20:
-                    motion_line_img = cv2.line(motion_line_img, prev_centroid, centroid, linecolor, LINE_THICKNESS)
-
-                prev_centroid = centroid
-
-
+                self.motion_line_color[label] = centroid_color
 
     def save_motion_history(self, prev_idx, curr_idx):
-        prev_frame = cv2.imread(self.primary_region_path + f'/{prev_idx:04d}.jpg')
-        curr_frame = cv2.imread(self.primary_region_path + f'/{curr_idx:04d}.jpg')
+        prev_frame = cv2.imread(self.detection_frame_path(prev_idx))
+        curr_frame = cv2.imread(self.detection_frame_path(curr_idx))
 
         h, w, _ = prev_frame.shape
 
-        curr_mask = np.full((h, w), 0, dtype=np.uint8)
-        mask_per_obj = {}
+        # Frames of the motion history window, the current frame stands in for those before the first
+        window = [frame if frame >= 0 else curr_idx for frame in range(curr_idx - MOTION_HISTORY_WINDOW, curr_idx)]
+        # All objects over the window, united on the encoded runs
+        curr_mask = self.mask_store.union(window)
         alpha_mask_per_obj = {}
         frame_masks = None
-        # no_window_mask_per_obj = {}
-        for i in range(MOTION_HISTORY_WINDOW):
-            if curr_idx - (MOTION_HISTORY_WINDOW - i) < 0:
-                frame_masks = self.masks[curr_idx]
-            else:
-                frame_masks = self.masks[curr_idx - (MOTION_HISTORY_WINDOW - i)]
+        for frame in window:
+            frame_masks = self.masks[frame]
             for mask, label, box in frame_masks:
-                if label not in mask_per_obj.keys():
-                    mask_per_obj[label] = np.full((h, w), 0, dtype=np.uint8)
+                if label not in alpha_mask_per_obj.keys():
                     alpha_mask_per_obj[label] = np.zeros((h, w, 4), dtype=np.uint8)
-                    # no_window_mask_per_obj[label] = np.full((h, w), 0, dtype=np.uint8)
-                curr_mask = cv2.add(curr_mask, mask.mask)
-
-                mask_per_obj[label] = cv2.add(mask_per_obj[label], mask.mask)
 
-                alpha_channel = mask.mask.copy() * 255
-                alpha_mask = mask.mask.copy() * 255
+                binary_mask = mask.mask
+                alpha_channel = binary_mask * 255
+                alpha_mask = binary_mask * 255
                 alpha_mask[alpha_mask == 255] = 0
                 alpha_mask = np.broadcast_to(alpha_mask[..., np.newaxis],
                                              (h, w, 4))
@@ -709,7 +884,6 @@ class OnlineDetector:
 
         curr_frame_masks = self.masks[curr_idx]
 
-        prev_masked = cv2.bitwise_and(prev_frame, prev_frame, mask=curr_mask)
         curr_masked = cv2.bitwise_and(curr_frame, curr_frame, mask=curr_mask)
         for mask, label, box in frame_masks:
             if label not in self.motion_gray_replay_dict.keys():
@@ -728,9 +902,6 @@ class OnlineDetector:
                                                             (int(box[1]), int(box[0])))
                 self.motion_gray_replay_dict[label][curr_idx] = alpha_mask_per_obj[label]
 
-        cv2.imwrite(self.obj_mask_output + f'/{prev_idx:04d}.jpg', prev_masked)
-        cv2.imwrite(self.obj_mask_output + f'/{curr_idx:04d}.jpg', curr_masked)
-
         # Motion history processing
 
         # Pixel-level difference within mask
@@ -820,18 +991,30 @@ class OnlineDetector:
         # Create a transparent image to draw motion lines, histories, and replays on
         transparent_img = np.zeros((image.shape[0], image.shape[1], 4), dtype=np.uint8)
 
+        bundle = native_or_fallback(lambda: ReplayBundleWriter(self.replay_bundle_path), None,
+                                    'Replay bundle unavailable, writing visualization files only')
+
+        # Motion line of each object as [layer, points drawn]. Lines only grow, so each frame draws just the new segments
+        line_layers = {}
+
+        # Layers are added at full weight and sums are scaled afterwards, with the rounding of the cv2.addWeighted
+        # calls they replace
+        def added(track_layers):
+            return [(layer, 1.0, BLEND_ADD) for layer in track_layers]
+
+        def scaled(scale):
+            return [(-1, scale, BLEND_SCALE)]
+
         # Re-position and re-scale motion history
         for frame_idx in range(self.obj_rec_count):
             print(f"frame idx: {frame_idx}")
-            frame_mask = transparent_img.copy()
-            replay_mask = transparent_img.copy()
-            gray_replay_mask = transparent_img.copy()
-            motion_line_mask = transparent_img.copy()
+            motion_line_layers = []
+            # Layers are placed where they belong in the frame and composited into all outputs in one pass
+            layers = []
+            history_layers, gray_layers, replay_layers = [], [], []
+            object_layers = []  # (label, line, gray replay, replay) of each object with a complete visualization
 
             for mask, label, box in curr_obj_pos:
-                # Save visualizations for each object
-                per_obj_mask = transparent_img.copy()
-
                 Vx1, Vy1, Vx2, Vy2 = int(box[0]), int(box[1]), int(box[2]), int(box[3])
                 if label not in self.motion_history_dict.keys():
                     continue
@@ -860,61 +1043,47 @@ class OnlineDetector:
 
                 # Clip the mask if the mask overflows out of the mask frame,
                 print("Resized Motion History Shape: ", resized.shape)
-                print("frame mask shape: ", frame_mask.shape)
-                if mask_position[1] + resized.shape[1] > frame_mask.shape[1]:
-                    print(f"width clipped: {new_width}->{frame_mask.shape[1] - mask_position[1]}")
-                    new_width = frame_mask.shape[1] - mask_position[1]
-                if mask_position[0] + resized.shape[0] > frame_mask.shape[0]:
-                    print(f"height clipped: {new_height}->{frame_mask.shape[0] - mask_position[0]}")
-                    new_height = frame_mask.shape[0] - mask_position[0]
-
-                layer = transparent_img.copy()
+                print("frame mask shape: ", transparent_img.shape)
+                if mask_position[1] + resized.shape[1] > transparent_img.shape[1]:
+                    print(f"width clipped: {new_width}->{transparent_img.shape[1] - mask_position[1]}")
+                    new_width = transparent_img.shape[1] - mask_position[1]
+                if mask_position[0] + resized.shape[0] > transparent_img.shape[0]:
+                    print(f"height clipped: {new_height}->{transparent_img.shape[0] - mask_position[0]}")
+                    new_height = transparent_img.shape[0] - mask_position[0]
+
                 y_diff, x_diff = 0, 0
                 if mask_position[0] < 0:
                     y_diff = -mask_position[0]
                 if mask_position[1] < 0:
                     x_diff = -mask_position[1]
 
-                layer[mask_position[0]+y_diff:mask_position[0]+new_height,
-                      mask_position[1]+x_diff:mask_position[1]+new_width] \
-                    = resized[y_diff:new_height, x_diff:new_width]
-                frame_mask = cv2.addWeighted(frame_mask, 1, layer, 1, 0)
+                history_layers.append(len(layers))
+                layers.append((resized[y_diff:new_height, x_diff:new_width],
+                               (mask_position[0] + y_diff, mask_position[1] + x_diff), NO_TINT))
 
                 # Motion Line
                 line_idx = max(frame_idx - 2, 1)
-                if label not in self.motion_line_dict[line_idx].keys():
-                    if frame_idx == 0:
-                        continue
-                    if label in self.motion_line_dict[line_idx - 1].keys():
-                        self.motion_line_dict[line_idx][label] = self.motion_line_dict[line_idx - 1][label]
-                    else:
-                        continue
-                centroids = np.array(self.motion_line_dict[line_idx][label]).copy()
+                centroids = np.array(self.trajectories.polyline(label, 0, line_idx))
+                if len(centroids) == 0:
+                    continue
                 new_centroids = (centroids - (self.mh_prev_x[label], self.mh_prev_y[label])) * \
                                 (x_scale_ratio, y_scale_ratio) + (Vx1, Vy1)
 
-                prev_centroid = None
-                for i, centroid in enumerate(new_centroids):
-                    linecolor = self.motion_line_color[label]
-                    linecolor = (int(linecolor[0]), int(linecolor[1]), int(linecolor[2]), 255)
-                    centroid = (int(centroid[0]), int(centroid[1]))
-                    if i == len(new_centroids) - 1:
-                        start_point = np.array(centroid) - LINE_THICKNESS * 2
-                        end_point = np.array(centroid) + LINE_THICKNESS * 2
-                        motion_line_mask = cv2.rectangle(motion_line_mask, start_point, end_point, linecolor,
-                                                         LINE_THICKNESS * 2)
-                        per_obj_mask = cv2.rectangle(per_obj_mask, start_point, end_point, linecolor,
-                                                         LINE_THICKNESS * 2)
-                    else:
-                        motion_line_mask = cv2.circle(motion_line_mask, centroid, LINE_THICKNESS, linecolor, -1)
-                        per_obj_mask = cv2.circle(per_obj_mask, centroid, LINE_THICKNESS, linecolor, -1)
-                    if prev_centroid is not None:
-                        motion_line_mask = cv2.line(motion_line_mask, prev_centroid, centroid, linecolor,
-                                                    LINE_THICKNESS)
-                        per_obj_mask = cv2.line(per_obj_mask, prev_centroid, centroid, linecolor,
-                                                    LINE_THICKNESS)
-                    prev_centroid = centroid
-
+                linecolor = self.motion_line_color[label]
+                linecolor = (int(linecolor[0]), int(linecolor[1]), int(linecolor[2]), 255)
+                if label not in line_layers:
+                    line_layers[label] = [self.create_line_layer(transparent_img.shape), 0]
+                line, drawn = line_layers[label]
+                for centroid in new_centroids[drawn:]:
+                    line.append((int(centroid[0]), int(centroid[1])), linecolor)
+                line_layers[label][1] = len(new_centroids)
+
+                # Line and the square marking its newest point
+                line_layer = len(layers)
+                layers.append((line.image, (0, 0), NO_TINT))
+                marker_layer = len(layers)
+                layers.append(self.line_marker(new_centroids[-1], linecolor))
+                motion_line_layers += [line_layer, marker_layer]
 
                 # Adjust Motion History
                 if frame_idx in self.motion_gray_replay_dict[label].keys():
@@ -927,12 +1096,10 @@ class OnlineDetector:
                     self.motion_gray_replay_dict[label][frame_idx] = self.motion_gray_replay_dict[label][
                         frame_idx - 1]
                 gray_resized = cv2.resize(gray_replay, (new_width, new_height))
-                layer = transparent_img.copy()
-                layer[mask_position[0] + y_diff:mask_position[0] + new_height,
-                mask_position[1] + x_diff:mask_position[1] + new_width] \
-                    = gray_resized[y_diff:new_height, x_diff:new_width]
-                gray_replay_mask = cv2.addWeighted(gray_replay_mask, 1, layer, 1, 0)
-                per_obj_mask = cv2.addWeighted(per_obj_mask, 1.0, layer, 0.8, 0)
+                gray_layer = len(layers)
+                gray_layers.append(gray_layer)
+                layers.append((gray_resized[y_diff:new_height, x_diff:new_width],
+                               (mask_position[0] + y_diff, mask_position[1] + x_diff), NO_TINT))
                 print(f"gray replay mask position[1], mask position[0]: {mask_position[1]}, {mask_position[0]}")
                 print(f"gray replay new height, new width: {new_height}, {new_width}")
 
@@ -951,14 +1118,13 @@ class OnlineDetector:
 
                 replay_mask_position = int(Vy1 - (self.mh_prev_y[label] - Pm_y) * y_scale_ratio), \
                                        int(Vx1 - (self.mh_prev_x[label] - Pm_x) * x_scale_ratio)
-                if replay_mask_position[1] + resized.shape[1] > frame_mask.shape[1]:
-                    print(f"replay width clipped: {new_width}->{frame_mask.shape[1] - replay_mask_position[1]}")
-                    new_width = frame_mask.shape[1] - replay_mask_position[1]
-                if replay_mask_position[0] + resized.shape[0] > frame_mask.shape[0]:
-                    print(f"replay height clipped: {new_height}->{frame_mask.shape[0] - replay_mask_position[0]}")
-                    new_height = frame_mask.shape[0] - replay_mask_position[0]
-
-                layer = transparent_img.copy()
+                if replay_mask_position[1] + resized.shape[1] > transparent_img.shape[1]:
+                    print(f"replay width clipped: {new_width}->{transparent_img.shape[1] - replay_mask_position[1]}")
+                    new_width = transparent_img.shape[1] - replay_mask_position[1]
+                if replay_mask_position[0] + resized.shape[0] > transparent_img.shape[0]:
+                    print(f"replay height clipped: {new_height}->{transparent_img.shape[0] - replay_mask_position[0]}")
+                    new_height = transparent_img.shape[0] - replay_mask_position[0]
+
                 print("replay mask position [1], replay mask position [0]: ", replay_mask_position[1], replay_mask_position[0])
                 print("replay x_diff, y_diff: ", x_diff, y_diff)
                 print("new width, new_height: ", new_width, new_height)
@@ -969,32 +1135,67 @@ class OnlineDetector:
                 if replay_mask_position[1] < 0:
                     x_diff = -replay_mask_position[1]
 
-                layer[replay_mask_position[0] + y_diff:replay_mask_position[0] + new_height,
-                      replay_mask_position[1] + x_diff:replay_mask_position[1] + new_width] \
-                    = resized[y_diff:new_height, x_diff:new_width]
-                replay_mask = cv2.addWeighted(replay_mask, 1, layer, 1, 0)
+                replay_layer = len(layers)
+                replay_layers.append(replay_layer)
+                layers.append((resized[y_diff:new_height, x_diff:new_width],
+                               (replay_mask_position[0] + y_diff, replay_mask_position[1] + x_diff), NO_TINT))
+                object_layers.append((label, line_layer, marker_layer, gray_layer, replay_layer))
 
-                per_obj_mask = cv2.add(per_obj_mask, layer)
-
-                # Save the combined visualization per object
+                # Folder of the combined visualization per object
                 if not os.path.exists(self.visualization_output + f'_{label}'):
                     os.mkdir(self.visualization_output + f'_{label}')
-                cv2.imwrite(self.visualization_output + f'_{label}/{frame_idx:04d}.png', per_obj_mask)
-
-            # Save adjusted visualizations
-            cv2.imwrite(self.motion_history_output + f'/{frame_idx:04d}.png', frame_mask)
-            frame_weighted = cv2.addWeighted(transparent_img, 0, replay_mask, 1, 0)
-            cv2.imwrite(self.replay_output + f'/{frame_idx:04d}.png', frame_weighted)
-            frame_weighted = cv2.addWeighted(transparent_img, 0, gray_replay_mask, 0.5, 0)
-            cv2.imwrite(self.gray_replay_output + f'/{frame_idx:04d}.png', frame_weighted)
-            cv2.imwrite(self.motion_line_output + f'/{frame_idx:04d}.png', motion_line_mask)
 
 
-            # Combine everything
-            frame_weighted = cv2.addWeighted(transparent_img, 0, gray_replay_mask, 0.8, 0)
-            frame_weighted = cv2.addWeighted(frame_weighted, 1.0, motion_line_mask, 1.0, 0)
-            frame_combined = cv2.add(frame_weighted, replay_mask)
-            cv2.imwrite(self.visualization_output + f'/{frame_idx:04d}.png', frame_combined)
+            # Output tracks as (layer, opacity, blend) applied in order
+            outputs = {
+                'motion_history': added(history_layers),
+                'replay': added(replay_layers),
+                'gray_replay': added(gray_layers) + scaled(0.5),
+                'motion_line': added(motion_line_layers),
+                # Combine everything
+                'visualization': added(gray_layers) + scaled(0.8) + added(motion_line_layers) + added(replay_layers),
+            }
+            for label, line_layer, marker_layer, gray_layer, replay_layer in object_layers:
+                outputs[f'visualization_{label}'] = added([gray_layer]) + scaled(0.8) + added([line_layer, marker_layer, replay_layer])
+
+            uses = [(output, layer, opacity, blend) for output, track_uses in enumerate(outputs.values())
+                    for layer, opacity, blend in track_uses]
+            images = self.compositor.composite(transparent_img.shape, layers, uses, len(outputs))
+            for track, image in zip(outputs, images):
+                self.save_visualization(bundle, track, frame_idx, image)
+
+        if bundle is not None:
+            bundle.close()
+        for line, _ in line_layers.values():
+            line.close()
+
+    @staticmethod
+    def create_line_layer(shape):
+        """Motion line layer of LINE_THICKNESS, anti-aliased natively or drawn with OpenCV without the library."""
+        return native_or_fallback(lambda: PolylineLayer(shape, LINE_THICKNESS), lambda: ReferencePolylineLayer(shape, LINE_THICKNESS),
+                                  'Polyline layer unavailable, drawing motion lines with OpenCV')
+
+    @staticmethod
+    def line_marker(centroid, color):
+        """Layer of the square around the newest motion line point, as cv2.rectangle draws it in the full frame."""
+        half = thickness = LINE_THICKNESS * 2
+        pad = thickness // 2 + 1
+        patch = np.zeros((2 * (half + pad) + 1, 2 * (half + pad) + 1, 4), np.uint8)
+        cv2.rectangle(patch, (pad, pad), (pad + 2 * half, pad + 2 * half), color, thickness)
+        return patch, (int(centroid[1]) - half - pad, int(centroid[0]) - half - pad), NO_TINT
+
+    def save_visualization(self, bundle, track, frame_idx, image):
+        """Writes visualization frame to its folder and, if open, to the replay bundle track of the same name.
+
+        Transparent BGRA overlays go to the bundle as sparse tiled overlays, which Unity uploads tile by tile.
+        """
+        cv2.imwrite(f'{self.output_path}/{track}/{frame_idx:04d}.png', image)
+        if bundle is None:
+            return
+        if image.ndim == 3 and image.shape[2] == 4:
+            bundle.write_overlay(track, frame_idx, image)
+        else:
+            bundle.write_image(track, frame_idx, image)
 
     def mark_primary_region(self):
         # Extract the primary region from 360-degree frame
@@ -1018,6 +1219,8 @@ class OnlineDetector:
 
             self.primary_offset = (theta, phi)
             self.primary_marked = True
+            # Next tracked frame becomes the stabilization reference
+            self.primary_view = None
         else:
             print("NO MARKER FOUND")
 
@@ -1029,13 +1232,87 @@ class OnlineDetector:
 
     def start_replay(self):
         self.primary_done = True
+        # Objects that changed in the primary region, those the user was looking away from first
+        if self.change_index is not None and self.change_index.event_count() > 0:
+            return self.rank_by_gaze(self.change_index.changed_objects())
         return self.obj_set
 
+    def rank_by_gaze(self, labels):
+        """Orders changed objects by angle between gaze and the primary view at their first change, largest first.
+
+        Keeps labels in order of first change without the gaze log of the recorder or without sensor timestamps, i.e.
+        for video input.
+        """
+        if not self.frame_views:
+            return labels
+        gaze_history = native_or_fallback(GazeHistory, None, 'Gaze history unavailable, replaying changes in order')
+        if gaze_history is None:
+            return labels
+        if not os.path.exists(GAZE_LOG) or gaze_history.load_log(GAZE_LOG) == 0:
+            print('No gaze log, replaying changes in order')
+            return labels
+
+        changes = []
+        for label in labels:
+            # Frames without a view have time 0, which has no gaze, so the change counts as unseen
+            sensor_time, (theta, phi) = self.frame_views.get(int(self.change_index.span(label)[0]), (0, (0.0, 0.0)))
+            changes.append((view_direction(theta, phi), sensor_time, label))
+        return [label for _, _, label in gaze_history.rank_by_inattention(changes)]
+
+    def stabilize_affine(self, primary_region):
+        """Stabilizes the primary region with chained 2D affine transforms. Returns None for the first frame."""
+        if self.frame_count <= 1:
+            self.prev_gray = cv2.cvtColor(primary_region, cv2.COLOR_BGR2GRAY)
+            cv2.imwrite(self.primary_region_path + f'/{self.frame_count - 1:04d}.jpg', primary_region)
+            return None
+
+        p_height, p_width = self.view_size
+
+        # Detect feature points in previous frame
+        prev_pts = cv2.goodFeaturesToTrack(self.prev_gray,
+                                           maxCorners=200,
+                                           qualityLevel=0.01,
+                                           minDistance=30,
+                                           blockSize=3)
+
+        # Convert current frame to grayscale
+        curr_gray = cv2.cvtColor(primary_region, cv2.COLOR_BGR2GRAY)
+
+        # Calculate optical flow (i.e. track feature points)
+        curr_pts, status, err = cv2.calcOpticalFlowPyrLK(self.prev_gray, curr_gray, prev_pts, None)
+
+        # Set curr_gray to prev_gray
+        self.prev_gray = curr_gray
+
+        # Sanity check
+        assert prev_pts.shape == curr_pts.shape
+
+        # Filter only valid points
+        idx = np.where(status==1)[0]
+        prev_pts = prev_pts[idx]
+        curr_pts = curr_pts[idx]
+
+        # Find transformation matrix
+        transform, _ = cv2.estimateAffine2D(prev_pts, curr_pts)
+
+        if transform is not None:
+            transform = np.append(transform, [[0, 0, 1]], axis=0)
+        if transform is None:
+            transform = self.last_transform
+
+        transform = transform.dot(self.last_transform)
+        self.last_transform = transform
+        inverse_transform = cv2.invertAffineTransform(transform[:2])
+        return cv2.warpAffine(primary_region, inverse_transform, (p_width, p_height))
+
     def run(self):
         print("Online detector run")
         if self.video_input == "":
             # webcam input
             cap = VideoStream(0)
+        elif self.video_input == EQUIRECT_SOURCE:
+            # Headset environment cubemap, converted to equirect by the recorder
+            cap = EquirectSnapshotStream()
         else:
             # File Input
             cap = VideoStream(self.video_input)
@@ -1053,12 +1330,16 @@ class OnlineDetector:
         self.center_view = (self.frame_h // RESIZE_H, self.frame_w // RESIZE_W)  # y, x
 
         self.replay_region = np.zeros(self.view_size)
+        self.change_index = native_or_fallback(lambda: ChangeIndex(p_width, p_height), None, 'Change index unavailable')
+        self.mask_store = native_or_fallback(lambda: MaskStore(p_width, p_height), lambda: ReferenceMaskStore(p_width, p_height),
+                                             'Mask store unavailable, keeping full frame masks')
+        self.create_detic_batches()
 
         self.frame_count = 0
-        prev_gray = None
+        self.prev_gray = None
         primary_region = None
 
-        last_transform = np.identity(3)
+        self.last_transform = np.identity(3)
 
         self.process_detic_async()
         while True:
@@ -1081,7 +1362,8 @@ class OnlineDetector:
                     self.mark_primary_region()
                 # Extract the primary region from 360-degree frame
                 equ = E2P.Equirectangular(frame)
-                marker_position = self.marker.get_position(frame)
+                marker_corners = self.marker.get_corners(frame)
+                marker_position = self.marker.get_position(frame, marker_corners)
                 if marker_position is not None:
                     marker_x, marker_y = marker_position
                     # Find the position of the marker in spherical coordinates
@@ -1093,92 +1375,88 @@ class OnlineDetector:
                         theta = self.primary_offset[0]
                         phi = self.primary_offset[1]
 
-                        primary_region = equ.GetPerspective(FOV, marker_theta + theta,
-                                                            marker_phi + phi, p_height, p_width)
-
-
-                        # Motion stabilization
-                        
-                        if self.frame_count <= 1:
-                            prev_gray = cv2.cvtColor(primary_region, cv2.COLOR_BGR2GRAY)
-                            cv2.imwrite(self.primary_region_path + f'/{self.frame_count - 1:04d}.jpg', primary_region)
-                            continue
-    
-                        # # Pre-define transformation-store array
-                        # transforms = np.zeros((n_frames-1, 3), np.float32)
-    
-                        # Detect feature points in previous frame
-                        prev_pts = cv2.goodFeaturesToTrack(prev_gray,
-                                                           maxCorners=200,
-                                                           qualityLevel=0.01,
-                                                           minDistance=30,
-                                                           blockSize=3)
-    
-                        # Convert current frame to grayscale
-                        curr_gray = cv2.cvtColor(primary_region, cv2.COLOR_BGR2GRAY)
-    
-                        # Calculate optical flow (i.e. track feature points)
-                        curr_pts, status, err = cv2.calcOpticalFlowPyrLK(prev_gray, curr_gray, prev_pts, None)
-
-                        # Set curr_gray to prev_gray
-                        prev_gray = curr_gray
-    
-                        # Sanity check
-                        assert prev_pts.shape == curr_pts.shape
-    
-                        # Filter only valid points
-                        idx = np.where(status==1)[0]
-                        prev_pts = prev_pts[idx]
-                        curr_pts = curr_pts[idx]
-    
-                        # Find transformation matrix
-                        transform, _ = cv2.estimateAffine2D(prev_pts, curr_pts)
-
-                        if transform is not None:
-                            transform = np.append(transform, [[0, 0, 1]], axis=0)
-                        if transform is None:
-                            transform = last_transform
-
-                        transform = transform.dot(last_transform)
-                        last_transform = transform
-                        inverse_transform = cv2.invertAffineTransform(transform[:2])
-                        primary_region = cv2.warpAffine(primary_region, inverse_transform, (p_width, p_height))
-                        
-                        ### END STABILIZATION ###
+                        if self.stabilizer is not None:
+                            # Motion stabilization against the view of the first tracked frame, folded into the
+                            # perspective remap
+                            is_reference = self.primary_view is None
+                            if is_reference:
+                                self.stabilizer.reset()
+                                self.primary_view = (marker_theta + theta, marker_phi + phi)
+                                self.reference_corners = marker_corners
+                            else:
+                                # The static marker bounds drift of the visual estimate
+                                self.stabilizer.set_marker_prior(self.reference_corners, marker_corners, frame.shape)
+                            self.stabilizer.update(frame)
+                            primary_region = self.stabilizer.perspective(frame, FOV, self.primary_view[0], self.primary_view[1],
+                                                                         p_height, p_width)
+                            if is_reference:
+                                cv2.imwrite(self.primary_region_path + f'/{self.frame_count - 1:04d}.jpg', primary_region)
+                                continue
+                        else:
+                            primary_region = self.stabilize_affine(equ.GetPerspective(FOV, marker_theta + theta,
+                                                                                      marker_phi + phi, p_height, p_width))
+                            if primary_region is None:
+                                continue
 
                         # Save primary region
-                        self.primary_history.append(primary_region)
+                        self.primary_history.append(self.frame_store.put(primary_region) if self.frame_store is not None
+                                                    else primary_region)
                         cv2.imwrite(self.primary_region_path + f'/{self.frame_count - 1:04d}.jpg', primary_region)
 
-                        # Append primary region image to object recognition queue
-                        self.images_or.append(primary_region)
+                        # Queue primary region for object recognition
+                        if getattr(cap, 'trace', None) is not None:
+                            view = self.primary_view if self.stabilizer is not None else (marker_theta + theta,
+                                                                                          marker_phi + phi)
+                            self.frame_views[self.frame_count - 1] = (cap.trace.sensor_timestamp, view)
+                        self.push_detection(self.frame_count - 1, primary_region)
                 else:
                     print("@@@@@@@ MARKER NOT FOUND @@@@@@@")
                     self.frame_count -= 1
 
-            # Call Detic for self.or_pool_size(=1) frame at a time
-            if len(self.images_or) > 1:
-                self.or_calc_count += 1
-            elif cap.frame is None:
+            # Input ended, stop once Detic caught up with the queued frames
+            if cap.frame is None and self.detection_backlog() == 0:
                 break
 
-            if not self.is_calc_saliency and primary_region is not None:
-                self.images_sal.append(primary_region)
-                if len(self.images_sal) == self.len_temporal:
-                    print("Run saliency model")
+            if primary_region is not None:
+                # The clip buffer slides by every frame, saliency runs on the latest window whenever the model is free
+                if self.clip_buffer is not None:
+                    self.clip_buffer.push(primary_region)
+                elif not self.is_calc_saliency:
+                    self.images_sal.append(primary_region)
+                if not self.is_calc_saliency and (self.clip_buffer is not None or len(self.images_sal) == self.len_temporal):
                     self.process_sal_async()
 
             if cv2.waitKey(1) & 0xFF == ord('q'):
                 break
 
         while self.varjo_image is None:
-            self.varjo_image = cv2.imread("../../VarjoCameraRecorder/VarjoCameraRecorder/bin/frames/left.bmp")
-        self.images_or.append(self.varjo_image)
-        self.is_varjo_frame = True
-        time.sleep(3)
+            self.varjo_image = read_snapshot("../../VarjoCameraRecorder/VarjoCameraRecorder/bin/frames/left")
+        # The Varjo snapshot job never expires. It resolves with the trace of the snapshot once detection is done.
+        varjo_detection = Future()
+        self.push_detection(None, (self.varjo_image, varjo_detection), deadline=0.0)
+        frame_trace = varjo_detection.result()
         self.apply_visualization()
+        if frame_trace is not None:
+            frame_trace.stamp(VISUALIZATION)
+            frame_trace.write(self.overlay_trace)
 
         print("APPLY VISUALIZATION DONE")
+        if self.mask_store.save(self.obj_mask_output):
+            print(f"Object masks: {self.mask_store.count()} masks, {self.mask_store.byte_size() >> 10} KB encoded")
+        if self.frame_store is not None:
+            stats = self.frame_store.stats()
+            print(f"Primary history: {stats['frame_count']} frames, {stats['resident_bytes'] >> 20} MB resident, "
+                  f"{stats['spill_bytes'] >> 20} MB spilled")
+        if self.detic_queue is not None:
+            stats = self.detic_queue.stats()
+            print(f"Detection queue: {stats['completed']} completed, {stats['dropped']} dropped, {stats['expired']} stale, "
+                  f"mean wait {stats['mean_wait']:.2f}s")
+        for name, scheduler in (('Detection', self.detic_batches), ('Saliency', self.saliency_batches)):
+            if scheduler is not None:
+                stats = scheduler.stats()
+                print(f"{name} batches: {stats['batches']} batches, mean size {stats['mean_batch_size']:.1f}, "
+                      f"mean latency {stats['mean_latency']:.2f}s")
+                scheduler.stop()
 
         # When everything done, release the capture
         cap.stop()
@@ -0,0 +1,127 @@
+import ctypes
+
+import numpy as np
+
+# Layer formats and blend modes, see OverlayCompositor
+LAYER_RGBA8 = 0
+LAYER_ALPHA8 = 1
+BLEND_ADD = 0
+BLEND_OVER = 1
+BLEND_SCALE = 2
+# Tint leaving layer colors unchanged
+NO_TINT = (1.0, 1.0, 1.0, 1.0)
+
+
+class _Layer(ctypes.Structure):
+    _fields_ = [('data', ctypes.c_void_p), ('width', ctypes.c_int32), ('height', ctypes.c_int32), ('row_stride', ctypes.c_int32),
+                ('format', ctypes.c_int32), ('x', ctypes.c_int32), ('y', ctypes.c_int32), ('tint', ctypes.c_float * 4)]
+
+
+class _LayerUse(ctypes.Structure):
+    _fields_ = [('output', ctypes.c_int32), ('layer', ctypes.c_int32), ('opacity', ctypes.c_float), ('blend', ctypes.c_int32)]
+
+
+class OverlayCompositor:
+    """Composites BGRA layers and grayscale masks into several BGRA outputs in one native multithreaded pass.
+
+    Replaces chains of cv2.addWeighted/cv2.add on full-frame transparent images: layers are placed at their
+    position instead of being pasted into frame sized copies, and tiles without any layer content are skipped.
+    """
+
+    def __init__(self, lib_path='ReplayApi.dll', thread_count=0):
+        self.lib = ctypes.CDLL(lib_path)
+        self.lib.rr_CompositorCreate.restype = ctypes.c_void_p
+        self.lib.rr_CompositorCreate.argtypes = [ctypes.c_int32]
+        self.lib.rr_CompositorDestroy.argtypes = [ctypes.c_void_p]
+        self.lib.rr_Composite.restype = ctypes.c_int32
+        self.lib.rr_Composite.argtypes = [ctypes.c_void_p, ctypes.c_int32, ctypes.c_int32, ctypes.POINTER(_Layer), ctypes.c_int32,
+                                          ctypes.POINTER(_LayerUse), ctypes.c_int32, ctypes.POINTER(ctypes.c_void_p),
+                                          ctypes.POINTER(ctypes.c_int32), ctypes.c_int32]
+        self.handle = self.lib.rr_CompositorCreate(thread_count)
+        if not self.handle:
+            raise RuntimeError('Creating overlay compositor failed')
+
+    def composite(self, shape, layers, uses, output_count):
+        """Returns output_count BGRA images of shape (height, width).
+
+        layers: list of (image, (y, x), tint) where image is HxWx4 uint8 or HxW uint8 mask and tint is a 4-tuple.
+        uses: list of (output, layer, opacity, blend) applied in order per output. BLEND_ADD is cv2.add for opacity 1,
+            BLEND_SCALE multiplies the output so far by opacity like addWeighted(out, opacity, 0, 0, 0) and ignores layer.
+        """
+        height, width = shape[:2]
+        arrays = [np.ascontiguousarray(image) for image, _, _ in layers]
+        c_layers = (_Layer * max(len(layers), 1))()
+        for i, (image, (y, x), tint) in enumerate(layers):
+            array = arrays[i]
+            c_layers[i] = _Layer(array.ctypes.data, array.shape[1], array.shape[0], array.strides[0],
+                                 LAYER_ALPHA8 if array.ndim == 2 else LAYER_RGBA8, x, y, (ctypes.c_float * 4)(*tint))
+
+        c_uses = (_LayerUse * max(len(uses), 1))(*[_LayerUse(o, l, opacity, blend) for o, l, opacity, blend in uses])
+        outputs = [np.empty((height, width, 4), dtype=np.uint8) for _ in range(output_count)]
+        c_outputs = (ctypes.c_void_p * output_count)(*[out.ctypes.data for out in outputs])
+        c_strides = (ctypes.c_int32 * output_count)(*[out.strides[0] for out in outputs])
+
+        if not self.lib.rr_Composite(self.handle, width, height, c_layers, len(layers), c_uses, len(uses), c_outputs, c_strides,
+                                     output_count):
+            raise ValueError('Invalid compositor layers')
+        return outputs
+
+    def close(self):
+        if self.handle:
+            self.lib.rr_CompositorDestroy(self.handle)
+            self.handle = None
+
+    def __del__(self):
+        self.close()
+
+
+class ReferenceCompositor:
+    """Numpy version of OverlayCompositor with the same 8.8 fixed point arithmetic, so both give identical outputs.
+
+    Used by the detector when the native library is missing, and as the reference the native SIMD path is tested
+    against.
+    """
+
+    @staticmethod
+    def _weight(value, max_value):
+        # toFixed() in OverlayCompositor.cpp, in single precision like the native code
+        value = min(max(np.float32(value), np.float32(0)), np.float32(max_value))
+        return int(value * np.float32(256) + np.float32(0.5))
+
+    def composite(self, shape, layers, uses, output_count):
+        height, width = shape[:2]
+        outputs = [np.zeros((height, width, 4), dtype=np.uint8) for _ in range(output_count)]
+        for output, layer, opacity, blend in uses:
+            if blend == BLEND_SCALE:
+                # scaleRow() in OverlayCompositor.cpp, single precision rounded half to even
+                scale = np.float32(min(max(opacity, 0), 255))
+                outputs[output][:] = np.clip(np.rint(outputs[output].astype(np.float32) * scale), 0, 255)
+                continue
+
+            image, (y, x), tint = layers[layer]
+            y0, x0 = max(y, 0), max(x, 0)
+            y1, x1 = min(y + image.shape[0], height), min(x + image.shape[1], width)
+            if y0 >= y1 or x0 >= x1:
+                continue
+
+            src = image[y0 - y:y1 - y, x0 - x:x1 - x].astype(np.uint32)
+            dst = outputs[output][y0:y1, x0:x1]
+            if blend == BLEND_ADD:
+                if src.ndim == 2:
+                    src = np.repeat(src[:, :, None], 4, axis=2)
+                weights = np.array([self._weight(np.float32(t) * np.float32(opacity), 127) for t in tint], np.uint32)
+                dst[:] = np.minimum(dst + ((src * weights) >> 8), 255)
+            else:
+                if src.ndim == 2:
+                    src = np.dstack([np.full(src.shape + (3,), 255, np.uint32), src])
+                weights = np.array([self._weight(np.float32(t) * np.float32(opacity if c == 3 else 1), 1) for c, t in enumerate(tint)],
+                                   np.uint32)
+                color = (src * weights) >> 8
+                alpha = color[:, :, 3:4].copy()
+                color[:, :, 3] = 255
+                t = color * alpha + dst * (255 - alpha) + 128
+                dst[:] = (t + (t >> 8)) >> 8
+        return outputs
+
+    def close(self):
+        pass
@@ -0,0 +1,106 @@
+import ctypes
+import weakref
+
+import cv2
+import numpy as np
+
+
+class PolylineLayer:
+    """Persistent anti-aliased motion line layer. Appending a point rasterizes only the newest segment.
+
+    Replaces redrawing a trajectory with cv2.line/cv2.circle for every frame. The layer is a BGRA image view that
+    can be passed to OverlayCompositor.composite as is. The view owns the native layer: it is destroyed once the
+    layer is closed and no view of image is left.
+    """
+
+    def __init__(self, shape, line_width, lib_path='ReplayApi.dll'):
+        self.lib = ctypes.CDLL(lib_path)
+        self.lib.rr_PolylineCreate.restype = ctypes.c_void_p
+        self.lib.rr_PolylineCreate.argtypes = [ctypes.c_int32, ctypes.c_int32, ctypes.c_float]
+        self.lib.rr_PolylineDestroy.argtypes = [ctypes.c_void_p]
+        self.lib.rr_PolylineAppend.argtypes = [ctypes.c_void_p, ctypes.c_float, ctypes.c_float, ctypes.POINTER(ctypes.c_float)]
+        self.lib.rr_PolylineDraw.argtypes = [ctypes.c_void_p, ctypes.c_void_p, ctypes.c_int32]
+        self.lib.rr_PolylineEnd.argtypes = [ctypes.c_void_p]
+        self.lib.rr_PolylineClear.argtypes = [ctypes.c_void_p]
+        self.lib.rr_PolylineGetData.restype = ctypes.c_int32
+        self.lib.rr_PolylineGetData.argtypes = [ctypes.c_void_p, ctypes.POINTER(ctypes.POINTER(ctypes.c_uint8)),
+                                                ctypes.POINTER(ctypes.c_int32)]
+
+        height, width = shape[:2]
+        handle = self.lib.rr_PolylineCreate(width, height, line_width)
+        if not handle:
+            raise RuntimeError('Creating polyline layer failed')
+
+        data = ctypes.POINTER(ctypes.c_uint8)()
+        stride = ctypes.c_int32()
+        self.lib.rr_PolylineGetData(handle, ctypes.byref(data), ctypes.byref(stride))
+        pixels = (ctypes.c_uint8 * (height * stride.value)).from_address(ctypes.addressof(data.contents))
+        weakref.finalize(pixels, self.lib.rr_PolylineDestroy, handle)
+        self.handle = handle
+        self.image = np.frombuffer(pixels, np.uint8).reshape(height, stride.value // 4, 4)[:, :width]
+
+    def append(self, point, color):
+        """Extends the current line to point (x, y). color is a BGRA tuple in 0..255."""
+        c_color = (ctypes.c_float * 4)(*[c / 255.0 for c in color])
+        self.lib.rr_PolylineAppend(self.handle, float(point[0]), float(point[1]), c_color)
+
+    def draw(self, points, colors):
+        """Draws a complete line through Nx2 points with Nx4 BGRA colors in 0..255. Ends the current line."""
+        points = np.asarray(points, dtype=np.float32).reshape(-1, 2)
+        colors = np.asarray(colors, dtype=np.float32).reshape(-1, 4) / 255.0
+        if len(points) != len(colors):
+            raise ValueError(f'Point and color count mismatch: {len(points)} != {len(colors)}')
+        vertices = np.ascontiguousarray(np.hstack([points, colors]), dtype=np.float32)
+        self.lib.rr_PolylineDraw(self.handle, vertices.ctypes.data, len(vertices))
+
+    def end(self):
+        self.lib.rr_PolylineEnd(self.handle)
+
+    def clear(self):
+        self.lib.rr_PolylineClear(self.handle)
+
+    def close(self):
+        # Views of image keep the native layer alive, see __init__
+        self.handle = None
+        self.image = None
+
+    def __del__(self):
+        self.close()
+
+
+class ReferencePolylineLayer:
+    """OpenCV version of PolylineLayer, used by the detector without the library.
+
+    Appending a point draws only the newest segment with cv2.line, without anti-aliasing or per-vertex color
+    interpolation.
+    """
+
+    def __init__(self, shape, line_width):
+        self.image = np.zeros(shape[:2] + (4,), np.uint8)
+        self.thickness = max(int(round(line_width)), 1)
+        self.last = None
+
+    def append(self, point, color):
+        point = (int(point[0]), int(point[1]))
+        color = tuple(int(c) for c in color)
+        if self.last is None:
+            cv2.circle(self.image, point, max(self.thickness // 2, 1), color, -1)
+        else:
+            cv2.line(self.image, self.last, point, color, self.thickness)
+        self.last = point
+
+    def draw(self, points, colors):
+        self.end()
+        for point, color in zip(points, colors):
+            self.append(point, color)
+        self.end()
+
+    def end(self):
+        self.last = None
+
+    def clear(self):
+        self.image[:] = 0
+        self.last = None
+
+    def close(self):
+        self.image = None
@@ -0,0 +1,71 @@
+import ctypes
+
+import cv2
+import numpy as np
+
+# Track types, see ReplayBundle::TrackType
+TRACK_IMAGE = 0
+TRACK_MASK = 1
+TRACK_OVERLAY = 2
+TRACK_DATA = 3
+
+
+class ReplayBundleWriter:
+    """Writes all per-frame replay outputs of a session into one bundle file through the native ReplayApi library."""
+
+    def __init__(self, path, lib_path='ReplayApi.dll'):
+        self.lib = ctypes.CDLL(lib_path)
+        self.lib.rr_BundleWriterCreate.restype = ctypes.c_void_p
+        self.lib.rr_BundleWriterCreate.argtypes = [ctypes.c_char_p]
+        self.lib.rr_BundleWriterAddTrack.restype = ctypes.c_int32
+        self.lib.rr_BundleWriterAddTrack.argtypes = [ctypes.c_void_p, ctypes.c_char_p, ctypes.c_int32]
+        self.lib.rr_BundleWriterWrite.restype = ctypes.c_int32
+        self.lib.rr_BundleWriterWrite.argtypes = [ctypes.c_void_p, ctypes.c_int32, ctypes.c_int64, ctypes.c_char_p, ctypes.c_int64]
+        self.lib.rr_BundleWriterWriteOverlay.restype = ctypes.c_int32
+        self.lib.rr_BundleWriterWriteOverlay.argtypes = [ctypes.c_void_p, ctypes.c_int32, ctypes.c_int64, ctypes.c_char_p,
+                                                         ctypes.c_int32, ctypes.c_int32, ctypes.c_int32]
+        self.lib.rr_BundleWriterClose.restype = ctypes.c_int32
+        self.lib.rr_BundleWriterClose.argtypes = [ctypes.c_void_p]
+
+        self.handle = self.lib.rr_BundleWriterCreate(path.encode('utf-8'))
+        if not self.handle:
+            raise IOError(f'Creating replay bundle failed: {path}')
+        self.tracks = {}
+
+    def track(self, name, track_type=TRACK_IMAGE):
+        if name not in self.tracks:
+            track_id = self.lib.rr_BundleWriterAddTrack(self.handle, name.encode('utf-8'), track_type)
+            if track_id < 0:
+                raise ValueError(f'Invalid replay bundle track: {name}')
+            self.tracks[name] = track_id
+        return self.tracks[name]
+
+    def write(self, name, frame_idx, data, track_type=TRACK_DATA):
+        # Size in bytes, len() of a numpy array is its first dimension
+        view = memoryview(np.ascontiguousarray(data) if isinstance(data, np.ndarray) else data)
+        track_id = self.track(name, track_type)
+        return self.lib.rr_BundleWriterWrite(self.handle, track_id, frame_idx, view.tobytes(), view.nbytes) != 0
+
+    def write_image(self, name, frame_idx, image, ext='.png'):
+        # Replaces cv2.imwrite(f'{name}/{frame_idx:04d}.png', image)
+        ok, encoded = cv2.imencode(ext, image)
+        if not ok:
+            return False
+        return self.write(name, frame_idx, encoded.tobytes(), TRACK_IMAGE)
+
+    def write_overlay(self, name, frame_idx, image):
+        # Stores BGRA overlay as sparse 32x32 tiles, only tiles with non-zero alpha are kept
+        track_id = self.track(name, TRACK_OVERLAY)
+        rgba = np.ascontiguousarray(cv2.cvtColor(image, cv2.COLOR_BGRA2RGBA))
+        height, width = rgba.shape[:2]
+        return self.lib.rr_BundleWriterWriteOverlay(self.handle, track_id, frame_idx, rgba.tobytes(), width, height, rgba.strides[0]) != 0
+
+    def close(self):
+        if self.handle:
+            ok = self.lib.rr_BundleWriterClose(self.handle) != 0
+            self.handle = None
+            return ok
+        return True
+
+    def __del__(self):
+        self.close()
@@ -0,0 +1,125 @@
+import ctypes
+
+import cv2
+import numpy as np
+
+# Max forward-backward tracking error in pixels
+MAX_TRACKING_ERROR = 1.0
+
+
+class SphericalStabilizer:
+    """Rotation-only stabilizer for the equirectangular 360 stream.
+
+    Replaces the chained cv2.estimateAffine2D + warpAffine pass on the primary region. Features tracked on the
+    equirect frame give the camera rotation against the reference orientation, and perspective() folds the correction
+    into the equirect-to-perspective remap, so the primary region is extracted stabilized in one cv2.remap.
+    Features are tracked across frames and detected again only when fewer than min_tracked survive.
+    """
+
+    def __init__(self, inlier_angle=1.0, min_inliers=8, prior_weight=0.05, max_features=400, min_tracked=100,
+                 lib_path='ReplayApi.dll'):
+        self.lib = ctypes.CDLL(lib_path)
+        self.lib.rr_SphericalStabilizerCreate.restype = ctypes.c_void_p
+        self.lib.rr_SphericalStabilizerCreate.argtypes = [ctypes.c_float, ctypes.c_int32, ctypes.c_float]
+        self.lib.rr_SphericalStabilizerDestroy.argtypes = [ctypes.c_void_p]
+        self.lib.rr_SphericalStabilizerReset.argtypes = [ctypes.c_void_p]
+        self.lib.rr_SphericalStabilizerUpdate.restype = ctypes.c_int32
+        self.lib.rr_SphericalStabilizerUpdate.argtypes = [ctypes.c_void_p, ctypes.c_void_p, ctypes.c_void_p, ctypes.c_int32, ctypes.c_int32,
+                                                          ctypes.c_int32]
+        self.lib.rr_SphericalStabilizerSetMarkerPrior.restype = ctypes.c_int32
+        self.lib.rr_SphericalStabilizerSetMarkerPrior.argtypes = [ctypes.c_void_p, ctypes.c_void_p, ctypes.c_void_p, ctypes.c_int32,
+                                                                  ctypes.c_int32, ctypes.c_int32]
+        self.lib.rr_SphericalStabilizerGetRotation.restype = ctypes.c_int32
+        self.lib.rr_SphericalStabilizerGetRotation.argtypes = [ctypes.c_void_p, ctypes.POINTER(ctypes.c_float * 4)]
+        self.lib.rr_SphericalStabilizerBuildRemap.restype = ctypes.c_int32
+        self.lib.rr_SphericalStabilizerBuildRemap.argtypes = [ctypes.c_void_p, ctypes.c_int32, ctypes.c_int32, ctypes.c_float, ctypes.c_float,
+                                                              ctypes.c_float, ctypes.c_int32, ctypes.c_int32, ctypes.c_void_p,
+                                                              ctypes.c_void_p]
+
+        self.handle = self.lib.rr_SphericalStabilizerCreate(inlier_angle, min_inliers, prior_weight)
+        if not self.handle:
+            raise ValueError(f'Invalid stabilizer configuration: inlier_angle={inlier_angle}, min_inliers={min_inliers}')
+        self.max_features = max_features
+        self.min_tracked = min_tracked
+        self.prev_gray = None
+        self.prev_pts = None
+
+    def update_points(self, prev_pts, curr_pts, shape):
+        """Updates rotation from Nx2 equirect pixel correspondences. Returns True if the visual estimate was accepted."""
+        prev_pts = np.ascontiguousarray(prev_pts, dtype=np.float32).reshape(-1, 2)
+        curr_pts = np.ascontiguousarray(curr_pts, dtype=np.float32).reshape(-1, 2)
+        if prev_pts.shape != curr_pts.shape:
+            raise ValueError(f'Correspondence count mismatch: {prev_pts.shape} != {curr_pts.shape}')
+        return bool(self.lib.rr_SphericalStabilizerUpdate(self.handle, prev_pts.ctypes.data, curr_pts.ctypes.data, len(prev_pts), shape[1],
+                                                          shape[0]))
+
+    def set_marker_prior(self, reference_corners, corners, shape):
+        """Sets the prior for the next update from equirect pixel corners of a static marker in the reference frame and
+        the current frame. Returns False if there are fewer than three corners."""
+        reference_corners = np.ascontiguousarray(reference_corners, dtype=np.float32).reshape(-1, 2)
+        corners = np.ascontiguousarray(corners, dtype=np.float32).reshape(-1, 2)
+        if reference_corners.shape != corners.shape:
+            raise ValueError(f'Corner count mismatch: {reference_corners.shape} != {corners.shape}')
+        return bool(self.lib.rr_SphericalStabilizerSetMarkerPrior(self.handle, reference_corners.ctypes.data, corners.ctypes.data,
+                                                                  len(corners), shape[1], shape[0]))
+
+    def update(self, frame):
+        """Tracks features from the previous equirect frame into this one and updates the rotation.
+
+        The first frame after construction or reset() only sets the reference. Returns True if the visual estimate was
+        accepted.
+        """
+        gray = cv2.cvtColor(frame, cv2.COLOR_BGR2GRAY)
+        prev_gray, self.prev_gray = self.prev_gray, gray
+        if prev_gray is None:
+            return True
+
+        # Detection on the full equirect frame is the expensive part, so keep tracking the surviving features
+        prev_pts = self.prev_pts
+        if prev_pts is None or len(prev_pts) < self.min_tracked:
+            prev_pts = cv2.goodFeaturesToTrack(prev_gray, maxCorners=self.max_features, qualityLevel=0.01, minDistance=20, blockSize=3)
+        if prev_pts is None:
+            self.prev_pts = None
+            return self.update_points(np.empty((0, 2), np.float32), np.empty((0, 2), np.float32), gray.shape)
+
+        # Forward-backward check, LK reports lost features as tracked e.g. on textureless frames
+        curr_pts, status, _ = cv2.calcOpticalFlowPyrLK(prev_gray, gray, prev_pts, None)
+        back_pts, back_status, _ = cv2.calcOpticalFlowPyrLK(gray, prev_gray, curr_pts, None)
+        error = np.linalg.norm((back_pts - prev_pts).reshape(-1, 2), axis=1)
+        idx = np.where((status.ravel() == 1) & (back_status.ravel() == 1) & (error < MAX_TRACKING_ERROR))[0]
+        self.prev_pts = curr_pts[idx]
+        return self.update_points(prev_pts[idx], curr_pts[idx], gray.shape)
+
+    def rotation(self):
+        """Returns camera rotation relative to the reference as (w, x, y, z) quaternion and inlier count of the latest update."""
+        out = (ctypes.c_float * 4)()
+        inliers = self.lib.rr_SphericalStabilizerGetRotation(self.handle, ctypes.byref(out))
+        return np.array(out[:], dtype=np.float32), inliers
+
+    def remap(self, shape, fov, theta, phi, height, width):
+        """Returns stabilized (map_x, map_y) for cv2.remap of an equirect frame of given shape, with the view angles of
+        Equirec2Perspec.GetPerspective in degrees."""
+        map_x = np.empty((height, width), np.float32)
+        map_y = np.empty((height, width), np.float32)
+        if not self.lib.rr_SphericalStabilizerBuildRemap(self.handle, shape[1], shape[0], fov, theta, phi, width, height, map_x.ctypes.data,
+                                                         map_y.ctypes.data):
+            raise ValueError(f'Invalid remap: shape={shape}, fov={fov}, size=({width}, {height})')
+        return map_x, map_y
+
+    def perspective(self, frame, fov, theta, phi, height, width):
+        """Extracts the stabilized perspective view, i.e. GetPerspective with the camera rotation removed."""
+        map_x, map_y = self.remap(frame.shape, fov, theta, phi, height, width)
+        return cv2.remap(frame, map_x, map_y, cv2.INTER_CUBIC, borderMode=cv2.BORDER_WRAP)
+
+    def reset(self):
+        self.lib.rr_SphericalStabilizerReset(self.handle)
+        self.prev_gray = None
+        self.prev_pts = None
+
+    def close(self):
+        if self.handle:
+            self.lib.rr_SphericalStabilizerDestroy(self.handle)
+            self.handle = None
+
+    def __del__(self):
+        self.close()
@@ -0,0 +1,97 @@
+import bisect
+import ctypes
+
+
+class TrajectoryStore:
+    """Per-object centroid trajectories of the detected objects, for the motion lines of the replay.
+
+    Samples are kept sorted by time per object, so the motion line up to a frame is a time-range query instead of a
+    copy of every line per frame. Objects are referred to by label; ids are assigned on first use.
+    """
+
+    def __init__(self, lib_path='ReplayApi.dll'):
+        self.lib = ctypes.CDLL(lib_path)
+        self.lib.rr_TrajectoryStoreCreate.restype = ctypes.c_void_p
+        self.lib.rr_TrajectoryStoreCreate.argtypes = []
+        self.lib.rr_TrajectoryStoreDestroy.argtypes = [ctypes.c_void_p]
+        self.lib.rr_TrajectoryStoreAppend.restype = ctypes.c_int32
+        self.lib.rr_TrajectoryStoreAppend.argtypes = [ctypes.c_void_p, ctypes.c_int64, ctypes.c_char_p, ctypes.c_double, ctypes.c_float,
+                                                      ctypes.c_float, ctypes.POINTER(ctypes.c_float), ctypes.c_float]
+        self.lib.rr_TrajectoryStoreQueryPolyline.restype = ctypes.c_int32
+        self.lib.rr_TrajectoryStoreQueryPolyline.argtypes = [ctypes.c_void_p, ctypes.c_int64, ctypes.c_double, ctypes.c_double,
+                                                             ctypes.c_float, ctypes.POINTER(ctypes.c_float), ctypes.c_int32]
+        self.lib.rr_TrajectoryStoreGetSampleCount.restype = ctypes.c_int64
+        self.lib.rr_TrajectoryStoreGetSampleCount.argtypes = [ctypes.c_void_p]
+        self.lib.rr_TrajectoryStoreClear.argtypes = [ctypes.c_void_p]
+
+        self.handle = self.lib.rr_TrajectoryStoreCreate()
+        if not self.handle:
+            raise RuntimeError('Creating trajectory store failed')
+        self.ids = {}
+
+    def object_id(self, label):
+        if label not in self.ids:
+            self.ids[label] = len(self.ids)
+        return self.ids[label]
+
+    def append(self, label, time, centroid, box, confidence=1.0):
+        """Adds object centroid (x, y) and box (x0, y0, x1, y1) in pixels at time."""
+        bbox = (ctypes.c_float * 4)(*(float(v) for v in box))
+        if not self.lib.rr_TrajectoryStoreAppend(self.handle, self.object_id(label), label.encode(), time, centroid[0], centroid[1],
+                                                 bbox, confidence):
+            raise ValueError(f'Invalid trajectory sample: label={label}, time={time}')
+
+    def polyline(self, label, t0, t1, tolerance=0.0):
+        """Returns [(x, y)] centroids of object within [t0, t1] in time order, simplified with pixel tolerance."""
+        if label not in self.ids:
+            return []
+        count = self.lib.rr_TrajectoryStoreQueryPolyline(self.handle, self.ids[label], t0, t1, tolerance, None, 0)
+        if count <= 0:
+            return []
+        points = (ctypes.c_float * (count * 2))()
+        count = min(count, self.lib.rr_TrajectoryStoreQueryPolyline(self.handle, self.ids[label], t0, t1, tolerance, points, count))
+        return [(points[i * 2], points[i * 2 + 1]) for i in range(count)]
+
+    def labels(self):
+        return list(self.ids)
+
+    def sample_count(self):
+        return self.lib.rr_TrajectoryStoreGetSampleCount(self.handle)
+
+    def clear(self):
+        self.lib.rr_TrajectoryStoreClear(self.handle)
+        self.ids = {}
+
+    def close(self):
+        if self.handle:
+            self.lib.rr_TrajectoryStoreDestroy(self.handle)
+            self.handle = None
+
+    def __del__(self):
+        self.close()
+
+
+class ReferenceTrajectoryStore:
+    """Python version of TrajectoryStore without polyline simplification, used by the detector without the library."""
+
+    def __init__(self):
+        self.trajectories = {}
+
+    def append(self, label, time, centroid, box, confidence=1.0):
+        samples = self.trajectories.setdefault(label, [])
+        samples.insert(bisect.bisect_right([t for t, _ in samples], time), (time, (float(centroid[0]), float(centroid[1]))))
+
+    def polyline(self, label, t0, t1, tolerance=0.0):
+        return [centroid for time, centroid in self.trajectories.get(label, []) if t0 <= time <= t1]
+
+    def labels(self):
+        return list(self.trajectories)
+
+    def sample_count(self):
+        return sum(len(samples) for samples in self.trajectories.values())
+
+    def clear(self):
+        self.trajectories = {}
+
+    def close(self):
+        pass
@@ -0,0 +1,95 @@
+import ctypes
+import itertools
+
+# Overflow policies and job outcomes, see WorkQueue
+DROP_OLDEST = 0
+KEEP_EVERY_KTH = 1
+LATEST_ONLY = 2
+BLOCK = 3
+COMPLETED = 0
+DROPPED = 1
+EXPIRED = 2
+CANCELLED = 3
+
+_JobCallback = ctypes.CFUNCTYPE(None, ctypes.c_void_p, ctypes.c_uint64, ctypes.c_int64, ctypes.c_int32, ctypes.c_double, ctypes.c_double)
+
+
+class _WorkQueueStats(ctypes.Structure):
+    _fields_ = [(name, ctypes.c_int64) for name in ('depth', 'max_depth', 'in_flight', 'pushed', 'completed', 'dropped', 'expired',
+                                                    'cancelled')] + \
+               [(name, ctypes.c_double) for name in ('mean_wait', 'max_wait', 'last_wait', 'mean_service')]
+
+
+class WorkQueue:
+    """Bounded native queue for inference jobs, replacing an unbounded list consumed with pop(0).
+
+    When the detector falls behind, jobs are dropped by policy or deadline instead of piling up, so results stay close
+    to real time. on_done(payload, timestamp, outcome, wait, service) is called exactly once per pushed job.
+    """
+
+    def __init__(self, name, capacity=2, policy=DROP_OLDEST, keep_every=1, max_age=0.0, on_done=None, lib_path='ReplayApi.dll'):
+        self.lib = ctypes.CDLL(lib_path)
+        self.lib.rr_WorkQueueCreate.restype = ctypes.c_void_p
+        self.lib.rr_WorkQueueCreate.argtypes = [ctypes.c_char_p, ctypes.c_int32, ctypes.c_int32, ctypes.c_int32, ctypes.c_double,
+                                                _JobCallback, ctypes.c_void_p]
+        self.lib.rr_WorkQueueDestroy.argtypes = [ctypes.c_void_p]
+        self.lib.rr_WorkQueuePush.restype = ctypes.c_int32
+        self.lib.rr_WorkQueuePush.argtypes = [ctypes.c_void_p, ctypes.c_uint64, ctypes.c_int64, ctypes.c_double]
+        self.lib.rr_WorkQueuePop.restype = ctypes.c_int32
+        self.lib.rr_WorkQueuePop.argtypes = [ctypes.c_void_p, ctypes.c_double, ctypes.POINTER(ctypes.c_uint64),
+                                             ctypes.POINTER(ctypes.c_int64), ctypes.POINTER(ctypes.c_double)]
+        self.lib.rr_WorkQueueComplete.argtypes = [ctypes.c_void_p, ctypes.c_uint64, ctypes.c_int32]
+        self.lib.rr_WorkQueueClose.argtypes = [ctypes.c_void_p]
+        self.lib.rr_WorkQueueGetStats.restype = ctypes.c_int32
+        self.lib.rr_WorkQueueGetStats.argtypes = [ctypes.c_void_p, ctypes.POINTER(_WorkQueueStats)]
+
+        self.payloads = {}
+        self.ids = itertools.count(1)
+        self.on_done = on_done
+        # Keep reference so the callback outlives the native queue
+        self.callback = _JobCallback(self._done)
+        self.handle = self.lib.rr_WorkQueueCreate(name.encode('utf-8'), capacity, policy, keep_every, max_age, self.callback, None)
+        if not self.handle:
+            raise ValueError(f'Invalid work queue configuration: {name}')
+
+    def _done(self, _, job_id, timestamp, outcome, wait, service):
+        payload = self.payloads.pop(job_id, None)
+        if self.on_done:
+            self.on_done(payload, timestamp, outcome, wait, service)
+
+    def push(self, payload, timestamp=0, deadline=0.0):
+        """Queues payload, e.g. a frame. Returns False if the job was dropped right away."""
+        job_id = next(self.ids)
+        self.payloads[job_id] = payload
+        return bool(self.lib.rr_WorkQueuePush(self.handle, job_id, timestamp, deadline))
+
+    def pop(self, timeout=-1.0):
+        """Returns (job_id, payload, timestamp, wait) of the oldest live job, or None on timeout or close."""
+        job_id = ctypes.c_uint64()
+        timestamp = ctypes.c_int64()
+        wait = ctypes.c_double()
+        if not self.lib.rr_WorkQueuePop(self.handle, timeout, ctypes.byref(job_id), ctypes.byref(timestamp), ctypes.byref(wait)):
+            return None
+        return job_id.value, self.payloads.get(job_id.value), timestamp.value, wait.value
+
+    def complete(self, job_id, success=True):
+        self.lib.rr_WorkQueueComplete(self.handle, job_id, 1 if success else 0)
+
+    def stats(self):
+        """Returns queue depth, outcome counts and wait times in seconds as dict."""
+        stats = _WorkQueueStats()
+        self.lib.rr_WorkQueueGetStats(self.handle, ctypes.byref(stats))
+        return {name: getattr(stats, name) for name, _ in _WorkQueueStats._fields_}
+
+    def stop(self):
+        """Cancels queued jobs and wakes workers blocked in pop. Call before joining workers and close."""
+        if self.handle:
+            self.lib.rr_WorkQueueClose(self.handle)
+
+    def close(self):
+        if self.handle:
+            self.lib.rr_WorkQueueDestroy(self.handle)
+            self.handle = None
+
+    def __del__(self):
+        self.close()
@@ -1,18 +1,18 @@
-import socket
-
 from turbojpeg import TurboJPEG
 # pip install PyTurboJPEG
 
 import cv2
-import struct
 import numpy as np
 
+import os
 import time
 
 import threading
 from threading import Thread
 
+from inference.latency_trace import LatencyCollector
 from inference.online_detector import OnlineDetector
+from networking.message_connection import CHANNEL_BULK, CHANNEL_CONTROL, MSG_IMAGE, MSG_TEXT, MessageListener
 # from inference_augmentation_controller import Inferencer_Controller
 # from inferencer_model import Inferencer_Model
 
@@ -23,18 +23,20 @@ BUFFER_MODE = ['REPEAT', 'WAIT'][1]
 SYSTEM = 'local'
 
 DEBUG = False
+FRAME_RECEIVE_TIMEOUT = 0.1
+SHUTDOWN_TIMEOUT = 5.0
 
 jpeg = TurboJPEG()
 
 
 class InferenceServer(Thread):
-    def __init__(self, client_socket, address, inferencer, debug=True, num_images=6, result_type=0, enable_external_view=False,
+    def __init__(self, connection, address, inferencer, debug=True, num_images=6, result_type=0, enable_external_view=False,
                  path=""):
         super(InferenceServer, self).__init__()
-        self.socket = client_socket
+        self.connection = connection
         self.address = address
         self.debug = debug
-        print('accepted connection from {}:{}'.format(address[0], address[1]))
+        print('accepted connection on port {}'.format(address[1]))
         #
         # self.model = Inferencer_Model(num_images, inferencer_type)
         # self.model.debug = debug
@@ -52,15 +54,19 @@ class InferenceServer(Thread):
 
     def run_server(self):
         print("run server")
+        # Frames arrive on the bulk channel, so commands are not queued behind them
+        frame_thread = Thread(target=self.receive_frames)
+        frame_thread.start()
         try:
             while self.running:
                 print("wait for request")
-                request = self.recv_one_message()
-                print("received: ", request)
-                if request is None:
+                message = self.connection.receive(CHANNEL_CONTROL)
+                if message is None:
                     self.running = False
                     break
-                continueThread = self.handle_request(request)
+                msg_type, request = message
+                print("received: ", msg_type, len(request))
+                continueThread = self.handle_request(msg_type, request)
 
                 if not continueThread:
                     break
@@ -68,39 +74,29 @@ class InferenceServer(Thread):
             print('thread ended')
         except Exception as e:
             print(e)
-
-    def send_one_message(self, data):
-        length = len(data)
-        self.socket.sendall(struct.pack('i', length))
-        self.socket.sendall(data)
-
-    def recv_one_message(self):
-        length = self.reclength()
-        msg = self.recvall(length)
-        # return msg.decode()
-        return msg
-
-    def recvall(self, count):
-        buf = b''
-        while count:
-            newbuf = self.socket.recv(count)
-            if not newbuf:
-                return None
-            buf += newbuf
-            count -= len(newbuf)
-        return buf
-
-    def reclength(self):
-        newbuf = self.socket.recv(4)
-        length, = struct.unpack('i', newbuf)
-        # print(length)
-        return length
-
-    def handle_request(self, request_msg):
-        try:
-            request_string = request_msg.decode()
-        except Exception as e:
-            request_string = 'unknown'
+        finally:
+            self.running = False
+            frame_thread.join()
+            # Closing drops queued sends, so let the client close first once it has the SHUTDOWN reply
+            deadline = time.monotonic() + SHUTDOWN_TIMEOUT
+            while self.connection.is_open() and time.monotonic() < deadline:
+                time.sleep(FRAME_RECEIVE_TIMEOUT)
+            self.connection.close()
+
+    def receive_frames(self):
+        # Times out to notice shutdown, the connection is closed only after this thread ends
+        while self.running and self.connection.is_open():
+            message = self.connection.receive(CHANNEL_BULK, FRAME_RECEIVE_TIMEOUT)
+            if message is not None:
+                self.handle_request(*message)
+
+    def send_one_message(self, data, msg_type=MSG_TEXT):
+        # Images go on the bulk channel, text replies on the control channel ahead of them
+        self.connection.send(CHANNEL_BULK if msg_type == MSG_IMAGE else CHANNEL_CONTROL, data, msg_type)
+
+    def handle_request(self, msg_type, request_msg):
+        # Frames arrive as image messages, everything else is a command
+        request_string = request_msg.decode(errors='replace') if msg_type == MSG_TEXT else 'unknown'
 
         if request_string == '':
             self.running = False
@@ -115,10 +111,9 @@ class InferenceServer(Thread):
 
         elif request_string == 'SHUTDOWN':
             self.send_one_message(b'SHUTDOWN')
-            self.socket.shutdown(0)
-            self.socket.close()
             print('shutdown')
             self.running = False
+            self.write_latency_report()
 
             return False
 
@@ -168,12 +163,12 @@ class InferenceServer(Thread):
                         self.send_image(self.inferencer.intersection_img_list.pop(0))
                     else:
                         self.inferencer.is_replaying = False
-                        # Send empty byte array when not showing the replay
-                        self.send_one_message(bytearray())
+                        # Send empty image when not showing the replay
+                        self.send_one_message(b'', MSG_IMAGE)
 
                 else:
-                    # Send empty byte array when not showing the replay
-                    self.send_one_message(bytearray())
+                    # Send empty image when not showing the replay
+                    self.send_one_message(b'', MSG_IMAGE)
 
             # # cv2.imshow('frame', combined_maps)
             # # cv2.waitKey(1)
@@ -212,7 +207,7 @@ class InferenceServer(Thread):
 
         else:
             image = request_msg
-            np_arr = np.fromstring(image, np.uint8)
+            np_arr = np.frombuffer(image, np.uint8)
             # img_np = jpeg.decode(np_arr)
             # self.controller.handle_image_received(img_np)
 
@@ -220,12 +215,26 @@ class InferenceServer(Thread):
             # cv2.waitKey(1)
         return True
 
+    def write_latency_report(self):
+        # Unity appends one trace per shown overlay to latency.trace in the output folder
+        log_path = os.path.join(self.output_path, 'latency.trace')
+        if not os.path.exists(log_path):
+            return
+        try:
+            collector = LatencyCollector()
+            count = collector.load_log(log_path)
+            collector.write_report(os.path.join(self.output_path, 'latency_report.json'))
+            collector.close()
+            print(f'Latency report written for {count} frames')
+        except OSError as e:
+            print(f'Latency report failed: {e}')
+
     def send_image(self, image):
         # encode image as np array
         # img_array = cv2.imencode('.jpg', image)[1]
         # self.send_one_message(img_array.tobytes())
         img_array = jpeg.encode(image)
-        self.send_one_message(img_array)
+        self.send_one_message(img_array, MSG_IMAGE)
 
 
 def start_server(output_path, detector):
@@ -233,9 +242,8 @@ def start_server(output_path, detector):
     bind_ip = IP
     bind_port = PORT
 
-    server = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
-    server.bind((bind_ip, bind_port))
-    server.listen(1)
+    # Messages are framed and multiplexed by ReplayApi, see MultiplexConnection.hpp. The listener binds all interfaces.
+    listener = MessageListener(bind_port)
     print('Listening on {}:{}'.format(bind_ip, bind_port))
 
     # add loop if more clients should be able to connect
@@ -243,12 +251,13 @@ def start_server(output_path, detector):
 
     # while True:
     # Accept messages from TCP clients
-    client_sock, address = server.accept()
-    print(f"Server accepts: {client_sock}, {address}")
-    client_sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+    connection = listener.accept_multiplexed()
+    listener.close()
+    print(f"Server accepts: {connection}")
+    address = (bind_ip, bind_port)
 
     global ir
-    ir = InferenceServer(client_sock, address, detector, path=output_path)
+    ir = InferenceServer(connection, address, detector, path=output_path)
     ir.start()
     return ir
 
@@ -0,0 +1,173 @@
+import ctypes
+
+# Message types of the Unity connection, see Client.cs
+MSG_TEXT = 1   # ASCII command or text reply
+MSG_IMAGE = 2  # JPEG frame, empty if there is none
+
+# Channels of multiplexed connections, see MultiplexConnection::Channel
+CHANNEL_CONTROL = 0  # Commands and their replies, sent ahead of bulk data
+CHANNEL_POSE = 1
+CHANNEL_BULK = 2     # Frames
+
+DEFAULT_CHUNK_SIZE = 256 * 1024
+
+
+class _Message(ctypes.Structure):
+    _fields_ = [('data', ctypes.c_void_p), ('size', ctypes.c_int64), ('sequence', ctypes.c_uint32), ('type', ctypes.c_uint16),
+                ('token', ctypes.c_void_p)]
+
+
+def _bind(lib):
+    lib.rr_ListenerCreate.restype = ctypes.c_void_p
+    lib.rr_ListenerCreate.argtypes = [ctypes.c_int32, ctypes.c_int32]
+    lib.rr_ListenerAccept.restype = ctypes.c_void_p
+    lib.rr_ListenerAccept.argtypes = [ctypes.c_void_p]
+    lib.rr_ListenerGetPort.restype = ctypes.c_int32
+    lib.rr_ListenerGetPort.argtypes = [ctypes.c_void_p]
+    lib.rr_ListenerDestroy.argtypes = [ctypes.c_void_p]
+    lib.rr_ConnectionConnect.restype = ctypes.c_void_p
+    lib.rr_ConnectionConnect.argtypes = [ctypes.c_char_p, ctypes.c_int32, ctypes.c_int32]
+    lib.rr_ConnectionDestroy.argtypes = [ctypes.c_void_p]
+    lib.rr_ConnectionSend.restype = ctypes.c_int32
+    lib.rr_ConnectionSend.argtypes = [ctypes.c_void_p, ctypes.c_uint16, ctypes.c_char_p, ctypes.c_int64]
+    lib.rr_ConnectionReceive.restype = ctypes.c_int32
+    lib.rr_ConnectionReceive.argtypes = [ctypes.c_void_p, ctypes.POINTER(_Message)]
+    lib.rr_MessageRelease.argtypes = [ctypes.POINTER(_Message)]
+    lib.rr_MultiplexAccept.restype = ctypes.c_void_p
+    lib.rr_MultiplexAccept.argtypes = [ctypes.c_void_p]
+    lib.rr_MultiplexConnect.restype = ctypes.c_void_p
+    lib.rr_MultiplexConnect.argtypes = [ctypes.c_char_p, ctypes.c_int32]
+    lib.rr_MultiplexDestroy.argtypes = [ctypes.c_void_p]
+    lib.rr_MultiplexSend.restype = ctypes.c_int32
+    lib.rr_MultiplexSend.argtypes = [ctypes.c_void_p, ctypes.c_int32, ctypes.c_uint16, ctypes.c_char_p, ctypes.c_int64]
+    lib.rr_MultiplexReceive.restype = ctypes.c_int32
+    lib.rr_MultiplexReceive.argtypes = [ctypes.c_void_p, ctypes.c_int32, ctypes.c_double, ctypes.POINTER(_Message)]
+    lib.rr_MultiplexIsOpen.restype = ctypes.c_int32
+    lib.rr_MultiplexIsOpen.argtypes = [ctypes.c_void_p]
+    return lib
+
+
+def _take(lib, message):
+    """Returns (type, payload bytes) of received native message and releases it."""
+    try:
+        return message.type, ctypes.string_at(message.data, message.size) if message.size else b''
+    finally:
+        lib.rr_MessageRelease(ctypes.byref(message))
+
+
+class MessageConnection:
+    """Framed message connection of ReplayApi, see MessageFraming.hpp for the wire format.
+
+    Messages are received into pooled native buffers and copied out once, sends are chunked natively. Send may be
+    called from any thread, receive from one thread at a time.
+    """
+
+    def __init__(self, lib, handle):
+        self.lib = lib
+        self.handle = handle
+
+    @classmethod
+    def connect(cls, host, port, chunk_size=DEFAULT_CHUNK_SIZE, lib_path='ReplayApi.dll'):
+        lib = _bind(ctypes.CDLL(lib_path))
+        handle = lib.rr_ConnectionConnect(host.encode(), port, chunk_size)
+        if not handle:
+            raise ConnectionError(f'Connecting to {host}:{port} failed')
+        return cls(lib, handle)
+
+    def send(self, data, msg_type=MSG_TEXT):
+        """Sends bytes-like data as one message. Returns False if the connection is closed."""
+        data = bytes(data)
+        return self.handle is not None and bool(self.lib.rr_ConnectionSend(self.handle, msg_type, data, len(data)))
+
+    def receive(self):
+        """Returns (type, payload bytes) of next message, None when the connection is closed. Blocks."""
+        if self.handle is None:
+            return None
+        message = _Message()
+        if not self.lib.rr_ConnectionReceive(self.handle, ctypes.byref(message)):
+            return None
+        return _take(self.lib, message)
+
+    def close(self):
+        if self.handle:
+            self.lib.rr_ConnectionDestroy(self.handle)
+            self.handle = None
+
+    def __del__(self):
+        self.close()
+
+
+class MultiplexConnection:
+    """Multiplexed connection of ReplayApi, see MultiplexConnection.hpp.
+
+    Control, pose and bulk channels share one socket. Each has its own flow control window, and a control message
+    waits for at most one bulk chunk instead of whole frames queued before it. Messages of each channel are received
+    in order; channels are independent, so each may be received from its own thread.
+    """
+
+    def __init__(self, lib, handle):
+        self.lib = lib
+        self.handle = handle
+
+    @classmethod
+    def connect(cls, host, port, lib_path='ReplayApi.dll'):
+        lib = _bind(ctypes.CDLL(lib_path))
+        handle = lib.rr_MultiplexConnect(host.encode(), port)
+        if not handle:
+            raise ConnectionError(f'Connecting to {host}:{port} failed')
+        return cls(lib, handle)
+
+    def send(self, channel, data, msg_type=MSG_TEXT):
+        """Queues copy of bytes-like data as one message on channel. Returns False if the connection is closed."""
+        data = bytes(data)
+        return self.handle is not None and bool(self.lib.rr_MultiplexSend(self.handle, channel, msg_type, data, len(data)))
+
+    def receive(self, channel, timeout=-1.0):
+        """Returns (type, payload bytes) of next message on channel, None on timeout or when the connection is closed.
+        Waits without limit if timeout is negative."""
+        if self.handle is None:
+            return None
+        message = _Message()
+        if not self.lib.rr_MultiplexReceive(self.handle, channel, timeout, ctypes.byref(message)):
+            return None
+        return _take(self.lib, message)
+
+    def is_open(self):
+        return self.handle is not None and bool(self.lib.rr_MultiplexIsOpen(self.handle))
+
+    def close(self):
+        if self.handle:
+            self.lib.rr_MultiplexDestroy(self.handle)
+            self.handle = None
+
+    def __del__(self):
+        self.close()
+
+
+class MessageListener:
+    """Accepts framed connections on all interfaces. Port 0 binds a free port, see port."""
+
+    def __init__(self, port, chunk_size=DEFAULT_CHUNK_SIZE, lib_path='ReplayApi.dll'):
+        self.lib = _bind(ctypes.CDLL(lib_path))
+        self.handle = self.lib.rr_ListenerCreate(port, chunk_size)
+        if not self.handle:
+            raise OSError(f'Listening on port {port} failed')
+        self.port = self.lib.rr_ListenerGetPort(self.handle)
+
+    def accept(self):
+        """Returns next MessageConnection, None if the listener is closed. Blocks."""
+        handle = self.lib.rr_ListenerAccept(self.handle)
+        return MessageConnection(self.lib, handle) if handle else None
+
+    def accept_multiplexed(self):
+        """Returns next MultiplexConnection, None if the listener is closed. Blocks."""
+        handle = self.lib.rr_MultiplexAccept(self.handle)
+        return MultiplexConnection(self.lib, handle) if handle else None
+
+    def close(self):
+        if self.handle:
+            self.lib.rr_ListenerDestroy(self.handle)
+            self.handle = None
+
+    def __del__(self):
+        self.close()
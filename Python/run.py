@@ -38,7 +38,8 @@ def main():
 
 if __name__ == '__main__':
     parser = argparse.ArgumentParser()
-    parser.add_argument("--src", default="", help="Path to an input video file. Leave blank to use live stream.")
+    parser.add_argument("--src", default="", help="Path to an input video file, or 'cubemap' for the recorder's equirect snapshots. "
+                                                  "Leave blank to use live stream.")
     parser.add_argument("--mode", default="live_streaming", help="live_streaming, video_input")
     args = parser.parse_args()
     main()
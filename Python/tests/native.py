@@ -0,0 +1,22 @@
+import ctypes
+import os
+import unittest
+
+# Native library under test, e.g. REPLAY_API_LIB=../VarjoCameraRecorder/VarjoCameraRecorder/bin/ReplayApi.dll
+LIB_PATH = os.environ.get('REPLAY_API_LIB', 'ReplayApi.dll')
+
+# Set by CI and ctest so that a missing library fails instead of skipping the native tests
+REQUIRE_NATIVE = os.environ.get('REPLAY_API_REQUIRE', '') not in ('', '0')
+
+
+def _available():
+    try:
+        ctypes.CDLL(LIB_PATH)
+        return True
+    except OSError:
+        if REQUIRE_NATIVE:
+            raise
+        return False
+
+
+requires_native = unittest.skipUnless(_available(), f'{LIB_PATH} not found, set REPLAY_API_LIB')
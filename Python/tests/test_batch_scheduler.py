@@ -0,0 +1,41 @@
+import unittest
+
+import numpy as np
+
+from inference.batch_scheduler import BatchScheduler
+from tests.native import LIB_PATH, requires_native
+
+
+def fill(source, slot):
+    if source[0] == 7:
+        raise RuntimeError('bad input')
+    slot[:] = source[0]
+
+
+@requires_native
+class BatchSchedulerTest(unittest.TestCase):
+    def run_model(self, scheduler, futures):
+        while not all(future.done() for future in futures):
+            batch = scheduler.next_batch(timeout=1.0)
+            if batch is None:
+                break
+            batch, inputs = batch
+            scheduler.finish(batch, [float(item[0]) for item in inputs])
+
+    def test_cancel_and_preprocess_error(self):
+        scheduler = BatchScheduler((4,), max_batch=4, preprocess=fill, lib_path=LIB_PATH)
+        try:
+            futures = [scheduler.submit(np.full(4, i, np.uint8)) for i in range(8)]
+            self.assertTrue(futures[2].cancel())
+            self.run_model(scheduler, futures)
+
+            self.assertTrue(futures[2].cancelled())
+            self.assertIsInstance(futures[7].exception(timeout=0), RuntimeError)
+            self.assertEqual([futures[i].result(timeout=0) for i in (0, 1, 3, 4, 5, 6)], [0.0, 1.0, 3.0, 4.0, 5.0, 6.0])
+        finally:
+            scheduler.stop()
+            scheduler.close()
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,58 @@
+import unittest
+
+import numpy as np
+
+from inference.change_index import ChangeIndex
+from tests.native import LIB_PATH, requires_native
+
+
+@requires_native
+class ChangeIndexTest(unittest.TestCase):
+    def setUp(self):
+        self.index = ChangeIndex(320, 240, tile_size=32, lib_path=LIB_PATH)
+
+    def tearDown(self):
+        self.index.close()
+
+    def test_query_returns_changes_in_region_and_time(self):
+        self.index.add_box(1, 'cup', (10, 10, 40, 40))
+        self.index.add_box(2, 'apple', (200, 100, 230, 130))
+        self.index.add_box(3, 'cup', (20, 20, 50, 50))
+
+        self.assertEqual(self.index.query((0, 0, 64, 64), 0, 10), [(1, 'cup'), (3, 'cup')])
+        self.assertEqual(self.index.query((0, 0, 320, 240), 2, 2), [(2, 'apple')])
+        self.assertTrue(self.index.has_change((210, 110, 211, 111), 0, 5))
+        self.assertFalse(self.index.has_change((210, 110, 211, 111), 3, 5))
+
+    def test_mask_touches_covered_tiles_only(self):
+        mask = np.zeros((240, 320), np.uint8)
+        mask[100:110, 100:110] = 1
+        self.index.add_mask(5, 'jar', mask)
+
+        self.assertEqual(self.index.event_count(), 1)
+        self.assertEqual(self.index.query((96, 96, 128, 128), 0, 10), [(5, 'jar')])
+        self.assertEqual(self.index.query((0, 0, 64, 64), 0, 10), [])
+
+    def test_duplicates_are_dropped_out_of_order(self):
+        self.index.add_box(1, 'cup', (0, 0, 10, 10))
+        self.index.add_box(1, 'hat', (0, 0, 10, 10))
+        self.index.add_box(2, 'cup', (0, 0, 10, 10))
+        # Same object and time again after later events, in the middle of the equal-time range
+        self.index.add_box(1, 'cup', (0, 0, 10, 10))
+        self.index.add_box(1, 'hat', (0, 0, 10, 10))
+
+        self.assertEqual(self.index.event_count(), 3)
+        self.assertEqual(self.index.query((0, 0, 10, 10), 0, 10), [(1, 'cup'), (1, 'hat'), (2, 'cup')])
+
+    def test_changed_objects_are_ordered_by_first_change(self):
+        self.index.add_box(4, 'hat', (0, 0, 10, 10))
+        self.index.add_box(2, 'cup', (0, 0, 10, 10))
+        self.index.add_box(7, 'cup', (0, 0, 10, 10))
+
+        self.assertEqual(self.index.changed_objects(), ['cup', 'hat'])
+        self.assertEqual(self.index.span('cup'), (2, 7, 2))
+        self.assertIsNone(self.index.span('apple'))
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,62 @@
+import os
+import tempfile
+import unittest
+
+import cv2
+import numpy as np
+
+from inference.equirect_snapshot import EquirectSnapshotStream
+from inference.latency_trace import FrameTrace, INGEST
+
+
+class EquirectSnapshotStreamTest(unittest.TestCase):
+    def setUp(self):
+        self.directory = tempfile.TemporaryDirectory()
+        self.base_path = os.path.join(self.directory.name, 'cube_equirect')
+        self.stream = EquirectSnapshotStream(self.base_path, timeout=0.05, poll_interval=0.005)
+
+    def tearDown(self):
+        self.directory.cleanup()
+
+    def write_image(self, frame_number, value):
+        cv2.imwrite(self.stream.image_path(frame_number), np.full((8, 16, 3), value, np.uint8))
+
+    def publish(self, frame_number, value):
+        self.write_image(frame_number, value)
+        FrameTrace(frame_number, 1000 * frame_number).write(self.base_path + '.trace')
+
+    def test_reads_each_published_frame_once(self):
+        self.publish(1, 10)
+        self.stream.read_stream()
+        self.assertEqual(self.stream.frame.shape, (8, 16, 3))
+        self.assertEqual(self.stream.frame[0, 0, 0], 10)
+        self.assertEqual(self.stream.trace.frame_number, 1)
+        self.assertNotEqual(self.stream.trace.stamps[INGEST], 0)
+
+        # Same trace again means no new frame, the stream times out
+        self.stream.read_stream()
+        self.assertIsNone(self.stream.frame)
+
+        self.publish(2, 20)
+        self.stream.read_stream()
+        self.assertEqual(self.stream.frame[0, 0, 0], 20)
+
+    def test_frame_is_none_without_snapshot(self):
+        self.stream.read_stream()
+        self.assertIsNone(self.stream.frame)
+
+    def test_trace_without_image_is_not_a_frame(self):
+        FrameTrace(1, 1000).write(self.base_path + '.trace')
+        self.stream.read_stream()
+        self.assertIsNone(self.stream.frame)
+
+    def test_image_of_next_frame_is_not_paired_with_trace(self):
+        # Recorder has written the next image and deleted the one of the published trace, but not yet its trace
+        FrameTrace(1, 1000).write(self.base_path + '.trace')
+        self.write_image(2, 20)
+        self.stream.read_stream()
+        self.assertIsNone(self.stream.frame)
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,48 @@
+import os
+import tempfile
+import unittest
+from unittest import mock
+
+import cv2
+import numpy as np
+
+from inference import foveal_frame
+from inference.foveal_frame import read_snapshot
+
+
+@mock.patch.object(foveal_frame, '_get_decoder', return_value=None)
+class ReadSnapshotWithoutDecoderTest(unittest.TestCase):
+    def setUp(self):
+        self.directory = tempfile.TemporaryDirectory()
+        self.base_path = os.path.join(self.directory.name, 'left')
+
+    def tearDown(self):
+        self.directory.cleanup()
+
+    def write(self, extension, mtime):
+        filename = self.base_path + extension
+        if extension == '.bmp':
+            cv2.imwrite(filename, np.full((4, 6, 3), 7, np.uint8))
+        else:
+            with open(filename, 'wb') as f:
+                f.write(b'\0' * 16)
+        os.utime(filename, (mtime, mtime))
+
+    def test_reads_newer_bmp(self, _):
+        self.write('.fov', 1000)
+        self.write('.bmp', 2000)
+        self.assertEqual(read_snapshot(self.base_path)[0, 0, 0], 7)
+
+    def test_newer_fov_is_an_error(self, _):
+        # The .bmp is left over from an earlier session
+        self.write('.bmp', 1000)
+        self.write('.fov', 2000)
+        with self.assertRaises(RuntimeError):
+            read_snapshot(self.base_path)
+
+    def test_missing_snapshot_is_none(self, _):
+        self.assertIsNone(read_snapshot(self.base_path))
+
+
+if __name__ == '__main__':
+    unittest.main()
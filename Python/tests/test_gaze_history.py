@@ -0,0 +1,65 @@
+import os
+import struct
+import tempfile
+import unittest
+
+from inference.gaze_history import GazeHistory
+from tests.native import LIB_PATH, requires_native
+
+
+def _pack(values, tail):
+    return sum((v & 0xFFFF) << (16 * i) for i, v in enumerate(values)) | (tail << 48)
+
+
+def _gaze_log(samples):
+    """Returns gaze log bytes of (time_ns, gaze, world) samples, valid status and unit vectors in Q14."""
+    data = struct.pack('<IHH', 0x4C5A4147, 1, 24)
+    for time, gaze, world in samples:
+        data += struct.pack('<qQQ', time, _pack(gaze, (2 << 14) | 1000), _pack(world, 1))
+    return data
+
+
+@requires_native
+class GazeHistoryTest(unittest.TestCase):
+    def setUp(self):
+        self.directory = tempfile.TemporaryDirectory()
+        self.history = GazeHistory(capacity=16, lib_path=LIB_PATH)
+
+    def tearDown(self):
+        self.history.close()
+        self.directory.cleanup()
+
+    def path(self, name):
+        return os.path.join(self.directory.name, name)
+
+    def test_written_log_matches_loaded_log(self):
+        data = _gaze_log([(1000000 * i, (0, 0, 16384), (0, 0, -16384)) for i in range(5)])
+        with open(self.path('in.log'), 'wb') as f:
+            f.write(data)
+
+        self.assertEqual(self.history.load_log(self.path('in.log')), 5)
+        self.assertTrue(self.history.write_log(self.path('out.log')))
+        with open(self.path('out.log'), 'rb') as f:
+            self.assertEqual(f.read(), data)
+
+        sample = self.history.sample_at(2100000, max_delta_ns=500000)
+        self.assertEqual(sample['time'], 2000000)
+        self.assertTrue(sample['valid'])
+        self.assertAlmostEqual(sample['focus_distance'], 1.0)
+
+    def test_write_log_keeps_latest_capacity_samples(self):
+        with open(self.path('in.log'), 'wb') as f:
+            f.write(_gaze_log([(1000000 * i, (0, 0, 16384), (0, 0, -16384)) for i in range(20)]))
+
+        self.assertEqual(self.history.load_log(self.path('in.log')), 20)
+        self.assertTrue(self.history.write_log(self.path('out.log')))
+        self.assertEqual(os.path.getsize(self.path('out.log')), 8 + 16 * 24)
+        self.assertIsNone(self.history.sample_at(3000000, max_delta_ns=0))
+        self.assertEqual(self.history.sample_at(19000000, max_delta_ns=0)['time'], 19000000)
+
+    def test_write_log_fails_on_missing_directory(self):
+        self.assertFalse(self.history.write_log(self.path('missing/out.log')))
+
+
+if __name__ == '__main__':
+    unittest.main()
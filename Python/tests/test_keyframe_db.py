@@ -0,0 +1,76 @@
+import unittest
+
+import numpy as np
+
+from inference.keyframe_db import KeyframeDatabase
+from tests.native import LIB_PATH, requires_native
+
+
+def _random_poses(rng, count):
+    """Returns count x 4 x 4 HMD poses with random rotation and position within a meter of the origin."""
+    q, r = np.linalg.qr(rng.normal(size=(count, 3, 3)))
+    q *= np.sign(np.diagonal(r, axis1=1, axis2=2))[:, None, :]
+    q[np.linalg.det(q) < 0, :, 0] *= -1
+    poses = np.tile(np.eye(4), (count, 1, 1))
+    poses[:, :3, :3] = q
+    poses[:, :3, 3] = rng.uniform(-1.0, 1.0, size=(count, 3))
+    return poses
+
+
+@requires_native
+class KeyframeDatabaseTest(unittest.TestCase):
+    KEYFRAMES = 50000
+    QUERIES = 500
+    POSITION_WEIGHT = 0.5
+
+    def setUp(self):
+        self.database = KeyframeDatabase(max_keyframes=self.KEYFRAMES, position_weight=self.POSITION_WEIGHT, lib_path=LIB_PATH)
+
+    def tearDown(self):
+        self.database.close()
+
+    def test_nearest_matches_brute_force(self):
+        rng = np.random.default_rng(7)
+        poses = _random_poses(rng, self.KEYFRAMES)
+        for i, pose in enumerate(poses):
+            self.assertEqual(self.database.add(1000 * i, pose, i + 1), i + 1)
+
+        # Database keeps directions and positions as float
+        directions = -poses[:, :3, 2]
+        directions = (directions / np.linalg.norm(directions, axis=1)[:, None]).astype(np.float32).astype(np.float64)
+        positions = poses[:, :3, 3].astype(np.float32).astype(np.float64)
+        times = 1000 * np.arange(self.KEYFRAMES)
+
+        for query in _random_poses(rng, self.QUERIES):
+            t0, t1 = np.sort(rng.integers(0, 1000 * self.KEYFRAMES, size=2))
+            max_angle = rng.uniform(5.0, 180.0)
+            direction = -query[:3, 2]
+            angles = np.degrees(np.arccos(np.clip(directions @ direction, -1.0, 1.0)))
+            costs = np.radians(angles) + self.POSITION_WEIGHT * np.linalg.norm(positions - query[:3, 3], axis=1)
+            costs[(times < t0) | (times > t1) | (angles > max_angle)] = np.inf
+
+            match = self.database.find_nearest(query, t0, t1, max_angle)
+            if not np.isfinite(costs.min()):
+                self.assertIsNone(match)
+                continue
+            self.assertIsNotNone(match)
+            self.assertAlmostEqual(match['cost'], costs.min(), places=6)
+
+        # Queries compare the keyframes near the view only, not the whole database
+        stats = self.database.stats()
+        self.assertEqual(stats['queries'], self.QUERIES)
+        self.assertLess(stats['scanned'] / stats['queries'], 0.1 * self.KEYFRAMES)
+
+    def test_frames_of_evicted_keyframes_are_not_returned(self):
+        poses = _random_poses(np.random.default_rng(3), 4)
+        for i, pose in enumerate(poses):
+            self.database.add(1000 * i, pose, i + 1)
+
+        self.assertEqual(self.database.evict_before(2000), 2)
+        self.assertIsNone(self.database.get(1))
+        self.assertEqual(self.database.get(3)['frame'], 3)
+        self.assertIn(self.database.find_nearest(poses[0])['id'], (3, 4))
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,80 @@
+import os
+import tempfile
+import unittest
+
+import numpy as np
+
+from inference.mask_store import MaskStore, ReferenceMaskStore
+from tests.native import LIB_PATH, requires_native
+
+
+def random_mask(rng, shape):
+    mask = np.zeros(shape, np.uint8)
+    y, x = rng.integers(0, shape[0] - 8), rng.integers(0, shape[1] - 8)
+    mask[y:y + rng.integers(4, 40), x:x + rng.integers(4, 60)] = 1
+    mask[rng.random(shape) < 0.02] = 1
+    return mask
+
+
+@requires_native
+class MaskStoreTest(unittest.TestCase):
+    def setUp(self):
+        self.store = MaskStore(96, 64, lib_path=LIB_PATH)
+        self.reference = ReferenceMaskStore(96, 64)
+
+    def tearDown(self):
+        self.store.close()
+
+    def put(self, frame, label, mask):
+        self.reference.put(frame, label, mask)
+        return self.store.put(frame, label, mask)
+
+    def test_stored_mask_decodes_losslessly(self):
+        mask = random_mask(np.random.default_rng(1), (64, 96))
+        stored = self.put(3, 'cup', mask)
+
+        np.testing.assert_array_equal(stored.mask, mask)
+        np.testing.assert_array_equal(self.store.get(3, 'cup', value=255), mask * 255)
+        self.assertIsNone(self.store.get(4, 'cup'))
+        self.assertIsNone(self.store.get(3, 'hat'))
+
+    def test_union_matches_numpy(self):
+        rng = np.random.default_rng(2)
+        for frame in range(5):
+            for label in ('cup', 'hat', 'jar'):
+                self.put(frame, label, random_mask(rng, (64, 96)))
+
+        for frames in ([0], [1, 3], [0, 1, 2, 3, 4], [2, 2, 9], []):
+            np.testing.assert_array_equal(self.store.union(frames), self.reference.union(frames))
+
+    def test_centroid_matches_numpy(self):
+        mask = random_mask(np.random.default_rng(3), (64, 96))
+        self.put(0, 'cup', mask)
+        self.put(0, 'hat', np.zeros((64, 96), np.uint8))
+
+        np.testing.assert_allclose(self.store.centroid(0, 'cup'), self.reference.centroid(0, 'cup'), atol=1e-3)
+        self.assertIsNone(self.store.centroid(0, 'hat'))
+
+    def test_encoded_size_is_below_dense_size(self):
+        for frame in range(10):
+            mask = np.zeros((64, 96), np.uint8)
+            mask[10 + frame:30 + frame, 20:50] = 1
+            self.put(frame, 'cup', mask)
+
+        self.assertEqual(self.store.count(), 10)
+        self.assertLess(self.store.byte_size(), self.reference.byte_size() // 4)
+
+    def test_save_writes_file(self):
+        self.put(0, 'cup', random_mask(np.random.default_rng(5), (64, 96)))
+        with tempfile.TemporaryDirectory() as directory:
+            filename = os.path.join(directory, 'masks.rle')
+            self.assertTrue(self.store.save(filename))
+            self.assertGreater(os.path.getsize(filename), 0)
+
+    def test_wrong_size_is_rejected(self):
+        with self.assertRaises(ValueError):
+            self.store.put(0, 'cup', np.zeros((64, 95), np.uint8))
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,79 @@
+import threading
+import unittest
+
+from networking.message_connection import (CHANNEL_BULK, CHANNEL_CONTROL, MSG_IMAGE, MSG_TEXT, MessageConnection,
+                                           MessageListener, MultiplexConnection)
+from tests.native import LIB_PATH, requires_native
+
+
+@requires_native
+class MessageConnectionTest(unittest.TestCase):
+    def setUp(self):
+        self.listener = MessageListener(0, chunk_size=4096, lib_path=LIB_PATH)
+        accepted = []
+        thread = threading.Thread(target=lambda: accepted.append(self.listener.accept()))
+        thread.start()
+        self.client = MessageConnection.connect('127.0.0.1', self.listener.port, chunk_size=4096, lib_path=LIB_PATH)
+        thread.join()
+        self.server = accepted[0]
+
+    def tearDown(self):
+        self.client.close()
+        self.server.close()
+        self.listener.close()
+
+    def test_messages_keep_type_and_payload(self):
+        image = bytes(range(256)) * 100  # Several chunks
+        self.assertTrue(self.client.send(b'START_REPLAY'))
+        self.assertTrue(self.client.send(image, MSG_IMAGE))
+        self.assertTrue(self.client.send(b'', MSG_IMAGE))
+
+        self.assertEqual(self.server.receive(), (MSG_TEXT, b'START_REPLAY'))
+        self.assertEqual(self.server.receive(), (MSG_IMAGE, image))
+        self.assertEqual(self.server.receive(), (MSG_IMAGE, b''))
+
+    def test_receive_returns_none_after_close(self):
+        self.client.close()
+        self.assertIsNone(self.server.receive())
+
+
+@requires_native
+class MultiplexConnectionTest(unittest.TestCase):
+    def setUp(self):
+        self.listener = MessageListener(0, lib_path=LIB_PATH)
+        accepted = []
+        thread = threading.Thread(target=lambda: accepted.append(self.listener.accept_multiplexed()))
+        thread.start()
+        self.client = MultiplexConnection.connect('127.0.0.1', self.listener.port, lib_path=LIB_PATH)
+        thread.join()
+        self.server = accepted[0]
+
+    def tearDown(self):
+        self.client.close()
+        self.server.close()
+        self.listener.close()
+
+    def test_channels_keep_type_and_payload(self):
+        frame = bytes(range(256)) * 20000  # Many chunks
+        self.assertTrue(self.client.send(CHANNEL_BULK, frame, MSG_IMAGE))
+        self.assertTrue(self.client.send(CHANNEL_CONTROL, b'RECEIVE'))
+
+        # Control is received without draining the bulk channel first
+        self.assertEqual(self.server.receive(CHANNEL_CONTROL, 5.0), (MSG_TEXT, b'RECEIVE'))
+        self.assertEqual(self.server.receive(CHANNEL_BULK, 5.0), (MSG_IMAGE, frame))
+
+        self.assertTrue(self.server.send(CHANNEL_BULK, b'', MSG_IMAGE))
+        self.assertEqual(self.client.receive(CHANNEL_BULK, 5.0), (MSG_IMAGE, b''))
+
+    def test_receive_times_out(self):
+        self.assertIsNone(self.server.receive(CHANNEL_CONTROL, 0.05))
+        self.assertTrue(self.server.is_open())
+
+    def test_receive_returns_none_after_close(self):
+        self.client.close()
+        self.assertIsNone(self.server.receive(CHANNEL_CONTROL))
+        self.assertFalse(self.server.is_open())
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,98 @@
+import unittest
+
+import cv2
+import numpy as np
+
+from inference.overlay_compositor import BLEND_ADD, BLEND_OVER, BLEND_SCALE, OverlayCompositor, ReferenceCompositor
+from tests.native import LIB_PATH, requires_native
+
+
+def random_layer(rng, height, width, channels, fill=0.3):
+    """Sparse random layer, mostly zero like the replay visualizations."""
+    shape = (height, width, channels) if channels > 1 else (height, width)
+    image = rng.integers(0, 256, shape, dtype=np.uint8)
+    image[rng.random((height, width)) > fill] = 0
+    return image
+
+
+def opencv_visualization(gray, line, replay):
+    """gray_replay and visualization of the cv2 chain in OnlineDetector.apply_visualization before the compositor."""
+    transparent = np.zeros_like(line)
+    gray_sum = transparent.copy()
+    for layer in gray:
+        gray_sum = cv2.addWeighted(gray_sum, 1, layer, 1, 0)
+    gray_replay = cv2.addWeighted(transparent, 0, gray_sum, 0.5, 0)
+    visualization = cv2.addWeighted(transparent, 0, gray_sum, 0.8, 0)
+    visualization = cv2.addWeighted(visualization, 1.0, line, 1.0, 0)
+    return gray_replay, cv2.add(visualization, replay)
+
+
+def composite_visualization(compositor, gray, line, replay):
+    """Same outputs as opencv_visualization() through compositor, with the uses of the detector."""
+    layers = [(layer, (0, 0), (1, 1, 1, 1)) for layer in gray + [line, replay]]
+    gray_uses = [(layer, 1.0, BLEND_ADD) for layer in range(len(gray))]
+    outputs = [gray_uses + [(-1, 0.5, BLEND_SCALE)],
+               gray_uses + [(-1, 0.8, BLEND_SCALE), (len(gray), 1.0, BLEND_ADD), (len(gray) + 1, 1.0, BLEND_ADD)]]
+    uses = [(output, layer, opacity, blend) for output, output_uses in enumerate(outputs) for layer, opacity, blend in output_uses]
+    return compositor.composite(line.shape, layers, uses, len(outputs))
+
+
+class ReferenceCompositorTest(unittest.TestCase):
+    def test_visualization_matches_opencv_chain(self):
+        # Dense gray layers saturate their sum before it is scaled
+        rng = np.random.default_rng(7)
+        gray = [random_layer(rng, 97, 131, 4, fill=0.8) for _ in range(3)]
+        line, replay = random_layer(rng, 97, 131, 4), random_layer(rng, 97, 131, 4)
+
+        for output, expected in zip(composite_visualization(ReferenceCompositor(), gray, line, replay),
+                                    opencv_visualization(gray, line, replay)):
+            np.testing.assert_array_equal(output, expected)
+
+
+@requires_native
+class OverlayCompositorTest(unittest.TestCase):
+    def setUp(self):
+        self.compositor = OverlayCompositor(lib_path=LIB_PATH, thread_count=3)
+
+    def tearDown(self):
+        self.compositor.close()
+
+    def test_simd_matches_reference_bit_exact(self):
+        rng = np.random.default_rng(3)
+        shape = (203, 317)
+        # Odd sizes, negative and overhanging offsets, RGBA and mask layers
+        layers = [(random_layer(rng, 203, 317, 4), (0, 0), (1, 1, 1, 1)),
+                  (random_layer(rng, 77, 131, 4), (-13, -29), (1, 0.5, 0.25, 1)),
+                  (random_layer(rng, 91, 45, 1), (150, 290), (0.2, 0.7, 1, 1)),
+                  (random_layer(rng, 64, 64, 4, fill=1.0), (64, 128), (1, 1, 1, 1)),
+                  (np.zeros((50, 50, 4), np.uint8), (10, 10), (1, 1, 1, 1))]
+        uses = [(0, 0, 1.0, BLEND_ADD), (0, 1, 0.8, BLEND_ADD), (0, 2, 0.5, BLEND_ADD),
+                (1, 0, 1.0, BLEND_ADD), (1, 1, 0.7, BLEND_OVER), (1, 2, 1.0, BLEND_OVER), (1, 3, 0.5, BLEND_OVER),
+                (2, 4, 1.0, BLEND_OVER), (2, 3, 2.5, BLEND_ADD), (2, -1, 0.3, BLEND_SCALE), (0, -1, 1.7, BLEND_SCALE)]
+
+        native = self.compositor.composite(shape, layers, uses, 4)
+        reference = ReferenceCompositor().composite(shape, layers, uses, 4)
+        for output, expected in zip(native, reference):
+            np.testing.assert_array_equal(output, expected)
+        self.assertFalse(native[3].any())
+
+    def test_add_matches_opencv_chain(self):
+        rng = np.random.default_rng(5)
+        a = random_layer(rng, 120, 160, 4)
+        b = random_layer(rng, 120, 160, 4)
+        layers = [(a, (0, 0), (1, 1, 1, 1)), (b, (0, 0), (1, 1, 1, 1))]
+        add, = self.compositor.composite(a.shape, layers, [(0, 0, 1.0, BLEND_ADD), (0, 1, 1.0, BLEND_ADD)], 1)
+        np.testing.assert_array_equal(add, cv2.add(a, b))
+
+    def test_visualization_matches_opencv_chain(self):
+        rng = np.random.default_rng(7)
+        # Widths not divisible by 4 or the tile size exercise the scalar tails
+        gray = [random_layer(rng, 150, 203, 4, fill=0.8) for _ in range(3)]
+        line, replay = random_layer(rng, 150, 203, 4), random_layer(rng, 150, 203, 4)
+
+        for output, expected in zip(composite_visualization(self.compositor, gray, line, replay),
+                                    opencv_visualization(gray, line, replay)):
+            np.testing.assert_array_equal(output, expected)
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,58 @@
+import gc
+import unittest
+
+import numpy as np
+
+from inference.polyline_layer import PolylineLayer
+from tests.native import LIB_PATH, requires_native
+
+
+def trajectory(count=300, width=640, height=360):
+    """Wandering motion line with per-vertex colors fading in, like a tracked object trajectory."""
+    rng = np.random.default_rng(3)
+    steps = rng.normal(0.0, 6.0, (count, 2))
+    points = np.cumsum(steps, axis=0) + (width / 2, height / 2)
+    points = np.clip(points, 0, (width - 1, height - 1))
+    alpha = np.linspace(40, 255, count)
+    colors = np.stack([np.full(count, 30), np.full(count, 200), np.full(count, 255), alpha], axis=1)
+    return points, colors
+
+
+@requires_native
+class PolylineLayerTest(unittest.TestCase):
+    shape = (360, 640)
+
+    def test_appended_matches_full_draw(self):
+        points, colors = trajectory()
+
+        appended = PolylineLayer(self.shape, 5.0, lib_path=LIB_PATH)
+        for point, color in zip(points, colors):
+            appended.append(point, color)
+        appended.end()
+
+        drawn = PolylineLayer(self.shape, 5.0, lib_path=LIB_PATH)
+        drawn.draw(points, colors)
+
+        self.assertIsNot(appended.image.base, drawn.image.base)
+        self.assertGreater(np.count_nonzero(drawn.image[..., 3]), 1000)
+        np.testing.assert_array_equal(appended.image, drawn.image)
+
+    def test_image_outlives_layer(self):
+        points, colors = trajectory(count=50)
+        layer = PolylineLayer(self.shape, 3.0, lib_path=LIB_PATH)
+        layer.draw(points, colors)
+        image = layer.image
+        expected = image.copy()
+
+        layer.close()
+        del layer
+        gc.collect()
+
+        # Allocations that would reuse freed layer memory
+        garbage = [np.full(self.shape + (4,), 255, np.uint8) for _ in range(4)]
+        np.testing.assert_array_equal(image, expected)
+        del garbage
+
+
+if __name__ == '__main__':
+    unittest.main()
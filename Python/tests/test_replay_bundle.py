@@ -0,0 +1,98 @@
+import ctypes
+import os
+import struct
+import tempfile
+import unittest
+
+import numpy as np
+
+from inference.replay_bundle import ReplayBundleWriter, TRACK_DATA
+from tests.native import LIB_PATH, requires_native
+
+_TRAILER = struct.Struct('<QQIIII')
+_ENTRY_HEADER = struct.Struct('<IIqQ')
+_ENTRY_MAGIC = 0x4E454252
+_TRACK_DEFINITION = 0xFFFFFFFF
+
+
+@requires_native
+class ReplayBundleTest(unittest.TestCase):
+    def setUp(self):
+        self.lib = ctypes.CDLL(LIB_PATH)
+        self.lib.rr_BundleOpen.restype = ctypes.c_void_p
+        self.lib.rr_BundleOpen.argtypes = [ctypes.c_char_p]
+        self.lib.rr_BundleClose.argtypes = [ctypes.c_void_p]
+        self.lib.rr_BundleGetTrackCount.restype = ctypes.c_int32
+        self.lib.rr_BundleGetTrackCount.argtypes = [ctypes.c_void_p]
+        self.lib.rr_BundleFindTrack.restype = ctypes.c_int32
+        self.lib.rr_BundleFindTrack.argtypes = [ctypes.c_void_p, ctypes.c_char_p]
+        self.lib.rr_BundleGetFrame.restype = ctypes.c_int32
+        self.lib.rr_BundleGetFrame.argtypes = [ctypes.c_void_p, ctypes.c_int32, ctypes.c_int64, ctypes.POINTER(ctypes.c_void_p),
+                                               ctypes.POINTER(ctypes.c_int64)]
+        self.dir = tempfile.TemporaryDirectory()
+        self.path = os.path.join(self.dir.name, 'replay.bundle')
+
+    def tearDown(self):
+        self.dir.cleanup()
+
+    def write_bundle(self, frames):
+        writer = ReplayBundleWriter(self.path, lib_path=LIB_PATH)
+        for frame_idx, data in enumerate(frames):
+            self.assertTrue(writer.write('data', frame_idx, data, TRACK_DATA))
+        self.assertTrue(writer.close())
+
+    def read_trailer(self):
+        with open(self.path, 'rb') as f:
+            f.seek(-_TRAILER.size, os.SEEK_END)
+            return _TRAILER.unpack(f.read(_TRAILER.size))
+
+    def read_frame(self, bundle, track, frame_idx):
+        data = ctypes.c_void_p()
+        size = ctypes.c_int64()
+        if not self.lib.rr_BundleGetFrame(bundle, track, frame_idx, ctypes.byref(data), ctypes.byref(size)):
+            return None
+        return ctypes.string_at(data, size.value)
+
+    def test_numpy_frame_is_written_whole(self):
+        frame = np.arange(6 * 5, dtype=np.uint16).reshape(6, 5)
+        self.write_bundle([frame])
+
+        bundle = self.lib.rr_BundleOpen(self.path.encode())
+        self.assertTrue(bundle)
+        track = self.lib.rr_BundleFindTrack(bundle, b'data')
+        self.assertEqual(self.read_frame(bundle, track, 0), frame.tobytes())
+        self.lib.rr_BundleClose(bundle)
+
+    def test_corrupt_index_counts_fall_back_to_scan(self):
+        self.write_bundle([b'abc', b'defg'])
+        index_offset, entry_count, track_count, reserved, magic, version = self.read_trailer()
+        with open(self.path, 'r+b') as f:
+            f.seek(-_TRAILER.size, os.SEEK_END)
+            f.write(_TRAILER.pack(index_offset, 2 ** 62, 0xFFFFFFFF, reserved, magic, version))
+
+        bundle = self.lib.rr_BundleOpen(self.path.encode())
+        self.assertTrue(bundle)
+        track = self.lib.rr_BundleFindTrack(bundle, b'data')
+        self.assertEqual(self.read_frame(bundle, track, 1), b'defg')
+        self.lib.rr_BundleClose(bundle)
+
+    def test_scan_stops_at_out_of_order_track_id(self):
+        # Drop the index as if the writer crashed, and give the track definition a far out of range id
+        self.write_bundle([b'abc'])
+        index_offset = self.read_trailer()[0]
+        with open(self.path, 'rb') as f:
+            data = bytearray(f.read(index_offset))
+        offset = data.find(_ENTRY_HEADER.pack(_ENTRY_MAGIC, _TRACK_DEFINITION, 0, 88)[:8])
+        self.assertGreater(offset, 0)
+        struct.pack_into('<I', data, offset + _ENTRY_HEADER.size, 0x7FFFFFFF)
+        with open(self.path, 'wb') as f:
+            f.write(data)
+
+        bundle = self.lib.rr_BundleOpen(self.path.encode())
+        self.assertTrue(bundle)
+        self.assertEqual(self.lib.rr_BundleGetTrackCount(bundle), 0)
+        self.lib.rr_BundleClose(bundle)
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,102 @@
+import unittest
+from unittest import mock
+
+import cv2
+import numpy as np
+
+import inference.Equirec2Perspec as E2P
+from inference.spherical_stabilizer import SphericalStabilizer
+from tests.native import LIB_PATH, requires_native
+
+
+def _quat_rotate(q, v):
+    w, x, y, z = q
+    u = np.array([x, y, z])
+    return 2.0 * np.dot(u, v) * u + (w * w - np.dot(u, u)) * v + 2.0 * w * np.cross(u, v)
+
+
+def _bearing_to_equirect(d, shape):
+    lon = np.arctan2(d[..., 0], d[..., 2])
+    lat = np.arcsin(np.clip(d[..., 1], -1.0, 1.0))
+    return np.stack([(lon / (2 * np.pi) + 0.5) * (shape[1] - 1), (lat / np.pi + 0.5) * (shape[0] - 1)], axis=-1)
+
+
+def _texture(shape, seed=1):
+    rng = np.random.default_rng(seed)
+    noise = rng.integers(0, 256, (shape[0] // 8, shape[1] // 8, 3), dtype=np.uint8)
+    return cv2.GaussianBlur(cv2.resize(noise, (shape[1], shape[0]), interpolation=cv2.INTER_LINEAR), (5, 5), 0)
+
+
+@requires_native
+class SphericalStabilizerTest(unittest.TestCase):
+    def setUp(self):
+        self.stabilizer = SphericalStabilizer(lib_path=LIB_PATH)
+
+    def tearDown(self):
+        self.stabilizer.close()
+
+    def test_recovers_rotation_from_equirect_points(self):
+        shape = (960, 1920)
+        angle = np.radians(3.0)
+        axis = np.array([0.2, 1.0, 0.1]) / np.linalg.norm([0.2, 1.0, 0.1])
+        q = np.concatenate([[np.cos(angle / 2)], np.sin(angle / 2) * axis])
+
+        rng = np.random.default_rng(7)
+        bearings = rng.normal(size=(200, 3))
+        bearings /= np.linalg.norm(bearings, axis=1, keepdims=True)
+        bearings = bearings[np.abs(bearings[:, 1]) < 0.8]
+        rotated = np.array([_quat_rotate(q, b) for b in bearings])
+
+        self.assertTrue(self.stabilizer.update_points(_bearing_to_equirect(bearings, shape), _bearing_to_equirect(rotated, shape), shape))
+        rotation, inliers = self.stabilizer.rotation()
+        self.assertEqual(inliers, len(bearings))
+        self.assertGreater(abs(np.dot(rotation, q)), np.cos(np.radians(0.05) / 2))
+
+    def test_identity_remap_matches_get_perspective(self):
+        frame = _texture((480, 960))
+        expected = E2P.Equirectangular(frame).GetPerspective(60, 30, -10, 120, 160)
+        actual = self.stabilizer.perspective(frame, 60, 30, -10, 120, 160)
+        self.assertLess(np.abs(actual.astype(np.int32) - expected).mean(), 1.0)
+
+    def test_yaw_is_removed_from_perspective(self):
+        frame = _texture((480, 960))
+        shift = 8
+        rotated = np.roll(frame, shift, axis=1)
+        self.stabilizer.update(frame)
+        self.assertTrue(self.stabilizer.update(rotated))
+
+        expected = E2P.Equirectangular(frame).GetPerspective(60, 0, 0, 120, 160)
+        unstabilized = E2P.Equirectangular(rotated).GetPerspective(60, 0, 0, 120, 160)
+        stabilized = self.stabilizer.perspective(rotated, 60, 0, 0, 120, 160)
+        error = np.abs(stabilized.astype(np.int32) - expected).mean()
+        self.assertLess(error, 0.25 * np.abs(unstabilized.astype(np.int32) - expected).mean())
+
+    def test_marker_prior_replaces_rejected_estimate(self):
+        shape = (960, 1920)
+        angle = np.radians(4.0)
+        axis = np.array([0.3, 1.0, -0.2]) / np.linalg.norm([0.3, 1.0, -0.2])
+        q = np.concatenate([[np.cos(angle / 2)], np.sin(angle / 2) * axis])
+
+        corners = np.array([[-0.05, -0.05, 1.0], [0.05, -0.05, 1.0], [0.05, 0.05, 1.0], [-0.05, 0.05, 1.0]])
+        corners /= np.linalg.norm(corners, axis=1, keepdims=True)
+        rotated = np.array([_quat_rotate(q, c) for c in corners])
+
+        self.assertTrue(self.stabilizer.set_marker_prior(_bearing_to_equirect(corners, shape), _bearing_to_equirect(rotated, shape), shape))
+        self.assertFalse(self.stabilizer.update_points(np.empty((0, 2)), np.empty((0, 2)), shape))
+        rotation, _ = self.stabilizer.rotation()
+        self.assertGreater(abs(np.dot(rotation, q)), np.cos(np.radians(0.1) / 2))
+
+    def test_features_are_detected_again_only_when_tracking_degrades(self):
+        frame = _texture((480, 960))
+        with mock.patch.object(cv2, 'goodFeaturesToTrack', wraps=cv2.goodFeaturesToTrack) as detect:
+            for shift in range(4):
+                self.stabilizer.update(np.roll(frame, 2 * shift, axis=1))
+            self.assertEqual(detect.call_count, 1)
+
+            self.stabilizer.update(np.zeros_like(frame))
+            self.stabilizer.update(frame)
+            self.assertEqual(detect.call_count, 2)
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,131 @@
+import ctypes
+import os
+import tempfile
+import unittest
+
+import cv2
+import numpy as np
+
+from inference.replay_bundle import ReplayBundleWriter, TRACK_IMAGE
+from tests.native import LIB_PATH, requires_native
+
+_TILE_SIZE = 32
+
+
+def overlay_frame(width=1917, height=1079, blobs=6):
+    """Transparent BGRA frame with opaque blobs, like the per-object replay visualizations."""
+    rng = np.random.default_rng(7)
+    frame = np.zeros((height, width, 4), np.uint8)
+    for _ in range(blobs):
+        center = (int(rng.integers(60, width - 60)), int(rng.integers(60, height - 60)))
+        color = tuple(int(c) for c in rng.integers(0, 256, 3)) + (255,)
+        cv2.circle(frame, center, 50, color, -1)
+    return frame
+
+
+@requires_native
+class TiledOverlayTest(unittest.TestCase):
+    def setUp(self):
+        self.lib = ctypes.CDLL(LIB_PATH)
+        self.lib.rr_BundleOpen.restype = ctypes.c_void_p
+        self.lib.rr_BundleOpen.argtypes = [ctypes.c_char_p]
+        self.lib.rr_BundleClose.argtypes = [ctypes.c_void_p]
+        self.lib.rr_BundleFindTrack.restype = ctypes.c_int32
+        self.lib.rr_BundleFindTrack.argtypes = [ctypes.c_void_p, ctypes.c_char_p]
+        self.lib.rr_BundleGetFrame.restype = ctypes.c_int32
+        self.lib.rr_BundleGetFrame.argtypes = [ctypes.c_void_p, ctypes.c_int32, ctypes.c_int64, ctypes.POINTER(ctypes.c_void_p),
+                                               ctypes.POINTER(ctypes.c_int64)]
+        self.lib.rr_OverlayOpen.restype = ctypes.c_void_p
+        self.lib.rr_OverlayOpen.argtypes = [ctypes.c_void_p, ctypes.c_int64]
+        self.lib.rr_OverlayOpenFromBundle.restype = ctypes.c_void_p
+        self.lib.rr_OverlayOpenFromBundle.argtypes = [ctypes.c_void_p, ctypes.c_int32, ctypes.c_int64]
+        self.lib.rr_OverlayDestroy.argtypes = [ctypes.c_void_p]
+        self.lib.rr_OverlayGetTileCount.restype = ctypes.c_int32
+        self.lib.rr_OverlayGetTileCount.argtypes = [ctypes.c_void_p]
+        self.lib.rr_OverlayDecode.restype = ctypes.c_int32
+        self.lib.rr_OverlayDecode.argtypes = [ctypes.c_void_p, ctypes.c_void_p, ctypes.c_int32]
+        self.dir = tempfile.TemporaryDirectory()
+        self.path = os.path.join(self.dir.name, 'replay.bundle')
+
+    def tearDown(self):
+        self.dir.cleanup()
+
+    def test_sparse_overlay_is_exact_and_small(self):
+        frame = overlay_frame()
+        height, width = frame.shape[:2]
+        writer = ReplayBundleWriter(self.path, lib_path=LIB_PATH)
+        self.assertTrue(writer.write_overlay('visualization', 0, frame))
+        self.assertTrue(writer.close())
+
+        bundle = self.lib.rr_BundleOpen(self.path.encode())
+        track = self.lib.rr_BundleFindTrack(bundle, b'visualization')
+        data = ctypes.c_void_p()
+        size = ctypes.c_int64()
+        self.assertTrue(self.lib.rr_BundleGetFrame(bundle, track, 0, ctypes.byref(data), ctypes.byref(size)))
+        overlay = self.lib.rr_OverlayOpen(data, size)
+        self.assertTrue(overlay)
+
+        # Six blobs cover a small fraction of the tiles, the stored overlay is at least 10x smaller than raw RGBA
+        tiles = ((width + _TILE_SIZE - 1) // _TILE_SIZE) * ((height + _TILE_SIZE - 1) // _TILE_SIZE)
+        self.assertLess(self.lib.rr_OverlayGetTileCount(overlay) * 10, tiles)
+        self.assertLess(size.value * 10, frame.nbytes)
+
+        np.testing.assert_array_equal(self.decode(overlay, frame.shape), cv2.cvtColor(frame, cv2.COLOR_BGRA2RGBA))
+
+        self.lib.rr_OverlayDestroy(overlay)
+        self.lib.rr_BundleClose(bundle)
+
+    def decode(self, overlay, shape):
+        decoded = np.empty(shape, np.uint8)
+        self.assertTrue(self.lib.rr_OverlayDecode(overlay, decoded.ctypes.data, decoded.strides[0]))
+        return decoded
+
+    def test_delta_frames_resolve_from_bundle(self):
+        frames = []
+        for frame_idx in range(5):
+            frame = np.zeros((240, 320, 4), np.uint8)
+            cv2.circle(frame, (60 + 40 * frame_idx, 120), 20, (0, 0, 255, 255), -1)
+            frames.append(frame)
+        writer = ReplayBundleWriter(self.path, lib_path=LIB_PATH)
+        for frame_idx, frame in enumerate(frames):
+            self.assertTrue(writer.write_overlay('replay', frame_idx, frame))
+        self.assertTrue(writer.close())
+
+        bundle = self.lib.rr_BundleOpen(self.path.encode())
+        track = self.lib.rr_BundleFindTrack(bundle, b'replay')
+
+        # Frames after the first are deltas, which cannot be opened without their keyframe
+        data = ctypes.c_void_p()
+        size = ctypes.c_int64()
+        self.assertTrue(self.lib.rr_BundleGetFrame(bundle, track, 3, ctypes.byref(data), ctypes.byref(size)))
+        self.assertFalse(self.lib.rr_OverlayOpen(data, size))
+
+        # Sequential frames interleaved with one-behind reads as prefetch issues them, then a backward jump
+        for frame_idx in [0, 1, 0, 2, 1, 3, 2, 4, 2]:
+            overlay = self.lib.rr_OverlayOpenFromBundle(bundle, track, frame_idx)
+            self.assertTrue(overlay)
+            np.testing.assert_array_equal(self.decode(overlay, frames[frame_idx].shape),
+                                          cv2.cvtColor(frames[frame_idx], cv2.COLOR_BGRA2RGBA))
+            self.lib.rr_OverlayDestroy(overlay)
+        self.assertFalse(self.lib.rr_OverlayOpenFromBundle(bundle, track, 5))
+        self.lib.rr_BundleClose(bundle)
+
+    def test_overlay_write_rejects_out_of_order_frames(self):
+        frame = overlay_frame(64, 64, blobs=0)
+        writer = ReplayBundleWriter(self.path, lib_path=LIB_PATH)
+        self.assertTrue(writer.write_overlay('replay', 0, frame))
+        self.assertTrue(writer.write_overlay('replay', 2, frame))
+        self.assertFalse(writer.write_overlay('replay', 1, frame))
+        self.assertFalse(writer.write_overlay('replay', 2, frame))
+        self.assertTrue(writer.write_overlay('replay', 3, frame))
+        self.assertTrue(writer.close())
+
+    def test_overlay_write_rejects_image_track(self):
+        writer = ReplayBundleWriter(self.path, lib_path=LIB_PATH)
+        writer.track('visualization', TRACK_IMAGE)
+        self.assertFalse(writer.write_overlay('visualization', 0, overlay_frame(64, 64, blobs=0)))
+        self.assertTrue(writer.close())
+
+
+if __name__ == '__main__':
+    unittest.main()
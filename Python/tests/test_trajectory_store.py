@@ -0,0 +1,48 @@
+import unittest
+
+from inference.trajectory_store import TrajectoryStore
+from tests.native import LIB_PATH, requires_native
+
+
+@requires_native
+class TrajectoryStoreTest(unittest.TestCase):
+    def setUp(self):
+        self.store = TrajectoryStore(lib_path=LIB_PATH)
+
+    def tearDown(self):
+        self.store.close()
+
+    def test_polyline_returns_centroids_up_to_time(self):
+        for time in range(4):
+            self.store.append('cup', time, (10 + time, 20), (0, 0, 30, 30))
+        self.store.append('hat', 1, (50, 60), (40, 50, 60, 70))
+
+        self.assertEqual(self.store.polyline('cup', 0, 2), [(10, 20), (11, 20), (12, 20)])
+        self.assertEqual(self.store.polyline('hat', 0, 2), [(50, 60)])
+        self.assertEqual(self.store.polyline('hat', 2, 3), [])
+        self.assertEqual(self.store.polyline('jar', 0, 3), [])
+        self.assertEqual(self.store.sample_count(), 5)
+
+    def test_out_of_order_samples_are_sorted(self):
+        self.store.append('cup', 3, (3, 0), (0, 0, 1, 1))
+        self.store.append('cup', 1, (1, 0), (0, 0, 1, 1))
+        self.store.append('cup', 2, (2, 0), (0, 0, 1, 1))
+
+        self.assertEqual(self.store.polyline('cup', 0, 3), [(1, 0), (2, 0), (3, 0)])
+
+    def test_tolerance_drops_collinear_points(self):
+        for time in range(5):
+            self.store.append('cup', time, (time * 10, 0), (0, 0, 1, 1))
+
+        self.assertEqual(self.store.polyline('cup', 0, 4, tolerance=1.0), [(0, 0), (40, 0)])
+
+    def test_clear_forgets_labels(self):
+        self.store.append('cup', 0, (1, 2), (0, 0, 1, 1))
+        self.store.clear()
+
+        self.assertEqual(self.store.sample_count(), 0)
+        self.assertEqual(self.store.labels(), [])
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -2,11 +2,10 @@
 using System.Collections;
 using System.Collections.Generic;
 using System.Linq;
-using System.Net.Sockets;
+using System.Runtime.InteropServices;
 using System.Text;
+using System.Threading;
 using UnityEngine;
-using UnityEngine.Networking;
-using static UnityEngine.Networking.NetworkTransport;
 
 namespace Assets.Script.Remote
 {
@@ -24,16 +23,51 @@ namespace Assets.Script.Remote
     }
 
     /// <summary>
-    /// Simple TCP Client that connects to the Python inference server.
+    /// Client of the Python inference server. Messages are multiplexed by ReplayApi (see MultiplexConnection.hpp):
+    /// commands and text replies use the control channel, frames the bulk channel, so a command is not queued behind
+    /// frames sent before it.
     /// </summary>
     public class Client : MonoBehaviour
     {
-        private TcpClient socket;
-        private NetworkStream stream;
+        private const string Library = "ReplayApi";
+
+        // Message received with rr_MultiplexReceive, see rr_Message in ReplayApi.h
+        [StructLayout(LayoutKind.Sequential)]
+        private struct NativeMessage
+        {
+            public IntPtr Data;
+            public long Size;
+            public uint Sequence;
+            public ushort Type;
+            public IntPtr Token;
+        }
+
+        [DllImport(Library)]
+        private static extern IntPtr rr_MultiplexConnect(string host, int port);
+
+        [DllImport(Library)]
+        private static extern void rr_MultiplexDestroy(IntPtr mux);
+
+        [DllImport(Library)]
+        private static extern int rr_MultiplexSend(IntPtr mux, int channel, ushort type, byte[] data, long size);
+
+        [DllImport(Library)]
+        private static extern int rr_MultiplexReceive(IntPtr mux, int channel, double timeout, out NativeMessage message);
+
+        [DllImport(Library)]
+        private static extern void rr_MessageRelease(ref NativeMessage message);
+
+        // Message types, see message_connection.py
+        public const ushort MessageText = 1;
+        public const ushort MessageImage = 2;
+
+        // Channels, see RR_CHANNEL_* in ReplayApi.h
+        private const int ChannelControl = 0;
+        private const int ChannelBulk = 2;
+
+        private IntPtr connection = IntPtr.Zero;
         private String bindIP = "localhost";
         //private String bindIP = "192.168.0.110";
-        //private int bindPort = 9998;
-        private Byte[] sizeBuffer = new Byte[4];
 
         private bool _connectedToServer = false;
 
@@ -43,12 +77,9 @@ namespace Assets.Script.Remote
         {
             try
             {
-                socket = new TcpClient();
-                socket.NoDelay = true;
-                socket.Connect(bindIP, port);
-                stream = socket.GetStream();
-                _connectedToServer = true;
-                Debug.Log("connected");
+                connection = rr_MultiplexConnect(bindIP, port);
+                _connectedToServer = connection != IntPtr.Zero;
+                Debug.Log(_connectedToServer ? "connected" : "connecting to server failed");
             }
             catch (Exception e)
             {
@@ -64,8 +95,9 @@ namespace Assets.Script.Remote
             }
 
             Debug.Log("closing connection to server");
-            stream.Close();
-            socket.Close();
+            _connectedToServer = false;
+            rr_MultiplexDestroy(connection);
+            connection = IntPtr.Zero;
         }
 
         protected void OnMessageAvailable(MessageAvailableEventArgs e)
@@ -108,254 +140,95 @@ namespace Assets.Script.Remote
                 return;
             }
 
-            // asynchronous read, calls the callback once data is available
-            stream.BeginRead(sizeBuffer, 0, sizeBuffer.Length, new AsyncCallback(ReadCallback), null);
-            Debug.Log("begin read finished");
-        }
-
-        private void ReadCallback(IAsyncResult ar)
-        {
-            // this blocks until the data is ready
-            int bytesRead = stream.EndRead(ar);
-
-            Debug.Log("end read finished " + bytesRead);
-
-            if (bytesRead != 2)
-                throw new InvalidOperationException("Invalid message header.");
-
-
-            int messageSize = BitConverter.ToInt32(sizeBuffer, 0);
-            //        int messageSize = BitConverter.ToInt32(sizeBuffer, 0);
-            Debug.Log("message size " + messageSize);
-
-            // now read the actual message
-            ReadMessage(messageSize);
-
-            // start listening again
-            ListenAsync();
-        }
-
-        private void ReadMessage(int messageSize)
-        {
-            try
+            // Receive blocks, so wait for the next message on a pool thread and listen again once it is handled
+            ThreadPool.QueueUserWorkItem(state =>
             {
-
-                int remainingLength = messageSize;
-                string serverMessage = "";
-
-                Debug.Log("getting message of size " + messageSize);
-
-                while (remainingLength > 0)
+                if (!Receive(ChannelControl, out _, out byte[] data))
                 {
-                    var incomingData = new Byte[remainingLength];
-                    int bytes_read = stream.Read(incomingData, 0, remainingLength);
-
-                    if (bytes_read > 0)
-                    {
-                        serverMessage += Encoding.ASCII.GetString(incomingData);
-                    }
-                    else
-                    {
-                        Debug.Log("something went wrong when reading data");
-                    }
-
-                    remainingLength -= bytes_read;
+                    Debug.Log("connection to server closed");
+                    return;
                 }
 
-                Debug.Log("read message " + serverMessage);
-
-                // do something with the servermessage here
-                OnMessageAvailable(new MessageAvailableEventArgs(serverMessage));
-            }
-
-            catch (SocketException socketException)
-            {
-                Debug.Log("Socket exception when receiving: " + socketException);
-            }
-
+                OnMessageAvailable(new MessageAvailableEventArgs(Encoding.ASCII.GetString(data)));
+                ListenAsync();
+            });
         }
 
         public string ListenSync()
         {
-            try
+            if (!Receive(ChannelControl, out _, out byte[] data))
             {
-
-                if (!_connectedToServer)
-                {
-                    return "";
-                }
-
-                Byte[] bytes = new Byte[4];
-                string serverMessage = "";
-
-                // Read first 4 bytes for length of the message
-                int length = stream.Read(bytes, 0, bytes.Length);
-                if (length == 4)
-                {
-                    int msgLength = BitConverter.ToInt32(bytes, 0);
-                    var allData = new List<Byte>();
-
-                    while (msgLength > 0)
-                    {
-                        var incomingData = new Byte[msgLength];
-                        int bytes_read = stream.Read(incomingData, 0, msgLength);
-                        // Debug.Log("Msg length read " + bytes_read);
-
-                        if (bytes_read > 0)
-                        {
-                            //serverMessage += Encoding.UTF8.GetString(incomingData);
-                            allData.AddRange(incomingData.Take(bytes_read));
-                        }
-                        else
-                        {
-                            Debug.Log("something went wrong when reading data");
-                        }
-
-                        msgLength -= bytes_read;
-                    }
-
-                    serverMessage = Encoding.UTF8.GetString(allData.ToArray());
-
-                }
-
-                return serverMessage;
+                return "";
             }
-            catch (SocketException socketException)
-            {
-                Debug.Log("Socket exception when receiving: " + socketException);
-            }
-            return "";
+            return Encoding.UTF8.GetString(data);
         }
 
-
         public byte[] ListenSyncRaw()
         {
-            try
+            if (!Receive(ChannelBulk, out _, out byte[] data))
             {
-
-                if (!_connectedToServer || !stream.CanRead)
-                {
-                    return new byte[0];
-                }
-
-                Byte[] bytes = new Byte[4];
-                var serverMessage = new List<Byte>();
-
-                try
-                {
-
-                    // Read first 4 bytes for length of the message
-                    int length = stream.Read(bytes, 0, bytes.Length);
-                    if (length == 4)
-                    {
-                        int msgLength = BitConverter.ToInt32(bytes, 0);
-
-                        while (msgLength > 0)
-                        {
-                            var incomingData = new Byte[msgLength];
-                            int bytes_read = stream.Read(incomingData, 0, msgLength);
-                            // Debug.Log("Msg length read " + bytes_read);
-
-                            if (bytes_read > 0)
-                            {
-                                //serverMessage += Encoding.UTF8.GetString(incomingData);
-                                serverMessage.AddRange(incomingData.Take(bytes_read));
-                            }
-                            else
-                            {
-                                Debug.Log("something went wrong when reading data");
-                            }
-
-                            msgLength -= bytes_read;
-                        }
-
-                    }
-
-                    return serverMessage.ToArray();
-                }
-                catch (Exception e)
-                {
-                    Debug.LogWarning("Exception when reading stream");
-                    Debug.LogWarning(e);
-                    return new byte[0];
-                }
+                return new byte[0];
             }
-            catch (SocketException socketException)
-            {
-                Debug.Log("Socket exception when receiving: " + socketException);
-            }
-
-            return new byte[0];
+            return data;
         }
 
-        public bool Send(string msg)
+        /// <summary>
+        /// Receive next message of channel, copied once out of the native receive buffer. Blocks. Returns false if
+        /// the connection is closed.
+        /// </summary>
+        private bool Receive(int channel, out ushort type, out byte[] data)
         {
-            if (socket == null || stream == null)
+            type = 0;
+            data = null;
+            if (!_connectedToServer)
             {
-                Debug.LogWarning("Could not send sync. Socket or stream null.");
                 return false;
             }
-            try
 
+            if (rr_MultiplexReceive(connection, channel, -1.0, out NativeMessage message) == 0)
             {
-                if (stream.CanWrite)
-                {
-                    // Convert string message to byte array
-                    byte[] clientMessageAsByteArray = Encoding.ASCII.GetBytes(msg);
-                    byte[] length = BitConverter.GetBytes((int)clientMessageAsByteArray.Length);
-
-                    var all = new byte[length.Length + clientMessageAsByteArray.Length];
-                    length.CopyTo(all, 0);
-                    clientMessageAsByteArray.CopyTo(all, length.Length);
-
-                    // Write byte array to socketConnection stream.                 
-                    stream.Write(all, 0, all.Length);
-                    return true;
-                }
-
+                Debug.LogWarning("Receiving message failed");
                 return false;
             }
-            catch (SocketException socketException)
+
+            try
             {
-                Debug.Log("Socket exception when sending: " + socketException);
-                return false;
+                type = message.Type;
+                data = new byte[message.Size];
+                if (message.Size > 0)
+                    Marshal.Copy(message.Data, data, 0, (int)message.Size);
+                return true;
+            }
+            finally
+            {
+                rr_MessageRelease(ref message);
             }
         }
 
+        public bool Send(string msg)
+        {
+            return Send(ChannelControl, MessageText, Encoding.ASCII.GetBytes(msg));
+        }
+
         public bool Send(byte[] buffer)
         {
-            if (socket == null || stream == null)
+            return Send(ChannelBulk, MessageImage, buffer);
+        }
+
+        private bool Send(int channel, ushort type, byte[] buffer)
+        {
+            if (!_connectedToServer)
             {
-                Debug.LogWarning("Could not send sync. Socket or stream null.");
+                Debug.LogWarning("Could not send sync. Not connected.");
                 return false;
             }
 
-            try
-            {
-                if (stream.CanWrite)
-                {
-                    // Convert string message to byte array
-                    byte[] bufferSize = BitConverter.GetBytes(buffer.Length);
-
-                    var all = new byte[bufferSize.Length + buffer.Length];
-                    bufferSize.CopyTo(all, 0);
-                    buffer.CopyTo(all, bufferSize.Length);
-
-                    // Write byte array to socketConnection stream.                 
-                    stream.BeginWrite(all, 0, all.Length, null, null);
-
-                    return true;
-                }
-                else
-                {
-                    return false;
-                }
-            }
-            catch (SocketException socketException)
+            if (rr_MultiplexSend(connection, channel, type, buffer, buffer.Length) == 0)
             {
-                Debug.Log("Socket exception when sending: " + socketException);
+                Debug.Log("Sending message failed");
                 return false;
             }
+            return true;
         }
 
     }
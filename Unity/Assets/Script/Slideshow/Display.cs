@@ -52,6 +52,13 @@ namespace Assets.Script.Controller
         private RenderTexture frameTex;
 
         private Dictionary<string, byte[]> vis_map;
+
+        // Native frame caches per visualization folder, vis_map holds the encoded files when the library is missing
+        private Dictionary<string, ReplayFrameCache> frameCaches;
+        public long frameCacheBudget = 512L * 1024 * 1024;
+        // Overlay tracks of the replay bundle shown by sub-rect uploads, the bundle stays open while they are used
+        private ReplayBundle replayBundle;
+        private Dictionary<string, ReplayOverlayTexture> overlayTextures;
         private Dictionary<string, Texture2D> combined_vis_map;
 
         public List<string> objList;
@@ -59,6 +66,9 @@ namespace Assets.Script.Controller
 
         private bool _started = false;
 
+        // Trace of the loaded overlay, logged once its texture is first shown
+        private FrameTrace pendingTrace;
+
         //Pads numbers to fit the image numbering standard
         string padNumbers(int i, int length)
         {
@@ -75,6 +85,70 @@ namespace Assets.Script.Controller
         }
 
 
+        // Loads slide i of visualization folder to texture from its frame cache, or decodes it from vis_map
+        bool loadSlide(string visFolder, string visPath, int i, Texture2D target)
+        {
+            ReplayFrameCache cache;
+            if (frameCaches.TryGetValue(visFolder, out cache) && cache.Load(i, target))
+            {
+                return true;
+            }
+
+            byte[] encoded;
+            if (vis_map.TryGetValue(visPath, out encoded))
+            {
+                bytes = encoded;
+                return target.LoadImage(encoded);
+            }
+            return false;
+        }
+
+        // Shows slide i of visualization folder through its overlay texture, uploading only changed tiles.
+        // Returns null if the folder has no overlay texture or the frame is missing.
+        Texture2D showOverlaySlide(string visFolder, int i)
+        {
+            ReplayOverlayTexture overlay;
+            if (overlayTextures.TryGetValue(visFolder, out overlay) && overlay.Show(i))
+            {
+                return overlay.Texture;
+            }
+            return null;
+        }
+
+        // Frame cache of visualization folder, from the detector replay bundle if it has the track
+        ReplayFrameCache createFrameCache(ReplayBundle bundle, string visName, string fileExt)
+        {
+            var cache = bundle != null ? ReplayFrameCache.Create(bundle, visName, frameCacheBudget) : null;
+            return cache ?? ReplayFrameCache.Create(file + "/" + visName + "/" + imagePrefix + "%04lld" + fileExt, frameCacheBudget);
+        }
+
+        // Overlay texture of visualization folder if the detector replay bundle has its overlay track
+        void addOverlayTexture(ReplayBundle bundle, string visName, string visFolder)
+        {
+            var overlay = bundle != null ? ReplayOverlayTexture.Create(bundle, visName) : null;
+            if (overlay != null)
+            {
+                overlayTextures[visFolder] = overlay;
+            }
+        }
+
+        void disposeFrameCaches()
+        {
+            foreach (var cache in frameCaches.Values)
+            {
+                cache.Dispose();
+            }
+            frameCaches.Clear();
+
+            foreach (var overlay in overlayTextures.Values)
+            {
+                overlay.Dispose();
+            }
+            overlayTextures.Clear();
+            replayBundle?.Dispose();
+            replayBundle = null;
+        }
+
         public void UpdateVisualizations()
         {
             string fileExt = ".png";
@@ -93,12 +167,7 @@ namespace Assets.Script.Controller
                         frame = new Texture2D(2, 2);
                         frame.hideFlags = HideFlags.HideAndDontSave;
                         vis_path = file + "/" + visualization + "_" + selObjList[0] + @"\" + imagePrefix + padNumbers(i, 4) + fileExt;
-                        try
-                        {
-                            bytes = vis_map[vis_path];
-                            frame.LoadImage(bytes);
-                        }
-                        catch
+                        if (!loadSlide(file + "/" + visualization + "_" + selObjList[0], vis_path, i, frame))
                         {
                             Debug.Log("file not found: " + vis_path);
                         }
@@ -106,16 +175,11 @@ namespace Assets.Script.Controller
                         for (var j = 1; j < selObjList.Count; j++)
                         {
                             vis_path = file + "/" + visualization + "_" + selObjList[j] + "/" + imagePrefix + padNumbers(j, 4) + fileExt;
-                            try
-                            {
-                                bytes = vis_map[vis_path];
-                            }
-                            catch
+                            Texture2D objTex = new Texture2D(2, 2);
+                            if (!loadSlide(file + "/" + visualization + "_" + selObjList[j], vis_path, j, objTex))
                             {
                                 Debug.Log("file not found: " + vis_path);
                             }
-                            Texture2D objTex = new Texture2D(2, 2);
-                            objTex.LoadImage(bytes);
 
                             int ix = 0;
                             Color[] objPixels = objTex.GetPixels();
@@ -168,6 +232,7 @@ namespace Assets.Script.Controller
 
             frame = new Texture2D(2, 2);
             frame.hideFlags = HideFlags.HideAndDontSave;
+            Texture2D shownTexture = frame;
 
             // Get texture
 
@@ -175,34 +240,38 @@ namespace Assets.Script.Controller
             {
                 vis_path = file + "/" + visualization + @"\" + imagePrefix + padNumbers(i, 4) + fileExt;
 
-                try
+                if (loadSlide(file + "/" + visualization, vis_path, i, frame))
                 {
-                    bytes = vis_map[vis_path];
                     print(vis_path);
                     print("Set Slide " + i);
                 }
-                catch
+                else
                 {
                     print("file not found: " + vis_path);
                     bytes = File.ReadAllBytes("../output/transparent.png");
+                    frame.LoadImage(bytes);
                 }
-                frame.LoadImage(bytes);
             }
             else if (visualization.Equals("visualization"))
             {
                 vis_path = file + "/" + visualization + @"\" + imagePrefix + padNumbers(i, 4) + fileExt;
-                try
+                Texture2D overlayTexture = showOverlaySlide(file + "/" + visualization, i);
+                if (overlayTexture != null)
+                {
+                    shownTexture = overlayTexture;
+                    print("Set Slide " + i);
+                }
+                else if (loadSlide(file + "/" + visualization, vis_path, i, frame))
                 {
-                    bytes = vis_map[vis_path];
                     print(vis_path);
                     print("Set Slide " + i);
                 }
-                catch
+                else
                 {
                     print("file not found: " + vis_path);
                     bytes = File.ReadAllBytes("../output/transparent.png");
+                    frame.LoadImage(bytes);
                 }
-                frame.LoadImage(bytes);
             }
             else
             {
@@ -210,14 +279,14 @@ namespace Assets.Script.Controller
                 if (selObjList.Count > 0)
                 {
                     vis_path = file + "/visualization_" + selObjList[0] + @"\" + imagePrefix + padNumbers(i, 4) + fileExt;
-                    try
+                    //bitmap = new Bitmap(vis_path);
+                    //graphics = System.Drawing.Graphics.FromImage(bitmap);
+                    Texture2D overlayTexture = selObjList.Count == 1 ? showOverlaySlide(file + "/visualization_" + selObjList[0], i) : null;
+                    if (overlayTexture != null)
                     {
-                        //bitmap = new Bitmap(vis_path);
-                        //graphics = System.Drawing.Graphics.FromImage(bitmap);
-                        bytes = vis_map[vis_path];
-                        frame.LoadImage(bytes);
+                        shownTexture = overlayTexture;
                     }
-                    catch
+                    else if (!loadSlide(file + "/visualization_" + selObjList[0], vis_path, i, frame))
                     {
                         Debug.Log("file not found: " + vis_path);
                     }
@@ -232,19 +301,12 @@ namespace Assets.Script.Controller
                     {
                         vis_path = file + "/visualization_" + selObjList[j] + @"\" + imagePrefix + padNumbers(i, 4) + fileExt;
 
-                        try
-                        {
-                            bytes = vis_map[vis_path];
-                        }
-                        catch
+                        Texture2D objTex = new Texture2D(2, 2);
+                        if (!loadSlide(file + "/visualization_" + selObjList[j], vis_path, i, objTex))
                         {
                             Debug.Log("file not found: " + vis_path);
                         }
 
-
-                        Texture2D objTex = new Texture2D(2, 2);
-                        objTex.LoadImage(bytes);
-
                         int ix = 0;
                         Color[] objPixels = objTex.GetPixels();
                         for (int y = 0; y < frame.height; y++)
@@ -275,7 +337,13 @@ namespace Assets.Script.Controller
 
             // Set the Texture you assign in the Inspector as the main texture (Or Albedo)
             //renderer.material.SetTexture("_MainTex", frameTex);
-            renderer.material.SetTexture("_MainTex", frame);
+            renderer.material.SetTexture("_MainTex", shownTexture);
+            if (pendingTrace != null)
+            {
+                pendingTrace.Stamp(FrameTrace.Stage.Upload);
+                pendingTrace.AppendToLog(file + "/latency.trace");
+                pendingTrace = null;
+            }
             //renderer.material.SetTextureScale("_MainTex", new Vector2(-1, 1));
             Resources.UnloadUnusedAssets();
             System.GC.Collect();
@@ -419,6 +487,8 @@ namespace Assets.Script.Controller
         void DoStart()
         {
             vis_map = new Dictionary<string, byte[]>();
+            frameCaches = new Dictionary<string, ReplayFrameCache>();
+            overlayTextures = new Dictionary<string, ReplayOverlayTexture>();
             combined_vis_map = new Dictionary<string, Texture2D>();
             //string file2 = file + '/' + visualization;
             ////figure out how many images in directory.
@@ -560,7 +630,9 @@ namespace Assets.Script.Controller
             string vis_path;
             string fileExt = ".png";
 
-
+            disposeFrameCaches();
+            var bundle = ReplayBundle.Open(file + "/replay.bundle");
+            replayBundle = bundle;
 
             for (int i = 0; i < visualizations.Length; i++)
             {
@@ -574,6 +646,13 @@ namespace Assets.Script.Controller
                     Debug.Log("visualizations: " + visualizations[i]);
                     fileExt = ".png";
                 }
+                addOverlayTexture(bundle, visualizations[i], vis_path);
+                var cache = createFrameCache(bundle, visualizations[i], fileExt);
+                if (cache != null)
+                {
+                    frameCaches[vis_path] = cache;
+                    continue;
+                }
                 string[] files = Directory.GetFiles(vis_path, "*", SearchOption.TopDirectoryOnly);
 
                 for (int j = 0; j < files.Length; j++)
@@ -589,6 +668,13 @@ namespace Assets.Script.Controller
             for (int i = 0; i < objList.Count; i++)
             {
                 vis_path = file + "/visualization_" + objList[i];
+                addOverlayTexture(bundle, "visualization_" + objList[i], vis_path);
+                var cache = createFrameCache(bundle, "visualization_" + objList[i], fileExt);
+                if (cache != null)
+                {
+                    frameCaches[vis_path] = cache;
+                    continue;
+                }
                 try
                 {
                     string[] files = Directory.GetFiles(vis_path, "*", SearchOption.TopDirectoryOnly);
@@ -612,6 +698,16 @@ namespace Assets.Script.Controller
                 }
             }
 
+            if (overlayTextures.Count == 0)
+            {
+                bundle?.Dispose();
+                replayBundle = null;
+            }
+
+            // Overlay trace is written by the detector next to the visualization folders
+            pendingTrace = FrameTrace.Read(file + "/overlay.trace");
+            pendingTrace?.Stamp(FrameTrace.Stage.Transport);
+
             GameObject objectBoard = GameObject.FindWithTag("ObjectBoard");
             GridObjectCollection objectBoardCollection = objectBoard.GetComponent<GridObjectCollection>();
             objectBoard.transform.rotation = Quaternion.identity;
@@ -729,6 +825,14 @@ namespace Assets.Script.Controller
 
 
 
+        void OnDestroy()
+        {
+            if (frameCaches != null)
+            {
+                disposeFrameCaches();
+            }
+        }
+
         void OnGUI()
         {
             //if (GUILayout.Button("Start server"))
@@ -0,0 +1,97 @@
+using System;
+using System.Diagnostics;
+using System.IO;
+
+namespace Assets.Script.Util
+{
+    // Frame id and timestamp envelope of a captured frame, matching FrameTrace.hpp in the recorder.
+    // The detector writes it next to the overlay images, Unity stamps transport and upload and appends it to the session log.
+    public class FrameTrace
+    {
+        public enum Stage
+        {
+            Exposure = 0,
+            Capture,
+            Publish,
+            Ingest,
+            Detection,
+            Visualization,
+            Transport,
+            Upload,
+            Count
+        }
+
+        public const int RecordSize = 88;
+        private const uint Magic = 0x43525446;
+        private const ushort Version = 1;
+
+        public long FrameNumber;
+        public long SensorTimestamp;
+        public long[] Stamps = new long[(int)Stage.Count];
+
+        // Monotonic clock in nanoseconds, same clock as the recorder and time.perf_counter_ns() in the detector.
+        // Split into seconds and remainder so the tick count does not overflow when scaled.
+        public static long Now()
+        {
+            long ticks = Stopwatch.GetTimestamp();
+            long frequency = Stopwatch.Frequency;
+            return (ticks / frequency) * 1000000000L + (ticks % frequency) * 1000000000L / frequency;
+        }
+
+        public void Stamp(Stage stage)
+        {
+            Stamps[(int)stage] = Now();
+        }
+
+        // Returns trace from sidecar file, null if missing or invalid
+        public static FrameTrace Read(string path)
+        {
+            if (!File.Exists(path))
+            {
+                return null;
+            }
+
+            try
+            {
+                using (var reader = new BinaryReader(File.OpenRead(path)))
+                {
+                    if (reader.BaseStream.Length < RecordSize || reader.ReadUInt32() != Magic || reader.ReadUInt16() != Version ||
+                        reader.ReadUInt16() != (ushort)Stage.Count)
+                    {
+                        return null;
+                    }
+
+                    var trace = new FrameTrace();
+                    trace.FrameNumber = reader.ReadInt64();
+                    trace.SensorTimestamp = reader.ReadInt64();
+                    for (int i = 0; i < trace.Stamps.Length; i++)
+                    {
+                        trace.Stamps[i] = reader.ReadInt64();
+                    }
+                    return trace;
+                }
+            }
+            catch (IOException)
+            {
+                return null;
+            }
+        }
+
+        // Appends trace to session trace log read by the latency collector
+        public void AppendToLog(string path)
+        {
+            using (var writer = new BinaryWriter(new FileStream(path, FileMode.Append, FileAccess.Write)))
+            {
+                writer.Write(Magic);
+                writer.Write(Version);
+                writer.Write((ushort)Stage.Count);
+                writer.Write(FrameNumber);
+                writer.Write(SensorTimestamp);
+                foreach (long stamp in Stamps)
+                {
+                    writer.Write(stamp);
+                }
+            }
+        }
+    }
+}
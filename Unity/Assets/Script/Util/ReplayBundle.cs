@@ -0,0 +1,82 @@
+using System;
+using System.IO;
+using System.Runtime.InteropServices;
+using UnityEngine;
+
+namespace Assets.Script.Util
+{
+    // Binding of the replay bundle reader in ReplayApi.dll.
+    // The detector writes all visualization tracks of a session to one bundle file, frames are decoded from the
+    // memory mapped bundle through ReplayFrameCache.
+    public class ReplayBundle : IDisposable
+    {
+        private const string Library = "ReplayApi";
+
+        [DllImport(Library)]
+        private static extern IntPtr rr_BundleOpen(string filename);
+
+        [DllImport(Library)]
+        private static extern void rr_BundleClose(IntPtr bundle);
+
+        [DllImport(Library)]
+        private static extern int rr_BundleFindTrack(IntPtr bundle, string name);
+
+        [DllImport(Library)]
+        private static extern int rr_BundleGetTrackType(IntPtr bundle, int track);
+
+        // Track types, see RR_TRACK_* in ReplayApi.h
+        public const int TrackImage = 0;
+        public const int TrackMask = 1;
+        public const int TrackOverlay = 2;
+        public const int TrackData = 3;
+
+        public IntPtr Handle { get; private set; }
+
+        private ReplayBundle(IntPtr handle)
+        {
+            Handle = handle;
+        }
+
+        // Returns opened bundle, null if the file or the native library is missing or the bundle is invalid
+        public static ReplayBundle Open(string filename)
+        {
+            if (!File.Exists(filename))
+            {
+                return null;
+            }
+
+            try
+            {
+                IntPtr handle = rr_BundleOpen(filename);
+                return handle != IntPtr.Zero ? new ReplayBundle(handle) : null;
+            }
+            catch (DllNotFoundException)
+            {
+                Debug.LogWarning("ReplayApi not found, ignoring replay bundle");
+                return null;
+            }
+        }
+
+        // Returns track id by name, -1 if not found
+        public int FindTrack(string name)
+        {
+            return Handle != IntPtr.Zero ? rr_BundleFindTrack(Handle, name) : -1;
+        }
+
+        // Returns track type, -1 if track is invalid
+        public int GetTrackType(int track)
+        {
+            return Handle != IntPtr.Zero ? rr_BundleGetTrackType(Handle, track) : -1;
+        }
+
+        // Frame caches created from the bundle keep it mapped, so the bundle may be disposed before them
+        public void Dispose()
+        {
+            if (Handle != IntPtr.Zero)
+            {
+                rr_BundleClose(Handle);
+                Handle = IntPtr.Zero;
+            }
+        }
+    }
+}
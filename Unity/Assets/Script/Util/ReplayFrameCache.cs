@@ -0,0 +1,115 @@
+using System;
+using System.Runtime.InteropServices;
+using UnityEngine;
+
+namespace Assets.Script.Util
+{
+    // Binding of the recorder frame cache in ReplayApi.dll.
+    // Frames are decoded and prefetched on native worker threads and uploaded as raw RGBA32 texture data, so scrubbing
+    // does not read and decode whole image files on the main thread.
+    public class ReplayFrameCache : IDisposable
+    {
+        private const string Library = "ReplayApi";
+
+        [StructLayout(LayoutKind.Sequential)]
+        private struct PinnedFrame
+        {
+            public IntPtr Pixels;
+            public int Width;
+            public int Height;
+            public long ByteSize;
+            public IntPtr Token;
+        }
+
+        [DllImport(Library)]
+        private static extern IntPtr rr_FrameCacheCreate(string pathFormat, long budgetBytes, int workerCount, int prefetchDepth);
+
+        [DllImport(Library)]
+        private static extern IntPtr rr_FrameCacheCreateFromBundle(IntPtr bundle, int track, long budgetBytes, int workerCount, int prefetchDepth);
+
+        [DllImport(Library)]
+        private static extern void rr_FrameCacheDestroy(IntPtr cache);
+
+        [DllImport(Library)]
+        private static extern int rr_FrameCacheAcquire(IntPtr cache, long index, ref PinnedFrame outFrame);
+
+        [DllImport(Library)]
+        private static extern void rr_FrameCacheRelease(ref PinnedFrame frame);
+
+        private IntPtr handle;
+
+        private ReplayFrameCache(IntPtr handle)
+        {
+            this.handle = handle;
+        }
+
+        // Returns cache of files from printf style path format, e.g. "out/visualization/%04lld.png".
+        // Null if the native library is missing or the cache could not be created.
+        public static ReplayFrameCache Create(string pathFormat, long budgetBytes, int workerCount = 2, int prefetchDepth = 4)
+        {
+            try
+            {
+                IntPtr handle = rr_FrameCacheCreate(pathFormat, budgetBytes, workerCount, prefetchDepth);
+                return handle != IntPtr.Zero ? new ReplayFrameCache(handle) : null;
+            }
+            catch (DllNotFoundException)
+            {
+                Debug.LogWarning("ReplayApi not found, loading frames without cache");
+                return null;
+            }
+        }
+
+        // Returns cache of named image or overlay track of bundle, null if the track is missing
+        public static ReplayFrameCache Create(ReplayBundle bundle, string track, long budgetBytes, int workerCount = 2, int prefetchDepth = 4)
+        {
+            int trackId = bundle.FindTrack(track);
+            if (trackId < 0)
+            {
+                return null;
+            }
+
+            IntPtr handle = rr_FrameCacheCreateFromBundle(bundle.Handle, trackId, budgetBytes, workerCount, prefetchDepth);
+            return handle != IntPtr.Zero ? new ReplayFrameCache(handle) : null;
+        }
+
+        // Loads frame to texture, resizing it to RGBA32 without mipmaps if needed. Returns false if frame could not be decoded.
+        public bool Load(long index, Texture2D texture)
+        {
+            if (handle == IntPtr.Zero)
+            {
+                return false;
+            }
+
+            var frame = new PinnedFrame();
+            if (rr_FrameCacheAcquire(handle, index, ref frame) == 0)
+            {
+                return false;
+            }
+
+            try
+            {
+                if (texture.width != frame.Width || texture.height != frame.Height || texture.format != TextureFormat.RGBA32 ||
+                    texture.mipmapCount != 1)
+                {
+                    texture.Resize(frame.Width, frame.Height, TextureFormat.RGBA32, false);
+                }
+                texture.LoadRawTextureData(frame.Pixels, (int)frame.ByteSize);
+                texture.Apply(false);
+            }
+            finally
+            {
+                rr_FrameCacheRelease(ref frame);
+            }
+            return true;
+        }
+
+        public void Dispose()
+        {
+            if (handle != IntPtr.Zero)
+            {
+                rr_FrameCacheDestroy(handle);
+                handle = IntPtr.Zero;
+            }
+        }
+    }
+}
@@ -0,0 +1,116 @@
+using System;
+using System.Runtime.InteropServices;
+using UnityEngine;
+using UnityEngine.Rendering;
+
+namespace Assets.Script.Util
+{
+    // Binding of the sparse tiled overlay upload in ReplayApi.dll.
+    // Shows frames of a bundle overlay track in one persistent texture. Only the tiles occupied in the new frame, and
+    // the tiles left over from the shown frame, are uploaded as D3D11 sub-rects on the render thread.
+    public class ReplayOverlayTexture : IDisposable
+    {
+        private const string Library = "ReplayApi";
+
+        [DllImport(Library)]
+        private static extern IntPtr rr_OverlayOpenFromBundle(IntPtr bundle, int track, long frameIndex);
+
+        [DllImport(Library)]
+        private static extern void rr_OverlayDestroy(IntPtr overlay);
+
+        [DllImport(Library)]
+        private static extern int rr_OverlayGetSize(IntPtr overlay, out int outWidth, out int outHeight);
+
+        [DllImport(Library)]
+        private static extern int rr_OverlayQueueUploadD3D11(IntPtr overlay, IntPtr previous, IntPtr texture);
+
+        [DllImport(Library)]
+        private static extern IntPtr rr_OverlayGetRenderEventFunc();
+
+        private readonly ReplayBundle bundle;
+        private readonly int track;
+        private readonly IntPtr renderEvent;
+        private IntPtr shown;
+
+        public Texture2D Texture { get; private set; }
+
+        private ReplayOverlayTexture(ReplayBundle bundle, int track, IntPtr renderEvent)
+        {
+            this.bundle = bundle;
+            this.track = track;
+            this.renderEvent = renderEvent;
+        }
+
+        // Returns texture of named bundle overlay track, null if there is no such track or the graphics API is not D3D11.
+        // The bundle must stay open while frames are shown.
+        public static ReplayOverlayTexture Create(ReplayBundle bundle, string track)
+        {
+            if (SystemInfo.graphicsDeviceType != GraphicsDeviceType.Direct3D11)
+            {
+                return null;
+            }
+
+            int trackId = bundle.FindTrack(track);
+            if (trackId < 0 || bundle.GetTrackType(trackId) != ReplayBundle.TrackOverlay)
+            {
+                return null;
+            }
+            return new ReplayOverlayTexture(bundle, trackId, rr_OverlayGetRenderEventFunc());
+        }
+
+        // Shows frame in texture. Delta frames are reconstructed natively, sequential frames cost one delta each.
+        // Returns false if the frame is missing or invalid, the texture then still shows the previous frame.
+        public bool Show(long frameIndex)
+        {
+            if (bundle.Handle == IntPtr.Zero)
+            {
+                return false;
+            }
+
+            IntPtr overlay = rr_OverlayOpenFromBundle(bundle.Handle, track, frameIndex);
+            int width, height;
+            if (overlay == IntPtr.Zero || rr_OverlayGetSize(overlay, out width, out height) == 0)
+            {
+                rr_OverlayDestroy(overlay);
+                return false;
+            }
+
+            // Tile uploads need a cleared texture of frame size to start from
+            if (Texture == null || Texture.width != width || Texture.height != height)
+            {
+                if (Texture != null)
+                {
+                    UnityEngine.Object.Destroy(Texture);
+                }
+                Texture = new Texture2D(width, height, TextureFormat.RGBA32, false);
+                Texture.hideFlags = HideFlags.HideAndDontSave;
+                Texture.LoadRawTextureData(new byte[width * height * 4]);
+                Texture.Apply(false);
+                rr_OverlayDestroy(shown);
+                shown = IntPtr.Zero;
+            }
+
+            if (rr_OverlayQueueUploadD3D11(overlay, shown, Texture.GetNativeTexturePtr()) == 0)
+            {
+                rr_OverlayDestroy(overlay);
+                return false;
+            }
+            GL.IssuePluginEvent(renderEvent, 0);
+
+            rr_OverlayDestroy(shown);
+            shown = overlay;
+            return true;
+        }
+
+        public void Dispose()
+        {
+            rr_OverlayDestroy(shown);
+            shown = IntPtr.Zero;
+            if (Texture != null)
+            {
+                UnityEngine.Object.Destroy(Texture);
+                Texture = null;
+            }
+        }
+    }
+}
@@ -0,0 +1,74 @@
+// Standalone runner for CaptureBenchmark, no headset or Varjo runtime needed.
+//
+// Usage: CaptureBenchmark [--width N] [--height N] [--cubemap N] [--min-seconds S] [--min-iterations N] [--threads N]
+//                         [--pin] [--filter PARTS] [--output-dir DIR] [--json FILE]
+//
+// PARTS is a comma separated list of case name parts, e.g. "scaling/,jobLatency/" for the JobSystem cases.
+// Results are written as Google Benchmark JSON to FILE, capture_benchmark.json by default. Progress is logged to
+// stdout. Exit code is nonzero if a case failed.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "CaptureBenchmark.hpp"
+
+namespace
+{
+using VarjoExamples::CaptureBenchmark;
+
+void printUsage()
+{
+    printf(
+        "Usage: CaptureBenchmark [--width N] [--height N] [--cubemap N] [--min-seconds S] [--min-iterations N] [--threads N]\n"
+        "                        [--pin] [--filter PARTS] [--output-dir DIR] [--json FILE]\n");
+}
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+    CaptureBenchmark::Config config;
+    std::string jsonFilename = "capture_benchmark.json";
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (!strcmp(arg, "--pin")) {
+            config.pinWorkers = true;
+        } else if (!strcmp(arg, "--help") || !strcmp(arg, "-h")) {
+            printUsage();
+            return EXIT_SUCCESS;
+        } else if (hasValue && !strcmp(arg, "--width")) {
+            config.width = atoi(argv[++i]);
+        } else if (hasValue && !strcmp(arg, "--height")) {
+            config.height = atoi(argv[++i]);
+        } else if (hasValue && !strcmp(arg, "--cubemap")) {
+            config.cubemapSize = atoi(argv[++i]);
+        } else if (hasValue && !strcmp(arg, "--min-seconds")) {
+            config.minSeconds = atof(argv[++i]);
+        } else if (hasValue && !strcmp(arg, "--min-iterations")) {
+            config.minIterations = atoi(argv[++i]);
+        } else if (hasValue && !strcmp(arg, "--threads")) {
+            config.maxThreads = atoi(argv[++i]);
+        } else if (hasValue && !strcmp(arg, "--filter")) {
+            config.filter = argv[++i];
+        } else if (hasValue && !strcmp(arg, "--output-dir")) {
+            config.outputDirectory = argv[++i];
+        } else if (hasValue && !strcmp(arg, "--json")) {
+            jsonFilename = argv[++i];
+        } else {
+            fprintf(stderr, "Invalid argument: %s\n", arg);
+            printUsage();
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (config.width <= 0 || config.height <= 0 || config.cubemapSize <= 0 || config.minIterations <= 0) {
+        fprintf(stderr, "Sizes and iteration count must be positive\n");
+        return EXIT_FAILURE;
+    }
+
+    return CaptureBenchmark::runToFile(config, jsonFilename) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
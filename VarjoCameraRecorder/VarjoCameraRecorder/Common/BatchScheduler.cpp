@@ -0,0 +1,306 @@
+#include "BatchScheduler.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+// Staging buffer alignment
+constexpr size_t c_pageSize = 4096;
+
+// Weight of latest batch in smoothed inference time
+constexpr double c_inferenceSmoothing = 0.2;
+
+// Return seconds between time points
+inline double secondsBetween(VarjoExamples::BatchScheduler::Clock::time_point from, VarjoExamples::BatchScheduler::Clock::time_point to)
+{
+    return std::chrono::duration<double>(to - from).count();
+}
+
+}  // namespace
+
+namespace VarjoExamples
+{
+BatchScheduler::BatchScheduler(const Config& config)
+    : m_config(config)
+{
+    if (config.itemBytes == 0 || config.maxBatchSize <= 0 || config.stagingCount <= 0) {
+        CRITICAL("Invalid batch configuration: itemBytes=%zu, maxBatchSize=%d, stagingCount=%d", config.itemBytes, config.maxBatchSize,
+            config.stagingCount);
+    }
+
+    m_staging.resize(config.stagingCount);
+    for (int i = 0; i < config.stagingCount; i++) {
+        Staging& staging = m_staging[i];
+        staging.storage.resize(getStagingSize() + c_pageSize);
+        const uintptr_t address = reinterpret_cast<uintptr_t>(staging.storage.data());
+        staging.data = staging.storage.data() + ((c_pageSize - address % c_pageSize) % c_pageSize);
+        staging.ids.reserve(config.maxBatchSize);
+        staging.submitTimes.reserve(config.maxBatchSize);
+        m_free.push_back(i);
+    }
+    m_inferenceTime.resize(config.maxBatchSize + 1, 0.0);
+
+    m_thread = std::thread(&BatchScheduler::schedulerLoop, this);
+}
+
+BatchScheduler::~BatchScheduler()
+{
+    stop();
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+void BatchScheduler::submit(uint64_t id, const uint8_t* input, size_t inputSize)
+{
+    Request request;
+    request.id = id;
+    request.input.assign(input, input + inputSize);
+    request.submitTime = Clock::now();
+
+    std::vector<uint64_t> dropped;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stats.submitted++;
+        if (m_stop) {
+            dropped.push_back(id);
+        } else {
+            while (!m_pending.empty() && m_pending.size() >= std::max<size_t>(m_config.maxPending, 1)) {
+                dropped.push_back(m_pending.front().id);
+                m_pending.pop_front();
+            }
+            m_pending.push_back(std::move(request));
+        }
+        m_stats.dropped += dropped.size();
+    }
+    m_requestCondition.notify_all();
+
+    if (m_config.resultCallback) {
+        for (const uint64_t droppedId : dropped) {
+            m_config.resultCallback(droppedId, false, nullptr, 0, 0.0);
+        }
+    }
+}
+
+bool BatchScheduler::acquireBatch(Batch& outBatch, double timeoutSeconds)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    const auto ready = [&] { return m_stop || !m_ready.empty(); };
+    if (timeoutSeconds < 0.0) {
+        m_batchCondition.wait(lock, ready);
+    } else if (!m_batchCondition.wait_for(lock, std::chrono::duration<double>(timeoutSeconds), ready)) {
+        return false;
+    }
+    if (m_ready.empty()) {
+        return false;
+    }
+
+    const int index = m_ready.front();
+    m_ready.pop_front();
+    m_inFlight.push_back(index);
+
+    Staging& staging = m_staging[index];
+    staging.acquireTime = Clock::now();
+    outBatch.batchId = staging.batchId;
+    outBatch.count = static_cast<int>(staging.ids.size());
+    outBatch.data = staging.data;
+    outBatch.itemBytes = m_config.itemBytes;
+    outBatch.ids = staging.ids;
+    return true;
+}
+
+void BatchScheduler::completeBatch(uint64_t batchId, const uint8_t* results, size_t resultStride)
+{
+    std::vector<uint64_t> ids;
+    std::vector<double> latencies;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = std::find_if(m_inFlight.begin(), m_inFlight.end(), [&](int index) { return m_staging[index].batchId == batchId; });
+        if (it == m_inFlight.end()) {
+            LOG_WARNING("Completed batch not in flight: id=%llu", batchId);
+            return;
+        }
+
+        const int index = *it;
+        m_inFlight.erase(it);
+        Staging& staging = m_staging[index];
+        const auto now = Clock::now();
+
+        // Smoothed inference time per batch size drives batch closing
+        const int count = static_cast<int>(staging.ids.size());
+        const double inference = secondsBetween(staging.acquireTime, now);
+        double& smoothed = m_inferenceTime[count];
+        smoothed = smoothed > 0.0 ? smoothed + (inference - smoothed) * c_inferenceSmoothing : inference;
+
+        ids = staging.ids;
+        for (const auto& submitTime : staging.submitTimes) {
+            const double latency = secondsBetween(submitTime, now);
+            latencies.push_back(latency);
+            m_latencySum += latency;
+            m_stats.maxLatencySeconds = std::max(m_stats.maxLatencySeconds, latency);
+            if (latency > m_config.latencyBoundSeconds) {
+                m_stats.overBound++;
+            }
+        }
+
+        m_inferenceSum += inference;
+        m_stats.batches++;
+        m_stats.completed += count;
+        m_stats.meanBatchSize = static_cast<double>(m_stats.completed) / m_stats.batches;
+        m_stats.meanLatencySeconds = m_latencySum / m_stats.completed;
+        m_stats.meanInferenceSeconds = m_inferenceSum / m_stats.batches;
+        m_free.push_back(index);
+    }
+    m_requestCondition.notify_all();
+
+    if (m_config.resultCallback) {
+        for (size_t i = 0; i < ids.size(); i++) {
+            m_config.resultCallback(ids[i], true, results ? results + i * resultStride : nullptr, results ? resultStride : 0, latencies[i]);
+        }
+    }
+}
+
+std::vector<uint8_t*> BatchScheduler::getStagingBuffers() const
+{
+    std::vector<uint8_t*> buffers;
+    for (const auto& staging : m_staging) {
+        buffers.push_back(staging.data);
+    }
+    return buffers;
+}
+
+void BatchScheduler::stop()
+{
+    std::vector<uint64_t> dropped;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+        for (const auto& request : m_pending) {
+            dropped.push_back(request.id);
+        }
+        m_pending.clear();
+        m_stats.dropped += dropped.size();
+    }
+    m_requestCondition.notify_all();
+    m_batchCondition.notify_all();
+
+    if (m_config.resultCallback) {
+        for (const uint64_t id : dropped) {
+            m_config.resultCallback(id, false, nullptr, 0, 0.0);
+        }
+    }
+}
+
+BatchScheduler::Stats BatchScheduler::getStats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+void BatchScheduler::schedulerLoop()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        m_requestCondition.wait(lock, [&] { return m_stop || (!m_pending.empty() && !m_free.empty()); });
+        if (m_stop) {
+            break;
+        }
+
+        // Staging buffer is owned by this thread until the batch closes
+        const int index = m_free.front();
+        m_free.pop_front();
+        Staging& staging = m_staging[index];
+        staging.ids.clear();
+        staging.submitTimes.clear();
+
+        while (!m_stop && static_cast<int>(staging.ids.size()) < m_config.maxBatchSize) {
+            if (m_pending.empty()) {
+                const auto hasRequest = [&] { return m_stop || !m_pending.empty(); };
+                if (staging.ids.empty()) {
+                    m_requestCondition.wait(lock, hasRequest);
+                    continue;
+                }
+
+                // Close batch when waiting longer would take oldest request over latency bound
+                const int count = static_cast<int>(staging.ids.size());
+                const double budget = std::min(m_config.maxDelaySeconds, m_config.latencyBoundSeconds - predictInference(count + 1));
+                const auto deadline = staging.submitTimes.front() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(budget));
+                if (!m_requestCondition.wait_until(lock, deadline, hasRequest)) {
+                    break;
+                }
+                continue;
+            }
+
+            Request request = std::move(m_pending.front());
+            m_pending.pop_front();
+            uint8_t* slot = staging.data + staging.ids.size() * m_config.itemBytes;
+
+            // Preprocess without lock, overlapping with inference of previous batch
+            lock.unlock();
+            bool preprocessed = true;
+            if (m_config.preprocess) {
+                preprocessed = m_config.preprocess(request.id, request.input.data(), request.input.size(), slot);
+            } else {
+                const size_t size = std::min(request.input.size(), m_config.itemBytes);
+                memcpy(slot, request.input.data(), size);
+                memset(slot + size, 0, m_config.itemBytes - size);
+            }
+            if (!preprocessed && m_config.resultCallback) {
+                m_config.resultCallback(request.id, false, nullptr, 0, 0.0);
+            }
+            lock.lock();
+
+            if (preprocessed) {
+                staging.ids.push_back(request.id);
+                staging.submitTimes.push_back(request.submitTime);
+            } else {
+                m_stats.dropped++;
+            }
+        }
+
+        if (m_stop) {
+            // Requests of unfinished batch get no result
+            const std::vector<uint64_t> dropped = staging.ids;
+            m_stats.dropped += dropped.size();
+            m_free.push_front(index);
+            lock.unlock();
+            if (m_config.resultCallback) {
+                for (const uint64_t id : dropped) {
+                    m_config.resultCallback(id, false, nullptr, 0, 0.0);
+                }
+            }
+            lock.lock();
+            break;
+        }
+
+        if (staging.ids.empty()) {
+            m_free.push_front(index);
+            continue;
+        }
+
+        staging.batchId = m_nextBatchId++;
+        m_ready.push_back(index);
+        m_batchCondition.notify_one();
+    }
+}
+
+double BatchScheduler::predictInference(int count) const
+{
+    count = std::min(count, m_config.maxBatchSize);
+    if (m_inferenceTime[count] > 0.0) {
+        return m_inferenceTime[count];
+    }
+
+    // Scale time of nearest measured batch size
+    for (int distance = 1; distance <= m_config.maxBatchSize; distance++) {
+        for (const int size : {count - distance, count + distance}) {
+            if (size > 0 && size <= m_config.maxBatchSize && m_inferenceTime[size] > 0.0) {
+                return m_inferenceTime[size] * count / size;
+            }
+        }
+    }
+    return 0.0;
+}
+
+}  // namespace VarjoExamples
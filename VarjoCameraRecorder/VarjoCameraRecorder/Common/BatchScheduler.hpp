@@ -0,0 +1,146 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Globals.hpp"
+
+namespace VarjoExamples
+{
+//! Micro-batching scheduler in front of a model call.
+//!
+//! Requests submitted from any thread are preprocessed by a scheduler thread directly into fixed size slots of a
+//! staging buffer. A batch closes when it is full or when waiting longer would push its oldest request over the
+//! latency bound, using the measured inference time of batches of that size. The inference thread acquires closed
+//! batches, runs the model on the staging buffer and completes the batch, which routes results back by request id.
+//! With two or more staging buffers the next batch is preprocessed while the current one is in inference. Staging
+//! buffers are page aligned and never reallocated, so they can be registered once as pinned memory for transfers.
+class BatchScheduler
+{
+public:
+    //! Clock for latencies
+    using Clock = std::chrono::steady_clock;
+
+    //! Preprocess function writing request input into staging slot of itemBytes. Called on scheduler thread.
+    using Preprocess = std::function<bool(uint64_t id, const uint8_t* input, size_t inputSize, uint8_t* slot)>;
+
+    //! Result function with request id, completion flag, result data if given, and latency from submit in seconds.
+    //! Called once per request; dropped requests are not completed.
+    using ResultCallback = std::function<void(uint64_t id, bool completed, const uint8_t* result, size_t resultSize, double latencySeconds)>;
+
+    //! Scheduler configuration
+    struct Config {
+        size_t itemBytes = 0;              //!< Staging slot size of one request
+        int maxBatchSize = 8;              //!< Largest batch
+        int stagingCount = 2;              //!< Staging buffers, two or more overlap preprocessing with inference
+        double latencyBoundSeconds = 0.1;  //!< Bound for submit to completion latency
+        double maxDelaySeconds = 0.05;     //!< Longest time a batch waits for more requests
+        size_t maxPending = 64;            //!< Submitted requests waiting for a batch, oldest are dropped over this
+        Preprocess preprocess;             //!< Input preprocessing, copies input if empty
+        ResultCallback resultCallback;     //!< Result routing, may be empty
+    };
+
+    //! Batch ready for inference. Staging data stays valid until completeBatch().
+    struct Batch {
+        uint64_t batchId = 0;       //!< Batch id for completion
+        int count = 0;              //!< Requests in batch
+        uint8_t* data = nullptr;    //!< Staging buffer, count slots of itemBytes
+        size_t itemBytes = 0;       //!< Slot size in bytes
+        std::vector<uint64_t> ids;  //!< Request ids in slot order
+    };
+
+    //! Scheduler statistics
+    struct Stats {
+        uint64_t submitted = 0;             //!< Requests submitted
+        uint64_t dropped = 0;               //!< Requests dropped by pending limit or failed preprocessing
+        uint64_t completed = 0;             //!< Requests completed
+        uint64_t batches = 0;               //!< Batches completed
+        double meanBatchSize = 0.0;         //!< Mean requests per completed batch
+        double meanLatencySeconds = 0.0;    //!< Mean submit to completion latency
+        double maxLatencySeconds = 0.0;     //!< Largest submit to completion latency
+        uint64_t overBound = 0;             //!< Requests completed over latency bound
+        double meanInferenceSeconds = 0.0;  //!< Mean acquire to completion time of batches
+    };
+
+    //! Construct scheduler and start scheduler thread. Throws on failure.
+    BatchScheduler(const Config& config);
+
+    //! Destruct scheduler. Stops scheduler thread.
+    ~BatchScheduler();
+
+    // Disable copy, move and assign
+    BatchScheduler(const BatchScheduler& other) = delete;
+    BatchScheduler(const BatchScheduler&& other) = delete;
+    BatchScheduler& operator=(const BatchScheduler& other) = delete;
+    BatchScheduler& operator=(const BatchScheduler&& other) = delete;
+
+    //! Submit request with input copied for preprocessing
+    void submit(uint64_t id, const uint8_t* input, size_t inputSize);
+
+    //! Acquire next closed batch, waiting up to timeout seconds, negative waits forever. Returns false on timeout or stop.
+    bool acquireBatch(Batch& outBatch, double timeoutSeconds = -1.0);
+
+    //! Complete acquired batch. Results, if given, are count entries of resultStride bytes routed to result callback.
+    void completeBatch(uint64_t batchId, const uint8_t* results = nullptr, size_t resultStride = 0);
+
+    //! Return staging buffer pointers for registering them as pinned memory
+    std::vector<uint8_t*> getStagingBuffers() const;
+
+    //! Return size of each staging buffer in bytes
+    size_t getStagingSize() const { return m_config.itemBytes * m_config.maxBatchSize; }
+
+    //! Stop scheduler. Wakes threads waiting in acquireBatch().
+    void stop();
+
+    //! Return scheduler statistics
+    Stats getStats() const;
+
+private:
+    //! Submitted request
+    struct Request {
+        uint64_t id = 0;               //!< Request id
+        std::vector<uint8_t> input;    //!< Input data
+        Clock::time_point submitTime;  //!< Submit time
+    };
+
+    //! Staging buffer with batch being built or processed
+    struct Staging {
+        uint8_t* data = nullptr;                     //!< Aligned slots within storage
+        std::vector<uint8_t> storage;                //!< Allocation
+        uint64_t batchId = 0;                        //!< Current batch id
+        std::vector<uint64_t> ids;                   //!< Request ids in slot order
+        std::vector<Clock::time_point> submitTimes;  //!< Submit times in slot order
+        Clock::time_point acquireTime;               //!< Time batch was acquired
+    };
+
+    //! Scheduler thread main loop
+    void schedulerLoop();
+
+    //! Predicted inference time of batch with given size. Requires lock.
+    double predictInference(int count) const;
+
+private:
+    const Config m_config;                       //!< Scheduler configuration
+    mutable std::mutex m_mutex;                  //!< Lock for scheduler state
+    std::condition_variable m_requestCondition;  //!< Signaled on submit, free staging or stop
+    std::condition_variable m_batchCondition;    //!< Signaled when a batch closes or on stop
+    std::thread m_thread;                        //!< Scheduler thread
+    bool m_stop = false;                         //!< Stop flag
+    std::deque<Request> m_pending;               //!< Requests waiting for a batch
+    std::vector<Staging> m_staging;              //!< Staging buffers
+    std::deque<int> m_free;                      //!< Free staging buffer indices
+    std::deque<int> m_ready;                     //!< Closed batches in order
+    std::vector<int> m_inFlight;                 //!< Acquired staging buffer indices
+    uint64_t m_nextBatchId = 1;                  //!< Next batch id
+    std::vector<double> m_inferenceTime;         //!< Smoothed inference time by batch size, zero if unknown
+    double m_latencySum = 0.0;                   //!< Sum of request latencies
+    double m_inferenceSum = 0.0;                 //!< Sum of batch inference times
+    Stats m_stats;                               //!< Scheduler statistics
+};
+
+}  // namespace VarjoExamples
@@ -0,0 +1,530 @@
+#include "CaptureBenchmark.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <thread>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#include <glm/gtc/packing.hpp>
+
+#include "DataStreamer.hpp"
+#include "EquirectConverter.hpp"
+#include "FovealCapture.hpp"
+#include "FrameConversion.hpp"
+#include "JobSystem.hpp"
+#include "JpegEncoder.hpp"
+#include "QoiCodec.hpp"
+
+namespace
+{
+using Clock = std::chrono::high_resolution_clock;
+using Case = VarjoExamples::CaptureBenchmark::Case;
+using Config = VarjoExamples::CaptureBenchmark::Config;
+
+// Pose lookups per measured iteration, single lookups are below timer resolution
+constexpr int c_poseBatch = 1000;
+
+// Color stream frame rate for concurrent callback
+constexpr double c_streamFrameRate = 90.0;
+
+// JPEG quality, the TurboJPEG default the inference server encodes frames with
+constexpr int c_jpegQuality = 85;
+
+// Color frames between stored snapshots, as in DataStreamer::storeBuffer
+constexpr int c_snapshotInterval = 60;
+
+// Pause between pose lookups measured against concurrent callback
+constexpr auto c_poseLookupInterval = std::chrono::microseconds(500);
+
+// Bulk jobs kept queued per worker for latency lane cases
+constexpr int c_bulkJobsPerWorker = 2;
+
+// Synthetic stream buffer
+struct SyntheticBuffer {
+    varjo_BufferMetadata metadata{};  // Buffer metadata
+    std::vector<uint8_t> data;        // CPU data
+};
+
+// Create buffer with gradient and sensor like noise, so encoders see realistic entropy
+SyntheticBuffer createBuffer(varjo_TextureFormat format, int width, int height)
+{
+    SyntheticBuffer buffer;
+    buffer.metadata.format = format;
+    buffer.metadata.type = varjo_BufferType_CPU;
+    buffer.metadata.width = width;
+    buffer.metadata.height = height;
+    buffer.metadata.rowStride = (format == varjo_TextureFormat_RGBA16_FLOAT) ? width * 4 * static_cast<int>(sizeof(uint16_t)) : (width + 63) & ~63;
+    buffer.data.resize(VarjoExamples::getBufferDataSize(format, height, buffer.metadata.rowStride));
+    buffer.metadata.byteSize = static_cast<int32_t>(buffer.data.size());
+
+    uint32_t seed = 12345;
+    const auto noise = [&seed] {
+        seed = seed * 1664525u + 1013904223u;
+        return static_cast<int>(seed >> 28) - 8;
+    };
+
+    if (format == varjo_TextureFormat_RGBA16_FLOAT) {
+        for (int y = 0; y < height; y++) {
+            uint16_t* row = reinterpret_cast<uint16_t*>(buffer.data.data() + static_cast<size_t>(y) * buffer.metadata.rowStride);
+            for (int x = 0; x < width; x++) {
+                const float value = static_cast<float>((x + y) % 256 + noise()) / 255.0f;
+                row[x * 4 + 0] = glm::packHalf1x16(std::max(value, 0.0f) * 2.0f);
+                row[x * 4 + 1] = glm::packHalf1x16(std::max(value, 0.0f));
+                row[x * 4 + 2] = glm::packHalf1x16(std::max(value, 0.0f) * 0.5f);
+                row[x * 4 + 3] = glm::packHalf1x16(1.0f);
+            }
+        }
+    } else {
+        for (size_t i = 0; i < buffer.data.size(); i++) {
+            const size_t x = i % buffer.metadata.rowStride;
+            const size_t y = i / buffer.metadata.rowStride;
+            buffer.data[i] = static_cast<uint8_t>(std::max(0, std::min(255, static_cast<int>((x / 4 + y / 3) % 200) + 28 + noise())));
+        }
+    }
+    return buffer;
+}
+
+// Return CPU time of calling thread in seconds. Like Google Benchmark, cases report CPU time of the measuring thread
+// only, so work handed to other threads shows as real time above CPU time.
+double getThreadCpuSeconds()
+{
+#if defined(_WIN32)
+    FILETIME creationTime, exitTime, kernelTime, userTime;
+    if (!GetThreadTimes(GetCurrentThread(), &creationTime, &exitTime, &kernelTime, &userTime)) {
+        return 0.0;
+    }
+    const auto toSeconds = [](const FILETIME& time) {
+        return static_cast<double>((static_cast<uint64_t>(time.dwHighDateTime) << 32) | time.dwLowDateTime) * 1e-7;
+    };
+    return toSeconds(kernelTime) + toSeconds(userTime);
+#else
+    timespec time{};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+    return static_cast<double>(time.tv_sec) + static_cast<double>(time.tv_nsec) * 1e-9;
+#endif
+}
+
+// Compute case statistics from iteration times and CPU time spent on all of them
+Case makeCase(const std::string& name, std::vector<double>& times, double cpuSeconds, double bytes, double items)
+{
+    Case result;
+    result.name = name;
+    result.iterations = static_cast<int64_t>(times.size());
+    if (times.empty()) {
+        return result;
+    }
+
+    double sum = 0.0;
+    for (const double t : times) {
+        sum += t;
+    }
+    std::sort(times.begin(), times.end());
+    result.meanSeconds = sum / times.size();
+    result.cpuSeconds = cpuSeconds / times.size();
+    result.medianSeconds = times[times.size() / 2];
+    result.minSeconds = times.front();
+    result.maxSeconds = times.back();
+    if (sum > 0.0) {
+        result.bytesPerSecond = bytes * times.size() / sum;
+        result.itemsPerSecond = items * times.size() / sum;
+    }
+    return result;
+}
+
+// Run function until minimum time and iterations are reached. Times are divided by batch for per item results.
+// A throwing function fails the case, which is then returned without iterations.
+template <typename Func>
+Case measure(const Config& config, const std::string& name, double bytes, int batch, Func func)
+{
+    std::vector<double> times;
+    double total = 0.0;
+    const double cpuStart = getThreadCpuSeconds();
+    try {
+        while (total < config.minSeconds || static_cast<int>(times.size()) < config.minIterations) {
+            const auto start = Clock::now();
+            func();
+            const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+            times.push_back(seconds / batch);
+            total += seconds;
+        }
+    } catch (const std::exception& e) {
+        LOG_ERROR("Capture benchmark: %s failed: %s", name.c_str(), e.what());
+        Case failed;
+        failed.name = name;
+        return failed;
+    }
+    Case result = makeCase(name, times, (getThreadCpuSeconds() - cpuStart) / batch, bytes, 1.0);
+    result.iterations *= batch;
+    LOG_INFO("Capture benchmark: %s, iterations=%lld, mean=%.3f us, median=%.3f us, max=%.3f us, %.1f MB/s", name.c_str(),
+        static_cast<long long>(result.iterations), result.meanSeconds * 1e6, result.medianSeconds * 1e6, result.maxSeconds * 1e6,
+        result.bytesPerSecond / (1024.0 * 1024.0));
+    return result;
+}
+
+// Escape string for JSON
+std::string escapeJson(const std::string& value)
+{
+    std::string escaped;
+    for (const char c : value) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+            escaped += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char code[8];
+            snprintf(code, sizeof(code), "\\u%04x", c);
+            escaped += code;
+        } else {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+}  // namespace
+
+namespace VarjoExamples
+{
+CaptureBenchmark::Result CaptureBenchmark::run(const Config& config)
+{
+    Result result;
+    result.valid = true;
+
+    // Filter is a comma separated list of name parts
+    const auto enabled = [&](const std::string& name) {
+        if (config.filter.empty()) {
+            return true;
+        }
+        size_t begin = 0;
+        while (begin <= config.filter.size()) {
+            const size_t end = std::min(config.filter.find(',', begin), config.filter.size());
+            const std::string part = config.filter.substr(begin, end - begin);
+            if (!part.empty() && name.find(part) != std::string::npos) {
+                return true;
+            }
+            begin = end + 1;
+        }
+        return false;
+    };
+    const auto add = [&](Case benchmarkCase) {
+        result.valid = result.valid && benchmarkCase.iterations > 0;
+        result.cases.push_back(std::move(benchmarkCase));
+    };
+
+    const SyntheticBuffer yuv422 = createBuffer(varjo_TextureFormat_YUV422, config.width, config.height);
+    const SyntheticBuffer nv12 = createBuffer(varjo_TextureFormat_NV12, config.width, config.height);
+    const SyntheticBuffer cubemap = createBuffer(varjo_TextureFormat_RGBA16_FLOAT, config.cubemapSize, config.cubemapSize * 6);
+    const SyntheticBuffer* colorBuffers[] = {&yuv422, &nv12};
+    const char* colorNames[] = {"YUV422", "NV12"};
+
+    // Format conversion
+    std::vector<uint8_t> pixels;
+    for (int i = 0; i < 2; i++) {
+        const std::string name = std::string("convert/") + colorNames[i];
+        if (enabled(name)) {
+            add(measure(config, name, static_cast<double>(colorBuffers[i]->data.size()), 1,
+                [&] { convertBufferToBGRA(colorBuffers[i]->metadata, colorBuffers[i]->data.data(), pixels); }));
+        }
+    }
+    if (enabled("convert/YUV422_normalized")) {
+        // Camera white balance of a warm indoor scene, one stop brighter than reference
+        const varjo_WBNormalizationData wbNormalizationData = {
+            {1.4, 1.0, 0.7},
+            {1.6, -0.4, -0.2, -0.3, 1.5, -0.2, 0.0, -0.5, 1.5},
+            {1.7, -0.5, -0.2, -0.3, 1.6, -0.3, -0.1, -0.4, 1.5},
+        };
+        const FrameNormalization normalization = getFrameNormalization(7.2, wbNormalizationData, 6.2);
+        add(measure(config, "convert/YUV422_normalized", static_cast<double>(yuv422.data.size()), 1,
+            [&] { convertBufferToBGRA(yuv422.metadata, yuv422.data.data(), pixels, nullptr, &normalization); }));
+    }
+    if (enabled("convert/RGBA16F")) {
+        add(measure(config, "convert/RGBA16F", static_cast<double>(cubemap.data.size()), 1,
+            [&] { convertBufferToBGRA(cubemap.metadata, cubemap.data.data(), pixels); }));
+    }
+    if (enabled("convert/equirect")) {
+        EquirectConverter converter(config.cubemapSize);
+        add(measure(config, "convert/equirect", static_cast<double>(cubemap.data.size()), 1,
+            [&] { converter.convertToBGRA(cubemap.metadata, cubemap.data.data(), pixels, &JobSystem::getShared()); }));
+    }
+
+    // Encoding of converted color frame
+    convertBufferToBGRA(yuv422.metadata, yuv422.data.data(), pixels);
+    std::vector<uint8_t> encoded;
+    if (enabled("encode/BMP")) {
+        add(measure(config, "encode/BMP", static_cast<double>(pixels.size()), 1, [&] { encodeBMP(pixels.data(), config.width, config.height, encoded); }));
+        LOG_INFO("  encode/BMP: %zu bytes", encoded.size());
+    }
+    if (enabled("encode/QOI")) {
+        add(measure(config, "encode/QOI", static_cast<double>(pixels.size()), 1, [&] {
+            encoded.clear();
+            encodeQoi(pixels.data(), config.width, config.height, config.width * 4, 4, false, encoded);
+        }));
+        LOG_INFO("  encode/QOI: %zu bytes", encoded.size());
+    }
+    if (enabled("encode/JPEG")) {
+        if (encodeJpeg(pixels.data(), config.width, config.height, config.width * 4, c_jpegQuality, encoded)) {
+            add(measure(config, "encode/JPEG", static_cast<double>(pixels.size()), 1,
+                [&] { encodeJpeg(pixels.data(), config.width, config.height, config.width * 4, c_jpegQuality, encoded); }));
+            LOG_INFO("  encode/JPEG: %zu bytes", encoded.size());
+        } else {
+            LOG_WARNING("Skipping encode/JPEG, no JPEG encoder in this build");
+        }
+    }
+    if (enabled("encode/foveal")) {
+        const FovealConfig fovealConfig;
+        FovealFrame fovealFrame;
+        add(measure(config, "encode/foveal", static_cast<double>(pixels.size()), 1, [&] {
+            encodeFoveal(pixels.data(), config.width, config.height, glm::ivec2(config.width / 2, config.height / 2), true, fovealConfig, fovealFrame,
+                &JobSystem::getShared());
+            serializeFoveal(fovealFrame, encoded);
+        }));
+        LOG_INFO("  encode/foveal: %zu bytes", encoded.size());
+    }
+
+    // Snapshot frame of storeBuffer: convert, encode and write file
+    const std::string filename = config.outputDirectory + "/capture_benchmark.bmp";
+    for (int i = 0; i < 2; i++) {
+        const std::string name = std::string("storeBuffer/") + colorNames[i];
+        if (enabled(name)) {
+            add(measure(config, name, static_cast<double>(colorBuffers[i]->data.size()), 1,
+                [&] { saveBufferBMP(filename, colorBuffers[i]->metadata, colorBuffers[i]->data.data(), &JobSystem::getShared()); }));
+        }
+    }
+    std::remove(filename.c_str());
+
+    // Row-parallel conversion from one thread to all cores. Calling thread takes part, so N threads use N - 1 workers.
+    const int maxThreads = config.maxThreads > 0 ? config.maxThreads : std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+    std::vector<int> threadCounts;
+    for (int threads = 1; threads < maxThreads; threads *= 2) {
+        threadCounts.push_back(threads);
+    }
+    threadCounts.push_back(maxThreads);
+    for (int i = 0; i < 2; i++) {
+        for (const int threads : threadCounts) {
+            const std::string name = std::string("scaling/convert_") + colorNames[i] + "/threads:" + std::to_string(threads);
+            if (!enabled(name)) {
+                continue;
+            }
+
+            JobSystem::Config jobConfig;
+            jobConfig.workerCount = std::max(threads - 1, 1);
+            jobConfig.latencyWorkers = 0;
+            jobConfig.pinWorkers = config.pinWorkers;
+            JobSystem jobs(jobConfig);
+            JobSystem* pool = threads > 1 ? &jobs : nullptr;
+            add(measure(config, name, static_cast<double>(colorBuffers[i]->data.size()), 1,
+                [&] { convertBufferToBGRA(colorBuffers[i]->metadata, colorBuffers[i]->data.data(), pixels, pool); }));
+        }
+    }
+
+    // Time until a job starts while all bulk workers encode frames, on the low-latency lane and behind bulk jobs
+    for (const bool underLoad : {false, true}) {
+        for (const auto priority : {JobSystem::Priority::LowLatency, JobSystem::Priority::Bulk}) {
+            const std::string name = std::string(priority == JobSystem::Priority::LowLatency ? "jobLatency/lowLatency" : "jobLatency/bulk") +
+                                     (underLoad ? "_under_encode" : "_idle");
+            if (!enabled(name)) {
+                continue;
+            }
+
+            // Bulk job resubmits itself until loading stops. Declared before pool so queued copies outlive it.
+            std::atomic_bool loading = underLoad;
+            std::function<void()> bulkJob;
+            JobSystem::Config jobConfig;
+            jobConfig.workerCount = std::max(maxThreads - 1, 1);
+            jobConfig.pinWorkers = config.pinWorkers;
+            JobSystem jobs(jobConfig);
+            bulkJob = [&] {
+                std::vector<uint8_t> bmp;
+                encodeBMP(pixels.data(), config.width, config.height, bmp);
+                if (loading) {
+                    jobs.submit(bulkJob);
+                }
+            };
+            for (int j = 0; underLoad && j < jobs.getWorkerCount() * c_bulkJobsPerWorker; j++) {
+                jobs.submit(bulkJob);
+            }
+
+            add(measure(config, name, 0.0, 1, [&] {
+                std::atomic_bool started = false;
+                jobs.submit([&] { started = true; }, priority);
+                while (!started) {
+                    std::this_thread::yield();
+                }
+            }));
+            loading = false;
+        }
+    }
+
+    DataStreamer::StreamData streamData;
+    DataStreamer::CubemapFrame latestCubemap;
+    varjo_Matrix hmdPose = toVarjoMatrix(glm::mat4(1.0f));
+
+    // Delayed buffers of one stereo frame queued in callback and released in main loop
+    if (enabled("delayedBuffers/queue")) {
+        streamData.delayedBuffers.reserve(2);
+        add(measure(config, "delayedBuffers/queue", 0.0, 1, [&] {
+            {
+                std::lock_guard<std::recursive_mutex> streamLock(streamData.mutex);
+                for (int channel = 0; channel < 2; channel++) {
+                    DataStreamer::DelayedBuffer delayedBuffer;
+                    delayedBuffer.type = varjo_StreamType_DistortedColor;
+                    delayedBuffer.streamId = 1;
+                    delayedBuffer.channelIndex = channel;
+                    delayedBuffer.trace.frameNumber = 1;
+                    delayedBuffer.bufferId = channel + 1;
+                    delayedBuffer.baseName = channel == 0 ? "left" : "right";
+                    delayedBuffer.buffer = yuv422.metadata;
+                    delayedBuffer.cpuBuffer = const_cast<uint8_t*>(yuv422.data.data());
+                    streamData.delayedBuffers.emplace_back(delayedBuffer);
+                }
+            }
+            std::lock_guard<std::recursive_mutex> streamLock(streamData.mutex);
+            streamData.delayedBuffers.clear();
+        }));
+    }
+
+    // Cubemap stored in stream callback and copied out by getCubemapFrame
+    if (enabled("cubemap/store")) {
+        add(measure(config, "cubemap/store", static_cast<double>(cubemap.data.size()), 1, [&] {
+            std::lock_guard<std::recursive_mutex> streamLock(streamData.mutex);
+            if (latestCubemap.data.size() != cubemap.data.size()) {
+                latestCubemap.data.resize(cubemap.data.size());
+            }
+            memcpy(latestCubemap.data.data(), cubemap.data.data(), cubemap.data.size());
+            latestCubemap.metadata = cubemap.metadata;
+        }));
+    }
+    if (enabled("cubemap/snapshot")) {
+        latestCubemap.data = cubemap.data;
+        latestCubemap.metadata = cubemap.metadata;
+        DataStreamer::CubemapFrame frame;
+        add(measure(config, "cubemap/snapshot", static_cast<double>(cubemap.data.size()), 1, [&] {
+            std::lock_guard<std::recursive_mutex> streamLock(streamData.mutex);
+            frame = latestCubemap;
+        }));
+    }
+
+    // Latest HMD pose as read by render loop
+    glm::mat4x4 pose(1.0f);
+    const auto lookupPose = [&] {
+        std::lock_guard<std::recursive_mutex> streamLock(streamData.mutex);
+        pose = fromVarjoMatrix(hmdPose);
+    };
+    if (enabled("pose/latest")) {
+        add(measure(config, "pose/latest", 0.0, c_poseBatch, [&] {
+            for (int i = 0; i < c_poseBatch; i++) {
+                lookupPose();
+            }
+        }));
+    }
+
+    // Pose lookups while the stream callback holds the stream lock for pose updates and snapshot frames
+    if (enabled("pose/latest_during_callback")) {
+        std::atomic_bool running = true;
+        std::thread callback([&] {
+            const auto frameTime = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / c_streamFrameRate));
+            auto nextFrame = Clock::now();
+            std::vector<uint8_t> snapshot;
+            for (int64_t frame = 0; running; frame++) {
+                {
+                    std::lock_guard<std::recursive_mutex> streamLock(streamData.mutex);
+                    hmdPose = toVarjoMatrix(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, static_cast<float>(frame))));
+                    if (frame % c_snapshotInterval == 0) {
+                        convertBufferToBGRA(yuv422.metadata, yuv422.data.data(), snapshot, &JobSystem::getShared());
+                        encodeBMP(snapshot.data(), config.width, config.height, encoded);
+                    }
+                }
+                nextFrame += frameTime;
+                std::this_thread::sleep_until(nextFrame);
+            }
+        });
+
+        Config lookupConfig = config;
+        lookupConfig.minSeconds = std::max(config.minSeconds, c_snapshotInterval / c_streamFrameRate);
+        std::vector<double> times;
+        double cpuSeconds = 0.0;
+        const auto start = Clock::now();
+        while (std::chrono::duration<double>(Clock::now() - start).count() < lookupConfig.minSeconds ||
+               static_cast<int>(times.size()) < lookupConfig.minIterations) {
+            const double cpuStart = getThreadCpuSeconds();
+            const auto lookupStart = Clock::now();
+            lookupPose();
+            times.push_back(std::chrono::duration<double>(Clock::now() - lookupStart).count());
+            cpuSeconds += getThreadCpuSeconds() - cpuStart;
+            std::this_thread::sleep_for(c_poseLookupInterval);
+        }
+        running = false;
+        callback.join();
+
+        Case lookupCase = makeCase("pose/latest_during_callback", times, cpuSeconds, 0.0, 1.0);
+        LOG_INFO("Capture benchmark: %s, iterations=%lld, mean=%.3f us, median=%.3f us, max=%.3f us", lookupCase.name.c_str(),
+            static_cast<long long>(lookupCase.iterations), lookupCase.meanSeconds * 1e6, lookupCase.medianSeconds * 1e6, lookupCase.maxSeconds * 1e6);
+        add(std::move(lookupCase));
+    }
+
+    return result;
+}
+
+std::string CaptureBenchmark::toJson(const Config& config, const Result& result)
+{
+    std::string json;
+    char line[512];
+
+    json += "{\n  \"context\": {\n";
+    snprintf(line, sizeof(line), "    \"num_cpus\": %u,\n", std::thread::hardware_concurrency());
+    json += line;
+#ifdef NDEBUG
+    json += "    \"library_build_type\": \"release\",\n";
+#else
+    json += "    \"library_build_type\": \"debug\",\n";
+#endif
+    snprintf(line, sizeof(line), "    \"width\": %d,\n    \"height\": %d,\n    \"cubemap_size\": %d,\n    \"valid\": %s,\n", config.width, config.height,
+        config.cubemapSize, result.valid ? "true" : "false");
+    json += line;
+    json += "    \"output_directory\": \"" + escapeJson(config.outputDirectory) + "\"\n  },\n  \"benchmarks\": [";
+
+    for (size_t i = 0; i < result.cases.size(); i++) {
+        const Case& c = result.cases[i];
+        const std::string name = escapeJson(c.name);
+        json += (i == 0) ? "\n" : ",\n";
+        json += "    {\n      \"name\": \"" + name + "\",\n      \"run_name\": \"" + name + "\",\n      \"run_type\": \"iteration\",\n";
+        snprintf(line, sizeof(line),
+            "      \"iterations\": %lld,\n      \"real_time\": %.3f,\n      \"cpu_time\": %.3f,\n      \"time_unit\": \"ns\",\n"
+            "      \"median_time\": %.3f,\n      \"min_time\": %.3f,\n      \"max_time\": %.3f,\n",
+            static_cast<long long>(c.iterations), c.meanSeconds * 1e9, c.cpuSeconds * 1e9, c.medianSeconds * 1e9, c.minSeconds * 1e9,
+            c.maxSeconds * 1e9);
+        json += line;
+        if (c.bytesPerSecond > 0.0) {
+            snprintf(line, sizeof(line), "      \"bytes_per_second\": %.1f,\n", c.bytesPerSecond);
+            json += line;
+        }
+        snprintf(line, sizeof(line), "      \"items_per_second\": %.1f\n    }", c.itemsPerSecond);
+        json += line;
+    }
+    json += "\n  ]\n}\n";
+    return json;
+}
+
+bool CaptureBenchmark::runToFile(const Config& config, const std::string& filename)
+{
+    const Result result = run(config);
+    const std::string json = toJson(config, result);
+
+    std::ofstream outFile(filename, std::ofstream::binary);
+    outFile.write(json.data(), json.size());
+    if (!outFile.good()) {
+        LOG_ERROR("Writing benchmark results failed: %s", filename.c_str());
+        return false;
+    }
+    LOG_INFO("Capture benchmark results written: %s", filename.c_str());
+    return result.valid;
+}
+
+}  // namespace VarjoExamples
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "Globals.hpp"
+
+namespace VarjoExamples
+{
+//! Benchmark suite for the CPU side of the capture path on synthetic stream buffers.
+//!
+//! Runs without a Varjo session: color frames are generated as YUV422 and NV12 at camera resolution and cubemaps
+//! as RGBA16F. Covers buffer conversion with and without exposure normalization, equirect conversion, BMP, QOI, JPEG
+//! and foveal encoding, the snapshot work of DataStreamer::storeBuffer, delayed buffer queueing, cubemap snapshotting and
+//! HMD pose lookups with and without a concurrent frame callback.
+//! Scaling cases run row-parallel conversion on 1 to maxThreads threads of a JobSystem, and job latency cases measure
+//! how long a job waits to start on the low-latency lane and on the bulk lane while workers encode frames.
+//! Cases that need a session repeat the work DataStreamer does for them with the same types and stream lock.
+class CaptureBenchmark
+{
+public:
+    //! Benchmark configuration
+    struct Config {
+        int width = 2880;                   //!< Color stream width
+        int height = 2720;                  //!< Color stream height
+        int cubemapSize = 256;              //!< Cubemap face size
+        double minSeconds = 0.5;            //!< Minimum measured time per case
+        int minIterations = 5;              //!< Minimum iterations per case
+        std::string outputDirectory = ".";  //!< Directory for files written by storeBuffer cases
+        std::string filter;                 //!< Run only cases whose name contains one of these comma separated parts, all if empty
+        int maxThreads = 0;                 //!< Largest thread count of scaling cases, hardware threads if zero
+        bool pinWorkers = false;            //!< Pin job system workers to cores in scaling and job latency cases
+    };
+
+    //! Result of one case. Times are per iteration.
+    struct Case {
+        std::string name;             //!< Case name, group/variant
+        int64_t iterations = 0;       //!< Measured iterations
+        double meanSeconds = 0.0;     //!< Mean time
+        double cpuSeconds = 0.0;      //!< Mean CPU time of measuring thread
+        double medianSeconds = 0.0;   //!< Median time
+        double minSeconds = 0.0;      //!< Fastest iteration
+        double maxSeconds = 0.0;      //!< Slowest iteration
+        double bytesPerSecond = 0.0;  //!< Input bytes processed per second, zero if not applicable
+        double itemsPerSecond = 0.0;  //!< Items processed per second
+    };
+
+    //! Benchmark result
+    struct Result {
+        bool valid = false;       //!< False if a case threw or ran no iterations
+        std::vector<Case> cases;  //!< Case results in run order
+    };
+
+    //! Run benchmark cases. Blocks until done.
+    static Result run(const Config& config);
+
+    //! Format result as JSON in Google Benchmark layout, so its compare tooling can diff two runs
+    static std::string toJson(const Config& config, const Result& result);
+
+    //! Run benchmark and write JSON to file. Returns false on failure.
+    static bool runToFile(const Config& config, const std::string& filename);
+};
+
+}  // namespace VarjoExamples
@@ -0,0 +1,179 @@
+#include "ChangeIndex.hpp"
+
+#include <algorithm>
+#include <iterator>
+
+namespace
+{
+using namespace VarjoExamples;
+
+// Event ordering by time
+inline bool eventBefore(const ChangeIndex::Event& a, double time) { return a.time < time; }
+inline bool timeBefore(double time, const ChangeIndex::Event& a) { return time < a.time; }
+
+}  // namespace
+
+namespace VarjoExamples
+{
+ChangeIndex::ChangeIndex(int width, int height, int tileSize)
+    : m_size(width, height)
+    , m_tileSize(std::max(tileSize, 1))
+    , m_tileCount((width + m_tileSize - 1) / m_tileSize, (height + m_tileSize - 1) / m_tileSize)
+{
+    m_tiles.resize(static_cast<size_t>(m_tileCount.x) * m_tileCount.y);
+}
+
+void ChangeIndex::setLabel(ObjectId object, const std::string& label) { m_labels[object] = label; }
+
+const std::string& ChangeIndex::getLabel(ObjectId object) const
+{
+    static const std::string c_empty;
+    auto it = m_labels.find(object);
+    return (it != m_labels.end()) ? it->second : c_empty;
+}
+
+void ChangeIndex::addChange(double time, ObjectId object, const glm::ivec4& bounds)
+{
+    const glm::ivec4 tiles = getTileRange(bounds);
+    if (tiles.x >= tiles.z || tiles.y >= tiles.w) {
+        return;
+    }
+
+    for (int ty = tiles.y; ty < tiles.w; ty++) {
+        for (int tx = tiles.x; tx < tiles.z; tx++) {
+            insert(ty * m_tileCount.x + tx, {time, object});
+        }
+    }
+    updateSpan(time, object);
+}
+
+void ChangeIndex::addChange(double time, ObjectId object, const RleMask& mask)
+{
+    if (mask.empty()) {
+        return;
+    }
+
+    // Collect touched tiles first so each tile gets a single event
+    std::vector<bool> touched(m_tiles.size(), false);
+    const float scaleX = static_cast<float>(m_size.x) / std::max(mask.getWidth(), 1);
+    const float scaleY = static_cast<float>(m_size.y) / std::max(mask.getHeight(), 1);
+    mask.forEachRun([&](int y, int begin, int end) {
+        const int ty = static_cast<int>(y * scaleY) / m_tileSize;
+        if (ty < 0 || ty >= m_tileCount.y) {
+            return;
+        }
+        const int tx0 = std::max(static_cast<int>(begin * scaleX) / m_tileSize, 0);
+        const int tx1 = std::min(static_cast<int>((end - 1) * scaleX) / m_tileSize, m_tileCount.x - 1);
+        for (int tx = tx0; tx <= tx1; tx++) {
+            touched[ty * m_tileCount.x + tx] = true;
+        }
+    });
+
+    for (size_t i = 0; i < touched.size(); i++) {
+        if (touched[i]) {
+            insert(static_cast<int>(i), {time, object});
+        }
+    }
+    updateSpan(time, object);
+}
+
+std::vector<ChangeIndex::Event> ChangeIndex::query(const glm::ivec4& region, double t0, double t1) const
+{
+    std::vector<Event> events;
+
+    const glm::ivec4 tiles = getTileRange(region);
+    for (int ty = tiles.y; ty < tiles.w; ty++) {
+        for (int tx = tiles.x; tx < tiles.z; tx++) {
+            const auto& tile = m_tiles[ty * m_tileCount.x + tx];
+            auto begin = std::lower_bound(tile.begin(), tile.end(), t0, eventBefore);
+            auto end = std::upper_bound(begin, tile.end(), t1, timeBefore);
+            events.insert(events.end(), begin, end);
+        }
+    }
+
+    // Merge tiles: sort by time and drop duplicates of the same object at the same time
+    std::sort(events.begin(), events.end(), [](const Event& a, const Event& b) { return (a.time < b.time) || (a.time == b.time && a.object < b.object); });
+    events.erase(std::unique(events.begin(), events.end(), [](const Event& a, const Event& b) { return a.time == b.time && a.object == b.object; }),
+        events.end());
+    return events;
+}
+
+bool ChangeIndex::hasChange(const glm::ivec4& region, double t0, double t1) const
+{
+    const glm::ivec4 tiles = getTileRange(region);
+    for (int ty = tiles.y; ty < tiles.w; ty++) {
+        for (int tx = tiles.x; tx < tiles.z; tx++) {
+            const auto& tile = m_tiles[ty * m_tileCount.x + tx];
+            auto it = std::lower_bound(tile.begin(), tile.end(), t0, eventBefore);
+            if (it != tile.end() && it->time <= t1) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+const ChangeIndex::ObjectSpan* ChangeIndex::getObjectSpan(ObjectId object) const
+{
+    auto it = m_spans.find(object);
+    return (it != m_spans.end()) ? &it->second : nullptr;
+}
+
+void ChangeIndex::clear()
+{
+    for (auto& tile : m_tiles) {
+        tile.clear();
+    }
+    m_spans.clear();
+    m_eventCount = 0;
+}
+
+void ChangeIndex::insert(int tileIndex, const Event& event)
+{
+    auto& tile = m_tiles[tileIndex];
+
+    // Events arrive mostly in time order, append in the common case
+    const bool append = tile.empty() || tile.back().time <= event.time;
+    auto end = append ? tile.end() : std::upper_bound(tile.begin(), tile.end(), event.time, timeBefore);
+
+    // Events of the same time end at the insert position
+    auto begin = end;
+    while (begin != tile.begin() && std::prev(begin)->time == event.time) {
+        --begin;
+    }
+
+    // One event per object and time in each tile
+    if (std::any_of(begin, end, [&](const Event& e) { return e.object == event.object; })) {
+        return;
+    }
+    tile.insert(end, event);
+    m_eventCount++;
+}
+
+void ChangeIndex::updateSpan(double time, ObjectId object)
+{
+    auto it = m_spans.find(object);
+    if (it == m_spans.end()) {
+        m_spans[object] = {time, time, 1};
+        return;
+    }
+
+    ObjectSpan& span = it->second;
+    span.first = std::min(span.first, time);
+    span.last = std::max(span.last, time);
+    span.count++;
+}
+
+glm::ivec4 ChangeIndex::getTileRange(const glm::ivec4& region) const
+{
+    const int x0 = std::max(region.x, 0);
+    const int y0 = std::max(region.y, 0);
+    const int x1 = std::min(region.z, m_size.x);
+    const int y1 = std::min(region.w, m_size.y);
+    if (x0 >= x1 || y0 >= y1) {
+        return glm::ivec4(0);
+    }
+    return glm::ivec4(x0 / m_tileSize, y0 / m_tileSize, (x1 - 1) / m_tileSize + 1, (y1 - 1) / m_tileSize + 1);
+}
+
+}  // namespace VarjoExamples
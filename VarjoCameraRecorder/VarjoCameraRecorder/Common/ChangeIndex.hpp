@@ -0,0 +1,90 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include "Globals.hpp"
+#include "MaskStore.hpp"
+
+namespace VarjoExamples
+{
+//! Spatio-temporal index of change events over the primary region.
+//! The region is split into a tile grid, each tile holding a time-sorted list of change events,
+//! so "what changed here between t0 and t1" is answered without scanning saved frames.
+class ChangeIndex
+{
+public:
+    //! Object id type
+    using ObjectId = int64_t;
+
+    //! Single change event
+    struct Event {
+        double time = 0.0;    //!< Event timestamp in seconds
+        ObjectId object = 0;  //!< Changed object
+    };
+
+    //! First and last change of an object
+    struct ObjectSpan {
+        double first = 0.0;  //!< First change timestamp
+        double last = 0.0;   //!< Last change timestamp
+        uint64_t count = 0;  //!< Number of change events
+    };
+
+    //! Construct index for region of given size
+    ChangeIndex(int width, int height, int tileSize = 32);
+
+    //! Set label for object
+    void setLabel(ObjectId object, const std::string& label);
+
+    //! Get label for object. Returns empty string if unknown.
+    const std::string& getLabel(ObjectId object) const;
+
+    //! Add change covering given pixel bounds (x0, y0, x1, y1), exclusive max
+    void addChange(double time, ObjectId object, const glm::ivec4& bounds);
+
+    //! Add change covering set pixels of given mask
+    void addChange(double time, ObjectId object, const RleMask& mask);
+
+    //! Return events in tiles overlapping given pixel region within [t0, t1], sorted by time. One event per object and time.
+    std::vector<Event> query(const glm::ivec4& region, double t0, double t1) const;
+
+    //! Return true if any change occurred in given pixel region within [t0, t1]
+    bool hasChange(const glm::ivec4& region, double t0, double t1) const;
+
+    //! Return first and last change of given object or nullptr if unknown
+    const ObjectSpan* getObjectSpan(ObjectId object) const;
+
+    //! Return spans of all objects
+    const std::unordered_map<ObjectId, ObjectSpan>& getObjectSpans() const { return m_spans; }
+
+    //! Return tile grid size
+    glm::ivec2 getTileCount() const { return m_tileCount; }
+
+    //! Return total event count over all tiles
+    size_t getEventCount() const { return m_eventCount; }
+
+    //! Remove all events
+    void clear();
+
+private:
+    //! Insert event to given tile keeping time order
+    void insert(int tileIndex, const Event& event);
+
+    //! Update object span with new event time
+    void updateSpan(double time, ObjectId object);
+
+    //! Return tile range (tx0, ty0, tx1, ty1) overlapping given pixel region, exclusive max
+    glm::ivec4 getTileRange(const glm::ivec4& region) const;
+
+private:
+    glm::ivec2 m_size;                                   //!< Region size in pixels
+    int m_tileSize;                                      //!< Tile size in pixels
+    glm::ivec2 m_tileCount;                              //!< Tile grid size
+    std::vector<std::vector<Event>> m_tiles;             //!< Time-sorted events per tile
+    std::unordered_map<ObjectId, ObjectSpan> m_spans;    //!< First/last change per object
+    std::unordered_map<ObjectId, std::string> m_labels;  //!< Object labels
+    size_t m_eventCount = 0;                             //!< Total event count
+};
+
+}  // namespace VarjoExamples
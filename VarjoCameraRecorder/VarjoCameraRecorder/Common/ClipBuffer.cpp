@@ -0,0 +1,198 @@
+#include "ClipBuffer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+
+#include <glm/gtc/packing.hpp>
+
+namespace
+{
+// Bilinear weights in fixed point, as in OpenCV INTER_LINEAR for 8-bit images
+constexpr int c_weightBits = 11;
+constexpr int c_weightOne = 1 << c_weightBits;
+
+// Output channels
+constexpr int c_channels = 3;
+
+// Compute left tap and right weight for each output coordinate with pixel centers aligned
+void computeTaps(int inSize, int outSize, std::vector<int>& offsets, std::vector<int16_t>& weights)
+{
+    offsets.resize(outSize);
+    weights.resize(outSize);
+    const double scale = static_cast<double>(inSize) / outSize;
+    for (int i = 0; i < outSize; i++) {
+        double f = (i + 0.5) * scale - 0.5;
+        int s = static_cast<int>(std::floor(f));
+        f -= s;
+        if (s < 0) {
+            s = 0;
+            f = 0.0;
+        } else if (s >= inSize - 1) {
+            s = inSize - 1;
+            f = 0.0;
+        }
+        offsets[i] = s;
+        weights[i] = static_cast<int16_t>(std::lround(f * c_weightOne));
+    }
+}
+
+}  // namespace
+
+namespace VarjoExamples
+{
+ClipBuffer::ClipBuffer()
+    : ClipBuffer(Config())
+{
+}
+
+ClipBuffer::ClipBuffer(const Config& config)
+    : m_config(config)
+    , m_slotCount(std::max(config.length, 1) + std::max(config.slack, 0))
+    , m_planeSlots(m_slotCount + std::max(config.length, 1) - 1)
+    , m_sampleSize(config.precision == Precision::Float16 ? sizeof(uint16_t) : sizeof(float))
+{
+    if (config.width <= 0 || config.height <= 0 || config.length <= 0) {
+        CRITICAL("Invalid clip size: %dx%d, length=%d", config.width, config.height, config.length);
+    }
+
+    m_data.resize(static_cast<size_t>(c_channels) * m_planeSlots * config.width * config.height * m_sampleSize);
+    m_rows.resize(static_cast<size_t>(2) * c_channels * config.width);
+
+    // Same normalization as the Python transform: x * 2 / 255 - 1
+    for (int i = 0; i < 256; i++) {
+        m_floatLut[i] = (i * 2.0f - 255.0f) / 255.0f;
+        m_halfLut[i] = glm::packHalf1x16(m_floatLut[i]);
+    }
+}
+
+void ClipBuffer::push(const uint8_t* data, int width, int height, int rowStride, int channels)
+{
+    if (!data || width <= 0 || height <= 0 || channels < c_channels || channels > 4) {
+        LOG_ERROR("Invalid clip frame: %dx%d, channels=%d", width, height, channels);
+        return;
+    }
+
+    if (width != m_inWidth || height != m_inHeight) {
+        prepareTaps(width, height);
+    }
+
+    // Slot of new frame is not part of any view handed out during the last slack pushes
+    const int slot = static_cast<int>(getFrameCount() % m_slotCount);
+    const int outWidth = m_config.width;
+    int32_t* rows[2] = {m_rows.data(), m_rows.data() + c_channels * outWidth};
+    int loaded[2] = {-1, -1};
+
+    // Horizontal pass of one source row into interleaved fixed point row
+    const auto resizeRow = [&](int sy, int32_t* out) {
+        const uint8_t* src = data + static_cast<size_t>(sy) * rowStride;
+        for (int x = 0; x < outWidth; x++) {
+            const uint8_t* p0 = src + m_xOffsets[x] * channels;
+            const uint8_t* p1 = src + std::min(m_xOffsets[x] + 1, width - 1) * channels;
+            const int w1 = m_xWeights[x];
+            const int w0 = c_weightOne - w1;
+            for (int c = 0; c < c_channels; c++) {
+                out[x * c_channels + c] = p0[c] * w0 + p1[c] * w1;
+            }
+        }
+    };
+
+    for (int y = 0; y < m_config.height; y++) {
+        const int sy0 = m_yOffsets[y];
+        const int sy1 = std::min(sy0 + 1, height - 1);
+
+        // Reuse rows of previous output row when possible
+        if (loaded[0] != sy0) {
+            if (loaded[1] == sy0) {
+                std::swap(rows[0], rows[1]);
+                std::swap(loaded[0], loaded[1]);
+            } else {
+                resizeRow(sy0, rows[0]);
+                loaded[0] = sy0;
+            }
+        }
+        if (loaded[1] != sy1) {
+            resizeRow(sy1, rows[1]);
+            loaded[1] = sy1;
+        }
+
+        for (int c = 0; c < c_channels; c++) {
+            if (m_config.precision == Precision::Float16) {
+                storeRow<uint16_t>(rows[0], rows[1], m_yWeights[y], c, slot, y);
+            } else {
+                storeRow<float>(rows[0], rows[1], m_yWeights[y], c, slot, y);
+            }
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_frameCount++;
+}
+
+bool ClipBuffer::getView(View& outView) const
+{
+    const int64_t frameCount = getFrameCount();
+    if (frameCount < m_config.length) {
+        return false;
+    }
+
+    const int64_t first = frameCount - m_config.length;
+    const int64_t frameStride = static_cast<int64_t>(m_config.width) * m_config.height * m_sampleSize;
+    const int64_t planeStride = frameStride * m_planeSlots;
+    outView.data = m_data.data() + (first % m_slotCount) * frameStride;
+    outView.shape = {1, c_channels, m_config.length, m_config.height, m_config.width};
+    outView.strides = {planeStride * c_channels, planeStride, frameStride, static_cast<int64_t>(m_config.width * m_sampleSize),
+        static_cast<int64_t>(m_sampleSize)};
+    outView.firstFrame = first;
+    return true;
+}
+
+int64_t ClipBuffer::getFrameCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_frameCount;
+}
+
+void ClipBuffer::clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_frameCount = 0;
+}
+
+void ClipBuffer::prepareTaps(int width, int height)
+{
+    computeTaps(width, m_config.width, m_xOffsets, m_xWeights);
+    computeTaps(height, m_config.height, m_yOffsets, m_yWeights);
+    m_inWidth = width;
+    m_inHeight = height;
+}
+
+template <typename T>
+void ClipBuffer::storeRow(const int32_t* row0, const int32_t* row1, int weight1, int channel, int slot, int y)
+{
+    const size_t frameSamples = static_cast<size_t>(m_config.width) * m_config.height;
+    T* plane = reinterpret_cast<T*>(m_data.data()) + static_cast<size_t>(channel) * m_planeSlots * frameSamples;
+    T* out = plane + slot * frameSamples + static_cast<size_t>(y) * m_config.width;
+
+    // Slots before length - 1 are mirrored past the ring end
+    T* mirror = slot < m_config.length - 1 ? out + m_slotCount * frameSamples : nullptr;
+
+    const int weight0 = c_weightOne - weight1;
+    constexpr int round = 1 << (2 * c_weightBits - 1);
+    for (int x = 0; x < m_config.width; x++) {
+        const int i = x * c_channels + channel;
+        const int value = (row0[i] * weight0 + row1[i] * weight1 + round) >> (2 * c_weightBits);
+        T sample;
+        if constexpr (std::is_same_v<T, float>) {
+            sample = m_floatLut[value];
+        } else {
+            sample = m_halfLut[value];
+        }
+        out[x] = sample;
+        if (mirror) {
+            mirror[x] = sample;
+        }
+    }
+}
+
+}  // namespace VarjoExamples
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <array>
+#include <mutex>
+#include <vector>
+
+#include "Globals.hpp"
+
+namespace VarjoExamples
+{
+//! Sliding window of preprocessed frames for clip based video models, stored as NCTHW tensor data.
+//!
+//! Each pushed frame is resized once with bilinear filtering, normalized to [-1, 1] and written into per-channel
+//! planes of a ring of frame slots. The first length - 1 slots are mirrored past the end of the ring, so the latest
+//! length frames are always one strided block and the window is handed out without copying. A view stays valid for
+//! the configured number of further pushes, which gives the consumer time to upload it.
+class ClipBuffer
+{
+public:
+    //! Sample type of tensor data
+    enum class Precision {
+        Float32,  //!< 32-bit float
+        Float16,  //!< IEEE half float
+    };
+
+    //! Buffer configuration
+    struct Config {
+        int width = 384;                           //!< Model input width
+        int height = 224;                          //!< Model input height
+        int length = 32;                           //!< Frames in window
+        int slack = 4;                             //!< Pushes a view stays valid for
+        Precision precision = Precision::Float32;  //!< Sample type
+    };
+
+    //! Strided view of latest window with shape (1, 3, length, height, width). Channel order is that of input frames.
+    struct View {
+        const void* data = nullptr;        //!< First sample of window
+        std::array<int64_t, 5> shape{};    //!< Tensor shape N, C, T, H, W
+        std::array<int64_t, 5> strides{};  //!< Strides in bytes
+        int64_t firstFrame = 0;            //!< Sequence number of oldest frame in window
+    };
+
+    //! Construct buffer with default configuration
+    ClipBuffer();
+
+    //! Construct buffer with given configuration
+    ClipBuffer(const Config& config);
+
+    // Disable copy, move and assign
+    ClipBuffer(const ClipBuffer& other) = delete;
+    ClipBuffer(const ClipBuffer&& other) = delete;
+    ClipBuffer& operator=(const ClipBuffer& other) = delete;
+    ClipBuffer& operator=(const ClipBuffer&& other) = delete;
+
+    //! Resize, normalize and append 8-bit frame with 3 or 4 channels. Extra channel is ignored. Call from one thread.
+    void push(const uint8_t* data, int width, int height, int rowStride, int channels);
+
+    //! Get view of latest length frames. Returns false until enough frames are pushed.
+    bool getView(View& outView) const;
+
+    //! Return pushed frame count
+    int64_t getFrameCount() const;
+
+    //! Drop all frames
+    void clear();
+
+    //! Return configuration
+    const Config& getConfig() const { return m_config; }
+
+private:
+    //! Prepare bilinear taps for input size
+    void prepareTaps(int width, int height);
+
+    //! Write resized row of one channel into slot
+    template <typename T>
+    void storeRow(const int32_t* row0, const int32_t* row1, int weight1, int channel, int slot, int y);
+
+private:
+    const Config m_config;        //!< Buffer configuration
+    const int m_slotCount;        //!< Ring slots, length + slack
+    const int m_planeSlots;       //!< Slots per channel plane including mirrored ones
+    const size_t m_sampleSize;    //!< Bytes per sample
+    std::vector<uint8_t> m_data;  //!< Channel planes of frame slots
+
+    mutable std::mutex m_mutex;  //!< Lock for frame count
+    int64_t m_frameCount = 0;    //!< Pushed frames
+
+    // Resize state, used by pushing thread
+    int m_inWidth = 0;                      //!< Input width of taps
+    int m_inHeight = 0;                     //!< Input height of taps
+    std::vector<int> m_xOffsets;            //!< Left source column of each output column
+    std::vector<int16_t> m_xWeights;        //!< Right source column weight, 11-bit fixed point
+    std::vector<int> m_yOffsets;            //!< Top source row of each output row
+    std::vector<int16_t> m_yWeights;        //!< Bottom source row weight, 11-bit fixed point
+    std::vector<int32_t> m_rows;            //!< Horizontally resized source rows, two per channel
+    std::array<float, 256> m_floatLut{};    //!< Normalized float of 8-bit value
+    std::array<uint16_t, 256> m_halfLut{};  //!< Normalized half of 8-bit value
+};
+
+}  // namespace VarjoExamples
@@ -6,11 +6,15 @@
 
 #include "DataStreamer.hpp"
 
-#include <fstream>
 #include <string>
 #include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
 
-#include <DirectXPackedVector.h>
+#include "FrameConversion.hpp"
+#include "FrameTrace.hpp"
 
 namespace
 {
@@ -26,175 +30,58 @@ const char* c_bufferFilenames[] = {"left", "right"};
 // Channel flags for channel indices
 const varjo_ChannelFlag c_channelFlags[] = {varjo_ChannelFlag_First, varjo_ChannelFlag_Second};
 
-// Convert YUV to RGB
-inline void convertYUVtoRGB(int Y, int U, int V, int& R, int& G, int& B)
-{
-    int C = Y - 16;
-    int D = U - 128;
-    int E = V - 128;
-    R = (298 * C + 409 * E + 128) >> 8;
-    G = (298 * C - 100 * D - 208 * E + 128) >> 8;
-    B = (298 * C + 516 * D + 128) >> 8;
-}
+// Gaze samples read per color frame. Gaze runs at up to 200 Hz, so this covers several dropped frames.
+constexpr int32_t c_gazeBatchSize = 64;
 
-// Save varjo buffer data as BMP image file
-void saveBMP(const std::string& filename, const varjo_BufferMetadata& buffer, void* cpuData)
-{
-    LOG_DEBUG("Saving buffer to file: %s", filename.c_str());
-
-    std::ofstream outFile(filename, std::ofstream::binary);
-
-    if (!outFile.good()) {
-        LOG_ERROR("Opening file for writing failed: %s", filename.c_str());
-        return;
-    }
+// Reference EV of exposure normalization if not configured, a lit indoor scene
+constexpr double c_defaultReferenceEV = 6.0;
 
-    constexpr int32_t components = 4;
+// Capture options file in working directory, next to the frames folder
+const char* c_captureConfigFile = "capture.cfg";
 
-    // Write BMP headers
-    BITMAPFILEHEADER bmFileHdr;
-    bmFileHdr.bfType = *(reinterpret_cast<const WORD*>("BM"));
-    bmFileHdr.bfSize = sizeof(BITMAPFILEHEADER) + sizeof(BITMAPINFOHEADER) + (components * buffer.width * buffer.height);
-    bmFileHdr.bfOffBits = sizeof(BITMAPFILEHEADER) + sizeof(BITMAPINFOHEADER);
-    outFile.write(reinterpret_cast<const char*>(&bmFileHdr), sizeof(bmFileHdr));
-    if (!outFile.good()) {
-        LOG_ERROR("Writing to bitmap file failed: %s", filename.c_str());
-        return;
+// Read "key = value" lines of capture options file. Empty lines and lines starting with '#' are skipped.
+std::map<std::string, std::string> readCaptureConfig(const std::string& filename)
+{
+    std::map<std::string, std::string> options;
+    std::ifstream file(filename);
+    std::string line;
+    while (std::getline(file, line)) {
+        const auto trim = [](const std::string& str) {
+            const size_t begin = str.find_first_not_of(" \t\r");
+            return (begin == std::string::npos) ? std::string() : str.substr(begin, str.find_last_not_of(" \t\r") - begin + 1);
+        };
+        const size_t separator = line.find('=');
+        const std::string key = trim(line.substr(0, separator));
+        if (key.empty() || key[0] == '#' || separator == std::string::npos) {
+            continue;
+        }
+        options[key] = trim(line.substr(separator + 1));
     }
+    return options;
+}
 
-    BITMAPINFOHEADER bmInfoHdr;
-    bmInfoHdr.biSize = sizeof(BITMAPINFOHEADER);
-    bmInfoHdr.biWidth = buffer.width;
-    bmInfoHdr.biHeight = buffer.height;
-    bmInfoHdr.biPlanes = 1;
-    bmInfoHdr.biBitCount = 32;
-    bmInfoHdr.biCompression = BI_RGB;
-    bmInfoHdr.biSizeImage = 0;
-    bmInfoHdr.biXPelsPerMeter = bmInfoHdr.biYPelsPerMeter = 2835;
-    bmInfoHdr.biClrImportant = bmInfoHdr.biClrUsed = 0;
-    outFile.write(reinterpret_cast<const char*>(&bmInfoHdr), sizeof(bmInfoHdr));
-    if (!outFile.good()) {
-        LOG_ERROR("Writing to bitmap file failed: %s", filename.c_str());
-        return;
+// Return integer option, fallback if missing or invalid
+int getIntOption(const std::map<std::string, std::string>& options, const std::string& key, int fallback)
+{
+    auto it = options.find(key);
+    if (it == options.end()) {
+        return fallback;
     }
+    char* end = nullptr;
+    const long value = std::strtol(it->second.c_str(), &end, 10);
+    return (end != it->second.c_str() && *end == '\0') ? static_cast<int>(value) : fallback;
+}
 
-    switch (buffer.format) {
-        case varjo_TextureFormat_RGBA16_FLOAT: {
-            // Background color for alpha blending
-            const float rgbBackground[3] = {0.25f, 0.45f, 0.40f};
-
-            // Convert half float to uint8
-            const DirectX::PackedVector::HALF* halfSrc = reinterpret_cast<const DirectX::PackedVector::HALF*>(cpuData);
-            halfSrc += buffer.byteSize / sizeof(DirectX::PackedVector::HALF);
-            for (int32_t y = 0; y < buffer.height; y++) {
-                halfSrc -= buffer.rowStride / sizeof(DirectX::PackedVector::HALF);
-                std::vector<uint8_t> line(buffer.width * components);
-                for (int32_t x = 0; x < buffer.width * components; x += components) {
-                    // Streamed RGB values are in linear colorspace so we gamma correct them for screen here
-                    constexpr float gamma = 1.0f / 2.2f;
-
-                    // Read alpha
-                    const float alpha = DirectX::PackedVector::XMConvertHalfToFloat(halfSrc[x + 3]);
-
-                    // Read value, gamma correct, alpha blend to background color, write to output in BMP byte order
-                    for (int32_t c = 0; c < 3; c++) {
-                        float value = powf(DirectX::PackedVector::XMConvertHalfToFloat(halfSrc[x + c]), gamma);
-                        value = value * alpha + rgbBackground[c] * (1.0f - alpha);
-                        line[x + (2 - c)] = static_cast<uint8_t>(std::max(0.0f, std::min(255.0f, 255.0f * value)));
-                    }
-
-                    // Write alpha
-                    line[x + 3] = 255;
-                    // line[x + 3] = static_cast<uint8_t>(max(0, min(255, 255.0 * alpha)));
-                }
-
-                // Write line to file
-                outFile.write(reinterpret_cast<const char*>(line.data()), line.size());
-                if (!outFile.good()) {
-                    LOG_ERROR("Writing to bitmap file failed: %s", filename.c_str());
-                    return;
-                }
-            }
-        } break;
-
-        case varjo_TextureFormat_YUV422: {
-            // Convert YUV422 to RGBA8
-            const uint8_t* b = reinterpret_cast<const uint8_t*>(cpuData);
-            b += (buffer.rowStride * buffer.height);
-            const uint32_t uvOffs = (buffer.rowStride * buffer.height);
-            for (int32_t y = 0; y < buffer.height; y++) {
-                std::vector<uint8_t> line(buffer.width * components);
-                b -= buffer.rowStride;
-                size_t lineOffs = 0;
-                for (int32_t x = 0; x < buffer.width; x++) {
-                    int Y = b[x];
-                    auto uvX = x - (x & 1);
-                    int U = b[uvX + 0 + uvOffs];
-                    int V = b[uvX + 1 + uvOffs];
-
-                    int R, G, B;
-                    convertYUVtoRGB(Y, U, V, R, G, B);
-
-                    // Write RGBA in BMP byteorder
-                    line[lineOffs + 2] = std::max(std::min(R, 255), 0);
-                    line[lineOffs + 1] = std::max(std::min(G, 255), 0);
-                    line[lineOffs + 0] = std::max(std::min(B, 255), 0);
-                    line[lineOffs + 3] = 255;
-                    lineOffs += components;
-                }
-                outFile.write(reinterpret_cast<const char*>(line.data()), line.size());
-                if (!outFile.good()) {
-                    LOG_ERROR("Writing to bitmap file failed: %s", filename.c_str());
-                    return;
-                }
-            }
-        } break;
-
-        case varjo_TextureFormat_NV12: {
-            // Convert YUV420 NV12 to RGBA8
-            const uint8_t* bY = reinterpret_cast<const uint8_t*>(cpuData);
-            bY += (buffer.rowStride * buffer.height);
-            const uint8_t* bUV = bY + (buffer.rowStride * (buffer.height >> 1));
-
-            for (int32_t y = 0; y < buffer.height; y++) {
-                std::vector<uint8_t> line(buffer.width * components);
-                bY -= buffer.rowStride;
-                if ((y & 1) == 0) {
-                    bUV -= buffer.rowStride;
-                }
-                size_t lineOffs = 0;
-                for (int32_t x = 0; x < buffer.width; x++) {
-                    int Y = bY[x];
-
-                    auto uvX = x - (x & 1);
-                    int U = bUV[uvX + 0];
-                    int V = bUV[uvX + 1];
-
-                    int R, G, B;
-                    convertYUVtoRGB(Y, U, V, R, G, B);
-
-                    // Write RGBA in BMP byteorder
-                    line[lineOffs + 2] = std::max(std::min(R, 255), 0);
-                    line[lineOffs + 1] = std::max(std::min(G, 255), 0);
-                    line[lineOffs + 0] = std::max(std::min(B, 255), 0);
-                    line[lineOffs + 3] = 255;
-                    lineOffs += components;
-                }
-                outFile.write(reinterpret_cast<const char*>(line.data()), line.size());
-                if (!outFile.good()) {
-                    LOG_ERROR("Writing to bitmap file failed: %s", filename.c_str());
-                    return;
-                }
-            }
-        } break;
-
-        default: {
-            CRITICAL("Unsupported pixel format: %d", static_cast<int>(buffer.format));
-        } break;
+// Return floating point option, fallback if missing or invalid
+double getDoubleOption(const std::map<std::string, std::string>& options, const std::string& key, double fallback)
+{
+    auto it = options.find(key);
+    if (it == options.end()) {
+        return fallback;
     }
-
-    outFile.close();
-    LOG_INFO("File saved succesfully: %s", filename.c_str());
+    char* end = nullptr;
+    const double value = std::strtod(it->second.c_str(), &end);
+    return (end != it->second.c_str() && *end == '\0' && std::isfinite(value)) ? value : fallback;
 }
 
 }  // namespace
@@ -205,6 +92,7 @@ DataStreamer::DataStreamer(varjo_Session* session)
     : m_session(session)
     , m_hmdPose(toVarjoMatrix(glm::mat4(0.0f)))
 {
+    applyCaptureConfig(c_captureConfigFile);
 }
 
 DataStreamer::~DataStreamer()
@@ -221,6 +109,15 @@ DataStreamer::~DataStreamer()
         varjo_StopDataStream(m_session, streamId);
     }
 
+    // Recorder stops with the streamer, keep its samples for replay
+    if (m_gazeRecorder) {
+        m_gazeData.recorder = nullptr;
+        m_gazeRecorder->stop();
+        if (m_gazeRecorder->writeLog(m_gazeLogFile)) {
+            LOG_INFO("Gaze log written: %s, samples=%llu", m_gazeLogFile.c_str(), static_cast<unsigned long long>(m_gazeRecorder->getStats().samples));
+        }
+    }
+
     // Reset session
     m_session = nullptr;
 }
@@ -363,7 +260,7 @@ void DataStreamer::handleDelayedBuffers(bool ignore)
     if (!ignore) {
         LOG_DEBUG("Handling delayed stream buffers: count=%d", m_streamData.delayedBuffers.size());
         for (auto& db : m_streamData.delayedBuffers) {
-            storeBuffer(db.type, db.streamId, db.channelIndex, db.frameNumber, db.bufferId, db.buffer, db.cpuBuffer, db.baseName);
+            storeBuffer(db.type, db.streamId, db.channelIndex, db.trace, db.normalization, db.bufferId, db.buffer, db.cpuBuffer, db.baseName);
         }
     } else {
         LOG_DEBUG("Ignoring delayed stream buffers: count=%d", m_streamData.delayedBuffers.size());
@@ -395,8 +292,9 @@ void DataStreamer::printStreamConfigs() const
     LOG_INFO("");
 }
 
-void DataStreamer::storeBuffer(varjo_StreamType type, varjo_StreamId streamId, varjo_ChannelIndex channelIdx, int64_t frameNumber, varjo_BufferId bufferId,
-    varjo_BufferMetadata& buffer, void* cpuData, const std::string& baseName)
+void DataStreamer::storeBuffer(varjo_StreamType type, varjo_StreamId streamId, varjo_ChannelIndex channelIdx, const FrameTrace& trace,
+    const FrameNormalization& normalization, varjo_BufferId bufferId, varjo_BufferMetadata& buffer, void* cpuData,
+    const std::string& baseName)
 {
     // Check that stream hasnot been stopped and removed already
     if (m_streamData.frameCounts.count({streamId, channelIdx}) == 0) {
@@ -415,8 +313,21 @@ void DataStreamer::storeBuffer(varjo_StreamType type, varjo_StreamId streamId, v
                 //baseName + "_sid" + std::to_string(streamId) + "_frm" + std::to_string(frameNumber) + "_bid" + std::to_string(bufferId) + ".bmp";
 
 		if (frameCount % 60 == 0) {
-			std::string fileName = "frames/" + baseName + ".bmp";
-			saveBMP(fileName, buffer, cpuData);
+			if (m_gazeContingentCapture && type == varjo_StreamType_DistortedColor) {
+				// Full resolution only around the gaze point, centered on the frame if gaze is not known
+				glm::ivec2 fixation;
+				const bool gazeValid = getFixation(channelIdx, buffer.width, buffer.height, fixation);
+				std::string fileName = "frames/" + baseName + ".fov";
+				saveBufferFoveal(fileName, buffer, cpuData, fixation, gazeValid, m_gazeData.config, &JobSystem::getShared(), &normalization);
+			} else {
+				std::string fileName = "frames/" + baseName + ".bmp";
+				saveBufferBMP(fileName, buffer, cpuData, &JobSystem::getShared(), &normalization);
+			}
+
+			// Publish trace next to snapshot for the detector
+			FrameTrace published = trace;
+			published.stamp(TraceStage::Publish);
+			writeTraceFile("frames/" + baseName + ".trace", published);
 		}
         //}
 
@@ -429,6 +340,10 @@ void DataStreamer::storeBuffer(varjo_StreamType type, varjo_StreamId streamId, v
 
             memcpy(m_latestCubemapFrame.data.data(), cpuData, buffer.byteSize);
             m_latestCubemapFrame.metadata = buffer;
+
+            if (m_equirectData.enabled && frameCount % m_equirectData.interval == 0) {
+                storeEquirect(trace, buffer, cpuData);
+            }
         }
 
         frameCount++;
@@ -446,8 +361,8 @@ void DataStreamer::storeBuffer(varjo_StreamType type, varjo_StreamId streamId, v
     CHECK_VARJO_ERR(m_session);
 }
 
-void DataStreamer::handleBuffer(
-    varjo_StreamType type, varjo_StreamId streamId, varjo_ChannelIndex channelIdx, int64_t frameNumber, varjo_BufferId bufferId, const std::string& baseName)
+void DataStreamer::handleBuffer(varjo_StreamType type, varjo_StreamId streamId, varjo_ChannelIndex channelIdx, const FrameTrace& trace,
+    const FrameNormalization& normalization, varjo_BufferId bufferId, const std::string& baseName)
 {
     // Lock buffer
     varjo_LockDataStreamBuffer(m_session, bufferId);
@@ -466,7 +381,8 @@ void DataStreamer::handleBuffer(
         delayedBuffer.type = type;
         delayedBuffer.streamId = streamId;
         delayedBuffer.channelIndex = channelIdx;
-        delayedBuffer.frameNumber = frameNumber;
+        delayedBuffer.trace = trace;
+        delayedBuffer.normalization = normalization;
         delayedBuffer.bufferId = bufferId;
         delayedBuffer.baseName = baseName;
         delayedBuffer.buffer = meta;
@@ -477,7 +393,7 @@ void DataStreamer::handleBuffer(
 
     } else {
         // Handle buffer immediately
-        storeBuffer(type, streamId, channelIdx, frameNumber, bufferId, meta, cpuData, baseName);
+        storeBuffer(type, streamId, channelIdx, trace, normalization, bufferId, meta, cpuData, baseName);
     }
 }
 
@@ -534,8 +450,30 @@ void DataStreamer::onDataStreamFrame(const varjo_StreamFrame* frame, varjo_Sessi
             m_frameExposure.wbNormalizationData = frame->metadata.distortedColor.wbNormalizationData;
             m_frameExposure.valid = true;
 
+            // Normalization from this frame's exposure, delayed buffers keep it with the buffer
+            FrameNormalization normalization;
+            if (m_normalizationData.enabled) {
+                normalization = getFrameNormalization(
+                    frame->metadata.distortedColor.ev, frame->metadata.distortedColor.wbNormalizationData, m_normalizationData.referenceEV);
+            }
+
             // Store HMD pose
             m_hmdPose = frame->hmdPose;
+            if (m_gazeData.recorder) {
+                m_gazeData.recorder->updateHeadPose(frame->hmdPose);
+            }
+
+            // Start frame trace. Exposure time is converted to trace clock by the frame age in Varjo time.
+            FrameTrace trace;
+            trace.frameNumber = frame->frameNumber;
+            trace.sensorTimestamp = frame->metadata.distortedColor.timestamp;
+            const int64_t captureTime = traceNow();
+            trace.stamp(TraceStage::Exposure, captureTime - (varjo_GetCurrentTime(session) - trace.sensorTimestamp));
+            trace.stamp(TraceStage::Capture, captureTime);
+
+            if (m_gazeContingentCapture) {
+                updateFrameGaze(session, trace.sensorTimestamp);
+            }
 
             std::vector<varjo_ChannelIndex> channelIndices;
             if (frame->channels & varjo_ChannelFlag_Left) {
@@ -549,13 +487,17 @@ void DataStreamer::onDataStreamFrame(const varjo_StreamFrame* frame, varjo_Sessi
             for (const varjo_ChannelIndex& channelIndex : channelIndices) {
                 LOG_DEBUG("  Channel index: #%lld", channelIndex);
 
+                // Store calibration for mapping gaze into the frame
+                CameraCalibration& camera = m_gazeData.cameras[channelIndex];
+                camera.valid = (frame->dataFlags & varjo_DataFlag_Extrinsics) && (frame->dataFlags & varjo_DataFlag_Intrinsics);
+
                 if (frame->dataFlags & varjo_DataFlag_Extrinsics) {
-                    varjo_Matrix extrinsics = varjo_GetCameraExtrinsics(session, frame->id, frame->frameNumber, channelIndex);
+                    camera.extrinsics = varjo_GetCameraExtrinsics(session, frame->id, frame->frameNumber, channelIndex);
                     CHECK_VARJO_ERR(m_session);
                 }
 
                 if (frame->dataFlags & varjo_DataFlag_Intrinsics) {
-                    varjo_CameraIntrinsics intrinsics = varjo_GetCameraIntrinsics(session, frame->id, frame->frameNumber, channelIndex);
+                    camera.intrinsics = varjo_GetCameraIntrinsics(session, frame->id, frame->frameNumber, channelIndex);
                     CHECK_VARJO_ERR(m_session);
                 }
 
@@ -580,7 +522,8 @@ void DataStreamer::onDataStreamFrame(const varjo_StreamFrame* frame, varjo_Sessi
 
                 // Only handle buffer if the channel was requested
                 if (requestedChannelFlags & c_channelFlags[channelIndex]) {
-                    handleBuffer(frame->type, frame->id, channelIndex, frame->frameNumber, bufferId, std::string(c_bufferFilenames[channelIndex]));
+                    handleBuffer(frame->type, frame->id, channelIndex, trace, normalization, bufferId,
+                        std::string(c_bufferFilenames[channelIndex]));
                 }
             }
         } break;
@@ -601,7 +544,15 @@ void DataStreamer::onDataStreamFrame(const varjo_StreamFrame* frame, varjo_Sessi
                 return;
             }
 
-            handleBuffer(frame->type, frame->id, varjo_ChannelIndex_First, frame->frameNumber, bufferId, "cube");
+            FrameTrace trace;
+            trace.frameNumber = frame->frameNumber;
+            trace.sensorTimestamp = frame->metadata.environmentCubemap.timestamp;
+            const int64_t captureTime = traceNow();
+            trace.stamp(TraceStage::Exposure, captureTime - (varjo_GetCurrentTime(session) - trace.sensorTimestamp));
+            trace.stamp(TraceStage::Capture, captureTime);
+
+            // Cubemap is already in absolute luminance, so it is not normalized
+            handleBuffer(frame->type, frame->id, varjo_ChannelIndex_First, trace, FrameNormalization(), bufferId, "cube");
 
         } break;
 
@@ -611,6 +562,189 @@ void DataStreamer::onDataStreamFrame(const varjo_StreamFrame* frame, varjo_Sessi
     }
 }
 
+void DataStreamer::applyCaptureConfig(const std::string& filename)
+{
+    const auto options = readCaptureConfig(filename);
+    if (options.empty()) {
+        return;
+    }
+    LOG_INFO("Capture options: %s", filename.c_str());
+
+    // Recorder goes first, gaze-contingent capture then looks up frame gaze from it
+    auto gazeLog = options.find("gaze_log");
+    if (gazeLog != options.end() && !gazeLog->second.empty()) {
+        auto recorder = std::make_unique<GazeRecorder>();
+        if (recorder->start(m_session)) {
+            m_gazeRecorder = std::move(recorder);
+            m_gazeLogFile = gazeLog->second;
+            m_gazeLogInterval = std::max(getDoubleOption(options, "gaze_log_interval", 0.0), 0.0);
+            setGazeRecorder(m_gazeRecorder.get());
+        }
+    }
+
+    // Snapshots use the normalization, so it is set before the capture options below
+    if (getIntOption(options, "exposure_normalization", 0) != 0) {
+        setExposureNormalization(true, getDoubleOption(options, "reference_ev", c_defaultReferenceEV));
+    }
+
+    if (getIntOption(options, "equirect", 0) != 0) {
+        EquirectConverter::Config equirectConfig;
+        equirectConfig.width = std::max(getIntOption(options, "equirect_width", equirectConfig.width), 0);
+        equirectConfig.height = std::max(getIntOption(options, "equirect_height", equirectConfig.height), 0);
+        setEquirectCapture(true, equirectConfig, getIntOption(options, "equirect_interval", 1));
+    }
+
+    if (getIntOption(options, "gaze_contingent", 0) != 0) {
+        FovealConfig fovealConfig;
+        fovealConfig.roiSize = std::max(getIntOption(options, "foveal_roi_size", fovealConfig.roiSize), 1);
+        fovealConfig.peripheryScale = std::max(getIntOption(options, "foveal_periphery_scale", fovealConfig.peripheryScale), 1);
+        setGazeContingentCapture(true, fovealConfig);
+    }
+}
+
+void DataStreamer::setGazeContingentCapture(bool enabled, const FovealConfig& config)
+{
+    // Frame callback comes from different thread, lock streaming data
+    std::lock_guard<std::recursive_mutex> streamLock(m_streamData.mutex);
+
+    if (enabled && !m_gazeData.initialized) {
+        if (!varjo_IsGazeAllowed(m_session)) {
+            LOG_ERROR("Gaze-contingent capture failed: gaze tracking not allowed");
+            return;
+        }
+
+        // Gaze may already be initialized by the application
+        varjo_GazeInit(m_session);
+        const varjo_Error error = varjo_GetError(m_session);
+        if (error != varjo_NoError && error != varjo_Error_GazeAlreadyInitialized) {
+            LOG_ERROR("Gaze-contingent capture failed: %s", varjo_GetErrorDesc(error));
+            return;
+        }
+
+        m_gazeData.samples.resize(c_gazeBatchSize);
+        m_gazeData.initialized = true;
+    }
+
+    m_gazeData.config = config;
+    m_gazeData.frameGazeValid = false;
+    m_gazeContingentCapture = enabled;
+    LOG_INFO("Gaze-contingent capture %s: roi=%d, peripheryScale=%d", enabled ? "enabled" : "disabled", config.roiSize, config.peripheryScale);
+}
+
+void DataStreamer::setGazeRecorder(GazeRecorder* recorder)
+{
+    // Frame callback comes from different thread, lock streaming data
+    std::lock_guard<std::recursive_mutex> streamLock(m_streamData.mutex);
+    m_gazeData.recorder = recorder;
+}
+
+void DataStreamer::setEquirectCapture(bool enabled, const EquirectConverter::Config& config, int interval)
+{
+    // Frame callback comes from different thread, lock streaming data
+    std::lock_guard<std::recursive_mutex> streamLock(m_streamData.mutex);
+    m_equirectData.enabled = enabled;
+    m_equirectData.config = config;
+    m_equirectData.interval = std::max(interval, 1);
+    m_equirectData.converter.reset();
+    LOG_INFO("Equirect capture %s: output=%dx%d, interval=%d", enabled ? "enabled" : "disabled", config.width, config.height, m_equirectData.interval);
+}
+
+void DataStreamer::storeEquirect(const FrameTrace& trace, const varjo_BufferMetadata& buffer, const void* cpuData)
+{
+    // Tables depend on face size, which is known only from the first frame
+    if (!m_equirectData.converter || m_equirectData.converter->getFaceSize() != buffer.width) {
+        m_equirectData.converter = std::make_unique<EquirectConverter>(buffer.width, m_equirectData.config);
+    }
+
+    // Snapshot file is named by frame number, so a detector reading the trace of one frame can never open the image
+    // of another or one still being written. The trace is published once the image is complete.
+    const std::string filename = "frames/cube_equirect_" + std::to_string(trace.frameNumber) + ".bmp";
+    if (m_equirectData.converter->saveBMP(filename, buffer, cpuData, &JobSystem::getShared())) {
+        FrameTrace published = trace;
+        published.stamp(TraceStage::Publish);
+        if (writeTraceFile("frames/cube_equirect.trace", published)) {
+            // Snapshots the detector still has open cannot be deleted on Windows, those are retried with the next one
+            auto& staleFiles = m_equirectData.staleFiles;
+            staleFiles.erase(std::remove_if(staleFiles.begin(), staleFiles.end(),
+                                 [](const std::string& staleFile) {
+                                     std::error_code error;
+                                     return std::filesystem::remove(staleFile, error) || !std::filesystem::exists(staleFile, error);
+                                 }),
+                staleFiles.end());
+            staleFiles.push_back(filename);
+        } else {
+            std::error_code error;
+            std::filesystem::remove(filename, error);
+        }
+    }
+
+    // The detector ranks changes by gaze at replay, while the recorder still runs
+    const auto now = std::chrono::steady_clock::now();
+    if (m_gazeRecorder && m_gazeLogInterval > 0.0 && now - m_gazeLogTime >= std::chrono::duration<double>(m_gazeLogInterval)) {
+        m_gazeLogTime = now;
+        m_gazeRecorder->writeLog(m_gazeLogFile);
+    }
+}
+
+void DataStreamer::setExposureNormalization(bool enabled, double referenceEV)
+{
+    // Frame callback comes from different thread, lock streaming data
+    std::lock_guard<std::recursive_mutex> streamLock(m_streamData.mutex);
+    m_normalizationData.enabled = enabled;
+    m_normalizationData.referenceEV = referenceEV;
+    LOG_INFO("Exposure normalization %s: referenceEV=%.2f", enabled ? "enabled" : "disabled", referenceEV);
+}
+
+bool DataStreamer::isExposureNormalizationEnabled() const
+{
+    // Frame callback comes from different thread, lock streaming data
+    std::lock_guard<std::recursive_mutex> streamLock(m_streamData.mutex);
+    return m_normalizationData.enabled;
+}
+
+void DataStreamer::updateFrameGaze(varjo_Session* session, int64_t frameTimestamp)
+{
+    // Recorder has the full gaze history, closest sample may also come after the frame
+    if (m_gazeData.recorder) {
+        GazeRecorder::Sample sample;
+        m_gazeData.frameGazeValid = m_gazeData.recorder->getSampleAt(frameTimestamp, m_gazeData.config.maxGazeAge, sample) && sample.isValid();
+        if (m_gazeData.frameGazeValid) {
+            m_gazeData.frameGaze = GazeRecorder::toVarjoGaze(sample);
+        }
+        return;
+    }
+
+    // Gaze runs faster than the camera, so read all samples since previous frame in one call
+    const int32_t count = varjo_GetGazeArray(session, m_gazeData.samples.data(), static_cast<int32_t>(m_gazeData.samples.size()));
+    CHECK_VARJO_ERR(m_session);
+
+    if (const varjo_Gaze* gaze = selectGaze(m_gazeData.samples.data(), count, frameTimestamp, m_gazeData.config.maxGazeAge)) {
+        m_gazeData.frameGaze = *gaze;
+    }
+
+    // Gaze of a previous frame is kept while close enough in time
+    m_gazeData.frameGazeValid = (m_gazeData.frameGaze.status == varjo_GazeStatus_Valid) &&
+                                (std::abs(m_gazeData.frameGaze.captureTime - frameTimestamp) <= m_gazeData.config.maxGazeAge);
+}
+
+bool DataStreamer::getFixation(varjo_ChannelIndex channelIdx, int width, int height, glm::ivec2& outFixation) const
+{
+    outFixation = glm::ivec2(width / 2, height / 2);
+    if (!m_gazeData.frameGazeValid || channelIdx < 0 || channelIdx >= static_cast<varjo_ChannelIndex>(m_gazeData.cameras.size())) {
+        return false;
+    }
+
+    const CameraCalibration& camera = m_gazeData.cameras[channelIdx];
+    glm::dvec2 pixel;
+    if (!camera.valid ||
+        !projectGazeToImage(m_gazeData.frameGaze, camera.extrinsics, camera.intrinsics, width, height, m_gazeData.config.defaultFocusDistance, pixel)) {
+        return false;
+    }
+
+    outFixation = glm::ivec2(pixel);
+    return true;
+}
+
 varjo_StreamId DataStreamer::startStreaming(varjo_StreamType type, varjo_TextureFormat format, varjo_ChannelFlag channels)
 {
     varjo_StreamId streamId = varjo_InvalidId;
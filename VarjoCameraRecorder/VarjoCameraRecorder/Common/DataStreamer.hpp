@@ -9,10 +9,17 @@
 #include <atomic>
 #include <array>
 #include <chrono>
+#include <memory>
 
 #include <Varjo_datastream.h>
 
 #include "Globals.hpp"
+#include "FrameTrace.hpp"
+#include "EquirectConverter.hpp"
+#include "FovealCapture.hpp"
+#include "FrameConversion.hpp"
+#include "GazeRecorder.hpp"
+#include "JobSystem.hpp"
 
 namespace VarjoExamples
 {
@@ -38,7 +45,7 @@ public:
     //! Construct data streamer
     DataStreamer(varjo_Session* session);
 
-    //! Destruct data streamer. Cleans up running data streams.
+    //! Destruct data streamer. Cleans up running data streams and writes the gaze log of capture options.
     ~DataStreamer();
 
     // Disable copy, move and assign
@@ -86,6 +93,29 @@ public:
     //! Get latest cube map frame
     bool getCubemapFrame(CubemapFrame& frame) const;
 
+    //! Set gaze-contingent capture. When enabled, color snapshots are stored as two-level foveal files with full
+    //! resolution only around the gaze point. Initializes gaze tracking on first enable.
+    void setGazeContingentCapture(bool enabled, const FovealConfig& config = FovealConfig());
+
+    //! Is gaze-contingent capture enabled
+    bool isGazeContingentCaptureEnabled() const { return m_gazeContingentCapture; }
+
+    //! Set gaze recorder fed with color frame HMD poses, null to detach. The recorder drains the gaze queue, so
+    //! gaze-contingent capture then looks up frame gaze from it by timestamp instead of reading the queue itself.
+    void setGazeRecorder(GazeRecorder* recorder);
+
+    //! Set equirect capture. When enabled, every interval-th environment cubemap frame is converted to an
+    //! equirectangular BMP snapshot for the 360 change detector, next to the cubemap face snapshot.
+    void setEquirectCapture(bool enabled, const EquirectConverter::Config& config = EquirectConverter::Config(), int interval = 1);
+
+    //! Set exposure normalization of color frames. When enabled, snapshots are converted to the reference EV with neutral
+    //! white balance using the exposure and white balance data of their own frame, so frame differencing does not see
+    //! camera exposure changes as motion.
+    void setExposureNormalization(bool enabled, double referenceEV);
+
+    //! Is exposure normalization enabled
+    bool isExposureNormalizationEnabled() const;
+
     //! Return status line
     std::string getStatusLine() const { return isStreaming() ? (m_statusLine.empty() ? "Not streaming." : m_statusLine) : "Not streaming."; }
 
@@ -97,12 +127,15 @@ private:
     void onDataStreamFrame(const varjo_StreamFrame* frame, varjo_Session* session);
 
     //! Handle frame buffer
-    void handleBuffer(varjo_StreamType type, varjo_StreamId streamId, varjo_ChannelIndex channelIdx, int64_t frameNumber, varjo_BufferId bufferId,
-        const std::string& baseName);
+    void handleBuffer(varjo_StreamType type, varjo_StreamId streamId, varjo_ChannelIndex channelIdx, const FrameTrace& trace,
+        const FrameNormalization& normalization, varjo_BufferId bufferId, const std::string& baseName);
 
     //! Store buffer contents to file
-    void storeBuffer(varjo_StreamType type, varjo_StreamId streamId, varjo_ChannelIndex channelIdx, int64_t frameNumber, varjo_BufferId bufferId,
-        varjo_BufferMetadata& buffer, void* cpuData, const std::string& baseName);
+    void storeBuffer(varjo_StreamType type, varjo_StreamId streamId, varjo_ChannelIndex channelIdx, const FrameTrace& trace,
+        const FrameNormalization& normalization, varjo_BufferId bufferId, varjo_BufferMetadata& buffer, void* cpuData, const std::string& baseName);
+
+    //! Convert cubemap buffer and save it as equirect snapshot with its trace
+    void storeEquirect(const FrameTrace& trace, const varjo_BufferMetadata& buffer, const void* cpuData);
 
     //! Find data stream of given type and texture format and start it
     varjo_StreamId startStreaming(varjo_StreamType streamType, varjo_TextureFormat streamFormat, varjo_ChannelFlag channels);
@@ -110,13 +143,26 @@ private:
     //! Get streaming ID
     std::pair<varjo_StreamId, varjo_ChannelFlag> getStreamingIdAndChannel(varjo_StreamType streamType, varjo_TextureFormat streamFormat) const;
 
+    //! Apply capture options of given file. Features not listed in the file stay disabled.
+    void applyCaptureConfig(const std::string& filename);
+
+    //! Read gaze samples since last frame and pick the one closest to frame timestamp
+    void updateFrameGaze(varjo_Session* session, int64_t frameTimestamp);
+
+    //! Return fixation pixel in color frame of given channel. Returns false and frame center if gaze is not known.
+    bool getFixation(varjo_ChannelIndex channelIdx, int width, int height, glm::ivec2& outFixation) const;
+
 private:
+    //! Benchmark repeats stream handling on stream data without a session
+    friend class CaptureBenchmark;
+
     //! Delayed buffer info structure
     struct DelayedBuffer {
         varjo_StreamType type;                                       //!< Stream type for this buffer
         varjo_StreamId streamId = varjo_InvalidId;                   //!< Stream Id for this buffer
         varjo_ChannelIndex channelIndex = varjo_ChannelIndex_First;  //!< Channel index
-        int64_t frameNumber = 0;                                     //!< Buffer frame number
+        FrameTrace trace;                                            //!< Buffer frame trace
+        FrameNormalization normalization;                            //!< Exposure normalization of buffer frame
         std::string baseName;                                        //!< Base filename
         varjo_BufferId bufferId = varjo_InvalidId;                   //!< Varjo buffer identifier
         varjo_BufferMetadata buffer;                                 //!< Varjo buffer metadata
@@ -133,13 +179,54 @@ private:
         std::vector<DelayedBuffer> delayedBuffers;                                     //!< List of delayed buffers
     };
 
-    varjo_Session* m_session = nullptr;                //!< Varjo session
-    std::atomic_bool m_delayedBufferHandling = false;  //!< Flag for delayed buffer handling
-    StreamData m_streamData;                           //!< Stream data
-    ExposureAdjustments m_frameExposure;               //!< Latest known frame exposure adjustments (updated when color stream running)
-    varjo_Matrix m_hmdPose;                            //!< Latest HMD pose
-    CubemapFrame m_latestCubemapFrame;                 //!< Latest cubemap frame
-    std::string m_statusLine;                          //!< Streaming status line
+    //! Camera calibration of latest color frame
+    struct CameraCalibration {
+        bool valid = false;                   //!< Are intrinsics and extrinsics valid
+        varjo_CameraIntrinsics intrinsics{};  //!< Camera intrinsics
+        varjo_Matrix extrinsics{};            //!< Camera pose in HMD space
+    };
+
+    //! Gaze data for gaze-contingent capture
+    struct GazeData {
+        bool initialized = false;                  //!< Gaze tracking initialized
+        FovealConfig config;                       //!< Foveal encoding config
+        std::vector<varjo_Gaze> samples;           //!< Gaze samples read per frame
+        varjo_Gaze frameGaze{};                    //!< Gaze sample of latest color frame
+        bool frameGazeValid = false;               //!< Is frame gaze valid and close to frame timestamp
+        std::array<CameraCalibration, 2> cameras;  //!< Calibration per color channel
+        GazeRecorder* recorder = nullptr;          //!< Gaze recorder, not owned
+    };
+
+    //! Exposure normalization of color frames
+    struct NormalizationData {
+        bool enabled = false;      //!< Exposure normalization enabled
+        double referenceEV = 0.0;  //!< EV frames are normalized to
+    };
+
+    //! Equirect capture of cubemap frames
+    struct EquirectData {
+        bool enabled = false;                          //!< Equirect capture enabled
+        EquirectConverter::Config config;              //!< Converter configuration
+        int interval = 1;                              //!< Cubemap frames between snapshots
+        std::unique_ptr<EquirectConverter> converter;  //!< Converter for current face size, created on first frame
+        std::vector<std::string> staleFiles;           //!< Replaced snapshots still to be deleted
+    };
+
+    varjo_Session* m_session = nullptr;                   //!< Varjo session
+    std::atomic_bool m_delayedBufferHandling = false;     //!< Flag for delayed buffer handling
+    StreamData m_streamData;                              //!< Stream data
+    ExposureAdjustments m_frameExposure;                  //!< Latest known frame exposure adjustments (updated when color stream running)
+    varjo_Matrix m_hmdPose;                               //!< Latest HMD pose
+    CubemapFrame m_latestCubemapFrame;                    //!< Latest cubemap frame
+    std::string m_statusLine;                             //!< Streaming status line
+    std::atomic_bool m_gazeContingentCapture = false;     //!< Flag for gaze-contingent capture
+    GazeData m_gazeData;                                  //!< Gaze data, locked with stream data
+    EquirectData m_equirectData;                          //!< Equirect capture, locked with stream data
+    NormalizationData m_normalizationData;                //!< Exposure normalization, locked with stream data
+    std::unique_ptr<GazeRecorder> m_gazeRecorder;         //!< Gaze recorder created from capture options
+    std::string m_gazeLogFile;                            //!< Gaze log written by destructor
+    double m_gazeLogInterval = 0.0;                       //!< Seconds between gaze log refreshes with equirect snapshots, 0 for none
+    std::chrono::steady_clock::time_point m_gazeLogTime;  //!< Last gaze log refresh
 
     //! Stream statistics
     struct {
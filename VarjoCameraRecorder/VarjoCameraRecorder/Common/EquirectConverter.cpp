@@ -0,0 +1,252 @@
+#include "EquirectConverter.hpp"
+
+#include <emmintrin.h>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+
+#include <glm/gtc/constants.hpp>
+
+#include "FrameConversion.hpp"
+
+namespace
+{
+// Faces in the cubemap buffer
+constexpr int c_faceCount = 6;
+
+// Floats per texel
+constexpr int c_components = 4;
+
+// Rows converted per job
+constexpr int64_t c_rowsPerJob = 16;
+
+// Bilinear weight scale
+constexpr double c_weightScale = 65536.0;
+
+// Run rows [0, height) through body, split over jobs on the low-latency lane if given
+void forRows(int height, VarjoExamples::JobSystem* jobs, const std::function<void(int y0, int y1)>& body)
+{
+    if (!jobs) {
+        body(0, height);
+        return;
+    }
+    jobs->parallelFor(
+        0, height, c_rowsPerJob, [&](int64_t begin, int64_t end) { body(static_cast<int>(begin), static_cast<int>(end)); },
+        VarjoExamples::JobSystem::Priority::LowLatency);
+}
+
+// Cube map face and face coordinates in [-1, 1] of world direction. Faces follow the D3D cube convention with the
+// front face on +Z, so world -Z maps to cube +Z. Face coordinates grow right and down in the face image.
+int getFace(const glm::dvec3& direction, double& s, double& t)
+{
+    const glm::dvec3 c(direction.x, direction.y, -direction.z);
+    const glm::dvec3 a = glm::abs(c);
+    if (a.x >= a.y && a.x >= a.z) {
+        s = (c.x > 0.0 ? -c.z : c.z) / a.x;
+        t = -c.y / a.x;
+        return c.x > 0.0 ? 0 : 1;
+    }
+    if (a.y >= a.z) {
+        s = c.x / a.y;
+        t = (c.y > 0.0 ? c.z : -c.z) / a.y;
+        return c.y > 0.0 ? 2 : 3;
+    }
+    s = (c.z > 0.0 ? c.x : -c.x) / a.z;
+    t = -c.y / a.z;
+    return c.z > 0.0 ? 4 : 5;
+}
+
+// World direction of face coordinates, inverse of getFace. Coordinates may extend past the face edge.
+glm::dvec3 getDirection(int face, double s, double t)
+{
+    glm::dvec3 c;
+    switch (face) {
+        case 0: c = glm::dvec3(1.0, -t, -s); break;
+        case 1: c = glm::dvec3(-1.0, -t, s); break;
+        case 2: c = glm::dvec3(s, 1.0, t); break;
+        case 3: c = glm::dvec3(s, -1.0, -t); break;
+        case 4: c = glm::dvec3(s, -t, 1.0); break;
+        default: c = glm::dvec3(-s, -t, -1.0); break;
+    }
+    return glm::dvec3(c.x, c.y, -c.z);
+}
+
+// Texel index of face texel. Texels off the face are taken from the face the texel center direction falls on.
+uint32_t getTexel(int face, int x, int y, int size)
+{
+    if (x < 0 || y < 0 || x >= size || y >= size) {
+        double s, t;
+        face = getFace(getDirection(face, (x + 0.5) * 2.0 / size - 1.0, (y + 0.5) * 2.0 / size - 1.0), s, t);
+        x = std::min(std::max(static_cast<int>(std::floor((s + 1.0) * 0.5 * size)), 0), size - 1);
+        y = std::min(std::max(static_cast<int>(std::floor((t + 1.0) * 0.5 * size)), 0), size - 1);
+    }
+    return static_cast<uint32_t>((face * size + y) * size + x);
+}
+
+}  // namespace
+
+namespace VarjoExamples
+{
+EquirectConverter::EquirectConverter(int faceSize)
+    : EquirectConverter(faceSize, Config())
+{
+}
+
+EquirectConverter::EquirectConverter(int faceSize, const Config& config)
+    : m_faceSize(faceSize)
+    , m_config(config)
+{
+    m_width = config.width > 0 ? config.width : faceSize * 4;
+    m_height = config.height > 0 ? config.height : (m_width + 1) / 2;
+    if (faceSize <= 0 || m_width <= 0 || m_height <= 0) {
+        CRITICAL("Invalid equirect conversion: face=%d, output=%dx%d", faceSize, m_width, m_height);
+    }
+
+    // Taps per output pixel from pixel center direction
+    m_taps.resize(static_cast<size_t>(m_width) * m_height);
+    for (int y = 0; y < m_height; y++) {
+        const double pitch = glm::half_pi<double>() - (y + 0.5) / m_height * glm::pi<double>();
+        for (int x = 0; x < m_width; x++) {
+            const double yaw = (x + 0.5) / m_width * glm::two_pi<double>() - glm::pi<double>();
+            const glm::dvec3 direction(std::cos(pitch) * std::sin(yaw), std::sin(pitch), -std::cos(pitch) * std::cos(yaw));
+
+            double s, t;
+            const int face = getFace(direction, s, t);
+            const double px = (s + 1.0) * 0.5 * faceSize - 0.5;
+            const double py = (t + 1.0) * 0.5 * faceSize - 0.5;
+            const int x0 = static_cast<int>(std::floor(px));
+            const int y0 = static_cast<int>(std::floor(py));
+
+            Tap& tap = m_taps[static_cast<size_t>(y) * m_width + x];
+            tap.offsets[0] = getTexel(face, x0, y0, faceSize) * c_components;
+            tap.offsets[1] = getTexel(face, x0 + 1, y0, faceSize) * c_components;
+            tap.offsets[2] = getTexel(face, x0, y0 + 1, faceSize) * c_components;
+            tap.offsets[3] = getTexel(face, x0 + 1, y0 + 1, faceSize) * c_components;
+            tap.fx = static_cast<uint16_t>(std::min(std::round((px - x0) * c_weightScale), c_weightScale - 1.0));
+            tap.fy = static_cast<uint16_t>(std::min(std::round((py - y0) * c_weightScale), c_weightScale - 1.0));
+        }
+    }
+
+    // Streamed values are linear, gamma correct them for 8-bit output
+    constexpr float gamma = 1.0f / 2.2f;
+    for (size_t i = 0; i < m_gammaLut.size(); i++) {
+        const float value = powf(static_cast<float>(i) / (m_gammaLut.size() - 1), gamma);
+        m_gammaLut[i] = static_cast<uint8_t>(std::round(255.0f * value));
+    }
+}
+
+void EquirectConverter::convert(const varjo_BufferMetadata& buffer, const void* cpuData, std::vector<float>& outPixels, JobSystem* jobs)
+{
+    unpackFaces(buffer, cpuData, jobs);
+
+    outPixels.resize(static_cast<size_t>(m_width) * m_height * c_components);
+    const float* texels = m_texels.data();
+    float* out = outPixels.data();
+    forRows(m_height, jobs, [&](int y0, int y1) {
+        const __m128 weightScale = _mm_set1_ps(static_cast<float>(1.0 / c_weightScale));
+        for (int y = y0; y < y1; y++) {
+            const Tap* tap = &m_taps[static_cast<size_t>(y) * m_width];
+            float* line = out + static_cast<size_t>(y) * m_width * c_components;
+            for (int x = 0; x < m_width; x++, tap++) {
+                const __m128 fx = _mm_mul_ps(_mm_set1_ps(tap->fx), weightScale);
+                const __m128 fy = _mm_mul_ps(_mm_set1_ps(tap->fy), weightScale);
+                const __m128 a = _mm_loadu_ps(texels + tap->offsets[0]);
+                const __m128 b = _mm_loadu_ps(texels + tap->offsets[1]);
+                const __m128 c = _mm_loadu_ps(texels + tap->offsets[2]);
+                const __m128 d = _mm_loadu_ps(texels + tap->offsets[3]);
+                const __m128 top = _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), fx));
+                const __m128 bottom = _mm_add_ps(c, _mm_mul_ps(_mm_sub_ps(d, c), fx));
+                _mm_storeu_ps(line + x * c_components, _mm_add_ps(top, _mm_mul_ps(_mm_sub_ps(bottom, top), fy)));
+            }
+        }
+    });
+}
+
+void EquirectConverter::convertToBGRA(const varjo_BufferMetadata& buffer, const void* cpuData, std::vector<uint8_t>& outPixels, JobSystem* jobs)
+{
+    unpackFaces(buffer, cpuData, jobs);
+
+    outPixels.resize(static_cast<size_t>(m_width) * m_height * c_components);
+    const float* texels = m_texels.data();
+    uint8_t* out = outPixels.data();
+    forRows(m_height, jobs, [&](int y0, int y1) {
+        const __m128 weightScale = _mm_set1_ps(static_cast<float>(1.0 / c_weightScale));
+        const __m128 gain = _mm_setr_ps(m_config.exposure, m_config.exposure, m_config.exposure, 1.0f);
+        const __m128 colorMask = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 quantize = _mm_setr_ps(4095.0f, 4095.0f, 4095.0f, 255.0f);
+        alignas(16) int32_t values[4];
+
+        for (int y = y0; y < y1; y++) {
+            const Tap* tap = &m_taps[static_cast<size_t>(y) * m_width];
+            uint8_t* line = out + static_cast<size_t>(y) * m_width * c_components;
+            for (int x = 0; x < m_width; x++, tap++) {
+                const __m128 fx = _mm_mul_ps(_mm_set1_ps(tap->fx), weightScale);
+                const __m128 fy = _mm_mul_ps(_mm_set1_ps(tap->fy), weightScale);
+                const __m128 a = _mm_loadu_ps(texels + tap->offsets[0]);
+                const __m128 b = _mm_loadu_ps(texels + tap->offsets[1]);
+                const __m128 c = _mm_loadu_ps(texels + tap->offsets[2]);
+                const __m128 d = _mm_loadu_ps(texels + tap->offsets[3]);
+                const __m128 top = _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), fx));
+                const __m128 bottom = _mm_add_ps(c, _mm_mul_ps(_mm_sub_ps(d, c), fx));
+                __m128 value = _mm_max_ps(_mm_mul_ps(_mm_add_ps(top, _mm_mul_ps(_mm_sub_ps(bottom, top), fy)), gain), zero);
+
+                // Tone map color only, alpha is coverage
+                if (m_config.toneMap) {
+                    const __m128 mapped = _mm_div_ps(value, _mm_add_ps(value, one));
+                    value = _mm_or_ps(_mm_and_ps(colorMask, mapped), _mm_andnot_ps(colorMask, value));
+                }
+
+                value = _mm_min_ps(value, one);
+                _mm_store_si128(reinterpret_cast<__m128i*>(values), _mm_cvtps_epi32(_mm_mul_ps(value, quantize)));
+                uint8_t* pixel = line + x * c_components;
+                pixel[0] = m_gammaLut[values[2]];
+                pixel[1] = m_gammaLut[values[1]];
+                pixel[2] = m_gammaLut[values[0]];
+                pixel[3] = static_cast<uint8_t>(values[3]);
+            }
+        }
+    });
+}
+
+bool EquirectConverter::saveBMP(const std::string& filename, const varjo_BufferMetadata& buffer, const void* cpuData, JobSystem* jobs)
+{
+    LOG_DEBUG("Saving equirect buffer to file: %s", filename.c_str());
+
+    std::vector<uint8_t> pixels;
+    convertToBGRA(buffer, cpuData, pixels, jobs);
+    std::vector<uint8_t> bmp;
+    encodeBMP(pixels.data(), m_width, m_height, bmp);
+
+    std::ofstream outFile(filename, std::ofstream::binary);
+    outFile.write(reinterpret_cast<const char*>(bmp.data()), bmp.size());
+    if (!outFile.good()) {
+        LOG_ERROR("Writing equirect file failed: %s", filename.c_str());
+        return false;
+    }
+    return true;
+}
+
+void EquirectConverter::unpackFaces(const varjo_BufferMetadata& buffer, const void* cpuData, JobSystem* jobs)
+{
+    if (buffer.format != varjo_TextureFormat_RGBA16_FLOAT || buffer.width != m_faceSize || buffer.height != m_faceSize * c_faceCount ||
+        buffer.rowStride < m_faceSize * c_components * static_cast<int>(sizeof(uint16_t)) || !cpuData) {
+        CRITICAL("Invalid cubemap buffer: format=%d, %dx%d, stride=%d, face size=%d", static_cast<int>(buffer.format), buffer.width, buffer.height,
+            buffer.rowStride, m_faceSize);
+    }
+
+    const size_t rowFloats = static_cast<size_t>(m_faceSize) * c_components;
+    m_texels.resize(rowFloats * buffer.height);
+    const uint8_t* src = reinterpret_cast<const uint8_t*>(cpuData);
+    float* texels = m_texels.data();
+    forRows(buffer.height, jobs, [&](int y0, int y1) {
+        for (int y = y0; y < y1; y++) {
+            const uint16_t* halfSrc = reinterpret_cast<const uint16_t*>(src + static_cast<size_t>(y) * buffer.rowStride);
+            convertHalfToFloat(halfSrc, texels + y * rowFloats, rowFloats);
+        }
+    });
+}
+
+}  // namespace VarjoExamples
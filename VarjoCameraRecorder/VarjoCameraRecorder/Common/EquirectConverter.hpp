@@ -0,0 +1,88 @@
+#pragma once
+
+#include <array>
+#include <string>
+#include <vector>
+
+#include <Varjo_types_datastream.h>
+
+#include "Globals.hpp"
+#include "JobSystem.hpp"
+
+namespace VarjoExamples
+{
+//! Converts environment cubemap buffers to equirectangular images for the 360 change detector.
+//!
+//! Input is the RGBA16_FLOAT CPU buffer of the environment cubemap stream, six square faces packed into one column
+//! in the order right, left, top, bottom, front, back. Output is world aligned: forward (-Z) in the image center,
+//! yaw from -180 degrees at the left edge and up at the top row.
+//!
+//! The four bilinear taps and weights of every output pixel are precomputed once per size. Taps falling off a face
+//! edge are remapped to the texel of the neighbouring face in that direction, so sampling is continuous across seams
+//! without padded faces. Each conversion unpacks the half float faces once with SSE2 and then blends the taps as four
+//! float lanes per pixel. Not thread safe, use one converter per thread.
+class EquirectConverter
+{
+public:
+    //! Converter configuration
+    struct Config {
+        int width = 0;          //!< Output width, 0 for four times face size
+        int height = 0;         //!< Output height, 0 for half of width
+        float exposure = 1.0f;  //!< Linear gain before 8-bit conversion, 1 maps 100 cd/m^2 to white
+        bool toneMap = true;    //!< Compress highlights with Reinhard curve for 8-bit output, otherwise clip
+    };
+
+    //! Construct converter for cubemap face size. Throws on invalid size.
+    EquirectConverter(int faceSize, const Config& config);
+
+    //! Construct converter for cubemap face size with default config
+    EquirectConverter(int faceSize);
+
+    // Disable copy, move and assign
+    EquirectConverter(const EquirectConverter& other) = delete;
+    EquirectConverter(const EquirectConverter&& other) = delete;
+    EquirectConverter& operator=(const EquirectConverter& other) = delete;
+    EquirectConverter& operator=(const EquirectConverter&& other) = delete;
+
+    //! Convert cubemap buffer to linear RGBA float rows, alpha is cubemap coverage. Splits over rows on jobs if given.
+    //! Throws if buffer is not an RGBA16_FLOAT cubemap of the converter face size.
+    void convert(const varjo_BufferMetadata& buffer, const void* cpuData, std::vector<float>& outPixels, JobSystem* jobs = nullptr);
+
+    //! Convert cubemap buffer to gamma corrected BGRA8 rows with exposure and optional tone mapping. Splits over rows on
+    //! jobs if given. Throws if buffer is not an RGBA16_FLOAT cubemap of the converter face size.
+    void convertToBGRA(const varjo_BufferMetadata& buffer, const void* cpuData, std::vector<uint8_t>& outPixels, JobSystem* jobs = nullptr);
+
+    //! Convert cubemap buffer to BGRA8 and save it as BMP image file. Returns false on write failure. Throws on buffer mismatch.
+    bool saveBMP(const std::string& filename, const varjo_BufferMetadata& buffer, const void* cpuData, JobSystem* jobs = nullptr);
+
+    //! Return cubemap face size
+    int getFaceSize() const { return m_faceSize; }
+
+    //! Return output width
+    int getWidth() const { return m_width; }
+
+    //! Return output height
+    int getHeight() const { return m_height; }
+
+private:
+    //! Bilinear taps of output pixel
+    struct Tap {
+        std::array<uint32_t, 4> offsets;  //!< Float offsets of top left, top right, bottom left and bottom right texels
+        uint16_t fx = 0;                  //!< Horizontal weight in 1/65536
+        uint16_t fy = 0;                  //!< Vertical weight in 1/65536
+    };
+
+    //! Unpack half float faces to float texels. Throws on buffer mismatch.
+    void unpackFaces(const varjo_BufferMetadata& buffer, const void* cpuData, JobSystem* jobs);
+
+private:
+    const int m_faceSize;                  //!< Cubemap face size
+    const Config m_config;                 //!< Converter configuration
+    int m_width = 0;                       //!< Output width
+    int m_height = 0;                      //!< Output height
+    std::vector<Tap> m_taps;               //!< Taps per output pixel
+    std::vector<float> m_texels;           //!< Unpacked RGBA faces
+    std::array<uint8_t, 4096> m_gammaLut;  //!< Gamma correction of [0, 1] in 4096 steps
+};
+
+}  // namespace VarjoExamples
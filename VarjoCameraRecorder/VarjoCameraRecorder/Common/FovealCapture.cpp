@@ -0,0 +1,364 @@
+#include "FovealCapture.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iterator>
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include "FrameConversion.hpp"
+#include "QoiCodec.hpp"
+
+namespace
+{
+// File magic "FOVL" and format version
+constexpr uint32_t c_fovealMagic = 0x4C564F46;
+constexpr uint16_t c_fovealVersion = 1;
+
+// Header flag for region following gaze
+constexpr uint32_t c_flagGazeValid = 1;
+
+// Header size in bytes
+constexpr size_t c_headerSize = 48;
+
+// Pixel size
+constexpr int c_components = 4;
+
+// Rows per job when downsampling and reconstructing
+constexpr int64_t c_rowsPerJob = 64;
+
+// Append little endian value
+template <typename T>
+inline void append(std::vector<uint8_t>& out, T value)
+{
+    for (size_t i = 0; i < sizeof(T); i++) {
+        out.push_back(static_cast<uint8_t>(static_cast<uint64_t>(value) >> (8 * i)));
+    }
+}
+
+// Read little endian value
+template <typename T>
+inline const uint8_t* get(const uint8_t* in, T& value)
+{
+    uint64_t v = 0;
+    for (size_t i = 0; i < sizeof(T); i++) {
+        v |= static_cast<uint64_t>(in[i]) << (8 * i);
+    }
+    value = static_cast<T>(v);
+    return in + sizeof(T);
+}
+
+// Run rows [0, height) through body, split over jobs on the low-latency lane if given
+void forRows(int height, VarjoExamples::JobSystem* jobs, const std::function<void(int y0, int y1)>& body)
+{
+    if (!jobs) {
+        body(0, height);
+        return;
+    }
+    jobs->parallelFor(
+        0, height, c_rowsPerJob, [&](int64_t begin, int64_t end) { body(static_cast<int>(begin), static_cast<int>(end)); },
+        VarjoExamples::JobSystem::Priority::LowLatency);
+}
+
+// Average periphery rows [y0, y1) from full frame
+void downsampleRows(const uint8_t* pixels, int width, int height, int scale, uint8_t* out, int y0, int y1)
+{
+    const int outWidth = (width + scale - 1) / scale;
+    for (int py = y0; py < y1; py++) {
+        const int sy0 = py * scale;
+        const int sy1 = std::min(sy0 + scale, height);
+        for (int px = 0; px < outWidth; px++) {
+            const int sx0 = px * scale;
+            const int sx1 = std::min(sx0 + scale, width);
+            uint32_t sum[c_components] = {};
+            for (int sy = sy0; sy < sy1; sy++) {
+                const uint8_t* src = pixels + (static_cast<size_t>(sy) * width + sx0) * c_components;
+                for (int sx = sx0; sx < sx1; sx++, src += c_components) {
+                    for (int c = 0; c < c_components; c++) {
+                        sum[c] += src[c];
+                    }
+                }
+            }
+            const uint32_t count = static_cast<uint32_t>((sy1 - sy0) * (sx1 - sx0));
+            uint8_t* dst = out + (static_cast<size_t>(py) * outWidth + px) * c_components;
+            for (int c = 0; c < c_components; c++) {
+                dst[c] = static_cast<uint8_t>((sum[c] + count / 2) / count);
+            }
+        }
+    }
+}
+
+// Upsample periphery rows [y0, y1) of full frame bilinearly
+void upsampleRows(const VarjoExamples::FovealFrame& frame, uint8_t* out, int y0, int y1)
+{
+    const int pw = frame.getPeripheryWidth();
+    const int ph = frame.getPeripheryHeight();
+    const float invScale = 1.0f / frame.scale;
+    const uint8_t* src = frame.periphery.data();
+
+    for (int y = y0; y < y1; y++) {
+        const float fy = std::max((y + 0.5f) * invScale - 0.5f, 0.0f);
+        const int iy0 = std::min(static_cast<int>(fy), ph - 1);
+        const int iy1 = std::min(iy0 + 1, ph - 1);
+        const float wy = fy - iy0;
+        const uint8_t* row0 = src + static_cast<size_t>(iy0) * pw * c_components;
+        const uint8_t* row1 = src + static_cast<size_t>(iy1) * pw * c_components;
+        uint8_t* dst = out + static_cast<size_t>(y) * frame.width * c_components;
+
+        for (int x = 0; x < frame.width; x++, dst += c_components) {
+            const float fx = std::max((x + 0.5f) * invScale - 0.5f, 0.0f);
+            const int ix0 = std::min(static_cast<int>(fx), pw - 1);
+            const int ix1 = std::min(ix0 + 1, pw - 1);
+            const float wx = fx - ix0;
+            for (int c = 0; c < c_components; c++) {
+                const float top = row0[ix0 * c_components + c] + (row0[ix1 * c_components + c] - row0[ix0 * c_components + c]) * wx;
+                const float bottom = row1[ix0 * c_components + c] + (row1[ix1 * c_components + c] - row1[ix0 * c_components + c]) * wx;
+                dst[c] = static_cast<uint8_t>(top + (bottom - top) * wy + 0.5f);
+            }
+        }
+    }
+}
+
+}  // namespace
+
+namespace VarjoExamples
+{
+bool projectGazeToImage(const varjo_Gaze& gaze, const varjo_Matrix& extrinsics, const varjo_CameraIntrinsics& intrinsics, int width, int height,
+    double defaultFocusDistance, glm::dvec2& outPixel)
+{
+    // Gaze point in HMD space, flipping gaze +Z forward to -Z forward
+    const double distance = gaze.focusDistance > 0.0 ? gaze.focusDistance : defaultFocusDistance;
+    const glm::dvec3 origin(gaze.gaze.origin[0], gaze.gaze.origin[1], -gaze.gaze.origin[2]);
+    const glm::dvec3 forward(gaze.gaze.forward[0], gaze.gaze.forward[1], -gaze.gaze.forward[2]);
+    const glm::dvec4 hmdPoint(origin + glm::normalize(forward) * distance, 1.0);
+
+    // Camera space point with OpenCV axes: +X right, +Y down, +Z forward
+    const glm::dvec4 cameraPoint = glm::inverse(glm::make_mat4(extrinsics.value)) * hmdPoint;
+    const glm::dvec3 point(cameraPoint.x, -cameraPoint.y, -cameraPoint.z);
+    const double length = glm::length(point);
+    if (length <= 0.0) {
+        return false;
+    }
+
+    // Omnidir projection: unit sphere, shifted by xi, radial and tangential distortion
+    const double k1 = intrinsics.distortionCoefficients[0];
+    const double k2 = intrinsics.distortionCoefficients[1];
+    const double skew = intrinsics.distortionCoefficients[2];
+    const double xi = intrinsics.model == varjo_IntrinsicsModel_Omnidir ? intrinsics.distortionCoefficients[3] : 0.0;
+    const double p1 = intrinsics.distortionCoefficients[4];
+    const double p2 = intrinsics.distortionCoefficients[5];
+
+    const glm::dvec3 sphere = point / length;
+    const double denominator = sphere.z + xi;
+    if (denominator <= 1e-6) {
+        return false;
+    }
+
+    const double x = sphere.x / denominator;
+    const double y = sphere.y / denominator;
+    const double r2 = x * x + y * y;
+    const double radial = 1.0 + k1 * r2 + k2 * r2 * r2;
+    const double xd = x * radial + 2.0 * p1 * x * y + p2 * (r2 + 2.0 * x * x);
+    const double yd = y * radial + p1 * (r2 + 2.0 * y * y) + 2.0 * p2 * x * y;
+
+    outPixel.x = (intrinsics.focalLengthX * xd + skew * yd + intrinsics.principalPointX) * width;
+    outPixel.y = (intrinsics.focalLengthY * yd + intrinsics.principalPointY) * height;
+    return outPixel.x >= 0.0 && outPixel.x < width && outPixel.y >= 0.0 && outPixel.y < height;
+}
+
+const varjo_Gaze* selectGaze(const varjo_Gaze* samples, int count, int64_t time, int64_t maxAge)
+{
+    const varjo_Gaze* best = nullptr;
+    int64_t bestDelta = maxAge;
+    for (int i = 0; i < count; i++) {
+        if (samples[i].status != varjo_GazeStatus_Valid) {
+            continue;
+        }
+        const int64_t delta = std::abs(samples[i].captureTime - time);
+        if (delta <= bestDelta) {
+            best = &samples[i];
+            bestDelta = delta;
+        }
+    }
+    return best;
+}
+
+void encodeFoveal(const uint8_t* pixels, int width, int height, const glm::ivec2& fixation, bool gazeValid, const FovealConfig& config,
+    FovealFrame& outFrame, JobSystem* jobs)
+{
+    outFrame.width = width;
+    outFrame.height = height;
+    outFrame.scale = std::max(config.peripheryScale, 1);
+    outFrame.gazeValid = gazeValid;
+    outFrame.fixation = glm::clamp(fixation, glm::ivec2(0), glm::ivec2(width - 1, height - 1));
+
+    // Region centered on fixation, shifted inside frame
+    const int roiWidth = std::min(std::max(config.roiSize, 1), width);
+    const int roiHeight = std::min(std::max(config.roiSize, 1), height);
+    const int roiX = std::min(std::max(outFrame.fixation.x - roiWidth / 2, 0), width - roiWidth);
+    const int roiY = std::min(std::max(outFrame.fixation.y - roiHeight / 2, 0), height - roiHeight);
+    outFrame.roi = glm::ivec4(roiX, roiY, roiWidth, roiHeight);
+
+    const size_t roiLineSize = static_cast<size_t>(roiWidth) * c_components;
+    outFrame.roiPixels.resize(roiLineSize * roiHeight);
+    for (int y = 0; y < roiHeight; y++) {
+        const uint8_t* src = pixels + (static_cast<size_t>(roiY + y) * width + roiX) * c_components;
+        std::copy(src, src + roiLineSize, outFrame.roiPixels.data() + y * roiLineSize);
+    }
+
+    outFrame.periphery.resize(static_cast<size_t>(outFrame.getPeripheryWidth()) * outFrame.getPeripheryHeight() * c_components);
+    forRows(outFrame.getPeripheryHeight(), jobs,
+        [&](int y0, int y1) { downsampleRows(pixels, width, height, outFrame.scale, outFrame.periphery.data(), y0, y1); });
+}
+
+void serializeFoveal(const FovealFrame& frame, std::vector<uint8_t>& out)
+{
+    std::vector<uint8_t> periphery;
+    encodeQoi(frame.periphery.data(), frame.getPeripheryWidth(), frame.getPeripheryHeight(), frame.getPeripheryWidth() * c_components,
+        c_components, false, periphery);
+    std::vector<uint8_t> roi;
+    encodeQoi(frame.roiPixels.data(), frame.roi.z, frame.roi.w, frame.roi.z * c_components, c_components, false, roi);
+
+    out.clear();
+    out.reserve(c_headerSize + periphery.size() + roi.size());
+    append<uint32_t>(out, c_fovealMagic);
+    append<uint16_t>(out, c_fovealVersion);
+    append<uint16_t>(out, static_cast<uint16_t>(frame.scale));
+    append<uint32_t>(out, frame.gazeValid ? c_flagGazeValid : 0);
+    append<uint32_t>(out, static_cast<uint32_t>(frame.width));
+    append<uint32_t>(out, static_cast<uint32_t>(frame.height));
+    append<int32_t>(out, frame.fixation.x);
+    append<int32_t>(out, frame.fixation.y);
+    append<uint32_t>(out, static_cast<uint32_t>(frame.roi.x));
+    append<uint32_t>(out, static_cast<uint32_t>(frame.roi.y));
+    append<uint32_t>(out, static_cast<uint32_t>(frame.roi.z));
+    append<uint32_t>(out, static_cast<uint32_t>(frame.roi.w));
+    append<uint32_t>(out, static_cast<uint32_t>(periphery.size()));
+    out.insert(out.end(), periphery.begin(), periphery.end());
+    append<uint32_t>(out, static_cast<uint32_t>(roi.size()));
+    out.insert(out.end(), roi.begin(), roi.end());
+}
+
+bool parseFoveal(const uint8_t* data, size_t size, FovealFrame& outFrame)
+{
+    if (size < c_headerSize) {
+        return false;
+    }
+
+    const uint8_t* end = data + size;
+    uint32_t magic = 0;
+    uint16_t version = 0;
+    uint16_t scale = 0;
+    uint32_t flags = 0;
+    uint32_t width = 0, height = 0;
+    uint32_t roiX = 0, roiY = 0, roiWidth = 0, roiHeight = 0;
+    uint32_t peripherySize = 0;
+    data = get(data, magic);
+    data = get(data, version);
+    data = get(data, scale);
+    if (magic != c_fovealMagic || version != c_fovealVersion || scale == 0) {
+        return false;
+    }
+
+    data = get(data, flags);
+    data = get(data, width);
+    data = get(data, height);
+    data = get(data, outFrame.fixation.x);
+    data = get(data, outFrame.fixation.y);
+    data = get(data, roiX);
+    data = get(data, roiY);
+    data = get(data, roiWidth);
+    data = get(data, roiHeight);
+    data = get(data, peripherySize);
+    if (width == 0 || height == 0 || roiWidth == 0 || roiHeight == 0 || roiX + roiWidth > width || roiY + roiHeight > height) {
+        return false;
+    }
+
+    outFrame.width = static_cast<int>(width);
+    outFrame.height = static_cast<int>(height);
+    outFrame.scale = scale;
+    outFrame.gazeValid = (flags & c_flagGazeValid) != 0;
+    outFrame.roi = glm::ivec4(roiX, roiY, roiWidth, roiHeight);
+
+    // Periphery stream, then region stream with its size prefix
+    if (static_cast<size_t>(end - data) < static_cast<size_t>(peripherySize) + sizeof(uint32_t)) {
+        return false;
+    }
+    const int pw = outFrame.getPeripheryWidth();
+    const int ph = outFrame.getPeripheryHeight();
+    outFrame.periphery.resize(static_cast<size_t>(pw) * ph * c_components);
+    if (!decodeQoi(data, peripherySize, outFrame.periphery.data(), pw, ph, pw * c_components, c_components)) {
+        return false;
+    }
+    data += peripherySize;
+
+    uint32_t roiSize = 0;
+    data = get(data, roiSize);
+    if (static_cast<size_t>(end - data) < roiSize) {
+        return false;
+    }
+    outFrame.roiPixels.resize(static_cast<size_t>(roiWidth) * roiHeight * c_components);
+    return decodeQoi(data, roiSize, outFrame.roiPixels.data(), outFrame.roi.z, outFrame.roi.w, outFrame.roi.z * c_components, c_components);
+}
+
+void reconstructFoveal(const FovealFrame& frame, std::vector<uint8_t>& outPixels, JobSystem* jobs)
+{
+    const size_t lineSize = static_cast<size_t>(frame.width) * c_components;
+    const size_t roiLineSize = static_cast<size_t>(frame.roi.z) * c_components;
+    outPixels.resize(lineSize * frame.height);
+    uint8_t* out = outPixels.data();
+
+    forRows(frame.height, jobs, [&](int y0, int y1) {
+        upsampleRows(frame, out, y0, y1);
+
+        // Paste region rows
+        for (int y = std::max(y0, frame.roi.y); y < std::min(y1, frame.roi.y + frame.roi.w); y++) {
+            const uint8_t* src = frame.roiPixels.data() + (y - frame.roi.y) * roiLineSize;
+            std::copy(src, src + roiLineSize, out + y * lineSize + static_cast<size_t>(frame.roi.x) * c_components);
+        }
+    });
+}
+
+size_t saveBufferFoveal(const std::string& filename, const varjo_BufferMetadata& buffer, const void* cpuData, const glm::ivec2& fixation,
+    bool gazeValid, const FovealConfig& config, JobSystem* jobs, const FrameNormalization* normalization)
+{
+    LOG_DEBUG("Saving foveal buffer to file: %s", filename.c_str());
+
+    std::vector<uint8_t> pixels;
+    convertBufferToBGRA(buffer, cpuData, pixels, jobs, normalization);
+    FovealFrame frame;
+    encodeFoveal(pixels.data(), buffer.width, buffer.height, fixation, gazeValid, config, frame, jobs);
+    std::vector<uint8_t> data;
+    serializeFoveal(frame, data);
+
+    std::ofstream outFile(filename, std::ofstream::binary);
+    outFile.write(reinterpret_cast<const char*>(data.data()), data.size());
+    if (!outFile.good()) {
+        LOG_ERROR("Writing foveal file failed: %s", filename.c_str());
+        return 0;
+    }
+    return data.size();
+}
+
+bool readFovealFile(const std::string& filename, std::vector<uint8_t>& outPixels, int& outWidth, int& outHeight)
+{
+    std::ifstream inFile(filename, std::ifstream::binary);
+    if (!inFile.good()) {
+        return false;
+    }
+    const std::vector<uint8_t> data((std::istreambuf_iterator<char>(inFile)), std::istreambuf_iterator<char>());
+
+    FovealFrame frame;
+    if (!parseFoveal(data.data(), data.size(), frame)) {
+        LOG_ERROR("Invalid foveal file: %s", filename.c_str());
+        return false;
+    }
+
+    reconstructFoveal(frame, outPixels);
+    outWidth = frame.width;
+    outHeight = frame.height;
+    return true;
+}
+
+}  // namespace VarjoExamples
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <Varjo_types.h>
+#include <Varjo_types_datastream.h>
+
+#include "Globals.hpp"
+#include "FrameConversion.hpp"
+#include "JobSystem.hpp"
+
+namespace VarjoExamples
+{
+//! Gaze-contingent two-level frame encoding: a full resolution region of interest around the fixation point and a
+//! downsampled periphery. With the default config a 2880x2720 frame keeps about a seventh of its pixels before
+//! QOI compression of both levels. The periphery also covers the region, so it can be upsampled on its own.
+//!
+//! Files are little-endian: magic "FOVL", version, periphery scale, flags, frame size, region rect, fixation pixel,
+//! then the periphery and region QOI streams each prefixed with their byte size. Pixels are BGRA8 as produced by
+//! convertBufferToBGRA.
+
+//! Foveal encoding configuration
+struct FovealConfig {
+    int roiSize = 768;                  //!< Full resolution region side in pixels
+    int peripheryScale = 4;             //!< Periphery downsampling factor
+    double defaultFocusDistance = 1.0;  //!< Gaze point distance in meters if gaze has no focus estimate
+    int64_t maxGazeAge = 50000000;      //!< Largest gaze to frame time difference in nanoseconds for a valid fixation
+};
+
+//! Two-level frame
+struct FovealFrame {
+    int width = 0;                   //!< Full frame width
+    int height = 0;                  //!< Full frame height
+    int scale = 1;                   //!< Periphery downsampling factor
+    bool gazeValid = false;          //!< Region follows gaze, otherwise centered on frame
+    glm::ivec2 fixation{0};          //!< Fixation pixel in full frame
+    glm::ivec4 roi{0};               //!< Region x, y, width, height in full frame
+    std::vector<uint8_t> periphery;  //!< Downsampled frame, BGRA8
+    std::vector<uint8_t> roiPixels;  //!< Full resolution region, BGRA8
+
+    //! Return periphery width
+    int getPeripheryWidth() const { return (width + scale - 1) / scale; }
+
+    //! Return periphery height
+    int getPeripheryHeight() const { return (height + scale - 1) / scale; }
+};
+
+//! Project gaze point into camera image of width x height pixels.
+//!
+//! The gaze ray is in HMD space with +Z forward and extended to the focus distance. Extrinsics are the camera pose
+//! in HMD space with -Z forward and +Y up, as HMD poses. Intrinsics follow the OpenCV omnidir model with principal
+//! point and focal lengths normalized to image size. Returns false if the point is behind the camera or outside
+//! the image.
+bool projectGazeToImage(const varjo_Gaze& gaze, const varjo_Matrix& extrinsics, const varjo_CameraIntrinsics& intrinsics, int width, int height,
+    double defaultFocusDistance, glm::dvec2& outPixel);
+
+//! Return sample of gaze array closest in time to given Varjo time with valid status, null if none is within maxAge
+const varjo_Gaze* selectGaze(const varjo_Gaze* samples, int count, int64_t time, int64_t maxAge);
+
+//! Split tightly packed BGRA8 frame into region around fixation and downsampled periphery, on jobs if given
+void encodeFoveal(const uint8_t* pixels, int width, int height, const glm::ivec2& fixation, bool gazeValid, const FovealConfig& config,
+    FovealFrame& outFrame, JobSystem* jobs = nullptr);
+
+//! Serialize frame as QOI compressed file contents
+void serializeFoveal(const FovealFrame& frame, std::vector<uint8_t>& out);
+
+//! Parse serialized frame. Returns false on bad magic, version or truncated data.
+bool parseFoveal(const uint8_t* data, size_t size, FovealFrame& outFrame);
+
+//! Reconstruct full size BGRA8 frame, upsampling periphery and pasting region over it
+void reconstructFoveal(const FovealFrame& frame, std::vector<uint8_t>& outPixels, JobSystem* jobs = nullptr);
+
+//! Convert CPU buffer data and save it as two-level file, converting on jobs and normalizing if given. Returns file
+//! size in bytes. Throws on unsupported format.
+size_t saveBufferFoveal(const std::string& filename, const varjo_BufferMetadata& buffer, const void* cpuData, const glm::ivec2& fixation,
+    bool gazeValid, const FovealConfig& config, JobSystem* jobs = nullptr, const FrameNormalization* normalization = nullptr);
+
+//! Read two-level file and reconstruct full size BGRA8 frame. Returns false if missing or invalid.
+bool readFovealFile(const std::string& filename, std::vector<uint8_t>& outPixels, int& outWidth, int& outHeight);
+
+}  // namespace VarjoExamples
@@ -0,0 +1,271 @@
+#include "FrameCache.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+#include "ImageDecoder.hpp"
+#include "OverlaySequence.hpp"
+
+namespace
+{
+// Reverse row order of tightly packed RGBA8 pixels in place
+void flipRows(std::vector<uint8_t>& pixels, int width, int height)
+{
+    const size_t rowBytes = static_cast<size_t>(width) * 4;
+    for (int y = 0; y < height / 2; y++) {
+        std::swap_ranges(pixels.begin() + y * rowBytes, pixels.begin() + (y + 1) * rowBytes, pixels.begin() + (height - 1 - y) * rowBytes);
+    }
+}
+
+}  // namespace
+
+namespace VarjoExamples
+{
+FrameCache::FrameCache(Decoder decoder, size_t budgetBytes, int workerCount, int prefetchDepth)
+    : m_decoder(std::move(decoder))
+    , m_budgetBytes(budgetBytes)
+    , m_prefetchDepth(std::max(prefetchDepth, 0))
+{
+    for (int i = 0; i < workerCount; i++) {
+        m_workers.emplace_back(&FrameCache::workerLoop, this);
+    }
+}
+
+FrameCache::~FrameCache()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+        m_queue.clear();
+    }
+    m_workCondition.notify_all();
+
+    for (auto& worker : m_workers) {
+        worker.join();
+    }
+}
+
+void FrameCache::setFrameRange(int64_t first, int64_t last)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_firstIndex = first;
+    m_lastIndex = last;
+}
+
+FrameCache::FramePtr FrameCache::get(int64_t index)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    // Track scrub direction from consecutive requests
+    if (m_prevRequest >= 0 && index != m_prevRequest) {
+        m_direction = (index > m_prevRequest) ? 1 : -1;
+    }
+    m_prevRequest = index;
+
+    // Wait for worker if frame is already being decoded
+    if (m_inFlight.count(index) && !m_entries.count(index)) {
+        m_stats.waits++;
+        m_loadedCondition.wait(lock, [&] { return m_inFlight.count(index) == 0; });
+    }
+
+    auto it = m_entries.find(index);
+    if (it != m_entries.end()) {
+        m_stats.hits++;
+        touch(it->second, index);
+        FramePtr frame = it->second.frame;
+        schedulePrefetch(index);
+        return frame;
+    }
+
+    // Miss: decode on calling thread without holding the lock
+    m_stats.misses++;
+    m_inFlight.insert(index);
+    schedulePrefetch(index);
+    const uint64_t generation = m_generation;
+    lock.unlock();
+
+    auto frame = std::make_shared<Frame>();
+    frame->index = index;
+    const bool decoded = decode(index, *frame);
+
+    lock.lock();
+    m_inFlight.erase(index);
+    m_loadedCondition.notify_all();
+    if (!decoded) {
+        return nullptr;
+    }
+    if (generation == m_generation) {
+        insert(frame);
+    }
+    return frame;
+}
+
+FrameCache::FramePtr FrameCache::tryGet(int64_t index)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_entries.find(index);
+    if (it == m_entries.end()) {
+        return nullptr;
+    }
+    touch(it->second, index);
+    return it->second.frame;
+}
+
+void FrameCache::clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_queue.clear();
+    m_entries.clear();
+    m_lru.clear();
+    m_stats.frameCount = 0;
+    m_stats.byteSize = 0;
+    m_prevRequest = -1;
+    m_generation++;
+}
+
+FrameCache::Stats FrameCache::getStats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+FrameCache::Decoder FrameCache::createFileDecoder(const std::string& pathFormat)
+{
+    return [pathFormat](int64_t index, Frame& outFrame) {
+        char path[1024];
+        snprintf(path, sizeof(path), pathFormat.c_str(), static_cast<long long>(index));
+        return decodeImageFile(path, outFrame.width, outFrame.height, outFrame.pixels);
+    };
+}
+
+FrameCache::Decoder FrameCache::createBundleDecoder(std::shared_ptr<const ReplayBundleReader> bundle, int track)
+{
+    // Overlay tracks hold keyframes and deltas, decoded through a sequence that keeps the last reconstructed frame
+    if (track >= 0 && track < static_cast<int>(bundle->getTracks().size()) &&
+        bundle->getTracks()[track].type == ReplayBundle::TrackType::Overlay) {
+        std::shared_ptr<OverlaySequence> sequence = OverlaySequence::fromBundle(bundle, track);
+        if (!sequence) {
+            return [](int64_t, Frame&) { return false; };
+        }
+        return [sequence](int64_t index, Frame& outFrame) { return sequence->decode(index, outFrame.width, outFrame.height, outFrame.pixels); };
+    }
+
+    return [bundle, track](int64_t index, Frame& outFrame) {
+        const auto view = bundle->getFrame(track, index);
+        if (!view.data) {
+            return false;
+        }
+        return decodeImageMemory(view.data, view.size, outFrame.width, outFrame.height, outFrame.pixels);
+    };
+}
+
+void FrameCache::workerLoop()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        m_workCondition.wait(lock, [&] { return m_stop || !m_queue.empty(); });
+        if (m_stop) {
+            break;
+        }
+
+        const int64_t index = m_queue.front();
+        m_queue.pop_front();
+        if (m_entries.count(index) || m_inFlight.count(index)) {
+            continue;
+        }
+
+        m_inFlight.insert(index);
+        const uint64_t generation = m_generation;
+        lock.unlock();
+
+        auto frame = std::make_shared<Frame>();
+        frame->index = index;
+        const bool decoded = decode(index, *frame);
+
+        lock.lock();
+        m_inFlight.erase(index);
+        // Frames decoded before clear() may come from replaced data
+        if (decoded && generation == m_generation) {
+            m_stats.prefetched++;
+            insert(frame);
+        }
+        m_loadedCondition.notify_all();
+    }
+}
+
+bool FrameCache::decode(int64_t index, Frame& outFrame) const
+{
+    if (!m_decoder(index, outFrame)) {
+        return false;
+    }
+    if (outFrame.width <= 0 || outFrame.height <= 0 || outFrame.pixels.size() != static_cast<size_t>(outFrame.width) * outFrame.height * 4) {
+        LOG_ERROR("Decoded frame has invalid size: index=%lld, size=(%d, %d), bytes=%zu", static_cast<long long>(index), outFrame.width,
+            outFrame.height, outFrame.pixels.size());
+        return false;
+    }
+
+    // Decoders produce top row first, Unity raw texture data starts from the bottom row
+    flipRows(outFrame.pixels, outFrame.width, outFrame.height);
+    return true;
+}
+
+void FrameCache::schedulePrefetch(int64_t index)
+{
+    if (m_workers.empty() || m_prefetchDepth == 0) {
+        return;
+    }
+
+    // Previous predictions are stale once the slider moves
+    m_queue.clear();
+
+    auto enqueue = [&](int64_t i) {
+        if (i >= m_firstIndex && i <= m_lastIndex && !m_entries.count(i) && !m_inFlight.count(i)) {
+            m_queue.push_back(i);
+        }
+    };
+
+    // Nearest frames in scrub direction first, then one frame behind for direction reversals
+    for (int step = 1; step <= m_prefetchDepth; step++) {
+        enqueue(index + m_direction * step);
+    }
+    enqueue(index - m_direction);
+
+    if (!m_queue.empty()) {
+        m_workCondition.notify_all();
+    }
+}
+
+void FrameCache::insert(const FramePtr& frame)
+{
+    auto it = m_entries.find(frame->index);
+    if (it != m_entries.end()) {
+        touch(it->second, frame->index);
+        return;
+    }
+
+    m_lru.push_front(frame->index);
+    m_entries[frame->index] = {frame, m_lru.begin()};
+    m_stats.byteSize += frame->getByteSize();
+    m_stats.frameCount = m_entries.size();
+
+    // Evict least recently used frames over budget. Outstanding FramePtrs stay valid.
+    while (m_stats.byteSize > m_budgetBytes && m_lru.size() > 1) {
+        const int64_t victim = m_lru.back();
+        m_lru.pop_back();
+
+        auto victimIt = m_entries.find(victim);
+        m_stats.byteSize -= victimIt->second.frame->getByteSize();
+        m_entries.erase(victimIt);
+        m_stats.evicted++;
+    }
+    m_stats.frameCount = m_entries.size();
+}
+
+void FrameCache::touch(Entry& entry, int64_t index)
+{
+    m_lru.erase(entry.lruIter);
+    m_lru.push_front(index);
+    entry.lruIter = m_lru.begin();
+}
+
+}  // namespace VarjoExamples
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "Globals.hpp"
+#include "ReplayBundle.hpp"
+
+namespace VarjoExamples
+{
+//! LRU cache of decoded replay frames with predictive prefetch for slider scrubbing.
+//! Frames are decoded to tightly packed RGBA8, bottom row first, so they can be uploaded as Unity raw texture data as is.
+class FrameCache
+{
+public:
+    //! Decoded frame
+    struct Frame {
+        int64_t index = 0;            //!< Frame index
+        int width = 0;                //!< Width in pixels
+        int height = 0;               //!< Height in pixels
+        std::vector<uint8_t> pixels;  //!< RGBA8 pixels, bottom row first
+
+        //! Return pixel data size in bytes
+        size_t getByteSize() const { return pixels.size(); }
+    };
+
+    //! Shared frame pointer. Holding it keeps the pixels pinned even if the cache evicts the frame.
+    using FramePtr = std::shared_ptr<const Frame>;
+
+    //! Frame decoder function producing RGBA8 pixels top row first. Called from worker threads.
+    using Decoder = std::function<bool(int64_t index, Frame& outFrame)>;
+
+    //! Cache statistics
+    struct Stats {
+        uint64_t hits = 0;        //!< Requests served from cache
+        uint64_t misses = 0;      //!< Requests decoded on calling thread
+        uint64_t waits = 0;       //!< Requests that waited for an in-flight prefetch
+        uint64_t prefetched = 0;  //!< Frames decoded by prefetch workers
+        uint64_t evicted = 0;     //!< Frames evicted by memory budget
+        size_t frameCount = 0;    //!< Frames currently cached
+        size_t byteSize = 0;      //!< Bytes currently cached
+    };
+
+    //! Construct cache with decoder, memory budget, worker count and prefetch depth
+    FrameCache(Decoder decoder, size_t budgetBytes, int workerCount = 2, int prefetchDepth = 4);
+
+    //! Destruct cache. Stops prefetch workers.
+    ~FrameCache();
+
+    // Disable copy, move and assign
+    FrameCache(const FrameCache& other) = delete;
+    FrameCache(const FrameCache&& other) = delete;
+    FrameCache& operator=(const FrameCache& other) = delete;
+    FrameCache& operator=(const FrameCache&& other) = delete;
+
+    //! Set valid frame index range [first, last] for prefetching
+    void setFrameRange(int64_t first, int64_t last);
+
+    //! Get frame, decoding on calling thread if not cached. Schedules prefetch in scrub direction. Returns nullptr on failure.
+    FramePtr get(int64_t index);
+
+    //! Get frame only if already cached. Does not schedule prefetch.
+    FramePtr tryGet(int64_t index);
+
+    //! Drop all cached frames and pending prefetches. Decodes in flight finish but are not cached.
+    void clear();
+
+    //! Return cache statistics
+    Stats getStats() const;
+
+    //! Create decoder loading image files with given printf style path format, e.g. "replay/%04lld.png"
+    static Decoder createFileDecoder(const std::string& pathFormat);
+
+    //! Create decoder loading encoded images or tiled overlays from track of replay bundle. Decoder keeps the bundle open.
+    static Decoder createBundleDecoder(std::shared_ptr<const ReplayBundleReader> bundle, int track);
+
+private:
+    //! Cache entry
+    struct Entry {
+        FramePtr frame;                        //!< Cached frame
+        std::list<int64_t>::iterator lruIter;  //!< Position in LRU list
+    };
+
+    //! Decode frame and flip it to bottom row first. Returns false on decode failure or size mismatch.
+    bool decode(int64_t index, Frame& outFrame) const;
+
+    //! Prefetch worker main loop
+    void workerLoop();
+
+    //! Replace prefetch queue with predictions around given index. Requires lock.
+    void schedulePrefetch(int64_t index);
+
+    //! Insert decoded frame and evict over budget. Requires lock.
+    void insert(const FramePtr& frame);
+
+    //! Mark entry most recently used. Requires lock.
+    void touch(Entry& entry, int64_t index);
+
+private:
+    Decoder m_decoder;                             //!< Frame decoder
+    const size_t m_budgetBytes;                    //!< Memory budget in bytes
+    const int m_prefetchDepth;                     //!< Frames to prefetch ahead in scrub direction
+    mutable std::mutex m_mutex;                    //!< Lock for cache state
+    std::condition_variable m_workCondition;       //!< Signaled when prefetch work is queued
+    std::condition_variable m_loadedCondition;     //!< Signaled when a prefetch completes
+    std::unordered_map<int64_t, Entry> m_entries;  //!< Cached frames by index
+    std::list<int64_t> m_lru;                      //!< Frame indices, most recently used first
+    std::unordered_set<int64_t> m_inFlight;        //!< Indices being decoded by workers
+    std::deque<int64_t> m_queue;                   //!< Prefetch queue
+    std::vector<std::thread> m_workers;            //!< Prefetch worker threads
+    bool m_stop = false;                           //!< Stop flag for workers
+    int64_t m_firstIndex = 0;                      //!< First valid frame index
+    int64_t m_lastIndex = INT64_MAX;               //!< Last valid frame index
+    int64_t m_prevRequest = -1;                    //!< Previously requested index
+    int m_direction = 1;                           //!< Current scrub direction
+    uint64_t m_generation = 0;                     //!< Incremented by clear() to drop decodes started before it
+    Stats m_stats;                                 //!< Cache statistics
+};
+
+}  // namespace VarjoExamples
@@ -0,0 +1,422 @@
+#include "FrameConversion.hpp"
+
+#include <emmintrin.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+#include <glm/gtc/packing.hpp>
+
+namespace
+{
+// Output pixel size
+constexpr int c_components = 4;
+
+// Rows converted per job
+constexpr int64_t c_rowsPerJob = 64;
+
+// Background color for alpha blending
+constexpr float c_rgbBackground[3] = {0.25f, 0.45f, 0.40f};
+
+// Streamed RGB values are in linear colorspace so we gamma correct them for screen
+constexpr float c_gamma = 1.0f / 2.2f;
+
+// Steps of gamma correction table for normalized conversion
+constexpr size_t c_gammaSteps = 4096;
+
+// Largest difference of normalization matrix entries from identity that converts without normalization
+constexpr float c_identityTolerance = 1e-3f;
+
+// BMP file and info header sizes
+constexpr uint32_t c_bmpFileHeaderSize = 14;
+constexpr uint32_t c_bmpInfoHeaderSize = 40;
+
+// Return true if buffer format can be converted
+bool isSupportedFormat(varjo_TextureFormat format)
+{
+    return format == varjo_TextureFormat_RGBA16_FLOAT || format == varjo_TextureFormat_YUV422 || format == varjo_TextureFormat_NV12;
+}
+
+// Convert YUV to RGB
+inline void convertYUVtoRGB(int Y, int U, int V, int& R, int& G, int& B)
+{
+    int C = Y - 16;
+    int D = U - 128;
+    int E = V - 128;
+    R = (298 * C + 409 * E + 128) >> 8;
+    G = (298 * C - 100 * D - 208 * E + 128) >> 8;
+    B = (298 * C + 516 * D + 128) >> 8;
+}
+
+// Write YUV pixel as BGRA
+inline void writeYUV(int Y, int U, int V, uint8_t* out)
+{
+    int R, G, B;
+    convertYUVtoRGB(Y, U, V, R, G, B);
+    out[0] = static_cast<uint8_t>(std::max(std::min(B, 255), 0));
+    out[1] = static_cast<uint8_t>(std::max(std::min(G, 255), 0));
+    out[2] = static_cast<uint8_t>(std::max(std::min(R, 255), 0));
+    out[3] = 255;
+}
+
+// Append little endian value
+template <typename T>
+inline void append(std::vector<uint8_t>& out, T value)
+{
+    for (size_t i = 0; i < sizeof(T); i++) {
+        out.push_back(static_cast<uint8_t>(static_cast<uint64_t>(value) >> (8 * i)));
+    }
+}
+
+// Convert rows [y0, y1) of CPU buffer data to BGRA8
+void convertRows(const varjo_BufferMetadata& buffer, const uint8_t* src, uint8_t* out, int32_t y0, int32_t y1)
+{
+    const size_t lineSize = static_cast<size_t>(buffer.width) * c_components;
+
+    switch (buffer.format) {
+        case varjo_TextureFormat_RGBA16_FLOAT: {
+            for (int32_t y = y0; y < y1; y++) {
+                const uint16_t* halfSrc = reinterpret_cast<const uint16_t*>(src + static_cast<size_t>(y) * buffer.rowStride);
+                uint8_t* line = out + y * lineSize;
+                for (int32_t x = 0; x < buffer.width * c_components; x += c_components) {
+                    const float alpha = glm::unpackHalf1x16(halfSrc[x + 3]);
+
+                    // Read value, gamma correct, alpha blend to background color, write in BGRA order
+                    for (int32_t c = 0; c < 3; c++) {
+                        float value = powf(glm::unpackHalf1x16(halfSrc[x + c]), c_gamma);
+                        value = value * alpha + c_rgbBackground[c] * (1.0f - alpha);
+                        line[x + (2 - c)] = static_cast<uint8_t>(std::max(0.0f, std::min(255.0f, 255.0f * value)));
+                    }
+                    line[x + 3] = 255;
+                }
+            }
+        } break;
+
+        case varjo_TextureFormat_YUV422: {
+            // Y plane is followed by UV plane of same row stride with interleaved U and V for pixel pairs
+            const size_t uvOffs = static_cast<size_t>(buffer.rowStride) * buffer.height;
+            for (int32_t y = y0; y < y1; y++) {
+                const uint8_t* b = src + static_cast<size_t>(y) * buffer.rowStride;
+                uint8_t* line = out + y * lineSize;
+                for (int32_t x = 0; x < buffer.width; x++) {
+                    const auto uvX = x - (x & 1);
+                    writeYUV(b[x], b[uvX + 0 + uvOffs], b[uvX + 1 + uvOffs], line + x * c_components);
+                }
+            }
+        } break;
+
+        case varjo_TextureFormat_NV12: {
+            // Y plane is followed by half height UV plane
+            const uint8_t* uvPlane = src + static_cast<size_t>(buffer.rowStride) * buffer.height;
+            for (int32_t y = y0; y < y1; y++) {
+                const uint8_t* bY = src + static_cast<size_t>(y) * buffer.rowStride;
+                const uint8_t* bUV = uvPlane + static_cast<size_t>(y >> 1) * buffer.rowStride;
+                uint8_t* line = out + y * lineSize;
+                for (int32_t x = 0; x < buffer.width; x++) {
+                    const auto uvX = x - (x & 1);
+                    writeYUV(bY[x], bUV[uvX + 0], bUV[uvX + 1], line + x * c_components);
+                }
+            }
+        } break;
+
+        default: break;
+    }
+}
+
+// Gamma tables for normalized conversion
+struct GammaTables {
+    std::array<float, 256> toLinear;          // Gamma encoded 8-bit value to linear
+    std::array<float, c_gammaSteps> toGamma;  // Square root of linear [0, 1] in c_gammaSteps steps to gamma encoded [0, 1]
+};
+
+// Return gamma tables, built on first use
+const GammaTables& getGammaTables()
+{
+    static const GammaTables tables = [] {
+        GammaTables t;
+        for (size_t i = 0; i < t.toLinear.size(); i++) {
+            t.toLinear[i] = powf(static_cast<float>(i) / 255.0f, 1.0f / c_gamma);
+        }
+        // Indexing by square root spends the steps evenly over dark and bright values
+        for (size_t i = 0; i < t.toGamma.size(); i++) {
+            t.toGamma[i] = powf(static_cast<float>(i) / (c_gammaSteps - 1), 2.0f * c_gamma);
+        }
+        return t;
+    }();
+    return tables;
+}
+
+// Convert four half floats in the low 16 bits of each lane to float. Inf and NaN become large finite values.
+inline __m128 halfToFloat(__m128i h)
+{
+    const __m128i sign = _mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(0x8000)), 16);
+    const __m128i magnitude = _mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(0x7FFF)), 13);
+
+    // Rebias exponent from 15 to 127, also scales denormals right
+    const __m128 value = _mm_mul_ps(_mm_castsi128_ps(magnitude), _mm_castsi128_ps(_mm_set1_epi32(0x77800000)));
+    return _mm_or_ps(value, _mm_castsi128_ps(sign));
+}
+
+// Return true if normalization matrix is identity to well below one 8-bit step after gamma correction
+bool isIdentity(const VarjoExamples::FrameNormalization& normalization)
+{
+    for (int i = 0; i < 9; i++) {
+        const float expected = (i % 4 == 0) ? 1.0f : 0.0f;
+        if (std::abs(normalization.matrix[i] - expected) > c_identityTolerance) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Write YUV pixel as linear RGBA
+inline void writeLinearYUV(int Y, int U, int V, const GammaTables& tables, float* out)
+{
+    int R, G, B;
+    convertYUVtoRGB(Y, U, V, R, G, B);
+    out[0] = tables.toLinear[std::max(std::min(R, 255), 0)];
+    out[1] = tables.toLinear[std::max(std::min(G, 255), 0)];
+    out[2] = tables.toLinear[std::max(std::min(B, 255), 0)];
+    out[3] = 1.0f;
+}
+
+// Decode row y of CPU buffer data to linear RGBA floats
+void decodeLinearRow(const varjo_BufferMetadata& buffer, const uint8_t* src, int32_t y, const GammaTables& tables, float* out)
+{
+    switch (buffer.format) {
+        case varjo_TextureFormat_RGBA16_FLOAT: {
+            const uint16_t* halfSrc = reinterpret_cast<const uint16_t*>(src + static_cast<size_t>(y) * buffer.rowStride);
+            VarjoExamples::convertHalfToFloat(halfSrc, out, static_cast<size_t>(buffer.width) * c_components);
+        } break;
+
+        case varjo_TextureFormat_YUV422: {
+            const size_t uvOffs = static_cast<size_t>(buffer.rowStride) * buffer.height;
+            const uint8_t* b = src + static_cast<size_t>(y) * buffer.rowStride;
+            for (int32_t x = 0; x < buffer.width; x++) {
+                const auto uvX = x - (x & 1);
+                writeLinearYUV(b[x], b[uvX + 0 + uvOffs], b[uvX + 1 + uvOffs], tables, out + x * c_components);
+            }
+        } break;
+
+        case varjo_TextureFormat_NV12: {
+            const uint8_t* bY = src + static_cast<size_t>(y) * buffer.rowStride;
+            const uint8_t* bUV = src + static_cast<size_t>(buffer.rowStride) * buffer.height + static_cast<size_t>(y >> 1) * buffer.rowStride;
+            for (int32_t x = 0; x < buffer.width; x++) {
+                const auto uvX = x - (x & 1);
+                writeLinearYUV(bY[x], bUV[uvX + 0], bUV[uvX + 1], tables, out + x * c_components);
+            }
+        } break;
+
+        default: break;
+    }
+}
+
+// Convert rows [y0, y1) of CPU buffer data to BGRA8 with normalization. Rows are decoded to linear RGBA, transformed
+// as four float lanes per pixel, gamma corrected through a table and alpha blended to background color.
+void convertRowsNormalized(const varjo_BufferMetadata& buffer, const uint8_t* src, uint8_t* out, int32_t y0, int32_t y1,
+    const VarjoExamples::FrameNormalization& normalization)
+{
+    const size_t lineSize = static_cast<size_t>(buffer.width) * c_components;
+    const GammaTables& tables = getGammaTables();
+    std::vector<float> linear(lineSize);
+
+    // Matrix columns, so each input channel scales one column
+    const float* m = normalization.matrix.data();
+    const __m128 columnR = _mm_setr_ps(m[0], m[3], m[6], 0.0f);
+    const __m128 columnG = _mm_setr_ps(m[1], m[4], m[7], 0.0f);
+    const __m128 columnB = _mm_setr_ps(m[2], m[5], m[8], 0.0f);
+    const __m128 background = _mm_setr_ps(c_rgbBackground[2], c_rgbBackground[1], c_rgbBackground[0], 1.0f);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 quantize = _mm_set1_ps(static_cast<float>(c_gammaSteps - 1));
+    const __m128 scale = _mm_set1_ps(255.0f);
+    alignas(16) int32_t indices[4];
+
+    for (int32_t y = y0; y < y1; y++) {
+        decodeLinearRow(buffer, src, y, tables, linear.data());
+        uint8_t* line = out + y * lineSize;
+        for (int32_t x = 0; x < buffer.width; x++) {
+            const __m128 p = _mm_loadu_ps(linear.data() + x * c_components);
+            __m128 color = _mm_mul_ps(columnR, _mm_shuffle_ps(p, p, _MM_SHUFFLE(0, 0, 0, 0)));
+            color = _mm_add_ps(color, _mm_mul_ps(columnG, _mm_shuffle_ps(p, p, _MM_SHUFFLE(1, 1, 1, 1))));
+            color = _mm_add_ps(color, _mm_mul_ps(columnB, _mm_shuffle_ps(p, p, _MM_SHUFFLE(2, 2, 2, 2))));
+            color = _mm_min_ps(_mm_max_ps(color, zero), one);
+            _mm_store_si128(reinterpret_cast<__m128i*>(indices), _mm_cvtps_epi32(_mm_mul_ps(_mm_sqrt_ps(color), quantize)));
+
+            // Gamma correct, alpha blend to background color and pack in BGRA order
+            const __m128 alpha = _mm_min_ps(_mm_max_ps(_mm_shuffle_ps(p, p, _MM_SHUFFLE(3, 3, 3, 3)), zero), one);
+            const __m128 gamma = _mm_setr_ps(tables.toGamma[indices[2]], tables.toGamma[indices[1]], tables.toGamma[indices[0]], 1.0f);
+            const __m128 blended = _mm_add_ps(_mm_mul_ps(gamma, alpha), _mm_mul_ps(background, _mm_sub_ps(one, alpha)));
+            __m128i bgra = _mm_cvtps_epi32(_mm_mul_ps(blended, scale));
+            bgra = _mm_packs_epi32(bgra, bgra);
+            bgra = _mm_packus_epi16(bgra, bgra);
+            const int32_t pixel = _mm_cvtsi128_si32(bgra);
+            std::memcpy(line + x * c_components, &pixel, sizeof(pixel));
+        }
+    }
+}
+
+}  // namespace
+
+namespace VarjoExamples
+{
+FrameNormalization getFrameNormalization(double ev, const varjo_WBNormalizationData& wbNormalizationData, double referenceEV)
+{
+    // Pixel values scale with 1 / 2^ev for the same luminance
+    const double exposureGain = std::pow(2.0, ev - referenceEV);
+
+    // Camera transform from 6500K to camera white balance is color * invCCM * diag(gains) * ccm on row vectors with
+    // row-major matrices. Building glm matrices from row-major values transposes them, which turns it into the column
+    // vector form ccm^T * diag(gains) * invCCM^T. The clamp between the matrices is left out, so it can be inverted.
+    const auto& inv = wbNormalizationData.invCCM.value;
+    const auto& ccm = wbNormalizationData.ccm.value;
+    const auto& gains = wbNormalizationData.whiteBalanceColorGains;
+    const glm::dmat3 invCCM(inv[0], inv[1], inv[2], inv[3], inv[4], inv[5], inv[6], inv[7], inv[8]);
+    const glm::dmat3 finalCCM(ccm[0], ccm[1], ccm[2], ccm[3], ccm[4], ccm[5], ccm[6], ccm[7], ccm[8]);
+    const glm::dmat3 cameraTransform = finalCCM * glm::dmat3(gains[0], 0.0, 0.0, 0.0, gains[1], 0.0, 0.0, 0.0, gains[2]) * invCCM;
+
+    glm::dmat3 transform(exposureGain);
+    const double determinant = glm::determinant(cameraTransform);
+    if (std::isfinite(determinant) && std::abs(determinant) > 1e-9) {
+        transform = glm::inverse(cameraTransform) * exposureGain;
+    } else {
+        LOG_WARNING("White balance transform not invertible, normalizing exposure only: det=%g", determinant);
+    }
+
+    FrameNormalization normalization;
+    normalization.enabled = true;
+    for (int row = 0; row < 3; row++) {
+        for (int col = 0; col < 3; col++) {
+            normalization.matrix[row * 3 + col] = static_cast<float>(transform[col][row]);
+        }
+    }
+    return normalization;
+}
+
+void convertHalfToFloat(const uint16_t* src, float* out, size_t count)
+{
+    const __m128i zero = _mm_setzero_si128();
+
+    // Eight values per iteration
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        _mm_storeu_ps(out + i, halfToFloat(_mm_unpacklo_epi16(h, zero)));
+        _mm_storeu_ps(out + i + 4, halfToFloat(_mm_unpackhi_epi16(h, zero)));
+    }
+    for (; i < count; i++) {
+        out[i] = glm::unpackHalf1x16(src[i]);
+    }
+}
+
+size_t getBufferDataSize(varjo_TextureFormat format, int height, int rowStride)
+{
+    const size_t planeSize = static_cast<size_t>(rowStride) * height;
+    switch (format) {
+        case varjo_TextureFormat_RGBA16_FLOAT: return planeSize;
+        case varjo_TextureFormat_YUV422: return planeSize * 2;
+        case varjo_TextureFormat_NV12: return planeSize + static_cast<size_t>(rowStride) * (height / 2);
+        default: return 0;
+    }
+}
+
+void convertBufferToBGRA(
+    const varjo_BufferMetadata& buffer, const void* cpuData, std::vector<uint8_t>& outPixels, JobSystem* jobs, const FrameNormalization* normalization)
+{
+    if (!isSupportedFormat(buffer.format)) {
+        CRITICAL("Unsupported pixel format: %d", static_cast<int>(buffer.format));
+    }
+
+    // Empty buffer converts to empty image
+    if (buffer.width <= 0 || buffer.height <= 0) {
+        outPixels.clear();
+        return;
+    }
+
+    const size_t lineSize = static_cast<size_t>(buffer.width) * c_components;
+    outPixels.resize(lineSize * buffer.height);
+    const uint8_t* src = reinterpret_cast<const uint8_t*>(cpuData);
+    uint8_t* out = outPixels.data();
+
+    // Frame already at reference exposure and neutral white balance takes the plain conversion
+    const bool normalize = normalization && normalization->enabled && !isIdentity(*normalization);
+    const auto convert = [&](int32_t y0, int32_t y1) {
+        if (normalize) {
+            convertRowsNormalized(buffer, src, out, y0, y1, *normalization);
+        } else {
+            convertRows(buffer, src, out, y0, y1);
+        }
+    };
+
+    if (!jobs) {
+        convert(0, buffer.height);
+        return;
+    }
+
+    // Conversion runs on the capture path, so it takes the low-latency lane
+    jobs->parallelFor(
+        0, buffer.height, c_rowsPerJob, [&](int64_t begin, int64_t end) { convert(static_cast<int32_t>(begin), static_cast<int32_t>(end)); },
+        JobSystem::Priority::LowLatency);
+}
+
+void encodeBMP(const uint8_t* pixels, int width, int height, std::vector<uint8_t>& out)
+{
+    const size_t lineSize = static_cast<size_t>(width) * c_components;
+    const uint32_t headerSize = c_bmpFileHeaderSize + c_bmpInfoHeaderSize;
+    out.clear();
+    out.reserve(headerSize + lineSize * height);
+
+    // File header
+    append<uint16_t>(out, 0x4D42);  // "BM"
+    append<uint32_t>(out, static_cast<uint32_t>(headerSize + lineSize * height));
+    append<uint32_t>(out, 0);
+    append<uint32_t>(out, headerSize);
+
+    // Info header for uncompressed 32-bit bottom-up image
+    append<uint32_t>(out, c_bmpInfoHeaderSize);
+    append<int32_t>(out, width);
+    append<int32_t>(out, height);
+    append<uint16_t>(out, 1);
+    append<uint16_t>(out, 32);
+    append<uint32_t>(out, 0);
+    append<uint32_t>(out, 0);
+    append<int32_t>(out, 2835);
+    append<int32_t>(out, 2835);
+    append<uint32_t>(out, 0);
+    append<uint32_t>(out, 0);
+
+    for (int y = height - 1; y >= 0; y--) {
+        const uint8_t* line = pixels + y * lineSize;
+        out.insert(out.end(), line, line + lineSize);
+    }
+}
+
+void saveBufferBMP(
+    const std::string& filename, const varjo_BufferMetadata& buffer, const void* cpuData, JobSystem* jobs, const FrameNormalization* normalization)
+{
+    LOG_DEBUG("Saving buffer to file: %s", filename.c_str());
+
+    std::vector<uint8_t> pixels;
+    convertBufferToBGRA(buffer, cpuData, pixels, jobs, normalization);
+    std::vector<uint8_t> bmp;
+    encodeBMP(pixels.data(), buffer.width, buffer.height, bmp);
+
+    std::ofstream outFile(filename, std::ofstream::binary);
+    if (!outFile.good()) {
+        LOG_ERROR("Opening file for writing failed: %s", filename.c_str());
+        return;
+    }
+
+    outFile.write(reinterpret_cast<const char*>(bmp.data()), bmp.size());
+    if (!outFile.good()) {
+        LOG_ERROR("Writing to bitmap file failed: %s", filename.c_str());
+        return;
+    }
+
+    outFile.close();
+    LOG_INFO("File saved succesfully: %s", filename.c_str());
+}
+
+}  // namespace VarjoExamples
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <array>
+#include <string>
+#include <vector>
+
+#include <Varjo_types_datastream.h>
+
+#include "Globals.hpp"
+#include "JobSystem.hpp"
+
+namespace VarjoExamples
+{
+//! CPU conversion and encoding of data stream buffers, shared by DataStreamer and CaptureBenchmark.
+//!
+//! Supported buffer formats are RGBA16_FLOAT (linear, gamma corrected and blended over background color), YUV422
+//! and NV12. Converted images are tightly packed 8-bit BGRA rows from top to bottom.
+
+//! Exposure and white balance normalization of camera frames, applied in linear color during conversion.
+//!
+//! The camera changes exposure EV and white balance with the scene, so the same surface comes out brighter or tinted
+//! from frame to frame. Normalization brings each frame to a reference EV with neutral white balance by inverting the
+//! camera color transform that ExampleShaders::WBNormalizationData applies to VR content on the GPU (inverse CCM,
+//! white balance gains, CCM) and scaling by the EV difference. Both fold into one 3x3 matrix per frame.
+struct FrameNormalization {
+    bool enabled = false;                                                                  //!< Apply normalization
+    std::array<float, 9> matrix = {1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f};  //!< Row-major transform of linear RGB column vectors
+};
+
+//! Return normalization of frame with given exposure EV and white balance data to reference EV. Exposure time and
+//! gain are part of EV. Normalizes exposure only if the white balance transform is not invertible.
+FrameNormalization getFrameNormalization(double ev, const varjo_WBNormalizationData& wbNormalizationData, double referenceEV);
+
+//! Convert count half floats to float, eight at a time with SSE2. Inf and NaN become large finite values.
+void convertHalfToFloat(const uint16_t* src, float* out, size_t count);
+
+//! Return byte size of CPU buffer data for given format, height and row stride. Returns zero for unsupported format.
+size_t getBufferDataSize(varjo_TextureFormat format, int height, int rowStride);
+
+//! Convert CPU buffer data to BGRA8, split over rows on the low-latency lane of jobs if given. Applies normalization in
+//! the same pass if given and enabled; an identity normalization converts as without one. Throws on unsupported format.
+//! Empty buffer gives empty output.
+void convertBufferToBGRA(const varjo_BufferMetadata& buffer, const void* cpuData, std::vector<uint8_t>& outPixels, JobSystem* jobs = nullptr,
+    const FrameNormalization* normalization = nullptr);
+
+//! Encode tightly packed BGRA8 rows as 32-bit BMP file contents
+void encodeBMP(const uint8_t* pixels, int width, int height, std::vector<uint8_t>& out);
+
+//! Convert CPU buffer data and save it as BMP image file, converting on jobs and normalizing if given. Throws on
+//! unsupported format.
+void saveBufferBMP(const std::string& filename, const varjo_BufferMetadata& buffer, const void* cpuData, JobSystem* jobs = nullptr,
+    const FrameNormalization* normalization = nullptr);
+
+}  // namespace VarjoExamples
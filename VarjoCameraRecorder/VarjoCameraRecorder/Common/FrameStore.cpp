@@ -0,0 +1,333 @@
+#include "FrameStore.hpp"
+
+#include <cstdio>
+#include <cstring>
+
+#include "QoiCodec.hpp"
+
+namespace
+{
+// Spill record magic
+constexpr uint32_t c_recordMagic = 0x4c505346;  // "FSPL"
+
+// Spill record codecs
+constexpr uint32_t c_codecRaw = 0;
+constexpr uint32_t c_codecQoi = 1;
+
+// Spill record header, followed by payload
+struct RecordHeader {
+    uint32_t magic = c_recordMagic;
+    int32_t width = 0;
+    int32_t height = 0;
+    int32_t channels = 0;
+    uint32_t codec = c_codecRaw;
+    uint32_t size = 0;
+};
+
+}  // namespace
+
+namespace VarjoExamples
+{
+FrameStore::FrameStore(const std::string& spillFilename, size_t budgetBytes)
+    : m_spillFilename(spillFilename)
+    , m_budgetBytes(budgetBytes)
+{
+    m_file.open(spillFilename, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!m_file) {
+        CRITICAL("Opening spill file failed: %s", spillFilename.c_str());
+    }
+}
+
+FrameStore::~FrameStore()
+{
+    m_file.close();
+    std::remove(m_spillFilename.c_str());
+}
+
+FrameStore::Handle FrameStore::put(const uint8_t* data, int width, int height, int channels, int rowStride)
+{
+    if (!data || width <= 0 || height <= 0 || channels < 1 || channels > 4 || rowStride < width * channels) {
+        LOG_ERROR("Invalid frame: %dx%d, channels=%d, stride=%d", width, height, channels, rowStride);
+        return 0;
+    }
+
+    // Copy outside lock
+    auto frame = std::make_shared<Frame>();
+    frame->width = width;
+    frame->height = height;
+    frame->channels = channels;
+    const size_t rowBytes = static_cast<size_t>(width) * channels;
+    frame->pixels.resize(rowBytes * height);
+    for (int y = 0; y < height; y++) {
+        memcpy(&frame->pixels[y * rowBytes], data + static_cast<size_t>(y) * rowStride, rowBytes);
+    }
+
+    std::vector<Victim> victims;
+    Handle handle;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        handle = m_nextHandle++;
+        Entry& entry = m_entries[handle];
+        entry.frame = std::move(frame);
+        entry.byteSize = entry.frame->getByteSize();
+        touch(entry, handle);
+        evict(victims);
+    }
+
+    spill(victims);
+    return handle;
+}
+
+FrameStore::FramePtr FrameStore::get(Handle handle)
+{
+    std::vector<Victim> victims;
+    FramePtr frame;
+    int64_t offset = -1;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_entries.find(handle);
+        if (it == m_entries.end()) {
+            return nullptr;
+        }
+
+        // Frame may still be in memory while being spilled
+        Entry& entry = it->second;
+        if (entry.frame) {
+            frame = entry.frame;
+            m_stats.hits++;
+            touch(entry, handle);
+            evict(victims);
+        } else {
+            offset = entry.spillOffset;
+        }
+    }
+
+    if (!frame) {
+        // Read and decompress without store lock
+        frame = readRecord(offset);
+        if (!frame) {
+            return nullptr;
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_entries.find(handle);
+        if (it == m_entries.end()) {
+            return frame;
+        }
+
+        // Another thread may have reloaded the frame meanwhile
+        Entry& entry = it->second;
+        if (entry.frame) {
+            frame = entry.frame;
+        } else {
+            entry.frame = frame;
+            m_stats.spilledCount--;
+            m_stats.reloads++;
+        }
+        touch(entry, handle);
+        evict(victims);
+    }
+
+    spill(victims);
+    return frame;
+}
+
+void FrameStore::release(Handle handle)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_entries.find(handle);
+    if (it == m_entries.end()) {
+        return;
+    }
+
+    Entry& entry = it->second;
+    if (entry.resident) {
+        m_lru.erase(entry.lruIter);
+        m_stats.residentBytes -= entry.byteSize;
+    } else if (!entry.frame) {
+        m_stats.spilledCount--;
+    }
+    m_entries.erase(it);
+}
+
+bool FrameStore::contains(Handle handle) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_entries.count(handle) != 0;
+}
+
+void FrameStore::setBudget(size_t budgetBytes)
+{
+    std::vector<Victim> victims;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_budgetBytes = budgetBytes;
+        evict(victims);
+    }
+    spill(victims);
+}
+
+FrameStore::Stats FrameStore::getStats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Stats stats = m_stats;
+    stats.frameCount = m_entries.size();
+    stats.residentCount = m_lru.size();
+    return stats;
+}
+
+void FrameStore::touch(Entry& entry, Handle handle)
+{
+    if (entry.resident) {
+        m_lru.erase(entry.lruIter);
+    } else {
+        entry.resident = true;
+        m_stats.residentBytes += entry.byteSize;
+    }
+    m_lru.push_front(handle);
+    entry.lruIter = m_lru.begin();
+}
+
+void FrameStore::evict(std::vector<Victim>& victims)
+{
+    // Walk from least recently used. Pinned frames would stay in memory anyway, so they are skipped.
+    auto it = m_lru.end();
+    while (m_stats.residentBytes > m_budgetBytes && it != m_lru.begin()) {
+        --it;
+        const Handle handle = *it;
+        Entry& entry = m_entries.at(handle);
+        if (entry.frame.use_count() > 1) {
+            continue;
+        }
+
+        it = m_lru.erase(it);
+        entry.resident = false;
+        m_stats.residentBytes -= entry.byteSize;
+        m_stats.evictions++;
+
+        // Frames already on disk are just dropped, others keep their pointer until written
+        if (entry.spillOffset >= 0) {
+            entry.frame.reset();
+            m_stats.spilledCount++;
+        } else if (!entry.spilling) {
+            entry.spilling = true;
+            victims.push_back({handle, entry.frame});
+        }
+    }
+}
+
+void FrameStore::spill(std::vector<Victim>& victims)
+{
+    if (victims.empty()) {
+        return;
+    }
+
+    std::vector<int64_t> offsets(victims.size());
+    for (size_t i = 0; i < victims.size(); i++) {
+        offsets[i] = writeRecord(*victims[i].frame);
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (size_t i = 0; i < victims.size(); i++) {
+        auto it = m_entries.find(victims[i].handle);
+        if (it == m_entries.end()) {
+            continue;
+        }
+
+        // Frame stays in memory over budget if writing failed, or if it was accessed meanwhile
+        Entry& entry = it->second;
+        entry.spilling = false;
+        if (offsets[i] < 0) {
+            if (!entry.resident) {
+                touch(entry, victims[i].handle);
+            }
+            continue;
+        }
+
+        m_stats.rawSpillBytes += entry.byteSize;
+        entry.spillOffset = offsets[i];
+        if (!entry.resident) {
+            entry.frame.reset();
+            m_stats.spilledCount++;
+        }
+    }
+
+    std::lock_guard<std::mutex> fileLock(m_fileMutex);
+    m_stats.spillBytes = static_cast<uint64_t>(m_fileSize);
+    victims.clear();
+}
+
+int64_t FrameStore::writeRecord(const Frame& frame)
+{
+    RecordHeader header;
+    header.width = frame.width;
+    header.height = frame.height;
+    header.channels = frame.channels;
+
+    // Compress without file lock. Keep raw pixels if compression does not help.
+    std::vector<uint8_t> compressed;
+    const uint8_t* payload = frame.pixels.data();
+    size_t size = frame.pixels.size();
+    if (frame.channels >= 3) {
+        compressed.reserve(size / 2);
+        encodeQoi(frame.pixels.data(), frame.width, frame.height, frame.width * frame.channels, frame.channels, false, compressed);
+        if (compressed.size() < size) {
+            header.codec = c_codecQoi;
+            payload = compressed.data();
+            size = compressed.size();
+        }
+    }
+    header.size = static_cast<uint32_t>(size);
+
+    std::lock_guard<std::mutex> lock(m_fileMutex);
+    const int64_t offset = m_fileSize;
+    m_file.seekp(offset);
+    m_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    m_file.write(reinterpret_cast<const char*>(payload), size);
+    if (!m_file) {
+        LOG_ERROR("Writing spill file failed: %s", m_spillFilename.c_str());
+        m_file.clear();
+        return -1;
+    }
+
+    m_fileSize += sizeof(header) + size;
+    return offset;
+}
+
+FrameStore::FramePtr FrameStore::readRecord(int64_t offset)
+{
+    RecordHeader header;
+    std::vector<uint8_t> payload;
+    {
+        std::lock_guard<std::mutex> lock(m_fileMutex);
+        m_file.seekg(offset);
+        m_file.read(reinterpret_cast<char*>(&header), sizeof(header));
+        if (m_file && header.magic == c_recordMagic) {
+            payload.resize(header.size);
+            m_file.read(reinterpret_cast<char*>(payload.data()), header.size);
+        }
+        if (!m_file || header.magic != c_recordMagic) {
+            LOG_ERROR("Reading spill file failed: %s, offset=%lld", m_spillFilename.c_str(), offset);
+            m_file.clear();
+            return nullptr;
+        }
+    }
+
+    auto frame = std::make_shared<Frame>();
+    frame->width = header.width;
+    frame->height = header.height;
+    frame->channels = header.channels;
+    const int rowStride = header.width * header.channels;
+    if (header.codec == c_codecQoi) {
+        frame->pixels.resize(static_cast<size_t>(rowStride) * header.height);
+        if (!decodeQoi(payload.data(), payload.size(), frame->pixels.data(), header.width, header.height, rowStride, header.channels)) {
+            LOG_ERROR("Invalid spill record: %s, offset=%lld", m_spillFilename.c_str(), offset);
+            return nullptr;
+        }
+    } else {
+        frame->pixels = std::move(payload);
+    }
+    return frame;
+}
+
+}  // namespace VarjoExamples
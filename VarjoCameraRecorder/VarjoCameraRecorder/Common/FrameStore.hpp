@@ -0,0 +1,130 @@
+#pragma once
+
+#include <fstream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Globals.hpp"
+
+namespace VarjoExamples
+{
+//! Bounded store of frame history referenced by handle.
+//!
+//! Frames over the memory budget are evicted in LRU order to an append-only spill file, compressed with QOI for
+//! three and four channel frames, and reloaded transparently when accessed again. Frames are immutable, so a frame
+//! that was spilled once is only dropped from memory when evicted again. Session length is limited by disk space.
+//! Spill file space of released frames is not reused; the file is deleted when the store is destroyed.
+class FrameStore
+{
+public:
+    //! Frame handle, zero is invalid
+    using Handle = uint64_t;
+
+    //! Stored frame
+    struct Frame {
+        int width = 0;                //!< Width in pixels
+        int height = 0;               //!< Height in pixels
+        int channels = 0;             //!< Bytes per pixel, 1 to 4
+        std::vector<uint8_t> pixels;  //!< Tightly packed pixels, top row first
+
+        //! Return pixel data size in bytes
+        size_t getByteSize() const { return pixels.size(); }
+    };
+
+    //! Shared frame pointer. Holding it pins the frame in memory, pinned frames are not evicted.
+    using FramePtr = std::shared_ptr<const Frame>;
+
+    //! Store statistics
+    struct Stats {
+        size_t frameCount = 0;       //!< Frames in store
+        size_t residentCount = 0;    //!< Frames in memory
+        size_t residentBytes = 0;    //!< Bytes in memory
+        size_t spilledCount = 0;     //!< Frames only on disk
+        uint64_t spillBytes = 0;     //!< Spill file size in bytes
+        uint64_t rawSpillBytes = 0;  //!< Uncompressed size of data written to spill file
+        uint64_t hits = 0;           //!< Requests served from memory
+        uint64_t reloads = 0;        //!< Requests reloaded from spill file
+        uint64_t evictions = 0;      //!< Frames evicted from memory
+    };
+
+    //! Construct store with spill file path and memory budget. Existing spill file is overwritten. Throws on failure.
+    FrameStore(const std::string& spillFilename, size_t budgetBytes);
+
+    //! Destruct store. Deletes spill file.
+    ~FrameStore();
+
+    // Disable copy, move and assign
+    FrameStore(const FrameStore& other) = delete;
+    FrameStore(const FrameStore&& other) = delete;
+    FrameStore& operator=(const FrameStore& other) = delete;
+    FrameStore& operator=(const FrameStore&& other) = delete;
+
+    //! Copy frame with 1 to 4 channels into store. Returns handle, or zero on invalid arguments.
+    Handle put(const uint8_t* data, int width, int height, int channels, int rowStride);
+
+    //! Get frame, reloading it from spill file if evicted. Returns nullptr for unknown handle or read failure.
+    FramePtr get(Handle handle);
+
+    //! Remove frame from store. Holders of the frame pointer keep their copy.
+    void release(Handle handle);
+
+    //! Return true if handle refers to a stored frame
+    bool contains(Handle handle) const;
+
+    //! Change memory budget. Evicts frames if needed.
+    void setBudget(size_t budgetBytes);
+
+    //! Return store statistics
+    Stats getStats() const;
+
+private:
+    //! Store entry
+    struct Entry {
+        FramePtr frame;                       //!< Frame in memory, or nullptr if only on disk
+        size_t byteSize = 0;                  //!< Frame size in bytes
+        bool resident = false;                //!< True if frame counts against budget and is in LRU list
+        int64_t spillOffset = -1;             //!< Record offset in spill file, or -1 if not written
+        bool spilling = false;                //!< True while frame is being written to spill file
+        std::list<Handle>::iterator lruIter;  //!< Position in LRU list if resident
+    };
+
+    //! Frame evicted from memory that needs to be written to spill file
+    struct Victim {
+        Handle handle = 0;  //!< Frame handle
+        FramePtr frame;     //!< Frame to write
+    };
+
+    //! Make entry resident and most recently used. Requires lock.
+    void touch(Entry& entry, Handle handle);
+
+    //! Evict least recently used unpinned frames until within budget. Requires lock.
+    void evict(std::vector<Victim>& victims);
+
+    //! Write evicted frames to spill file and drop them from memory. Called without lock.
+    void spill(std::vector<Victim>& victims);
+
+    //! Append frame record to spill file. Returns record offset, or -1 on failure.
+    int64_t writeRecord(const Frame& frame);
+
+    //! Read frame record from spill file. Returns nullptr on failure.
+    FramePtr readRecord(int64_t offset);
+
+private:
+    const std::string m_spillFilename;            //!< Spill file path
+    size_t m_budgetBytes = 0;                     //!< Memory budget in bytes
+    mutable std::mutex m_mutex;                   //!< Lock for store state
+    std::unordered_map<Handle, Entry> m_entries;  //!< Frames by handle
+    std::list<Handle> m_lru;                      //!< Resident handles, most recently used first
+    Handle m_nextHandle = 1;                      //!< Next handle to assign
+    Stats m_stats;                                //!< Store statistics
+
+    std::mutex m_fileMutex;  //!< Lock for spill file, taken without store lock
+    std::fstream m_file;     //!< Spill file
+    int64_t m_fileSize = 0;  //!< Spill file size in bytes
+};
+
+}  // namespace VarjoExamples
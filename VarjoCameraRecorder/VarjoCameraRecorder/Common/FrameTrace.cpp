@@ -0,0 +1,303 @@
+#include "FrameTrace.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+
+namespace
+{
+// Record magic "FTRC" and format version
+constexpr uint32_t c_traceMagic = 0x43525446;
+constexpr uint16_t c_traceVersion = 1;
+
+// Stage names, also used as JSON keys
+const char* c_stageNames[] = {"exposure", "capture", "publish", "ingest", "detection", "visualization", "transport", "upload"};
+static_assert(sizeof(c_stageNames) / sizeof(c_stageNames[0]) == VarjoExamples::c_traceStageCount, "Stage name missing");
+static_assert(VarjoExamples::c_traceRecordSize == 24 + 8 * VarjoExamples::c_traceStageCount, "Record size mismatch");
+
+// Write little endian value
+template <typename T>
+inline uint8_t* put(uint8_t* out, T value)
+{
+    for (size_t i = 0; i < sizeof(T); i++) {
+        out[i] = static_cast<uint8_t>(static_cast<uint64_t>(value) >> (8 * i));
+    }
+    return out + sizeof(T);
+}
+
+// Read little endian value
+template <typename T>
+inline const uint8_t* get(const uint8_t* in, T& value)
+{
+    uint64_t v = 0;
+    for (size_t i = 0; i < sizeof(T); i++) {
+        v |= static_cast<uint64_t>(in[i]) << (8 * i);
+    }
+    value = static_cast<T>(v);
+    return in + sizeof(T);
+}
+
+// Return percentile of sorted values with linear interpolation
+double percentile(const std::vector<double>& sorted, double p)
+{
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    const double position = p * (sorted.size() - 1);
+    const size_t index = static_cast<size_t>(position);
+    if (index + 1 >= sorted.size()) {
+        return sorted.back();
+    }
+    const double fraction = position - index;
+    return sorted[index] + (sorted[index + 1] - sorted[index]) * fraction;
+}
+
+}  // namespace
+
+namespace VarjoExamples
+{
+const char* getTraceStageName(TraceStage stage)
+{
+    const int index = static_cast<int>(stage);
+    return (index >= 0 && index < c_traceStageCount) ? c_stageNames[index] : "unknown";
+}
+
+int64_t traceNow()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void serializeTrace(const FrameTrace& trace, uint8_t* out)
+{
+    out = put<uint32_t>(out, c_traceMagic);
+    out = put<uint16_t>(out, c_traceVersion);
+    out = put<uint16_t>(out, static_cast<uint16_t>(c_traceStageCount));
+    out = put<int64_t>(out, trace.frameNumber);
+    out = put<int64_t>(out, trace.sensorTimestamp);
+    for (const int64_t stamp : trace.stamps) {
+        out = put<int64_t>(out, stamp);
+    }
+}
+
+bool parseTrace(const uint8_t* data, size_t size, FrameTrace& outTrace)
+{
+    if (size < c_traceRecordSize) {
+        return false;
+    }
+
+    uint32_t magic = 0;
+    uint16_t version = 0;
+    uint16_t stageCount = 0;
+    data = get(data, magic);
+    data = get(data, version);
+    data = get(data, stageCount);
+    if (magic != c_traceMagic || version != c_traceVersion || stageCount != c_traceStageCount) {
+        return false;
+    }
+
+    data = get(data, outTrace.frameNumber);
+    data = get(data, outTrace.sensorTimestamp);
+    for (int64_t& stamp : outTrace.stamps) {
+        data = get(data, stamp);
+    }
+    return true;
+}
+
+bool writeTraceFile(const std::string& filename, const FrameTrace& trace)
+{
+    uint8_t record[c_traceRecordSize];
+    serializeTrace(trace, record);
+
+    // Readers poll the sidecar, so write a temporary file and replace the sidecar with it in one rename
+    const std::string tempFilename = filename + ".tmp";
+    {
+        std::ofstream outFile(tempFilename, std::ofstream::binary | std::ofstream::trunc);
+        outFile.write(reinterpret_cast<const char*>(record), sizeof(record));
+        if (!outFile.good()) {
+            LOG_ERROR("Writing trace file failed: %s", tempFilename.c_str());
+            return false;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(tempFilename, filename, error);
+    if (error) {
+        LOG_ERROR("Replacing trace file failed: %s: %s", filename.c_str(), error.message().c_str());
+        std::filesystem::remove(tempFilename, error);
+        return false;
+    }
+    return true;
+}
+
+bool readTraceFile(const std::string& filename, FrameTrace& outTrace)
+{
+    uint8_t record[c_traceRecordSize];
+    std::ifstream inFile(filename, std::ifstream::binary);
+    inFile.read(reinterpret_cast<char*>(record), sizeof(record));
+    return inFile.gcount() == static_cast<std::streamsize>(sizeof(record)) && parseTrace(record, sizeof(record), outTrace);
+}
+
+bool appendTraceLog(const std::string& filename, const FrameTrace& trace)
+{
+    uint8_t record[c_traceRecordSize];
+    serializeTrace(trace, record);
+
+    std::ofstream outFile(filename, std::ofstream::binary | std::ofstream::app);
+    outFile.write(reinterpret_cast<const char*>(record), sizeof(record));
+    if (!outFile.good()) {
+        LOG_ERROR("Appending to trace log failed: %s", filename.c_str());
+        return false;
+    }
+    return true;
+}
+
+LatencyCollector::LatencyCollector(size_t maxSamples)
+    : m_maxSamples(std::max<size_t>(maxSamples, 1))
+{
+}
+
+void LatencyCollector::record(const FrameTrace& trace)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_traceCount++;
+
+    int64_t first = 0;
+    int64_t previous = 0;
+    for (int i = 0; i < c_traceStageCount; i++) {
+        const int64_t stamp = trace.stamps[i];
+        if (stamp == 0) {
+            continue;
+        }
+        if (previous != 0) {
+            add(m_stages[i], (stamp - previous) * 1e-9);
+        } else {
+            first = stamp;
+        }
+        previous = stamp;
+    }
+    if (previous != first) {
+        add(m_total, (previous - first) * 1e-9);
+    }
+}
+
+size_t LatencyCollector::loadLog(const std::string& filename)
+{
+    std::ifstream inFile(filename, std::ifstream::binary);
+    if (!inFile.good()) {
+        LOG_ERROR("Opening trace log failed: %s", filename.c_str());
+        return 0;
+    }
+
+    size_t count = 0;
+    uint8_t data[c_traceRecordSize];
+    FrameTrace trace;
+    while (inFile.read(reinterpret_cast<char*>(data), sizeof(data))) {
+        if (parseTrace(data, sizeof(data), trace)) {
+            record(trace);
+            count++;
+        } else {
+            LOG_WARNING("Invalid trace record in log: %s", filename.c_str());
+        }
+    }
+    return count;
+}
+
+LatencyCollector::Stats LatencyCollector::getStageStats(TraceStage stage) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const int index = static_cast<int>(stage);
+    return (index >= 0 && index < c_traceStageCount) ? computeStats(m_stages[index]) : Stats{};
+}
+
+LatencyCollector::Stats LatencyCollector::getTotalStats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return computeStats(m_total);
+}
+
+uint64_t LatencyCollector::getTraceCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_traceCount;
+}
+
+std::string LatencyCollector::toJson() const
+{
+    const auto format = [](const Stats& stats) {
+        char line[256];
+        snprintf(line, sizeof(line), "{\"count\": %llu, \"mean\": %.6f, \"p50\": %.6f, \"p90\": %.6f, \"p99\": %.6f, \"max\": %.6f}",
+            static_cast<unsigned long long>(stats.count), stats.mean, stats.p50, stats.p90, stats.p99, stats.max);
+        return std::string(line);
+    };
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::string json = "{\n  \"traces\": " + std::to_string(m_traceCount) + ",\n  \"unit\": \"seconds\",\n  \"stages\": {";
+    for (int i = 1; i < c_traceStageCount; i++) {
+        json += (i == 1) ? "\n" : ",\n";
+        json += std::string("    \"") + c_stageNames[i] + "\": " + format(computeStats(m_stages[i]));
+    }
+    json += "\n  },\n  \"total\": " + format(computeStats(m_total)) + "\n}\n";
+    return json;
+}
+
+bool LatencyCollector::writeReport(const std::string& filename) const
+{
+    const std::string json = toJson();
+    std::ofstream outFile(filename, std::ofstream::binary);
+    outFile.write(json.data(), json.size());
+    if (!outFile.good()) {
+        LOG_ERROR("Writing latency report failed: %s", filename.c_str());
+        return false;
+    }
+    return true;
+}
+
+void LatencyCollector::reset()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stages = {};
+    m_total = {};
+    m_traceCount = 0;
+}
+
+void LatencyCollector::add(Samples& samples, double value)
+{
+    samples.count++;
+    samples.sum += value;
+    samples.max = (samples.count == 1) ? value : std::max(samples.max, value);
+
+    if (samples.values.size() < m_maxSamples) {
+        samples.values.push_back(value);
+        return;
+    }
+
+    // Reservoir sampling: replace random kept sample with probability maxSamples / count
+    m_random ^= m_random << 13;
+    m_random ^= m_random >> 7;
+    m_random ^= m_random << 17;
+    const uint64_t slot = m_random % samples.count;
+    if (slot < samples.values.size()) {
+        samples.values[slot] = value;
+    }
+}
+
+LatencyCollector::Stats LatencyCollector::computeStats(const Samples& samples)
+{
+    Stats stats;
+    stats.count = samples.count;
+    if (samples.count == 0) {
+        return stats;
+    }
+
+    std::vector<double> sorted = samples.values;
+    std::sort(sorted.begin(), sorted.end());
+    stats.mean = samples.sum / samples.count;
+    stats.p50 = percentile(sorted, 0.50);
+    stats.p90 = percentile(sorted, 0.90);
+    stats.p99 = percentile(sorted, 0.99);
+    stats.max = samples.max;
+    return stats;
+}
+
+}  // namespace VarjoExamples
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <array>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Globals.hpp"
+
+namespace VarjoExamples
+{
+//! Stages a captured frame passes on its way to the replay overlay, in order
+enum class TraceStage : int {
+    Exposure = 0,   //!< Camera exposure, from stream frame timestamp
+    Capture,        //!< Frame callback in DataStreamer
+    Publish,        //!< Snapshot written for detector
+    Ingest,         //!< Snapshot read by detector
+    Detection,      //!< Detic inference done
+    Visualization,  //!< Overlay images written
+    Transport,      //!< Overlay images read by Unity
+    Upload,         //!< Overlay texture uploaded and shown
+    Count
+};
+
+//! Number of trace stages
+constexpr int c_traceStageCount = static_cast<int>(TraceStage::Count);
+
+//! Serialized FrameTrace size in bytes
+constexpr size_t c_traceRecordSize = 88;
+
+//! Return stage name
+const char* getTraceStageName(TraceStage stage);
+
+//! Return trace clock time in nanoseconds. The clock is the system monotonic clock (QueryPerformanceCounter on
+//! Windows), the same one Python time.perf_counter_ns() and .NET Stopwatch.GetTimestamp() read, so stamps from
+//! the recorder, detector and Unity processes are comparable.
+int64_t traceNow();
+
+//! Frame id and timestamp envelope carried with a frame through every stage. Each stage stamps its trace clock
+//! time. Serialized little-endian as magic "FTRC", version, stage count, frame number, sensor timestamp and stamps.
+struct FrameTrace {
+    int64_t frameNumber = 0;                          //!< Stream frame number
+    int64_t sensorTimestamp = 0;                      //!< Stream frame timestamp in Varjo time
+    std::array<int64_t, c_traceStageCount> stamps{};  //!< Trace clock time of each stage, zero if not reached
+
+    //! Stamp stage with given trace clock time
+    void stamp(TraceStage stage, int64_t time = traceNow()) { stamps[static_cast<int>(stage)] = time; }
+
+    //! Return true if stage was stamped
+    bool has(TraceStage stage) const { return stamps[static_cast<int>(stage)] != 0; }
+};
+
+//! Serialize trace into c_traceRecordSize bytes
+void serializeTrace(const FrameTrace& trace, uint8_t* out);
+
+//! Parse serialized trace. Returns false on bad size, magic or version.
+bool parseTrace(const uint8_t* data, size_t size, FrameTrace& outTrace);
+
+//! Write trace as sidecar file next to a stage output, atomically replacing previous. Returns false on failure.
+bool writeTraceFile(const std::string& filename, const FrameTrace& trace);
+
+//! Read trace sidecar file. Returns false if missing or invalid.
+bool readTraceFile(const std::string& filename, FrameTrace& outTrace);
+
+//! Append trace to session trace log. Returns false on failure.
+bool appendTraceLog(const std::string& filename, const FrameTrace& trace);
+
+//! Collects frame traces of a session into per-stage latency distributions.
+//!
+//! The latency of a stage is the time from the previous stamped stage of the same trace, so a trace that skips a
+//! stage still contributes to the rest. Total latency runs from the first to the last stamped stage. Samples are
+//! kept exactly up to a limit per stage, after which reservoir sampling keeps a uniform subset.
+class LatencyCollector
+{
+public:
+    //! Latency distribution in seconds
+    struct Stats {
+        uint64_t count = 0;  //!< Samples
+        double mean = 0.0;   //!< Mean
+        double p50 = 0.0;    //!< Median
+        double p90 = 0.0;    //!< 90th percentile
+        double p99 = 0.0;    //!< 99th percentile
+        double max = 0.0;    //!< Largest
+    };
+
+    //! Construct collector keeping at most maxSamples samples per stage
+    LatencyCollector(size_t maxSamples = 100000);
+
+    // Disable copy, move and assign
+    LatencyCollector(const LatencyCollector& other) = delete;
+    LatencyCollector(const LatencyCollector&& other) = delete;
+    LatencyCollector& operator=(const LatencyCollector& other) = delete;
+    LatencyCollector& operator=(const LatencyCollector&& other) = delete;
+
+    //! Add trace. Thread safe.
+    void record(const FrameTrace& trace);
+
+    //! Add all traces of session trace log. Returns number of traces read.
+    size_t loadLog(const std::string& filename);
+
+    //! Return latency into stage from previous stamped stage
+    Stats getStageStats(TraceStage stage) const;
+
+    //! Return latency from first to last stamped stage
+    Stats getTotalStats() const;
+
+    //! Return recorded trace count
+    uint64_t getTraceCount() const;
+
+    //! Format per-stage breakdown as JSON
+    std::string toJson() const;
+
+    //! Write JSON report to file. Returns false on failure.
+    bool writeReport(const std::string& filename) const;
+
+    //! Drop all samples
+    void reset();
+
+private:
+    //! Samples of one distribution
+    struct Samples {
+        std::vector<double> values;  //!< Kept samples in seconds
+        uint64_t count = 0;          //!< All samples seen
+        double sum = 0.0;            //!< Sum of all samples
+        double max = 0.0;            //!< Largest sample
+    };
+
+    //! Add sample to distribution. Requires lock.
+    void add(Samples& samples, double value);
+
+    //! Compute distribution statistics. Requires lock.
+    static Stats computeStats(const Samples& samples);
+
+private:
+    const size_t m_maxSamples;                        //!< Kept samples per distribution
+    mutable std::mutex m_mutex;                       //!< Lock for samples
+    std::array<Samples, c_traceStageCount> m_stages;  //!< Stage latencies
+    Samples m_total;                                  //!< Total latencies
+    uint64_t m_traceCount = 0;                        //!< Recorded traces
+    uint64_t m_random = 0x9E3779B97F4A7C15ull;        //!< Reservoir sampling state
+};
+
+}  // namespace VarjoExamples
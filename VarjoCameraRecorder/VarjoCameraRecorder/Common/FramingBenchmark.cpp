@@ -0,0 +1,202 @@
+#include "FramingBenchmark.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+namespace VarjoExamples
+{
+FramingBenchmark::Result FramingBenchmark::run(const Config& config)
+{
+    Result result;
+
+    // Payload with recognizable pattern so receiver can spot torn or reordered chunks
+    std::vector<uint8_t> payload(config.messageSize);
+    for (size_t i = 0; i < payload.size(); i++) {
+        payload[i] = static_cast<uint8_t>(i * 31 + 7);
+    }
+
+    const int segmentCount = std::max(config.segmentCount, 1);
+    std::vector<ConstBuffer> segments(segmentCount);
+    const size_t segmentSize = payload.size() / segmentCount;
+    for (int i = 0; i < segmentCount; i++) {
+        segments[i].data = payload.data() + i * segmentSize;
+        segments[i].size = (i == segmentCount - 1) ? payload.size() - i * segmentSize : segmentSize;
+    }
+
+    MessageListener listener(config.port, config.chunkSize);
+
+    using Clock = std::chrono::high_resolution_clock;
+    Clock::time_point endTime;
+    bool received = true;
+
+    std::thread receiver([&] {
+        auto connection = listener.accept();
+        if (!connection) {
+            received = false;
+            return;
+        }
+
+        Message message;
+        for (int i = 0; i < config.messageCount; i++) {
+            if (!connection->receive(message) || message.size != payload.size() ||
+                (message.size > 0 && (message.data()[0] != payload[0] || message.data()[message.size - 1] != payload.back()))) {
+                received = false;
+                break;
+            }
+            result.messages++;
+            result.bytes += message.size;
+        }
+        endTime = Clock::now();
+
+        const auto stats = connection->getPool().getStats();
+        result.poolAllocations = stats.allocations;
+        result.poolReuses = stats.reuses;
+    });
+
+    auto connection = MessageConnection::connect("127.0.0.1", listener.getPort(), config.chunkSize);
+    const auto startTime = Clock::now();
+    bool sent = connection != nullptr;
+    for (int i = 0; sent && i < config.messageCount; i++) {
+        sent = connection->send(static_cast<uint16_t>(1), segments.data(), segments.size());
+    }
+
+    if (!sent) {
+        listener.close();
+        if (connection) {
+            connection->close();
+        }
+    }
+    receiver.join();
+
+    result.valid = sent && received;
+    result.seconds = std::chrono::duration<double>(endTime - startTime).count();
+    if (result.valid && result.seconds > 0.0) {
+        result.megabytesPerSecond = static_cast<double>(result.bytes) / (1024.0 * 1024.0) / result.seconds;
+        result.messagesPerSecond = static_cast<double>(result.messages) / result.seconds;
+    }
+
+    LOG_INFO("Framing benchmark: size=%zu, count=%d, chunk=%zu, %.1f MB/s, %.1f msg/s, allocations=%llu, reuses=%llu", config.messageSize,
+        config.messageCount, config.chunkSize, result.megabytesPerSecond, result.messagesPerSecond,
+        static_cast<unsigned long long>(result.poolAllocations), static_cast<unsigned long long>(result.poolReuses));
+    return result;
+}
+
+FramingBenchmark::MultiplexResult FramingBenchmark::runMultiplexed(const MultiplexConfig& config)
+{
+    using Channel = MultiplexConnection::Channel;
+    using Clock = std::chrono::high_resolution_clock;
+
+    MultiplexResult result;
+
+    auto payload = std::make_shared<std::vector<uint8_t>>(config.bulkSize);
+    for (size_t i = 0; i < payload->size(); i++) {
+        (*payload)[i] = static_cast<uint8_t>(i * 31 + 7);
+    }
+
+    std::mutex mutex;
+    std::condition_variable bulkCondition;
+    bool corrupted = false;
+    Clock::time_point endTime;
+    std::vector<Clock::time_point> controlSent;
+    double totalRoundTrip = 0.0;
+
+    // Server echoes control messages and checks bulk frames. Handler runs on the server receiver thread, which is
+    // joined in the server destructor, so the raw pointer stays valid while the handler can run.
+    std::unique_ptr<MultiplexConnection> server;
+    MultiplexConnection* echo = nullptr;
+    auto serverHandler = [&](Channel channel, Message& message) {
+        if (channel == Channel::Control) {
+            echo->send(Channel::Control, message.type, message.data(), message.size);
+            return;
+        }
+        const bool intact = message.size == payload->size() &&
+                            (message.size == 0 || (message.data()[0] == payload->front() && message.data()[message.size - 1] == payload->back()));
+        std::lock_guard<std::mutex> lock(mutex);
+        corrupted |= !intact;
+        result.bulkFrames += intact ? 1 : 0;
+        if (corrupted || result.bulkFrames == static_cast<uint64_t>(config.bulkCount)) {
+            endTime = Clock::now();
+            bulkCondition.notify_all();
+        }
+    };
+
+    // Client measures round trip of each echoed control message
+    auto clientHandler = [&](Channel channel, Message& message) {
+        uint32_t index = 0;
+        if (channel != Channel::Control || message.size != sizeof(index)) {
+            return;
+        }
+        std::memcpy(&index, message.data(), sizeof(index));
+        const auto now = Clock::now();
+        std::lock_guard<std::mutex> lock(mutex);
+        if (index < controlSent.size()) {
+            const double roundTrip = std::chrono::duration<double>(now - controlSent[index]).count();
+            result.controlRoundTrips++;
+            result.maxControlRoundTrip = std::max(result.maxControlRoundTrip, roundTrip);
+            totalRoundTrip += roundTrip;
+        }
+    };
+
+    MessageListener listener(config.port);
+    uintptr_t serverSocket = MessageConnection::c_invalidSocket;
+    std::thread acceptor([&] { serverSocket = listener.acceptSocket(); });
+    auto client = MultiplexConnection::connect("127.0.0.1", listener.getPort(), clientHandler, config.connection);
+    if (!client) {
+        listener.close();
+    }
+    acceptor.join();
+    if (!client || serverSocket == MessageConnection::c_invalidSocket) {
+        MessageConnection::closeSocket(serverSocket);
+        LOG_ERROR("Multiplex benchmark failed to connect.");
+        return result;
+    }
+    server = std::make_unique<MultiplexConnection>(serverSocket, serverHandler, config.connection);
+    echo = server.get();
+
+    // Queue all bulk frames up front so control always competes with a full backlog
+    const auto startTime = Clock::now();
+    bool sent = true;
+    for (int i = 0; sent && i < config.bulkCount; i++) {
+        sent = client->send(Channel::Bulk, static_cast<uint16_t>(1), payload, payload->data(), payload->size());
+    }
+
+    const auto deadline = startTime + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(config.timeout));
+    const auto interval = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(config.controlInterval));
+    bool finished = false;
+    while (sent && !finished && Clock::now() < deadline) {
+        uint32_t index = 0;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            index = static_cast<uint32_t>(controlSent.size());
+            controlSent.push_back(Clock::now());
+        }
+        sent = client->send(Channel::Control, static_cast<uint16_t>(2), &index, sizeof(index));
+
+        std::unique_lock<std::mutex> lock(mutex);
+        finished = bulkCondition.wait_for(lock, interval, [&] { return corrupted || result.bulkFrames == static_cast<uint64_t>(config.bulkCount); });
+    }
+
+    // Let the last echo come back before closing
+    std::this_thread::sleep_for(interval);
+    client.reset();
+    server.reset();
+
+    result.valid = sent && finished && !corrupted;
+    if (result.valid) {
+        result.seconds = std::chrono::duration<double>(endTime - startTime).count();
+        result.bulkMegabytesPerSecond =
+            (result.seconds > 0.0) ? static_cast<double>(result.bulkFrames * config.bulkSize) / (1024.0 * 1024.0) / result.seconds : 0.0;
+        result.avgControlRoundTrip = (result.controlRoundTrips > 0) ? totalRoundTrip / static_cast<double>(result.controlRoundTrips) : 0.0;
+    }
+
+    LOG_INFO("Multiplex benchmark: bulk=%zu x %d, %.1f MB/s, control round trips=%llu, avg=%.2f ms, max=%.2f ms", config.bulkSize,
+        config.bulkCount, result.bulkMegabytesPerSecond, static_cast<unsigned long long>(result.controlRoundTrips),
+        result.avgControlRoundTrip * 1000.0, result.maxControlRoundTrip * 1000.0);
+    return result;
+}
+
+}  // namespace VarjoExamples
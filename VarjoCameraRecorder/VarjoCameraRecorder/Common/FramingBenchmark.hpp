@@ -0,0 +1,62 @@
+#pragma once
+
+#include "MessageFraming.hpp"
+#include "MultiplexConnection.hpp"
+
+namespace VarjoExamples
+{
+//! Loopback benchmarks for MessageConnection throughput and MultiplexConnection control latency
+class FramingBenchmark
+{
+public:
+    //! Benchmark configuration
+    struct Config {
+        size_t messageSize = 4 << 20;                              //!< Payload size per message in bytes
+        int messageCount = 256;                                    //!< Messages to send
+        int segmentCount = 2;                                      //!< Gather segments per message
+        size_t chunkSize = MessageConnection::c_defaultChunkSize;  //!< Maximum chunk payload size
+        uint16_t port = 0;                                         //!< Loopback port, zero picks a free port
+    };
+
+    //! Benchmark result
+    struct Result {
+        bool valid = false;               //!< False if connection failed or data was corrupted
+        uint64_t messages = 0;            //!< Messages received
+        uint64_t bytes = 0;               //!< Payload bytes received
+        double seconds = 0.0;             //!< Time from first send to last receive
+        double megabytesPerSecond = 0.0;  //!< Payload throughput in MB/s
+        double messagesPerSecond = 0.0;   //!< Message rate
+        uint64_t poolAllocations = 0;     //!< Receive buffers allocated from heap
+        uint64_t poolReuses = 0;          //!< Receive buffers reused from pool
+    };
+
+    //! Multiplexed benchmark configuration
+    struct MultiplexConfig {
+        size_t bulkSize = 4 << 20;                 //!< Payload size per bulk frame in bytes
+        int bulkCount = 200;                       //!< Bulk frames to stream
+        double controlInterval = 0.005;            //!< Seconds between control echo requests
+        double timeout = 60.0;                     //!< Seconds to wait for all bulk frames
+        MultiplexConnection::Config connection{};  //!< Channel configuration of both ends
+        uint16_t port = 0;                         //!< Loopback port, zero picks a free port
+    };
+
+    //! Multiplexed benchmark result
+    struct MultiplexResult {
+        bool valid = false;                   //!< False if connection failed, timed out or bulk data was corrupted
+        uint64_t bulkFrames = 0;              //!< Bulk frames received intact
+        uint64_t controlRoundTrips = 0;       //!< Control echoes received
+        double seconds = 0.0;                 //!< Time from first bulk send to last bulk receive
+        double bulkMegabytesPerSecond = 0.0;  //!< Bulk payload throughput in MB/s
+        double maxControlRoundTrip = 0.0;     //!< Worst control round trip in seconds
+        double avgControlRoundTrip = 0.0;     //!< Average control round trip in seconds
+    };
+
+    //! Run benchmark over loopback. Blocks until all messages are received.
+    static Result run(const Config& config);
+
+    //! Stream bulk frames over a multiplexed loopback connection while echoing control messages at a fixed
+    //! interval, measuring control round trips behind the bulk backlog. Blocks until all frames are received.
+    static MultiplexResult runMultiplexed(const MultiplexConfig& config);
+};
+
+}  // namespace VarjoExamples
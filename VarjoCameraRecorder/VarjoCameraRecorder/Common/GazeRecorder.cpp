@@ -0,0 +1,537 @@
+#include "GazeRecorder.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+namespace
+{
+// Log magic "GAZL" and format version
+constexpr uint32_t c_logMagic = 0x4C5A4147;
+constexpr uint16_t c_logVersion = 1;
+
+// Serialized sample size in bytes
+constexpr size_t c_recordSize = 24;
+
+// Fixed-point scale of unit vectors
+constexpr double c_directionScale = 16384.0;
+
+// Largest focus distance in millimeters that fits the sample
+constexpr int c_maxFocusMillimeters = 0x3FFF;
+
+// Sample gap that ends a fixation, e.g. a blink or dropped samples
+constexpr int64_t c_maxFixationGap = 50000000;
+
+// Samples per log read
+constexpr size_t c_logChunk = 4096;
+
+// Pack unit vector to fixed point
+std::array<int16_t, 3> packDirection(const glm::dvec3& direction)
+{
+    const double length = glm::length(direction);
+    std::array<int16_t, 3> packed{};
+    if (length <= 0.0) {
+        return packed;
+    }
+    for (int i = 0; i < 3; i++) {
+        const double value = std::round(direction[i] / length * c_directionScale);
+        packed[i] = static_cast<int16_t>(std::max(std::min(value, 32767.0), -32768.0));
+    }
+    return packed;
+}
+
+// Pack three 16-bit values and a 16-bit tail into one word
+uint64_t packWord(const std::array<int16_t, 3>& values, uint16_t tail)
+{
+    return static_cast<uint64_t>(static_cast<uint16_t>(values[0])) | (static_cast<uint64_t>(static_cast<uint16_t>(values[1])) << 16) |
+           (static_cast<uint64_t>(static_cast<uint16_t>(values[2])) << 32) | (static_cast<uint64_t>(tail) << 48);
+}
+
+// Unpack word of packWord
+void unpackWord(uint64_t word, std::array<int16_t, 3>& outValues, uint16_t& outTail)
+{
+    outValues[0] = static_cast<int16_t>(static_cast<uint16_t>(word));
+    outValues[1] = static_cast<int16_t>(static_cast<uint16_t>(word >> 16));
+    outValues[2] = static_cast<int16_t>(static_cast<uint16_t>(word >> 32));
+    outTail = static_cast<uint16_t>(word >> 48);
+}
+
+// Write little endian value
+template <typename T>
+inline uint8_t* put(uint8_t* out, T value)
+{
+    for (size_t i = 0; i < sizeof(T); i++) {
+        out[i] = static_cast<uint8_t>(static_cast<uint64_t>(value) >> (8 * i));
+    }
+    return out + sizeof(T);
+}
+
+// Read little endian value
+template <typename T>
+inline const uint8_t* get(const uint8_t* in, T& value)
+{
+    uint64_t v = 0;
+    for (size_t i = 0; i < sizeof(T); i++) {
+        v |= static_cast<uint64_t>(in[i]) << (8 * i);
+    }
+    value = static_cast<T>(v);
+    return in + sizeof(T);
+}
+
+// Return config with ring, batch and region sizes clamped to at least one
+VarjoExamples::GazeRecorder::Config getValidConfig(VarjoExamples::GazeRecorder::Config config)
+{
+    config.capacity = std::max(config.capacity, 1);
+    config.batchSize = std::max(config.batchSize, 1);
+    config.regionColumns = std::max(config.regionColumns, 1);
+    config.regionRows = std::max(config.regionRows, 1);
+    return config;
+}
+
+}  // namespace
+
+namespace VarjoExamples
+{
+GazeRecorder::GazeRecorder()
+    : GazeRecorder(Config())
+{
+}
+
+GazeRecorder::GazeRecorder(const Config& config)
+    : m_config(getValidConfig(config))
+    , m_slots(new Slot[m_config.capacity])
+    , m_dwell(static_cast<size_t>(m_config.regionColumns * m_config.regionRows), 0.0)
+{
+}
+
+GazeRecorder::~GazeRecorder() { stop(); }
+
+bool GazeRecorder::start(varjo_Session* session)
+{
+    if (m_running) {
+        return true;
+    }
+
+#if defined(_WIN32)
+    if (!varjo_IsGazeAllowed(session)) {
+        LOG_ERROR("Gaze recorder failed: gaze tracking not allowed");
+        return false;
+    }
+
+    // Gaze may already be initialized by the application
+    varjo_GazeInit(session);
+    const varjo_Error error = varjo_GetError(session);
+    if (error != varjo_NoError && error != varjo_Error_GazeAlreadyInitialized) {
+        LOG_ERROR("Gaze recorder failed: %s", varjo_GetErrorDesc(error));
+        return false;
+    }
+
+    m_session = session;
+    m_running = true;
+    m_pollThread = std::thread(&GazeRecorder::pollLoop, this);
+    LOG_INFO("Gaze recorder started: capacity=%d, batch=%d", m_config.capacity, m_config.batchSize);
+    return true;
+#else
+    (void)session;
+    LOG_ERROR("Gaze recorder failed: Varjo runtime is only available on Windows");
+    return false;
+#endif
+}
+
+void GazeRecorder::stop()
+{
+    m_running = false;
+    if (m_pollThread.joinable()) {
+        m_pollThread.join();
+    }
+    m_session = nullptr;
+}
+
+void GazeRecorder::updateHeadPose(const varjo_Matrix& hmdPose)
+{
+    const glm::dmat3 rotation(glm::make_mat4(hmdPose.value));
+    std::lock_guard<std::mutex> lock(m_poseMutex);
+    m_headRotation = rotation;
+    m_hasPose = true;
+}
+
+void GazeRecorder::record(const varjo_Gaze* gazes, int count)
+{
+    glm::dmat3 rotation;
+    bool hasPose = false;
+    {
+        std::lock_guard<std::mutex> lock(m_poseMutex);
+        rotation = m_headRotation;
+        hasPose = m_hasPose;
+    }
+
+    std::vector<Sample> samples(static_cast<size_t>(std::max(count, 0)));
+    for (int i = 0; i < count; i++) {
+        const varjo_Gaze& gaze = gazes[i];
+        const glm::dvec3 forward(gaze.gaze.forward[0], gaze.gaze.forward[1], gaze.gaze.forward[2]);
+        const int focus = static_cast<int>(std::round(std::max(gaze.focusDistance, 0.0) * 1000.0));
+
+        Sample& sample = samples[i];
+        sample.time = gaze.captureTime;
+        sample.gaze = packDirection(forward);
+        sample.focusAndStatus = static_cast<uint16_t>((static_cast<int>(gaze.status) & 3) << 14 | std::min(focus, c_maxFocusMillimeters));
+
+        // Gaze is +Z forward, HMD space -Z forward
+        if (hasPose) {
+            sample.world = packDirection(rotation * glm::dvec3(forward.x, forward.y, -forward.z));
+            sample.flags |= c_flagWorld;
+        }
+    }
+    recordSamples(samples.data(), samples.size());
+}
+
+void GazeRecorder::recordSamples(const Sample* samples, size_t count)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (size_t i = 0; i < count; i++) {
+        push(samples[i]);
+        updateFixation(samples[i]);
+        m_stats.samples++;
+        if (samples[i].isValid()) {
+            m_stats.valid++;
+        }
+    }
+}
+
+bool GazeRecorder::getSampleAt(int64_t time, int64_t maxDelta, Sample& outSample) const
+{
+    const uint64_t capacity = static_cast<uint64_t>(m_config.capacity);
+    const uint64_t end = m_written.load(std::memory_order_acquire);
+    const uint64_t begin = end > capacity ? end - capacity : 0;
+    const uint64_t index = lowerBound(begin, end, time);
+
+    // Closest of the samples around the bound
+    bool found = false;
+    int64_t bestDelta = maxDelta;
+    for (uint64_t candidate = (index > begin ? index - 1 : index); candidate < std::min(index + 1, end); candidate++) {
+        Sample sample;
+        if (!read(candidate, sample)) {
+            continue;
+        }
+        const int64_t delta = std::abs(sample.time - time);
+        if (delta <= bestDelta) {
+            outSample = sample;
+            bestDelta = delta;
+            found = true;
+        }
+    }
+    return found;
+}
+
+void GazeRecorder::getSamples(int64_t t0, int64_t t1, std::vector<Sample>& outSamples) const
+{
+    outSamples.clear();
+    const uint64_t capacity = static_cast<uint64_t>(m_config.capacity);
+    const uint64_t end = m_written.load(std::memory_order_acquire);
+    const uint64_t begin = end > capacity ? end - capacity : 0;
+
+    Sample sample;
+    for (uint64_t index = lowerBound(begin, end, t0); index < end; index++) {
+        // Samples lapped by the writer while copying are skipped
+        if (!read(index, sample)) {
+            continue;
+        }
+        if (sample.time > t1) {
+            break;
+        }
+        if (sample.time >= t0) {
+            outSamples.push_back(sample);
+        }
+    }
+}
+
+double GazeRecorder::getAngleTo(const glm::dvec3& direction, int64_t time, int64_t maxDelta) const
+{
+    Sample sample;
+    const double length = glm::length(direction);
+    if (length <= 0.0 || !getSampleAt(time, maxDelta, sample) || !sample.isValid() || !sample.hasWorld()) {
+        return -1.0;
+    }
+    const double cosine = glm::dot(glm::normalize(sample.getWorld()), direction / length);
+    return std::acos(std::max(std::min(cosine, 1.0), -1.0));
+}
+
+std::vector<GazeRecorder::Fixation> GazeRecorder::getFixations(int64_t t0, int64_t t1) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<Fixation> fixations;
+    for (const Fixation& fixation : m_fixations) {
+        if (fixation.end >= t0 && fixation.start <= t1) {
+            fixations.push_back(fixation);
+        }
+    }
+
+    // Fixation in progress
+    if (m_currentCount > 0 && m_current.end - m_current.start >= m_config.minFixationDuration && m_current.end >= t0 && m_current.start <= t1) {
+        Fixation current = m_current;
+        current.direction = glm::normalize(m_currentSum);
+        current.region = getRegion(current.direction);
+        fixations.push_back(current);
+    }
+    return fixations;
+}
+
+std::vector<double> GazeRecorder::getDwellTimes() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<double> dwell = m_dwell;
+    if (m_currentCount > 0 && m_current.end - m_current.start >= m_config.minFixationDuration) {
+        dwell[getRegion(glm::normalize(m_currentSum))] += (m_current.end - m_current.start) * 1e-9;
+    }
+    return dwell;
+}
+
+int GazeRecorder::getRegion(const glm::dvec3& direction) const
+{
+    // Yaw zero looks along -Z, pitch positive up
+    const int columns = m_config.regionColumns;
+    const int rows = m_config.regionRows;
+    const double length = std::max(glm::length(direction), 1e-9);
+    const double yaw = std::atan2(direction.x, -direction.z);
+    const double pitch = std::asin(std::max(std::min(direction.y / length, 1.0), -1.0));
+    const int column = static_cast<int>((yaw + glm::pi<double>()) / (2.0 * glm::pi<double>()) * columns);
+    const int row = static_cast<int>((pitch + 0.5 * glm::pi<double>()) / glm::pi<double>() * rows);
+    return std::min(std::max(row, 0), rows - 1) * columns + std::min(std::max(column, 0), columns - 1);
+}
+
+GazeRecorder::Stats GazeRecorder::getStats() const
+{
+    Stats stats;
+    stats.samples = m_stats.samples;
+    stats.valid = m_stats.valid;
+    stats.drains = m_stats.drains;
+    stats.fixations = m_stats.fixations;
+    return stats;
+}
+
+bool GazeRecorder::writeLog(const std::string& filename) const
+{
+    std::vector<Sample> samples;
+    getSamples(std::numeric_limits<int64_t>::min(), std::numeric_limits<int64_t>::max(), samples);
+
+    std::vector<uint8_t> data(8 + samples.size() * c_recordSize);
+    uint8_t* out = data.data();
+    out = put<uint32_t>(out, c_logMagic);
+    out = put<uint16_t>(out, c_logVersion);
+    out = put<uint16_t>(out, static_cast<uint16_t>(c_recordSize));
+    for (const Sample& sample : samples) {
+        out = put<int64_t>(out, sample.time);
+        out = put<uint64_t>(out, packWord(sample.gaze, sample.focusAndStatus));
+        out = put<uint64_t>(out, packWord(sample.world, sample.flags));
+    }
+
+    // The log is refreshed while the detector may read it, so write a temporary file and replace the log in one rename
+    const std::string tempFilename = filename + ".tmp";
+    {
+        std::ofstream outFile(tempFilename, std::ofstream::binary | std::ofstream::trunc);
+        outFile.write(reinterpret_cast<const char*>(data.data()), data.size());
+        if (!outFile.good()) {
+            LOG_ERROR("Writing gaze log failed: %s", tempFilename.c_str());
+            return false;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(tempFilename, filename, error);
+    if (error) {
+        LOG_ERROR("Replacing gaze log failed: %s: %s", filename.c_str(), error.message().c_str());
+        std::filesystem::remove(tempFilename, error);
+        return false;
+    }
+    return true;
+}
+
+size_t GazeRecorder::loadLog(const std::string& filename)
+{
+    std::ifstream inFile(filename, std::ifstream::binary);
+    uint8_t header[8];
+    if (!inFile.read(reinterpret_cast<char*>(header), sizeof(header))) {
+        LOG_ERROR("Opening gaze log failed: %s", filename.c_str());
+        return 0;
+    }
+
+    uint32_t magic = 0;
+    uint16_t version = 0;
+    uint16_t recordSize = 0;
+    get(get(get(header, magic), version), recordSize);
+    if (magic != c_logMagic || version != c_logVersion || recordSize != c_recordSize) {
+        LOG_ERROR("Invalid gaze log: %s", filename.c_str());
+        return 0;
+    }
+
+    size_t count = 0;
+    std::vector<uint8_t> data(c_logChunk * c_recordSize);
+    std::vector<Sample> samples;
+    while (inFile) {
+        inFile.read(reinterpret_cast<char*>(data.data()), data.size());
+        const size_t records = static_cast<size_t>(inFile.gcount()) / c_recordSize;
+
+        samples.resize(records);
+        const uint8_t* in = data.data();
+        for (Sample& sample : samples) {
+            uint64_t gazeWord = 0;
+            uint64_t worldWord = 0;
+            in = get(get(get(in, sample.time), gazeWord), worldWord);
+            unpackWord(gazeWord, sample.gaze, sample.focusAndStatus);
+            unpackWord(worldWord, sample.world, sample.flags);
+        }
+        recordSamples(samples.data(), samples.size());
+        count += records;
+    }
+    return count;
+}
+
+varjo_Gaze GazeRecorder::toVarjoGaze(const Sample& sample)
+{
+    varjo_Gaze gaze{};
+    const glm::dvec3 forward = sample.getGaze();
+    const double length = glm::length(forward);
+    for (int i = 0; i < 3; i++) {
+        gaze.gaze.forward[i] = length > 0.0 ? forward[i] / length : 0.0;
+    }
+    gaze.focusDistance = sample.getFocusDistance();
+    gaze.captureTime = sample.time;
+    gaze.status = sample.getStatus();
+    return gaze;
+}
+
+void GazeRecorder::push(const Sample& sample)
+{
+    // Announce slot before writing it, so readers that copied part of it see it was lapped
+    const uint64_t index = m_written.load(std::memory_order_relaxed);
+    m_writing.store(index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    Slot& slot = m_slots[index % static_cast<uint64_t>(m_config.capacity)];
+    slot.words[0].store(static_cast<uint64_t>(sample.time), std::memory_order_relaxed);
+    slot.words[1].store(packWord(sample.gaze, sample.focusAndStatus), std::memory_order_relaxed);
+    slot.words[2].store(packWord(sample.world, sample.flags), std::memory_order_relaxed);
+    m_written.store(index + 1, std::memory_order_release);
+}
+
+bool GazeRecorder::read(uint64_t index, Sample& outSample) const
+{
+    const uint64_t capacity = static_cast<uint64_t>(m_config.capacity);
+    if (index >= m_written.load(std::memory_order_acquire)) {
+        return false;
+    }
+
+    const Slot& slot = m_slots[index % capacity];
+    const uint64_t timeWord = slot.words[0].load(std::memory_order_relaxed);
+    const uint64_t gazeWord = slot.words[1].load(std::memory_order_relaxed);
+    const uint64_t worldWord = slot.words[2].load(std::memory_order_relaxed);
+
+    // Slot is reused by sample index + capacity, so the copy is intact if that write has not started
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (m_writing.load(std::memory_order_relaxed) > index + capacity) {
+        return false;
+    }
+
+    outSample.time = static_cast<int64_t>(timeWord);
+    unpackWord(gazeWord, outSample.gaze, outSample.focusAndStatus);
+    unpackWord(worldWord, outSample.world, outSample.flags);
+    return true;
+}
+
+int64_t GazeRecorder::peekTime(uint64_t index) const
+{
+    return static_cast<int64_t>(m_slots[index % static_cast<uint64_t>(m_config.capacity)].words[0].load(std::memory_order_relaxed));
+}
+
+uint64_t GazeRecorder::lowerBound(uint64_t begin, uint64_t end, int64_t time) const
+{
+    // Samples are in capture time order. A slot lapped during the search only shifts the bound near the old end.
+    while (begin < end) {
+        const uint64_t middle = begin + (end - begin) / 2;
+        if (peekTime(middle) < time) {
+            begin = middle + 1;
+        } else {
+            end = middle;
+        }
+    }
+    return begin;
+}
+
+void GazeRecorder::updateFixation(const Sample& sample)
+{
+    if (!sample.isValid() || !sample.hasWorld()) {
+        closeFixation();
+        return;
+    }
+
+    const glm::dvec3 direction = glm::normalize(sample.getWorld());
+    if (m_currentCount > 0) {
+        const double cosine = glm::dot(glm::normalize(m_currentSum), direction);
+        if (cosine < std::cos(glm::radians(m_config.fixationRadius)) || sample.time - m_current.end > c_maxFixationGap) {
+            closeFixation();
+        }
+    }
+
+    if (m_currentCount == 0) {
+        m_current = {};
+        m_current.start = sample.time;
+    }
+    m_current.end = sample.time;
+    m_currentSum += direction;
+    m_currentCount++;
+}
+
+void GazeRecorder::closeFixation()
+{
+    if (m_currentCount > 0 && m_current.end - m_current.start >= m_config.minFixationDuration) {
+        m_current.direction = glm::normalize(m_currentSum);
+        m_current.region = getRegion(m_current.direction);
+        m_dwell[m_current.region] += (m_current.end - m_current.start) * 1e-9;
+
+        m_fixations.push_back(m_current);
+        while (m_fixations.size() > m_config.maxFixations) {
+            m_fixations.pop_front();
+        }
+        m_stats.fixations++;
+    }
+
+    m_currentSum = glm::dvec3(0.0);
+    m_currentCount = 0;
+}
+
+void GazeRecorder::pollLoop()
+{
+#if defined(_WIN32)
+    std::vector<varjo_Gaze> gazes(static_cast<size_t>(m_config.batchSize));
+    varjo_Error lastError = varjo_NoError;
+
+    while (m_running) {
+        // Drain all samples since previous poll, a full batch means more are queued
+        int32_t count = 0;
+        do {
+            count = varjo_GetGazeDataArray(m_session, gazes.data(), nullptr, static_cast<int32_t>(gazes.size()));
+            m_stats.drains++;
+
+            // Log error once until it changes, gaze can be unavailable for a long time
+            const varjo_Error error = varjo_GetError(m_session);
+            if (error != varjo_NoError && error != lastError) {
+                LOG_ERROR("Reading gaze failed: %s", varjo_GetErrorDesc(error));
+            }
+            lastError = error;
+
+            if (count > 0) {
+                record(gazes.data(), count);
+            }
+        } while (count == static_cast<int32_t>(gazes.size()) && m_running);
+
+        std::this_thread::sleep_for(m_config.pollInterval);
+    }
+#endif
+}
+
+}  // namespace VarjoExamples
@@ -0,0 +1,209 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Globals.hpp"
+
+namespace VarjoExamples
+{
+//! Records the full rate gaze stream for replay prioritization.
+//!
+//! A poll thread drains varjo_GetGazeDataArray in batches, so no sample of the 200 Hz stream is lost between
+//! frames. Samples are packed into 24 byte fixed-point records and written to a ring that readers
+//! query by timestamp without locking: a reader copies a slot and then checks that the writer has not lapped it.
+//! Gaze directions are also rotated into world space with the latest HMD pose, so fixations and dwell time per
+//! equirectangular world region are computed incrementally as samples arrive.
+//!
+//! Sample times are Varjo time, the clock of stream frame timestamps, so samples align with DataStreamer frames.
+//! Without a session the recorder can be filled from a gaze log for queries during replay.
+class GazeRecorder
+{
+public:
+    //! Recorder configuration
+    struct Config {
+        int capacity = 1 << 16;                      //!< Ring capacity in samples, about five minutes at 200 Hz
+        int batchSize = 64;                          //!< Samples drained per call
+        std::chrono::milliseconds pollInterval{10};  //!< Time between drains
+        double fixationRadius = 1.5;                 //!< Largest angle in degrees of a fixation sample from the fixation center
+        int64_t minFixationDuration = 100000000;     //!< Shortest fixation in nanoseconds
+        int regionColumns = 36;                      //!< Dwell regions around the yaw circle
+        int regionRows = 18;                         //!< Dwell regions from pitch -90 to 90 degrees
+        size_t maxFixations = 4096;                  //!< Fixations kept for queries
+    };
+
+    //! Gaze sample in fixed point: directions as unit vectors in Q14, focus distance in millimeters
+    struct Sample {
+        int64_t time = 0;                //!< Capture time in Varjo time
+        std::array<int16_t, 3> gaze{};   //!< Gaze direction in HMD space, +Z forward
+        std::array<int16_t, 3> world{};  //!< Gaze direction in world space, -Z forward
+        uint16_t focusAndStatus = 0;     //!< Focus distance in bits 0-13, gaze status in bits 14-15
+        uint16_t flags = 0;              //!< Sample flags
+
+        //! Return gaze status
+        varjo_GazeStatus getStatus() const { return focusAndStatus >> 14; }
+
+        //! Return true if gaze is valid
+        bool isValid() const { return getStatus() == varjo_GazeStatus_Valid; }
+
+        //! Return true if world direction is known
+        bool hasWorld() const { return (flags & c_flagWorld) != 0; }
+
+        //! Return focus distance in meters, zero if not estimated
+        double getFocusDistance() const { return (focusAndStatus & 0x3FFF) * 0.001; }
+
+        //! Return gaze direction in HMD space
+        glm::dvec3 getGaze() const { return glm::dvec3(gaze[0], gaze[1], gaze[2]) / 16384.0; }
+
+        //! Return gaze direction in world space
+        glm::dvec3 getWorld() const { return glm::dvec3(world[0], world[1], world[2]) / 16384.0; }
+    };
+
+    //! Fixation, a run of samples within fixationRadius of their mean direction
+    struct Fixation {
+        int64_t start = 0;          //!< First sample time
+        int64_t end = 0;            //!< Last sample time
+        glm::dvec3 direction{0.0};  //!< Mean world direction
+        int region = -1;            //!< Dwell region of direction
+    };
+
+    //! Recorder statistics
+    struct Stats {
+        uint64_t samples = 0;    //!< Samples recorded
+        uint64_t valid = 0;      //!< Samples with valid gaze
+        uint64_t drains = 0;     //!< Drain calls
+        uint64_t fixations = 0;  //!< Fixations detected
+    };
+
+    //! Sample flag: world direction set from HMD pose
+    static constexpr uint16_t c_flagWorld = 1;
+
+    //! Construct recorder. Capacity, batch and region sizes below one are clamped to one.
+    GazeRecorder(const Config& config);
+
+    //! Construct recorder with default config
+    GazeRecorder();
+
+    //! Destruct recorder. Stops poll thread.
+    ~GazeRecorder();
+
+    // Disable copy, move and assign
+    GazeRecorder(const GazeRecorder& other) = delete;
+    GazeRecorder(const GazeRecorder&& other) = delete;
+    GazeRecorder& operator=(const GazeRecorder& other) = delete;
+    GazeRecorder& operator=(const GazeRecorder&& other) = delete;
+
+    //! Initialize gaze tracking and start poll thread. Returns false if gaze is not available.
+    bool start(varjo_Session* session);
+
+    //! Stop poll thread
+    void stop();
+
+    //! Set latest HMD world pose for rotating gaze into world space. Thread safe.
+    void updateHeadPose(const varjo_Matrix& hmdPose);
+
+    //! Record gaze samples in capture time order. Called by the poll thread while running.
+    void record(const varjo_Gaze* gazes, int count);
+
+    //! Record packed samples in capture time order, e.g. from a gaze log
+    void recordSamples(const Sample* samples, size_t count);
+
+    //! Find sample closest to Varjo time within maxDelta. Lock-free. Returns false if none.
+    bool getSampleAt(int64_t time, int64_t maxDelta, Sample& outSample) const;
+
+    //! Copy samples with time in [t0, t1] in time order. Lock-free.
+    void getSamples(int64_t t0, int64_t t1, std::vector<Sample>& outSamples) const;
+
+    //! Return angle in radians between world gaze at time and given world direction, negative if no valid gaze
+    //! within maxDelta. Large angles mean the user was looking away at that time.
+    double getAngleTo(const glm::dvec3& direction, int64_t time, int64_t maxDelta) const;
+
+    //! Return fixations overlapping [t0, t1], including the one in progress
+    std::vector<Fixation> getFixations(int64_t t0, int64_t t1) const;
+
+    //! Return dwell time in seconds per region, rows from bottom, columns from yaw -180 degrees
+    std::vector<double> getDwellTimes() const;
+
+    //! Return dwell region of world direction
+    int getRegion(const glm::dvec3& direction) const;
+
+    //! Return recorder configuration, as clamped by the constructor
+    const Config& getConfig() const { return m_config; }
+
+    //! Return recorder statistics
+    Stats getStats() const;
+
+    //! Write all ring samples to gaze log, replacing an existing log atomically. Returns false on failure.
+    bool writeLog(const std::string& filename) const;
+
+    //! Record all samples of gaze log. Returns number of samples read.
+    size_t loadLog(const std::string& filename);
+
+    //! Return varjo_Gaze with direction, focus, status and time of sample, origin at HMD center
+    static varjo_Gaze toVarjoGaze(const Sample& sample);
+
+private:
+    //! Ring slot, sample packed into three words
+    struct Slot {
+        std::array<std::atomic<uint64_t>, 3> words;  //!< Packed sample
+    };
+
+    //! Write sample to ring
+    void push(const Sample& sample);
+
+    //! Read sample at ring index. Returns false if writer lapped it.
+    bool read(uint64_t index, Sample& outSample) const;
+
+    //! Return time of sample at ring index without validation
+    int64_t peekTime(uint64_t index) const;
+
+    //! Return first ring index with time >= given time among indices in [begin, end)
+    uint64_t lowerBound(uint64_t begin, uint64_t end, int64_t time) const;
+
+    //! Feed sample to fixation detector. Requires lock.
+    void updateFixation(const Sample& sample);
+
+    //! Close fixation in progress, keeping it if long enough. Requires lock.
+    void closeFixation();
+
+    //! Poll thread main loop
+    void pollLoop();
+
+private:
+    const Config m_config;               //!< Recorder configuration
+    std::unique_ptr<Slot[]> m_slots;     //!< Sample ring
+    std::atomic<uint64_t> m_written{0};  //!< Samples written, ring index of next sample
+    std::atomic<uint64_t> m_writing{0};  //!< Samples written or being written
+
+    mutable std::mutex m_poseMutex;  //!< Lock for pose
+    glm::dmat3 m_headRotation{1.0};  //!< Latest HMD world rotation
+    bool m_hasPose = false;          //!< Is pose known
+
+    mutable std::mutex m_mutex;        //!< Lock for writers, fixations and dwell
+    std::deque<Fixation> m_fixations;  //!< Recent fixations, oldest first
+    Fixation m_current;                //!< Fixation candidate in progress
+    glm::dvec3 m_currentSum{0.0};      //!< Sum of candidate directions
+    int64_t m_currentCount = 0;        //!< Candidate sample count
+    std::vector<double> m_dwell;       //!< Dwell seconds per region
+
+    varjo_Session* m_session = nullptr;  //!< Varjo session while polling
+    std::atomic_bool m_running{false};   //!< Poll thread run flag
+    std::thread m_pollThread;            //!< Poll thread
+
+    //! Statistics counters
+    struct {
+        std::atomic<uint64_t> samples{0};    //!< Samples recorded
+        std::atomic<uint64_t> valid{0};      //!< Valid samples
+        std::atomic<uint64_t> drains{0};     //!< Drain calls
+        std::atomic<uint64_t> fixations{0};  //!< Fixations detected
+    } m_stats;
+};
+
+}  // namespace VarjoExamples
@@ -1,6 +1,8 @@
 
 #include "Globals.hpp"
 
+#include <cstdarg>
+
 namespace
 {
 constexpr VarjoExamples::LogLevel c_defaultLogLevel = VarjoExamples::LogLevel::Info;
@@ -65,7 +67,7 @@ void writeLog(LogLevel level, const char* funcName, int lineNum, const char* pre
     // formatStr  += std::string(funcName) + "():" + std::to_string(lineNum) + ": ";
     formatStr += std::string(prefix) + format;
     va_start(args, format);
-    vsprintf_s(lineBuf, lineLimit, formatStr.data(), args);
+    vsnprintf(lineBuf, lineLimit, formatStr.data(), args);
     va_end(args);
 
     writeLog(level, std::string(lineBuf));
@@ -9,7 +9,9 @@
 #include <stdexcept>
 #include <functional>
 
+#if defined(_WIN32)
 #include <wrl.h>
+#endif
 
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/glm.hpp>
@@ -18,8 +20,10 @@
 
 #include <Varjo.h>
 
+#if defined(_WIN32)
 // Use MS COM smart pointers for DX objects
 using Microsoft::WRL::ComPtr;
+#endif
 
 namespace VarjoExamples
 {
@@ -53,33 +57,34 @@ extern void writeLog(LogLevel level, const char* funcName, int lineNum, const ch
 //! Macro for debug log
 #define LOG_DEBUG(FORMAT, ...)                                                                                         \
     {                                                                                                             \
-        VarjoExamples::writeLog(VarjoExamples::LogLevel::Debug, __FUNCTION__, __LINE__, "", FORMAT, __VA_ARGS__); \
+        VarjoExamples::writeLog(VarjoExamples::LogLevel::Debug, __FUNCTION__, __LINE__, "", FORMAT, ##__VA_ARGS__); \
     }
 
 //! Macro for info log
 #define LOG_INFO(FORMAT, ...)                                                                                        \
     {                                                                                                            \
-        VarjoExamples::writeLog(VarjoExamples::LogLevel::Info, __FUNCTION__, __LINE__, "", FORMAT, __VA_ARGS__); \
+        VarjoExamples::writeLog(VarjoExamples::LogLevel::Info, __FUNCTION__, __LINE__, "", FORMAT, ##__VA_ARGS__); \
     }
 
 //! Macro for warn log
 #define LOG_WARNING(FORMAT, ...)                                                                                                 \
     {                                                                                                                     \
-        VarjoExamples::writeLog(VarjoExamples::LogLevel::Warning, __FUNCTION__, __LINE__, "WARN: ", FORMAT, __VA_ARGS__); \
+        VarjoExamples::writeLog(VarjoExamples::LogLevel::Warning, __FUNCTION__, __LINE__, "WARN: ", FORMAT, ##__VA_ARGS__); \
     }
 
 //! Macro for error log
 #define LOG_ERROR(FORMAT, ...)                                                                                                \
     {                                                                                                                    \
-        VarjoExamples::writeLog(VarjoExamples::LogLevel::Error, __FUNCTION__, __LINE__, "ERROR: ", FORMAT, __VA_ARGS__); \
+        VarjoExamples::writeLog(VarjoExamples::LogLevel::Error, __FUNCTION__, __LINE__, "ERROR: ", FORMAT, ##__VA_ARGS__); \
     }
 
 //! Macro for critical error. This will throw a std::runtime_error exception.
 #define CRITICAL(FORMAT, ...)                                                                                                  \
     {                                                                                                                          \
-        VarjoExamples::writeLog(VarjoExamples::LogLevel::Critical, __FUNCTION__, __LINE__, "CRITICAL: ", FORMAT, __VA_ARGS__); \
+        VarjoExamples::writeLog(VarjoExamples::LogLevel::Critical, __FUNCTION__, __LINE__, "CRITICAL: ", FORMAT, ##__VA_ARGS__); \
     }
 
+#if defined(_WIN32)
 //! Check Windows error code
 inline void checkHResult(const char* func, int line, const char* what, HRESULT hr)
 {
@@ -91,6 +96,7 @@ inline void checkHResult(const char* func, int line, const char* what, HRESULT h
 
 //! Macro for checking microsoft HRESULT
 #define CHECK_HRESULT(VALUE) VarjoExamples::checkHResult(__FUNCTION__, __LINE__, #VALUE, VALUE)
+#endif
 
 //! Check Varjo error code
 inline varjo_Error checkVError(const char* func, int line, varjo_Session* session)
@@ -132,6 +138,7 @@ private:
 };
 
 #define __CONCAT_NX(A, B) A##B
+#undef __CONCAT
 #define __CONCAT(A, B) __CONCAT_NX(A, B)
 
 //! Get Varjo matrix from GLM matrix
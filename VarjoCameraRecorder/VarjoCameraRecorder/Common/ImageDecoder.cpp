@@ -0,0 +1,195 @@
+#include "ImageDecoder.hpp"
+
+#if defined(_WIN32)
+#include <wincodec.h>
+
+#pragma comment(lib, "windowscodecs.lib")
+#else
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#endif
+
+#if defined(_WIN32)
+namespace
+{
+using namespace VarjoExamples;
+
+// Initialize COM for calling thread once. WIC factory is free threaded.
+bool initCom()
+{
+    thread_local const HRESULT hr = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+    return SUCCEEDED(hr) || hr == RPC_E_CHANGED_MODE;
+}
+
+// Create WIC factory for calling thread
+ComPtr<IWICImagingFactory> getFactory()
+{
+    ComPtr<IWICImagingFactory> factory;
+    if (!initCom()) {
+        LOG_ERROR("COM initialization failed.");
+        return factory;
+    }
+
+    const HRESULT hr = CoCreateInstance(CLSID_WICImagingFactory, nullptr, CLSCTX_INPROC_SERVER, IID_PPV_ARGS(&factory));
+    if (FAILED(hr)) {
+        LOG_ERROR("Creating WIC factory failed: %x", hr);
+        factory.Reset();
+    }
+    return factory;
+}
+
+// Convert first frame of decoder to RGBA8
+bool convertFrame(IWICImagingFactory* factory, IWICBitmapDecoder* decoder, int& outWidth, int& outHeight, std::vector<uint8_t>& outPixels)
+{
+    ComPtr<IWICBitmapFrameDecode> source;
+    ComPtr<IWICFormatConverter> converter;
+    if (FAILED(decoder->GetFrame(0, &source)) || FAILED(factory->CreateFormatConverter(&converter))) {
+        return false;
+    }
+
+    if (FAILED(converter->Initialize(source.Get(), GUID_WICPixelFormat32bppRGBA, WICBitmapDitherTypeNone, nullptr, 0.0, WICBitmapPaletteTypeCustom))) {
+        return false;
+    }
+
+    UINT width = 0;
+    UINT height = 0;
+    if (FAILED(converter->GetSize(&width, &height))) {
+        return false;
+    }
+
+    const UINT stride = width * 4;
+    outPixels.resize(static_cast<size_t>(stride) * height);
+    if (FAILED(converter->CopyPixels(nullptr, stride, static_cast<UINT>(outPixels.size()), outPixels.data()))) {
+        return false;
+    }
+
+    outWidth = static_cast<int>(width);
+    outHeight = static_cast<int>(height);
+    return true;
+}
+
+}  // namespace
+
+namespace VarjoExamples
+{
+bool decodeImageFile(const std::string& filename, int& outWidth, int& outHeight, std::vector<uint8_t>& outPixels)
+{
+    ComPtr<IWICImagingFactory> factory = getFactory();
+    if (!factory) {
+        return false;
+    }
+
+    const std::wstring wideName(filename.begin(), filename.end());
+    ComPtr<IWICBitmapDecoder> decoder;
+    if (FAILED(factory->CreateDecoderFromFilename(wideName.c_str(), nullptr, GENERIC_READ, WICDecodeMetadataCacheOnDemand, &decoder))) {
+        LOG_ERROR("Opening image failed: %s", filename.c_str());
+        return false;
+    }
+
+    if (!convertFrame(factory.Get(), decoder.Get(), outWidth, outHeight, outPixels)) {
+        LOG_ERROR("Decoding image failed: %s", filename.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool decodeImageMemory(const uint8_t* data, size_t size, int& outWidth, int& outHeight, std::vector<uint8_t>& outPixels)
+{
+    ComPtr<IWICImagingFactory> factory = getFactory();
+    if (!factory) {
+        return false;
+    }
+
+    ComPtr<IWICStream> stream;
+    ComPtr<IWICBitmapDecoder> decoder;
+    if (FAILED(factory->CreateStream(&stream)) || FAILED(stream->InitializeFromMemory(const_cast<BYTE*>(data), static_cast<DWORD>(size))) ||
+        FAILED(factory->CreateDecoderFromStream(stream.Get(), nullptr, WICDecodeMetadataCacheOnDemand, &decoder))) {
+        LOG_ERROR("Opening image from memory failed: size=%zu", size);
+        return false;
+    }
+
+    if (!convertFrame(factory.Get(), decoder.Get(), outWidth, outHeight, outPixels)) {
+        LOG_ERROR("Decoding image from memory failed: size=%zu", size);
+        return false;
+    }
+    return true;
+}
+
+}  // namespace VarjoExamples
+#else
+
+namespace
+{
+// Read little endian value from byte buffer
+template <typename T>
+T readLE(const uint8_t* p)
+{
+    T value;
+    memcpy(&value, p, sizeof(T));
+    return value;
+}
+
+}  // namespace
+
+namespace VarjoExamples
+{
+// Without WIC only uncompressed 24-bit and 32-bit BMP images are supported, as written by the capture path
+bool decodeImageMemory(const uint8_t* data, size_t size, int& outWidth, int& outHeight, std::vector<uint8_t>& outPixels)
+{
+    constexpr size_t c_headerSize = 14 + 40;
+    if (!data || size < c_headerSize || data[0] != 'B' || data[1] != 'M') {
+        LOG_ERROR("Decoding image from memory failed, only BMP is supported without WIC: size=%zu", size);
+        return false;
+    }
+
+    const uint32_t pixelOffset = readLE<uint32_t>(data + 10);
+    const int32_t width = readLE<int32_t>(data + 18);
+    const int32_t height = readLE<int32_t>(data + 22);
+    const uint16_t bitCount = readLE<uint16_t>(data + 28);
+    const uint32_t compression = readLE<uint32_t>(data + 30);
+    const int rows = height < 0 ? -height : height;
+    const int components = bitCount / 8;
+    const size_t lineSize = (static_cast<size_t>(width) * components + 3) & ~size_t(3);
+    if (width <= 0 || rows == 0 || (bitCount != 24 && bitCount != 32) || (compression != 0 && compression != 3) ||
+        pixelOffset + lineSize * rows > size) {
+        LOG_ERROR("Decoding image from memory failed, unsupported BMP: size=%zu, bits=%d", size, bitCount);
+        return false;
+    }
+
+    // Rows are stored bottom-up unless height is negative
+    outPixels.resize(static_cast<size_t>(width) * rows * 4);
+    for (int y = 0; y < rows; y++) {
+        const uint8_t* src = data + pixelOffset + lineSize * (height > 0 ? rows - 1 - y : y);
+        uint8_t* dst = outPixels.data() + static_cast<size_t>(width) * 4 * y;
+        for (int x = 0; x < width; x++, src += components, dst += 4) {
+            dst[0] = src[2];
+            dst[1] = src[1];
+            dst[2] = src[0];
+            dst[3] = components == 4 ? src[3] : 255;
+        }
+    }
+
+    outWidth = width;
+    outHeight = rows;
+    return true;
+}
+
+bool decodeImageFile(const std::string& filename, int& outWidth, int& outHeight, std::vector<uint8_t>& outPixels)
+{
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.good()) {
+        LOG_ERROR("Opening image failed: %s", filename.c_str());
+        return false;
+    }
+
+    const std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (!decodeImageMemory(data.data(), data.size(), outWidth, outHeight, outPixels)) {
+        LOG_ERROR("Decoding image failed: %s", filename.c_str());
+        return false;
+    }
+    return true;
+}
+
+}  // namespace VarjoExamples
+#endif
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "Globals.hpp"
+
+namespace VarjoExamples
+{
+//! Decode PNG/JPEG/BMP image file to tightly packed RGBA8 using Windows Imaging Component. Safe to call from any thread.
+//! Off Windows only uncompressed BMP is supported.
+bool decodeImageFile(const std::string& filename, int& outWidth, int& outHeight, std::vector<uint8_t>& outPixels);
+
+//! Decode PNG/JPEG/BMP image from memory to tightly packed RGBA8. Safe to call from any thread.
+bool decodeImageMemory(const uint8_t* data, size_t size, int& outWidth, int& outHeight, std::vector<uint8_t>& outPixels);
+
+}  // namespace VarjoExamples
@@ -0,0 +1,409 @@
+#include "JobSystem.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+#if defined(_WIN32)
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#endif
+
+namespace
+{
+// Time a waiting thread sleeps before looking for jobs to help with again
+constexpr auto c_helpInterval = std::chrono::milliseconds(1);
+
+// Pool and bulk worker index of current thread
+struct WorkerSlot {
+    const void* system = nullptr;  //!< Pool of worker, null if not a worker
+    int index = -1;                //!< Bulk worker index, -1 for latency workers
+};
+thread_local WorkerSlot t_worker;
+
+// Pin current thread to given core
+void pinCurrentThread(int core)
+{
+    const int coreCount = std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+    const int target = (core % coreCount) % 64;
+#if defined(_WIN32)
+    if (SetThreadAffinityMask(GetCurrentThread(), 1ull << target) == 0) {
+        LOG_WARNING("Pinning worker to core %d failed", target);
+    }
+#elif defined(__linux__)
+    cpu_set_t cores;
+    CPU_ZERO(&cores);
+    CPU_SET(target, &cores);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(cores), &cores) != 0) {
+        LOG_WARNING("Pinning worker to core %d failed", target);
+    }
+#else
+    LOG_WARNING("Pinning worker to core %d not supported on this platform", target);
+#endif
+}
+
+}  // namespace
+
+namespace VarjoExamples
+{
+JobSystem::TaskGroup::TaskGroup(JobSystem& system)
+    : m_system(system)
+{
+}
+
+JobSystem::TaskGroup::~TaskGroup()
+{
+    try {
+        wait();
+    } catch (const std::exception& e) {
+        LOG_ERROR("Unhandled task group exception: %s", e.what());
+    } catch (...) {
+        LOG_ERROR("Unhandled task group exception");
+    }
+}
+
+void JobSystem::TaskGroup::run(Job job, Priority priority)
+{
+    if (priority == Priority::LowLatency) {
+        m_lowLatency = true;
+    }
+
+    m_pending++;
+    m_system.push(
+        [this, job = std::move(job)]() {
+            try {
+                job();
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (!m_exception) {
+                    m_exception = std::current_exception();
+                }
+            }
+
+            // Decrement under lock so the waiting thread can not destroy the group before we are done with it
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (--m_pending == 0) {
+                m_condition.notify_all();
+            }
+        },
+        priority);
+}
+
+void JobSystem::TaskGroup::wait()
+{
+    // Low-latency waiters only help on the latency lane, so the capture path never picks up a long bulk job
+    const int workerIndex = m_system.getCurrentWorker();
+    while (true) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_pending == 0) {
+                break;
+            }
+        }
+
+        if (m_system.runOne(workerIndex, m_lowLatency)) {
+            m_system.m_stats.helped++;
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_condition.wait_for(lock, c_helpInterval, [&] { return m_pending == 0; });
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_exception) {
+        std::exception_ptr exception = m_exception;
+        m_exception = nullptr;
+        std::rethrow_exception(exception);
+    }
+}
+
+JobSystem::JobSystem()
+    : JobSystem(Config())
+{
+}
+
+JobSystem::JobSystem(const Config& config)
+{
+    const int hardwareThreads = std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+    const int latencyWorkers = std::max(config.latencyWorkers, 0);
+    const int workerCount = config.workerCount > 0 ? config.workerCount : std::max(hardwareThreads - latencyWorkers, 1);
+
+    for (int i = 0; i < workerCount; i++) {
+        m_deques.emplace_back(std::make_unique<WorkerDeque>());
+    }
+
+    // Latency workers take the first cores so bulk workers can be limited to the rest
+    int core = config.pinWorkers ? config.firstCore : -1;
+    for (int i = 0; i < latencyWorkers; i++) {
+        m_workers.emplace_back(&JobSystem::latencyLoop, this, core);
+        core = config.pinWorkers ? core + 1 : -1;
+    }
+    for (int i = 0; i < workerCount; i++) {
+        m_workers.emplace_back(&JobSystem::workerLoop, this, i, core);
+        core = config.pinWorkers ? core + 1 : -1;
+    }
+
+    LOG_DEBUG("Job system started: workers=%d, latencyWorkers=%d, pinned=%d", workerCount, latencyWorkers, config.pinWorkers ? 1 : 0);
+}
+
+JobSystem::~JobSystem()
+{
+    m_stop = true;
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+    }
+    m_workCondition.notify_all();
+    m_latencyCondition.notify_all();
+
+    for (auto& worker : m_workers) {
+        worker.join();
+    }
+}
+
+void JobSystem::submit(Job job, Priority priority) { push(std::move(job), priority); }
+
+void JobSystem::parallelFor(
+    int64_t begin, int64_t end, int64_t grain, const std::function<void(int64_t begin, int64_t end)>& body, Priority priority)
+{
+    const int64_t count = end - begin;
+    if (count <= 0) {
+        return;
+    }
+
+    if (grain <= 0) {
+        const int64_t chunks = 4 * (static_cast<int64_t>(m_deques.size()) + 1);
+        grain = std::max<int64_t>((count + chunks - 1) / chunks, 1);
+    }
+
+    // Calling thread runs the first chunk itself
+    const int64_t firstEnd = std::min(begin + grain, end);
+    TaskGroup group(*this);
+    for (int64_t chunkBegin = firstEnd; chunkBegin < end; chunkBegin += grain) {
+        const int64_t chunkEnd = std::min(chunkBegin + grain, end);
+        group.run([&body, chunkBegin, chunkEnd]() { body(chunkBegin, chunkEnd); }, priority);
+    }
+
+    std::exception_ptr exception;
+    try {
+        body(begin, firstEnd);
+    } catch (...) {
+        exception = std::current_exception();
+    }
+
+    group.wait();
+    if (exception) {
+        std::rethrow_exception(exception);
+    }
+}
+
+void JobSystem::parallelForTiles(
+    int width, int height, int tileSize, const std::function<void(int x0, int y0, int x1, int y1)>& body, Priority priority)
+{
+    if (width <= 0 || height <= 0 || tileSize <= 0) {
+        return;
+    }
+
+    const int tilesX = (width + tileSize - 1) / tileSize;
+    const int tilesY = (height + tileSize - 1) / tileSize;
+    parallelFor(
+        0, static_cast<int64_t>(tilesX) * tilesY, 0,
+        [&](int64_t begin, int64_t end) {
+            for (int64_t tile = begin; tile < end; tile++) {
+                const int x0 = static_cast<int>(tile % tilesX) * tileSize;
+                const int y0 = static_cast<int>(tile / tilesX) * tileSize;
+                body(x0, y0, std::min(x0 + tileSize, width), std::min(y0 + tileSize, height));
+            }
+        },
+        priority);
+}
+
+JobSystem::Stats JobSystem::getStats() const
+{
+    Stats stats;
+    stats.submitted = m_stats.submitted;
+    stats.executed = m_stats.executed;
+    stats.stolen = m_stats.stolen;
+    stats.latencyJobs = m_stats.latencyJobs;
+    stats.helped = m_stats.helped;
+    return stats;
+}
+
+JobSystem& JobSystem::getShared()
+{
+    // Never destroyed: joining workers from static destructors can deadlock when the DLL is unloaded
+    static JobSystem* shared = new JobSystem();
+    return *shared;
+}
+
+void JobSystem::push(Job job, Priority priority)
+{
+    m_stats.submitted++;
+
+    if (priority == Priority::LowLatency) {
+        {
+            std::lock_guard<std::mutex> lock(m_latencyMutex);
+            m_latencyJobs.emplace_back(std::move(job));
+            m_latencyQueued++;
+            m_queued++;
+        }
+
+        // Take sleep lock so a worker checking the counters can not miss the signal
+        {
+            std::lock_guard<std::mutex> lock(m_sleepMutex);
+        }
+        m_latencyCondition.notify_one();
+        m_workCondition.notify_one();
+        return;
+    }
+
+    // Workers push to their own deque, other threads to the shared queue
+    const int current = getCurrentWorker();
+    if (current >= 0) {
+        WorkerDeque& deque = *m_deques[current];
+        std::lock_guard<std::mutex> lock(deque.mutex);
+        deque.jobs.emplace_back(std::move(job));
+        m_queued++;
+    } else {
+        std::lock_guard<std::mutex> lock(m_injectMutex);
+        m_injectedJobs.emplace_back(std::move(job));
+        m_queued++;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+    }
+    m_workCondition.notify_one();
+}
+
+bool JobSystem::pop(int workerIndex, bool latencyOnly, Job& outJob)
+{
+    if (m_latencyQueued > 0) {
+        std::lock_guard<std::mutex> lock(m_latencyMutex);
+        if (!m_latencyJobs.empty()) {
+            outJob = std::move(m_latencyJobs.front());
+            m_latencyJobs.pop_front();
+            m_latencyQueued--;
+            m_queued--;
+            m_stats.latencyJobs++;
+            return true;
+        }
+    }
+
+    if (latencyOnly || m_queued == 0) {
+        return false;
+    }
+
+    // Outside jobs in submit order
+    {
+        std::lock_guard<std::mutex> lock(m_injectMutex);
+        if (!m_injectedJobs.empty()) {
+            outJob = std::move(m_injectedJobs.front());
+            m_injectedJobs.pop_front();
+            m_queued--;
+            return true;
+        }
+    }
+
+    // Own deque newest first
+    if (workerIndex >= 0) {
+        WorkerDeque& deque = *m_deques[workerIndex];
+        std::lock_guard<std::mutex> lock(deque.mutex);
+        if (!deque.jobs.empty()) {
+            outJob = std::move(deque.jobs.back());
+            deque.jobs.pop_back();
+            m_queued--;
+            return true;
+        }
+    }
+
+    // Steal oldest job from other deques, starting after own
+    const size_t dequeCount = m_deques.size();
+    const size_t start = workerIndex >= 0 ? static_cast<size_t>(workerIndex) + 1 : 0;
+    for (size_t i = 0; i < dequeCount; i++) {
+        const size_t index = (start + i) % dequeCount;
+        if (static_cast<int>(index) == workerIndex) {
+            continue;
+        }
+
+        WorkerDeque& deque = *m_deques[index];
+        std::lock_guard<std::mutex> lock(deque.mutex);
+        if (!deque.jobs.empty()) {
+            outJob = std::move(deque.jobs.front());
+            deque.jobs.pop_front();
+            m_queued--;
+            m_stats.stolen++;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool JobSystem::runOne(int workerIndex, bool latencyOnly)
+{
+    Job job;
+    if (!pop(workerIndex, latencyOnly, job)) {
+        return false;
+    }
+
+    execute(job);
+    return true;
+}
+
+void JobSystem::execute(Job& job)
+{
+    try {
+        job();
+    } catch (const std::exception& e) {
+        LOG_ERROR("Job failed: %s", e.what());
+    } catch (...) {
+        LOG_ERROR("Job failed with unknown exception");
+    }
+    m_stats.executed++;
+}
+
+void JobSystem::workerLoop(int workerIndex, int core)
+{
+    t_worker.system = this;
+    t_worker.index = workerIndex;
+    if (core >= 0) {
+        pinCurrentThread(core);
+    }
+
+    while (true) {
+        if (runOne(workerIndex, false)) {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_sleepMutex);
+        m_workCondition.wait(lock, [&] { return m_stop || m_queued > 0; });
+        if (m_stop && m_queued == 0) {
+            break;
+        }
+    }
+}
+
+void JobSystem::latencyLoop(int core)
+{
+    t_worker.system = this;
+    t_worker.index = -1;
+    if (core >= 0) {
+        pinCurrentThread(core);
+    }
+
+    while (true) {
+        if (runOne(-1, true)) {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_sleepMutex);
+        m_latencyCondition.wait(lock, [&] { return m_stop || m_latencyQueued > 0; });
+        if (m_stop && m_latencyQueued == 0) {
+            break;
+        }
+    }
+}
+
+int JobSystem::getCurrentWorker() const { return t_worker.system == this ? t_worker.index : -1; }
+
+}  // namespace VarjoExamples
@@ -0,0 +1,175 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Globals.hpp"
+
+namespace VarjoExamples
+{
+//! Work-stealing thread pool shared by the native pipeline components.
+//!
+//! Each bulk worker owns a deque: jobs submitted from a worker go to the back of its own deque and are run newest
+//! first, idle workers steal the oldest job from the front of other deques. Jobs submitted from other threads go to
+//! a shared queue that workers take from in order before their own deque, so outside work is never starved by jobs
+//! that keep spawning more. Low-latency jobs, e.g. frame conversion on the capture path, go to a separate lane that
+//! every worker checks first. Dedicated latency workers serve only that lane, so a latency job starts even while
+//! all bulk workers are busy with long encode jobs.
+//!
+//! Threads waiting on a TaskGroup run queued jobs while they wait, so nested parallelism does not deadlock.
+class JobSystem
+{
+public:
+    //! Job function
+    using Job = std::function<void()>;
+
+    //! Job lane
+    enum class Priority {
+        Bulk,        //!< Throughput work, e.g. encoding and file writes
+        LowLatency,  //!< Capture path work that must not queue behind bulk jobs
+    };
+
+    //! Pool configuration
+    struct Config {
+        int workerCount = 0;      //!< Bulk workers, hardware threads minus latency workers if zero or negative
+        int latencyWorkers = 1;   //!< Workers serving only the low-latency lane
+        bool pinWorkers = false;  //!< Pin each worker to one core
+        int firstCore = 0;        //!< First core for pinned workers, latency workers are pinned first
+    };
+
+    //! Pool statistics
+    struct Stats {
+        uint64_t submitted = 0;    //!< Jobs submitted
+        uint64_t executed = 0;     //!< Jobs executed
+        uint64_t stolen = 0;       //!< Jobs stolen from another worker's deque
+        uint64_t latencyJobs = 0;  //!< Jobs executed from the low-latency lane
+        uint64_t helped = 0;       //!< Jobs executed by threads waiting on a task group
+    };
+
+    //! Set of jobs that can be waited for together
+    class TaskGroup
+    {
+    public:
+        //! Construct group submitting to given pool
+        TaskGroup(JobSystem& system);
+
+        //! Destruct group. Waits for outstanding jobs.
+        ~TaskGroup();
+
+        // Disable copy, move and assign
+        TaskGroup(const TaskGroup& other) = delete;
+        TaskGroup(const TaskGroup&& other) = delete;
+        TaskGroup& operator=(const TaskGroup& other) = delete;
+        TaskGroup& operator=(const TaskGroup&& other) = delete;
+
+        //! Submit job to group
+        void run(Job job, Priority priority = Priority::Bulk);
+
+        //! Wait until all jobs of group are done, running queued jobs meanwhile. Rethrows first exception of a job.
+        void wait();
+
+    private:
+        JobSystem& m_system;                  //!< Pool running the jobs
+        std::atomic<int64_t> m_pending{0};    //!< Jobs not yet finished
+        std::mutex m_mutex;                   //!< Lock for completion signal and exception
+        std::condition_variable m_condition;  //!< Signaled when last job finishes
+        std::exception_ptr m_exception;       //!< First exception thrown by a job
+        bool m_lowLatency = false;            //!< Group has low-latency jobs
+    };
+
+    //! Construct pool and start workers
+    JobSystem(const Config& config);
+
+    //! Construct pool with default config
+    JobSystem();
+
+    //! Destruct pool. Runs jobs already queued, then joins workers.
+    ~JobSystem();
+
+    // Disable copy, move and assign
+    JobSystem(const JobSystem& other) = delete;
+    JobSystem(const JobSystem&& other) = delete;
+    JobSystem& operator=(const JobSystem& other) = delete;
+    JobSystem& operator=(const JobSystem&& other) = delete;
+
+    //! Submit detached job. Exceptions are logged and dropped.
+    void submit(Job job, Priority priority = Priority::Bulk);
+
+    //! Run body over [begin, end) split into chunks of at most grain indices. Zero grain picks about four chunks per
+    //! worker. Calling thread takes part and returns when all chunks are done. Rethrows first exception of body.
+    void parallelFor(int64_t begin, int64_t end, int64_t grain, const std::function<void(int64_t begin, int64_t end)>& body,
+        Priority priority = Priority::Bulk);
+
+    //! Run body over tiles of a width x height image, as parallelFor over tile indices
+    void parallelForTiles(int width, int height, int tileSize, const std::function<void(int x0, int y0, int x1, int y1)>& body,
+        Priority priority = Priority::Bulk);
+
+    //! Return number of bulk workers
+    int getWorkerCount() const { return static_cast<int>(m_deques.size()); }
+
+    //! Return pool statistics
+    Stats getStats() const;
+
+    //! Return pool shared by pipeline components, created with default config on first use
+    static JobSystem& getShared();
+
+private:
+    //! Job deque of one bulk worker
+    struct WorkerDeque {
+        std::mutex mutex;      //!< Lock for jobs
+        std::deque<Job> jobs;  //!< Own jobs at back, stolen from front
+    };
+
+    //! Queue job to lane or deque and wake a worker
+    void push(Job job, Priority priority);
+
+    //! Take next job for worker, negative index for threads outside the pool. Returns false if none queued.
+    bool pop(int workerIndex, bool latencyOnly, Job& outJob);
+
+    //! Run one queued job if any. Returns false if none queued.
+    bool runOne(int workerIndex, bool latencyOnly);
+
+    //! Run job and count it
+    void execute(Job& job);
+
+    //! Bulk worker main loop
+    void workerLoop(int workerIndex, int core);
+
+    //! Latency worker main loop
+    void latencyLoop(int core);
+
+    //! Return this thread's worker index in this pool, -1 if not a bulk worker
+    int getCurrentWorker() const;
+
+private:
+    std::vector<std::unique_ptr<WorkerDeque>> m_deques;  //!< Bulk worker deques
+    std::mutex m_latencyMutex;                           //!< Lock for latency lane
+    std::deque<Job> m_latencyJobs;                       //!< Low-latency lane
+    std::atomic<int64_t> m_queued{0};                    //!< Jobs queued in all queues
+    std::atomic<int64_t> m_latencyQueued{0};             //!< Jobs queued in latency lane
+    std::mutex m_injectMutex;                            //!< Lock for shared queue
+    std::deque<Job> m_injectedJobs;                      //!< Bulk jobs submitted from outside the pool
+    std::mutex m_sleepMutex;                             //!< Lock for sleeping workers
+    std::condition_variable m_workCondition;             //!< Signaled when a job is queued
+    std::condition_variable m_latencyCondition;          //!< Signaled when a latency job is queued
+    std::atomic_bool m_stop{false};                      //!< Stop flag for workers
+    std::vector<std::thread> m_workers;                  //!< Bulk and latency worker threads
+
+    //! Statistics counters
+    struct {
+        std::atomic<uint64_t> submitted{0};    //!< Jobs submitted
+        std::atomic<uint64_t> executed{0};     //!< Jobs executed
+        std::atomic<uint64_t> stolen{0};       //!< Jobs stolen
+        std::atomic<uint64_t> latencyJobs{0};  //!< Jobs from latency lane
+        std::atomic<uint64_t> helped{0};       //!< Jobs run by waiting threads
+    } m_stats;
+};
+
+}  // namespace VarjoExamples
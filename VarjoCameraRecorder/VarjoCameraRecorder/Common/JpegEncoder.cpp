@@ -0,0 +1,173 @@
+#include "JpegEncoder.hpp"
+
+#include <algorithm>
+
+#if defined(_WIN32)
+#include <wincodec.h>
+
+#pragma comment(lib, "windowscodecs.lib")
+#elif defined(REPLAY_HAVE_LIBJPEG)
+#include <csetjmp>
+#include <cstdio>
+#include <cstdlib>
+
+#include <jpeglib.h>
+#endif
+
+namespace
+{
+#if defined(_WIN32)
+// Copy BGRA8 row to packed BGR
+void packBgr(const uint8_t* bgra, int width, uint8_t* bgr)
+{
+    for (int x = 0; x < width; x++, bgra += 4, bgr += 3) {
+        bgr[0] = bgra[0];
+        bgr[1] = bgra[1];
+        bgr[2] = bgra[2];
+    }
+}
+#elif defined(REPLAY_HAVE_LIBJPEG)
+// libjpeg error manager returning to encodeJpeg instead of exiting the process
+struct ErrorManager {
+    jpeg_error_mgr base;  //!< libjpeg error manager, must be first
+    jmp_buf jump;         //!< Return point in encodeJpeg
+};
+
+void onJpegError(j_common_ptr info)
+{
+    char message[JMSG_LENGTH_MAX];
+    info->err->format_message(info, message);
+    LOG_ERROR("Encoding JPEG failed: %s", message);
+    longjmp(reinterpret_cast<ErrorManager*>(info->err)->jump, 1);
+}
+#endif
+
+}  // namespace
+
+namespace VarjoExamples
+{
+#if defined(_WIN32)
+bool encodeJpeg(const uint8_t* bgra, int width, int height, int rowStride, int quality, std::vector<uint8_t>& out)
+{
+    thread_local const HRESULT comResult = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+    if (FAILED(comResult) && comResult != RPC_E_CHANGED_MODE) {
+        LOG_ERROR("COM initialization failed.");
+        return false;
+    }
+
+    ComPtr<IWICImagingFactory> factory;
+    ComPtr<IStream> stream;
+    ComPtr<IWICBitmapEncoder> encoder;
+    ComPtr<IWICBitmapFrameEncode> frame;
+    ComPtr<IPropertyBag2> properties;
+    if (FAILED(CoCreateInstance(CLSID_WICImagingFactory, nullptr, CLSCTX_INPROC_SERVER, IID_PPV_ARGS(&factory))) ||
+        FAILED(CreateStreamOnHGlobal(nullptr, TRUE, &stream)) || FAILED(factory->CreateEncoder(GUID_ContainerFormatJpeg, nullptr, &encoder)) ||
+        FAILED(encoder->Initialize(stream.Get(), WICBitmapEncoderNoCache)) || FAILED(encoder->CreateNewFrame(&frame, &properties))) {
+        LOG_ERROR("Creating JPEG encoder failed.");
+        return false;
+    }
+
+    // WIC takes quality as 0-1 frame property and 24-bit BGR input
+    PROPBAG2 option = {};
+    option.pstrName = const_cast<LPOLESTR>(L"ImageQuality");
+    VARIANT value;
+    VariantInit(&value);
+    value.vt = VT_R4;
+    value.fltVal = static_cast<float>(std::clamp(quality, 1, 100)) / 100.0f;
+
+    std::vector<uint8_t> bgr(static_cast<size_t>(width) * height * 3);
+    for (int y = 0; y < height; y++) {
+        packBgr(bgra + static_cast<size_t>(y) * rowStride, width, bgr.data() + static_cast<size_t>(y) * width * 3);
+    }
+
+    WICPixelFormatGUID format = GUID_WICPixelFormat24bppBGR;
+    if (FAILED(properties->Write(1, &option, &value)) || FAILED(frame->Initialize(properties.Get())) ||
+        FAILED(frame->SetSize(static_cast<UINT>(width), static_cast<UINT>(height))) || FAILED(frame->SetPixelFormat(&format)) ||
+        format != GUID_WICPixelFormat24bppBGR ||
+        FAILED(frame->WritePixels(static_cast<UINT>(height), static_cast<UINT>(width * 3), static_cast<UINT>(bgr.size()), bgr.data())) ||
+        FAILED(frame->Commit()) || FAILED(encoder->Commit())) {
+        LOG_ERROR("Encoding JPEG failed: size=(%d, %d)", width, height);
+        return false;
+    }
+
+    STATSTG info = {};
+    HGLOBAL memory = nullptr;
+    if (FAILED(stream->Stat(&info, STATFLAG_NONAME)) || FAILED(GetHGlobalFromStream(stream.Get(), &memory))) {
+        LOG_ERROR("Reading encoded JPEG failed.");
+        return false;
+    }
+    const auto* data = static_cast<const uint8_t*>(GlobalLock(memory));
+    if (!data) {
+        LOG_ERROR("Reading encoded JPEG failed.");
+        return false;
+    }
+    out.assign(data, data + static_cast<size_t>(info.cbSize.QuadPart));
+    GlobalUnlock(memory);
+    return true;
+}
+#elif defined(REPLAY_HAVE_LIBJPEG)
+bool encodeJpeg(const uint8_t* bgra, int width, int height, int rowStride, int quality, std::vector<uint8_t>& out)
+{
+    // Everything touched after setjmp lives outside it, a failing libjpeg call jumps back here
+    jpeg_compress_struct info;
+    ErrorManager errors;
+    unsigned char* buffer = nullptr;
+    unsigned long size = 0;
+#if !defined(JCS_EXTENSIONS)
+    std::vector<uint8_t> row(static_cast<size_t>(width) * 3);
+#endif
+
+    info.err = jpeg_std_error(&errors.base);
+    errors.base.error_exit = onJpegError;
+    if (setjmp(errors.jump)) {
+        jpeg_destroy_compress(&info);
+        free(buffer);
+        return false;
+    }
+
+    jpeg_create_compress(&info);
+    jpeg_mem_dest(&info, &buffer, &size);
+    info.image_width = static_cast<JDIMENSION>(width);
+    info.image_height = static_cast<JDIMENSION>(height);
+#if defined(JCS_EXTENSIONS)
+    info.input_components = 4;
+    info.in_color_space = JCS_EXT_BGRA;
+#else
+    info.input_components = 3;
+    info.in_color_space = JCS_RGB;
+#endif
+    jpeg_set_defaults(&info);
+    jpeg_set_quality(&info, std::clamp(quality, 1, 100), TRUE);
+    jpeg_start_compress(&info, TRUE);
+
+    while (info.next_scanline < info.image_height) {
+        const uint8_t* src = bgra + static_cast<size_t>(info.next_scanline) * rowStride;
+#if defined(JCS_EXTENSIONS)
+        JSAMPROW line = const_cast<JSAMPROW>(src);
+#else
+        // Plain libjpeg takes RGB only
+        for (int x = 0; x < width; x++) {
+            row[x * 3] = src[x * 4 + 2];
+            row[x * 3 + 1] = src[x * 4 + 1];
+            row[x * 3 + 2] = src[x * 4];
+        }
+        JSAMPROW line = row.data();
+#endif
+        jpeg_write_scanlines(&info, &line, 1);
+    }
+
+    jpeg_finish_compress(&info);
+    jpeg_destroy_compress(&info);
+    out.assign(buffer, buffer + size);
+    free(buffer);
+    return true;
+}
+#else
+bool encodeJpeg(const uint8_t* /*bgra*/, int width, int height, int /*rowStride*/, int /*quality*/, std::vector<uint8_t>& /*out*/)
+{
+    LOG_ERROR("Encoding JPEG failed, built without libjpeg: size=(%d, %d)", width, height);
+    return false;
+}
+#endif
+
+}  // namespace VarjoExamples
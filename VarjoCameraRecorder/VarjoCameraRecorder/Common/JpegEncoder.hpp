@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Globals.hpp"
+
+namespace VarjoExamples
+{
+//! Encode BGRA8 pixels as baseline JPEG with quality 1-100, alpha is dropped. Uses Windows Imaging Component on
+//! Windows and libjpeg elsewhere when the build found it. Returns false if encoding fails or no encoder is available.
+bool encodeJpeg(const uint8_t* bgra, int width, int height, int rowStride, int quality, std::vector<uint8_t>& out);
+
+}  // namespace VarjoExamples
@@ -0,0 +1,267 @@
+#include "KeyframeDatabase.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+#include <glm/gtc/constants.hpp>
+
+namespace
+{
+// Angle added to query radius to cover rounding of stored float directions
+constexpr double c_radiusMargin = 1e-5;
+
+// Return view direction of pose, -Z forward
+glm::dvec3 getViewDirection(const varjo_Matrix& pose) { return -glm::dvec3(pose.value[8], pose.value[9], pose.value[10]); }
+
+// Return position of pose
+glm::dvec3 getPosition(const varjo_Matrix& pose) { return glm::dvec3(pose.value[12], pose.value[13], pose.value[14]); }
+
+// Return azimuth of direction in [-pi, pi], zero forward
+double getAzimuth(const glm::dvec3& direction) { return std::atan2(direction.x, -direction.z); }
+
+}  // namespace
+
+namespace VarjoExamples
+{
+KeyframeDatabase::KeyframeDatabase()
+    : KeyframeDatabase(Config())
+{
+}
+
+KeyframeDatabase::KeyframeDatabase(const Config& config, FrameStore* frameStore)
+    : m_config(config)
+    , m_frameStore(frameStore)
+{
+    const size_t cellCount = static_cast<size_t>(std::max(config.directionBands, 1)) * std::max(config.directionSectors, 1);
+    m_cells.resize(cellCount);
+    m_visited.resize(cellCount, 0);
+}
+
+KeyframeDatabase::Id KeyframeDatabase::add(int64_t time, const varjo_Matrix& hmdPose, FrameStore::Handle frame)
+{
+    const glm::dvec3 direction = getViewDirection(hmdPose);
+    const double length = glm::length(direction);
+    if (!(length > 1e-6)) {
+        LOG_ERROR("Invalid keyframe pose");
+        return 0;
+    }
+
+    std::vector<FrameStore::Handle> evicted;
+    Id id = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_records.empty() && time < m_records.back().keyframe.time) {
+            LOG_WARNING("Keyframe older than latest ignored: time=%lld, latest=%lld", time, m_records.back().keyframe.time);
+            return 0;
+        }
+
+        id = m_firstId + m_records.size();
+        Record record;
+        record.keyframe.id = id;
+        record.keyframe.time = time;
+        record.keyframe.hmdPose = hmdPose;
+        record.keyframe.frame = frame;
+        record.cell = getCell(direction / length);
+        m_records.push_back(record);
+
+        Entry entry;
+        entry.time = time;
+        entry.direction = glm::vec3(direction / length);
+        entry.position = glm::vec3(getPosition(hmdPose));
+        entry.id = id;
+        m_cells[record.cell].push_back(entry);
+        m_stats.added++;
+
+        // Evict incrementally so a config change or a long pause does not stall a single insert
+        for (size_t i = 0; i < m_config.evictionBatch && m_records.size() > 1; i++) {
+            const bool overCapacity = m_records.size() > m_config.maxKeyframes;
+            const bool tooOld = m_config.maxAge > 0 && m_records.front().keyframe.time < time - m_config.maxAge;
+            if (!overCapacity && !tooOld) {
+                break;
+            }
+            evictOldest(evicted);
+        }
+    }
+
+    releaseFrames(evicted);
+    return id;
+}
+
+bool KeyframeDatabase::findNearest(const varjo_Matrix& hmdPose, int64_t t0, int64_t t1, double maxAngle, Match& outMatch) const
+{
+    glm::dvec3 direction = getViewDirection(hmdPose);
+    const double length = glm::length(direction);
+    if (!(length > 1e-6) || t0 > t1) {
+        return false;
+    }
+    direction /= length;
+    const glm::dvec3 position = getPosition(hmdPose);
+    maxAngle = std::min(std::max(maxAngle, 0.0), glm::pi<double>());
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stats.queries++;
+
+    // Stamp cells per query instead of clearing a visited set
+    if (++m_queryStamp == 0) {
+        std::fill(m_visited.begin(), m_visited.end(), 0);
+        m_queryStamp = 1;
+    }
+
+    // Grow radius from one cell until no unscanned cell can beat the best match: every keyframe outside the radius
+    // has a larger angle, and so a larger cost, than the radius
+    const double cellAngle = std::sqrt(4.0 * glm::pi<double>() / m_cells.size());
+    double bestCost = std::numeric_limits<double>::infinity();
+    const Entry* best = nullptr;
+    std::vector<int> cells;
+    for (double radius = std::min(cellAngle, maxAngle);; radius = std::min(radius * 2.0, maxAngle)) {
+        getCells(direction, radius, cells);
+        for (int cell : cells) {
+            if (m_visited[cell] == m_queryStamp) {
+                continue;
+            }
+            m_visited[cell] = m_queryStamp;
+
+            const std::deque<Entry>& entries = m_cells[cell];
+            auto it = std::lower_bound(entries.begin(), entries.end(), t0, [](const Entry& e, int64_t time) { return e.time < time; });
+            for (; it != entries.end() && it->time <= t1; ++it) {
+                m_stats.scanned++;
+                const double angle = std::acos(std::min(std::max(glm::dot(direction, glm::dvec3(it->direction)), -1.0), 1.0));
+                if (angle > maxAngle) {
+                    continue;
+                }
+                const double cost = angle + m_config.positionWeight * glm::length(position - glm::dvec3(it->position));
+                if (cost < bestCost) {
+                    bestCost = cost;
+                    best = &*it;
+                }
+            }
+        }
+
+        if ((best && bestCost <= radius) || radius >= maxAngle) {
+            break;
+        }
+    }
+
+    if (!best) {
+        return false;
+    }
+
+    const Record& record = m_records[best->id - m_firstId];
+    outMatch.keyframe = record.keyframe;
+    outMatch.angle = std::acos(std::min(std::max(glm::dot(direction, glm::dvec3(best->direction)), -1.0), 1.0));
+    outMatch.distance = glm::length(position - glm::dvec3(best->position));
+    outMatch.cost = bestCost;
+    return true;
+}
+
+bool KeyframeDatabase::get(Id id, Keyframe& outKeyframe) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (id < m_firstId || id - m_firstId >= m_records.size()) {
+        return false;
+    }
+    outKeyframe = m_records[id - m_firstId].keyframe;
+    return true;
+}
+
+size_t KeyframeDatabase::evictBefore(int64_t time, size_t maxCount)
+{
+    std::vector<FrameStore::Handle> evicted;
+    size_t count = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        while (count < maxCount && !m_records.empty() && m_records.front().keyframe.time < time) {
+            evictOldest(evicted);
+            count++;
+        }
+    }
+
+    releaseFrames(evicted);
+    return count;
+}
+
+KeyframeDatabase::Stats KeyframeDatabase::getStats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Stats stats = m_stats;
+    stats.keyframes = m_records.size();
+    return stats;
+}
+
+int KeyframeDatabase::getCell(const glm::dvec3& direction) const
+{
+    // Equal band heights along up axis give equal areas
+    const int bands = std::max(m_config.directionBands, 1);
+    const int sectors = std::max(m_config.directionSectors, 1);
+    const int band = std::min(std::max(static_cast<int>((direction.y + 1.0) * 0.5 * bands), 0), bands - 1);
+    const double azimuth = getAzimuth(direction);
+    const int sector = std::min(std::max(static_cast<int>((azimuth + glm::pi<double>()) / glm::two_pi<double>() * sectors), 0), sectors - 1);
+    return band * sectors + sector;
+}
+
+void KeyframeDatabase::getCells(const glm::dvec3& direction, double radius, std::vector<int>& outCells) const
+{
+    const int bands = std::max(m_config.directionBands, 1);
+    const int sectors = std::max(m_config.directionSectors, 1);
+    radius += c_radiusMargin;
+
+    // Band range from polar angle range of the cap
+    const double polar = std::acos(std::min(std::max(direction.y, -1.0), 1.0));
+    const double polarMin = polar - radius;
+    const double polarMax = polar + radius;
+    const double upMax = (polarMin <= 0.0) ? 1.0 : std::cos(polarMin);
+    const double upMin = (polarMax >= glm::pi<double>()) ? -1.0 : std::cos(polarMax);
+    const int band0 = std::min(std::max(static_cast<int>((upMin + 1.0) * 0.5 * bands), 0), bands - 1);
+    const int band1 = std::min(std::max(static_cast<int>((upMax + 1.0) * 0.5 * bands), 0), bands - 1);
+
+    // Sector range from azimuth extent of the cap, all sectors if the cap covers a pole
+    int sector0 = 0;
+    int sector1 = sectors - 1;
+    if (polarMin > 0.0 && polarMax < glm::pi<double>()) {
+        const double extent = std::asin(std::min(std::sin(radius) / std::sin(polar), 1.0));
+        const double azimuth = getAzimuth(direction) + glm::pi<double>();
+        const int first = static_cast<int>(std::floor((azimuth - extent) / glm::two_pi<double>() * sectors));
+        const int last = static_cast<int>(std::floor((azimuth + extent) / glm::two_pi<double>() * sectors));
+        if (last - first + 1 < sectors) {
+            sector0 = first;
+            sector1 = last;
+        }
+    }
+
+    outCells.clear();
+    for (int band = band0; band <= band1; band++) {
+        for (int sector = sector0; sector <= sector1; sector++) {
+            outCells.push_back(band * sectors + ((sector % sectors) + sectors) % sectors);
+        }
+    }
+}
+
+void KeyframeDatabase::evictOldest(std::vector<FrameStore::Handle>& frames)
+{
+    // Cells keep insertion order, so the oldest keyframe is first in its cell
+    const Record& record = m_records.front();
+    std::deque<Entry>& entries = m_cells[record.cell];
+    assert(!entries.empty() && entries.front().id == record.keyframe.id);
+    entries.pop_front();
+
+    if (record.keyframe.frame != 0) {
+        frames.push_back(record.keyframe.frame);
+    }
+    m_records.pop_front();
+    m_firstId++;
+    m_stats.evicted++;
+}
+
+void KeyframeDatabase::releaseFrames(const std::vector<FrameStore::Handle>& frames)
+{
+    if (!m_frameStore) {
+        return;
+    }
+    for (FrameStore::Handle frame : frames) {
+        m_frameStore->release(frame);
+    }
+}
+
+}  // namespace VarjoExamples
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <vector>
+
+#include "Globals.hpp"
+#include "FrameStore.hpp"
+
+namespace VarjoExamples
+{
+//! Keyframe database of captured frames indexed by HMD viewpoint.
+//!
+//! Keyframes are bucketed by view direction into an equal-area sphere grid: bands of equal height along the world up
+//! axis split into equal azimuth sectors, so horizontal views fall on compact cells near the equator. A nearest
+//! viewpoint query scans the cells within a growing angular radius and stops once the best match is closer than any
+//! unscanned cell can be, so its cost depends on the keyframes near the view rather than on the database size.
+//! Keyframes are kept in capture time order both globally and per cell, which makes time window filtering a binary
+//! search and lets the oldest keyframes be evicted in constant time each, a few per insert.
+//!
+//! Frame pixels live in a FrameStore, keyframes only keep the frame handle. If a store is given, frames of evicted
+//! keyframes are released from it.
+class KeyframeDatabase
+{
+public:
+    //! Keyframe id, zero is invalid
+    using Id = uint64_t;
+
+    //! Database configuration
+    struct Config {
+        int directionBands = 32;      //!< Equal-area bands from straight down to straight up
+        int directionSectors = 64;    //!< Azimuth sectors per band
+        double positionWeight = 0.5;  //!< Match cost in radians of view angle per meter of position offset
+        size_t maxKeyframes = 65536;  //!< Keyframes kept before the oldest are evicted
+        int64_t maxAge = 0;           //!< Age in nanoseconds after which keyframes are evicted, 0 for no limit
+        size_t evictionBatch = 8;     //!< Most keyframes evicted per insert
+    };
+
+    //! Stored keyframe
+    struct Keyframe {
+        Id id = 0;                     //!< Keyframe id
+        int64_t time = 0;              //!< Capture time in Varjo time
+        varjo_Matrix hmdPose{};        //!< HMD pose in world space
+        FrameStore::Handle frame = 0;  //!< Frame handle
+    };
+
+    //! Query result
+    struct Match {
+        Keyframe keyframe;      //!< Matched keyframe
+        double angle = 0.0;     //!< View direction angle in radians
+        double distance = 0.0;  //!< Position offset in meters
+        double cost = 0.0;      //!< Angle plus weighted distance
+    };
+
+    //! Database statistics
+    struct Stats {
+        size_t keyframes = 0;  //!< Keyframes in database
+        uint64_t added = 0;    //!< Keyframes added
+        uint64_t evicted = 0;  //!< Keyframes evicted
+        uint64_t queries = 0;  //!< Nearest viewpoint queries
+        uint64_t scanned = 0;  //!< Keyframes compared by queries
+    };
+
+    //! Construct database. Frames of evicted keyframes are released from frame store if given.
+    KeyframeDatabase(const Config& config, FrameStore* frameStore = nullptr);
+
+    //! Construct database with default config
+    KeyframeDatabase();
+
+    // Disable copy, move and assign
+    KeyframeDatabase(const KeyframeDatabase& other) = delete;
+    KeyframeDatabase(const KeyframeDatabase&& other) = delete;
+    KeyframeDatabase& operator=(const KeyframeDatabase& other) = delete;
+    KeyframeDatabase& operator=(const KeyframeDatabase&& other) = delete;
+
+    //! Add keyframe captured at Varjo time with HMD pose. Times must not decrease. Evicts up to evictionBatch old
+    //! keyframes. Returns keyframe id, or zero if time is older than the latest keyframe.
+    Id add(int64_t time, const varjo_Matrix& hmdPose, FrameStore::Handle frame);
+
+    //! Find keyframe with the lowest cost to HMD pose among keyframes captured in [t0, t1] within maxAngle radians of
+    //! the view direction. Returns false if none.
+    bool findNearest(const varjo_Matrix& hmdPose, int64_t t0, int64_t t1, double maxAngle, Match& outMatch) const;
+
+    //! Get keyframe by id. Returns false if unknown or evicted.
+    bool get(Id id, Keyframe& outKeyframe) const;
+
+    //! Evict up to maxCount oldest keyframes captured before given time. Returns number evicted.
+    size_t evictBefore(int64_t time, size_t maxCount);
+
+    //! Return database statistics
+    Stats getStats() const;
+
+private:
+    //! Cell entry, copy of keyframe viewpoint for scanning
+    struct Entry {
+        int64_t time = 0;           //!< Capture time
+        glm::vec3 direction{0.0f};  //!< Unit view direction
+        glm::vec3 position{0.0f};   //!< HMD position
+        Id id = 0;                  //!< Keyframe id
+    };
+
+    //! Stored keyframe with its cell
+    struct Record {
+        Keyframe keyframe;  //!< Keyframe
+        int cell = 0;       //!< Direction cell index
+    };
+
+    //! Return direction cell of unit direction
+    int getCell(const glm::dvec3& direction) const;
+
+    //! Collect cells that may hold directions within radius of given unit direction
+    void getCells(const glm::dvec3& direction, double radius, std::vector<int>& outCells) const;
+
+    //! Evict oldest keyframe and collect its frame. Requires lock.
+    void evictOldest(std::vector<FrameStore::Handle>& frames);
+
+    //! Release evicted frames from frame store. Called without lock.
+    void releaseFrames(const std::vector<FrameStore::Handle>& frames);
+
+private:
+    const Config m_config;                    //!< Database configuration
+    FrameStore* const m_frameStore;           //!< Frame store for evicted frames, not owned
+    mutable std::mutex m_mutex;               //!< Lock for database state
+    std::deque<Record> m_records;             //!< Keyframes in time order
+    Id m_firstId = 1;                         //!< Id of oldest record
+    std::vector<std::deque<Entry>> m_cells;   //!< Time-ordered entries per direction cell
+    mutable std::vector<uint32_t> m_visited;  //!< Query stamp per cell scanned
+    mutable uint32_t m_queryStamp = 0;        //!< Stamp of current query
+    mutable Stats m_stats;                    //!< Database statistics
+};
+
+}  // namespace VarjoExamples
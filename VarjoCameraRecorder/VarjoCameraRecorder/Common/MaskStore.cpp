@@ -0,0 +1,478 @@
+#include "MaskStore.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+namespace
+{
+// Serialization magic and version
+constexpr uint32_t c_maskMagic = 0x4b534d52;  // "RMSK"
+constexpr uint32_t c_maskVersion = 1;
+
+// Serialized sizes of a mask header (width, height, y0, row offset count, run count) and of a mask file record header
+constexpr uint64_t c_maskHeaderBytes = 4 * sizeof(int32_t) + sizeof(uint32_t);
+constexpr uint64_t c_recordHeaderBytes = sizeof(int64_t) + sizeof(VarjoExamples::MaskStore::ObjectId);
+
+// Return bytes left in stream, 0 if the stream is not seekable
+uint64_t remainingBytes(std::istream& in)
+{
+    const std::streampos pos = in.tellg();
+    if (pos < 0) {
+        return 0;
+    }
+    in.seekg(0, std::ios::end);
+    const std::streampos end = in.tellg();
+    in.seekg(pos);
+    return (end > pos) ? static_cast<uint64_t>(end - pos) : 0;
+}
+
+// Sum of squares 0^2 + ... + n^2
+inline double sumOfSquares(double n) { return n * (n + 1.0) * (2.0 * n + 1.0) / 6.0; }
+
+// Union of two sorted run lists
+void uniteRuns(const uint16_t* a, const uint16_t* aEnd, const uint16_t* b, const uint16_t* bEnd, std::vector<uint16_t>& out)
+{
+    out.clear();
+    while (a != aEnd || b != bEnd) {
+        // Pick run with smaller begin
+        const uint16_t* run;
+        if (b == bEnd || (a != aEnd && a[0] <= b[0])) {
+            run = a;
+            a += 2;
+        } else {
+            run = b;
+            b += 2;
+        }
+
+        // Extend last output run if overlapping or adjacent
+        if (!out.empty() && run[0] <= out.back()) {
+            out.back() = std::max(out.back(), run[1]);
+        } else {
+            out.push_back(run[0]);
+            out.push_back(run[1]);
+        }
+    }
+}
+
+// Intersection of two sorted run lists
+void intersectRuns(const uint16_t* a, const uint16_t* aEnd, const uint16_t* b, const uint16_t* bEnd, std::vector<uint16_t>& out)
+{
+    out.clear();
+    while (a != aEnd && b != bEnd) {
+        const uint16_t begin = std::max(a[0], b[0]);
+        const uint16_t end = std::min(a[1], b[1]);
+        if (begin < end) {
+            out.push_back(begin);
+            out.push_back(end);
+        }
+
+        // Advance run that ends first
+        if (a[1] < b[1]) {
+            a += 2;
+        } else {
+            b += 2;
+        }
+    }
+}
+
+}  // namespace
+
+namespace VarjoExamples
+{
+RleMask::RleMask(int width, int height)
+    : m_width(width)
+    , m_height(height)
+{
+    assert(width <= std::numeric_limits<uint16_t>::max());
+}
+
+RleMask RleMask::fromDense(const uint8_t* data, int width, int height, int rowStride, uint8_t threshold)
+{
+    RleMask mask(width, height);
+    std::vector<uint16_t> row;
+
+    for (int y = 0; y < height; y++) {
+        const uint8_t* src = data + static_cast<size_t>(y) * rowStride;
+        row.clear();
+
+        int x = 0;
+        while (x < width) {
+            // Skip clear pixels
+            while (x < width && src[x] <= threshold) {
+                x++;
+            }
+            if (x == width) {
+                break;
+            }
+
+            const int begin = x;
+            while (x < width && src[x] > threshold) {
+                x++;
+            }
+            row.push_back(static_cast<uint16_t>(begin));
+            row.push_back(static_cast<uint16_t>(x));
+        }
+
+        mask.appendRow(y, row.data(), row.data() + row.size());
+    }
+
+    mask.trim();
+    return mask;
+}
+
+void RleMask::toDense(uint8_t* data, int rowStride, uint8_t value) const
+{
+    for (int y = 0; y < m_height; y++) {
+        uint8_t* dst = data + static_cast<size_t>(y) * rowStride;
+        memset(dst, 0, m_width);
+
+        const auto row = getRow(y);
+        for (const uint16_t* r = row.first; r != row.second; r += 2) {
+            memset(dst + r[0], value, r[1] - r[0]);
+        }
+    }
+}
+
+void RleMask::appendRow(int y, const uint16_t* begin, const uint16_t* end)
+{
+    if (m_rowOffsets.empty()) {
+        // Skip leading empty rows
+        if (begin == end) {
+            return;
+        }
+        m_y0 = y;
+        m_rowOffsets.push_back(0);
+    }
+
+    // Pad skipped rows as empty
+    const int rows = static_cast<int>(m_rowOffsets.size()) - 1;
+    for (int i = m_y0 + rows; i < y; i++) {
+        m_rowOffsets.push_back(static_cast<uint32_t>(m_runs.size()));
+    }
+
+    m_runs.insert(m_runs.end(), begin, end);
+    m_rowOffsets.push_back(static_cast<uint32_t>(m_runs.size()));
+}
+
+void RleMask::trim()
+{
+    while (m_rowOffsets.size() > 1 && m_rowOffsets[m_rowOffsets.size() - 1] == m_rowOffsets[m_rowOffsets.size() - 2]) {
+        m_rowOffsets.pop_back();
+    }
+    if (m_rowOffsets.size() <= 1) {
+        m_rowOffsets.clear();
+        m_y0 = 0;
+    }
+    m_runs.shrink_to_fit();
+    m_rowOffsets.shrink_to_fit();
+}
+
+std::pair<const uint16_t*, const uint16_t*> RleMask::getRow(int y) const
+{
+    const int index = y - m_y0;
+    if (m_rowOffsets.empty() || index < 0 || index >= static_cast<int>(m_rowOffsets.size()) - 1) {
+        return {nullptr, nullptr};
+    }
+    const uint16_t* base = m_runs.data();
+    return {base + m_rowOffsets[index], base + m_rowOffsets[index + 1]};
+}
+
+glm::ivec4 RleMask::getBounds() const
+{
+    if (empty()) {
+        return glm::ivec4(0);
+    }
+
+    int x0 = m_width;
+    int x1 = 0;
+    for (size_t i = 0; i + 1 < m_rowOffsets.size(); i++) {
+        if (m_rowOffsets[i] != m_rowOffsets[i + 1]) {
+            x0 = std::min(x0, static_cast<int>(m_runs[m_rowOffsets[i]]));
+            x1 = std::max(x1, static_cast<int>(m_runs[m_rowOffsets[i + 1] - 1]));
+        }
+    }
+    return glm::ivec4(x0, m_y0, x1, m_y0 + static_cast<int>(m_rowOffsets.size()) - 1);
+}
+
+uint64_t RleMask::area() const
+{
+    uint64_t sum = 0;
+    for (size_t i = 0; i < m_runs.size(); i += 2) {
+        sum += m_runs[i + 1] - m_runs[i];
+    }
+    return sum;
+}
+
+RleMask::Moments RleMask::moments() const
+{
+    Moments m;
+    for (size_t row = 0; row + 1 < m_rowOffsets.size(); row++) {
+        const double y = static_cast<double>(m_y0 + static_cast<int>(row));
+        double rowCount = 0.0;
+        double rowSumX = 0.0;
+        for (uint32_t i = m_rowOffsets[row]; i < m_rowOffsets[row + 1]; i += 2) {
+            // Closed form sums over x in [a, b)
+            const double a = m_runs[i];
+            const double b = m_runs[i + 1];
+            const double n = b - a;
+            rowCount += n;
+            rowSumX += (a + b - 1.0) * n * 0.5;
+            m.m20 += sumOfSquares(b - 1.0) - sumOfSquares(a - 1.0);
+        }
+        m.m00 += rowCount;
+        m.m10 += rowSumX;
+        m.m01 += rowCount * y;
+        m.m11 += rowSumX * y;
+        m.m02 += rowCount * y * y;
+    }
+    return m;
+}
+
+glm::vec2 RleMask::centroid() const
+{
+    const Moments m = moments();
+    if (m.m00 <= 0.0) {
+        return glm::vec2(-1.0f);
+    }
+    return glm::vec2(static_cast<float>(m.m10 / m.m00), static_cast<float>(m.m01 / m.m00));
+}
+
+template <typename Combine>
+RleMask RleMask::combine(const RleMask& a, const RleMask& b, int y0, int y1, Combine combineRow)
+{
+    RleMask result(a.m_width, a.m_height);
+    std::vector<uint16_t> row;
+    for (int y = y0; y < y1; y++) {
+        const auto rowA = a.getRow(y);
+        const auto rowB = b.getRow(y);
+        combineRow(rowA.first, rowA.second, rowB.first, rowB.second, row);
+        result.appendRow(y, row.data(), row.data() + row.size());
+    }
+    result.trim();
+    return result;
+}
+
+RleMask RleMask::unite(const RleMask& a, const RleMask& b)
+{
+    assert(a.m_width == b.m_width && a.m_height == b.m_height);
+    if (a.empty()) {
+        return b;
+    }
+    if (b.empty()) {
+        return a;
+    }
+
+    const int y0 = std::min(a.m_y0, b.m_y0);
+    const int y1 = std::max(a.m_y0 + static_cast<int>(a.m_rowOffsets.size()), b.m_y0 + static_cast<int>(b.m_rowOffsets.size())) - 1;
+    return combine(a, b, y0, y1, uniteRuns);
+}
+
+RleMask RleMask::intersect(const RleMask& a, const RleMask& b)
+{
+    assert(a.m_width == b.m_width && a.m_height == b.m_height);
+    if (a.empty() || b.empty()) {
+        return RleMask(a.m_width, a.m_height);
+    }
+
+    const int y0 = std::max(a.m_y0, b.m_y0);
+    const int y1 = std::min(a.m_y0 + static_cast<int>(a.m_rowOffsets.size()), b.m_y0 + static_cast<int>(b.m_rowOffsets.size())) - 1;
+    return combine(a, b, y0, std::max(y0, y1), intersectRuns);
+}
+
+uint64_t RleMask::intersectionArea(const RleMask& a, const RleMask& b)
+{
+    if (a.empty() || b.empty()) {
+        return 0;
+    }
+
+    uint64_t sum = 0;
+    const int y0 = std::max(a.m_y0, b.m_y0);
+    const int y1 = std::min(a.m_y0 + static_cast<int>(a.m_rowOffsets.size()), b.m_y0 + static_cast<int>(b.m_rowOffsets.size())) - 1;
+    for (int y = y0; y < y1; y++) {
+        auto ra = a.getRow(y);
+        auto rb = b.getRow(y);
+        while (ra.first != ra.second && rb.first != rb.second) {
+            const int begin = std::max(ra.first[0], rb.first[0]);
+            const int end = std::min(ra.first[1], rb.first[1]);
+            sum += (begin < end) ? (end - begin) : 0;
+            if (ra.first[1] < rb.first[1]) {
+                ra.first += 2;
+            } else {
+                rb.first += 2;
+            }
+        }
+    }
+    return sum;
+}
+
+bool RleMask::write(std::ostream& out) const
+{
+    const int32_t header[4] = {m_width, m_height, m_y0, static_cast<int32_t>(m_rowOffsets.size())};
+    const uint32_t runCount = static_cast<uint32_t>(m_runs.size());
+    out.write(reinterpret_cast<const char*>(header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(&runCount), sizeof(runCount));
+    out.write(reinterpret_cast<const char*>(m_rowOffsets.data()), m_rowOffsets.size() * sizeof(uint32_t));
+    out.write(reinterpret_cast<const char*>(m_runs.data()), m_runs.size() * sizeof(uint16_t));
+    return out.good();
+}
+
+bool RleMask::read(std::istream& in)
+{
+    int32_t header[4] = {};
+    uint32_t runCount = 0;
+    in.read(reinterpret_cast<char*>(header), sizeof(header));
+    in.read(reinterpret_cast<char*>(&runCount), sizeof(runCount));
+    if (!in.good() || header[0] < 0 || header[1] < 0 || header[3] < 0 || (runCount % 2) != 0) {
+        return false;
+    }
+
+    // Counts come from the file, check them against its size before allocating
+    const uint64_t dataSize = static_cast<uint64_t>(header[3]) * sizeof(uint32_t) + static_cast<uint64_t>(runCount) * sizeof(uint16_t);
+    if (dataSize > remainingBytes(in)) {
+        return false;
+    }
+
+    std::vector<uint32_t> rowOffsets(header[3]);
+    std::vector<uint16_t> runs(runCount);
+    in.read(reinterpret_cast<char*>(rowOffsets.data()), rowOffsets.size() * sizeof(uint32_t));
+    in.read(reinterpret_cast<char*>(runs.data()), runs.size() * sizeof(uint16_t));
+    if (!in.good()) {
+        return false;
+    }
+
+    // Row offsets must index the run array in order, runs must lie inside the mask width
+    if (rowOffsets.empty() ? runCount != 0 : (rowOffsets.front() != 0 || rowOffsets.back() != runCount)) {
+        return false;
+    }
+    for (size_t row = 0; row + 1 < rowOffsets.size(); row++) {
+        if (rowOffsets[row] > rowOffsets[row + 1] || (rowOffsets[row] % 2) != 0) {
+            return false;
+        }
+    }
+    for (uint32_t i = 0; i < runCount; i += 2) {
+        if (runs[i] >= runs[i + 1] || runs[i + 1] > header[0]) {
+            return false;
+        }
+    }
+
+    m_width = header[0];
+    m_height = header[1];
+    m_y0 = header[2];
+    m_rowOffsets = std::move(rowOffsets);
+    m_runs = std::move(runs);
+    return true;
+}
+
+void MaskStore::store(int64_t frame, ObjectId object, RleMask mask)
+{
+    // New slots are not counted yet, replaced masks are
+    auto inserted = m_masks.try_emplace(Key(frame, object));
+    RleMask& slot = inserted.first->second;
+    const size_t oldSize = inserted.second ? 0 : slot.getByteSize();
+    const size_t newSize = mask.getByteSize();
+    if (newSize >= oldSize) {
+        m_byteSize += newSize - oldSize;
+    } else {
+        m_byteSize -= oldSize - newSize;
+    }
+    slot = std::move(mask);
+}
+
+const RleMask* MaskStore::get(int64_t frame, ObjectId object) const
+{
+    auto it = m_masks.find({frame, object});
+    return (it != m_masks.end()) ? &it->second : nullptr;
+}
+
+RleMask MaskStore::getFrameUnion(int64_t frame) const
+{
+    RleMask result;
+    auto it = m_masks.lower_bound({frame, std::numeric_limits<ObjectId>::min()});
+    for (; it != m_masks.end() && it->first.first == frame; ++it) {
+        result = result.empty() ? it->second : RleMask::unite(result, it->second);
+    }
+    return result;
+}
+
+void MaskStore::eraseBefore(int64_t frame)
+{
+    auto end = m_masks.lower_bound({frame, std::numeric_limits<ObjectId>::min()});
+    for (auto it = m_masks.begin(); it != end; ++it) {
+        m_byteSize -= it->second.getByteSize();
+    }
+    m_masks.erase(m_masks.begin(), end);
+}
+
+void MaskStore::clear()
+{
+    m_masks.clear();
+    m_byteSize = 0;
+}
+
+bool MaskStore::save(const std::string& filename) const
+{
+    std::ofstream outFile(filename, std::ofstream::binary);
+    if (!outFile.good()) {
+        LOG_ERROR("Opening file for writing failed: %s", filename.c_str());
+        return false;
+    }
+
+    const uint64_t count = m_masks.size();
+    outFile.write(reinterpret_cast<const char*>(&c_maskMagic), sizeof(c_maskMagic));
+    outFile.write(reinterpret_cast<const char*>(&c_maskVersion), sizeof(c_maskVersion));
+    outFile.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    for (const auto& it : m_masks) {
+        outFile.write(reinterpret_cast<const char*>(&it.first.first), sizeof(it.first.first));
+        outFile.write(reinterpret_cast<const char*>(&it.first.second), sizeof(it.first.second));
+        if (!it.second.write(outFile)) {
+            LOG_ERROR("Writing mask file failed: %s", filename.c_str());
+            return false;
+        }
+    }
+    return outFile.good();
+}
+
+bool MaskStore::load(const std::string& filename)
+{
+    std::ifstream inFile(filename, std::ifstream::binary);
+    if (!inFile.good()) {
+        LOG_ERROR("Opening file for reading failed: %s", filename.c_str());
+        return false;
+    }
+
+    uint32_t magic = 0;
+    uint32_t version = 0;
+    uint64_t count = 0;
+    inFile.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+    inFile.read(reinterpret_cast<char*>(&version), sizeof(version));
+    inFile.read(reinterpret_cast<char*>(&count), sizeof(count));
+    if (!inFile.good() || magic != c_maskMagic || version != c_maskVersion) {
+        LOG_ERROR("Invalid mask file: %s", filename.c_str());
+        return false;
+    }
+
+    if (count > remainingBytes(inFile) / (c_recordHeaderBytes + c_maskHeaderBytes)) {
+        LOG_ERROR("Invalid mask file: %s, masks=%llu exceed file size", filename.c_str(), count);
+        return false;
+    }
+
+    clear();
+    for (uint64_t i = 0; i < count; i++) {
+        Key key;
+        RleMask mask;
+        inFile.read(reinterpret_cast<char*>(&key.first), sizeof(key.first));
+        inFile.read(reinterpret_cast<char*>(&key.second), sizeof(key.second));
+        if (!inFile.good() || !mask.read(inFile)) {
+            LOG_ERROR("Reading mask failed: %s, index=%llu", filename.c_str(), i);
+            clear();
+            return false;
+        }
+        store(key.first, key.second, std::move(mask));
+    }
+    return true;
+}
+
+}  // namespace VarjoExamples
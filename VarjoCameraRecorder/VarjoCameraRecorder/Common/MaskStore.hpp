@@ -0,0 +1,150 @@
+#pragma once
+
+#include <vector>
+#include <map>
+#include <string>
+#include <iosfwd>
+
+#include "Globals.hpp"
+
+namespace VarjoExamples
+{
+//! Binary object mask stored as row-wise run-length encoding, cropped to its bounding box.
+//! Mask algebra operates directly on runs without expanding to full frame.
+class RleMask
+{
+public:
+    //! Raw image moments up to second order
+    struct Moments {
+        double m00 = 0.0;  //!< Area
+        double m10 = 0.0;  //!< Sum of x
+        double m01 = 0.0;  //!< Sum of y
+        double m20 = 0.0;  //!< Sum of x^2
+        double m11 = 0.0;  //!< Sum of x*y
+        double m02 = 0.0;  //!< Sum of y^2
+    };
+
+    //! Construct empty mask of given frame size
+    RleMask(int width = 0, int height = 0);
+
+    //! Encode mask from 8-bit image. Pixels above threshold are set.
+    static RleMask fromDense(const uint8_t* data, int width, int height, int rowStride, uint8_t threshold = 127);
+
+    //! Decode mask into 8-bit image of frame size. Set pixels are written with given value, others are cleared.
+    void toDense(uint8_t* data, int rowStride, uint8_t value = 255) const;
+
+    //! Return frame width
+    int getWidth() const { return m_width; }
+
+    //! Return frame height
+    int getHeight() const { return m_height; }
+
+    //! Return true if no pixels are set
+    bool empty() const { return m_runs.empty(); }
+
+    //! Return bounding box (x0, y0, x1, y1), exclusive max. Empty mask returns zero box.
+    glm::ivec4 getBounds() const;
+
+    //! Return set pixel count
+    uint64_t area() const;
+
+    //! Return raw moments
+    Moments moments() const;
+
+    //! Return centroid. Empty mask returns (-1, -1).
+    glm::vec2 centroid() const;
+
+    //! Return union of two masks of same frame size
+    static RleMask unite(const RleMask& a, const RleMask& b);
+
+    //! Return intersection of two masks of same frame size
+    static RleMask intersect(const RleMask& a, const RleMask& b);
+
+    //! Return pixel count of intersection without building it
+    static uint64_t intersectionArea(const RleMask& a, const RleMask& b);
+
+    //! Call func(y, begin, end) for each run in ascending row order
+    template <typename Func>
+    void forEachRun(Func func) const
+    {
+        for (size_t row = 0; row + 1 < m_rowOffsets.size(); row++) {
+            for (uint32_t i = m_rowOffsets[row]; i < m_rowOffsets[row + 1]; i += 2) {
+                func(m_y0 + static_cast<int>(row), static_cast<int>(m_runs[i]), static_cast<int>(m_runs[i + 1]));
+            }
+        }
+    }
+
+    //! Return memory used by encoded data in bytes
+    size_t getByteSize() const { return sizeof(RleMask) + m_runs.size() * sizeof(uint16_t) + m_rowOffsets.size() * sizeof(uint32_t); }
+
+    //! Write mask to binary stream
+    bool write(std::ostream& out) const;
+
+    //! Read mask from binary stream
+    bool read(std::istream& in);
+
+private:
+    //! Append runs for given row. Rows must be appended in ascending order.
+    void appendRow(int y, const uint16_t* begin, const uint16_t* end);
+
+    //! Drop trailing empty rows after building
+    void trim();
+
+    //! Return runs of given absolute row
+    std::pair<const uint16_t*, const uint16_t*> getRow(int y) const;
+
+    //! Row-wise merge of two masks using given run combiner
+    template <typename Combine>
+    static RleMask combine(const RleMask& a, const RleMask& b, int y0, int y1, Combine combineRow);
+
+private:
+    int m_width = 0;                     //!< Frame width
+    int m_height = 0;                    //!< Frame height
+    int m_y0 = 0;                        //!< First encoded row
+    std::vector<uint32_t> m_rowOffsets;  //!< Offsets into run array for each encoded row (rows + 1 entries)
+    std::vector<uint16_t> m_runs;        //!< Interleaved run begin/end x coordinates
+};
+
+//! Container for per-frame object masks
+class MaskStore
+{
+public:
+    //! Object id type
+    using ObjectId = int64_t;
+
+    //! Key for single mask
+    using Key = std::pair<int64_t, ObjectId>;
+
+    //! Store mask for given frame and object
+    void store(int64_t frame, ObjectId object, RleMask mask);
+
+    //! Get mask for given frame and object or nullptr if not found
+    const RleMask* get(int64_t frame, ObjectId object) const;
+
+    //! Return union of all object masks in given frame
+    RleMask getFrameUnion(int64_t frame) const;
+
+    //! Return mask count
+    size_t getCount() const { return m_masks.size(); }
+
+    //! Return total encoded size in bytes
+    size_t getByteSize() const { return m_byteSize; }
+
+    //! Remove masks of frames before given frame
+    void eraseBefore(int64_t frame);
+
+    //! Remove all masks
+    void clear();
+
+    //! Save all masks to file
+    bool save(const std::string& filename) const;
+
+    //! Load masks from file
+    bool load(const std::string& filename);
+
+private:
+    std::map<Key, RleMask> m_masks;  //!< Masks ordered by frame and object
+    size_t m_byteSize = 0;           //!< Total encoded size
+};
+
+}  // namespace VarjoExamples
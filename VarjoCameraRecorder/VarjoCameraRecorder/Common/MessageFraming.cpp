@@ -0,0 +1,417 @@
+// Must be included before Windows.h pulled in by Globals.hpp
+#include "SocketPlatform.hpp"
+
+#include "MessageFraming.hpp"
+
+#include <algorithm>
+#include <string>
+
+namespace
+{
+constexpr uintptr_t c_invalidSocket = VarjoExamples::MessageConnection::c_invalidSocket;
+
+void putU16(uint8_t* p, uint16_t v)
+{
+    p[0] = static_cast<uint8_t>(v);
+    p[1] = static_cast<uint8_t>(v >> 8);
+}
+
+void putU32(uint8_t* p, uint32_t v)
+{
+    for (int i = 0; i < 4; i++) {
+        p[i] = static_cast<uint8_t>(v >> (8 * i));
+    }
+}
+
+uint16_t getU16(const uint8_t* p) { return static_cast<uint16_t>(p[0] | (p[1] << 8)); }
+
+uint32_t getU32(const uint8_t* p)
+{
+    uint32_t v = 0;
+    for (int i = 0; i < 4; i++) {
+        v |= static_cast<uint32_t>(p[i]) << (8 * i);
+    }
+    return v;
+}
+
+// Initialize Winsock once per process
+bool initSockets()
+{
+    static const bool initialized = [] {
+        WSADATA wsaData;
+        return WSAStartup(MAKEWORD(2, 2), &wsaData) == 0;
+    }();
+    return initialized;
+}
+
+}  // namespace
+
+namespace VarjoExamples
+{
+void MessageHeader::write(uint8_t* outData) const
+{
+    putU32(outData + 0, magic);
+    putU16(outData + 4, version);
+    putU16(outData + 6, type);
+    putU32(outData + 8, flags);
+    putU32(outData + 12, length);
+    putU32(outData + 16, sequence);
+    putU32(outData + 20, totalLength);
+}
+
+bool MessageHeader::read(const uint8_t* data)
+{
+    magic = getU32(data + 0);
+    version = getU16(data + 4);
+    type = getU16(data + 6);
+    flags = getU32(data + 8);
+    length = getU32(data + 12);
+    sequence = getU32(data + 16);
+    totalLength = getU32(data + 20);
+    return magic == c_magic && version == c_version && length <= totalLength;
+}
+
+//---------------------------------------------------------------------------
+
+struct BufferPool::State {
+    std::mutex mutex;                                         //!< Lock for pool
+    std::vector<std::unique_ptr<std::vector<uint8_t>>> idle;  //!< Idle buffers
+    size_t maxPooled = 0;                                     //!< Maximum idle buffers
+    Stats stats;                                              //!< Pool statistics
+};
+
+BufferPool::BufferPool(size_t maxPooled)
+    : m_state(std::make_shared<State>())
+{
+    m_state->maxPooled = maxPooled;
+}
+
+BufferPool::Buffer BufferPool::acquire(size_t size)
+{
+    std::unique_ptr<std::vector<uint8_t>> storage;
+    {
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+
+        // Smallest idle buffer that fits
+        auto best = m_state->idle.end();
+        for (auto it = m_state->idle.begin(); it != m_state->idle.end(); ++it) {
+            if ((*it)->size() >= size && (best == m_state->idle.end() || (*it)->size() < (*best)->size())) {
+                best = it;
+            }
+        }
+
+        if (best != m_state->idle.end()) {
+            storage = std::move(*best);
+            m_state->idle.erase(best);
+            m_state->stats.reuses++;
+            m_state->stats.pooledCount--;
+            m_state->stats.pooledBytes -= storage->size();
+        } else {
+            m_state->stats.allocations++;
+        }
+    }
+
+    // Buffers only grow so that reuse never reinitializes contents
+    if (!storage) {
+        storage = std::make_unique<std::vector<uint8_t>>(size);
+    }
+
+    std::weak_ptr<State> weakState = m_state;
+    return Buffer(storage.release(), [weakState](std::vector<uint8_t>* released) {
+        std::unique_ptr<std::vector<uint8_t>> owned(released);
+        if (auto state = weakState.lock()) {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            if (state->idle.size() < state->maxPooled) {
+                state->stats.pooledCount++;
+                state->stats.pooledBytes += owned->size();
+                state->idle.push_back(std::move(owned));
+            }
+        }
+    });
+}
+
+BufferPool::Stats BufferPool::getStats() const
+{
+    std::lock_guard<std::mutex> lock(m_state->mutex);
+    return m_state->stats;
+}
+
+//---------------------------------------------------------------------------
+
+MessageConnection::MessageConnection(uintptr_t socket, size_t maxChunkSize)
+    : m_socket(socket)
+    , m_maxChunkSize(std::max<size_t>(maxChunkSize, 1))
+{
+    const int noDelay = 1;
+    setsockopt(static_cast<SOCKET>(socket), IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&noDelay), sizeof(noDelay));
+}
+
+MessageConnection::~MessageConnection() { close(); }
+
+std::unique_ptr<MessageConnection> MessageConnection::connect(const std::string& host, uint16_t port, size_t maxChunkSize)
+{
+    const uintptr_t s = connectSocket(host, port);
+    if (s == c_invalidSocket) {
+        return nullptr;
+    }
+    return std::make_unique<MessageConnection>(s, maxChunkSize);
+}
+
+uintptr_t MessageConnection::connectSocket(const std::string& host, uint16_t port)
+{
+    if (!initSockets()) {
+        LOG_ERROR("WSAStartup failed.");
+        return c_invalidSocket;
+    }
+
+    addrinfo hints = {};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_protocol = IPPROTO_TCP;
+
+    addrinfo* result = nullptr;
+    const std::string service = std::to_string(port);
+    if (getaddrinfo(host.c_str(), service.c_str(), &hints, &result) != 0) {
+        LOG_ERROR("Resolving host failed: %s", host.c_str());
+        return c_invalidSocket;
+    }
+
+    SOCKET s = INVALID_SOCKET;
+    for (addrinfo* addr = result; addr; addr = addr->ai_next) {
+        s = socket(addr->ai_family, addr->ai_socktype, addr->ai_protocol);
+        if (s == INVALID_SOCKET) {
+            continue;
+        }
+        if (::connect(s, addr->ai_addr, static_cast<int>(addr->ai_addrlen)) == 0) {
+            break;
+        }
+        closesocket(s);
+        s = INVALID_SOCKET;
+    }
+    freeaddrinfo(result);
+
+    if (s == INVALID_SOCKET) {
+        LOG_ERROR("Connecting failed: %s:%d", host.c_str(), port);
+        return c_invalidSocket;
+    }
+    return static_cast<uintptr_t>(s);
+}
+
+void MessageConnection::closeSocket(uintptr_t socket)
+{
+    if (socket != c_invalidSocket) {
+        closesocket(static_cast<SOCKET>(socket));
+    }
+}
+
+bool MessageConnection::send(uint16_t type, const void* data, size_t size)
+{
+    const ConstBuffer segment{data, size};
+    return send(type, &segment, 1);
+}
+
+bool MessageConnection::send(uint16_t type, const ConstBuffer* segments, size_t segmentCount)
+{
+    size_t totalLength = 0;
+    for (size_t i = 0; i < segmentCount; i++) {
+        totalLength += segments[i].size;
+    }
+    if (totalLength > c_maxMessageSize) {
+        LOG_ERROR("Message too large: %zu", totalLength);
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_sendMutex);
+    const SOCKET s = static_cast<SOCKET>(m_socket.load());
+    if (s == INVALID_SOCKET) {
+        return false;
+    }
+
+    MessageHeader header;
+    header.type = type;
+    header.sequence = m_sendSequence++;
+    header.totalLength = static_cast<uint32_t>(totalLength);
+
+    uint8_t headerData[MessageHeader::c_size];
+    std::vector<WSABUF> buffers;
+    buffers.reserve(segmentCount + 1);
+
+    // Walk segments chunk by chunk, gathering header and payload slices into one send per chunk
+    size_t segment = 0;
+    size_t segmentOffset = 0;
+    size_t remaining = totalLength;
+    do {
+        const size_t chunkLength = std::min(remaining, m_maxChunkSize);
+        remaining -= chunkLength;
+
+        header.length = static_cast<uint32_t>(chunkLength);
+        header.flags = remaining > 0 ? MessageHeader::Flag_More : MessageHeader::Flag_None;
+        header.write(headerData);
+
+        buffers.clear();
+        buffers.push_back({static_cast<ULONG>(MessageHeader::c_size), reinterpret_cast<char*>(headerData)});
+
+        size_t needed = chunkLength;
+        while (needed > 0) {
+            const ConstBuffer& src = segments[segment];
+            const size_t take = std::min(needed, src.size - segmentOffset);
+            if (take > 0) {
+                WSABUF buffer;
+                buffer.buf = const_cast<char*>(static_cast<const char*>(src.data) + segmentOffset);
+                buffer.len = static_cast<ULONG>(take);
+                buffers.push_back(buffer);
+            }
+            needed -= take;
+            segmentOffset += take;
+            if (segmentOffset == src.size) {
+                segment++;
+                segmentOffset = 0;
+            }
+        }
+
+        DWORD sent = 0;
+        if (WSASend(s, buffers.data(), static_cast<DWORD>(buffers.size()), &sent, 0, nullptr, nullptr) != 0 ||
+            sent != MessageHeader::c_size + chunkLength) {
+            LOG_ERROR("Sending message failed: type=%d, error=%d", type, WSAGetLastError());
+            return false;
+        }
+    } while (remaining > 0);
+
+    return true;
+}
+
+bool MessageConnection::receive(Message& outMessage)
+{
+    uint8_t headerData[MessageHeader::c_size];
+    MessageHeader header;
+    size_t offset = 0;
+
+    do {
+        if (!recvAll(headerData, sizeof(headerData))) {
+            return false;
+        }
+        if (!header.read(headerData)) {
+            LOG_ERROR("Invalid message header: magic=%x, version=%d", header.magic, header.version);
+            return false;
+        }
+
+        // First chunk allocates storage for whole message. Previous payload goes back to the pool first.
+        if (offset == 0) {
+            if (header.totalLength > c_maxMessageSize) {
+                LOG_ERROR("Message too large: sequence=%u, size=%u", header.sequence, header.totalLength);
+                return false;
+            }
+            outMessage.buffer.reset();
+            outMessage.type = header.type;
+            outMessage.sequence = header.sequence;
+            outMessage.size = header.totalLength;
+            outMessage.buffer = m_pool.acquire(header.totalLength);
+        } else if (header.sequence != outMessage.sequence || header.totalLength != outMessage.size) {
+            LOG_ERROR("Interleaved message chunks: sequence=%u, expected=%u", header.sequence, outMessage.sequence);
+            return false;
+        }
+
+        if (offset + header.length > outMessage.size) {
+            LOG_ERROR("Message chunk overflow: sequence=%u", header.sequence);
+            return false;
+        }
+
+        // Payload goes straight into the pooled buffer
+        if (!recvAll(outMessage.buffer->data() + offset, header.length)) {
+            return false;
+        }
+        offset += header.length;
+    } while (header.flags & MessageHeader::Flag_More);
+
+    return offset == outMessage.size;
+}
+
+void MessageConnection::close()
+{
+    const uintptr_t s = m_socket.exchange(c_invalidSocket);
+    if (s != c_invalidSocket) {
+        shutdown(static_cast<SOCKET>(s), SD_BOTH);
+        closesocket(static_cast<SOCKET>(s));
+    }
+}
+
+bool MessageConnection::isOpen() const { return m_socket.load() != c_invalidSocket; }
+
+bool MessageConnection::recvAll(uint8_t* data, size_t size)
+{
+    const SOCKET s = static_cast<SOCKET>(m_socket.load());
+    size_t received = 0;
+    while (received < size) {
+        const int n = recv(s, reinterpret_cast<char*>(data + received), static_cast<int>(std::min<size_t>(size - received, INT32_MAX)), 0);
+        if (n <= 0) {
+            return false;
+        }
+        received += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+//---------------------------------------------------------------------------
+
+MessageListener::MessageListener(uint16_t port, size_t maxChunkSize)
+    : m_socket(c_invalidSocket)
+    , m_maxChunkSize(maxChunkSize)
+{
+    if (!initSockets()) {
+        CRITICAL("WSAStartup failed.");
+    }
+
+    SOCKET s = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (s == INVALID_SOCKET) {
+        CRITICAL("Creating socket failed: %d", WSAGetLastError());
+    }
+
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(port);
+
+    if (bind(s, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(s, SOMAXCONN) != 0) {
+        const int error = WSAGetLastError();
+        closesocket(s);
+        CRITICAL("Binding socket failed: port=%d, error=%d", port, error);
+    }
+
+    // Resolve actual port when binding to port zero
+    socklen_t length = sizeof(address);
+    getsockname(s, reinterpret_cast<sockaddr*>(&address), &length);
+    m_port = ntohs(address.sin_port);
+    m_socket = static_cast<uintptr_t>(s);
+}
+
+MessageListener::~MessageListener() { close(); }
+
+std::unique_ptr<MessageConnection> MessageListener::accept()
+{
+    const uintptr_t s = acceptSocket();
+    if (s == c_invalidSocket) {
+        return nullptr;
+    }
+    return std::make_unique<MessageConnection>(s, m_maxChunkSize);
+}
+
+uintptr_t MessageListener::acceptSocket()
+{
+    const uintptr_t listenSocket = m_socket.load();
+    if (listenSocket == c_invalidSocket) {
+        return c_invalidSocket;
+    }
+
+    SOCKET s = ::accept(static_cast<SOCKET>(listenSocket), nullptr, nullptr);
+    return s == INVALID_SOCKET ? c_invalidSocket : static_cast<uintptr_t>(s);
+}
+
+void MessageListener::close()
+{
+    const uintptr_t s = m_socket.exchange(c_invalidSocket);
+    if (s != c_invalidSocket) {
+        closesocket(static_cast<SOCKET>(s));
+    }
+}
+
+}  // namespace VarjoExamples
@@ -0,0 +1,196 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "Globals.hpp"
+
+namespace VarjoExamples
+{
+//! Versioned message framing for the recorder, detector and Unity connections.
+//!
+//! Every message is sent as one or more chunks. Each chunk starts with a fixed 24 byte little-endian header:
+//!   uint32 magic, uint16 version, uint16 type, uint32 flags, uint32 length, uint32 sequence, uint32 totalLength
+//! where length is the chunk payload size and totalLength the size of the whole message. All chunks of a message
+//! share the same sequence number, and all but the last have Flag_More set. The top byte of flags holds the
+//! logical channel id on multiplexed connections and is zero otherwise.
+struct MessageHeader {
+    static constexpr uint32_t c_magic = 0x464D5252;  //!< "RRMF"
+    static constexpr uint16_t c_version = 1;         //!< Current protocol version
+    static constexpr size_t c_size = 24;             //!< Serialized header size
+
+    //! Header flags
+    enum Flags : uint32_t {
+        Flag_None = 0,
+        Flag_More = 1 << 0,     //!< More chunks of the same message follow
+        Flag_Control = 1 << 1,  //!< Transport internal message, not delivered to application
+    };
+
+    static constexpr uint32_t c_channelShift = 24;  //!< Bit offset of channel id in flags
+
+    uint32_t magic = c_magic;      //!< Magic number
+    uint16_t version = c_version;  //!< Protocol version
+    uint16_t type = 0;             //!< Application message type
+    uint32_t flags = 0;            //!< Header flags
+    uint32_t length = 0;           //!< Chunk payload length in bytes
+    uint32_t sequence = 0;         //!< Message sequence number
+    uint32_t totalLength = 0;      //!< Total message length in bytes
+
+    //! Return logical channel id
+    uint8_t getChannel() const { return static_cast<uint8_t>(flags >> c_channelShift); }
+
+    //! Set logical channel id
+    void setChannel(uint8_t channel) { flags = (flags & ~(0xFFu << c_channelShift)) | (static_cast<uint32_t>(channel) << c_channelShift); }
+
+    //! Serialize header to c_size bytes
+    void write(uint8_t* outData) const;
+
+    //! Deserialize header from c_size bytes. Returns false if magic or version do not match.
+    bool read(const uint8_t* data);
+};
+
+//! Pool of reusable byte buffers. Released buffers return to the pool automatically and stay valid
+//! even if the pool is destroyed before them.
+class BufferPool
+{
+public:
+    //! Pooled buffer. Dropping the last reference returns the storage to the pool.
+    using Buffer = std::shared_ptr<std::vector<uint8_t>>;
+
+    //! Pool statistics
+    struct Stats {
+        uint64_t allocations = 0;  //!< Buffers allocated from heap
+        uint64_t reuses = 0;       //!< Buffers served from pool
+        size_t pooledCount = 0;    //!< Buffers currently idle in pool
+        size_t pooledBytes = 0;    //!< Bytes currently idle in pool
+    };
+
+    //! Construct pool keeping at most maxPooled idle buffers
+    explicit BufferPool(size_t maxPooled = 16);
+
+    //! Acquire buffer holding at least size bytes. Contents are unspecified.
+    Buffer acquire(size_t size);
+
+    //! Return pool statistics
+    Stats getStats() const;
+
+private:
+    struct State;
+    std::shared_ptr<State> m_state;  //!< Shared pool state, referenced weakly by outstanding buffers
+};
+
+//! Received message
+struct Message {
+    uint16_t type = 0;          //!< Application message type
+    uint32_t sequence = 0;      //!< Message sequence number
+    BufferPool::Buffer buffer;  //!< Payload storage from receive pool
+    size_t size = 0;            //!< Payload size in bytes
+
+    //! Return payload pointer
+    const uint8_t* data() const { return buffer ? buffer->data() : nullptr; }
+};
+
+//! Payload segment for gather writes
+struct ConstBuffer {
+    const void* data = nullptr;  //!< Segment data
+    size_t size = 0;             //!< Segment size in bytes
+};
+
+//! Framed message connection over a connected TCP socket. Send is thread safe, receive must be
+//! called from a single thread.
+class MessageConnection
+{
+public:
+    static constexpr size_t c_defaultChunkSize = 256 * 1024;       //!< Default maximum chunk payload size
+    static constexpr size_t c_maxMessageSize = 256 * 1024 * 1024;  //!< Largest message accepted by send and receive
+    static constexpr uintptr_t c_invalidSocket = ~uintptr_t(0);    //!< Invalid socket handle
+
+    //! Construct connection owning connected socket
+    explicit MessageConnection(uintptr_t socket, size_t maxChunkSize = c_defaultChunkSize);
+
+    //! Destruct connection. Closes socket.
+    ~MessageConnection();
+
+    // Disable copy, move and assign
+    MessageConnection(const MessageConnection& other) = delete;
+    MessageConnection(const MessageConnection&& other) = delete;
+    MessageConnection& operator=(const MessageConnection& other) = delete;
+    MessageConnection& operator=(const MessageConnection&& other) = delete;
+
+    //! Connect to host and port. Returns nullptr on failure.
+    static std::unique_ptr<MessageConnection> connect(const std::string& host, uint16_t port, size_t maxChunkSize = c_defaultChunkSize);
+
+    //! Connect TCP socket to host and port. Returns c_invalidSocket on failure.
+    static uintptr_t connectSocket(const std::string& host, uint16_t port);
+
+    //! Close socket returned by connectSocket or MessageListener::acceptSocket
+    static void closeSocket(uintptr_t socket);
+
+    //! Send message. Returns false on socket error.
+    bool send(uint16_t type, const void* data, size_t size);
+
+    //! Send message gathered from multiple segments without copying them. Returns false on socket error.
+    bool send(uint16_t type, const ConstBuffer* segments, size_t segmentCount);
+
+    //! Receive next message directly into pooled buffer. Returns false on disconnect, protocol error or a message
+    //! larger than c_maxMessageSize.
+    bool receive(Message& outMessage);
+
+    //! Shut down and close socket. Unblocks pending send and receive, isOpen returns false afterwards.
+    void close();
+
+    //! Return true if socket is open
+    bool isOpen() const;
+
+    //! Return receive buffer pool
+    BufferPool& getPool() { return m_pool; }
+
+private:
+    //! Receive exactly size bytes
+    bool recvAll(uint8_t* data, size_t size);
+
+private:
+    std::atomic<uintptr_t> m_socket;  //!< Connected socket
+    const size_t m_maxChunkSize;      //!< Maximum chunk payload size
+    std::mutex m_sendMutex;           //!< Keeps chunks of concurrent sends together
+    uint32_t m_sendSequence = 0;      //!< Next send sequence
+    BufferPool m_pool;                //!< Receive buffer pool
+};
+
+//! Listening socket accepting framed connections
+class MessageListener
+{
+public:
+    //! Construct listener bound to port on all interfaces. Throws on failure.
+    explicit MessageListener(uint16_t port, size_t maxChunkSize = MessageConnection::c_defaultChunkSize);
+
+    //! Destruct listener. Closes socket.
+    ~MessageListener();
+
+    // Disable copy, move and assign
+    MessageListener(const MessageListener& other) = delete;
+    MessageListener(const MessageListener&& other) = delete;
+    MessageListener& operator=(const MessageListener& other) = delete;
+    MessageListener& operator=(const MessageListener&& other) = delete;
+
+    //! Accept next connection. Blocks. Returns nullptr when listener is closed.
+    std::unique_ptr<MessageConnection> accept();
+
+    //! Accept next raw socket for other transports. Blocks. Returns MessageConnection::c_invalidSocket when listener is closed.
+    uintptr_t acceptSocket();
+
+    //! Close listener. Unblocks pending accept.
+    void close();
+
+    //! Return bound port
+    uint16_t getPort() const { return m_port; }
+
+private:
+    std::atomic<uintptr_t> m_socket;  //!< Listening socket
+    uint16_t m_port = 0;              //!< Bound port
+    const size_t m_maxChunkSize;      //!< Chunk size for accepted connections
+};
+
+}  // namespace VarjoExamples
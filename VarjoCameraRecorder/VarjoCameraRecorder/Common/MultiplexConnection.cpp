@@ -0,0 +1,363 @@
+// Must be included before Windows.h pulled in by Globals.hpp
+#include "SocketPlatform.hpp"
+
+#include "MultiplexConnection.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+constexpr uintptr_t c_invalidSocket = VarjoExamples::MessageConnection::c_invalidSocket;
+
+// Transport internal message types, sent with Flag_Control
+constexpr uint16_t c_windowUpdate = 1;  // Credits sequence bytes to channel window
+
+}  // namespace
+
+namespace VarjoExamples
+{
+MultiplexConnection::MultiplexConnection(uintptr_t socket, Handler handler, const Config& config)
+    : m_socket(socket)
+    , m_handler(std::move(handler))
+{
+    const SOCKET s = static_cast<SOCKET>(socket);
+    const int noDelay = 1;
+    setsockopt(s, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&noDelay), sizeof(noDelay));
+    if (config.socketSendBuffer > 0) {
+        setsockopt(s, SOL_SOCKET, SO_SNDBUF, reinterpret_cast<const char*>(&config.socketSendBuffer), sizeof(config.socketSendBuffer));
+    }
+
+    for (size_t i = 0; i < c_channelCount; i++) {
+        ChannelState& channel = m_channels[i];
+        channel.config = config.channels[i];
+        channel.config.window = std::max<size_t>(channel.config.window, 1);
+        // Credits are held back until a quarter of the window is processed, so a chunk of at most half the window
+        // always fits in the remaining send window and the sender cannot stall on uncredited bytes
+        channel.config.chunkSize = std::clamp<size_t>(channel.config.chunkSize, 1, std::max<size_t>(channel.config.window / 2, 1));
+        channel.sendWindow = channel.config.window;
+        m_creditsToSend[i] = 0;
+    }
+
+    m_writer = std::thread(&MultiplexConnection::writerLoop, this);
+    m_receiver = std::thread(&MultiplexConnection::receiverLoop, this);
+}
+
+MultiplexConnection::~MultiplexConnection()
+{
+    close();
+    m_writer.join();
+    m_receiver.join();
+    MessageConnection::closeSocket(m_socket.exchange(c_invalidSocket));
+}
+
+std::unique_ptr<MultiplexConnection> MultiplexConnection::connect(const std::string& host, uint16_t port, Handler handler, const Config& config)
+{
+    const uintptr_t s = MessageConnection::connectSocket(host, port);
+    if (s == c_invalidSocket) {
+        return nullptr;
+    }
+    return std::make_unique<MultiplexConnection>(s, std::move(handler), config);
+}
+
+bool MultiplexConnection::send(Channel channel, uint16_t type, const void* data, size_t size)
+{
+    auto copy = std::make_shared<std::vector<uint8_t>>(static_cast<const uint8_t*>(data), static_cast<const uint8_t*>(data) + size);
+    const void* copyData = copy->data();
+    return send(channel, type, std::move(copy), copyData, size);
+}
+
+bool MultiplexConnection::send(Channel channel, uint16_t type, std::shared_ptr<const void> owner, const void* data, size_t size)
+{
+    const size_t index = static_cast<size_t>(channel);
+    if (index >= c_channelCount || size > MessageConnection::c_maxMessageSize) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_open) {
+        return false;
+    }
+
+    ChannelState& state = m_channels[index];
+    Outgoing message;
+    message.owner = std::move(owner);
+    message.data = static_cast<const uint8_t*>(data);
+    message.size = size;
+    message.type = type;
+    message.sequence = state.nextSequence++;
+    message.queued = Clock::now();
+    state.queue.push_back(std::move(message));
+
+    m_writeCondition.notify_one();
+    return true;
+}
+
+void MultiplexConnection::close()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_open = false;
+        for (auto& channel : m_channels) {
+            channel.queue.clear();
+        }
+    }
+    m_writeCondition.notify_all();
+
+    // Shutdown unblocks receiver, socket itself is closed in destructor
+    const uintptr_t s = m_socket.load();
+    if (s != c_invalidSocket) {
+        shutdown(static_cast<SOCKET>(s), SD_BOTH);
+    }
+}
+
+bool MultiplexConnection::isOpen() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_open;
+}
+
+MultiplexConnection::ChannelStats MultiplexConnection::getStats(Channel channel) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_channels[static_cast<size_t>(channel)].stats;
+}
+
+void MultiplexConnection::writerLoop()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        size_t next = c_channelCount;
+        m_writeCondition.wait(lock, [&] {
+            if (!m_open) {
+                return true;
+            }
+            for (size_t credit : m_creditsToSend) {
+                if (credit > 0) {
+                    return true;
+                }
+            }
+            next = pickChannel();
+            return next < c_channelCount;
+        });
+        if (!m_open) {
+            break;
+        }
+
+        MessageHeader header;
+        const uint8_t* data = nullptr;
+        std::shared_ptr<const void> owner;
+        Clock::time_point queued;
+        bool last = false;
+
+        // Window updates go out before any payload so the peer never stalls on our backlog
+        auto creditIt = std::find_if(m_creditsToSend.begin(), m_creditsToSend.end(), [](size_t credit) { return credit > 0; });
+        if (creditIt != m_creditsToSend.end()) {
+            const size_t channel = static_cast<size_t>(creditIt - m_creditsToSend.begin());
+            header.type = c_windowUpdate;
+            header.flags = MessageHeader::Flag_Control;
+            header.setChannel(static_cast<uint8_t>(channel));
+            header.sequence = static_cast<uint32_t>(std::min<size_t>(*creditIt, UINT32_MAX));
+            *creditIt -= header.sequence;
+        } else {
+            ChannelState& state = m_channels[next];
+            Outgoing& message = state.queue.front();
+
+            const size_t length = std::min({message.size - message.offset, state.config.chunkSize, state.sendWindow});
+            header.type = message.type;
+            header.sequence = message.sequence;
+            header.length = static_cast<uint32_t>(length);
+            header.totalLength = static_cast<uint32_t>(message.size);
+            data = message.data + message.offset;
+
+            message.offset += length;
+            state.sendWindow -= length;
+            last = message.offset == message.size;
+            header.flags = last ? MessageHeader::Flag_None : MessageHeader::Flag_More;
+            header.setChannel(static_cast<uint8_t>(next));
+
+            // Keep payload alive while writing even if close() clears the queue
+            owner = message.owner;
+            if (last) {
+                queued = message.queued;
+                state.queue.pop_front();
+            }
+        }
+        lock.unlock();
+
+        const bool written = writeChunk(header, data, header.length);
+
+        lock.lock();
+        if (!written) {
+            m_open = false;
+            break;
+        }
+
+        if (!(header.flags & MessageHeader::Flag_Control)) {
+            ChannelState& state = m_channels[header.getChannel()];
+            state.stats.bytesSent += header.length;
+            if (last) {
+                const double latency = std::chrono::duration<double>(Clock::now() - queued).count();
+                state.stats.messagesSent++;
+                state.stats.maxSendLatency = std::max(state.stats.maxSendLatency, latency);
+                state.totalSendLatency += latency;
+                state.stats.avgSendLatency = state.totalSendLatency / static_cast<double>(state.stats.messagesSent);
+            }
+        }
+    }
+}
+
+void MultiplexConnection::receiverLoop()
+{
+    uint8_t headerData[MessageHeader::c_size];
+    MessageHeader header;
+
+    while (readAll(headerData, sizeof(headerData))) {
+        if (!header.read(headerData) || header.getChannel() >= c_channelCount) {
+            LOG_ERROR("Invalid multiplexed header: magic=%x, version=%d, channel=%d", header.magic, header.version, header.getChannel());
+            break;
+        }
+
+        const size_t index = header.getChannel();
+        ChannelState& state = m_channels[index];
+
+        if (header.flags & MessageHeader::Flag_Control) {
+            if (header.type == c_windowUpdate) {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                state.sendWindow += header.sequence;
+                m_writeCondition.notify_one();
+            }
+            continue;
+        }
+
+        // Reassembly state is only touched by this thread
+        if (state.incomingOffset == 0) {
+            if (header.totalLength > MessageConnection::c_maxMessageSize) {
+                LOG_ERROR("Message too large on channel %zu: sequence=%u, size=%u", index, header.sequence, header.totalLength);
+                break;
+            }
+            state.incoming.buffer.reset();
+            state.incoming.type = header.type;
+            state.incoming.sequence = header.sequence;
+            state.incoming.size = header.totalLength;
+            state.incoming.buffer = state.pool.acquire(header.totalLength);
+        } else if (header.sequence != state.incoming.sequence) {
+            LOG_ERROR("Interleaved chunks on channel %zu: sequence=%u, expected=%u", index, header.sequence, state.incoming.sequence);
+            break;
+        }
+
+        if (state.incomingOffset + header.length > state.incoming.size ||
+            (!(header.flags & MessageHeader::Flag_More) && state.incomingOffset + header.length != state.incoming.size)) {
+            LOG_ERROR("Invalid chunk length on channel %zu: sequence=%u", index, header.sequence);
+            break;
+        }
+
+        if (!readAll(state.incoming.buffer->data() + state.incomingOffset, header.length)) {
+            break;
+        }
+        state.incomingOffset += header.length;
+
+        const bool complete = !(header.flags & MessageHeader::Flag_More);
+        if (complete) {
+            state.incomingOffset = 0;
+            if (m_handler) {
+                m_handler(static_cast<Channel>(index), state.incoming);
+            }
+        }
+
+        // Credit after processing so a slow handler throttles only its own channel
+        std::lock_guard<std::mutex> lock(m_mutex);
+        state.stats.bytesReceived += header.length;
+        if (complete) {
+            state.stats.messagesReceived++;
+        }
+        addCredit(index, header.length);
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_open = false;
+    for (auto& channel : m_channels) {
+        channel.queue.clear();
+    }
+    m_writeCondition.notify_all();
+}
+
+size_t MultiplexConnection::pickChannel()
+{
+    size_t best = c_channelCount;
+    for (size_t i = 0; i < c_channelCount; i++) {
+        ChannelState& state = m_channels[i];
+        if (state.queue.empty()) {
+            continue;
+        }
+
+        // Require room for a full chunk, or the whole remainder, to avoid dribbling tiny chunks
+        const Outgoing& message = state.queue.front();
+        const size_t wanted = std::min(message.size - message.offset, state.config.chunkSize);
+        if (wanted > 0 && state.sendWindow < wanted) {
+            if (!state.stalled) {
+                state.stalled = true;
+                state.stats.windowStalls++;
+            }
+            continue;
+        }
+        state.stalled = false;
+
+        if (best == c_channelCount || state.config.priority < m_channels[best].config.priority) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+void MultiplexConnection::addCredit(size_t channel, size_t bytes)
+{
+    ChannelState& state = m_channels[channel];
+    state.pendingCredit += bytes;
+
+    // Batch window updates to a quarter of the window
+    if (state.pendingCredit >= state.config.window / 4) {
+        m_creditsToSend[channel] += state.pendingCredit;
+        state.pendingCredit = 0;
+        m_writeCondition.notify_one();
+    }
+}
+
+bool MultiplexConnection::writeChunk(const MessageHeader& header, const void* data, size_t size)
+{
+    const SOCKET s = static_cast<SOCKET>(m_socket.load());
+    if (s == INVALID_SOCKET) {
+        return false;
+    }
+
+    uint8_t headerData[MessageHeader::c_size];
+    header.write(headerData);
+
+    WSABUF buffers[2];
+    buffers[0].buf = reinterpret_cast<char*>(headerData);
+    buffers[0].len = static_cast<ULONG>(sizeof(headerData));
+    buffers[1].buf = const_cast<char*>(static_cast<const char*>(data));
+    buffers[1].len = static_cast<ULONG>(size);
+
+    DWORD sent = 0;
+    if (WSASend(s, buffers, size > 0 ? 2 : 1, &sent, 0, nullptr, nullptr) != 0) {
+        return false;
+    }
+    return sent == sizeof(headerData) + size;
+}
+
+bool MultiplexConnection::readAll(uint8_t* data, size_t size)
+{
+    const SOCKET s = static_cast<SOCKET>(m_socket.load());
+    size_t received = 0;
+    while (received < size) {
+        const int n = recv(s, reinterpret_cast<char*>(data + received), static_cast<int>(std::min<size_t>(size - received, INT32_MAX)), 0);
+        if (n <= 0) {
+            return false;
+        }
+        received += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+}  // namespace VarjoExamples
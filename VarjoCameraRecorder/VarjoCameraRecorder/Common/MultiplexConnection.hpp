@@ -0,0 +1,157 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "MessageFraming.hpp"
+
+namespace VarjoExamples
+{
+//! Framed connection carrying independent logical channels over one TCP socket.
+//!
+//! Messages are split into chunks no larger than the channel chunk size, and a single writer thread always
+//! sends the next chunk of the highest priority channel that has data and window left. A control message
+//! queued behind a multi-megabyte bulk frame therefore waits for at most one bulk chunk. Each channel has
+//! a byte window granted by the receiver: chunks are credited back once processed, so a slow consumer of
+//! one channel cannot starve the others.
+class MultiplexConnection
+{
+public:
+    //! Logical channels
+    enum class Channel : uint8_t {
+        Control = 0,  //!< Interaction commands, e.g. START_REPLAY
+        Pose = 1,     //!< Pose and metadata updates
+        Bulk = 2,     //!< Frames and other large payloads
+        Count
+    };
+
+    static constexpr size_t c_channelCount = static_cast<size_t>(Channel::Count);
+
+    //! Per channel configuration. Both ends must use the same windows.
+    struct ChannelConfig {
+        int priority = 0;      //!< Lower value is sent first
+        size_t window = 0;     //!< Bytes that may be in flight before receiver credits them
+        size_t chunkSize = 0;  //!< Maximum chunk payload size, at most half the window
+    };
+
+    //! Connection configuration
+    struct Config {
+        std::array<ChannelConfig, c_channelCount> channels = {{
+            {0, 256 * 1024, 16 * 1024},       // Control
+            {1, 1024 * 1024, 16 * 1024},      // Pose
+            {2, 8 * 1024 * 1024, 64 * 1024},  // Bulk
+        }};
+        int socketSendBuffer = 256 * 1024;  //!< Kernel send buffer. Small keeps bulk data from queueing ahead of control.
+    };
+
+    //! Per channel statistics
+    struct ChannelStats {
+        uint64_t messagesSent = 0;      //!< Messages fully written to socket
+        uint64_t bytesSent = 0;         //!< Payload bytes written
+        uint64_t messagesReceived = 0;  //!< Messages delivered to handler
+        uint64_t bytesReceived = 0;     //!< Payload bytes received
+        uint64_t windowStalls = 0;      //!< Times channel had data but no window
+        double maxSendLatency = 0.0;    //!< Longest time from send() to last chunk written in seconds
+        double avgSendLatency = 0.0;    //!< Average time from send() to last chunk written in seconds
+    };
+
+    //! Message handler, called on receive thread
+    using Handler = std::function<void(Channel channel, Message& message)>;
+
+    //! Construct connection owning connected socket
+    MultiplexConnection(uintptr_t socket, Handler handler, const Config& config);
+
+    //! Destruct connection. Closes socket and joins threads.
+    ~MultiplexConnection();
+
+    // Disable copy, move and assign
+    MultiplexConnection(const MultiplexConnection& other) = delete;
+    MultiplexConnection(const MultiplexConnection&& other) = delete;
+    MultiplexConnection& operator=(const MultiplexConnection& other) = delete;
+    MultiplexConnection& operator=(const MultiplexConnection&& other) = delete;
+
+    //! Connect to host and port. Returns nullptr on failure.
+    static std::unique_ptr<MultiplexConnection> connect(const std::string& host, uint16_t port, Handler handler, const Config& config);
+
+    //! Queue copy of message on channel. Returns false if connection is closed or message is larger than
+    //! MessageConnection::c_maxMessageSize.
+    bool send(Channel channel, uint16_t type, const void* data, size_t size);
+
+    //! Queue message without copying. Owner keeps data alive until the last chunk is written.
+    bool send(Channel channel, uint16_t type, std::shared_ptr<const void> owner, const void* data, size_t size);
+
+    //! Close connection. Pending messages are dropped.
+    void close();
+
+    //! Return true if connection is open
+    bool isOpen() const;
+
+    //! Return statistics of channel
+    ChannelStats getStats(Channel channel) const;
+
+private:
+    using Clock = std::chrono::high_resolution_clock;
+
+    //! Queued outgoing message
+    struct Outgoing {
+        std::shared_ptr<const void> owner;  //!< Keeps data alive
+        const uint8_t* data = nullptr;      //!< Payload
+        size_t size = 0;                    //!< Payload size
+        size_t offset = 0;                  //!< Bytes already sent
+        uint16_t type = 0;                  //!< Application message type
+        uint32_t sequence = 0;              //!< Message sequence on channel
+        Clock::time_point queued;           //!< Time send() was called
+    };
+
+    //! Channel state
+    struct ChannelState {
+        ChannelConfig config;           //!< Channel configuration
+        std::deque<Outgoing> queue;     //!< Outgoing messages
+        size_t sendWindow = 0;          //!< Bytes we may still send
+        uint32_t nextSequence = 0;      //!< Next outgoing sequence
+        Message incoming;               //!< Message being reassembled
+        size_t incomingOffset = 0;      //!< Bytes of incoming message received
+        size_t pendingCredit = 0;       //!< Processed bytes not yet credited to sender
+        BufferPool pool;                //!< Receive buffer pool
+        ChannelStats stats;             //!< Channel statistics
+        double totalSendLatency = 0.0;  //!< Sum of send latencies for average
+        bool stalled = false;           //!< Waiting for window
+    };
+
+    //! Writer main loop
+    void writerLoop();
+
+    //! Receiver main loop
+    void receiverLoop();
+
+    //! Pick channel to send next. Returns c_channelCount if none. Requires lock.
+    size_t pickChannel();
+
+    //! Credit processed bytes and queue window update when worthwhile. Requires lock.
+    void addCredit(size_t channel, size_t bytes);
+
+    //! Write header and payload slice with one gather write
+    bool writeChunk(const MessageHeader& header, const void* data, size_t size);
+
+    //! Receive exactly size bytes
+    bool readAll(uint8_t* data, size_t size);
+
+private:
+    std::atomic<uintptr_t> m_socket;                      //!< Connected socket
+    Handler m_handler;                                    //!< Message handler
+    mutable std::mutex m_mutex;                           //!< Lock for channel state
+    std::condition_variable m_writeCondition;             //!< Signaled when data, window or credit changes
+    std::array<ChannelState, c_channelCount> m_channels;  //!< Channel states
+    std::array<size_t, c_channelCount> m_creditsToSend;   //!< Window updates waiting to be sent
+    bool m_open = true;                                   //!< Open flag
+    std::thread m_writer;                                 //!< Writer thread
+    std::thread m_receiver;                               //!< Receiver thread
+};
+
+}  // namespace VarjoExamples
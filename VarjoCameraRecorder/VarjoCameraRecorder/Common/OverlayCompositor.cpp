@@ -0,0 +1,354 @@
+#include "OverlayCompositor.hpp"
+
+#include <emmintrin.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+using VarjoExamples::OverlayCompositor;
+
+// Per channel weights in 8.8 fixed point. Weighted channels must stay below 32768 for signed 16-bit packing.
+struct Weights {
+    uint16_t w[4];
+};
+
+inline uint16_t toFixed(float v, float maxValue) { return static_cast<uint16_t>(std::clamp(v, 0.0f, maxValue) * 256.0f + 0.5f); }
+
+// Expand four mask bytes to four pixels with mask in every channel
+inline __m128i expandMask(const uint8_t* mask)
+{
+    int32_t bits;
+    memcpy(&bits, mask, sizeof(bits));
+    __m128i v = _mm_cvtsi32_si128(bits);
+    v = _mm_unpacklo_epi8(v, v);
+    return _mm_unpacklo_epi16(v, v);
+}
+
+// Load four source pixels. Masks used for source over get full color and mask as alpha.
+inline __m128i loadSource(const uint8_t* src, bool mask, bool over)
+{
+    if (!mask) {
+        return _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+    }
+    const __m128i v = expandMask(src);
+    if (!over) {
+        return v;
+    }
+    return _mm_or_si128(_mm_and_si128(v, _mm_set1_epi32(static_cast<int>(0xff000000u))), _mm_set1_epi32(0x00ffffff));
+}
+
+// Load single source pixel as 32-bit value
+inline uint32_t loadSourcePixel(const uint8_t* src, bool mask, bool over)
+{
+    if (!mask) {
+        uint32_t v;
+        memcpy(&v, src, sizeof(v));
+        return v;
+    }
+    const uint32_t m = *src;
+    return over ? ((m << 24) | 0x00ffffffu) : (m * 0x01010101u);
+}
+
+// Multiply 16-bit channels by 8.8 weights
+inline __m128i weigh(__m128i v16, __m128i w) { return _mm_mulhi_epu16(_mm_slli_epi16(v16, 8), w); }
+
+// dst = saturate(dst + src * w)
+void blendRowAdd(const uint8_t* src, bool mask, uint8_t* dst, int count, const Weights& weights)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i w = _mm_setr_epi16(weights.w[0], weights.w[1], weights.w[2], weights.w[3], weights.w[0], weights.w[1], weights.w[2], weights.w[3]);
+    const int srcStep = mask ? 1 : 4;
+
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m128i s = loadSource(src + i * srcStep, mask, false);
+        const __m128i lo = weigh(_mm_unpacklo_epi8(s, zero), w);
+        const __m128i hi = weigh(_mm_unpackhi_epi8(s, zero), w);
+        __m128i* d = reinterpret_cast<__m128i*>(dst + i * 4);
+        _mm_storeu_si128(d, _mm_adds_epu8(_mm_loadu_si128(d), _mm_packus_epi16(lo, hi)));
+    }
+
+    for (; i < count; i++) {
+        const uint32_t s = loadSourcePixel(src + i * srcStep, mask, false);
+        for (int c = 0; c < 4; c++) {
+            const uint32_t v = dst[i * 4 + c] + ((((s >> (c * 8)) & 0xff) * weights.w[c]) >> 8);
+            dst[i * 4 + c] = static_cast<uint8_t>(std::min<uint32_t>(v, 255));
+        }
+    }
+}
+
+// dst = src * a + dst * (1 - a), with a taken from weighted source alpha
+void blendRowOver(const uint8_t* src, bool mask, uint8_t* dst, int count, const Weights& weights)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i w = _mm_setr_epi16(weights.w[0], weights.w[1], weights.w[2], weights.w[3], weights.w[0], weights.w[1], weights.w[2], weights.w[3]);
+    const __m128i colorMask = _mm_setr_epi16(-1, -1, -1, 0, -1, -1, -1, 0);
+    const __m128i alphaOne = _mm_setr_epi16(0, 0, 0, 255, 0, 0, 0, 255);
+    const __m128i full = _mm_set1_epi16(255);
+    const __m128i half = _mm_set1_epi16(128);
+    const int srcStep = mask ? 1 : 4;
+
+    // Blend four channels of two pixels, (c * a + d * (255 - a)) / 255 with exact rounding
+    auto blend = [&](__m128i s16, __m128i d16) {
+        s16 = weigh(s16, w);
+        __m128i a = _mm_shufflelo_epi16(s16, _MM_SHUFFLE(3, 3, 3, 3));
+        a = _mm_shufflehi_epi16(a, _MM_SHUFFLE(3, 3, 3, 3));
+        s16 = _mm_or_si128(_mm_and_si128(s16, colorMask), alphaOne);
+        __m128i t = _mm_add_epi16(_mm_mullo_epi16(s16, a), _mm_mullo_epi16(d16, _mm_sub_epi16(full, a)));
+        t = _mm_add_epi16(t, half);
+        return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+    };
+
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m128i s = loadSource(src + i * srcStep, mask, true);
+        __m128i* d = reinterpret_cast<__m128i*>(dst + i * 4);
+        const __m128i dv = _mm_loadu_si128(d);
+        const __m128i lo = blend(_mm_unpacklo_epi8(s, zero), _mm_unpacklo_epi8(dv, zero));
+        const __m128i hi = blend(_mm_unpackhi_epi8(s, zero), _mm_unpackhi_epi8(dv, zero));
+        _mm_storeu_si128(d, _mm_packus_epi16(lo, hi));
+    }
+
+    for (; i < count; i++) {
+        const uint32_t s = loadSourcePixel(src + i * srcStep, mask, true);
+        uint32_t c[4];
+        for (int k = 0; k < 4; k++) {
+            c[k] = (((s >> (k * 8)) & 0xff) * weights.w[k]) >> 8;
+        }
+        const uint32_t a = c[3];
+        c[3] = 255;
+        for (int k = 0; k < 4; k++) {
+            uint32_t t = c[k] * a + dst[i * 4 + k] * (255 - a) + 128;
+            dst[i * 4 + k] = static_cast<uint8_t>((t + (t >> 8)) >> 8);
+        }
+    }
+}
+
+// dst = round(dst * scale), rounding half to even in single precision like cv2.addWeighted
+void scaleRow(uint8_t* dst, int count, float scale)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128 s = _mm_set1_ps(scale);
+
+    // Default MXCSR rounding of the conversion is round half to even, as cvRound
+    auto scale4 = [&](__m128i v32) { return _mm_cvtps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(v32), s)); };
+
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i* d = reinterpret_cast<__m128i*>(dst + i * 4);
+        const __m128i v = _mm_loadu_si128(d);
+        const __m128i lo = _mm_unpacklo_epi8(v, zero);
+        const __m128i hi = _mm_unpackhi_epi8(v, zero);
+        const __m128i lo16 = _mm_packs_epi32(scale4(_mm_unpacklo_epi16(lo, zero)), scale4(_mm_unpackhi_epi16(lo, zero)));
+        const __m128i hi16 = _mm_packs_epi32(scale4(_mm_unpacklo_epi16(hi, zero)), scale4(_mm_unpackhi_epi16(hi, zero)));
+        _mm_storeu_si128(d, _mm_packus_epi16(lo16, hi16));
+    }
+
+    for (int c = i * 4; c < count * 4; c++) {
+        dst[c] = static_cast<uint8_t>(std::clamp<long>(std::lrint(dst[c] * scale), 0, 255));
+    }
+}
+
+// Return true if any byte of layer inside rect is non-zero
+bool hasContent(const OverlayCompositor::Layer& layer, int x0, int y0, int x1, int y1)
+{
+    const int bpp = layer.format == OverlayCompositor::Format::Alpha8 ? 1 : 4;
+    const size_t rowBytes = static_cast<size_t>(x1 - x0) * bpp;
+    for (int y = y0; y < y1; y++) {
+        const uint8_t* row = layer.data + static_cast<size_t>(y - layer.y) * layer.rowStride + static_cast<size_t>(x0 - layer.x) * bpp;
+        size_t i = 0;
+        for (; i + 16 <= rowBytes; i += 16) {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + i));
+            if (_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_setzero_si128())) != 0xffff) {
+                return true;
+            }
+        }
+        for (; i < rowBytes; i++) {
+            if (row[i]) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+}  // namespace
+
+namespace VarjoExamples
+{
+OverlayCompositor::OverlayCompositor()
+    : OverlayCompositor(Config())
+{
+}
+
+OverlayCompositor::OverlayCompositor(const Config& config)
+{
+    const int threadCount = config.threadCount > 0 ? config.threadCount : std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+
+    // Calling thread processes tiles too
+    for (int i = 1; i < threadCount; i++) {
+        m_workers.emplace_back(&OverlayCompositor::workerLoop, this);
+    }
+}
+
+OverlayCompositor::~OverlayCompositor()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_jobCondition.notify_all();
+
+    for (auto& worker : m_workers) {
+        worker.join();
+    }
+}
+
+void OverlayCompositor::composite(int width, int height, const std::vector<Layer>& layers, const std::vector<Output>& outputs)
+{
+    std::lock_guard<std::mutex> callLock(m_callMutex);
+    const auto start = std::chrono::high_resolution_clock::now();
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_width = std::max(width, 0);
+        m_height = std::max(height, 0);
+        m_tilesX = (m_width + c_tileSize - 1) / c_tileSize;
+        m_tileCount = m_tilesX * ((m_height + c_tileSize - 1) / c_tileSize);
+        m_layers = &layers;
+        m_outputs = &outputs;
+        m_nextTile = 0;
+        m_skippedTiles = 0;
+        m_busyWorkers = static_cast<int>(m_workers.size());
+        m_generation++;
+    }
+    m_jobCondition.notify_all();
+
+    runTiles();
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_doneCondition.wait(lock, [&] { return m_busyWorkers == 0; });
+    m_layers = nullptr;
+    m_outputs = nullptr;
+
+    m_stats.tileCount = static_cast<size_t>(m_tileCount) * outputs.size();
+    m_stats.skippedTiles = m_skippedTiles;
+    m_stats.seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+OverlayCompositor::Stats OverlayCompositor::getStats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+void OverlayCompositor::workerLoop()
+{
+    uint64_t generation = 0;
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        m_jobCondition.wait(lock, [&] { return m_stop || m_generation != generation; });
+        if (m_stop) {
+            break;
+        }
+        generation = m_generation;
+
+        lock.unlock();
+        runTiles();
+        lock.lock();
+
+        if (--m_busyWorkers == 0) {
+            m_doneCondition.notify_all();
+        }
+    }
+}
+
+void OverlayCompositor::runTiles()
+{
+    std::vector<uint8_t> active(m_layers->size());
+    for (int tile = m_nextTile++; tile < m_tileCount; tile = m_nextTile++) {
+        compositeTile(tile, active);
+    }
+}
+
+void OverlayCompositor::compositeTile(int tile, std::vector<uint8_t>& active)
+{
+    const int x0 = (tile % m_tilesX) * c_tileSize;
+    const int y0 = (tile / m_tilesX) * c_tileSize;
+    const int x1 = std::min(x0 + c_tileSize, m_width);
+    const int y1 = std::min(y0 + c_tileSize, m_height);
+
+    // Find layers with content in tile once for all outputs
+    const auto& layers = *m_layers;
+    for (size_t i = 0; i < layers.size(); i++) {
+        const Layer& layer = layers[i];
+        const int lx0 = std::max(x0, layer.x);
+        const int ly0 = std::max(y0, layer.y);
+        const int lx1 = std::min(x1, layer.x + layer.width);
+        const int ly1 = std::min(y1, layer.y + layer.height);
+        active[i] = layer.data && lx0 < lx1 && ly0 < ly1 && hasContent(layer, lx0, ly0, lx1, ly1);
+    }
+
+    for (const Output& output : *m_outputs) {
+        for (int y = y0; y < y1; y++) {
+            memset(output.rgba + static_cast<size_t>(y) * output.rowStride + x0 * 4, 0, static_cast<size_t>(x1 - x0) * 4);
+        }
+
+        bool blended = false;
+        for (const LayerUse& use : output.layers) {
+            // Scaling a cleared tile leaves it cleared
+            if (use.blend == BlendMode::Scale) {
+                if (blended) {
+                    const float scale = std::clamp(use.opacity, 0.0f, 255.0f);
+                    for (int y = y0; y < y1; y++) {
+                        scaleRow(output.rgba + static_cast<size_t>(y) * output.rowStride + x0 * 4, x1 - x0, scale);
+                    }
+                }
+                continue;
+            }
+
+            if (use.layer < 0 || use.layer >= static_cast<int>(layers.size()) || !active[use.layer]) {
+                continue;
+            }
+
+            const Layer& layer = layers[use.layer];
+            const bool mask = layer.format == Format::Alpha8;
+            const int bpp = mask ? 1 : 4;
+
+            // Opacity scales all channels when adding, only alpha when blending over
+            Weights weights;
+            for (int c = 0; c < 4; c++) {
+                if (use.blend == BlendMode::Add) {
+                    weights.w[c] = toFixed(layer.tint[c] * use.opacity, 127.0f);
+                } else {
+                    weights.w[c] = toFixed(layer.tint[c] * (c == 3 ? use.opacity : 1.0f), 1.0f);
+                }
+            }
+
+            const int lx0 = std::max(x0, layer.x);
+            const int ly0 = std::max(y0, layer.y);
+            const int lx1 = std::min(x1, layer.x + layer.width);
+            const int ly1 = std::min(y1, layer.y + layer.height);
+            for (int y = ly0; y < ly1; y++) {
+                const uint8_t* src = layer.data + static_cast<size_t>(y - layer.y) * layer.rowStride + static_cast<size_t>(lx0 - layer.x) * bpp;
+                uint8_t* dst = output.rgba + static_cast<size_t>(y) * output.rowStride + lx0 * 4;
+                if (use.blend == BlendMode::Add) {
+                    blendRowAdd(src, mask, dst, lx1 - lx0, weights);
+                } else {
+                    blendRowOver(src, mask, dst, lx1 - lx0, weights);
+                }
+            }
+            blended = true;
+        }
+
+        if (!blended) {
+            m_skippedTiles++;
+        }
+    }
+}
+
+}  // namespace VarjoExamples
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Globals.hpp"
+
+namespace VarjoExamples
+{
+//! Multithreaded SIMD compositor building several RGBA8 overlay outputs from a shared list of layers in one pass.
+//!
+//! The output frame is processed in 64x64 tiles spread over worker threads. For each tile the compositor first
+//! finds which layers cover it with non-zero pixels, then blends those into every output that uses them. Tiles no
+//! output layer touches are only cleared. Channel order is whatever the layer data uses; byte 3 is alpha.
+class OverlayCompositor
+{
+public:
+    static constexpr int c_tileSize = 64;  //!< Tile width and height in pixels
+
+    //! Layer pixel format
+    enum class Format {
+        Rgba8,   //!< Four channels per pixel, multiplied by tint
+        Alpha8,  //!< One channel grayscale or alpha mask, colored with tint
+    };
+
+    //! Blend mode of layer in output
+    enum class BlendMode {
+        Add,    //!< Saturating add of all channels weighted in 8.8 fixed point rounding down, exact like cv2.add for opacity 1
+        Over,   //!< Source over blend by layer alpha
+        Scale,  //!< Output so far multiplied by opacity rounding to nearest, like cv2.addWeighted(out, opacity, 0, 0, 0). No layer.
+    };
+
+    //! Source layer placed in output frame
+    struct Layer {
+        const uint8_t* data = nullptr;  //!< Pixel data, top row first
+        int width = 0;                  //!< Width in pixels
+        int height = 0;                 //!< Height in pixels
+        int rowStride = 0;              //!< Row stride in bytes
+        Format format = Format::Rgba8;  //!< Pixel format
+        int x = 0;                      //!< Left edge in output, may be negative
+        int y = 0;                      //!< Top edge in output, may be negative
+        glm::vec4 tint = glm::vec4(1);  //!< Per channel multiplier, or mask color for Alpha8
+    };
+
+    //! Use of layer in output
+    struct LayerUse {
+        int layer = 0;                     //!< Layer index, unused by Scale
+        float opacity = 1.0f;              //!< Layer weight in this output, or output multiplier for Scale
+        BlendMode blend = BlendMode::Add;  //!< Blend mode
+    };
+
+    //! Output image. Layers are blended in order onto a cleared image.
+    struct Output {
+        uint8_t* rgba = nullptr;       //!< RGBA8 pixels of frame size
+        int rowStride = 0;             //!< Row stride in bytes
+        std::vector<LayerUse> layers;  //!< Layers to blend
+    };
+
+    //! Compositor configuration
+    struct Config {
+        int threadCount = 0;  //!< Threads including caller, 0 uses hardware concurrency
+    };
+
+    //! Compositing statistics of last call
+    struct Stats {
+        size_t tileCount = 0;     //!< Output tiles processed over all outputs
+        size_t skippedTiles = 0;  //!< Output tiles only cleared
+        double seconds = 0.0;     //!< Duration of composite call
+    };
+
+    //! Construct compositor with default configuration
+    OverlayCompositor();
+
+    //! Construct compositor with given configuration
+    OverlayCompositor(const Config& config);
+
+    //! Destruct compositor. Joins worker threads.
+    ~OverlayCompositor();
+
+    // Disable copy, move and assign
+    OverlayCompositor(const OverlayCompositor& other) = delete;
+    OverlayCompositor(const OverlayCompositor&& other) = delete;
+    OverlayCompositor& operator=(const OverlayCompositor& other) = delete;
+    OverlayCompositor& operator=(const OverlayCompositor&& other) = delete;
+
+    //! Composite layers into all outputs of given frame size. Blocks until done.
+    void composite(int width, int height, const std::vector<Layer>& layers, const std::vector<Output>& outputs);
+
+    //! Return statistics of last composite call
+    Stats getStats() const;
+
+private:
+    //! Worker main loop
+    void workerLoop();
+
+    //! Process tiles until none are left
+    void runTiles();
+
+    //! Composite single tile into all outputs
+    void compositeTile(int tile, std::vector<uint8_t>& active);
+
+private:
+    std::mutex m_callMutex;                   //!< Serializes composite calls
+    mutable std::mutex m_mutex;               //!< Lock for job state
+    std::condition_variable m_jobCondition;   //!< Signaled when a job starts or workers stop
+    std::condition_variable m_doneCondition;  //!< Signaled when a worker finishes job
+    std::vector<std::thread> m_workers;       //!< Worker threads
+    uint64_t m_generation = 0;                //!< Job generation counter
+    int m_busyWorkers = 0;                    //!< Workers still processing current job
+    bool m_stop = false;                      //!< Stop flag for workers
+
+    // Current job, written by composite() before workers are woken
+    int m_width = 0;                                 //!< Frame width
+    int m_height = 0;                                //!< Frame height
+    int m_tilesX = 0;                                //!< Tile grid width
+    int m_tileCount = 0;                             //!< Tile count
+    const std::vector<Layer>* m_layers = nullptr;    //!< Layers of job
+    const std::vector<Output>* m_outputs = nullptr;  //!< Outputs of job
+    std::atomic<int> m_nextTile{0};                  //!< Next tile to process
+    std::atomic<size_t> m_skippedTiles{0};           //!< Skipped output tiles of job
+    Stats m_stats;                                   //!< Statistics of last call
+};
+
+}  // namespace VarjoExamples
@@ -0,0 +1,234 @@
+#include "OverlaySequence.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+// Free cursors kept before the least recently used one is reused, covers playback plus prefetch workers
+constexpr size_t c_maxCursors = 4;
+
+}  // namespace
+
+namespace VarjoExamples
+{
+OverlaySequenceEncoder::OverlaySequenceEncoder(const Config& config)
+    : m_config(config)
+{
+}
+
+bool OverlaySequenceEncoder::encode(const uint8_t* rgba, int width, int height, int rowStride, std::vector<uint8_t>& out)
+{
+    // Reconstructed frames have fully transparent pixels cleared, deltas are taken against that
+    std::vector<uint8_t> current(static_cast<size_t>(width) * height * 4);
+    for (int y = 0; y < height; y++) {
+        const uint8_t* src = rgba + static_cast<size_t>(y) * rowStride;
+        uint8_t* dst = current.data() + static_cast<size_t>(y) * width * 4;
+        for (int x = 0; x < width; x++) {
+            if (src[x * 4 + 3]) {
+                memcpy(dst + x * 4, src + x * 4, 4);
+            } else {
+                memset(dst + x * 4, 0, 4);
+            }
+        }
+    }
+
+    bool keyframe = m_sinceKeyframe < 0 || m_sinceKeyframe + 1 >= m_config.keyframeInterval || width != m_width || height != m_height;
+    TiledOverlay overlay;
+    if (!keyframe) {
+        overlay = TiledOverlay::encodeDelta(current.data(), m_previous.data(), width, height, width * 4);
+        const double gridCount = static_cast<double>(overlay.getTilesX()) * overlay.getTilesY();
+        keyframe = static_cast<double>(overlay.getTileCount()) > m_config.maxDeltaRatio * gridCount;
+    }
+    if (keyframe) {
+        overlay = TiledOverlay::encode(current.data(), width, height, width * 4);
+        m_sinceKeyframe = 0;
+    } else {
+        m_sinceKeyframe++;
+    }
+
+    overlay.serialize(out);
+    m_previous.swap(current);
+    m_width = width;
+    m_height = height;
+    return keyframe;
+}
+
+std::unique_ptr<OverlaySequence> OverlaySequence::fromBundle(std::shared_ptr<const ReplayBundleReader> bundle, int track)
+{
+    if (!bundle || track < 0 || track >= static_cast<int>(bundle->getTracks().size())) {
+        return nullptr;
+    }
+
+    auto sequence = std::make_unique<OverlaySequence>();
+    const auto& info = bundle->getTracks()[track];
+    std::lock_guard<std::mutex> lock(sequence->m_mutex);
+    for (size_t i = 0; i < info.entryCount; i++) {
+        const auto view = bundle->getFrame(track, info.entries[i].frameIndex);
+        if (!sequence->appendEntry(info.entries[i].frameIndex, view.data, view.size)) {
+            LOG_ERROR("Invalid overlay frame %lld in track: %s", static_cast<long long>(info.entries[i].frameIndex), info.name.c_str());
+            return nullptr;
+        }
+    }
+    sequence->m_owner = std::move(bundle);
+    return sequence;
+}
+
+bool OverlaySequence::append(OverlaySequenceEncoder& encoder, int64_t frameIndex, const uint8_t* rgba, int width, int height, int rowStride)
+{
+    std::vector<uint8_t> data;
+    encoder.encode(rgba, width, height, rowStride, data);
+    return append(frameIndex, data.data(), data.size());
+}
+
+bool OverlaySequence::append(int64_t frameIndex, const uint8_t* data, size_t size)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_storage.emplace_back(data, data + size);
+    if (!appendEntry(frameIndex, m_storage.back().data(), size)) {
+        m_storage.pop_back();
+        return false;
+    }
+    return true;
+}
+
+bool OverlaySequence::appendEntry(int64_t frameIndex, const uint8_t* data, size_t size)
+{
+    Entry entry;
+    int width = 0;
+    int height = 0;
+    bool delta = false;
+    if (!TiledOverlay::readHeader(data, size, width, height, delta) || (delta && m_entries.empty()) ||
+        (!m_entries.empty() && frameIndex <= m_entries.back().frameIndex)) {
+        return false;
+    }
+
+    entry.frameIndex = frameIndex;
+    entry.data = data;
+    entry.size = size;
+    entry.keyframe = !delta;
+    m_entries.push_back(entry);
+
+    m_stats.frameCount++;
+    m_stats.keyframeCount += entry.keyframe ? 1 : 0;
+    m_stats.byteSize += size;
+    return true;
+}
+
+bool OverlaySequence::decode(int64_t frameIndex, int& outWidth, int& outHeight, std::vector<uint8_t>& outPixels)
+{
+    // Reserve a cursor and copy the entries to apply under lock, then decode without it so that decoders run in parallel
+    Cursor* cursor = nullptr;
+    std::vector<Entry> entries;
+    size_t target = 0;
+    bool restart = false;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        const auto it = std::lower_bound(
+            m_entries.begin(), m_entries.end(), frameIndex, [](const Entry& entry, int64_t index) { return entry.frameIndex < index; });
+        if (it == m_entries.end() || it->frameIndex != frameIndex) {
+            return false;
+        }
+        target = static_cast<size_t>(it - m_entries.begin());
+
+        size_t keyframe = target;
+        while (!m_entries[keyframe].keyframe) {
+            keyframe--;
+        }
+
+        // Continue from cursor if it lies between keyframe and target, otherwise restart from keyframe
+        cursor = acquireCursor(keyframe, target);
+        restart = cursor->position == SIZE_MAX || cursor->position < keyframe || cursor->position > target;
+        const size_t first = restart ? keyframe : cursor->position + 1;
+        entries.assign(m_entries.begin() + first, m_entries.begin() + target + 1);
+        if (restart) {
+            m_stats.keyframeDecodes++;
+        }
+    }
+
+    bool decoded = true;
+    uint64_t deltas = 0;
+    for (size_t i = 0; i < entries.size() && decoded; i++) {
+        TiledOverlay overlay;
+        const Entry& entry = entries[i];
+        if (restart && i == 0) {
+            decoded = overlay.deserialize(entry.data, entry.size);
+            if (decoded) {
+                cursor->width = overlay.getWidth();
+                cursor->height = overlay.getHeight();
+                cursor->pixels.resize(static_cast<size_t>(cursor->width) * cursor->height * 4);
+                decoded = overlay.decode(cursor->pixels.data(), cursor->width * 4);
+            }
+            continue;
+        }
+
+        decoded = overlay.deserialize(entry.data, entry.size) && overlay.getWidth() == cursor->width && overlay.getHeight() == cursor->height &&
+                  overlay.applyDelta(cursor->pixels.data(), cursor->width * 4);
+        if (!decoded) {
+            LOG_ERROR("Invalid overlay delta for frame %lld", static_cast<long long>(entry.frameIndex));
+        }
+        deltas += decoded ? 1 : 0;
+    }
+    if (decoded) {
+        outWidth = cursor->width;
+        outHeight = cursor->height;
+        outPixels = cursor->pixels;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    cursor->position = decoded ? target : SIZE_MAX;
+    cursor->busy = false;
+    m_stats.deltasApplied += deltas;
+    return decoded;
+}
+
+OverlaySequence::Cursor* OverlaySequence::acquireCursor(size_t keyframe, size_t target)
+{
+    Cursor* closest = nullptr;
+    Cursor* oldest = nullptr;
+    for (const auto& cursor : m_cursors) {
+        if (cursor->busy) {
+            continue;
+        }
+        if (cursor->position != SIZE_MAX && cursor->position >= keyframe && cursor->position <= target &&
+            (!closest || cursor->position > closest->position)) {
+            closest = cursor.get();
+        }
+        if (!oldest || cursor->lastUse < oldest->lastUse) {
+            oldest = cursor.get();
+        }
+    }
+
+    // Start a new cursor rather than move one that another reader is advancing, unless enough are kept already
+    Cursor* cursor = closest;
+    if (!cursor && oldest && m_cursors.size() >= c_maxCursors) {
+        cursor = oldest;
+    }
+    if (!cursor) {
+        m_cursors.push_back(std::make_unique<Cursor>());
+        cursor = m_cursors.back().get();
+    }
+    cursor->busy = true;
+    cursor->lastUse = ++m_cursorUses;
+    return cursor;
+}
+
+bool OverlaySequence::getFrameRange(int64_t& outFirst, int64_t& outLast) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_entries.empty()) {
+        return false;
+    }
+    outFirst = m_entries.front().frameIndex;
+    outLast = m_entries.back().frameIndex;
+    return true;
+}
+
+OverlaySequence::Stats OverlaySequence::getStats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+}  // namespace VarjoExamples
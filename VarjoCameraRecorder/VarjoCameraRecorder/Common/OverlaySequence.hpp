@@ -0,0 +1,123 @@
+#pragma once
+
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "Globals.hpp"
+#include "ReplayBundle.hpp"
+#include "TiledOverlay.hpp"
+
+namespace VarjoExamples
+{
+//! Encoder turning consecutive overlay frames of one track into periodic keyframes and tile XOR deltas.
+class OverlaySequenceEncoder
+{
+public:
+    //! Encoder configuration
+    struct Config {
+        int keyframeInterval = 30;   //!< Maximum frames from keyframe to next keyframe
+        double maxDeltaRatio = 0.5;  //!< Encode keyframe instead if larger fraction of tiles changed
+    };
+
+    //! Construct encoder with default configuration
+    OverlaySequenceEncoder() = default;
+
+    //! Construct encoder with given configuration
+    OverlaySequenceEncoder(const Config& config);
+
+    //! Encode next RGBA8 frame and append serialized overlay to buffer. Returns true if a keyframe was written.
+    bool encode(const uint8_t* rgba, int width, int height, int rowStride, std::vector<uint8_t>& out);
+
+    //! Make next frame a keyframe, e.g. after skipping frames
+    void reset() { m_sinceKeyframe = -1; }
+
+private:
+    Config m_config;                  //!< Encoder configuration
+    std::vector<uint8_t> m_previous;  //!< Previous frame as decoders reconstruct it, tightly packed
+    int m_width = 0;                  //!< Previous frame width
+    int m_height = 0;                 //!< Previous frame height
+    int m_sinceKeyframe = -1;         //!< Frames since last keyframe, -1 forces keyframe
+};
+
+//! Random access over keyframe and delta overlay sequence held in RAM or in a mapped replay bundle.
+//!
+//! Decoding a frame starts from the nearest preceding keyframe and applies deltas forward. Reconstructed frames are
+//! kept as cursors, one per concurrent decoder, so sequential playback costs one delta per frame even while other
+//! threads prefetch elsewhere. Thread safe, decoding runs outside the lock.
+class OverlaySequence
+{
+public:
+    //! Sequence statistics
+    struct Stats {
+        size_t frameCount = 0;         //!< Frames in sequence
+        size_t keyframeCount = 0;      //!< Keyframes in sequence
+        size_t byteSize = 0;           //!< Serialized size of all frames in bytes
+        uint64_t keyframeDecodes = 0;  //!< Times decoding restarted from keyframe
+        uint64_t deltasApplied = 0;    //!< Delta frames applied
+    };
+
+    //! Construct empty sequence
+    OverlaySequence() = default;
+
+    // Disable copy, move and assign
+    OverlaySequence(const OverlaySequence& other) = delete;
+    OverlaySequence(const OverlaySequence&& other) = delete;
+    OverlaySequence& operator=(const OverlaySequence& other) = delete;
+    OverlaySequence& operator=(const OverlaySequence&& other) = delete;
+
+    //! Create sequence referencing overlay track of replay bundle. Sequence keeps the bundle open. Returns nullptr on failure.
+    static std::unique_ptr<OverlaySequence> fromBundle(std::shared_ptr<const ReplayBundleReader> bundle, int track);
+
+    //! Encode RGBA8 frame and append it. Frame indices must ascend.
+    bool append(OverlaySequenceEncoder& encoder, int64_t frameIndex, const uint8_t* rgba, int width, int height, int rowStride);
+
+    //! Append copy of serialized keyframe or delta. Frame indices must ascend and the first frame must be a keyframe.
+    bool append(int64_t frameIndex, const uint8_t* data, size_t size);
+
+    //! Decode frame to tightly packed RGBA8
+    bool decode(int64_t frameIndex, int& outWidth, int& outHeight, std::vector<uint8_t>& outPixels);
+
+    //! Return first and last frame index. Returns false if sequence is empty.
+    bool getFrameRange(int64_t& outFirst, int64_t& outLast) const;
+
+    //! Return sequence statistics
+    Stats getStats() const;
+
+private:
+    //! Serialized frame
+    struct Entry {
+        int64_t frameIndex = 0;         //!< Frame index
+        const uint8_t* data = nullptr;  //!< Serialized overlay
+        size_t size = 0;                //!< Serialized size
+        bool keyframe = false;          //!< True if frame is a keyframe
+    };
+
+    //! Last reconstructed frame of one decoder
+    struct Cursor {
+        std::vector<uint8_t> pixels;  //!< Reconstructed frame, tightly packed
+        int width = 0;                //!< Reconstructed frame width
+        int height = 0;               //!< Reconstructed frame height
+        size_t position = SIZE_MAX;   //!< Entry of reconstructed frame, SIZE_MAX if none
+        uint64_t lastUse = 0;         //!< Use counter value when last acquired
+        bool busy = false;            //!< True while a decode runs on the cursor
+    };
+
+    //! Append frame referencing data owned elsewhere. Requires lock.
+    bool appendEntry(int64_t frameIndex, const uint8_t* data, size_t size);
+
+    //! Reserve cursor for decoding entries from keyframe to target, preferring one already between them. Requires lock.
+    Cursor* acquireCursor(size_t keyframe, size_t target);
+
+private:
+    mutable std::mutex m_mutex;                      //!< Lock for sequence state
+    std::vector<Entry> m_entries;                    //!< Frames by ascending index
+    std::deque<std::vector<uint8_t>> m_storage;      //!< Owned frame data of appended frames
+    std::shared_ptr<const void> m_owner;             //!< Keeps referenced frame data alive
+    std::vector<std::unique_ptr<Cursor>> m_cursors;  //!< Decoding cursors, about one per concurrent decoder
+    uint64_t m_cursorUses = 0;                       //!< Cursor use counter for least recently used reuse
+    Stats m_stats;                                   //!< Sequence statistics
+};
+
+}  // namespace VarjoExamples
@@ -0,0 +1,134 @@
+#include "PolylineRasterizer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace VarjoExamples
+{
+PolylineRasterizer::PolylineRasterizer(int width, int height, float lineWidth)
+    : m_width(std::max(width, 0))
+    , m_height(std::max(height, 0))
+    , m_pixels(static_cast<size_t>(m_width) * m_height * 4, 0)
+{
+    setLineWidth(lineWidth);
+}
+
+void PolylineRasterizer::clear()
+{
+    // Only the drawn area can be non-zero
+    if (m_bounds.z > m_bounds.x) {
+        for (int y = m_bounds.y; y < m_bounds.w; y++) {
+            memset(&m_pixels[(static_cast<size_t>(y) * m_width + m_bounds.x) * 4], 0, static_cast<size_t>(m_bounds.z - m_bounds.x) * 4);
+        }
+        growBox(m_dirty, m_bounds);
+    }
+    m_bounds = glm::ivec4(0);
+    m_hasLast = false;
+}
+
+void PolylineRasterizer::draw(const std::vector<Vertex>& vertices)
+{
+    endPolyline();
+    for (const auto& vertex : vertices) {
+        append(vertex);
+    }
+    endPolyline();
+}
+
+void PolylineRasterizer::append(const Vertex& vertex)
+{
+    drawSegment(m_hasLast ? m_last : vertex, vertex);
+    m_last = vertex;
+    m_hasLast = true;
+}
+
+glm::ivec4 PolylineRasterizer::takeDirtyRect()
+{
+    const glm::ivec4 dirty = m_dirty;
+    m_dirty = glm::ivec4(0);
+    return dirty;
+}
+
+OverlayCompositor::Layer PolylineRasterizer::getLayer() const
+{
+    OverlayCompositor::Layer layer;
+    layer.data = m_pixels.data();
+    layer.width = m_width;
+    layer.height = m_height;
+    layer.rowStride = getRowStride();
+    layer.format = OverlayCompositor::Format::Rgba8;
+    return layer;
+}
+
+void PolylineRasterizer::drawSegment(const Vertex& a, const Vertex& b)
+{
+    // Coverage falls from 1 to 0 over one pixel centered on the capsule edge
+    const float reach = m_radius + 0.5f;
+    const glm::vec2 p0 = a.position;
+    const glm::vec2 d = b.position - a.position;
+    const float lengthSq = glm::dot(d, d);
+
+    const int y0 = std::max(static_cast<int>(std::floor(std::min(p0.y, b.position.y) - reach)), 0);
+    const int y1 = std::min(static_cast<int>(std::ceil(std::max(p0.y, b.position.y) + reach)), m_height);
+    if (y0 >= y1 || reach <= 0.5f) {
+        return;
+    }
+
+    glm::ivec4 drawn(INT32_MAX, INT32_MAX, INT32_MIN, INT32_MIN);
+    for (int y = y0; y < y1; y++) {
+        const float py = static_cast<float>(y) + 0.5f;
+
+        // Horizontal span of capsule on this row: segment part within reach vertically, grown by reach
+        float t0 = 0.0f;
+        float t1 = 1.0f;
+        if (std::abs(d.y) > 1e-6f) {
+            t0 = std::clamp((py - reach - p0.y) / d.y, 0.0f, 1.0f);
+            t1 = std::clamp((py + reach - p0.y) / d.y, 0.0f, 1.0f);
+        }
+        const float sx0 = p0.x + d.x * t0;
+        const float sx1 = p0.x + d.x * t1;
+        const int x0 = std::max(static_cast<int>(std::floor(std::min(sx0, sx1) - reach)), 0);
+        const int x1 = std::min(static_cast<int>(std::ceil(std::max(sx0, sx1) + reach)), m_width);
+
+        uint8_t* row = &m_pixels[static_cast<size_t>(y) * m_width * 4];
+        for (int x = x0; x < x1; x++) {
+            const glm::vec2 p(static_cast<float>(x) + 0.5f, py);
+            const float t = lengthSq > 0.0f ? std::clamp(glm::dot(p - p0, d) / lengthSq, 0.0f, 1.0f) : 0.0f;
+            const float distance = glm::length(p - (p0 + d * t));
+            const float coverage = std::clamp(reach - distance, 0.0f, 1.0f);
+            if (coverage <= 0.0f) {
+                continue;
+            }
+
+            const glm::vec4 color = glm::mix(a.color, b.color, t);
+            const int alpha = static_cast<int>(std::clamp(color.a, 0.0f, 1.0f) * coverage * 255.0f + 0.5f);
+            uint8_t* pixel = row + x * 4;
+            if (alpha <= pixel[3]) {
+                continue;
+            }
+
+            pixel[0] = static_cast<uint8_t>(std::clamp(color.r, 0.0f, 1.0f) * 255.0f + 0.5f);
+            pixel[1] = static_cast<uint8_t>(std::clamp(color.g, 0.0f, 1.0f) * 255.0f + 0.5f);
+            pixel[2] = static_cast<uint8_t>(std::clamp(color.b, 0.0f, 1.0f) * 255.0f + 0.5f);
+            pixel[3] = static_cast<uint8_t>(alpha);
+            drawn = glm::ivec4(std::min(drawn.x, x), std::min(drawn.y, y), std::max(drawn.z, x + 1), std::max(drawn.w, y + 1));
+        }
+    }
+
+    if (drawn.x < drawn.z) {
+        growBox(m_bounds, drawn);
+        growBox(m_dirty, drawn);
+    }
+}
+
+void PolylineRasterizer::growBox(glm::ivec4& box, const glm::ivec4& add)
+{
+    if (box.z <= box.x) {
+        box = add;
+    } else {
+        box = glm::ivec4(std::min(box.x, add.x), std::min(box.y, add.y), std::max(box.z, add.z), std::max(box.w, add.w));
+    }
+}
+
+}  // namespace VarjoExamples
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include "Globals.hpp"
+#include "OverlayCompositor.hpp"
+
+namespace VarjoExamples
+{
+//! Anti-aliased polyline rasterizer drawing motion lines into a persistent RGBA8 layer.
+//!
+//! Each segment is rasterized as a capsule, which gives round joins and caps, with coverage from the exact distance
+//! to the segment and color interpolated between its vertices. Overlapping strokes keep the larger alpha instead of
+//! blending, so joins of translucent lines do not darken. Appending a vertex rasterizes only the new segment, so a
+//! growing trajectory costs one segment per frame. The layer can be passed to OverlayCompositor as is.
+class PolylineRasterizer
+{
+public:
+    //! Polyline vertex
+    struct Vertex {
+        glm::vec2 position = glm::vec2(0.0f);  //!< Position in pixels
+        glm::vec4 color = glm::vec4(1.0f);     //!< Color and alpha in [0, 1], in channel order of layer
+    };
+
+    //! Construct rasterizer with layer size and line width in pixels
+    PolylineRasterizer(int width, int height, float lineWidth);
+
+    //! Clear layer and end current polyline
+    void clear();
+
+    //! Draw complete polyline on top of layer. Ends current polyline.
+    void draw(const std::vector<Vertex>& vertices);
+
+    //! Extend current polyline with segment to vertex. First vertex of a polyline draws a dot.
+    void append(const Vertex& vertex);
+
+    //! End current polyline. Next append starts a new one.
+    void endPolyline() { m_hasLast = false; }
+
+    //! Set line width for subsequent segments
+    void setLineWidth(float lineWidth) { m_radius = std::max(lineWidth, 0.0f) * 0.5f; }
+
+    //! Return layer pixels, straight alpha RGBA8
+    const uint8_t* getData() const { return m_pixels.data(); }
+
+    //! Return layer row stride in bytes
+    int getRowStride() const { return m_width * 4; }
+
+    //! Return layer width
+    int getWidth() const { return m_width; }
+
+    //! Return layer height
+    int getHeight() const { return m_height; }
+
+    //! Return bounding box of drawn pixels (x0, y0, x1, y1), exclusive max. Empty layer returns zero box.
+    glm::ivec4 getBounds() const { return m_bounds; }
+
+    //! Return box changed since previous call and reset it, for sub-rect uploads. Returns zero box if unchanged.
+    glm::ivec4 takeDirtyRect();
+
+    //! Return compositor layer referencing layer pixels
+    OverlayCompositor::Layer getLayer() const;
+
+private:
+    //! Rasterize capsule from a to b
+    void drawSegment(const Vertex& a, const Vertex& b);
+
+    //! Grow box to contain given box
+    static void growBox(glm::ivec4& box, const glm::ivec4& add);
+
+private:
+    int m_width = 0;                //!< Layer width
+    int m_height = 0;               //!< Layer height
+    float m_radius = 0.0f;          //!< Half line width
+    std::vector<uint8_t> m_pixels;  //!< Layer pixels
+    glm::ivec4 m_bounds{0};         //!< Bounds of drawn pixels
+    glm::ivec4 m_dirty{0};          //!< Changed box since last takeDirtyRect()
+    Vertex m_last;                  //!< Last vertex of current polyline
+    bool m_hasLast = false;         //!< True if current polyline has a vertex
+};
+
+}  // namespace VarjoExamples
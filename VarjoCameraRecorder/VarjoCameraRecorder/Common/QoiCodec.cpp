@@ -0,0 +1,175 @@
+#include "QoiCodec.hpp"
+
+#include <cstring>
+
+namespace
+{
+// QOI ops
+constexpr uint8_t c_opIndex = 0x00;
+constexpr uint8_t c_opDiff = 0x40;
+constexpr uint8_t c_opLuma = 0x80;
+constexpr uint8_t c_opRun = 0xc0;
+constexpr uint8_t c_opRgb = 0xfe;
+constexpr uint8_t c_opRgba = 0xff;
+constexpr uint8_t c_opMask = 0xc0;
+constexpr int c_maxRun = 62;
+
+// Load pixel, three channel pixels are opaque
+inline uint32_t loadPixel(const uint8_t* p, int channels)
+{
+    if (channels == 4) {
+        uint32_t v;
+        memcpy(&v, p, sizeof(v));
+        return v;
+    }
+    return p[0] | (p[1] << 8) | (p[2] << 16) | 0xff000000u;
+}
+
+inline void storePixel(uint8_t* p, uint32_t v, int channels)
+{
+    if (channels == 4) {
+        memcpy(p, &v, sizeof(v));
+    } else {
+        p[0] = static_cast<uint8_t>(v);
+        p[1] = static_cast<uint8_t>(v >> 8);
+        p[2] = static_cast<uint8_t>(v >> 16);
+    }
+}
+
+inline int qoiHash(uint32_t v)
+{
+    const uint32_t r = v & 0xff, g = (v >> 8) & 0xff, b = (v >> 16) & 0xff, a = v >> 24;
+    return static_cast<int>((r * 3 + g * 5 + b * 7 + a * 11) & 63);
+}
+
+}  // namespace
+
+namespace VarjoExamples
+{
+void encodeQoi(const uint8_t* pixels, int width, int height, int rowStride, int channels, bool clearTransparent,
+    std::vector<uint8_t>& out)
+{
+    uint32_t index[64] = {};
+    uint32_t prev = 0;
+    int run = 0;
+
+    for (int y = 0; y < height; y++) {
+        const uint8_t* row = pixels + static_cast<size_t>(y) * rowStride;
+        for (int x = 0; x < width; x++) {
+            uint32_t px = loadPixel(row + x * channels, channels);
+            if (clearTransparent && !(px & 0xff000000u)) {
+                px = 0;
+            }
+            if (px == prev) {
+                if (++run == c_maxRun) {
+                    out.push_back(static_cast<uint8_t>(c_opRun | (run - 1)));
+                    run = 0;
+                }
+                continue;
+            }
+
+            if (run > 0) {
+                out.push_back(static_cast<uint8_t>(c_opRun | (run - 1)));
+                run = 0;
+            }
+
+            const int hash = qoiHash(px);
+            if (index[hash] == px) {
+                out.push_back(static_cast<uint8_t>(c_opIndex | hash));
+            } else {
+                index[hash] = px;
+                if ((px >> 24) == (prev >> 24)) {
+                    const int dr = static_cast<int8_t>((px & 0xff) - (prev & 0xff));
+                    const int dg = static_cast<int8_t>(((px >> 8) & 0xff) - ((prev >> 8) & 0xff));
+                    const int db = static_cast<int8_t>(((px >> 16) & 0xff) - ((prev >> 16) & 0xff));
+                    const int drg = dr - dg;
+                    const int dbg = db - dg;
+                    if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1) {
+                        out.push_back(static_cast<uint8_t>(c_opDiff | ((dr + 2) << 4) | ((dg + 2) << 2) | (db + 2)));
+                    } else if (dg >= -32 && dg <= 31 && drg >= -8 && drg <= 7 && dbg >= -8 && dbg <= 7) {
+                        out.push_back(static_cast<uint8_t>(c_opLuma | (dg + 32)));
+                        out.push_back(static_cast<uint8_t>(((drg + 8) << 4) | (dbg + 8)));
+                    } else {
+                        out.push_back(c_opRgb);
+                        out.push_back(static_cast<uint8_t>(px));
+                        out.push_back(static_cast<uint8_t>(px >> 8));
+                        out.push_back(static_cast<uint8_t>(px >> 16));
+                    }
+                } else {
+                    out.push_back(c_opRgba);
+                    out.push_back(static_cast<uint8_t>(px));
+                    out.push_back(static_cast<uint8_t>(px >> 8));
+                    out.push_back(static_cast<uint8_t>(px >> 16));
+                    out.push_back(static_cast<uint8_t>(px >> 24));
+                }
+            }
+            prev = px;
+        }
+    }
+
+    if (run > 0) {
+        out.push_back(static_cast<uint8_t>(c_opRun | (run - 1)));
+    }
+}
+
+bool decodeQoi(const uint8_t* data, size_t size, uint8_t* pixels, int width, int height, int rowStride, int channels)
+{
+    uint32_t index[64] = {};
+    uint32_t px = 0;
+    int run = 0;
+    const uint8_t* p = data;
+    const uint8_t* end = data + size;
+
+    for (int y = 0; y < height; y++) {
+        uint8_t* row = pixels + static_cast<size_t>(y) * rowStride;
+        for (int x = 0; x < width; x++) {
+            if (run > 0) {
+                run--;
+            } else {
+                if (p >= end) {
+                    return false;
+                }
+                const uint8_t op = *p++;
+                if (op == c_opRgb) {
+                    if (end - p < 3) {
+                        return false;
+                    }
+                    px = (px & 0xff000000u) | p[0] | (p[1] << 8) | (p[2] << 16);
+                    p += 3;
+                } else if (op == c_opRgba) {
+                    if (end - p < 4) {
+                        return false;
+                    }
+                    px = p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24);
+                    p += 4;
+                } else if ((op & c_opMask) == c_opIndex) {
+                    px = index[op];
+                } else if ((op & c_opMask) == c_opDiff) {
+                    const uint32_t r = ((px & 0xff) + ((op >> 4) & 3) - 2) & 0xff;
+                    const uint32_t g = (((px >> 8) & 0xff) + ((op >> 2) & 3) - 2) & 0xff;
+                    const uint32_t b = (((px >> 16) & 0xff) + (op & 3) - 2) & 0xff;
+                    px = (px & 0xff000000u) | r | (g << 8) | (b << 16);
+                } else if ((op & c_opMask) == c_opLuma) {
+                    if (p >= end) {
+                        return false;
+                    }
+                    const int dg = (op & 0x3f) - 32;
+                    const int drg = (*p >> 4) - 8;
+                    const int dbg = (*p & 0x0f) - 8;
+                    p++;
+                    const uint32_t r = ((px & 0xff) + dg + drg) & 0xff;
+                    const uint32_t g = (((px >> 8) & 0xff) + dg) & 0xff;
+                    const uint32_t b = (((px >> 16) & 0xff) + dg + dbg) & 0xff;
+                    px = (px & 0xff000000u) | r | (g << 8) | (b << 16);
+                } else {
+                    run = op & 0x3f;
+                }
+                index[qoiHash(px)] = px;
+            }
+            storePixel(row + x * channels, px, channels);
+        }
+    }
+    return true;
+}
+
+}  // namespace VarjoExamples
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace VarjoExamples
+{
+//! Headerless QOI image streams, used for overlay tiles and spilled frames.
+//!
+//! Streams carry no size or channel count; the caller stores those. The previous pixel starts as transparent
+//! black so that transparent areas collapse into runs. Three channel pixels are encoded as opaque.
+
+//! Append QOI stream of width x height pixels with 3 or 4 channels. If clearTransparent is set, pixels with zero
+//! alpha are encoded as zero.
+void encodeQoi(const uint8_t* pixels, int width, int height, int rowStride, int channels, bool clearTransparent,
+    std::vector<uint8_t>& out);
+
+//! Decode QOI stream of width x height pixels with 3 or 4 channels. Returns false if stream is truncated.
+bool decodeQoi(const uint8_t* data, size_t size, uint8_t* pixels, int width, int height, int rowStride, int channels);
+
+}  // namespace VarjoExamples
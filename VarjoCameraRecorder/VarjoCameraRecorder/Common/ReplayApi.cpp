@@ -0,0 +1,2084 @@
+#define REPLAY_API_EXPORTS
+#include "ReplayApi.h"
+
+#if defined(_WIN32)
+#include <d3d11.h>
+#endif
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <limits>
+#include <mutex>
+#include <unordered_map>
+
+#include "BatchScheduler.hpp"
+#include "CaptureBenchmark.hpp"
+#include "ChangeIndex.hpp"
+#include "ClipBuffer.hpp"
+#include "FovealCapture.hpp"
+#include "FrameCache.hpp"
+#include "FrameStore.hpp"
+#include "FrameTrace.hpp"
+#include "FramingBenchmark.hpp"
+#include "GazeRecorder.hpp"
+#include "KeyframeDatabase.hpp"
+#include "MaskStore.hpp"
+#include "MessageFraming.hpp"
+#include "MultiplexConnection.hpp"
+#include "OverlayCompositor.hpp"
+#include "OverlaySequence.hpp"
+#include "PolylineRasterizer.hpp"
+#include "ReplayBundle.hpp"
+#include "SphericalStabilizer.hpp"
+#include "TiledOverlay.hpp"
+#include "TrajectoryStore.hpp"
+#include "WorkQueue.hpp"
+
+using namespace VarjoExamples;
+
+// Opaque handle wraps the C++ object
+struct rr_FrameCache {
+    std::unique_ptr<FrameCache> cache;
+};
+
+struct rr_Connection {
+    std::unique_ptr<MessageConnection> connection;
+};
+
+struct rr_Listener {
+    std::unique_ptr<MessageListener> listener;
+};
+
+// Received messages are queued per channel for polling from Unity update loop or blocking receives
+struct rr_Multiplex {
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::array<std::deque<Message>, MultiplexConnection::c_channelCount> received;
+    std::unique_ptr<MultiplexConnection> connection;
+};
+
+// Overlay tracks are delta encoded per track in write order
+struct rr_BundleWriter {
+    struct OverlayTrack {
+        OverlaySequenceEncoder encoder;
+        int64_t lastFrame = INT64_MIN;
+    };
+
+    ReplayBundleWriter writer;
+    std::mutex mutex;
+    std::unordered_map<int32_t, OverlayTrack> overlayTracks;
+};
+
+// Shared so that frame caches created from the bundle keep the mapping alive
+struct rr_Bundle {
+    std::shared_ptr<ReplayBundleReader> reader;
+    std::mutex mutex;
+    std::unordered_map<int32_t, std::unique_ptr<OverlaySequence>> overlaySequences;  // Delta resolution per track, created on use
+};
+
+struct rr_Overlay {
+    TiledOverlay overlay;
+};
+
+struct rr_FovealFrame {
+    FovealFrame frame;
+};
+
+struct rr_GazeRecorder {
+    std::unique_ptr<GazeRecorder> recorder;
+};
+
+struct rr_KeyframeDatabase {
+    std::unique_ptr<KeyframeDatabase> database;
+};
+
+struct rr_Compositor {
+    std::unique_ptr<OverlayCompositor> compositor;
+};
+
+struct rr_Polyline {
+    std::unique_ptr<PolylineRasterizer> rasterizer;
+};
+
+struct rr_FrameStore {
+    std::unique_ptr<FrameStore> store;
+};
+
+struct rr_WorkQueue {
+    std::unique_ptr<WorkQueue> queue;
+};
+
+struct rr_ClipBuffer {
+    std::unique_ptr<ClipBuffer> buffer;
+};
+
+// Acquired batches are kept until completion so their id arrays stay valid
+struct rr_BatchScheduler {
+    std::unique_ptr<BatchScheduler> scheduler;
+    std::mutex mutex;
+    std::unordered_map<uint64_t, BatchScheduler::Batch> batches;
+};
+
+struct rr_LatencyCollector {
+    std::unique_ptr<LatencyCollector> collector;
+};
+
+struct rr_SphericalStabilizer {
+    std::unique_ptr<SphericalStabilizer> stabilizer;
+};
+
+struct rr_ChangeIndex {
+    std::unique_ptr<ChangeIndex> index;
+};
+
+struct rr_TrajectoryStore {
+    TrajectoryStore store;
+};
+
+struct rr_MaskStore {
+    MaskStore store;
+    int32_t width = 0;
+    int32_t height = 0;
+};
+
+namespace
+{
+// Copy keyframe to API struct
+void toApiKeyframe(const KeyframeDatabase::Keyframe& keyframe, rr_Keyframe& out)
+{
+    out.id = keyframe.id;
+    out.time = keyframe.time;
+    std::copy(keyframe.hmdPose.value, keyframe.hmdPose.value + 16, out.hmdPose);
+    out.frame = keyframe.frame;
+}
+
+#if defined(_WIN32)
+// Overlay sub-rect upload queued on the Unity main thread for its render thread
+struct OverlayUpload {
+    TiledOverlay overlay;            // Overlay to upload
+    TiledOverlay previous;           // Overlay the texture holds, empty if unknown
+    ComPtr<ID3D11Resource> texture;  // Target texture, referenced until uploaded
+};
+
+std::mutex g_overlayUploadMutex;
+std::vector<OverlayUpload> g_overlayUploads;
+
+// Unity render event running queued overlay uploads with the immediate context of the texture device
+void __stdcall runOverlayUploads(int32_t /*eventId*/)
+{
+    std::vector<OverlayUpload> uploads;
+    {
+        std::lock_guard<std::mutex> lock(g_overlayUploadMutex);
+        uploads.swap(g_overlayUploads);
+    }
+
+    for (const auto& upload : uploads) {
+        ComPtr<ID3D11Device> device;
+        upload.texture->GetDevice(&device);
+        ComPtr<ID3D11DeviceContext> context;
+        device->GetImmediateContext(&context);
+        const TiledOverlay* previous = upload.previous.getWidth() > 0 ? &upload.previous : nullptr;
+        if (!upload.overlay.upload(context.Get(), upload.texture.Get(), previous, true)) {
+            LOG_WARNING("Uploading overlay failed.");
+        }
+    }
+}
+#endif
+
+// Return handler queueing received messages of multiplexed connection
+MultiplexConnection::Handler queueMultiplexed(rr_Multiplex* multiplex)
+{
+    return [multiplex](MultiplexConnection::Channel channel, Message& message) {
+        {
+            std::lock_guard<std::mutex> lock(multiplex->mutex);
+            multiplex->received[static_cast<size_t>(channel)].push_back(std::move(message));
+        }
+        multiplex->condition.notify_all();
+    };
+}
+
+// Hand received message over to API struct. Heap allocated buffer reference keeps the payload alive across the C
+// boundary until rr_MessageRelease.
+void toApiMessage(Message& message, rr_Message& out)
+{
+    out.data = message.data();
+    out.size = static_cast<int64_t>(message.size);
+    out.sequence = message.sequence;
+    out.type = message.type;
+    out.token = new BufferPool::Buffer(std::move(message.buffer));
+}
+
+// Copy column major pose array to Varjo matrix
+varjo_Matrix toVarjoPose(const double* pose)
+{
+    varjo_Matrix matrix;
+    std::copy(pose, pose + 16, matrix.value);
+    return matrix;
+}
+
+}  // namespace
+
+extern "C" {
+
+rr_FrameCache* rr_FrameCacheCreate(const char* pathFormat, int64_t budgetBytes, int32_t workerCount, int32_t prefetchDepth)
+{
+    if (!pathFormat || budgetBytes <= 0) {
+        return nullptr;
+    }
+
+    try {
+        auto handle = std::make_unique<rr_FrameCache>();
+        handle->cache =
+            std::make_unique<FrameCache>(FrameCache::createFileDecoder(pathFormat), static_cast<size_t>(budgetBytes), workerCount, prefetchDepth);
+        return handle.release();
+    } catch (const std::exception& e) {
+        LOG_ERROR("Creating frame cache failed: %s", e.what());
+        return nullptr;
+    }
+}
+
+void rr_FrameCacheDestroy(rr_FrameCache* cache) { delete cache; }
+
+void rr_FrameCacheSetRange(rr_FrameCache* cache, int64_t first, int64_t last)
+{
+    if (cache) {
+        cache->cache->setFrameRange(first, last);
+    }
+}
+
+int32_t rr_FrameCacheAcquire(rr_FrameCache* cache, int64_t index, rr_PinnedFrame* outFrame)
+{
+    if (!cache || !outFrame) {
+        return 0;
+    }
+
+    try {
+        FrameCache::FramePtr frame = cache->cache->get(index);
+        if (!frame) {
+            return 0;
+        }
+
+        // Heap allocated shared pointer keeps the frame pinned across the C boundary
+        outFrame->pixels = frame->pixels.data();
+        outFrame->width = frame->width;
+        outFrame->height = frame->height;
+        outFrame->byteSize = static_cast<int64_t>(frame->getByteSize());
+        outFrame->token = new FrameCache::FramePtr(std::move(frame));
+        return 1;
+    } catch (const std::exception& e) {
+        LOG_ERROR("Acquiring frame failed: index=%lld, %s", index, e.what());
+        return 0;
+    }
+}
+
+void rr_FrameCacheRelease(rr_PinnedFrame* frame)
+{
+    if (frame && frame->token) {
+        delete static_cast<FrameCache::FramePtr*>(frame->token);
+        *frame = {};
+    }
+}
+
+rr_Listener* rr_ListenerCreate(int32_t port, int32_t maxChunkSize)
+{
+    if (port < 0 || port > 65535 || maxChunkSize <= 0) {
+        return nullptr;
+    }
+
+    try {
+        auto handle = std::make_unique<rr_Listener>();
+        handle->listener = std::make_unique<MessageListener>(static_cast<uint16_t>(port), static_cast<size_t>(maxChunkSize));
+        return handle.release();
+    } catch (const std::exception& e) {
+        LOG_ERROR("Creating listener failed: %s", e.what());
+        return nullptr;
+    }
+}
+
+rr_Connection* rr_ListenerAccept(rr_Listener* listener)
+{
+    if (!listener) {
+        return nullptr;
+    }
+
+    auto connection = listener->listener->accept();
+    if (!connection) {
+        return nullptr;
+    }
+    auto handle = std::make_unique<rr_Connection>();
+    handle->connection = std::move(connection);
+    return handle.release();
+}
+
+int32_t rr_ListenerGetPort(rr_Listener* listener) { return listener ? listener->listener->getPort() : 0; }
+
+void rr_ListenerDestroy(rr_Listener* listener) { delete listener; }
+
+rr_Connection* rr_ConnectionConnect(const char* host, int32_t port, int32_t maxChunkSize)
+{
+    if (!host || port <= 0 || port > 65535 || maxChunkSize <= 0) {
+        return nullptr;
+    }
+
+    auto connection = MessageConnection::connect(host, static_cast<uint16_t>(port), static_cast<size_t>(maxChunkSize));
+    if (!connection) {
+        return nullptr;
+    }
+    auto handle = std::make_unique<rr_Connection>();
+    handle->connection = std::move(connection);
+    return handle.release();
+}
+
+void rr_ConnectionDestroy(rr_Connection* connection) { delete connection; }
+
+int32_t rr_ConnectionSend(rr_Connection* connection, uint16_t type, const uint8_t* data, int64_t size)
+{
+    if (!connection || size < 0 || (size > 0 && !data)) {
+        return 0;
+    }
+    return connection->connection->send(type, data, static_cast<size_t>(size)) ? 1 : 0;
+}
+
+int32_t rr_ConnectionReceive(rr_Connection* connection, rr_Message* outMessage)
+{
+    if (!connection || !outMessage) {
+        return 0;
+    }
+
+    try {
+        Message message;
+        if (!connection->connection->receive(message)) {
+            return 0;
+        }
+
+        toApiMessage(message, *outMessage);
+        return 1;
+    } catch (const std::exception& e) {
+        LOG_ERROR("Receiving message failed: %s", e.what());
+        return 0;
+    }
+}
+
+void rr_MessageRelease(rr_Message* message)
+{
+    if (message && message->token) {
+        delete static_cast<BufferPool::Buffer*>(message->token);
+        *message = {};
+    }
+}
+
+int32_t rr_FramingBenchmark(int64_t messageSize, int32_t messageCount, int32_t chunkSize, rr_FramingBenchmarkResult* outResult)
+{
+    if (messageSize < 0 || messageCount <= 0 || chunkSize <= 0 || !outResult) {
+        return 0;
+    }
+
+    try {
+        FramingBenchmark::Config config;
+        config.messageSize = static_cast<size_t>(messageSize);
+        config.messageCount = messageCount;
+        config.chunkSize = static_cast<size_t>(chunkSize);
+
+        const auto result = FramingBenchmark::run(config);
+        outResult->megabytesPerSecond = result.megabytesPerSecond;
+        outResult->messagesPerSecond = result.messagesPerSecond;
+        outResult->seconds = result.seconds;
+        return result.valid ? 1 : 0;
+    } catch (const std::exception& e) {
+        LOG_ERROR("Framing benchmark failed: %s", e.what());
+        return 0;
+    }
+}
+
+int32_t rr_MultiplexBenchmark(int64_t bulkSize, int32_t bulkCount, double controlInterval, rr_MultiplexBenchmarkResult* outResult)
+{
+    if (bulkSize < 0 || bulkCount <= 0 || controlInterval <= 0.0 || !outResult) {
+        return 0;
+    }
+
+    try {
+        FramingBenchmark::MultiplexConfig config;
+        config.bulkSize = static_cast<size_t>(bulkSize);
+        config.bulkCount = bulkCount;
+        config.controlInterval = controlInterval;
+
+        const auto result = FramingBenchmark::runMultiplexed(config);
+        outResult->bulkMegabytesPerSecond = result.bulkMegabytesPerSecond;
+        outResult->maxControlRoundTrip = result.maxControlRoundTrip;
+        outResult->avgControlRoundTrip = result.avgControlRoundTrip;
+        outResult->controlRoundTrips = static_cast<int64_t>(result.controlRoundTrips);
+        outResult->seconds = result.seconds;
+        return result.valid ? 1 : 0;
+    } catch (const std::exception& e) {
+        LOG_ERROR("Multiplex benchmark failed: %s", e.what());
+        return 0;
+    }
+}
+
+int32_t rr_CaptureBenchmark(int32_t width, int32_t height, double minSeconds, int32_t maxThreads, int32_t pinWorkers,
+    const char* outputDirectory, const char* filter, const char* jsonFilename)
+{
+    if (width <= 0 || height <= 0 || !outputDirectory || !jsonFilename) {
+        return 0;
+    }
+
+    try {
+        CaptureBenchmark::Config config;
+        config.width = width;
+        config.height = height;
+        config.minSeconds = minSeconds;
+        config.maxThreads = maxThreads;
+        config.pinWorkers = pinWorkers != 0;
+        config.outputDirectory = outputDirectory;
+        config.filter = filter ? filter : "";
+        return CaptureBenchmark::runToFile(config, jsonFilename) ? 1 : 0;
+    } catch (const std::exception& e) {
+        LOG_ERROR("Capture benchmark failed: %s", e.what());
+        return 0;
+    }
+}
+
+rr_Multiplex* rr_MultiplexConnect(const char* host, int32_t port)
+{
+    if (!host || port <= 0 || port > 65535) {
+        return nullptr;
+    }
+
+    try {
+        auto handle = std::make_unique<rr_Multiplex>();
+        handle->connection =
+            MultiplexConnection::connect(host, static_cast<uint16_t>(port), queueMultiplexed(handle.get()), MultiplexConnection::Config());
+        if (!handle->connection) {
+            return nullptr;
+        }
+        return handle.release();
+    } catch (const std::exception& e) {
+        LOG_ERROR("Creating multiplexed connection failed: %s", e.what());
+        return nullptr;
+    }
+}
+
+rr_Multiplex* rr_MultiplexAccept(rr_Listener* listener)
+{
+    if (!listener) {
+        return nullptr;
+    }
+
+    const uintptr_t socket = listener->listener->acceptSocket();
+    if (socket == MessageConnection::c_invalidSocket) {
+        return nullptr;
+    }
+
+    try {
+        auto handle = std::make_unique<rr_Multiplex>();
+        handle->connection = std::make_unique<MultiplexConnection>(socket, queueMultiplexed(handle.get()), MultiplexConnection::Config());
+        return handle.release();
+    } catch (const std::exception& e) {
+        LOG_ERROR("Accepting multiplexed connection failed: %s", e.what());
+        MessageConnection::closeSocket(socket);
+        return nullptr;
+    }
+}
+
+void rr_MultiplexDestroy(rr_Multiplex* mux)
+{
+    if (mux) {
+        // Join connection threads before the queues they write to go away
+        mux->connection.reset();
+        delete mux;
+    }
+}
+
+int32_t rr_MultiplexSend(rr_Multiplex* mux, int32_t channel, uint16_t type, const uint8_t* data, int64_t size)
+{
+    if (!mux || channel < 0 || channel >= static_cast<int32_t>(MultiplexConnection::c_channelCount) || size < 0 || (size > 0 && !data)) {
+        return 0;
+    }
+    return mux->connection->send(static_cast<MultiplexConnection::Channel>(channel), type, data, static_cast<size_t>(size)) ? 1 : 0;
+}
+
+int32_t rr_MultiplexPoll(rr_Multiplex* mux, int32_t channel, rr_Message* outMessage)
+{
+    if (!mux || !outMessage || channel < 0 || channel >= static_cast<int32_t>(MultiplexConnection::c_channelCount)) {
+        return 0;
+    }
+
+    Message message;
+    {
+        std::lock_guard<std::mutex> lock(mux->mutex);
+        auto& queue = mux->received[channel];
+        if (queue.empty()) {
+            return 0;
+        }
+        message = std::move(queue.front());
+        queue.pop_front();
+    }
+
+    toApiMessage(message, *outMessage);
+    return 1;
+}
+
+int32_t rr_MultiplexReceive(rr_Multiplex* mux, int32_t channel, double timeout, rr_Message* outMessage)
+{
+    if (!mux || !outMessage || channel < 0 || channel >= static_cast<int32_t>(MultiplexConnection::c_channelCount)) {
+        return 0;
+    }
+
+    // Closing does not signal the queues, so waits are sliced to notice a closed connection
+    using Clock = std::chrono::steady_clock;
+    constexpr Clock::duration c_closeCheckInterval = std::chrono::milliseconds(50);
+    const Clock::time_point deadline = Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(std::max(timeout, 0.0)));
+
+    Message message;
+    {
+        std::unique_lock<std::mutex> lock(mux->mutex);
+        auto& queue = mux->received[channel];
+        while (queue.empty()) {
+            const Clock::time_point now = Clock::now();
+            if (!mux->connection->isOpen() || (timeout >= 0.0 && now >= deadline)) {
+                return 0;
+            }
+            mux->condition.wait_for(lock, timeout >= 0.0 ? std::min(deadline - now, c_closeCheckInterval) : c_closeCheckInterval);
+        }
+        message = std::move(queue.front());
+        queue.pop_front();
+    }
+
+    toApiMessage(message, *outMessage);
+    return 1;
+}
+
+int32_t rr_MultiplexIsOpen(rr_Multiplex* mux) { return (mux && mux->connection->isOpen()) ? 1 : 0; }
+
+rr_BundleWriter* rr_BundleWriterCreate(const char* filename)
+{
+    if (!filename) {
+        return nullptr;
+    }
+
+    auto handle = std::make_unique<rr_BundleWriter>();
+    if (!handle->writer.open(filename)) {
+        return nullptr;
+    }
+    return handle.release();
+}
+
+int32_t rr_BundleWriterAddTrack(rr_BundleWriter* writer, const char* name, int32_t type)
+{
+    if (!writer || !name || type < 0 || type > static_cast<int32_t>(ReplayBundle::TrackType::Data)) {
+        return -1;
+    }
+    return writer->writer.addTrack(name, static_cast<ReplayBundle::TrackType>(type));
+}
+
+int32_t rr_BundleWriterWrite(rr_BundleWriter* writer, int32_t track, int64_t frameIndex, const uint8_t* data, int64_t size)
+{
+    if (!writer || size < 0 || (size > 0 && !data)) {
+        return 0;
+    }
+    return writer->writer.write(track, frameIndex, data, static_cast<size_t>(size)) ? 1 : 0;
+}
+
+int32_t rr_BundleWriterClose(rr_BundleWriter* writer)
+{
+    if (!writer) {
+        return 0;
+    }
+    const bool ok = writer->writer.finish();
+    delete writer;
+    return ok ? 1 : 0;
+}
+
+int32_t rr_BundleWriterWriteOverlay(
+    rr_BundleWriter* writer, int32_t track, int64_t frameIndex, const uint8_t* rgba, int32_t width, int32_t height, int32_t rowStride)
+{
+    if (!writer || !rgba || width <= 0 || height <= 0 || rowStride < width * 4) {
+        return 0;
+    }
+
+    ReplayBundle::TrackType type;
+    if (!writer->writer.getTrackType(track, type) || type != ReplayBundle::TrackType::Overlay) {
+        LOG_ERROR("Replay bundle track %d is not an overlay track.", track);
+        return 0;
+    }
+
+    // Encode and write under one lock so deltas reach the bundle in encoding order
+    std::lock_guard<std::mutex> lock(writer->mutex);
+    auto& overlayTrack = writer->overlayTracks[track];
+
+    // Readers apply deltas in frame index order, which must then be the encoding order
+    if (frameIndex <= overlayTrack.lastFrame) {
+        LOG_ERROR("Overlay frame %lld written after frame %lld of track %d.", static_cast<long long>(frameIndex),
+            static_cast<long long>(overlayTrack.lastFrame), track);
+        return 0;
+    }
+
+    std::vector<uint8_t> data;
+    overlayTrack.encoder.encode(rgba, width, height, rowStride, data);
+    if (!writer->writer.write(track, frameIndex, data.data(), data.size())) {
+        // Frame is missing from the bundle, so the next frame must not be a delta against it
+        overlayTrack.encoder.reset();
+        return 0;
+    }
+    overlayTrack.lastFrame = frameIndex;
+    return 1;
+}
+
+rr_Bundle* rr_BundleOpen(const char* filename)
+{
+    if (!filename) {
+        return nullptr;
+    }
+
+    auto reader = std::make_shared<ReplayBundleReader>();
+    if (!reader->open(filename)) {
+        return nullptr;
+    }
+    auto handle = std::make_unique<rr_Bundle>();
+    handle->reader = std::move(reader);
+    return handle.release();
+}
+
+void rr_BundleClose(rr_Bundle* bundle) { delete bundle; }
+
+int32_t rr_BundleFindTrack(rr_Bundle* bundle, const char* name) { return (bundle && name) ? bundle->reader->findTrack(name) : -1; }
+
+int32_t rr_BundleGetTrackCount(rr_Bundle* bundle) { return bundle ? static_cast<int32_t>(bundle->reader->getTracks().size()) : 0; }
+
+int32_t rr_BundleGetTrackName(rr_Bundle* bundle, int32_t track, char* outName, int32_t nameCapacity)
+{
+    if (!bundle || !outName || nameCapacity <= 0 || track < 0 || track >= static_cast<int32_t>(bundle->reader->getTracks().size())) {
+        return 0;
+    }
+
+    const std::string& name = bundle->reader->getTracks()[track].name;
+    const size_t length = std::min(name.size(), static_cast<size_t>(nameCapacity - 1));
+    memcpy(outName, name.data(), length);
+    outName[length] = '\0';
+    return 1;
+}
+
+int32_t rr_BundleGetTrackType(rr_Bundle* bundle, int32_t track)
+{
+    if (!bundle || track < 0 || track >= static_cast<int32_t>(bundle->reader->getTracks().size())) {
+        return -1;
+    }
+    return static_cast<int32_t>(bundle->reader->getTracks()[track].type);
+}
+
+int32_t rr_BundleGetFrameRange(rr_Bundle* bundle, int32_t track, int64_t* outFirst, int64_t* outLast)
+{
+    if (!bundle || !outFirst || !outLast) {
+        return 0;
+    }
+    return bundle->reader->getFrameRange(track, *outFirst, *outLast) ? 1 : 0;
+}
+
+int32_t rr_BundleGetFrame(rr_Bundle* bundle, int32_t track, int64_t frameIndex, const uint8_t** outData, int64_t* outSize)
+{
+    if (!bundle || !outData || !outSize) {
+        return 0;
+    }
+
+    const auto view = bundle->reader->getFrame(track, frameIndex);
+    if (!view.data) {
+        return 0;
+    }
+    *outData = view.data;
+    *outSize = static_cast<int64_t>(view.size);
+    return 1;
+}
+
+rr_FrameCache* rr_FrameCacheCreateFromBundle(rr_Bundle* bundle, int32_t track, int64_t budgetBytes, int32_t workerCount, int32_t prefetchDepth)
+{
+    int64_t first = 0;
+    int64_t last = 0;
+    if (!bundle || budgetBytes <= 0 || !bundle->reader->getFrameRange(track, first, last)) {
+        return nullptr;
+    }
+
+    try {
+        auto handle = std::make_unique<rr_FrameCache>();
+        handle->cache = std::make_unique<FrameCache>(
+            FrameCache::createBundleDecoder(bundle->reader, track), static_cast<size_t>(budgetBytes), workerCount, prefetchDepth);
+        handle->cache->setFrameRange(first, last);
+        return handle.release();
+    } catch (const std::exception& e) {
+        LOG_ERROR("Creating frame cache failed: %s", e.what());
+        return nullptr;
+    }
+}
+
+rr_Overlay* rr_OverlayOpen(const uint8_t* data, int64_t size)
+{
+    if (!data || size <= 0) {
+        return nullptr;
+    }
+
+    auto handle = std::make_unique<rr_Overlay>();
+    if (!handle->overlay.deserialize(data, static_cast<size_t>(size)) || handle->overlay.isDelta()) {
+        return nullptr;
+    }
+    return handle.release();
+}
+
+rr_Overlay* rr_OverlayOpenFromBundle(rr_Bundle* bundle, int32_t track, int64_t frameIndex)
+{
+    if (!bundle) {
+        return nullptr;
+    }
+
+    const auto view = bundle->reader->getFrame(track, frameIndex);
+    try {
+        auto handle = std::make_unique<rr_Overlay>();
+        if (!view.data || !handle->overlay.deserialize(view.data, view.size)) {
+            return nullptr;
+        }
+        if (!handle->overlay.isDelta()) {
+            return handle.release();
+        }
+
+        // Reconstruct delta frame from its keyframe. The sequence keeps the last frame, so playback applies one delta per frame.
+        OverlaySequence* sequence = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(bundle->mutex);
+            auto& entry = bundle->overlaySequences[track];
+            if (!entry) {
+                entry = OverlaySequence::fromBundle(bundle->reader, track);
+            }
+            sequence = entry.get();
+        }
+
+        int width = 0;
+        int height = 0;
+        std::vector<uint8_t> pixels;
+        if (!sequence || !sequence->decode(frameIndex, width, height, pixels)) {
+            return nullptr;
+        }
+        handle->overlay = TiledOverlay::encode(pixels.data(), width, height, width * 4);
+        return handle.release();
+    } catch (const std::exception& e) {
+        LOG_ERROR("Opening overlay frame failed: %s", e.what());
+        return nullptr;
+    }
+}
+
+void rr_OverlayDestroy(rr_Overlay* overlay) { delete overlay; }
+
+int32_t rr_OverlayGetSize(rr_Overlay* overlay, int32_t* outWidth, int32_t* outHeight)
+{
+    if (!overlay || !outWidth || !outHeight) {
+        return 0;
+    }
+    *outWidth = overlay->overlay.getWidth();
+    *outHeight = overlay->overlay.getHeight();
+    return 1;
+}
+
+int32_t rr_OverlayGetTileCount(rr_Overlay* overlay) { return overlay ? static_cast<int32_t>(overlay->overlay.getTileCount()) : 0; }
+
+int32_t rr_OverlayDecodeTile(rr_Overlay* overlay, int32_t tile, uint8_t* outPixels, int32_t rowStride, rr_TileRect* outRect)
+{
+    if (!overlay || !outPixels || !outRect || tile < 0 || tile >= static_cast<int32_t>(overlay->overlay.getTileCount()) ||
+        rowStride < TiledOverlay::c_tileSize * 4) {
+        return 0;
+    }
+
+    const auto rect = overlay->overlay.getTileRect(static_cast<size_t>(tile));
+    outRect->x = rect.x;
+    outRect->y = rect.y;
+    outRect->width = rect.width;
+    outRect->height = rect.height;
+    return overlay->overlay.decodeTile(static_cast<size_t>(tile), outPixels, rowStride) ? 1 : 0;
+}
+
+int32_t rr_OverlayDecode(rr_Overlay* overlay, uint8_t* outPixels, int32_t rowStride)
+{
+    if (!overlay || !outPixels || rowStride < overlay->overlay.getWidth() * 4) {
+        return 0;
+    }
+    return overlay->overlay.decode(outPixels, rowStride) ? 1 : 0;
+}
+
+int32_t rr_OverlayUploadD3D11(rr_Overlay* overlay, rr_Overlay* previous, void* deviceContext, void* texture)
+{
+    if (!overlay) {
+        return 0;
+    }
+    return overlay->overlay.upload(static_cast<ID3D11DeviceContext*>(deviceContext), static_cast<ID3D11Resource*>(texture),
+               previous ? &previous->overlay : nullptr)
+               ? 1
+               : 0;
+}
+
+int32_t rr_OverlayQueueUploadD3D11(rr_Overlay* overlay, rr_Overlay* previous, void* texture)
+{
+    if (!overlay || !texture || overlay->overlay.isDelta()) {
+        return 0;
+    }
+
+#if defined(_WIN32)
+    OverlayUpload upload;
+    upload.overlay = overlay->overlay;
+    if (previous) {
+        upload.previous = previous->overlay;
+    }
+    upload.texture = static_cast<ID3D11Resource*>(texture);
+
+    std::lock_guard<std::mutex> lock(g_overlayUploadMutex);
+    g_overlayUploads.push_back(std::move(upload));
+    return 1;
+#else
+    (void)previous;
+    LOG_ERROR("Overlay upload requires Direct3D 11.");
+    return 0;
+#endif
+}
+
+rr_RenderEventFunc rr_OverlayGetRenderEventFunc()
+{
+#if defined(_WIN32)
+    return runOverlayUploads;
+#else
+    return nullptr;
+#endif
+}
+
+rr_Compositor* rr_CompositorCreate(int32_t threadCount)
+{
+    try {
+        OverlayCompositor::Config config;
+        config.threadCount = threadCount;
+        auto handle = std::make_unique<rr_Compositor>();
+        handle->compositor = std::make_unique<OverlayCompositor>(config);
+        return handle.release();
+    } catch (const std::exception& e) {
+        LOG_ERROR("Creating compositor failed: %s", e.what());
+        return nullptr;
+    }
+}
+
+void rr_CompositorDestroy(rr_Compositor* compositor) { delete compositor; }
+
+int32_t rr_Composite(rr_Compositor* compositor, int32_t width, int32_t height, const rr_Layer* layers, int32_t layerCount,
+    const rr_LayerUse* uses, int32_t useCount, uint8_t* const* outputs, const int32_t* rowStrides, int32_t outputCount)
+{
+    if (!compositor || width <= 0 || height <= 0 || layerCount < 0 || useCount < 0 || outputCount <= 0 || (layerCount > 0 && !layers) ||
+        (useCount > 0 && !uses) || !outputs || !rowStrides) {
+        return 0;
+    }
+
+    std::vector<OverlayCompositor::Layer> compositeLayers(layerCount);
+    for (int32_t i = 0; i < layerCount; i++) {
+        const rr_Layer& src = layers[i];
+        auto& layer = compositeLayers[i];
+        const int bpp = src.format == RR_LAYER_ALPHA8 ? 1 : 4;
+        if (src.width < 0 || src.height < 0 || src.rowStride < src.width * bpp) {
+            return 0;
+        }
+        layer.data = src.data;
+        layer.width = src.width;
+        layer.height = src.height;
+        layer.rowStride = src.rowStride;
+        layer.format = src.format == RR_LAYER_ALPHA8 ? OverlayCompositor::Format::Alpha8 : OverlayCompositor::Format::Rgba8;
+        layer.x = src.x;
+        layer.y = src.y;
+        layer.tint = glm::vec4(src.tint[0], src.tint[1], src.tint[2], src.tint[3]);
+    }
+
+    std::vector<OverlayCompositor::Output> compositeOutputs(outputCount);
+    for (int32_t i = 0; i < outputCount; i++) {
+        if (!outputs[i] || rowStrides[i] < width * 4) {
+            return 0;
+        }
+        compositeOutputs[i].rgba = outputs[i];
+        compositeOutputs[i].rowStride = rowStrides[i];
+    }
+
+    for (int32_t i = 0; i < useCount; i++) {
+        if (uses[i].output < 0 || uses[i].output >= outputCount) {
+            return 0;
+        }
+        OverlayCompositor::LayerUse use;
+        use.layer = uses[i].layer;
+        use.opacity = uses[i].opacity;
+        switch (uses[i].blend) {
+            case RR_BLEND_OVER: use.blend = OverlayCompositor::BlendMode::Over; break;
+            case RR_BLEND_SCALE: use.blend = OverlayCompositor::BlendMode::Scale; break;
+            default: use.blend = OverlayCompositor::BlendMode::Add; break;
+        }
+        compositeOutputs[uses[i].output].layers.push_back(use);
+    }
+
+    compositor->compositor->composite(width, height, compositeLayers, compositeOutputs);
+    return 1;
+}
+
+rr_Polyline* rr_PolylineCreate(int32_t width, int32_t height, float lineWidth)
+{
+    if (width <= 0 || height <= 0) {
+        return nullptr;
+    }
+
+    try {
+        auto handle = std::make_unique<rr_Polyline>();
+        handle->rasterizer = std::make_unique<PolylineRasterizer>(width, height, lineWidth);
+        return handle.release();
+    } catch (const std::exception& e) {
+        LOG_ERROR("Creating polyline layer failed: %s", e.what());
+        return nullptr;
+    }
+}
+
+void rr_PolylineDestroy(rr_Polyline* polyline) { delete polyline; }
+
+void rr_PolylineAppend(rr_Polyline* polyline, float x, float y, const float color[4])
+{
+    if (!polyline || !color) {
+        return;
+    }
+
+    PolylineRasterizer::Vertex vertex;
+    vertex.position = glm::vec2(x, y);
+    vertex.color = glm::vec4(color[0], color[1], color[2], color[3]);
+    polyline->rasterizer->append(vertex);
+}
+
+void rr_PolylineDraw(rr_Polyline* polyline, const float* vertices, int32_t count)
+{
+    if (!polyline || (!vertices && count > 0)) {
+        return;
+    }
+
+    try {
+        std::vector<PolylineRasterizer::Vertex> polylineVertices(std::max(count, 0));
+        for (int32_t i = 0; i < count; i++) {
+            const float* v = vertices + static_cast<size_t>(i) * 6;
+            polylineVertices[i].position = glm::vec2(v[0], v[1]);
+            polylineVertices[i].color = glm::vec4(v[2], v[3], v[4], v[5]);
+        }
+        polyline->rasterizer->draw(polylineVertices);
+    } catch (const std::exception& e) {
+        LOG_ERROR("Drawing polyline failed: %s", e.what());
+    }
+}
+
+void rr_PolylineEnd(rr_Polyline* polyline)
+{
+    if (polyline) {
+        polyline->rasterizer->endPolyline();
+    }
+}
+
+void rr_PolylineClear(rr_Polyline* polyline)
+{
+    if (polyline) {
+        polyline->rasterizer->clear();
+    }
+}
+
+void rr_PolylineSetLineWidth(rr_Polyline* polyline, float lineWidth)
+{
+    if (polyline) {
+        polyline->rasterizer->setLineWidth(lineWidth);
+    }
+}
+
+int32_t rr_PolylineGetData(rr_Polyline* polyline, const uint8_t** outData, int32_t* outRowStride)
+{
+    if (!polyline || !outData || !outRowStride) {
+        return 0;
+    }
+    *outData = polyline->rasterizer->getData();
+    *outRowStride = polyline->rasterizer->getRowStride();
+    return 1;
+}
+
+int32_t rr_PolylineTakeDirtyRect(rr_Polyline* polyline, rr_TileRect* outRect)
+{
+    if (!polyline || !outRect) {
+        return 0;
+    }
+
+    const glm::ivec4 dirty = polyline->rasterizer->takeDirtyRect();
+    outRect->x = dirty.x;
+    outRect->y = dirty.y;
+    outRect->width = dirty.z - dirty.x;
+    outRect->height = dirty.w - dirty.y;
+    return outRect->width > 0 ? 1 : 0;
+}
+
+rr_FrameStore* rr_FrameStoreCreate(const char* spillFilename, int64_t budgetBytes)
+{
+    if (!spillFilename || budgetBytes < 0) {
+        return nullptr;
+    }
+
+    try {
+        auto handle = std::make_unique<rr_FrameStore>();
+        handle->store = std::make_unique<FrameStore>(spillFilename, static_cast<size_t>(budgetBytes));
+        return handle.release();
+    } catch (const std::exception& e) {
+        LOG_ERROR("Creating frame store failed: %s", e.what());
+        return nullptr;
+    }
+}
+
+void rr_FrameStoreDestroy(rr_FrameStore* store) { delete store; }
+
+uint64_t rr_FrameStorePut(rr_FrameStore* store, const uint8_t* data, int32_t width, int32_t height, int32_t channels, int32_t rowStride)
+{
+    if (!store) {
+        return 0;
+    }
+
+    try {
+        return store->store->put(data, width, height, channels, rowStride);
+    } catch (const std::exception& e) {
+        LOG_ERROR("Storing frame failed: %s", e.what());
+        return 0;
+    }
+}
+
+int32_t rr_FrameStoreAcquire(rr_FrameStore* store, uint64_t handle, rr_StoredFrame* outFrame)
+{
+    if (!store || !outFrame) {
+        return 0;
+    }
+
+    try {
+        FrameStore::FramePtr frame = store->store->get(handle);
+        if (!frame) {
+            return 0;
+        }
+
+        // Heap allocated shared pointer keeps the frame pinned across the C boundary
+        outFrame->pixels = frame->pixels.data();
+        outFrame->width = frame->width;
+        outFrame->height = frame->height;
+        outFrame->channels = frame->channels;
+        outFrame->token = new FrameStore::FramePtr(std::move(frame));
+        return 1;
+    } catch (const std::exception& e) {
+        LOG_ERROR("Acquiring stored frame failed: handle=%llu, %s", handle, e.what());
+        return 0;
+    }
+}
+
+void rr_FrameStoreUnpin(rr_StoredFrame* frame)
+{
+    if (frame && frame->token) {
+        delete static_cast<FrameStore::FramePtr*>(frame->token);
+        *frame = {};
+    }
+}
+
+void rr_FrameStoreRelease(rr_FrameStore* store, uint64_t handle)
+{
+    if (store) {
+        store->store->release(handle);
+    }
+}
+
+void rr_FrameStoreSetBudget(rr_FrameStore* store, int64_t budgetBytes)
+{
+    if (store && budgetBytes >= 0) {
+        store->store->setBudget(static_cast<size_t>(budgetBytes));
+    }
+}
+
+int32_t rr_FrameStoreGetStats(rr_FrameStore* store, rr_FrameStoreStats* outStats)
+{
+    if (!store || !outStats) {
+        return 0;
+    }
+
+    const FrameStore::Stats stats = store->store->getStats();
+    outStats->frameCount = static_cast<int64_t>(stats.frameCount);
+    outStats->residentCount = static_cast<int64_t>(stats.residentCount);
+    outStats->residentBytes = static_cast<int64_t>(stats.residentBytes);
+    outStats->spilledCount = static_cast<int64_t>(stats.spilledCount);
+    outStats->spillBytes = static_cast<int64_t>(stats.spillBytes);
+    outStats->rawSpillBytes = static_cast<int64_t>(stats.rawSpillBytes);
+    outStats->hits = static_cast<int64_t>(stats.hits);
+    outStats->reloads = static_cast<int64_t>(stats.reloads);
+    outStats->evictions = static_cast<int64_t>(stats.evictions);
+    return 1;
+}
+
+rr_WorkQueue* rr_WorkQueueCreate(const char* name, int32_t capacity, int32_t policy, int32_t keepEvery, double maxAgeSeconds,
+    rr_JobCallback callback, void* userData)
+{
+    if (capacity <= 0 || policy < RR_QUEUE_DROP_OLDEST || policy > RR_QUEUE_BLOCK) {
+        return nullptr;
+    }
+
+    try {
+        WorkQueue::Config config;
+        if (name) {
+            config.name = name;
+        }
+        config.capacity = static_cast<size_t>(capacity);
+        config.policy = static_cast<WorkQueue::Policy>(policy);
+        config.keepEvery = keepEvery;
+        config.maxAgeSeconds = maxAgeSeconds;
+        if (callback) {
+            config.callback = [callback, userData](const WorkQueue::Job& job, WorkQueue::Outcome outcome, double waitSeconds, double serviceSeconds) {
+                callback(userData, job.id, job.timestamp, static_cast<int32_t>(outcome), waitSeconds, serviceSeconds);
+            };
+        }
+
+        auto handle = std::make_unique<rr_WorkQueue>();
+        handle->queue = std::make_unique<WorkQueue>(config);
+        return handle.release();
+    } catch (const std::exception& e) {
+        LOG_ERROR("Creating work queue failed: %s", e.what());
+        return nullptr;
+    }
+}
+
+void rr_WorkQueueDestroy(rr_WorkQueue* queue) { delete queue; }
+
+int32_t rr_WorkQueuePush(rr_WorkQueue* queue, uint64_t id, int64_t timestamp, double deadlineSeconds)
+{
+    if (!queue) {
+        return 0;
+    }
+    return queue->queue->push(id, timestamp, deadlineSeconds) ? 1 : 0;
+}
+
+int32_t rr_WorkQueuePop(rr_WorkQueue* queue, double timeoutSeconds, uint64_t* outId, int64_t* outTimestamp, double* outWaitSeconds)
+{
+    if (!queue || !outId) {
+        return 0;
+    }
+
+    WorkQueue::Job job;
+    if (!queue->queue->pop(job, timeoutSeconds)) {
+        return 0;
+    }
+
+    *outId = job.id;
+    if (outTimestamp) {
+        *outTimestamp = job.timestamp;
+    }
+    if (outWaitSeconds) {
+        *outWaitSeconds = std::chrono::duration<double>(job.popTime - job.pushTime).count();
+    }
+    return 1;
+}
+
+void rr_WorkQueueComplete(rr_WorkQueue* queue, uint64_t id, int32_t success)
+{
+    if (queue) {
+        queue->queue->complete(id, success != 0);
+    }
+}
+
+void rr_WorkQueueClose(rr_WorkQueue* queue)
+{
+    if (queue) {
+        queue->queue->close();
+    }
+}
+
+int32_t rr_WorkQueueGetStats(rr_WorkQueue* queue, rr_WorkQueueStats* outStats)
+{
+    if (!queue || !outStats) {
+        return 0;
+    }
+
+    const WorkQueue::Stats stats = queue->queue->getStats();
+    outStats->depth = static_cast<int64_t>(stats.depth);
+    outStats->maxDepth = static_cast<int64_t>(stats.maxDepth);
+    outStats->inFlight = static_cast<int64_t>(stats.inFlight);
+    outStats->pushed = static_cast<int64_t>(stats.pushed);
+    outStats->completed = static_cast<int64_t>(stats.completed);
+    outStats->dropped = static_cast<int64_t>(stats.dropped);
+    outStats->expired = static_cast<int64_t>(stats.expired);
+    outStats->cancelled = static_cast<int64_t>(stats.cancelled);
+    outStats->meanWaitSeconds = stats.meanWaitSeconds;
+    outStats->maxWaitSeconds = stats.maxWaitSeconds;
+    outStats->lastWaitSeconds = stats.lastWaitSeconds;
+    outStats->meanServiceSeconds = stats.meanServiceSeconds;
+    return 1;
+}
+
+rr_ClipBuffer* rr_ClipBufferCreate(int32_t width, int32_t height, int32_t length, int32_t slack, int32_t half)
+{
+    if (width <= 0 || height <= 0 || length <= 0 || slack < 0) {
+        return nullptr;
+    }
+
+    try {
+        ClipBuffer::Config config;
+        config.width = width;
+        config.height = height;
+        config.length = length;
+        config.slack = slack;
+        config.precision = half ? ClipBuffer::Precision::Float16 : ClipBuffer::Precision::Float32;
+        auto handle = std::make_unique<rr_ClipBuffer>();
+        handle->buffer = std::make_unique<ClipBuffer>(config);
+        return handle.release();
+    } catch (const std::exception& e) {
+        LOG_ERROR("Creating clip buffer failed: %s", e.what());
+        return nullptr;
+    }
+}
+
+void rr_ClipBufferDestroy(rr_ClipBuffer* buffer) { delete buffer; }
+
+int32_t rr_ClipBufferPush(rr_ClipBuffer* buffer, const uint8_t* data, int32_t width, int32_t height, int32_t rowStride, int32_t channels)
+{
+    if (!buffer || !data || width <= 0 || height <= 0 || channels < 3 || channels > 4) {
+        return 0;
+    }
+    buffer->buffer->push(data, width, height, rowStride, channels);
+    return 1;
+}
+
+int32_t rr_ClipBufferGetView(rr_ClipBuffer* buffer, rr_ClipView* outView)
+{
+    if (!buffer || !outView) {
+        return 0;
+    }
+
+    ClipBuffer::View view;
+    if (!buffer->buffer->getView(view)) {
+        return 0;
+    }
+
+    outView->data = view.data;
+    std::copy(view.shape.begin(), view.shape.end(), outView->shape);
+    std::copy(view.strides.begin(), view.strides.end(), outView->strides);
+    outView->firstFrame = view.firstFrame;
+    outView->half = buffer->buffer->getConfig().precision == ClipBuffer::Precision::Float16 ? 1 : 0;
+    return 1;
+}
+
+void rr_ClipBufferClear(rr_ClipBuffer* buffer)
+{
+    if (buffer) {
+        buffer->buffer->clear();
+    }
+}
+
+rr_BatchScheduler* rr_BatchSchedulerCreate(int64_t itemBytes, int32_t maxBatchSize, int32_t stagingCount, double latencyBoundSeconds,
+    double maxDelaySeconds, int32_t maxPending, rr_BatchPreprocess preprocess, rr_BatchResult result, void* userData)
+{
+    if (itemBytes <= 0 || maxBatchSize <= 0 || stagingCount <= 0 || maxPending <= 0) {
+        return nullptr;
+    }
+
+    try {
+        BatchScheduler::Config config;
+        config.itemBytes = static_cast<size_t>(itemBytes);
+        config.maxBatchSize = maxBatchSize;
+        config.stagingCount = stagingCount;
+        config.latencyBoundSeconds = latencyBoundSeconds;
+        config.maxDelaySeconds = maxDelaySeconds;
+        config.maxPending = static_cast<size_t>(maxPending);
+        if (preprocess) {
+            config.preprocess = [preprocess, userData](uint64_t id, const uint8_t* input, size_t inputSize, uint8_t* slot) {
+                return preprocess(userData, id, input, static_cast<int64_t>(inputSize), slot) != 0;
+            };
+        }
+        if (result) {
+            config.resultCallback = [result, userData](uint64_t id, bool completed, const uint8_t* data, size_t size, double latencySeconds) {
+                result(userData, id, completed ? 1 : 0, data, static_cast<int64_t>(size), latencySeconds);
+            };
+        }
+
+        auto handle = std::make_unique<rr_BatchScheduler>();
+        handle->scheduler = std::make_unique<BatchScheduler>(config);
+        return handle.release();
+    } catch (const std::exception& e) {
+        LOG_ERROR("Creating batch scheduler failed: %s", e.what());
+        return nullptr;
+    }
+}
+
+void rr_BatchSchedulerDestroy(rr_BatchScheduler* scheduler) { delete scheduler; }
+
+void rr_BatchSchedulerSubmit(rr_BatchScheduler* scheduler, uint64_t id, const uint8_t* input, int64_t inputSize)
+{
+    if (scheduler && (input || inputSize == 0) && inputSize >= 0) {
+        scheduler->scheduler->submit(id, input, static_cast<size_t>(inputSize));
+    }
+}
+
+int32_t rr_BatchSchedulerAcquire(rr_BatchScheduler* scheduler, double timeoutSeconds, rr_Batch* outBatch)
+{
+    if (!scheduler || !outBatch) {
+        return 0;
+    }
+
+    BatchScheduler::Batch batch;
+    if (!scheduler->scheduler->acquireBatch(batch, timeoutSeconds)) {
+        return 0;
+    }
+
+    std::lock_guard<std::mutex> lock(scheduler->mutex);
+    const BatchScheduler::Batch& stored = scheduler->batches[batch.batchId] = std::move(batch);
+    outBatch->batchId = stored.batchId;
+    outBatch->count = stored.count;
+    outBatch->data = stored.data;
+    outBatch->itemBytes = static_cast<int64_t>(stored.itemBytes);
+    outBatch->ids = stored.ids.data();
+    return 1;
+}
+
+void rr_BatchSchedulerComplete(rr_BatchScheduler* scheduler, uint64_t batchId, const uint8_t* results, int64_t resultStride)
+{
+    if (!scheduler) {
+        return;
+    }
+
+    scheduler->scheduler->completeBatch(batchId, results, results ? static_cast<size_t>(resultStride) : 0);
+    std::lock_guard<std::mutex> lock(scheduler->mutex);
+    scheduler->batches.erase(batchId);
+}
+
+int32_t rr_BatchSchedulerGetStaging(rr_BatchScheduler* scheduler, uint8_t** outBuffers, int32_t maxCount, int64_t* outSize)
+{
+    if (!scheduler) {
+        return 0;
+    }
+
+    const std::vector<uint8_t*> buffers = scheduler->scheduler->getStagingBuffers();
+    for (int32_t i = 0; outBuffers && i < maxCount && i < static_cast<int32_t>(buffers.size()); i++) {
+        outBuffers[i] = buffers[i];
+    }
+    if (outSize) {
+        *outSize = static_cast<int64_t>(scheduler->scheduler->getStagingSize());
+    }
+    return static_cast<int32_t>(buffers.size());
+}
+
+void rr_BatchSchedulerStop(rr_BatchScheduler* scheduler)
+{
+    if (scheduler) {
+        scheduler->scheduler->stop();
+    }
+}
+
+int32_t rr_BatchSchedulerGetStats(rr_BatchScheduler* scheduler, rr_BatchSchedulerStats* outStats)
+{
+    if (!scheduler || !outStats) {
+        return 0;
+    }
+
+    const BatchScheduler::Stats stats = scheduler->scheduler->getStats();
+    outStats->submitted = static_cast<int64_t>(stats.submitted);
+    outStats->dropped = static_cast<int64_t>(stats.dropped);
+    outStats->completed = static_cast<int64_t>(stats.completed);
+    outStats->batches = static_cast<int64_t>(stats.batches);
+    outStats->meanBatchSize = stats.meanBatchSize;
+    outStats->meanLatencySeconds = stats.meanLatencySeconds;
+    outStats->maxLatencySeconds = stats.maxLatencySeconds;
+    outStats->overBound = static_cast<int64_t>(stats.overBound);
+    outStats->meanInferenceSeconds = stats.meanInferenceSeconds;
+    return 1;
+}
+
+int64_t rr_TraceNow() { return traceNow(); }
+
+rr_LatencyCollector* rr_LatencyCollectorCreate(int64_t maxSamples)
+{
+    if (maxSamples <= 0) {
+        return nullptr;
+    }
+
+    try {
+        auto handle = std::make_unique<rr_LatencyCollector>();
+        handle->collector = std::make_unique<LatencyCollector>(static_cast<size_t>(maxSamples));
+        return handle.release();
+    } catch (const std::exception& e) {
+        LOG_ERROR("rr_LatencyCollectorCreate failed: %s", e.what());
+        return nullptr;
+    }
+}
+
+void rr_LatencyCollectorDestroy(rr_LatencyCollector* collector) { delete collector; }
+
+int32_t rr_LatencyCollectorRecord(rr_LatencyCollector* collector, const uint8_t* record, int64_t size)
+{
+    FrameTrace trace;
+    if (!collector || !record || size < 0 || !parseTrace(record, static_cast<size_t>(size), trace)) {
+        return 0;
+    }
+
+    try {
+        collector->collector->record(trace);
+        return 1;
+    } catch (const std::exception& e) {
+        LOG_ERROR("rr_LatencyCollectorRecord failed: %s", e.what());
+        return 0;
+    }
+}
+
+int64_t rr_LatencyCollectorLoadLog(rr_LatencyCollector* collector, const char* filename)
+{
+    if (!collector || !filename) {
+        return 0;
+    }
+
+    try {
+        return static_cast<int64_t>(collector->collector->loadLog(filename));
+    } catch (const std::exception& e) {
+        LOG_ERROR("rr_LatencyCollectorLoadLog failed: %s", e.what());
+        return 0;
+    }
+}
+
+int32_t rr_LatencyCollectorGetStats(rr_LatencyCollector* collector, int32_t stage, rr_LatencyStats* outStats)
+{
+    if (!collector || !outStats || stage < 0 || stage > c_traceStageCount) {
+        return 0;
+    }
+
+    const LatencyCollector::Stats stats =
+        (stage == c_traceStageCount) ? collector->collector->getTotalStats() : collector->collector->getStageStats(static_cast<TraceStage>(stage));
+    outStats->count = static_cast<int64_t>(stats.count);
+    outStats->mean = stats.mean;
+    outStats->p50 = stats.p50;
+    outStats->p90 = stats.p90;
+    outStats->p99 = stats.p99;
+    outStats->max = stats.max;
+    return 1;
+}
+
+int32_t rr_LatencyCollectorWriteReport(rr_LatencyCollector* collector, const char* filename)
+{
+    if (!collector || !filename) {
+        return 0;
+    }
+
+    try {
+        return collector->collector->writeReport(filename) ? 1 : 0;
+    } catch (const std::exception& e) {
+        LOG_ERROR("rr_LatencyCollectorWriteReport failed: %s", e.what());
+        return 0;
+    }
+}
+
+rr_FovealFrame* rr_FovealFrameOpen(const uint8_t* data, int64_t size)
+{
+    if (!data || size <= 0) {
+        return nullptr;
+    }
+
+    auto handle = std::make_unique<rr_FovealFrame>();
+    if (!parseFoveal(data, static_cast<size_t>(size), handle->frame)) {
+        return nullptr;
+    }
+    return handle.release();
+}
+
+void rr_FovealFrameDestroy(rr_FovealFrame* frame) { delete frame; }
+
+int32_t rr_FovealFrameGetInfo(rr_FovealFrame* frame, rr_FovealInfo* outInfo)
+{
+    if (!frame || !outInfo) {
+        return 0;
+    }
+
+    const FovealFrame& f = frame->frame;
+    outInfo->width = f.width;
+    outInfo->height = f.height;
+    outInfo->peripheryScale = f.scale;
+    outInfo->gazeValid = f.gazeValid ? 1 : 0;
+    outInfo->fixationX = f.fixation.x;
+    outInfo->fixationY = f.fixation.y;
+    outInfo->roi = {f.roi.x, f.roi.y, f.roi.z, f.roi.w};
+    return 1;
+}
+
+int32_t rr_FovealFrameDecode(rr_FovealFrame* frame, uint8_t* outPixels, int32_t rowStride)
+{
+    if (!frame || !outPixels || rowStride < frame->frame.width * 4) {
+        return 0;
+    }
+
+    try {
+        std::vector<uint8_t> pixels;
+        reconstructFoveal(frame->frame, pixels, &JobSystem::getShared());
+        const size_t lineSize = static_cast<size_t>(frame->frame.width) * 4;
+        for (int32_t y = 0; y < frame->frame.height; y++) {
+            memcpy(outPixels + static_cast<size_t>(y) * rowStride, pixels.data() + y * lineSize, lineSize);
+        }
+        return 1;
+    } catch (const std::exception& e) {
+        LOG_ERROR("rr_FovealFrameDecode failed: %s", e.what());
+        return 0;
+    }
+}
+
+rr_GazeRecorder* rr_GazeRecorderCreate(int32_t capacity)
+{
+    if (capacity <= 0) {
+        return nullptr;
+    }
+
+    try {
+        GazeRecorder::Config config;
+        config.capacity = capacity;
+        auto handle = std::make_unique<rr_GazeRecorder>();
+        handle->recorder = std::make_unique<GazeRecorder>(config);
+        return handle.release();
+    } catch (const std::exception& e) {
+        LOG_ERROR("rr_GazeRecorderCreate failed: %s", e.what());
+        return nullptr;
+    }
+}
+
+void rr_GazeRecorderDestroy(rr_GazeRecorder* recorder) { delete recorder; }
+
+int64_t rr_GazeRecorderLoadLog(rr_GazeRecorder* recorder, const char* filename)
+{
+    if (!recorder || !filename) {
+        return 0;
+    }
+
+    try {
+        return static_cast<int64_t>(recorder->recorder->loadLog(filename));
+    } catch (const std::exception& e) {
+        LOG_ERROR("rr_GazeRecorderLoadLog failed: %s", e.what());
+        return 0;
+    }
+}
+
+int32_t rr_GazeRecorderWriteLog(rr_GazeRecorder* recorder, const char* filename)
+{
+    if (!recorder || !filename) {
+        return 0;
+    }
+
+    try {
+        return recorder->recorder->writeLog(filename) ? 1 : 0;
+    } catch (const std::exception& e) {
+        LOG_ERROR("rr_GazeRecorderWriteLog failed: %s", e.what());
+        return 0;
+    }
+}
+
+int32_t rr_GazeRecorderGetSampleAt(rr_GazeRecorder* recorder, int64_t time, int64_t maxDelta, rr_GazeSample* outSample)
+{
+    GazeRecorder::Sample sample;
+    if (!recorder || !outSample || !recorder->recorder->getSampleAt(time, maxDelta, sample)) {
+        return 0;
+    }
+
+    const glm::dvec3 gaze = sample.getGaze();
+    const glm::dvec3 world = sample.getWorld();
+    outSample->time = sample.time;
+    for (int i = 0; i < 3; i++) {
+        outSample->gaze[i] = gaze[i];
+        outSample->world[i] = world[i];
+    }
+    outSample->focusDistance = sample.getFocusDistance();
+    outSample->status = static_cast<int32_t>(sample.getStatus());
+    outSample->hasWorld = sample.hasWorld() ? 1 : 0;
+    return 1;
+}
+
+double rr_GazeRecorderGetAngleTo(rr_GazeRecorder* recorder, const double* direction, int64_t time, int64_t maxDelta)
+{
+    if (!recorder || !direction) {
+        return -1.0;
+    }
+    return recorder->recorder->getAngleTo(glm::dvec3(direction[0], direction[1], direction[2]), time, maxDelta);
+}
+
+int32_t rr_GazeRecorderGetFixations(rr_GazeRecorder* recorder, int64_t t0, int64_t t1, rr_GazeFixation* outFixations, int32_t maxCount)
+{
+    if (!recorder) {
+        return 0;
+    }
+
+    try {
+        const auto fixations = recorder->recorder->getFixations(t0, t1);
+        const int32_t count = outFixations ? std::min(static_cast<int32_t>(fixations.size()), maxCount) : 0;
+        for (int32_t i = 0; i < count; i++) {
+            outFixations[i].start = fixations[i].start;
+            outFixations[i].end = fixations[i].end;
+            for (int c = 0; c < 3; c++) {
+                outFixations[i].direction[c] = fixations[i].direction[c];
+            }
+            outFixations[i].region = fixations[i].region;
+        }
+        return static_cast<int32_t>(fixations.size());
+    } catch (const std::exception& e) {
+        LOG_ERROR("rr_GazeRecorderGetFixations failed: %s", e.what());
+        return 0;
+    }
+}
+
+int32_t rr_GazeRecorderGetDwell(rr_GazeRecorder* recorder, double* outDwell, int32_t maxCount, int32_t* outColumns, int32_t* outRows)
+{
+    if (!recorder || !outDwell || !outColumns || !outRows) {
+        return 0;
+    }
+
+    try {
+        const GazeRecorder::Config& config = recorder->recorder->getConfig();
+        const auto dwell = recorder->recorder->getDwellTimes();
+        const int32_t count = std::min(static_cast<int32_t>(dwell.size()), maxCount);
+        std::copy(dwell.begin(), dwell.begin() + count, outDwell);
+        *outColumns = config.regionColumns;
+        *outRows = config.regionRows;
+        return count;
+    } catch (const std::exception& e) {
+        LOG_ERROR("rr_GazeRecorderGetDwell failed: %s", e.what());
+        return 0;
+    }
+}
+
+rr_KeyframeDatabase* rr_KeyframeDatabaseCreate(rr_FrameStore* frameStore, int64_t maxKeyframes, int64_t maxAge, double positionWeight)
+{
+    if (maxKeyframes <= 0 || positionWeight < 0.0) {
+        return nullptr;
+    }
+
+    try {
+        KeyframeDatabase::Config config;
+        config.maxKeyframes = static_cast<size_t>(maxKeyframes);
+        config.maxAge = std::max<int64_t>(maxAge, 0);
+        config.positionWeight = positionWeight;
+        auto handle = std::make_unique<rr_KeyframeDatabase>();
+        handle->database = std::make_unique<KeyframeDatabase>(config, frameStore ? frameStore->store.get() : nullptr);
+        return handle.release();
+    } catch (const std::exception& e) {
+        LOG_ERROR("rr_KeyframeDatabaseCreate failed: %s", e.what());
+        return nullptr;
+    }
+}
+
+void rr_KeyframeDatabaseDestroy(rr_KeyframeDatabase* database) { delete database; }
+
+uint64_t rr_KeyframeDatabaseAdd(rr_KeyframeDatabase* database, int64_t time, const double* hmdPose, uint64_t frame)
+{
+    if (!database || !hmdPose) {
+        return 0;
+    }
+
+    try {
+        return database->database->add(time, toVarjoPose(hmdPose), frame);
+    } catch (const std::exception& e) {
+        LOG_ERROR("rr_KeyframeDatabaseAdd failed: %s", e.what());
+        return 0;
+    }
+}
+
+int32_t rr_KeyframeDatabaseFindNearest(
+    rr_KeyframeDatabase* database, const double* hmdPose, int64_t t0, int64_t t1, double maxAngle, rr_KeyframeMatch* outMatch)
+{
+    KeyframeDatabase::Match match;
+    if (!database || !hmdPose || !outMatch || !database->database->findNearest(toVarjoPose(hmdPose), t0, t1, maxAngle, match)) {
+        return 0;
+    }
+
+    toApiKeyframe(match.keyframe, outMatch->keyframe);
+    outMatch->angle = match.angle;
+    outMatch->distance = match.distance;
+    outMatch->cost = match.cost;
+    return 1;
+}
+
+int32_t rr_KeyframeDatabaseGet(rr_KeyframeDatabase* database, uint64_t id, rr_Keyframe* outKeyframe)
+{
+    KeyframeDatabase::Keyframe keyframe;
+    if (!database || !outKeyframe || !database->database->get(id, keyframe)) {
+        return 0;
+    }
+
+    toApiKeyframe(keyframe, *outKeyframe);
+    return 1;
+}
+
+int64_t rr_KeyframeDatabaseEvictBefore(rr_KeyframeDatabase* database, int64_t time, int64_t maxCount)
+{
+    if (!database || maxCount <= 0) {
+        return 0;
+    }
+    return static_cast<int64_t>(database->database->evictBefore(time, static_cast<size_t>(maxCount)));
+}
+
+int32_t rr_KeyframeDatabaseGetStats(rr_KeyframeDatabase* database, rr_KeyframeDatabaseStats* outStats)
+{
+    if (!database || !outStats) {
+        return 0;
+    }
+
+    const KeyframeDatabase::Stats stats = database->database->getStats();
+    outStats->keyframes = static_cast<int64_t>(stats.keyframes);
+    outStats->added = static_cast<int64_t>(stats.added);
+    outStats->evicted = static_cast<int64_t>(stats.evicted);
+    outStats->queries = static_cast<int64_t>(stats.queries);
+    outStats->scanned = static_cast<int64_t>(stats.scanned);
+    return 1;
+}
+
+rr_SphericalStabilizer* rr_SphericalStabilizerCreate(float inlierAngleDeg, int32_t minInliers, float priorWeight)
+{
+    if (inlierAngleDeg <= 0.0f || minInliers < 3 || priorWeight < 0.0f || priorWeight > 1.0f) {
+        return nullptr;
+    }
+
+    try {
+        SphericalStabilizer::Config config;
+        config.inlierAngle = glm::radians(inlierAngleDeg);
+        config.minInliers = static_cast<size_t>(minInliers);
+        config.priorWeight = priorWeight;
+        auto handle = std::make_unique<rr_SphericalStabilizer>();
+        handle->stabilizer = std::make_unique<SphericalStabilizer>(config);
+        return handle.release();
+    } catch (const std::exception& e) {
+        LOG_ERROR("rr_SphericalStabilizerCreate failed: %s", e.what());
+        return nullptr;
+    }
+}
+
+void rr_SphericalStabilizerDestroy(rr_SphericalStabilizer* stabilizer) { delete stabilizer; }
+
+void rr_SphericalStabilizerReset(rr_SphericalStabilizer* stabilizer)
+{
+    if (stabilizer) {
+        stabilizer->stabilizer->reset();
+    }
+}
+
+int32_t rr_SphericalStabilizerUpdate(rr_SphericalStabilizer* stabilizer, const float* previous, const float* current, int32_t count, int32_t equirectWidth,
+    int32_t equirectHeight)
+{
+    if (!stabilizer || !previous || !current || count < 0 || equirectWidth <= 1 || equirectHeight <= 1) {
+        return 0;
+    }
+
+    try {
+        std::vector<SphericalStabilizer::Correspondence> correspondences(count);
+        for (int32_t i = 0; i < count; i++) {
+            const glm::vec2 from(previous[2 * i], previous[2 * i + 1]);
+            const glm::vec2 to(current[2 * i], current[2 * i + 1]);
+            correspondences[i].previous = SphericalStabilizer::equirectToBearing(from, equirectWidth, equirectHeight);
+            correspondences[i].current = SphericalStabilizer::equirectToBearing(to, equirectWidth, equirectHeight);
+        }
+        return stabilizer->stabilizer->update(correspondences) ? 1 : 0;
+    } catch (const std::exception& e) {
+        LOG_ERROR("rr_SphericalStabilizerUpdate failed: %s", e.what());
+        return 0;
+    }
+}
+
+int32_t rr_SphericalStabilizerSetMarkerPrior(rr_SphericalStabilizer* stabilizer, const float* reference, const float* current, int32_t count,
+    int32_t equirectWidth, int32_t equirectHeight)
+{
+    if (!stabilizer || !reference || !current || count < 3 || equirectWidth <= 1 || equirectHeight <= 1) {
+        return 0;
+    }
+
+    try {
+        std::vector<SphericalStabilizer::Correspondence> corners(count);
+        for (int32_t i = 0; i < count; i++) {
+            const glm::vec2 from(reference[2 * i], reference[2 * i + 1]);
+            const glm::vec2 to(current[2 * i], current[2 * i + 1]);
+            corners[i].previous = SphericalStabilizer::equirectToBearing(from, equirectWidth, equirectHeight);
+            corners[i].current = SphericalStabilizer::equirectToBearing(to, equirectWidth, equirectHeight);
+        }
+        stabilizer->stabilizer->setPrior(corners);
+        return 1;
+    } catch (const std::exception& e) {
+        LOG_ERROR("rr_SphericalStabilizerSetMarkerPrior failed: %s", e.what());
+        return 0;
+    }
+}
+
+int32_t rr_SphericalStabilizerGetRotation(rr_SphericalStabilizer* stabilizer, float outRotation[4])
+{
+    if (!stabilizer || !outRotation) {
+        return 0;
+    }
+
+    const glm::quat& rotation = stabilizer->stabilizer->getRotation();
+    outRotation[0] = rotation.w;
+    outRotation[1] = rotation.x;
+    outRotation[2] = rotation.y;
+    outRotation[3] = rotation.z;
+    return static_cast<int32_t>(stabilizer->stabilizer->getInlierCount());
+}
+
+int32_t rr_SphericalStabilizerBuildRemap(rr_SphericalStabilizer* stabilizer, int32_t equirectWidth, int32_t equirectHeight, float fovDeg, float thetaDeg,
+    float phiDeg, int32_t width, int32_t height, float* outMapX, float* outMapY)
+{
+    if (!stabilizer || !outMapX || !outMapY || equirectWidth <= 1 || equirectHeight <= 1 || width <= 0 || height <= 0 || fovDeg <= 0.0f ||
+        fovDeg >= 180.0f) {
+        return 0;
+    }
+
+    try {
+        std::vector<float> mapX;
+        std::vector<float> mapY;
+        stabilizer->stabilizer->buildRemap(equirectWidth, equirectHeight, fovDeg, thetaDeg, phiDeg, width, height, mapX, mapY);
+        std::copy(mapX.begin(), mapX.end(), outMapX);
+        std::copy(mapY.begin(), mapY.end(), outMapY);
+        return 1;
+    } catch (const std::exception& e) {
+        LOG_ERROR("rr_SphericalStabilizerBuildRemap failed: %s", e.what());
+        return 0;
+    }
+}
+
+rr_ChangeIndex* rr_ChangeIndexCreate(int32_t width, int32_t height, int32_t tileSize)
+{
+    if (width <= 0 || height <= 0 || tileSize <= 0) {
+        return nullptr;
+    }
+
+    try {
+        auto handle = std::make_unique<rr_ChangeIndex>();
+        handle->index = std::make_unique<ChangeIndex>(width, height, tileSize);
+        return handle.release();
+    } catch (const std::exception& e) {
+        LOG_ERROR("rr_ChangeIndexCreate failed: %s", e.what());
+        return nullptr;
+    }
+}
+
+void rr_ChangeIndexDestroy(rr_ChangeIndex* index) { delete index; }
+
+int32_t rr_ChangeIndexAddBox(rr_ChangeIndex* index, double time, int64_t object, int32_t x0, int32_t y0, int32_t x1, int32_t y1)
+{
+    if (!index) {
+        return 0;
+    }
+
+    try {
+        index->index->addChange(time, object, glm::ivec4(x0, y0, x1, y1));
+        return 1;
+    } catch (const std::exception& e) {
+        LOG_ERROR("rr_ChangeIndexAddBox failed: %s", e.what());
+        return 0;
+    }
+}
+
+int32_t rr_ChangeIndexAddMask(rr_ChangeIndex* index, double time, int64_t object, const uint8_t* mask, int32_t width, int32_t height, int32_t rowStride)
+{
+    if (!index || !mask || width <= 0 || height <= 0 || rowStride < width) {
+        return 0;
+    }
+
+    try {
+        index->index->addChange(time, object, RleMask::fromDense(mask, width, height, rowStride, 0));
+        return 1;
+    } catch (const std::exception& e) {
+        LOG_ERROR("rr_ChangeIndexAddMask failed: %s", e.what());
+        return 0;
+    }
+}
+
+int32_t rr_ChangeIndexQuery(
+    rr_ChangeIndex* index, int32_t x0, int32_t y0, int32_t x1, int32_t y1, double t0, double t1, rr_ChangeEvent* outEvents, int32_t maxCount)
+{
+    if (!index || (!outEvents && maxCount > 0) || maxCount < 0) {
+        return -1;
+    }
+
+    try {
+        const std::vector<ChangeIndex::Event> events = index->index->query(glm::ivec4(x0, y0, x1, y1), t0, t1);
+        const size_t count = std::min(events.size(), static_cast<size_t>(maxCount));
+        for (size_t i = 0; i < count; i++) {
+            outEvents[i].time = events[i].time;
+            outEvents[i].object = events[i].object;
+        }
+        return static_cast<int32_t>(std::min(events.size(), static_cast<size_t>(INT32_MAX)));
+    } catch (const std::exception& e) {
+        LOG_ERROR("rr_ChangeIndexQuery failed: %s", e.what());
+        return -1;
+    }
+}
+
+int32_t rr_ChangeIndexHasChange(rr_ChangeIndex* index, int32_t x0, int32_t y0, int32_t x1, int32_t y1, double t0, double t1)
+{
+    return (index && index->index->hasChange(glm::ivec4(x0, y0, x1, y1), t0, t1)) ? 1 : 0;
+}
+
+int32_t rr_ChangeIndexGetObjectSpan(rr_ChangeIndex* index, int64_t object, rr_ChangeSpan* outSpan)
+{
+    const ChangeIndex::ObjectSpan* span = index ? index->index->getObjectSpan(object) : nullptr;
+    if (!span || !outSpan) {
+        return 0;
+    }
+
+    outSpan->first = span->first;
+    outSpan->last = span->last;
+    outSpan->count = static_cast<int64_t>(span->count);
+    return 1;
+}
+
+int64_t rr_ChangeIndexGetEventCount(rr_ChangeIndex* index) { return index ? static_cast<int64_t>(index->index->getEventCount()) : 0; }
+
+void rr_ChangeIndexClear(rr_ChangeIndex* index)
+{
+    if (index) {
+        index->index->clear();
+    }
+}
+
+rr_TrajectoryStore* rr_TrajectoryStoreCreate(void)
+{
+    try {
+        return new rr_TrajectoryStore();
+    } catch (const std::exception& e) {
+        LOG_ERROR("rr_TrajectoryStoreCreate failed: %s", e.what());
+        return nullptr;
+    }
+}
+
+void rr_TrajectoryStoreDestroy(rr_TrajectoryStore* store) { delete store; }
+
+int32_t rr_TrajectoryStoreAppend(
+    rr_TrajectoryStore* store, int64_t object, const char* label, double time, float x, float y, const float bbox[4], float confidence)
+{
+    if (!store || !label || !bbox) {
+        return 0;
+    }
+
+    try {
+        TrajectoryStore::Sample sample;
+        sample.time = time;
+        sample.centroid = glm::vec2(x, y);
+        sample.bbox = glm::vec4(bbox[0], bbox[1], bbox[2], bbox[3]);
+        sample.confidence = confidence;
+        store->store.append(object, label, sample);
+        return 1;
+    } catch (const std::exception& e) {
+        LOG_ERROR("rr_TrajectoryStoreAppend failed: %s", e.what());
+        return 0;
+    }
+}
+
+int32_t rr_TrajectoryStoreQueryPolyline(
+    rr_TrajectoryStore* store, int64_t object, double t0, double t1, float tolerance, float* outPoints, int32_t maxCount)
+{
+    if (!store || (!outPoints && maxCount > 0) || maxCount < 0) {
+        return -1;
+    }
+
+    try {
+        const std::vector<glm::vec2> points = store->store.queryPolyline(object, t0, t1, tolerance);
+        const size_t count = std::min(points.size(), static_cast<size_t>(maxCount));
+        for (size_t i = 0; i < count; i++) {
+            outPoints[i * 2] = points[i].x;
+            outPoints[i * 2 + 1] = points[i].y;
+        }
+        return static_cast<int32_t>(std::min(points.size(), static_cast<size_t>(INT32_MAX)));
+    } catch (const std::exception& e) {
+        LOG_ERROR("rr_TrajectoryStoreQueryPolyline failed: %s", e.what());
+        return -1;
+    }
+}
+
+int64_t rr_TrajectoryStoreGetSampleCount(rr_TrajectoryStore* store) { return store ? static_cast<int64_t>(store->store.getSampleCount()) : 0; }
+
+void rr_TrajectoryStoreClear(rr_TrajectoryStore* store)
+{
+    if (store) {
+        store->store.clear();
+    }
+}
+
+rr_MaskStore* rr_MaskStoreCreate(int32_t width, int32_t height)
+{
+    if (width <= 0 || height <= 0 || width > std::numeric_limits<uint16_t>::max()) {
+        return nullptr;
+    }
+
+    try {
+        auto handle = std::make_unique<rr_MaskStore>();
+        handle->width = width;
+        handle->height = height;
+        return handle.release();
+    } catch (const std::exception& e) {
+        LOG_ERROR("rr_MaskStoreCreate failed: %s", e.what());
+        return nullptr;
+    }
+}
+
+void rr_MaskStoreDestroy(rr_MaskStore* store) { delete store; }
+
+int32_t rr_MaskStorePut(rr_MaskStore* store, int64_t frame, int64_t object, const uint8_t* mask, int32_t rowStride)
+{
+    if (!store || !mask || rowStride < store->width) {
+        return 0;
+    }
+
+    try {
+        store->store.store(frame, object, RleMask::fromDense(mask, store->width, store->height, rowStride, 0));
+        return 1;
+    } catch (const std::exception& e) {
+        LOG_ERROR("rr_MaskStorePut failed: %s", e.what());
+        return 0;
+    }
+}
+
+int32_t rr_MaskStoreGetMask(rr_MaskStore* store, int64_t frame, int64_t object, uint8_t* outMask, int32_t rowStride, uint8_t value)
+{
+    const RleMask* mask = store ? store->store.get(frame, object) : nullptr;
+    if (!mask || !outMask || rowStride < store->width) {
+        return 0;
+    }
+
+    mask->toDense(outMask, rowStride, value);
+    return 1;
+}
+
+int32_t rr_MaskStoreGetCentroid(rr_MaskStore* store, int64_t frame, int64_t object, float outCentroid[2])
+{
+    const RleMask* mask = store ? store->store.get(frame, object) : nullptr;
+    if (!mask || mask->empty() || !outCentroid) {
+        return 0;
+    }
+
+    const glm::vec2 centroid = mask->centroid();
+    outCentroid[0] = centroid.x;
+    outCentroid[1] = centroid.y;
+    return 1;
+}
+
+int32_t rr_MaskStoreGetUnion(rr_MaskStore* store, const int64_t* frames, int32_t frameCount, uint8_t* outMask, int32_t rowStride, uint8_t value)
+{
+    if (!store || (!frames && frameCount > 0) || frameCount < 0 || !outMask || rowStride < store->width) {
+        return 0;
+    }
+
+    try {
+        RleMask result(store->width, store->height);
+        for (int32_t i = 0; i < frameCount; i++) {
+            const RleMask frameUnion = store->store.getFrameUnion(frames[i]);
+            if (!frameUnion.empty()) {
+                result = RleMask::unite(result, frameUnion);
+            }
+        }
+        result.toDense(outMask, rowStride, value);
+        return 1;
+    } catch (const std::exception& e) {
+        LOG_ERROR("rr_MaskStoreGetUnion failed: %s", e.what());
+        return 0;
+    }
+}
+
+int64_t rr_MaskStoreGetCount(rr_MaskStore* store) { return store ? static_cast<int64_t>(store->store.getCount()) : 0; }
+
+int64_t rr_MaskStoreGetByteSize(rr_MaskStore* store) { return store ? static_cast<int64_t>(store->store.getByteSize()) : 0; }
+
+int32_t rr_MaskStoreSave(rr_MaskStore* store, const char* filename)
+{
+    return (store && filename && store->store.save(filename)) ? 1 : 0;
+}
+
+}  // extern "C"
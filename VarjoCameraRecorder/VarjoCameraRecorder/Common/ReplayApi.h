@@ -0,0 +1,790 @@
+#pragma once
+
+//! C interface to native replay components for Unity (P/Invoke) and Python (ctypes) bindings.
+//! All handles are opaque. Functions never throw; failures are reported through return values.
+
+#include <stdint.h>
+
+#if defined(_WIN32) && defined(REPLAY_API_EXPORTS)
+#define REPLAY_API __declspec(dllexport)
+#elif defined(_WIN32)
+#define REPLAY_API __declspec(dllimport)
+#else
+#define REPLAY_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//! Opaque frame cache handle
+typedef struct rr_FrameCache rr_FrameCache;
+
+//! Pinned frame returned by rr_FrameCacheAcquire. Pixels stay valid until rr_FrameCacheRelease.
+typedef struct rr_PinnedFrame {
+    const uint8_t* pixels;  //!< RGBA8 pixels, bottom row first, ready for Texture2D.LoadRawTextureData
+    int32_t width;          //!< Width in pixels
+    int32_t height;         //!< Height in pixels
+    int64_t byteSize;       //!< Pixel data size in bytes
+    void* token;            //!< Pin token for release
+} rr_PinnedFrame;
+
+//! Create frame cache decoding files from printf style path format (e.g. "out/replay/%04lld.png").
+REPLAY_API rr_FrameCache* rr_FrameCacheCreate(const char* pathFormat, int64_t budgetBytes, int32_t workerCount, int32_t prefetchDepth);
+
+//! Destroy frame cache. Pinned frames must be released before.
+REPLAY_API void rr_FrameCacheDestroy(rr_FrameCache* cache);
+
+//! Set valid frame index range [first, last]
+REPLAY_API void rr_FrameCacheSetRange(rr_FrameCache* cache, int64_t first, int64_t last);
+
+//! Acquire decoded frame. Returns 0 on failure.
+REPLAY_API int32_t rr_FrameCacheAcquire(rr_FrameCache* cache, int64_t index, rr_PinnedFrame* outFrame);
+
+//! Release frame acquired with rr_FrameCacheAcquire
+REPLAY_API void rr_FrameCacheRelease(rr_PinnedFrame* frame);
+
+//! Opaque framed connection and listener handles
+typedef struct rr_Connection rr_Connection;
+typedef struct rr_Listener rr_Listener;
+
+//! Message received with rr_ConnectionReceive. Data stays valid until rr_MessageRelease.
+typedef struct rr_Message {
+    const uint8_t* data;  //!< Payload
+    int64_t size;         //!< Payload size in bytes
+    uint32_t sequence;    //!< Message sequence number
+    uint16_t type;        //!< Application message type
+    void* token;          //!< Buffer token for release
+} rr_Message;
+
+//! Loopback framing benchmark result
+typedef struct rr_FramingBenchmarkResult {
+    double megabytesPerSecond;  //!< Payload throughput in MB/s
+    double messagesPerSecond;   //!< Message rate
+    double seconds;             //!< Duration in seconds
+} rr_FramingBenchmarkResult;
+
+//! Loopback multiplex benchmark result
+typedef struct rr_MultiplexBenchmarkResult {
+    double bulkMegabytesPerSecond;  //!< Bulk payload throughput in MB/s
+    double maxControlRoundTrip;     //!< Worst control round trip in seconds
+    double avgControlRoundTrip;     //!< Average control round trip in seconds
+    int64_t controlRoundTrips;      //!< Control echoes received
+    double seconds;                 //!< Duration in seconds
+} rr_MultiplexBenchmarkResult;
+
+//! Listen for framed connections on port. Returns null on failure.
+REPLAY_API rr_Listener* rr_ListenerCreate(int32_t port, int32_t maxChunkSize);
+
+//! Accept next connection. Blocks. Returns null when listener is closed.
+REPLAY_API rr_Connection* rr_ListenerAccept(rr_Listener* listener);
+
+//! Return port listener is bound to, e.g. the one picked for port 0
+REPLAY_API int32_t rr_ListenerGetPort(rr_Listener* listener);
+
+//! Close and destroy listener
+REPLAY_API void rr_ListenerDestroy(rr_Listener* listener);
+
+//! Connect to framed server. Returns null on failure.
+REPLAY_API rr_Connection* rr_ConnectionConnect(const char* host, int32_t port, int32_t maxChunkSize);
+
+//! Close and destroy connection. Received messages must be released before.
+REPLAY_API void rr_ConnectionDestroy(rr_Connection* connection);
+
+//! Send message. Returns 0 on failure.
+REPLAY_API int32_t rr_ConnectionSend(rr_Connection* connection, uint16_t type, const uint8_t* data, int64_t size);
+
+//! Receive next message. Blocks. Returns 0 on disconnect or protocol error.
+REPLAY_API int32_t rr_ConnectionReceive(rr_Connection* connection, rr_Message* outMessage);
+
+//! Release message received with rr_ConnectionReceive, returning its buffer to the pool
+REPLAY_API void rr_MessageRelease(rr_Message* message);
+
+//! Run loopback throughput benchmark. Returns 0 on failure.
+REPLAY_API int32_t rr_FramingBenchmark(int64_t messageSize, int32_t messageCount, int32_t chunkSize, rr_FramingBenchmarkResult* outResult);
+
+//! Run loopback multiplex benchmark streaming bulkCount frames on the bulk channel while echoing control messages every
+//! controlInterval seconds. Returns 0 on failure.
+REPLAY_API int32_t rr_MultiplexBenchmark(int64_t bulkSize, int32_t bulkCount, double controlInterval, rr_MultiplexBenchmarkResult* outResult);
+
+//! Run capture pipeline benchmark on synthetic frames of given color stream size and write Google Benchmark style JSON
+//! to file. Scaling cases run on 1 to maxThreads threads, all hardware threads if zero. Filter selects cases by name
+//! substring, null runs all. Returns 0 on failure.
+REPLAY_API int32_t rr_CaptureBenchmark(int32_t width, int32_t height, double minSeconds, int32_t maxThreads, int32_t pinWorkers,
+    const char* outputDirectory, const char* filter, const char* jsonFilename);
+
+//! Opaque multiplexed connection handle
+typedef struct rr_Multiplex rr_Multiplex;
+
+//! Multiplexed channel ids
+enum { RR_CHANNEL_CONTROL = 0, RR_CHANNEL_POSE = 1, RR_CHANNEL_BULK = 2 };
+
+//! Connect multiplexed connection with default channel configuration. Returns null on failure.
+REPLAY_API rr_Multiplex* rr_MultiplexConnect(const char* host, int32_t port);
+
+//! Accept next connection of listener as multiplexed connection with default channel configuration. Blocks. Returns
+//! null when listener is closed.
+REPLAY_API rr_Multiplex* rr_MultiplexAccept(rr_Listener* listener);
+
+//! Close and destroy multiplexed connection. Polled messages must be released before.
+REPLAY_API void rr_MultiplexDestroy(rr_Multiplex* mux);
+
+//! Queue copy of message on channel. Returns 0 if connection is closed.
+REPLAY_API int32_t rr_MultiplexSend(rr_Multiplex* mux, int32_t channel, uint16_t type, const uint8_t* data, int64_t size);
+
+//! Pop next received message of channel without blocking. Returns 0 if none is available. Release with rr_MessageRelease.
+REPLAY_API int32_t rr_MultiplexPoll(rr_Multiplex* mux, int32_t channel, rr_Message* outMessage);
+
+//! Pop next received message of channel, waiting up to timeout seconds for one, without limit if negative. Returns 0 on
+//! timeout or once the connection is closed and the channel drained. Release with rr_MessageRelease.
+REPLAY_API int32_t rr_MultiplexReceive(rr_Multiplex* mux, int32_t channel, double timeout, rr_Message* outMessage);
+
+//! Return 1 if connection is open
+REPLAY_API int32_t rr_MultiplexIsOpen(rr_Multiplex* mux);
+
+//! Opaque replay bundle writer and reader handles
+typedef struct rr_BundleWriter rr_BundleWriter;
+typedef struct rr_Bundle rr_Bundle;
+
+//! Replay bundle track types
+enum { RR_TRACK_IMAGE = 0, RR_TRACK_MASK = 1, RR_TRACK_OVERLAY = 2, RR_TRACK_DATA = 3 };
+
+//! Create replay bundle file for writing. Returns null on failure.
+REPLAY_API rr_BundleWriter* rr_BundleWriterCreate(const char* filename);
+
+//! Add track or return existing track with same name. Returns track id, or -1 on failure.
+REPLAY_API int32_t rr_BundleWriterAddTrack(rr_BundleWriter* writer, const char* name, int32_t type);
+
+//! Append frame to track. Returns 0 on failure.
+REPLAY_API int32_t rr_BundleWriterWrite(rr_BundleWriter* writer, int32_t track, int64_t frameIndex, const uint8_t* data, int64_t size);
+
+//! Write footer index, close file and destroy writer. Returns 0 on failure.
+REPLAY_API int32_t rr_BundleWriterClose(rr_BundleWriter* writer);
+
+//! Encode RGBA8 overlay as sparse tiles and append to track as keyframe or delta against the previous frame of the track.
+//! Fails if the track is not an overlay track or frameIndex is not above the last frame written to it. Returns 0 on failure.
+REPLAY_API int32_t rr_BundleWriterWriteOverlay(
+    rr_BundleWriter* writer, int32_t track, int64_t frameIndex, const uint8_t* rgba, int32_t width, int32_t height, int32_t rowStride);
+
+//! Open replay bundle for reading. Returns null on failure.
+REPLAY_API rr_Bundle* rr_BundleOpen(const char* filename);
+
+//! Close replay bundle. Frame pointers become invalid.
+REPLAY_API void rr_BundleClose(rr_Bundle* bundle);
+
+//! Return track id by name, or -1 if not found
+REPLAY_API int32_t rr_BundleFindTrack(rr_Bundle* bundle, const char* name);
+
+//! Return number of tracks
+REPLAY_API int32_t rr_BundleGetTrackCount(rr_Bundle* bundle);
+
+//! Copy zero terminated track name to buffer. Returns 0 if track is invalid.
+REPLAY_API int32_t rr_BundleGetTrackName(rr_Bundle* bundle, int32_t track, char* outName, int32_t nameCapacity);
+
+//! Return RR_TRACK_* type of track, -1 if track is invalid
+REPLAY_API int32_t rr_BundleGetTrackType(rr_Bundle* bundle, int32_t track);
+
+//! Get first and last frame index of track. Returns 0 if track is empty.
+REPLAY_API int32_t rr_BundleGetFrameRange(rr_Bundle* bundle, int32_t track, int64_t* outFirst, int64_t* outLast);
+
+//! Get frame bytes of track. Data points into the mapped file and stays valid until rr_BundleClose. Returns 0 if not found.
+REPLAY_API int32_t rr_BundleGetFrame(rr_Bundle* bundle, int32_t track, int64_t frameIndex, const uint8_t** outData, int64_t* outSize);
+
+//! Create frame cache decoding image or overlay track of bundle. Bundle may be closed before the cache.
+REPLAY_API rr_FrameCache* rr_FrameCacheCreateFromBundle(rr_Bundle* bundle, int32_t track, int64_t budgetBytes, int32_t workerCount, int32_t prefetchDepth);
+
+//! Opaque sparse tiled overlay handle
+typedef struct rr_Overlay rr_Overlay;
+
+//! Pixel rectangle of overlay tile
+typedef struct rr_TileRect {
+    int32_t x;       //!< Left edge
+    int32_t y;       //!< Top edge
+    int32_t width;   //!< Width in pixels
+    int32_t height;  //!< Height in pixels
+} rr_TileRect;
+
+//! Read serialized overlay keyframe. Returns null on failure and for delta frames, open those with rr_OverlayOpenFromBundle.
+REPLAY_API rr_Overlay* rr_OverlayOpen(const uint8_t* data, int64_t size);
+
+//! Open frame of bundle overlay track. Delta frames are reconstructed from their keyframe, so the overlay holds the full
+//! frame either way. Sequential frames of a track apply one delta each. Returns null on failure.
+REPLAY_API rr_Overlay* rr_OverlayOpenFromBundle(rr_Bundle* bundle, int32_t track, int64_t frameIndex);
+
+//! Destroy overlay
+REPLAY_API void rr_OverlayDestroy(rr_Overlay* overlay);
+
+//! Get frame size. Returns 0 on failure.
+REPLAY_API int32_t rr_OverlayGetSize(rr_Overlay* overlay, int32_t* outWidth, int32_t* outHeight);
+
+//! Return number of stored tiles
+REPLAY_API int32_t rr_OverlayGetTileCount(rr_Overlay* overlay);
+
+//! Decode stored tile to RGBA8 buffer of at least 32x32 pixels and output its rect. Returns 0 on failure.
+REPLAY_API int32_t rr_OverlayDecodeTile(rr_Overlay* overlay, int32_t tile, uint8_t* outPixels, int32_t rowStride, rr_TileRect* outRect);
+
+//! Decode full frame to RGBA8 buffer. Returns 0 on failure.
+REPLAY_API int32_t rr_OverlayDecode(rr_Overlay* overlay, uint8_t* outPixels, int32_t rowStride);
+
+//! Upload stored tiles to ID3D11Resource as sub-rects using ID3D11DeviceContext, clearing tiles left over from previous. Returns 0 on failure.
+REPLAY_API int32_t rr_OverlayUploadD3D11(rr_Overlay* overlay, rr_Overlay* previous, void* deviceContext, void* texture);
+
+//! Unity render event callback, see GL.IssuePluginEvent
+#if defined(_WIN32)
+typedef void(__stdcall* rr_RenderEventFunc)(int32_t eventId);
+#else
+typedef void (*rr_RenderEventFunc)(int32_t eventId);
+#endif
+
+//! Queue sub-rect upload of overlay to Unity texture (Texture2D.GetNativeTexturePtr, RGBA32 of frame size, bottom row first)
+//! for the render thread. Previous is the overlay the texture holds, or null. Overlays are copied, so they can be destroyed
+//! right after. Queued uploads run when the event of rr_OverlayGetRenderEventFunc is issued. Returns 0 on failure.
+REPLAY_API int32_t rr_OverlayQueueUploadD3D11(rr_Overlay* overlay, rr_Overlay* previous, void* texture);
+
+//! Return render event running queued overlay uploads on the Unity render thread. Returns null off Windows.
+REPLAY_API rr_RenderEventFunc rr_OverlayGetRenderEventFunc();
+
+//! Opaque overlay compositor handle
+typedef struct rr_Compositor rr_Compositor;
+
+//! Compositor layer formats and blend modes
+enum { RR_LAYER_RGBA8 = 0, RR_LAYER_ALPHA8 = 1 };
+enum { RR_BLEND_ADD = 0, RR_BLEND_OVER = 1, RR_BLEND_SCALE = 2 };
+
+//! Compositor source layer placed in output frame
+typedef struct rr_Layer {
+    const uint8_t* data;  //!< Pixel data, top row first
+    int32_t width;        //!< Width in pixels
+    int32_t height;       //!< Height in pixels
+    int32_t rowStride;    //!< Row stride in bytes
+    int32_t format;       //!< RR_LAYER_*
+    int32_t x;            //!< Left edge in output, may be negative
+    int32_t y;            //!< Top edge in output, may be negative
+    float tint[4];        //!< Per channel multiplier, or mask color for alpha layers
+} rr_Layer;
+
+//! Use of layer in output
+typedef struct rr_LayerUse {
+    int32_t output;  //!< Output index
+    int32_t layer;   //!< Layer index, unused by RR_BLEND_SCALE
+    float opacity;   //!< Layer weight in output, or output multiplier for RR_BLEND_SCALE
+    int32_t blend;   //!< RR_BLEND_*
+} rr_LayerUse;
+
+//! Create compositor with given thread count, 0 for hardware concurrency. Returns null on failure.
+REPLAY_API rr_Compositor* rr_CompositorCreate(int32_t threadCount);
+
+//! Destroy compositor
+REPLAY_API void rr_CompositorDestroy(rr_Compositor* compositor);
+
+//! Composite layers into RGBA8 outputs of given frame size. Uses are applied in order per output. Returns 0 on failure.
+REPLAY_API int32_t rr_Composite(rr_Compositor* compositor, int32_t width, int32_t height, const rr_Layer* layers, int32_t layerCount,
+    const rr_LayerUse* uses, int32_t useCount, uint8_t* const* outputs, const int32_t* rowStrides, int32_t outputCount);
+
+//! Opaque polyline layer handle
+typedef struct rr_Polyline rr_Polyline;
+
+//! Create polyline layer of given size and line width. Returns null on failure.
+REPLAY_API rr_Polyline* rr_PolylineCreate(int32_t width, int32_t height, float lineWidth);
+
+//! Destroy polyline layer
+REPLAY_API void rr_PolylineDestroy(rr_Polyline* polyline);
+
+//! Extend current polyline to vertex with color and alpha in [0, 1]. Only the new segment is rasterized.
+REPLAY_API void rr_PolylineAppend(rr_Polyline* polyline, float x, float y, const float color[4]);
+
+//! Draw complete polyline from count vertices of x, y, r, g, b, a floats. Ends current polyline.
+REPLAY_API void rr_PolylineDraw(rr_Polyline* polyline, const float* vertices, int32_t count);
+
+//! End current polyline. Next append starts a new one.
+REPLAY_API void rr_PolylineEnd(rr_Polyline* polyline);
+
+//! Clear layer
+REPLAY_API void rr_PolylineClear(rr_Polyline* polyline);
+
+//! Set line width for subsequent segments
+REPLAY_API void rr_PolylineSetLineWidth(rr_Polyline* polyline, float lineWidth);
+
+//! Get RGBA8 layer pixels. Data stays valid until rr_PolylineDestroy. Returns 0 on failure.
+REPLAY_API int32_t rr_PolylineGetData(rr_Polyline* polyline, const uint8_t** outData, int32_t* outRowStride);
+
+//! Get rect changed since previous call for sub-rect upload. Returns 0 if nothing changed.
+REPLAY_API int32_t rr_PolylineTakeDirtyRect(rr_Polyline* polyline, rr_TileRect* outRect);
+
+//! Opaque bounded frame store handle
+typedef struct rr_FrameStore rr_FrameStore;
+
+//! Frame pinned by rr_FrameStoreAcquire. Pixels stay valid until rr_FrameStoreUnpin.
+typedef struct rr_StoredFrame {
+    const uint8_t* pixels;  //!< Tightly packed pixels, top row first
+    int32_t width;          //!< Width in pixels
+    int32_t height;         //!< Height in pixels
+    int32_t channels;       //!< Bytes per pixel
+    void* token;            //!< Pin token for unpin
+} rr_StoredFrame;
+
+//! Frame store statistics
+typedef struct rr_FrameStoreStats {
+    int64_t frameCount;     //!< Frames in store
+    int64_t residentCount;  //!< Frames in memory
+    int64_t residentBytes;  //!< Bytes in memory
+    int64_t spilledCount;   //!< Frames only on disk
+    int64_t spillBytes;     //!< Spill file size in bytes
+    int64_t rawSpillBytes;  //!< Uncompressed size of data written to spill file
+    int64_t hits;           //!< Requests served from memory
+    int64_t reloads;        //!< Requests reloaded from spill file
+    int64_t evictions;      //!< Frames evicted from memory
+} rr_FrameStoreStats;
+
+//! Create frame store with spill file path and memory budget. Returns null on failure.
+REPLAY_API rr_FrameStore* rr_FrameStoreCreate(const char* spillFilename, int64_t budgetBytes);
+
+//! Destroy frame store and delete spill file. Pinned frames must be unpinned before.
+REPLAY_API void rr_FrameStoreDestroy(rr_FrameStore* store);
+
+//! Copy frame with 1 to 4 channels into store. Returns frame handle, or 0 on failure.
+REPLAY_API uint64_t rr_FrameStorePut(rr_FrameStore* store, const uint8_t* data, int32_t width, int32_t height, int32_t channels, int32_t rowStride);
+
+//! Pin frame, reloading it from spill file if evicted. Returns 0 on failure.
+REPLAY_API int32_t rr_FrameStoreAcquire(rr_FrameStore* store, uint64_t handle, rr_StoredFrame* outFrame);
+
+//! Unpin frame acquired with rr_FrameStoreAcquire
+REPLAY_API void rr_FrameStoreUnpin(rr_StoredFrame* frame);
+
+//! Remove frame from store
+REPLAY_API void rr_FrameStoreRelease(rr_FrameStore* store, uint64_t handle);
+
+//! Change memory budget
+REPLAY_API void rr_FrameStoreSetBudget(rr_FrameStore* store, int64_t budgetBytes);
+
+//! Get store statistics. Returns 0 on failure.
+REPLAY_API int32_t rr_FrameStoreGetStats(rr_FrameStore* store, rr_FrameStoreStats* outStats);
+
+//! Opaque inference work queue handle
+typedef struct rr_WorkQueue rr_WorkQueue;
+
+//! Work queue overflow policies and job outcomes
+enum { RR_QUEUE_DROP_OLDEST = 0, RR_QUEUE_KEEP_EVERY_KTH = 1, RR_QUEUE_LATEST_ONLY = 2, RR_QUEUE_BLOCK = 3 };
+enum { RR_JOB_COMPLETED = 0, RR_JOB_DROPPED = 1, RR_JOB_EXPIRED = 2, RR_JOB_CANCELLED = 3 };
+
+//! Job completion callback with outcome RR_JOB_*, queue wait and service time in seconds. Called once per job.
+typedef void (*rr_JobCallback)(void* userData, uint64_t id, int64_t timestamp, int32_t outcome, double waitSeconds, double serviceSeconds);
+
+//! Work queue statistics
+typedef struct rr_WorkQueueStats {
+    int64_t depth;              //!< Jobs currently queued
+    int64_t maxDepth;           //!< Largest queue depth seen
+    int64_t inFlight;           //!< Jobs popped but not completed
+    int64_t pushed;             //!< Jobs pushed
+    int64_t completed;          //!< Jobs completed
+    int64_t dropped;            //!< Jobs dropped by policy
+    int64_t expired;            //!< Jobs dropped by deadline
+    int64_t cancelled;          //!< Jobs cancelled
+    double meanWaitSeconds;     //!< Mean queue wait of popped jobs
+    double maxWaitSeconds;      //!< Largest queue wait of popped jobs
+    double lastWaitSeconds;     //!< Queue wait of last popped job
+    double meanServiceSeconds;  //!< Mean time from pop to completion
+} rr_WorkQueueStats;
+
+//! Create work queue with capacity, policy RR_QUEUE_*, keep interval, default maximum job age (0 disables) and optional
+//! completion callback. Returns null on failure.
+REPLAY_API rr_WorkQueue* rr_WorkQueueCreate(const char* name, int32_t capacity, int32_t policy, int32_t keepEvery, double maxAgeSeconds,
+    rr_JobCallback callback, void* userData);
+
+//! Destroy work queue. Queued jobs are cancelled.
+REPLAY_API void rr_WorkQueueDestroy(rr_WorkQueue* queue);
+
+//! Push job. Deadline in seconds from now, 0 uses queue default. Returns 0 if job was dropped.
+REPLAY_API int32_t rr_WorkQueuePush(rr_WorkQueue* queue, uint64_t id, int64_t timestamp, double deadlineSeconds);
+
+//! Pop oldest live job, waiting up to timeout seconds, negative waits forever. Returns 0 on timeout or close.
+REPLAY_API int32_t rr_WorkQueuePop(rr_WorkQueue* queue, double timeoutSeconds, uint64_t* outId, int64_t* outTimestamp, double* outWaitSeconds);
+
+//! Mark popped job completed, or cancelled if success is 0
+REPLAY_API void rr_WorkQueueComplete(rr_WorkQueue* queue, uint64_t id, int32_t success);
+
+//! Close queue, cancelling queued jobs and waking waiting threads
+REPLAY_API void rr_WorkQueueClose(rr_WorkQueue* queue);
+
+//! Get queue statistics. Returns 0 on failure.
+REPLAY_API int32_t rr_WorkQueueGetStats(rr_WorkQueue* queue, rr_WorkQueueStats* outStats);
+
+//! Opaque saliency clip buffer handle
+typedef struct rr_ClipBuffer rr_ClipBuffer;
+
+//! Strided view of latest clip window with shape (1, 3, length, height, width)
+typedef struct rr_ClipView {
+    const void* data;    //!< First sample of window
+    int64_t shape[5];    //!< Tensor shape N, C, T, H, W
+    int64_t strides[5];  //!< Strides in bytes
+    int64_t firstFrame;  //!< Sequence number of oldest frame in window
+    int32_t half;        //!< 1 if samples are half floats, 0 for 32-bit floats
+} rr_ClipView;
+
+//! Create clip buffer for model input size and window length. View stays valid for slack pushes. Returns null on failure.
+REPLAY_API rr_ClipBuffer* rr_ClipBufferCreate(int32_t width, int32_t height, int32_t length, int32_t slack, int32_t half);
+
+//! Destroy clip buffer
+REPLAY_API void rr_ClipBufferDestroy(rr_ClipBuffer* buffer);
+
+//! Resize, normalize and append 8-bit frame with 3 or 4 channels. Returns 0 on failure.
+REPLAY_API int32_t rr_ClipBufferPush(rr_ClipBuffer* buffer, const uint8_t* data, int32_t width, int32_t height, int32_t rowStride, int32_t channels);
+
+//! Get view of latest window. Returns 0 until enough frames are pushed.
+REPLAY_API int32_t rr_ClipBufferGetView(rr_ClipBuffer* buffer, rr_ClipView* outView);
+
+//! Drop all frames
+REPLAY_API void rr_ClipBufferClear(rr_ClipBuffer* buffer);
+
+//! Opaque micro-batching scheduler handle
+typedef struct rr_BatchScheduler rr_BatchScheduler;
+
+//! Preprocess callback writing request input into staging slot. Called on scheduler thread. Returns 0 to drop request.
+typedef int32_t (*rr_BatchPreprocess)(void* userData, uint64_t id, const uint8_t* input, int64_t inputSize, uint8_t* slot);
+
+//! Result callback, called once per request. completed is 0 for dropped requests.
+typedef void (*rr_BatchResult)(void* userData, uint64_t id, int32_t completed, const uint8_t* result, int64_t resultSize, double latencySeconds);
+
+//! Batch acquired for inference. Data and ids stay valid until rr_BatchSchedulerComplete.
+typedef struct rr_Batch {
+    uint64_t batchId;     //!< Batch id for completion
+    int32_t count;        //!< Requests in batch
+    uint8_t* data;        //!< Staging buffer, count slots of itemBytes
+    int64_t itemBytes;    //!< Slot size in bytes
+    const uint64_t* ids;  //!< Request ids in slot order
+} rr_Batch;
+
+//! Batch scheduler statistics
+typedef struct rr_BatchSchedulerStats {
+    int64_t submitted;            //!< Requests submitted
+    int64_t dropped;              //!< Requests dropped
+    int64_t completed;            //!< Requests completed
+    int64_t batches;              //!< Batches completed
+    double meanBatchSize;         //!< Mean requests per batch
+    double meanLatencySeconds;    //!< Mean submit to completion latency
+    double maxLatencySeconds;     //!< Largest submit to completion latency
+    int64_t overBound;            //!< Requests completed over latency bound
+    double meanInferenceSeconds;  //!< Mean acquire to completion time of batches
+} rr_BatchSchedulerStats;
+
+//! Create batch scheduler. Preprocess callback copies input if null. Returns null on failure.
+REPLAY_API rr_BatchScheduler* rr_BatchSchedulerCreate(int64_t itemBytes, int32_t maxBatchSize, int32_t stagingCount, double latencyBoundSeconds,
+    double maxDelaySeconds, int32_t maxPending, rr_BatchPreprocess preprocess, rr_BatchResult result, void* userData);
+
+//! Destroy batch scheduler. Acquired batches must be completed before.
+REPLAY_API void rr_BatchSchedulerDestroy(rr_BatchScheduler* scheduler);
+
+//! Submit request, input is copied
+REPLAY_API void rr_BatchSchedulerSubmit(rr_BatchScheduler* scheduler, uint64_t id, const uint8_t* input, int64_t inputSize);
+
+//! Acquire next batch, waiting up to timeout seconds, negative waits forever. Returns 0 on timeout or stop.
+REPLAY_API int32_t rr_BatchSchedulerAcquire(rr_BatchScheduler* scheduler, double timeoutSeconds, rr_Batch* outBatch);
+
+//! Complete batch. Results, if not null, are count entries of resultStride bytes.
+REPLAY_API void rr_BatchSchedulerComplete(rr_BatchScheduler* scheduler, uint64_t batchId, const uint8_t* results, int64_t resultStride);
+
+//! Get staging buffers for pinning. Returns buffer count, writes up to maxCount pointers and buffer size.
+REPLAY_API int32_t rr_BatchSchedulerGetStaging(rr_BatchScheduler* scheduler, uint8_t** outBuffers, int32_t maxCount, int64_t* outSize);
+
+//! Stop scheduler and wake threads waiting in rr_BatchSchedulerAcquire
+REPLAY_API void rr_BatchSchedulerStop(rr_BatchScheduler* scheduler);
+
+//! Get scheduler statistics. Returns 0 on failure.
+REPLAY_API int32_t rr_BatchSchedulerGetStats(rr_BatchScheduler* scheduler, rr_BatchSchedulerStats* outStats);
+
+//! Latency collector over frame traces
+typedef struct rr_LatencyCollector rr_LatencyCollector;
+
+//! Latency distribution in seconds
+typedef struct rr_LatencyStats {
+    int64_t count;  //!< Samples
+    double mean;    //!< Mean
+    double p50;     //!< Median
+    double p90;     //!< 90th percentile
+    double p99;     //!< 99th percentile
+    double max;     //!< Largest
+} rr_LatencyStats;
+
+//! Return trace clock time in nanoseconds, shared by all processes on the machine
+REPLAY_API int64_t rr_TraceNow();
+
+//! Create latency collector keeping at most maxSamples samples per stage. Returns null on failure.
+REPLAY_API rr_LatencyCollector* rr_LatencyCollectorCreate(int64_t maxSamples);
+
+//! Destroy latency collector
+REPLAY_API void rr_LatencyCollectorDestroy(rr_LatencyCollector* collector);
+
+//! Add serialized frame trace. Returns 0 if record is invalid.
+REPLAY_API int32_t rr_LatencyCollectorRecord(rr_LatencyCollector* collector, const uint8_t* record, int64_t size);
+
+//! Add all traces of session trace log. Returns number of traces read.
+REPLAY_API int64_t rr_LatencyCollectorLoadLog(rr_LatencyCollector* collector, const char* filename);
+
+//! Get latency into stage from previous stamped stage. Stage count gets total latency. Returns 0 on failure.
+REPLAY_API int32_t rr_LatencyCollectorGetStats(rr_LatencyCollector* collector, int32_t stage, rr_LatencyStats* outStats);
+
+//! Write JSON report of per-stage latencies. Returns 0 on failure.
+REPLAY_API int32_t rr_LatencyCollectorWriteReport(rr_LatencyCollector* collector, const char* filename);
+
+//! Gaze-contingent two-level frame
+typedef struct rr_FovealFrame rr_FovealFrame;
+
+//! Two-level frame layout
+typedef struct rr_FovealInfo {
+    int32_t width;           //!< Full frame width
+    int32_t height;          //!< Full frame height
+    int32_t peripheryScale;  //!< Periphery downsampling factor
+    int32_t gazeValid;       //!< 1 if region follows gaze, 0 if centered on frame
+    int32_t fixationX;       //!< Fixation pixel x
+    int32_t fixationY;       //!< Fixation pixel y
+    rr_TileRect roi;         //!< Full resolution region
+} rr_FovealInfo;
+
+//! Read serialized two-level frame as stored by gaze-contingent capture. Returns null on failure.
+REPLAY_API rr_FovealFrame* rr_FovealFrameOpen(const uint8_t* data, int64_t size);
+
+//! Destroy two-level frame
+REPLAY_API void rr_FovealFrameDestroy(rr_FovealFrame* frame);
+
+//! Get frame layout. Returns 0 on failure.
+REPLAY_API int32_t rr_FovealFrameGetInfo(rr_FovealFrame* frame, rr_FovealInfo* outInfo);
+
+//! Reconstruct full frame to BGRA8 buffer, upsampling periphery. Returns 0 on failure.
+REPLAY_API int32_t rr_FovealFrameDecode(rr_FovealFrame* frame, uint8_t* outPixels, int32_t rowStride);
+
+//! Gaze history of a session
+typedef struct rr_GazeRecorder rr_GazeRecorder;
+
+//! Gaze sample
+typedef struct rr_GazeSample {
+    int64_t time;          //!< Capture time in Varjo time, the clock of frame trace sensor timestamps
+    double gaze[3];        //!< Gaze direction in HMD space, +Z forward
+    double world[3];       //!< Gaze direction in world space, -Z forward
+    double focusDistance;  //!< Focus distance in meters, zero if not estimated
+    int32_t status;        //!< Gaze status, 2 if valid
+    int32_t hasWorld;      //!< 1 if world direction is known
+} rr_GazeSample;
+
+//! Gaze fixation
+typedef struct rr_GazeFixation {
+    int64_t start;        //!< First sample time
+    int64_t end;          //!< Last sample time
+    double direction[3];  //!< Mean world direction
+    int32_t region;       //!< Dwell region of direction
+} rr_GazeFixation;
+
+//! Create gaze recorder keeping up to capacity samples, filled with rr_GazeRecorderLoadLog. Returns null on failure.
+REPLAY_API rr_GazeRecorder* rr_GazeRecorderCreate(int32_t capacity);
+
+//! Destroy gaze recorder
+REPLAY_API void rr_GazeRecorderDestroy(rr_GazeRecorder* recorder);
+
+//! Add all samples of gaze log. Returns number of samples read.
+REPLAY_API int64_t rr_GazeRecorderLoadLog(rr_GazeRecorder* recorder, const char* filename);
+
+//! Write all samples to gaze log. Returns 0 on failure.
+REPLAY_API int32_t rr_GazeRecorderWriteLog(rr_GazeRecorder* recorder, const char* filename);
+
+//! Get sample closest to time within maxDelta nanoseconds. Returns 0 if none.
+REPLAY_API int32_t rr_GazeRecorderGetSampleAt(rr_GazeRecorder* recorder, int64_t time, int64_t maxDelta, rr_GazeSample* outSample);
+
+//! Return angle in radians between world gaze at time and world direction, negative if no valid gaze within maxDelta
+REPLAY_API double rr_GazeRecorderGetAngleTo(rr_GazeRecorder* recorder, const double* direction, int64_t time, int64_t maxDelta);
+
+//! Get up to maxCount fixations overlapping [t0, t1]. Returns number of fixations available.
+REPLAY_API int32_t rr_GazeRecorderGetFixations(
+    rr_GazeRecorder* recorder, int64_t t0, int64_t t1, rr_GazeFixation* outFixations, int32_t maxCount);
+
+//! Get dwell seconds per region, rows from bottom and columns from yaw -180 degrees. Returns region count, 0 on failure.
+REPLAY_API int32_t rr_GazeRecorderGetDwell(rr_GazeRecorder* recorder, double* outDwell, int32_t maxCount, int32_t* outColumns, int32_t* outRows);
+
+//! Opaque keyframe database handle
+typedef struct rr_KeyframeDatabase rr_KeyframeDatabase;
+
+//! Keyframe
+typedef struct rr_Keyframe {
+    uint64_t id;         //!< Keyframe id
+    int64_t time;        //!< Capture time in Varjo time
+    double hmdPose[16];  //!< HMD pose in world space, column major
+    uint64_t frame;      //!< Frame store handle
+} rr_Keyframe;
+
+//! Nearest viewpoint query result
+typedef struct rr_KeyframeMatch {
+    rr_Keyframe keyframe;  //!< Matched keyframe
+    double angle;          //!< View direction angle in radians
+    double distance;       //!< Position offset in meters
+    double cost;           //!< Angle plus weighted distance
+} rr_KeyframeMatch;
+
+//! Keyframe database statistics
+typedef struct rr_KeyframeDatabaseStats {
+    int64_t keyframes;  //!< Keyframes in database
+    int64_t added;      //!< Keyframes added
+    int64_t evicted;    //!< Keyframes evicted
+    int64_t queries;    //!< Nearest viewpoint queries
+    int64_t scanned;    //!< Keyframes compared by queries
+} rr_KeyframeDatabaseStats;
+
+//! Create keyframe database keeping up to maxKeyframes keyframes, and none older than maxAge nanoseconds if maxAge is
+//! positive. Position weight is match cost in radians per meter. Frames of evicted keyframes are released from frame
+//! store if given, the store must outlive the database. Returns null on failure.
+REPLAY_API rr_KeyframeDatabase* rr_KeyframeDatabaseCreate(rr_FrameStore* frameStore, int64_t maxKeyframes, int64_t maxAge, double positionWeight);
+
+//! Destroy keyframe database
+REPLAY_API void rr_KeyframeDatabaseDestroy(rr_KeyframeDatabase* database);
+
+//! Add keyframe with column major HMD pose and frame store handle. Times must not decrease. Returns keyframe id, or 0 on failure.
+REPLAY_API uint64_t rr_KeyframeDatabaseAdd(rr_KeyframeDatabase* database, int64_t time, const double* hmdPose, uint64_t frame);
+
+//! Find keyframe captured in [t0, t1] with the viewpoint closest to column major HMD pose, within maxAngle radians of
+//! its view direction. Returns 0 if none.
+REPLAY_API int32_t rr_KeyframeDatabaseFindNearest(
+    rr_KeyframeDatabase* database, const double* hmdPose, int64_t t0, int64_t t1, double maxAngle, rr_KeyframeMatch* outMatch);
+
+//! Get keyframe by id. Returns 0 if unknown or evicted.
+REPLAY_API int32_t rr_KeyframeDatabaseGet(rr_KeyframeDatabase* database, uint64_t id, rr_Keyframe* outKeyframe);
+
+//! Evict up to maxCount oldest keyframes captured before time. Returns number evicted.
+REPLAY_API int64_t rr_KeyframeDatabaseEvictBefore(rr_KeyframeDatabase* database, int64_t time, int64_t maxCount);
+
+//! Get database statistics. Returns 0 on failure.
+REPLAY_API int32_t rr_KeyframeDatabaseGetStats(rr_KeyframeDatabase* database, rr_KeyframeDatabaseStats* outStats);
+
+//! Opaque rotation-only stabilizer handle for equirectangular frames
+typedef struct rr_SphericalStabilizer rr_SphericalStabilizer;
+
+//! Create stabilizer. Inlier angle is in degrees, prior weight in [0, 1]. Returns null on failure.
+REPLAY_API rr_SphericalStabilizer* rr_SphericalStabilizerCreate(float inlierAngleDeg, int32_t minInliers, float priorWeight);
+
+//! Destroy stabilizer
+REPLAY_API void rr_SphericalStabilizerDestroy(rr_SphericalStabilizer* stabilizer);
+
+//! Reset rotation to the current orientation
+REPLAY_API void rr_SphericalStabilizerReset(rr_SphericalStabilizer* stabilizer);
+
+//! Update rotation from count tracked feature pairs given as interleaved (x, y) equirect pixel coordinates in previous and
+//! current frame. Returns 1 if the visual estimate was accepted, 0 if rejected or on failure.
+REPLAY_API int32_t rr_SphericalStabilizerUpdate(rr_SphericalStabilizer* stabilizer, const float* previous, const float* current, int32_t count,
+    int32_t equirectWidth, int32_t equirectHeight);
+
+//! Set prior for the next update from count corners of a static marker given as interleaved (x, y) equirect pixel coordinates in the
+//! reference frame and the current frame. Needs at least three corners. Returns 0 on failure.
+REPLAY_API int32_t rr_SphericalStabilizerSetMarkerPrior(rr_SphericalStabilizer* stabilizer, const float* reference, const float* current, int32_t count,
+    int32_t equirectWidth, int32_t equirectHeight);
+
+//! Get camera rotation relative to reference orientation as quaternion (w, x, y, z). Returns inlier count of latest update.
+REPLAY_API int32_t rr_SphericalStabilizerGetRotation(rr_SphericalStabilizer* stabilizer, float outRotation[4]);
+
+//! Build stabilized perspective remap tables of width * height floats for cv2.remap. Theta is yaw and phi pitch in degrees, as in
+//! Equirec2Perspec.GetPerspective. Returns 0 on failure.
+REPLAY_API int32_t rr_SphericalStabilizerBuildRemap(rr_SphericalStabilizer* stabilizer, int32_t equirectWidth, int32_t equirectHeight, float fovDeg,
+    float thetaDeg, float phiDeg, int32_t width, int32_t height, float* outMapX, float* outMapY);
+
+//! Opaque spatio-temporal change index handle
+typedef struct rr_ChangeIndex rr_ChangeIndex;
+
+//! Change event returned by rr_ChangeIndexQuery
+typedef struct rr_ChangeEvent {
+    double time;     //!< Event time
+    int64_t object;  //!< Changed object
+} rr_ChangeEvent;
+
+//! First and last change of an object
+typedef struct rr_ChangeSpan {
+    double first;   //!< First change time
+    double last;    //!< Last change time
+    int64_t count;  //!< Number of changes
+} rr_ChangeSpan;
+
+//! Create change index over region of given size split into square tiles. Returns null on failure.
+REPLAY_API rr_ChangeIndex* rr_ChangeIndexCreate(int32_t width, int32_t height, int32_t tileSize);
+
+//! Destroy change index
+REPLAY_API void rr_ChangeIndexDestroy(rr_ChangeIndex* index);
+
+//! Add change covering pixel bounds (x0, y0, x1, y1), exclusive max. Returns 0 on failure.
+REPLAY_API int32_t rr_ChangeIndexAddBox(rr_ChangeIndex* index, double time, int64_t object, int32_t x0, int32_t y0, int32_t x1, int32_t y1);
+
+//! Add change covering non-zero pixels of 8-bit mask, scaled from mask size to region size. Returns 0 on failure.
+REPLAY_API int32_t rr_ChangeIndexAddMask(
+    rr_ChangeIndex* index, double time, int64_t object, const uint8_t* mask, int32_t width, int32_t height, int32_t rowStride);
+
+//! Query events in tiles overlapping pixel region within [t0, t1], sorted by time. Writes up to maxCount events and returns the
+//! total event count, -1 on failure.
+REPLAY_API int32_t rr_ChangeIndexQuery(
+    rr_ChangeIndex* index, int32_t x0, int32_t y0, int32_t x1, int32_t y1, double t0, double t1, rr_ChangeEvent* outEvents, int32_t maxCount);
+
+//! Return 1 if any change occurred in pixel region within [t0, t1]
+REPLAY_API int32_t rr_ChangeIndexHasChange(rr_ChangeIndex* index, int32_t x0, int32_t y0, int32_t x1, int32_t y1, double t0, double t1);
+
+//! Get first and last change of object. Returns 0 if unknown.
+REPLAY_API int32_t rr_ChangeIndexGetObjectSpan(rr_ChangeIndex* index, int64_t object, rr_ChangeSpan* outSpan);
+
+//! Return total event count over all tiles
+REPLAY_API int64_t rr_ChangeIndexGetEventCount(rr_ChangeIndex* index);
+
+//! Remove all events
+REPLAY_API void rr_ChangeIndexClear(rr_ChangeIndex* index);
+
+//! Opaque per-object trajectory store handle
+typedef struct rr_TrajectoryStore rr_TrajectoryStore;
+
+//! Create empty trajectory store. Returns null on failure.
+REPLAY_API rr_TrajectoryStore* rr_TrajectoryStoreCreate(void);
+
+//! Destroy trajectory store
+REPLAY_API void rr_TrajectoryStoreDestroy(rr_TrajectoryStore* store);
+
+//! Append sample with centroid (x, y) and bounding box (x0, y0, x1, y1) in pixels to object trajectory, label is kept from
+//! the first sample. Returns 0 on failure.
+REPLAY_API int32_t rr_TrajectoryStoreAppend(
+    rr_TrajectoryStore* store, int64_t object, const char* label, double time, float x, float y, const float bbox[4], float confidence);
+
+//! Query object centroids within [t0, t1] as interleaved (x, y), simplified with given pixel tolerance. Writes up to maxCount
+//! points and returns the total point count, -1 on failure.
+REPLAY_API int32_t rr_TrajectoryStoreQueryPolyline(
+    rr_TrajectoryStore* store, int64_t object, double t0, double t1, float tolerance, float* outPoints, int32_t maxCount);
+
+//! Return total sample count over all objects
+REPLAY_API int64_t rr_TrajectoryStoreGetSampleCount(rr_TrajectoryStore* store);
+
+//! Remove all trajectories
+REPLAY_API void rr_TrajectoryStoreClear(rr_TrajectoryStore* store);
+
+//! Opaque run-length encoded object mask store handle
+typedef struct rr_MaskStore rr_MaskStore;
+
+//! Create mask store for masks of given frame size, width up to 65535. Returns null on failure.
+REPLAY_API rr_MaskStore* rr_MaskStoreCreate(int32_t width, int32_t height);
+
+//! Destroy mask store
+REPLAY_API void rr_MaskStoreDestroy(rr_MaskStore* store);
+
+//! Encode non-zero pixels of 8-bit mask of store frame size and store it for frame and object, replacing an earlier mask.
+//! Returns 0 on failure.
+REPLAY_API int32_t rr_MaskStorePut(rr_MaskStore* store, int64_t frame, int64_t object, const uint8_t* mask, int32_t rowStride);
+
+//! Decode mask of frame and object into 8-bit image of store frame size, set pixels written with value. Returns 0 if not found.
+REPLAY_API int32_t rr_MaskStoreGetMask(rr_MaskStore* store, int64_t frame, int64_t object, uint8_t* outMask, int32_t rowStride, uint8_t value);
+
+//! Get mask centroid (x, y) in pixels. Returns 0 if not found or empty.
+REPLAY_API int32_t rr_MaskStoreGetCentroid(rr_MaskStore* store, int64_t frame, int64_t object, float outCentroid[2]);
+
+//! Decode union of all object masks in given frames into 8-bit image of store frame size, set pixels written with value. The
+//! union is built on the runs. Returns 0 on failure.
+REPLAY_API int32_t rr_MaskStoreGetUnion(
+    rr_MaskStore* store, const int64_t* frames, int32_t frameCount, uint8_t* outMask, int32_t rowStride, uint8_t value);
+
+//! Return mask count
+REPLAY_API int64_t rr_MaskStoreGetCount(rr_MaskStore* store);
+
+//! Return total encoded size in bytes
+REPLAY_API int64_t rr_MaskStoreGetByteSize(rr_MaskStore* store);
+
+//! Save all masks to file. Returns 0 on failure.
+REPLAY_API int32_t rr_MaskStoreSave(rr_MaskStore* store, const char* filename);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,460 @@
+#include "ReplayBundle.hpp"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+using namespace VarjoExamples;
+
+// Padding before an entry header so that its payload starts on alignment boundary
+uint64_t getEntryPadding(uint64_t offset)
+{
+    const uint64_t payloadOffset = offset + sizeof(ReplayBundle::EntryHeader);
+    return (ReplayBundle::c_alignment - payloadOffset % ReplayBundle::c_alignment) % ReplayBundle::c_alignment;
+}
+
+// Sort entries by frame index. Later writes of the same frame replace earlier ones.
+void sortEntries(std::vector<ReplayBundle::IndexEntry>& entries)
+{
+    std::stable_sort(entries.begin(), entries.end(), [](const auto& a, const auto& b) { return a.frameIndex < b.frameIndex; });
+
+    size_t count = 0;
+    for (size_t i = 0; i < entries.size(); i++) {
+        if (i + 1 < entries.size() && entries[i + 1].frameIndex == entries[i].frameIndex) {
+            continue;
+        }
+        entries[count++] = entries[i];
+    }
+    entries.resize(count);
+}
+
+const uint8_t c_zeros[ReplayBundle::c_alignment] = {};
+
+// Track type read from file is one of TrackType
+bool isValidTrackType(uint32_t type) { return type <= static_cast<uint32_t>(ReplayBundle::TrackType::Data); }
+
+}  // namespace
+
+namespace VarjoExamples
+{
+ReplayBundleWriter::~ReplayBundleWriter()
+{
+    if (isOpen()) {
+        finish();
+    }
+}
+
+bool ReplayBundleWriter::open(const std::string& filename)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_file.is_open()) {
+        LOG_ERROR("Replay bundle already open.");
+        return false;
+    }
+
+    m_file.open(filename, std::ofstream::binary | std::ofstream::trunc);
+    if (!m_file) {
+        LOG_ERROR("Creating replay bundle failed: %s", filename.c_str());
+        return false;
+    }
+
+    const ReplayBundle::FileHeader header;
+    m_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    m_offset = sizeof(header);
+    m_tracks.clear();
+    m_entries.clear();
+    return true;
+}
+
+int ReplayBundleWriter::addTrack(const std::string& name, ReplayBundle::TrackType type)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_file.is_open() || name.empty() || name.size() > ReplayBundle::c_maxNameLength) {
+        LOG_ERROR("Invalid replay bundle track: %s", name.c_str());
+        return -1;
+    }
+
+    for (const auto& track : m_tracks) {
+        if (name == track.name) {
+            return static_cast<int>(track.id);
+        }
+    }
+
+    ReplayBundle::TrackRecord record;
+    record.id = static_cast<uint32_t>(m_tracks.size());
+    record.type = static_cast<uint32_t>(type);
+    memcpy(record.name, name.data(), name.size());
+
+    // Definition record lets a scan recover track names of an unfinished bundle
+    uint64_t offset = 0;
+    if (!appendRecord(ReplayBundle::c_trackDefinition, record.id, &record, sizeof(record), offset)) {
+        return -1;
+    }
+
+    m_tracks.push_back(record);
+    m_entries.emplace_back();
+    return static_cast<int>(record.id);
+}
+
+bool ReplayBundleWriter::write(int track, int64_t frameIndex, const void* data, size_t size)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_file.is_open() || track < 0 || track >= static_cast<int>(m_tracks.size())) {
+        return false;
+    }
+
+    ReplayBundle::IndexEntry entry;
+    entry.frameIndex = frameIndex;
+    entry.size = size;
+    if (!appendRecord(static_cast<uint32_t>(track), frameIndex, data, size, entry.offset)) {
+        return false;
+    }
+    m_entries[track].push_back(entry);
+    return true;
+}
+
+bool ReplayBundleWriter::getTrackType(int track, ReplayBundle::TrackType& outType) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (track < 0 || track >= static_cast<int>(m_tracks.size())) {
+        return false;
+    }
+    outType = static_cast<ReplayBundle::TrackType>(m_tracks[track].type);
+    return true;
+}
+
+bool ReplayBundleWriter::finish()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_file.is_open()) {
+        return false;
+    }
+
+    // Index starts 8 byte aligned so mapped readers can use records in place
+    const uint64_t padding = (8 - m_offset % 8) % 8;
+    m_file.write(reinterpret_cast<const char*>(c_zeros), padding);
+
+    ReplayBundle::Trailer trailer;
+    trailer.indexOffset = m_offset + padding;
+    trailer.trackCount = static_cast<uint32_t>(m_tracks.size());
+
+    for (size_t i = 0; i < m_tracks.size(); i++) {
+        sortEntries(m_entries[i]);
+        m_tracks[i].firstEntry = trailer.entryCount;
+        m_tracks[i].entryCount = m_entries[i].size();
+        trailer.entryCount += m_entries[i].size();
+    }
+
+    m_file.write(reinterpret_cast<const char*>(m_tracks.data()), m_tracks.size() * sizeof(ReplayBundle::TrackRecord));
+    for (const auto& entries : m_entries) {
+        m_file.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(ReplayBundle::IndexEntry));
+    }
+    m_file.write(reinterpret_cast<const char*>(&trailer), sizeof(trailer));
+
+    m_file.close();
+    const bool ok = !m_file.fail();
+
+    if (!ok) {
+        LOG_ERROR("Writing replay bundle index failed.");
+    }
+    return ok;
+}
+
+bool ReplayBundleWriter::isOpen() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_file.is_open();
+}
+
+bool ReplayBundleWriter::appendRecord(uint32_t track, int64_t frameIndex, const void* data, size_t size, uint64_t& outOffset)
+{
+    const uint64_t padding = getEntryPadding(m_offset);
+    m_file.write(reinterpret_cast<const char*>(c_zeros), padding);
+
+    ReplayBundle::EntryHeader header;
+    header.track = track;
+    header.frameIndex = frameIndex;
+    header.size = size;
+    m_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    m_file.write(static_cast<const char*>(data), size);
+
+    if (!m_file) {
+        LOG_ERROR("Writing replay bundle failed: track=%u, frame=%lld", track, frameIndex);
+        return false;
+    }
+
+    outOffset = m_offset + padding + sizeof(header);
+    m_offset = outOffset + size;
+    return true;
+}
+
+ReplayBundleReader::~ReplayBundleReader() { close(); }
+
+bool ReplayBundleReader::open(const std::string& filename)
+{
+    close();
+
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        LOG_ERROR("Opening replay bundle failed: %s", filename.c_str());
+        return false;
+    }
+    m_fileHandle = file;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart < static_cast<LONGLONG>(sizeof(ReplayBundle::FileHeader))) {
+        LOG_ERROR("Invalid replay bundle size: %s", filename.c_str());
+        close();
+        return false;
+    }
+    m_size = static_cast<uint64_t>(size.QuadPart);
+
+    m_mappingHandle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (m_mappingHandle) {
+        m_data = static_cast<const uint8_t*>(MapViewOfFile(m_mappingHandle, FILE_MAP_READ, 0, 0, 0));
+    }
+#else
+    const int file = ::open(filename.c_str(), O_RDONLY);
+    if (file < 0) {
+        LOG_ERROR("Opening replay bundle failed: %s", filename.c_str());
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(file, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(ReplayBundle::FileHeader))) {
+        LOG_ERROR("Invalid replay bundle size: %s", filename.c_str());
+        ::close(file);
+        return false;
+    }
+    m_size = static_cast<uint64_t>(info.st_size);
+
+    // Mapping stays valid after closing the descriptor
+    void* data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, file, 0);
+    ::close(file);
+    if (data != MAP_FAILED) {
+        m_data = static_cast<const uint8_t*>(data);
+    }
+#endif
+    if (!m_data) {
+        LOG_ERROR("Mapping replay bundle failed: %s", filename.c_str());
+        close();
+        return false;
+    }
+
+    ReplayBundle::FileHeader header;
+    memcpy(&header, m_data, sizeof(header));
+    if (header.magic != ReplayBundle::c_fileMagic || header.version != ReplayBundle::c_version) {
+        LOG_ERROR("Invalid replay bundle: magic=%x, version=%u", header.magic, header.version);
+        close();
+        return false;
+    }
+
+    if (!loadIndex()) {
+        LOG_WARNING("Replay bundle has no index, scanning: %s", filename.c_str());
+        if (!scanIndex()) {
+            close();
+            return false;
+        }
+    }
+    return true;
+}
+
+void ReplayBundleReader::close()
+{
+#if defined(_WIN32)
+    if (m_data) {
+        UnmapViewOfFile(m_data);
+        m_data = nullptr;
+    }
+    if (m_mappingHandle) {
+        CloseHandle(m_mappingHandle);
+        m_mappingHandle = nullptr;
+    }
+    if (m_fileHandle) {
+        CloseHandle(m_fileHandle);
+        m_fileHandle = nullptr;
+    }
+#else
+    if (m_data) {
+        munmap(const_cast<uint8_t*>(m_data), m_size);
+        m_data = nullptr;
+    }
+#endif
+    m_size = 0;
+    m_tracks.clear();
+    m_scanned.clear();
+    m_recovered = false;
+}
+
+int ReplayBundleReader::findTrack(const std::string& name) const
+{
+    for (size_t i = 0; i < m_tracks.size(); i++) {
+        if (m_tracks[i].name == name) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+ReplayBundleReader::FrameView ReplayBundleReader::getFrame(int track, int64_t frameIndex) const
+{
+    FrameView view;
+    if (track < 0 || track >= static_cast<int>(m_tracks.size())) {
+        return view;
+    }
+
+    const Track& t = m_tracks[track];
+    const ReplayBundle::IndexEntry* end = t.entries + t.entryCount;
+    const ReplayBundle::IndexEntry* it =
+        std::lower_bound(t.entries, end, frameIndex, [](const ReplayBundle::IndexEntry& entry, int64_t index) { return entry.frameIndex < index; });
+    if (it != end && it->frameIndex == frameIndex) {
+        view.data = m_data + it->offset;
+        view.size = static_cast<size_t>(it->size);
+    }
+    return view;
+}
+
+bool ReplayBundleReader::getFrameRange(int track, int64_t& outFirst, int64_t& outLast) const
+{
+    if (track < 0 || track >= static_cast<int>(m_tracks.size()) || m_tracks[track].entryCount == 0) {
+        return false;
+    }
+
+    const Track& t = m_tracks[track];
+    outFirst = t.entries[0].frameIndex;
+    outLast = t.entries[t.entryCount - 1].frameIndex;
+    return true;
+}
+
+bool ReplayBundleReader::loadIndex()
+{
+    if (m_size < sizeof(ReplayBundle::FileHeader) + sizeof(ReplayBundle::Trailer)) {
+        return false;
+    }
+
+    ReplayBundle::Trailer trailer;
+    memcpy(&trailer, m_data + m_size - sizeof(trailer), sizeof(trailer));
+    if (trailer.magic != ReplayBundle::c_trailerMagic || trailer.version != ReplayBundle::c_version) {
+        return false;
+    }
+
+    // Bound counts by file size first so the index size cannot overflow
+    if (trailer.trackCount > m_size / sizeof(ReplayBundle::TrackRecord) || trailer.entryCount > m_size / sizeof(ReplayBundle::IndexEntry) ||
+        trailer.indexOffset < sizeof(ReplayBundle::FileHeader) || trailer.indexOffset > m_size) {
+        LOG_ERROR("Invalid replay bundle index: offset=%llu, tracks=%u, entries=%llu", static_cast<unsigned long long>(trailer.indexOffset),
+            trailer.trackCount, static_cast<unsigned long long>(trailer.entryCount));
+        return false;
+    }
+
+    const uint64_t indexSize = trailer.trackCount * sizeof(ReplayBundle::TrackRecord) + trailer.entryCount * sizeof(ReplayBundle::IndexEntry);
+    if (trailer.indexOffset % 8 != 0 || trailer.indexOffset + indexSize + sizeof(trailer) != m_size) {
+        LOG_ERROR("Invalid replay bundle index: offset=%llu, tracks=%u, entries=%llu", static_cast<unsigned long long>(trailer.indexOffset),
+            trailer.trackCount, static_cast<unsigned long long>(trailer.entryCount));
+        return false;
+    }
+
+    // Records are used in place from the mapping
+    const auto* records = reinterpret_cast<const ReplayBundle::TrackRecord*>(m_data + trailer.indexOffset);
+    const auto* entries = reinterpret_cast<const ReplayBundle::IndexEntry*>(records + trailer.trackCount);
+
+    m_tracks.resize(trailer.trackCount);
+    for (uint32_t i = 0; i < trailer.trackCount; i++) {
+        const ReplayBundle::TrackRecord& record = records[i];
+        if (record.id != i || !isValidTrackType(record.type) || record.entryCount > trailer.entryCount ||
+            record.firstEntry > trailer.entryCount - record.entryCount) {
+            LOG_ERROR("Invalid replay bundle track: %u", i);
+            m_tracks.clear();
+            return false;
+        }
+
+        Track& track = m_tracks[i];
+        track.name.assign(record.name, strnlen(record.name, sizeof(record.name)));
+        track.type = static_cast<ReplayBundle::TrackType>(record.type);
+        track.entries = entries + record.firstEntry;
+        track.entryCount = static_cast<size_t>(record.entryCount);
+
+        // Entries must lie before the index and be sorted for binary search
+        for (size_t e = 0; e < track.entryCount; e++) {
+            const ReplayBundle::IndexEntry& entry = track.entries[e];
+            if (entry.offset > trailer.indexOffset || entry.size > trailer.indexOffset - entry.offset ||
+                (e > 0 && entry.frameIndex <= track.entries[e - 1].frameIndex)) {
+                LOG_ERROR("Invalid replay bundle entry: track=%u, frame=%lld", i, entry.frameIndex);
+                m_tracks.clear();
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool ReplayBundleReader::scanIndex()
+{
+    m_recovered = true;
+
+    uint64_t offset = sizeof(ReplayBundle::FileHeader);
+    while (true) {
+        const uint64_t headerOffset = offset + getEntryPadding(offset);
+        if (headerOffset + sizeof(ReplayBundle::EntryHeader) > m_size) {
+            break;
+        }
+
+        ReplayBundle::EntryHeader header;
+        memcpy(&header, m_data + headerOffset, sizeof(header));
+        const uint64_t payloadOffset = headerOffset + sizeof(header);
+
+        // Stop at torn or missing record, e.g. after a crash
+        if (header.magic != ReplayBundle::c_entryMagic || header.size > m_size - payloadOffset) {
+            break;
+        }
+
+        if (header.track == ReplayBundle::c_trackDefinition) {
+            ReplayBundle::TrackRecord record;
+            if (header.size != sizeof(record)) {
+                break;
+            }
+            memcpy(&record, m_data + payloadOffset, sizeof(record));
+
+            // Writer assigns ids in order, so a definition either repeats a known track or adds the next one
+            if (record.id > m_tracks.size() || !isValidTrackType(record.type)) {
+                LOG_ERROR("Invalid replay bundle track definition: id=%u, type=%u", record.id, record.type);
+                break;
+            }
+            if (record.id == m_tracks.size()) {
+                m_tracks.resize(record.id + 1);
+                m_scanned.resize(record.id + 1);
+            }
+            m_tracks[record.id].name.assign(record.name, strnlen(record.name, sizeof(record.name)));
+            m_tracks[record.id].type = static_cast<ReplayBundle::TrackType>(record.type);
+        } else if (header.track < m_tracks.size()) {
+            ReplayBundle::IndexEntry entry;
+            entry.frameIndex = header.frameIndex;
+            entry.offset = payloadOffset;
+            entry.size = header.size;
+            m_scanned[header.track].push_back(entry);
+        }
+
+        offset = payloadOffset + header.size;
+    }
+
+    for (size_t i = 0; i < m_tracks.size(); i++) {
+        sortEntries(m_scanned[i]);
+        m_tracks[i].entries = m_scanned[i].data();
+        m_tracks[i].entryCount = m_scanned[i].size();
+    }
+
+    LOG_INFO("Recovered replay bundle index: tracks=%zu", m_tracks.size());
+    return true;
+}
+
+}  // namespace VarjoExamples
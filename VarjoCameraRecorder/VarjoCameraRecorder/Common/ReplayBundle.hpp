@@ -0,0 +1,203 @@
+#pragma once
+
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Globals.hpp"
+
+namespace VarjoExamples
+{
+//! Single file replay bundle holding all per-frame outputs of a session in typed tracks.
+//!
+//! File layout:
+//!   FileHeader
+//!   EntryHeader + payload, ...      (16 byte aligned, track definitions and frames in write order)
+//!   TrackRecord[trackCount]          (footer index)
+//!   IndexEntry[entryCount]           (grouped by track, sorted by frame index)
+//!   Trailer
+//!
+//! Readers memory map the file and find any frame of any track with one binary search in the footer index.
+//! Every record is preceded by an EntryHeader, so the index of a bundle whose writer never finished can be
+//! rebuilt by scanning.
+struct ReplayBundle {
+    //! Track payload type
+    enum class TrackType : uint32_t {
+        Image = 0,    //!< Encoded PNG/JPEG/BMP image
+        Mask = 1,     //!< Serialized RleMask
+        Overlay = 2,  //!< Sparse tiled overlay
+        Data = 3,     //!< Application defined bytes
+    };
+
+    static constexpr uint32_t c_fileMagic = 0x444e4252;     //!< "RBND"
+    static constexpr uint32_t c_entryMagic = 0x4e454252;    //!< "RBEN"
+    static constexpr uint32_t c_trailerMagic = 0x58494252;  //!< "RBIX"
+    static constexpr uint32_t c_version = 1;                //!< Format version
+    static constexpr uint32_t c_trackDefinition = ~0u;      //!< EntryHeader track id of track definition records
+    static constexpr size_t c_maxNameLength = 63;           //!< Maximum track name length
+    static constexpr size_t c_alignment = 16;               //!< Payload alignment in bytes
+
+    //! File header
+    struct FileHeader {
+        uint32_t magic = c_fileMagic;  //!< File magic
+        uint32_t version = c_version;  //!< Format version
+        uint64_t reserved = 0;         //!< Reserved, zero
+    };
+
+    //! Header preceding every record
+    struct EntryHeader {
+        uint32_t magic = c_entryMagic;  //!< Entry magic
+        uint32_t track = 0;             //!< Track id, or c_trackDefinition
+        int64_t frameIndex = 0;         //!< Frame index
+        uint64_t size = 0;              //!< Payload size in bytes
+    };
+
+    //! Track record in footer index. Also the payload of track definition entries.
+    struct TrackRecord {
+        uint32_t id = 0;                      //!< Track id
+        uint32_t type = 0;                    //!< TrackType
+        uint64_t firstEntry = 0;              //!< First IndexEntry of track
+        uint64_t entryCount = 0;              //!< Number of IndexEntries of track
+        char name[c_maxNameLength + 1] = {};  //!< Zero terminated track name
+    };
+
+    //! Frame entry in footer index
+    struct IndexEntry {
+        int64_t frameIndex = 0;  //!< Frame index
+        uint64_t offset = 0;     //!< Payload offset from start of file
+        uint64_t size = 0;       //!< Payload size in bytes
+    };
+
+    //! Trailer at end of file
+    struct Trailer {
+        uint64_t indexOffset = 0;         //!< Offset of first TrackRecord
+        uint64_t entryCount = 0;          //!< Number of IndexEntries
+        uint32_t trackCount = 0;          //!< Number of TrackRecords
+        uint32_t reserved = 0;            //!< Reserved, zero
+        uint32_t magic = c_trailerMagic;  //!< Trailer magic
+        uint32_t version = c_version;     //!< Format version
+    };
+
+    static_assert(sizeof(FileHeader) == 16, "Unexpected FileHeader size");
+    static_assert(sizeof(EntryHeader) == 24, "Unexpected EntryHeader size");
+    static_assert(sizeof(TrackRecord) == 88, "Unexpected TrackRecord size");
+    static_assert(sizeof(IndexEntry) == 24, "Unexpected IndexEntry size");
+    static_assert(sizeof(Trailer) == 32, "Unexpected Trailer size");
+};
+
+//! Bundle writer for the detector. Thread safe.
+class ReplayBundleWriter
+{
+public:
+    //! Construct writer. Call open() before writing.
+    ReplayBundleWriter() = default;
+
+    //! Destruct writer. Finishes bundle if still open.
+    ~ReplayBundleWriter();
+
+    // Disable copy, move and assign
+    ReplayBundleWriter(const ReplayBundleWriter& other) = delete;
+    ReplayBundleWriter(const ReplayBundleWriter&& other) = delete;
+    ReplayBundleWriter& operator=(const ReplayBundleWriter& other) = delete;
+    ReplayBundleWriter& operator=(const ReplayBundleWriter&& other) = delete;
+
+    //! Create bundle file. Returns false on failure.
+    bool open(const std::string& filename);
+
+    //! Add track, or return existing track with same name. Returns track id, or -1 on failure.
+    int addTrack(const std::string& name, ReplayBundle::TrackType type);
+
+    //! Append frame to track. Writing same frame index again replaces it in the index.
+    bool write(int track, int64_t frameIndex, const void* data, size_t size);
+
+    //! Get payload type of track. Returns false if track does not exist.
+    bool getTrackType(int track, ReplayBundle::TrackType& outType) const;
+
+    //! Write footer index and close file
+    bool finish();
+
+    //! Return true if file is open
+    bool isOpen() const;
+
+private:
+    //! Append record with alignment padding and entry header, outputting payload offset. Requires lock.
+    bool appendRecord(uint32_t track, int64_t frameIndex, const void* data, size_t size, uint64_t& outOffset);
+
+private:
+    mutable std::mutex m_mutex;                                    //!< Lock for writer state
+    std::ofstream m_file;                                          //!< Output file
+    uint64_t m_offset = 0;                                         //!< Current file offset
+    std::vector<ReplayBundle::TrackRecord> m_tracks;               //!< Track records by id
+    std::vector<std::vector<ReplayBundle::IndexEntry>> m_entries;  //!< Index entries by track id
+};
+
+//! Memory mapped bundle reader. Frame data stays valid while the reader exists. Thread safe after open.
+class ReplayBundleReader
+{
+public:
+    //! Track of opened bundle
+    struct Track {
+        std::string name;                                              //!< Track name
+        ReplayBundle::TrackType type = ReplayBundle::TrackType::Data;  //!< Payload type
+        const ReplayBundle::IndexEntry* entries = nullptr;             //!< Entries sorted by frame index
+        size_t entryCount = 0;                                         //!< Number of entries
+    };
+
+    //! Frame data view
+    struct FrameView {
+        const uint8_t* data = nullptr;  //!< Payload in mapped file
+        size_t size = 0;                //!< Payload size in bytes
+    };
+
+    //! Construct reader. Call open() before reading.
+    ReplayBundleReader() = default;
+
+    //! Destruct reader. Unmaps file.
+    ~ReplayBundleReader();
+
+    // Disable copy, move and assign
+    ReplayBundleReader(const ReplayBundleReader& other) = delete;
+    ReplayBundleReader(const ReplayBundleReader&& other) = delete;
+    ReplayBundleReader& operator=(const ReplayBundleReader& other) = delete;
+    ReplayBundleReader& operator=(const ReplayBundleReader&& other) = delete;
+
+    //! Map bundle file. Rebuilds index by scanning if the writer did not finish. Returns false on failure.
+    bool open(const std::string& filename);
+
+    //! Unmap file
+    void close();
+
+    //! Return track id by name, or -1 if not found
+    int findTrack(const std::string& name) const;
+
+    //! Return tracks indexed by track id
+    const std::vector<Track>& getTracks() const { return m_tracks; }
+
+    //! Get frame of track. Returns empty view if not found.
+    FrameView getFrame(int track, int64_t frameIndex) const;
+
+    //! Get first and last frame index of track. Returns false if track is empty.
+    bool getFrameRange(int track, int64_t& outFirst, int64_t& outLast) const;
+
+    //! Return true if index was rebuilt by scanning
+    bool isRecovered() const { return m_recovered; }
+
+private:
+    //! Use footer index in mapped file. Returns false if trailer is missing or invalid.
+    bool loadIndex();
+
+    //! Rebuild index by scanning entry headers
+    bool scanIndex();
+
+private:
+    void* m_fileHandle = nullptr;                                  //!< File handle, Windows only
+    void* m_mappingHandle = nullptr;                               //!< File mapping handle, Windows only
+    const uint8_t* m_data = nullptr;                               //!< Mapped file data
+    uint64_t m_size = 0;                                           //!< Mapped file size
+    std::vector<Track> m_tracks;                                   //!< Tracks by id
+    std::vector<std::vector<ReplayBundle::IndexEntry>> m_scanned;  //!< Index storage when recovered by scanning
+    bool m_recovered = false;                                      //!< Index rebuilt by scanning
+};
+
+}  // namespace VarjoExamples
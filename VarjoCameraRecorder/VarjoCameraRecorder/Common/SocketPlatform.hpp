@@ -0,0 +1,95 @@
+#pragma once
+
+//! Socket headers for the networking sources. Off Windows the Winsock subset they use is mapped to BSD sockets,
+//! so the same code builds on both.
+
+#if defined(_WIN32)
+// Winsock must be included before Windows.h
+#include <winsock2.h>
+#include <ws2tcpip.h>
+
+#pragma comment(lib, "ws2_32.lib")
+#else
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <vector>
+
+using SOCKET = int;
+using DWORD = uint32_t;
+using ULONG = uint32_t;
+using WORD = uint16_t;
+
+constexpr SOCKET INVALID_SOCKET = -1;
+constexpr int SOCKET_ERROR = -1;
+constexpr int SD_BOTH = SHUT_RDWR;
+
+#define MAKEWORD(LOW, HIGH) static_cast<WORD>(((LOW)&0xff) | (((HIGH)&0xff) << 8))
+
+struct WSADATA {
+};
+
+//! Scatter/gather buffer with the Winsock field order
+struct WSABUF {
+    ULONG len;  //!< Buffer size in bytes
+    char* buf;  //!< Buffer data
+};
+
+inline int WSAStartup(WORD /*version*/, WSADATA* /*data*/) { return 0; }
+
+inline int WSACleanup() { return 0; }
+
+inline int WSAGetLastError() { return errno; }
+
+inline int closesocket(SOCKET s) { return close(s); }
+
+//! Write all buffers like blocking WSASend, continuing after partial writes. Broken pipes are reported as errors
+//! instead of raising SIGPIPE.
+inline int WSASend(SOCKET s, WSABUF* buffers, DWORD bufferCount, DWORD* outSent, DWORD /*flags*/, void* /*overlapped*/, void* /*routine*/)
+{
+    std::vector<iovec> parts(bufferCount);
+    for (DWORD i = 0; i < bufferCount; i++) {
+        parts[i].iov_base = buffers[i].buf;
+        parts[i].iov_len = buffers[i].len;
+    }
+
+    size_t first = 0;
+    DWORD sent = 0;
+    while (first < parts.size()) {
+        msghdr message{};
+        message.msg_iov = parts.data() + first;
+        message.msg_iovlen = parts.size() - first;
+        const ssize_t n = sendmsg(s, &message, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return SOCKET_ERROR;
+        }
+        sent += static_cast<DWORD>(n);
+
+        // Skip written buffers and advance into the partially written one
+        size_t remaining = static_cast<size_t>(n);
+        while (first < parts.size() && remaining >= parts[first].iov_len) {
+            remaining -= parts[first].iov_len;
+            first++;
+        }
+        if (remaining > 0) {
+            parts[first].iov_base = static_cast<char*>(parts[first].iov_base) + remaining;
+            parts[first].iov_len -= remaining;
+        }
+    }
+
+    if (outSent) {
+        *outSent = sent;
+    }
+    return 0;
+}
+#endif
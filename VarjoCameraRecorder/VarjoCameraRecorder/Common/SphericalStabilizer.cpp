@@ -0,0 +1,263 @@
+#include "SphericalStabilizer.hpp"
+
+#include <cassert>
+#include <cmath>
+#include <array>
+#include <algorithm>
+
+namespace
+{
+// Power iterations for dominant eigenvector of Horn's matrix
+constexpr int c_powerIterations = 32;
+
+// Inlier threshold multiplier for the first refinement pass
+constexpr float c_coarseInlierScale = 4.0f;
+
+constexpr double c_pi = 3.14159265358979323846;
+
+// Minimum marker corners for a 3-DoF rotation prior
+constexpr size_t c_minPriorCorners = 3;
+
+// Angle between two unit vectors
+inline float angleBetween(const glm::vec3& a, const glm::vec3& b) { return std::acos(glm::clamp(glm::dot(a, b), -1.0f, 1.0f)); }
+
+}  // namespace
+
+namespace VarjoExamples
+{
+SphericalStabilizer::SphericalStabilizer(const Config& config)
+    : m_config(config)
+{
+}
+
+void SphericalStabilizer::reset()
+{
+    m_rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+    m_prior = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+    m_hasPrior = false;
+    m_inlierCount = 0;
+}
+
+void SphericalStabilizer::setPrior(const glm::quat& rotation)
+{
+    m_prior = glm::normalize(rotation);
+    m_hasPrior = true;
+}
+
+void SphericalStabilizer::setPrior(const glm::mat4x4& referencePose, const glm::mat4x4& currentPose)
+{
+    // Static object seen from a rotated camera: current = R * reference
+    const glm::quat reference = glm::quat_cast(glm::mat3x3(referencePose));
+    const glm::quat current = glm::quat_cast(glm::mat3x3(currentPose));
+    setPrior(current * glm::inverse(reference));
+}
+
+void SphericalStabilizer::setPrior(const MarkerTracker::MarkerObject& reference, const MarkerTracker::MarkerObject& current)
+{
+    if (reference.id != current.id) {
+        LOG_WARNING("Marker prior ignored. Marker ids differ: %lld != %lld", reference.id, current.id);
+        return;
+    }
+    setPrior(reference.pose, current.pose);
+}
+
+void SphericalStabilizer::setPrior(const std::vector<Correspondence>& markerCorners)
+{
+    if (markerCorners.size() < c_minPriorCorners) {
+        LOG_WARNING("Marker prior ignored. Too few corners: %d", static_cast<int>(markerCorners.size()));
+        return;
+    }
+
+    // Corners of a small marker span a few degrees, so Horn's matrix has nearly equal eigenvalues for roll around the
+    // marker. Solve in closed form instead: swing the marker center onto its current bearing, then twist around it.
+    glm::vec3 referenceCenter(0.0f);
+    glm::vec3 currentCenter(0.0f);
+    for (const auto& c : markerCorners) {
+        referenceCenter += glm::normalize(c.previous);
+        currentCenter += glm::normalize(c.current);
+    }
+    referenceCenter = glm::normalize(referenceCenter);
+    currentCenter = glm::normalize(currentCenter);
+    const glm::quat swing = glm::rotation(referenceCenter, currentCenter);
+
+    // Mean signed angle of swung corners to current corners around the current center
+    float sinSum = 0.0f;
+    float cosSum = 0.0f;
+    for (const auto& c : markerCorners) {
+        const glm::vec3 from = swing * glm::normalize(c.previous);
+        const glm::vec3 to = glm::normalize(c.current);
+        const glm::vec3 fromOffset = from - glm::dot(from, currentCenter) * currentCenter;
+        const glm::vec3 toOffset = to - glm::dot(to, currentCenter) * currentCenter;
+        sinSum += glm::dot(glm::cross(fromOffset, toOffset), currentCenter);
+        cosSum += glm::dot(fromOffset, toOffset);
+    }
+    const glm::quat twist = glm::angleAxis(std::atan2(sinSum, cosSum), currentCenter);
+    setPrior(twist * swing);
+}
+
+void SphericalStabilizer::setPriorFromHmd(const varjo_Matrix& referencePose, const varjo_Matrix& currentPose)
+{
+    // World space bearing d maps to camera space as inverse(H) * d
+    const glm::quat reference = glm::quat_cast(glm::mat3x3(fromVarjoMatrix(referencePose)));
+    const glm::quat current = glm::quat_cast(glm::mat3x3(fromVarjoMatrix(currentPose)));
+    setPrior(glm::inverse(current) * reference);
+}
+
+bool SphericalStabilizer::update(const std::vector<Correspondence>& correspondences)
+{
+    // Express previous bearings in the reference orientation so the estimate is absolute, not chained
+    const glm::quat toReference = glm::inverse(m_rotation);
+    std::vector<glm::vec3> reference;
+    std::vector<glm::vec3> current;
+    reference.reserve(correspondences.size());
+    current.reserve(correspondences.size());
+
+    glm::quat estimate = m_hasPrior ? m_prior : m_rotation;
+    std::vector<glm::vec3> inlierFrom;
+    std::vector<glm::vec3> inlierTo;
+    inlierFrom.reserve(correspondences.size());
+    inlierTo.reserve(correspondences.size());
+
+    for (const auto& c : correspondences) {
+        reference.emplace_back(toReference * glm::normalize(c.previous));
+        current.emplace_back(glm::normalize(c.current));
+    }
+
+    m_inlierCount = 0;
+    for (int iter = 0; iter < m_config.refineIterations; iter++) {
+        const float threshold = (iter == 0) ? m_config.inlierAngle * c_coarseInlierScale : m_config.inlierAngle;
+
+        inlierFrom.clear();
+        inlierTo.clear();
+        for (size_t i = 0; i < reference.size(); i++) {
+            if (angleBetween(estimate * reference[i], current[i]) <= threshold) {
+                inlierFrom.emplace_back(reference[i]);
+                inlierTo.emplace_back(current[i]);
+            }
+        }
+
+        if (inlierFrom.size() < m_config.minInliers) {
+            break;
+        }
+
+        estimate = solveRotation(inlierFrom, inlierTo, estimate);
+        m_inlierCount = inlierFrom.size();
+    }
+
+    const bool accepted = (m_inlierCount >= m_config.minInliers);
+    if (accepted) {
+        // Pull towards absolute prior to cancel residual drift
+        m_rotation = m_hasPrior ? glm::slerp(estimate, m_prior, m_config.priorWeight) : estimate;
+    } else {
+        LOG_DEBUG("Visual rotation rejected: inliers=%d, correspondences=%d", static_cast<int>(m_inlierCount), static_cast<int>(correspondences.size()));
+        if (m_hasPrior) {
+            m_rotation = m_prior;
+        }
+    }
+
+    m_rotation = glm::normalize(m_rotation);
+    m_hasPrior = false;
+    return accepted;
+}
+
+glm::quat SphericalStabilizer::solveRotation(const std::vector<glm::vec3>& from, const std::vector<glm::vec3>& to, const glm::quat& initial)
+{
+    assert(from.size() == to.size());
+
+    // Cross covariance S = sum(from * to^T)
+    double S[3][3] = {};
+    double norm = 0.0;
+    for (size_t i = 0; i < from.size(); i++) {
+        for (int r = 0; r < 3; r++) {
+            for (int c = 0; c < 3; c++) {
+                S[r][c] += static_cast<double>(from[i][r]) * to[i][c];
+            }
+        }
+        norm += glm::length(from[i]) * glm::length(to[i]);
+    }
+
+    // Horn's symmetric 4x4 matrix, quaternion order (w, x, y, z)
+    const double N[4][4] = {
+        {S[0][0] + S[1][1] + S[2][2], S[1][2] - S[2][1], S[2][0] - S[0][2], S[0][1] - S[1][0]},
+        {S[1][2] - S[2][1], S[0][0] - S[1][1] - S[2][2], S[0][1] + S[1][0], S[2][0] + S[0][2]},
+        {S[2][0] - S[0][2], S[0][1] + S[1][0], -S[0][0] + S[1][1] - S[2][2], S[1][2] + S[2][1]},
+        {S[0][1] - S[1][0], S[2][0] + S[0][2], S[1][2] + S[2][1], -S[0][0] - S[1][1] + S[2][2]},
+    };
+
+    // Eigenvalues are bounded by +-norm, shift to make the dominant eigenvalue the largest in magnitude
+    std::array<double, 4> q = {initial.w, initial.x, initial.y, initial.z};
+    for (int iter = 0; iter < c_powerIterations; iter++) {
+        std::array<double, 4> next{};
+        for (int r = 0; r < 4; r++) {
+            next[r] = norm * q[r];
+            for (int c = 0; c < 4; c++) {
+                next[r] += N[r][c] * q[c];
+            }
+        }
+
+        const double len = std::sqrt(next[0] * next[0] + next[1] * next[1] + next[2] * next[2] + next[3] * next[3]);
+        if (len <= 0.0) {
+            return initial;
+        }
+        for (int r = 0; r < 4; r++) {
+            q[r] = next[r] / len;
+        }
+    }
+
+    return glm::normalize(glm::quat(static_cast<float>(q[0]), static_cast<float>(q[1]), static_cast<float>(q[2]), static_cast<float>(q[3])));
+}
+
+void SphericalStabilizer::buildRemap(int equirectWidth, int equirectHeight, float fovDeg, float thetaDeg, float phiDeg, int width, int height,
+    std::vector<float>& outMapX, std::vector<float>& outMapY) const
+{
+    outMapX.resize(static_cast<size_t>(width) * height);
+    outMapY.resize(static_cast<size_t>(width) * height);
+
+    const float f = 0.5f * width / std::tan(0.5f * glm::radians(fovDeg));
+    const float cx = 0.5f * (width - 1);
+    const float cy = 0.5f * (height - 1);
+
+    // View rotation as in Equirec2Perspec: yaw around Y, then pitch around the yawed X axis
+    const glm::quat yaw = glm::angleAxis(glm::radians(thetaDeg), glm::vec3(0.0f, 1.0f, 0.0f));
+    const glm::quat pitch = glm::angleAxis(glm::radians(phiDeg), yaw * glm::vec3(1.0f, 0.0f, 0.0f));
+
+    // Fold stabilization into the view rotation: sample current frame at R * view direction
+    const glm::mat3x3 R = glm::mat3_cast(m_rotation * pitch * yaw);
+
+    const float scaleX = static_cast<float>((equirectWidth - 1) / (2.0 * c_pi));
+    const float scaleY = static_cast<float>((equirectHeight - 1) / c_pi);
+    const float offsetX = 0.5f * (equirectWidth - 1);
+    const float offsetY = 0.5f * (equirectHeight - 1);
+
+    for (int y = 0; y < height; y++) {
+        float* rowX = &outMapX[static_cast<size_t>(y) * width];
+        float* rowY = &outMapY[static_cast<size_t>(y) * width];
+        const glm::vec3 rowBase = R * glm::vec3(-cx / f, (y - cy) / f, 1.0f);
+        const glm::vec3 step = R[0] / f;
+
+        glm::vec3 d = rowBase;
+        for (int x = 0; x < width; x++, d += step) {
+            const float lon = std::atan2(d.x, d.z);
+            const float lat = std::asin(glm::clamp(d.y / glm::length(d), -1.0f, 1.0f));
+            rowX[x] = lon * scaleX + offsetX;
+            rowY[x] = lat * scaleY + offsetY;
+        }
+    }
+}
+
+glm::vec3 SphericalStabilizer::equirectToBearing(const glm::vec2& pixel, int equirectWidth, int equirectHeight)
+{
+    const float lon = static_cast<float>((pixel.x / (equirectWidth - 1) - 0.5f) * 2.0 * c_pi);
+    const float lat = static_cast<float>((pixel.y / (equirectHeight - 1) - 0.5f) * c_pi);
+    return glm::vec3(std::cos(lat) * std::sin(lon), std::sin(lat), std::cos(lat) * std::cos(lon));
+}
+
+glm::vec2 SphericalStabilizer::bearingToEquirect(const glm::vec3& bearing, int equirectWidth, int equirectHeight)
+{
+    const glm::vec3 d = glm::normalize(bearing);
+    const float lon = std::atan2(d.x, d.z);
+    const float lat = std::asin(glm::clamp(d.y, -1.0f, 1.0f));
+    return glm::vec2(static_cast<float>((lon / (2.0 * c_pi) + 0.5) * (equirectWidth - 1)), static_cast<float>((lat / c_pi + 0.5) * (equirectHeight - 1)));
+}
+
+}  // namespace VarjoExamples
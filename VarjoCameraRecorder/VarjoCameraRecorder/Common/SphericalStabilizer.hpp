@@ -0,0 +1,86 @@
+#pragma once
+
+#include <vector>
+
+#include "Globals.hpp"
+#include "MarkerTracker.hpp"
+
+namespace VarjoExamples
+{
+//! Rotation-only stabilizer for equirectangular 360 frames.
+//! Estimates 3-DoF camera rotation on the sphere from feature bearings against a fixed reference orientation,
+//! so the correction can be folded into the equirect-to-perspective remap instead of a separate 2D warp.
+class SphericalStabilizer
+{
+public:
+    //! Bearing correspondence between previous and current frame (unit vectors in camera space)
+    struct Correspondence {
+        glm::vec3 previous{0.0f, 0.0f, 1.0f};  //!< Bearing in previous frame
+        glm::vec3 current{0.0f, 0.0f, 1.0f};   //!< Bearing in current frame
+    };
+
+    //! Stabilizer configuration
+    struct Config {
+        float inlierAngle = glm::radians(1.0f);  //!< Max residual angle for inlier correspondences (radians)
+        int refineIterations = 4;                //!< Inlier refinement iterations per update
+        size_t minInliers = 8;                   //!< Minimum inlier count for accepting a visual estimate
+        float priorWeight = 0.05f;               //!< Blend weight towards absolute pose prior (0 = visual only)
+    };
+
+    //! Construct stabilizer with default config
+    SphericalStabilizer() = default;
+
+    //! Construct stabilizer with given config
+    SphericalStabilizer(const Config& config);
+
+    //! Reset rotation to identity and clear prior
+    void reset();
+
+    //! Set absolute prior for current frame rotation relative to reference orientation
+    void setPrior(const glm::quat& rotation);
+
+    //! Set prior from reference and current poses of a static object expressed in camera space
+    void setPrior(const glm::mat4x4& referencePose, const glm::mat4x4& currentPose);
+
+    //! Set prior from reference and current marker observations. Marker poses must be in camera space (inverse HMD pose * world pose).
+    void setPrior(const MarkerTracker::MarkerObject& reference, const MarkerTracker::MarkerObject& current);
+
+    //! Set prior from bearings of static marker corners, with reference frame bearings in previous and current frame bearings in current.
+    //! Needs at least three corners.
+    void setPrior(const std::vector<Correspondence>& markerCorners);
+
+    //! Set prior from reference and current HMD poses (world space, camera rigidly attached to HMD)
+    void setPriorFromHmd(const varjo_Matrix& referencePose, const varjo_Matrix& currentPose);
+
+    //! Update rotation estimate with frame-to-frame correspondences. Returns false if visual estimate was rejected.
+    bool update(const std::vector<Correspondence>& correspondences);
+
+    //! Return current camera rotation relative to reference orientation
+    const glm::quat& getRotation() const { return m_rotation; }
+
+    //! Return inlier count of the latest update
+    size_t getInlierCount() const { return m_inlierCount; }
+
+    //! Build stabilized perspective remap tables (compatible with cv::remap CV_32FC1 maps).
+    //! Theta is yaw and phi is pitch in degrees, matching Equirec2Perspec.GetPerspective.
+    void buildRemap(int equirectWidth, int equirectHeight, float fovDeg, float thetaDeg, float phiDeg, int width, int height, std::vector<float>& outMapX,
+        std::vector<float>& outMapY) const;
+
+    //! Convert equirect pixel coordinate to unit bearing
+    static glm::vec3 equirectToBearing(const glm::vec2& pixel, int equirectWidth, int equirectHeight);
+
+    //! Convert unit bearing to equirect pixel coordinate
+    static glm::vec2 bearingToEquirect(const glm::vec3& bearing, int equirectWidth, int equirectHeight);
+
+    //! Solve rotation mapping from-bearings to to-bearings in least squares sense (Horn's quaternion method)
+    static glm::quat solveRotation(const std::vector<glm::vec3>& from, const std::vector<glm::vec3>& to, const glm::quat& initial);
+
+private:
+    Config m_config;                               //!< Stabilizer config
+    glm::quat m_rotation{1.0f, 0.0f, 0.0f, 0.0f};  //!< Current rotation relative to reference
+    glm::quat m_prior{1.0f, 0.0f, 0.0f, 0.0f};     //!< Absolute rotation prior for current frame
+    bool m_hasPrior = false;                       //!< Is prior set for current frame
+    size_t m_inlierCount = 0;                      //!< Inlier count of latest update
+};
+
+}  // namespace VarjoExamples
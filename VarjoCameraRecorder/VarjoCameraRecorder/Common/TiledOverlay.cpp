@@ -0,0 +1,393 @@
+#include "TiledOverlay.hpp"
+
+#if defined(_WIN32)
+#include <d3d11.h>
+#endif
+#include <emmintrin.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include "QoiCodec.hpp"
+
+namespace
+{
+// Serialization magic and version
+constexpr uint32_t c_overlayMagic = 0x564f5452;  // "RTOV"
+constexpr uint32_t c_deltaMagic = 0x444f5452;    // "RTOD"
+constexpr uint32_t c_overlayVersion = 1;
+
+// Serialized overlay header, followed by occupancy words, tile offsets and tile data
+struct OverlayHeader {
+    uint32_t magic = c_overlayMagic;
+    uint32_t version = c_overlayVersion;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t tileCount = 0;
+    uint32_t dataSize = 0;
+};
+
+static_assert(sizeof(OverlayHeader) == 24, "Unexpected OverlayHeader size");
+
+inline uint32_t loadPixel(const uint8_t* p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    // Normalize fully transparent pixels so they compress as runs
+    return (v & 0xff000000u) ? v : 0u;
+}
+
+inline void storePixel(uint8_t* p, uint32_t v) { memcpy(p, &v, sizeof(v)); }
+
+// Return true if any pixel of rect has non-zero alpha
+bool hasAlpha(const uint8_t* rgba, int width, int height, int rowStride)
+{
+    for (int y = 0; y < height; y++) {
+        const uint8_t* row = rgba + static_cast<size_t>(y) * rowStride;
+        uint32_t bits = 0;
+        for (int x = 0; x < width; x++) {
+            bits |= row[x * 4 + 3];
+        }
+        if (bits) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Return true if rect differs between frames. Fully transparent pixels compare equal regardless of color.
+bool tileDiffers(const uint8_t* a, const uint8_t* b, int width, int height, int rowStride)
+{
+    const __m128i alphaMask = _mm_set1_epi32(static_cast<int>(0xff000000u));
+    const __m128i zero = _mm_setzero_si128();
+
+    for (int y = 0; y < height; y++) {
+        const uint8_t* rowA = a + static_cast<size_t>(y) * rowStride;
+        const uint8_t* rowB = b + static_cast<size_t>(y) * rowStride;
+        int x = 0;
+        for (; x + 4 <= width; x += 4) {
+            __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rowA + x * 4));
+            __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rowB + x * 4));
+            va = _mm_andnot_si128(_mm_cmpeq_epi32(_mm_and_si128(va, alphaMask), zero), va);
+            vb = _mm_andnot_si128(_mm_cmpeq_epi32(_mm_and_si128(vb, alphaMask), zero), vb);
+            if (_mm_movemask_epi8(_mm_cmpeq_epi8(va, vb)) != 0xffff) {
+                return true;
+            }
+        }
+        for (; x < width; x++) {
+            if (loadPixel(rowA + x * 4) != loadPixel(rowB + x * 4)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+}  // namespace
+
+namespace VarjoExamples
+{
+TiledOverlay TiledOverlay::encode(const uint8_t* rgba, int width, int height, int rowStride)
+{
+    TiledOverlay overlay;
+    overlay.reset(width, height);
+
+    for (int ty = 0; ty < overlay.m_tilesY; ty++) {
+        for (int tx = 0; tx < overlay.m_tilesX; tx++) {
+            const int gridIndex = ty * overlay.m_tilesX + tx;
+            const TileRect rect = overlay.getGridRect(gridIndex);
+            const uint8_t* tile = rgba + static_cast<size_t>(rect.y) * rowStride + rect.x * 4;
+            if (!hasAlpha(tile, rect.width, rect.height, rowStride)) {
+                continue;
+            }
+
+            overlay.m_occupancy[gridIndex >> 6] |= uint64_t(1) << (gridIndex & 63);
+            overlay.m_tiles.push_back(static_cast<uint32_t>(gridIndex));
+            encodeQoi(tile, rect.width, rect.height, rowStride, 4, true, overlay.m_data);
+            overlay.m_offsets.push_back(static_cast<uint32_t>(overlay.m_data.size()));
+        }
+    }
+    return overlay;
+}
+
+TiledOverlay TiledOverlay::encodeDelta(const uint8_t* rgba, const uint8_t* previous, int width, int height, int rowStride)
+{
+    TiledOverlay overlay;
+    overlay.reset(width, height);
+    overlay.m_delta = true;
+
+    constexpr int c_tileStride = c_tileSize * 4;
+    std::vector<uint8_t> diff(static_cast<size_t>(c_tileStride) * c_tileSize);
+
+    for (int ty = 0; ty < overlay.m_tilesY; ty++) {
+        for (int tx = 0; tx < overlay.m_tilesX; tx++) {
+            const int gridIndex = ty * overlay.m_tilesX + tx;
+            const TileRect rect = overlay.getGridRect(gridIndex);
+            const size_t offset = static_cast<size_t>(rect.y) * rowStride + rect.x * 4;
+            if (!tileDiffers(rgba + offset, previous + offset, rect.width, rect.height, rowStride)) {
+                continue;
+            }
+
+            // Unchanged pixels XOR to zero and collapse into runs
+            for (int y = 0; y < rect.height; y++) {
+                const uint8_t* cur = rgba + offset + static_cast<size_t>(y) * rowStride;
+                const uint8_t* prev = previous + offset + static_cast<size_t>(y) * rowStride;
+                for (int x = 0; x < rect.width; x++) {
+                    storePixel(&diff[y * c_tileStride + x * 4], loadPixel(cur + x * 4) ^ loadPixel(prev + x * 4));
+                }
+            }
+
+            overlay.m_occupancy[gridIndex >> 6] |= uint64_t(1) << (gridIndex & 63);
+            overlay.m_tiles.push_back(static_cast<uint32_t>(gridIndex));
+            encodeQoi(diff.data(), rect.width, rect.height, c_tileStride, 4, false, overlay.m_data);
+            overlay.m_offsets.push_back(static_cast<uint32_t>(overlay.m_data.size()));
+        }
+    }
+    return overlay;
+}
+
+bool TiledOverlay::applyDelta(uint8_t* rgba, int rowStride) const
+{
+    if (!m_delta) {
+        return false;
+    }
+
+    constexpr int c_tileStride = c_tileSize * 4;
+    std::vector<uint8_t> diff(static_cast<size_t>(c_tileStride) * c_tileSize);
+
+    for (size_t i = 0; i < m_tiles.size(); i++) {
+        if (!decodeTile(i, diff.data(), c_tileStride)) {
+            return false;
+        }
+        const TileRect rect = getTileRect(i);
+        for (int y = 0; y < rect.height; y++) {
+            uint8_t* row = rgba + static_cast<size_t>(rect.y + y) * rowStride + rect.x * 4;
+            const uint8_t* diffRow = &diff[y * c_tileStride];
+            for (int x = 0; x < rect.width * 4; x++) {
+                row[x] ^= diffRow[x];
+            }
+        }
+    }
+    return true;
+}
+
+bool TiledOverlay::decode(uint8_t* rgba, int rowStride) const
+{
+    if (m_delta) {
+        return false;
+    }
+
+    for (int ty = 0; ty < m_tilesY; ty++) {
+        // Clear spans of consecutive empty tiles row by row
+        int tx = 0;
+        while (tx < m_tilesX) {
+            if (isOccupied(ty * m_tilesX + tx)) {
+                tx++;
+                continue;
+            }
+            const int begin = tx;
+            while (tx < m_tilesX && !isOccupied(ty * m_tilesX + tx)) {
+                tx++;
+            }
+
+            const TileRect first = getGridRect(ty * m_tilesX + begin);
+            const TileRect last = getGridRect(ty * m_tilesX + tx - 1);
+            const size_t spanBytes = static_cast<size_t>(last.x + last.width - first.x) * 4;
+            for (int y = first.y; y < first.y + first.height; y++) {
+                memset(rgba + static_cast<size_t>(y) * rowStride + first.x * 4, 0, spanBytes);
+            }
+        }
+    }
+
+    for (size_t i = 0; i < m_tiles.size(); i++) {
+        const TileRect rect = getTileRect(i);
+        if (!decodeTile(i, rgba + static_cast<size_t>(rect.y) * rowStride + rect.x * 4, rowStride)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool TiledOverlay::decodeTile(size_t tile, uint8_t* rgba, int rowStride) const
+{
+    if (tile >= m_tiles.size()) {
+        return false;
+    }
+    const TileRect rect = getTileRect(tile);
+    return decodeQoi(m_data.data() + m_offsets[tile], m_offsets[tile + 1] - m_offsets[tile], rgba, rect.width, rect.height, rowStride, 4);
+}
+
+bool TiledOverlay::upload(ID3D11DeviceContext* context, ID3D11Resource* texture, const TiledOverlay* previous, bool bottomUp) const
+{
+    if (!context || !texture || m_delta) {
+        return false;
+    }
+
+#if defined(_WIN32)
+    constexpr int c_tileStride = c_tileSize * 4;
+    std::vector<uint8_t> pixels(static_cast<size_t>(c_tileStride) * c_tileSize, 0);
+
+    const auto uploadRect = [&](const TileRect& rect) {
+        const int top = bottomUp ? m_height - rect.y - rect.height : rect.y;
+        const D3D11_BOX box = {static_cast<UINT>(rect.x), static_cast<UINT>(top), 0, static_cast<UINT>(rect.x + rect.width),
+            static_cast<UINT>(top + rect.height), 1};
+        context->UpdateSubresource(texture, 0, &box, pixels.data(), c_tileStride, 0);
+    };
+
+    // Clear tiles that were visible in previous overlay but are now empty
+    if (previous && previous->m_width == m_width && previous->m_height == m_height) {
+        for (size_t i = 0; i < previous->m_tiles.size(); i++) {
+            const int gridIndex = static_cast<int>(previous->m_tiles[i]);
+            if (!isOccupied(gridIndex)) {
+                uploadRect(getGridRect(gridIndex));
+            }
+        }
+    }
+
+    for (size_t i = 0; i < m_tiles.size(); i++) {
+        if (!decodeTile(i, pixels.data(), c_tileStride)) {
+            return false;
+        }
+        const TileRect rect = getTileRect(i);
+        if (bottomUp) {
+            for (int y = 0; y < rect.height / 2; y++) {
+                std::swap_ranges(pixels.begin() + y * c_tileStride, pixels.begin() + y * c_tileStride + rect.width * 4,
+                    pixels.begin() + (rect.height - 1 - y) * c_tileStride);
+            }
+        }
+        uploadRect(rect);
+    }
+    return true;
+#else
+    (void)previous;
+    (void)bottomUp;
+    LOG_ERROR("Overlay upload requires Direct3D 11.");
+    return false;
+#endif
+}
+
+TiledOverlay::TileRect TiledOverlay::getGridRect(int gridIndex) const
+{
+    TileRect rect;
+    rect.x = (gridIndex % m_tilesX) * c_tileSize;
+    rect.y = (gridIndex / m_tilesX) * c_tileSize;
+    rect.width = std::min(c_tileSize, m_width - rect.x);
+    rect.height = std::min(c_tileSize, m_height - rect.y);
+    return rect;
+}
+
+void TiledOverlay::serialize(std::vector<uint8_t>& out) const
+{
+    OverlayHeader header;
+    header.magic = m_delta ? c_deltaMagic : c_overlayMagic;
+    header.width = static_cast<uint32_t>(m_width);
+    header.height = static_cast<uint32_t>(m_height);
+    header.tileCount = static_cast<uint32_t>(m_tiles.size());
+    header.dataSize = static_cast<uint32_t>(m_data.size());
+
+    const size_t begin = out.size();
+    const size_t occupancyBytes = m_occupancy.size() * sizeof(uint64_t);
+    const size_t offsetBytes = m_offsets.size() * sizeof(uint32_t);
+    out.resize(begin + sizeof(header) + occupancyBytes + offsetBytes + m_data.size());
+
+    uint8_t* p = out.data() + begin;
+    memcpy(p, &header, sizeof(header));
+    p += sizeof(header);
+    memcpy(p, m_occupancy.data(), occupancyBytes);
+    p += occupancyBytes;
+    memcpy(p, m_offsets.data(), offsetBytes);
+    p += offsetBytes;
+    if (!m_data.empty()) {
+        memcpy(p, m_data.data(), m_data.size());
+    }
+}
+
+bool TiledOverlay::deserialize(const uint8_t* data, size_t size)
+{
+    OverlayHeader header;
+    if (!data || size < sizeof(header)) {
+        return false;
+    }
+    memcpy(&header, data, sizeof(header));
+    if ((header.magic != c_overlayMagic && header.magic != c_deltaMagic) || header.version != c_overlayVersion || header.width > 65536 || header.height > 65536) {
+        LOG_ERROR("Invalid overlay header: magic=%x, version=%u", header.magic, header.version);
+        return false;
+    }
+
+    reset(static_cast<int>(header.width), static_cast<int>(header.height));
+    m_delta = header.magic == c_deltaMagic;
+    const size_t occupancyBytes = m_occupancy.size() * sizeof(uint64_t);
+    const size_t offsetBytes = (static_cast<size_t>(header.tileCount) + 1) * sizeof(uint32_t);
+    if (header.tileCount > static_cast<uint32_t>(m_tilesX * m_tilesY) || size - sizeof(header) < occupancyBytes + offsetBytes + header.dataSize) {
+        LOG_ERROR("Truncated overlay: size=%zu", size);
+        reset(0, 0);
+        return false;
+    }
+
+    const uint8_t* p = data + sizeof(header);
+    memcpy(m_occupancy.data(), p, occupancyBytes);
+    p += occupancyBytes;
+    m_offsets.resize(header.tileCount + 1);
+    memcpy(m_offsets.data(), p, offsetBytes);
+    p += offsetBytes;
+    m_data.assign(p, p + header.dataSize);
+
+    buildTileList();
+    if (m_tiles.size() != header.tileCount || !std::is_sorted(m_offsets.begin(), m_offsets.end()) || m_offsets.back() != header.dataSize) {
+        LOG_ERROR("Inconsistent overlay tile index");
+        reset(0, 0);
+        return false;
+    }
+    return true;
+}
+
+bool TiledOverlay::readHeader(const uint8_t* data, size_t size, int& outWidth, int& outHeight, bool& outDelta)
+{
+    OverlayHeader header;
+    if (!data || size < sizeof(header)) {
+        return false;
+    }
+    memcpy(&header, data, sizeof(header));
+    if ((header.magic != c_overlayMagic && header.magic != c_deltaMagic) || header.version != c_overlayVersion) {
+        return false;
+    }
+    outWidth = static_cast<int>(header.width);
+    outHeight = static_cast<int>(header.height);
+    outDelta = header.magic == c_deltaMagic;
+    return true;
+}
+
+void TiledOverlay::reset(int width, int height)
+{
+    m_width = width;
+    m_height = height;
+    m_delta = false;
+    m_tilesX = (width + c_tileSize - 1) / c_tileSize;
+    m_tilesY = (height + c_tileSize - 1) / c_tileSize;
+    m_occupancy.assign((static_cast<size_t>(m_tilesX) * m_tilesY + 63) / 64, 0);
+    m_tiles.clear();
+    m_offsets.assign(1, 0);
+    m_data.clear();
+}
+
+void TiledOverlay::buildTileList()
+{
+    m_tiles.clear();
+    const int gridCount = m_tilesX * m_tilesY;
+    for (size_t word = 0; word < m_occupancy.size(); word++) {
+        uint64_t bits = m_occupancy[word];
+        while (bits) {
+            int bit = 0;
+            while (!((bits >> bit) & 1)) {
+                bit++;
+            }
+            bits &= bits - 1;
+            const int gridIndex = static_cast<int>(word * 64) + bit;
+            if (gridIndex < gridCount) {
+                m_tiles.push_back(static_cast<uint32_t>(gridIndex));
+            }
+        }
+    }
+}
+
+}  // namespace VarjoExamples
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <vector>
+
+#include "Globals.hpp"
+
+struct ID3D11DeviceContext;
+struct ID3D11Resource;
+
+namespace VarjoExamples
+{
+//! Sparse encoding of mostly transparent RGBA8 replay overlays.
+//!
+//! The frame is split into 32x32 tiles and only tiles with non-zero alpha are stored, each compressed
+//! independently with a tile-local QOI stream. An occupancy bitmap tells which tiles are present, so consumers
+//! can decode and upload just the occupied tiles as texture sub-rects. Fully transparent pixels decode as zero.
+//!
+//! A delta overlay stores instead the tiles that changed against the previous frame, as XOR of the two, and is
+//! applied on top of the reconstructed previous frame. See OverlaySequence.
+class TiledOverlay
+{
+public:
+    static constexpr int c_tileSize = 32;  //!< Tile width and height in pixels
+
+    //! Pixel rectangle of tile, clipped to frame
+    struct TileRect {
+        int x = 0;       //!< Left edge
+        int y = 0;       //!< Top edge
+        int width = 0;   //!< Width in pixels
+        int height = 0;  //!< Height in pixels
+    };
+
+    //! Construct empty overlay
+    TiledOverlay() = default;
+
+    //! Encode overlay from RGBA8 image. Byte 3 of each pixel is alpha.
+    static TiledOverlay encode(const uint8_t* rgba, int width, int height, int rowStride);
+
+    //! Encode tiles of RGBA8 image that differ from previous image of same size and stride
+    static TiledOverlay encodeDelta(const uint8_t* rgba, const uint8_t* previous, int width, int height, int rowStride);
+
+    //! Apply delta overlay to reconstructed previous frame in place. Returns false if this is not a delta.
+    bool applyDelta(uint8_t* rgba, int rowStride) const;
+
+    //! Read frame size and delta flag of serialized overlay without decoding it
+    static bool readHeader(const uint8_t* data, size_t size, int& outWidth, int& outHeight, bool& outDelta);
+
+    //! Decode full frame to RGBA8 image of frame size. Empty tiles are cleared. Fails for delta overlays.
+    bool decode(uint8_t* rgba, int rowStride) const;
+
+    //! Decode stored tile to RGBA8 image of tile rect size. Delta tiles decode to XOR difference.
+    bool decodeTile(size_t tile, uint8_t* rgba, int rowStride) const;
+
+    //! Upload stored tiles to texture of frame size as sub-rects. Tiles occupied only in previous overlay are cleared. Fails for delta overlays.
+    //! With bottomUp the texture holds the bottom row first, as Unity textures do. Fails off Windows.
+    bool upload(ID3D11DeviceContext* context, ID3D11Resource* texture, const TiledOverlay* previous = nullptr, bool bottomUp = false) const;
+
+    //! Return frame width
+    int getWidth() const { return m_width; }
+
+    //! Return frame height
+    int getHeight() const { return m_height; }
+
+    //! Return tile grid width
+    int getTilesX() const { return m_tilesX; }
+
+    //! Return tile grid height
+    int getTilesY() const { return m_tilesY; }
+
+    //! Return number of stored tiles
+    size_t getTileCount() const { return m_tiles.size(); }
+
+    //! Return grid index (tileY * tilesX + tileX) of stored tile
+    int getTileGridIndex(size_t tile) const { return static_cast<int>(m_tiles[tile]); }
+
+    //! Return pixel rectangle of stored tile
+    TileRect getTileRect(size_t tile) const { return getGridRect(static_cast<int>(m_tiles[tile])); }
+
+    //! Return pixel rectangle of grid tile
+    TileRect getGridRect(int gridIndex) const;
+
+    //! Return true if grid tile is stored
+    bool isOccupied(int gridIndex) const { return (m_occupancy[gridIndex >> 6] >> (gridIndex & 63)) & 1; }
+
+    //! Return true if overlay is a delta against previous frame
+    bool isDelta() const { return m_delta; }
+
+    //! Return true if no tiles are stored
+    bool empty() const { return m_tiles.empty(); }
+
+    //! Return memory used by encoded data in bytes
+    size_t getByteSize() const
+    {
+        return sizeof(TiledOverlay) + m_occupancy.size() * sizeof(uint64_t) + (m_tiles.size() + m_offsets.size()) * sizeof(uint32_t) + m_data.size();
+    }
+
+    //! Append serialized overlay to buffer
+    void serialize(std::vector<uint8_t>& out) const;
+
+    //! Read serialized overlay. Returns false if data is invalid.
+    bool deserialize(const uint8_t* data, size_t size);
+
+private:
+    //! Reset to empty overlay of given frame size
+    void reset(int width, int height);
+
+    //! Rebuild stored tile list from occupancy bitmap
+    void buildTileList();
+
+private:
+    int m_width = 0;                    //!< Frame width
+    int m_height = 0;                   //!< Frame height
+    int m_tilesX = 0;                   //!< Tile grid width
+    int m_tilesY = 0;                   //!< Tile grid height
+    bool m_delta = false;               //!< Tiles hold XOR against previous frame
+    std::vector<uint64_t> m_occupancy;  //!< Bit per grid tile, set if stored
+    std::vector<uint32_t> m_tiles;      //!< Grid index of each stored tile in ascending order
+    std::vector<uint32_t> m_offsets;    //!< Offsets of tile streams in data (stored tiles + 1 entries)
+    std::vector<uint8_t> m_data;        //!< Concatenated tile streams
+};
+
+}  // namespace VarjoExamples
@@ -0,0 +1,297 @@
+#include "TrajectoryStore.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+
+namespace
+{
+using namespace VarjoExamples;
+
+// Serialization magic and version
+constexpr uint32_t c_magic = 0x4a525452;  // "RTRJ"
+constexpr uint32_t c_version = 1;
+
+// Serialized sizes of an object header (id, label size, sample count) and of a sample
+constexpr uint64_t c_objectHeaderBytes = sizeof(TrajectoryStore::ObjectId) + sizeof(uint32_t) + sizeof(uint64_t);
+constexpr uint64_t c_sampleBytes = sizeof(double) + sizeof(glm::vec2) + sizeof(glm::vec4) + sizeof(float);
+
+// Squared distance from point to segment
+float segmentDistanceSq(const glm::vec2& p, const glm::vec2& a, const glm::vec2& b)
+{
+    const glm::vec2 ab = b - a;
+    const float lenSq = glm::dot(ab, ab);
+    const float t = (lenSq > 0.0f) ? glm::clamp(glm::dot(p - a, ab) / lenSq, 0.0f, 1.0f) : 0.0f;
+    const glm::vec2 d = p - (a + t * ab);
+    return glm::dot(d, d);
+}
+
+template <typename T>
+void writePod(std::ostream& out, const T& value)
+{
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+void writeArray(std::ostream& out, const std::vector<T>& values)
+{
+    out.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+}
+
+template <typename T>
+bool readPod(std::istream& in, T& value)
+{
+    in.read(reinterpret_cast<char*>(&value), sizeof(T));
+    return in.good();
+}
+
+template <typename T>
+bool readArray(std::istream& in, std::vector<T>& values, size_t count)
+{
+    values.resize(count);
+    in.read(reinterpret_cast<char*>(values.data()), count * sizeof(T));
+    return in.good();
+}
+
+// Return bytes left in stream, 0 if the stream is not seekable
+uint64_t remainingBytes(std::istream& in)
+{
+    const std::streampos pos = in.tellg();
+    if (pos < 0) {
+        return 0;
+    }
+    in.seekg(0, std::ios::end);
+    const std::streampos end = in.tellg();
+    in.seekg(pos);
+    return (end > pos) ? static_cast<uint64_t>(end - pos) : 0;
+}
+
+}  // namespace
+
+namespace VarjoExamples
+{
+void TrajectoryStore::append(ObjectId id, const std::string& label, const Sample& sample)
+{
+    auto& trajectory = m_trajectories[id];
+    if (trajectory.label.empty()) {
+        trajectory.label = label;
+    }
+
+    // Common case: samples arrive in time order
+    if (trajectory.times.empty() || trajectory.times.back() <= sample.time) {
+        trajectory.times.emplace_back(sample.time);
+        trajectory.centroids.emplace_back(sample.centroid);
+        trajectory.bboxes.emplace_back(sample.bbox);
+        trajectory.confidences.emplace_back(sample.confidence);
+        return;
+    }
+
+    const auto pos = std::upper_bound(trajectory.times.begin(), trajectory.times.end(), sample.time) - trajectory.times.begin();
+    trajectory.times.insert(trajectory.times.begin() + pos, sample.time);
+    trajectory.centroids.insert(trajectory.centroids.begin() + pos, sample.centroid);
+    trajectory.bboxes.insert(trajectory.bboxes.begin() + pos, sample.bbox);
+    trajectory.confidences.insert(trajectory.confidences.begin() + pos, sample.confidence);
+}
+
+const TrajectoryStore::Trajectory* TrajectoryStore::getTrajectory(ObjectId id) const
+{
+    auto it = m_trajectories.find(id);
+    return (it != m_trajectories.end()) ? &it->second : nullptr;
+}
+
+TrajectoryStore::Range TrajectoryStore::query(ObjectId id, double t0, double t1) const
+{
+    const Trajectory* trajectory = getTrajectory(id);
+    if (!trajectory || t1 < t0) {
+        return {0, 0};
+    }
+
+    const auto& times = trajectory->times;
+    const size_t begin = std::lower_bound(times.begin(), times.end(), t0) - times.begin();
+    const size_t end = std::upper_bound(times.begin() + begin, times.end(), t1) - times.begin();
+    return {begin, end};
+}
+
+std::vector<glm::vec2> TrajectoryStore::queryPolyline(ObjectId id, double t0, double t1, float tolerance) const
+{
+    std::vector<glm::vec2> polyline;
+
+    const Range range = query(id, t0, t1);
+    if (range.first == range.second) {
+        return polyline;
+    }
+
+    const glm::vec2* points = &getTrajectory(id)->centroids[range.first];
+    const size_t count = range.second - range.first;
+
+    if (tolerance <= 0.0f) {
+        polyline.assign(points, points + count);
+        return polyline;
+    }
+
+    const auto indices = simplify(points, count, tolerance);
+    polyline.reserve(indices.size());
+    for (size_t i : indices) {
+        polyline.emplace_back(points[i]);
+    }
+    return polyline;
+}
+
+size_t TrajectoryStore::getSampleCount() const
+{
+    size_t count = 0;
+    for (const auto& it : m_trajectories) {
+        count += it.second.size();
+    }
+    return count;
+}
+
+std::vector<size_t> TrajectoryStore::simplify(const glm::vec2* points, size_t count, float tolerance)
+{
+    std::vector<size_t> indices;
+    if (count <= 2) {
+        for (size_t i = 0; i < count; i++) {
+            indices.emplace_back(i);
+        }
+        return indices;
+    }
+
+    const float toleranceSq = tolerance * tolerance;
+    std::vector<bool> keep(count, false);
+    keep[0] = keep[count - 1] = true;
+
+    // Iterative Douglas-Peucker to avoid recursion depth on long trajectories
+    std::vector<std::pair<size_t, size_t>> stack;
+    stack.emplace_back(0, count - 1);
+    while (!stack.empty()) {
+        const auto segment = stack.back();
+        stack.pop_back();
+
+        float maxDistSq = 0.0f;
+        size_t maxIndex = segment.first;
+        for (size_t i = segment.first + 1; i < segment.second; i++) {
+            const float distSq = segmentDistanceSq(points[i], points[segment.first], points[segment.second]);
+            if (distSq > maxDistSq) {
+                maxDistSq = distSq;
+                maxIndex = i;
+            }
+        }
+
+        if (maxDistSq > toleranceSq) {
+            keep[maxIndex] = true;
+            stack.emplace_back(segment.first, maxIndex);
+            stack.emplace_back(maxIndex, segment.second);
+        }
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        if (keep[i]) {
+            indices.emplace_back(i);
+        }
+    }
+    return indices;
+}
+
+bool TrajectoryStore::write(std::ostream& out) const
+{
+    writePod(out, c_magic);
+    writePod(out, c_version);
+    writePod(out, static_cast<uint64_t>(m_trajectories.size()));
+
+    for (const auto& it : m_trajectories) {
+        const Trajectory& trajectory = it.second;
+        writePod(out, it.first);
+        writePod(out, static_cast<uint32_t>(trajectory.label.size()));
+        out.write(trajectory.label.data(), trajectory.label.size());
+        writePod(out, static_cast<uint64_t>(trajectory.size()));
+        writeArray(out, trajectory.times);
+        writeArray(out, trajectory.centroids);
+        writeArray(out, trajectory.bboxes);
+        writeArray(out, trajectory.confidences);
+    }
+
+    return out.good();
+}
+
+bool TrajectoryStore::read(std::istream& in)
+{
+    uint32_t magic = 0;
+    uint32_t version = 0;
+    uint64_t objectCount = 0;
+    if (!readPod(in, magic) || !readPod(in, version) || !readPod(in, objectCount)) {
+        LOG_ERROR("Reading trajectory header failed.");
+        return false;
+    }
+
+    if (magic != c_magic || version != c_version) {
+        LOG_ERROR("Invalid trajectory data: magic=%x, version=%u", magic, version);
+        return false;
+    }
+
+    // Counts come from the file, check them against its size before allocating
+    if (objectCount > remainingBytes(in) / c_objectHeaderBytes) {
+        LOG_ERROR("Invalid trajectory data: objects=%llu exceed stream size", objectCount);
+        return false;
+    }
+
+    std::unordered_map<ObjectId, Trajectory> trajectories;
+    for (uint64_t i = 0; i < objectCount; i++) {
+        ObjectId id = 0;
+        uint32_t labelSize = 0;
+        uint64_t sampleCount = 0;
+        if (!readPod(in, id) || !readPod(in, labelSize)) {
+            LOG_ERROR("Reading trajectory failed: index=%llu", i);
+            return false;
+        }
+
+        if (labelSize > remainingBytes(in)) {
+            LOG_ERROR("Invalid trajectory label: id=%lld, size=%u", id, labelSize);
+            return false;
+        }
+
+        Trajectory& trajectory = trajectories[id];
+        trajectory.label.resize(labelSize);
+        in.read(&trajectory.label[0], labelSize);
+
+        if (!readPod(in, sampleCount)) {
+            LOG_ERROR("Reading trajectory samples failed: id=%lld", id);
+            return false;
+        }
+
+        if (sampleCount > remainingBytes(in) / c_sampleBytes) {
+            LOG_ERROR("Invalid trajectory data: id=%lld, samples=%llu exceed stream size", id, sampleCount);
+            return false;
+        }
+
+        if (!readArray(in, trajectory.times, sampleCount) || !readArray(in, trajectory.centroids, sampleCount) ||
+            !readArray(in, trajectory.bboxes, sampleCount) || !readArray(in, trajectory.confidences, sampleCount)) {
+            LOG_ERROR("Reading trajectory samples failed: id=%lld", id);
+            return false;
+        }
+    }
+
+    m_trajectories = std::move(trajectories);
+    return true;
+}
+
+bool TrajectoryStore::save(const std::string& filename) const
+{
+    std::ofstream outFile(filename, std::ofstream::binary);
+    if (!outFile.good()) {
+        LOG_ERROR("Opening file for writing failed: %s", filename.c_str());
+        return false;
+    }
+    return write(outFile);
+}
+
+bool TrajectoryStore::load(const std::string& filename)
+{
+    std::ifstream inFile(filename, std::ifstream::binary);
+    if (!inFile.good()) {
+        LOG_ERROR("Opening file for reading failed: %s", filename.c_str());
+        return false;
+    }
+    return read(inFile);
+}
+
+}  // namespace VarjoExamples
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <iosfwd>
+
+#include "Globals.hpp"
+
+namespace VarjoExamples
+{
+//! Compact per-object trajectory store with time-range queries.
+//! Samples are kept in structure-of-arrays layout per object, sorted by timestamp.
+class TrajectoryStore
+{
+public:
+    //! Object id type
+    using ObjectId = int64_t;
+
+    //! Single trajectory sample
+    struct Sample {
+        double time = 0.0;         //!< Sample timestamp in seconds
+        glm::vec2 centroid{0.0f};  //!< Object centroid in pixels
+        glm::vec4 bbox{0.0f};      //!< Bounding box (x0, y0, x1, y1) in pixels
+        float confidence = 0.0f;   //!< Detection confidence
+    };
+
+    //! Structure-of-arrays trajectory for a single object
+    struct Trajectory {
+        std::string label;                 //!< Object label
+        std::vector<double> times;         //!< Sample timestamps, ascending
+        std::vector<glm::vec2> centroids;  //!< Sample centroids
+        std::vector<glm::vec4> bboxes;     //!< Sample bounding boxes
+        std::vector<float> confidences;    //!< Sample confidences
+
+        //! Return sample count
+        size_t size() const { return times.size(); }
+
+        //! Return sample at given index
+        Sample at(size_t index) const { return {times[index], centroids[index], bboxes[index], confidences[index]}; }
+    };
+
+    //! Half-open index range [begin, end) into a trajectory
+    using Range = std::pair<size_t, size_t>;
+
+    //! Append sample to object trajectory. Out-of-order samples are inserted in place.
+    void append(ObjectId id, const std::string& label, const Sample& sample);
+
+    //! Return trajectory for given object or nullptr if unknown
+    const Trajectory* getTrajectory(ObjectId id) const;
+
+    //! Return all trajectories
+    const std::unordered_map<ObjectId, Trajectory>& getTrajectories() const { return m_trajectories; }
+
+    //! Return sample index range with timestamps in [t0, t1]
+    Range query(ObjectId id, double t0, double t1) const;
+
+    //! Return centroids in [t0, t1] simplified with Douglas-Peucker using given pixel tolerance
+    std::vector<glm::vec2> queryPolyline(ObjectId id, double t0, double t1, float tolerance = 0.0f) const;
+
+    //! Return total sample count over all objects
+    size_t getSampleCount() const;
+
+    //! Remove all trajectories
+    void clear() { m_trajectories.clear(); }
+
+    //! Write store to binary stream. Returns false on failure.
+    bool write(std::ostream& out) const;
+
+    //! Read store from seekable binary stream, replacing current contents. Counts are validated against the stream size.
+    //! Returns false on failure.
+    bool read(std::istream& in);
+
+    //! Save store to file
+    bool save(const std::string& filename) const;
+
+    //! Load store from file
+    bool load(const std::string& filename);
+
+    //! Douglas-Peucker polyline simplification. Returns indices of kept points.
+    static std::vector<size_t> simplify(const glm::vec2* points, size_t count, float tolerance);
+
+private:
+    std::unordered_map<ObjectId, Trajectory> m_trajectories;  //!< Trajectories by object id
+};
+
+}  // namespace VarjoExamples
@@ -0,0 +1,219 @@
+#include "WorkQueue.hpp"
+
+#include <algorithm>
+
+namespace
+{
+// Return seconds between time points
+inline double secondsBetween(VarjoExamples::WorkQueue::Clock::time_point from, VarjoExamples::WorkQueue::Clock::time_point to)
+{
+    return std::chrono::duration<double>(to - from).count();
+}
+
+}  // namespace
+
+namespace VarjoExamples
+{
+WorkQueue::WorkQueue()
+    : WorkQueue(Config())
+{
+}
+
+WorkQueue::WorkQueue(const Config& config)
+    : m_config(config)
+{
+}
+
+WorkQueue::~WorkQueue() { close(); }
+
+bool WorkQueue::push(uint64_t id, int64_t timestamp, double deadlineSeconds)
+{
+    Job job;
+    job.id = id;
+    job.timestamp = timestamp;
+    job.pushTime = Clock::now();
+    const double maxAge = deadlineSeconds > 0.0 ? deadlineSeconds : m_config.maxAgeSeconds;
+    job.deadline = maxAge > 0.0 ? job.pushTime + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(maxAge))
+                                : Clock::time_point::max();
+
+    std::vector<Report> reports;
+    bool queued = false;
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_stats.pushed++;
+
+        const size_t capacity = m_config.policy == Policy::LatestOnly ? 1 : std::max<size_t>(m_config.capacity, 1);
+        const uint64_t keepEvery = static_cast<uint64_t>(std::max(m_config.keepEvery, 1));
+        if (m_closed) {
+            finish(job, Outcome::Cancelled, 0.0, reports);
+        } else if (m_config.policy == Policy::KeepEveryKth && (m_pushCount++ % keepEvery) != 0) {
+            finish(job, Outcome::Dropped, 0.0, reports);
+        } else {
+            if (m_config.policy == Policy::Block) {
+                m_spaceCondition.wait(lock, [&] { return m_closed || m_queue.size() < capacity; });
+            }
+
+            // Stale jobs go first, then policy makes room by dropping the oldest
+            dropExpired(job.pushTime, reports);
+            while (!m_closed && m_queue.size() >= capacity) {
+                finish(m_queue.front(), Outcome::Dropped, 0.0, reports);
+                m_queue.pop_front();
+            }
+
+            if (m_closed) {
+                finish(job, Outcome::Cancelled, 0.0, reports);
+            } else {
+                m_queue.push_back(job);
+                m_stats.depth = m_queue.size();
+                m_stats.maxDepth = std::max(m_stats.maxDepth, m_stats.depth);
+                queued = true;
+            }
+        }
+    }
+
+    if (queued) {
+        m_jobCondition.notify_one();
+    }
+    notify(reports);
+    return queued;
+}
+
+bool WorkQueue::pop(Job& outJob, double timeoutSeconds)
+{
+    std::vector<Report> reports;
+    bool popped = false;
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        const auto waitEnd = timeoutSeconds >= 0.0
+                                 ? Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(timeoutSeconds))
+                                 : Clock::time_point::max();
+
+        while (true) {
+            dropExpired(Clock::now(), reports);
+            if (!m_queue.empty() || m_closed) {
+                break;
+            }
+
+            if (timeoutSeconds < 0.0) {
+                m_jobCondition.wait(lock);
+            } else if (m_jobCondition.wait_until(lock, waitEnd) == std::cv_status::timeout) {
+                dropExpired(Clock::now(), reports);
+                break;
+            }
+        }
+
+        if (!m_queue.empty()) {
+            outJob = m_queue.front();
+            m_queue.pop_front();
+            outJob.popTime = Clock::now();
+            m_inFlight[outJob.id] = outJob;
+
+            const double wait = secondsBetween(outJob.pushTime, outJob.popTime);
+            m_popCount++;
+            m_waitSum += wait;
+            m_stats.lastWaitSeconds = wait;
+            m_stats.maxWaitSeconds = std::max(m_stats.maxWaitSeconds, wait);
+            m_stats.meanWaitSeconds = m_waitSum / static_cast<double>(m_popCount);
+            m_stats.depth = m_queue.size();
+            m_stats.inFlight = m_inFlight.size();
+            popped = true;
+        }
+    }
+
+    m_spaceCondition.notify_one();
+    notify(reports);
+    return popped;
+}
+
+void WorkQueue::complete(uint64_t id, bool success)
+{
+    std::vector<Report> reports;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_inFlight.find(id);
+        if (it == m_inFlight.end()) {
+            LOG_WARNING("%s: Completed job not in flight: id=%llu", m_config.name.c_str(), id);
+            return;
+        }
+
+        const double service = secondsBetween(it->second.popTime, Clock::now());
+        if (success) {
+            m_serviceSum += service;
+        }
+        finish(it->second, success ? Outcome::Completed : Outcome::Cancelled, service, reports);
+        m_inFlight.erase(it);
+        m_stats.inFlight = m_inFlight.size();
+        if (m_stats.completed > 0) {
+            m_stats.meanServiceSeconds = m_serviceSum / static_cast<double>(m_stats.completed);
+        }
+    }
+
+    notify(reports);
+}
+
+void WorkQueue::close()
+{
+    std::vector<Report> reports;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_closed = true;
+        for (const auto& job : m_queue) {
+            finish(job, Outcome::Cancelled, 0.0, reports);
+        }
+        m_queue.clear();
+        m_stats.depth = 0;
+    }
+
+    m_jobCondition.notify_all();
+    m_spaceCondition.notify_all();
+    notify(reports);
+}
+
+WorkQueue::Stats WorkQueue::getStats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+void WorkQueue::dropExpired(Clock::time_point now, std::vector<Report>& reports)
+{
+    // Jobs with explicit deadlines may expire out of order, so check the whole queue
+    const size_t before = m_queue.size();
+    for (auto it = m_queue.begin(); it != m_queue.end();) {
+        if (it->deadline <= now) {
+            finish(*it, Outcome::Expired, 0.0, reports);
+            it = m_queue.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    if (m_queue.size() != before) {
+        m_stats.depth = m_queue.size();
+        m_spaceCondition.notify_all();
+    }
+}
+
+void WorkQueue::finish(const Job& job, Outcome outcome, double service, std::vector<Report>& reports)
+{
+    switch (outcome) {
+        case Outcome::Completed: m_stats.completed++; break;
+        case Outcome::Dropped: m_stats.dropped++; break;
+        case Outcome::Expired: m_stats.expired++; break;
+        case Outcome::Cancelled: m_stats.cancelled++; break;
+    }
+    const Clock::time_point waitEnd = job.popTime != Clock::time_point() ? job.popTime : Clock::now();
+    reports.push_back({job, outcome, secondsBetween(job.pushTime, waitEnd), service});
+}
+
+void WorkQueue::notify(const std::vector<Report>& reports)
+{
+    if (!m_config.callback) {
+        return;
+    }
+
+    for (const auto& report : reports) {
+        m_config.callback(report.job, report.outcome, report.wait, report.service);
+    }
+}
+
+}  // namespace VarjoExamples
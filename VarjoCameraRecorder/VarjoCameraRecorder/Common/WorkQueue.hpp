@@ -0,0 +1,148 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Globals.hpp"
+
+namespace VarjoExamples
+{
+//! Bounded queue of inference jobs between a producer and one or more worker threads.
+//!
+//! Jobs carry only ids; payloads stay with the caller. When the producer outpaces the workers the queue drops jobs
+//! according to its policy instead of growing, and jobs older than their deadline are dropped when popped, so workers
+//! always process recent frames. Every job ends with exactly one completion callback telling its outcome. Callbacks
+//! are called without the queue lock, on the thread that decided the outcome. One queue is one pipeline stage;
+//! statistics report its depth, queue wait and service times.
+class WorkQueue
+{
+public:
+    //! Overflow policy
+    enum class Policy {
+        DropOldest,    //!< Full queue drops the oldest queued job
+        KeepEveryKth,  //!< Only every k-th pushed job is queued, full queue drops the oldest
+        LatestOnly,    //!< Queue holds one job, new job replaces queued one
+        Block,         //!< Full queue blocks producer until a job is popped
+    };
+
+    //! Job outcome reported to completion callback
+    enum class Outcome {
+        Completed,  //!< Worker completed job
+        Dropped,    //!< Dropped by overflow policy
+        Expired,    //!< Deadline passed before a worker popped the job
+        Cancelled,  //!< Queue closed or job cancelled by worker
+    };
+
+    //! Clock for deadlines and wait times
+    using Clock = std::chrono::steady_clock;
+
+    //! Queued job
+    struct Job {
+        uint64_t id = 0;             //!< Caller assigned job id
+        int64_t timestamp = 0;       //!< Caller timestamp, e.g. capture time or frame number
+        Clock::time_point pushTime;  //!< Time job was pushed
+        Clock::time_point deadline;  //!< Time after which job is expired
+        Clock::time_point popTime;   //!< Time worker popped job
+    };
+
+    //! Completion callback with job, outcome, queue wait and service time in seconds
+    using CompletionCallback = std::function<void(const Job& job, Outcome outcome, double waitSeconds, double serviceSeconds)>;
+
+    //! Queue configuration
+    struct Config {
+        std::string name = "queue";          //!< Stage name for logging
+        size_t capacity = 4;                 //!< Maximum queued jobs, excluding jobs being processed
+        Policy policy = Policy::DropOldest;  //!< Overflow policy
+        int keepEvery = 1;                   //!< Keep interval for KeepEveryKth policy
+        double maxAgeSeconds = 0.0;          //!< Default deadline relative to push, zero disables
+        CompletionCallback callback;         //!< Completion callback, may be empty
+    };
+
+    //! Queue statistics
+    struct Stats {
+        size_t depth = 0;                 //!< Jobs currently queued
+        size_t maxDepth = 0;              //!< Largest queue depth seen
+        size_t inFlight = 0;              //!< Jobs popped but not completed
+        uint64_t pushed = 0;              //!< Jobs pushed
+        uint64_t completed = 0;           //!< Jobs completed
+        uint64_t dropped = 0;             //!< Jobs dropped by policy
+        uint64_t expired = 0;             //!< Jobs dropped by deadline
+        uint64_t cancelled = 0;           //!< Jobs cancelled
+        double meanWaitSeconds = 0.0;     //!< Mean queue wait of popped jobs
+        double maxWaitSeconds = 0.0;      //!< Largest queue wait of popped jobs
+        double lastWaitSeconds = 0.0;     //!< Queue wait of last popped job
+        double meanServiceSeconds = 0.0;  //!< Mean time from pop to completion
+    };
+
+    //! Construct queue with default configuration
+    WorkQueue();
+
+    //! Construct queue with given configuration
+    WorkQueue(const Config& config);
+
+    //! Destruct queue. Cancels queued jobs.
+    ~WorkQueue();
+
+    // Disable copy, move and assign
+    WorkQueue(const WorkQueue& other) = delete;
+    WorkQueue(const WorkQueue&& other) = delete;
+    WorkQueue& operator=(const WorkQueue& other) = delete;
+    WorkQueue& operator=(const WorkQueue&& other) = delete;
+
+    //! Push job with caller timestamp. Deadline in seconds from now, zero uses configured maximum age.
+    //! Returns false if job was not queued, in which case its callback has been called.
+    bool push(uint64_t id, int64_t timestamp, double deadlineSeconds = 0.0);
+
+    //! Pop oldest live job, waiting up to timeout seconds, negative waits forever. Expired jobs are skipped.
+    //! Returns false on timeout or when queue is closed and empty.
+    bool pop(Job& outJob, double timeoutSeconds = -1.0);
+
+    //! Mark popped job completed, or cancelled if not successful
+    void complete(uint64_t id, bool success = true);
+
+    //! Close queue. Cancels queued jobs and wakes all waiting threads.
+    void close();
+
+    //! Return queue statistics
+    Stats getStats() const;
+
+private:
+    //! Job with its outcome, reported after unlocking
+    struct Report {
+        Job job;          //!< Finished job
+        Outcome outcome;  //!< Outcome
+        double wait;      //!< Queue wait in seconds
+        double service;   //!< Service time in seconds
+    };
+
+    //! Remove expired jobs from queue. Requires lock.
+    void dropExpired(Clock::time_point now, std::vector<Report>& reports);
+
+    //! Count outcome and queue report. Requires lock.
+    void finish(const Job& job, Outcome outcome, double service, std::vector<Report>& reports);
+
+    //! Call completion callback for reports. Called without lock.
+    void notify(const std::vector<Report>& reports);
+
+private:
+    const Config m_config;                         //!< Queue configuration
+    mutable std::mutex m_mutex;                    //!< Lock for queue state
+    std::condition_variable m_jobCondition;        //!< Signaled when a job is pushed or queue closes
+    std::condition_variable m_spaceCondition;      //!< Signaled when a job is removed or queue closes
+    std::deque<Job> m_queue;                       //!< Queued jobs, oldest first
+    std::unordered_map<uint64_t, Job> m_inFlight;  //!< Popped jobs by id
+    uint64_t m_pushCount = 0;                      //!< Push counter for keep interval
+    bool m_closed = false;                         //!< True after close()
+    double m_waitSum = 0.0;                        //!< Sum of queue waits of popped jobs
+    uint64_t m_popCount = 0;                       //!< Popped jobs
+    double m_serviceSum = 0.0;                     //!< Sum of service times of completed jobs
+    Stats m_stats;                                 //!< Queue statistics
+};
+
+}  // namespace VarjoExamples